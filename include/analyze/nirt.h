@@ -77,6 +77,27 @@ ANALYZE_EXPORT void nirt_destroy(struct nirt_state *ns);
  */
 ANALYZE_EXPORT int nirt_exec(struct nirt_state *ns, const char *script);
 
+/**
+ * Shoot a list of rays read from ifp in parallel, using the current objects,
+ * output formats, units and settings of ns, and write the formatted output
+ * for each ray to ofp in input order.
+ *
+ * In text mode each line holds "x y z dx dy dz" - a target point in local
+ * units and a shot direction - separated by whitespace or commas.  Blank
+ * lines and lines starting with '#' are skipped.  If binary is non-zero the
+ * input is instead a stream of native doubles, six per ray in the same
+ * order.  Up to ncpu threads are used, or all available processors if ncpu
+ * is zero or less.
+ *
+ * The output formats are compiled once per call.  Each ray's report is
+ * produced as if it were the only shot made, so values never carry over
+ * from a previous ray.  Segment plotting and diff collection are not
+ * performed in batch mode.
+ *
+ * Returns the number of rays shot, or -1 on error.
+ */
+ANALYZE_EXPORT long nirt_batch(struct nirt_state *ns, FILE *ifp, int binary, FILE *ofp, int ncpu);
+
 /* Flags for clearing/resetting/reporting the struct nirt_state state */
 #define NIRT_ALL      0x1    /**< @brief reset to initial state or report all state */
 #define NIRT_OUT      0x2    /**< @brief output log*/
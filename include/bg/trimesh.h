@@ -35,6 +35,7 @@
 #include "vmath.h"
 #include "bg/defines.h"
 #include "bu/vls.h"
+#include "bn/tol.h"
 
 __BEGIN_DECLS
 
@@ -148,7 +149,7 @@ struct bg_trimesh_decimation_settings {
     int method;            // Select decimation method to use
     fastf_t feature_size;  // Smallest feature size (mm) to leave undecimated
     fastf_t max_runtime;   // If the decimation takes more than max_runtime seconds, abort
-    size_t max_threads;    // Don't use more than max_threads when processing.
+    size_t max_threads;    // Don't use more than max_threads when processing (0 = all available).
     struct bu_vls msgs;    // Messages reported during decimation
 };
 #define BG_TRIMESH_DECIMATION_METHOD_DEFAULT 0
@@ -166,6 +167,9 @@ struct bg_trimesh_decimation_settings {
  * @param[in] n_p size of points array
  * @param[in] s decimation settings
  *
+ * Large meshes are split spatially and the parts decimated in parallel, using
+ * up to s->max_threads threads.  The output is the same for any thread count.
+ *
  * NOTE: This routine will not produce a points array that includes only the
  * points used in the decimated mesh - to generate that output, use the
  * bg_trimesh_3d_gc routine with the ofaces set produced by this function.
@@ -175,9 +179,76 @@ BG_EXPORT extern int bg_trimesh_decimate(int **ofaces, int *n_ofaces,
     int *ifaces, int n_ifaces, point_t *p, int n_p, struct bg_trimesh_decimation_settings *s);
 
 
+/**
+ * @brief
+ * Bounding volume hierarchy over the triangles of a mesh.
+ *
+ * A BVH is built once and can then be queried any number of times, from
+ * any number of threads.  It refers to (does not copy) the faces and
+ * vertices arrays it was created with, so those must not be changed or
+ * freed while the BVH is in use.
+ */
+struct bg_trimesh_bvh;
+
+/**
+ * @brief
+ * Build a BVH over num_faces triangles.  Returns NULL if there are no
+ * faces or a face references a vertex outside the vertices array.
+ */
+BG_EXPORT extern struct bg_trimesh_bvh *
+bg_trimesh_bvh_create(const int *faces, size_t num_faces, const point_t *vertices, size_t num_vertices);
+
+/** Release a BVH created by bg_trimesh_bvh_create */
+BG_EXPORT extern void bg_trimesh_bvh_destroy(struct bg_trimesh_bvh *bvh);
+
+/**
+ * @brief
+ * Find the faces whose bounding boxes overlap the box bmin/bmax.  If
+ * ofaces is non-NULL it is set to a bu_malloc'd, sorted array of the
+ * face indices (NULL if there are none).
+ *
+ * @return the number of faces found */
+BG_EXPORT extern size_t
+bg_trimesh_bvh_query(int **ofaces, const struct bg_trimesh_bvh *bvh, const point_t bmin, const point_t bmax);
+
+/**
+ * @brief
+ * Find the pairs of triangles, one from each BVH, that intersect
+ * according to bg_tri_tri_isect.  Candidate pairs are tested using up
+ * to ncpu threads (ncpu <= 0 uses all available CPUs).
+ *
+ * If pairs is non-NULL it is set to a bu_malloc'd array of 2*N face
+ * indices (face in a, face in b), sorted, or NULL if there are none.
+ *
+ * @return N, the number of intersecting pairs */
+BG_EXPORT extern size_t
+bg_trimesh_bvh_isect(int **pairs, const struct bg_trimesh_bvh *a, const struct bg_trimesh_bvh *b, int ncpu);
+
+/**
+ * @brief
+ * Find the pairs of triangles in a single mesh that intersect each
+ * other.  Output is as for bg_trimesh_bvh_isect, with the lower face
+ * index first in each pair.
+ *
+ * Triangles that share a vertex are neighbors and always touch, so they
+ * are not tested against each other.  Vertices are shared if they have
+ * the same index or, when tol is non-NULL, lie within tol->dist of each
+ * other, so meshes that haven't been welded are handled too.  This
+ * means a triangle folded back through a neighbor it shares only one
+ * vertex with is not reported.
+ *
+ * @return the number of intersecting pairs */
+BG_EXPORT extern size_t
+bg_trimesh_bvh_self_isect(int **pairs, const struct bg_trimesh_bvh *bvh, const struct bn_tol *tol, int ncpu);
+
 /* Make an attempt at a trimesh intersection calculator that returns the sets
  * of faces intersecting and inside the other for each mesh. Doesn't attempt
- * a boolean evaluation, just characterizes faces */
+ * a boolean evaluation, just characterizes faces.
+ *
+ * The intersecting face sets are sorted, bu_malloc'd arrays (NULL if
+ * empty).  The inside sets are not yet computed and are always returned
+ * empty.  Any of the output pointers may be NULL.  Returns the number of
+ * intersecting face pairs. */
 BG_EXPORT extern int
 bg_trimesh_isect(
     int **faces_inside_1, int *num_faces_inside_1, int **faces_inside_2, int *num_faces_inside_2,
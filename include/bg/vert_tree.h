@@ -118,6 +118,35 @@ BG_EXPORT extern size_t bg_vert_tree_add_w_norm(struct bg_vert_tree *tree,
  */
 BG_EXPORT extern void bg_vert_tree_clean(struct bg_vert_tree *tree);
 
+/**
+ *@brief
+ *	Merge the vertices of a flat point array (3 fastf_t per vertex)
+ *	using a spatial hash grid.
+ *
+ *	Vertices are considered in input order, and each one is merged
+ *	into the earliest already kept vertex whose squared distance from
+ *	it is <= local_tol_sq (the same tolerance used by bg_vert_tree_add,
+ *	but every kept vertex within tolerance is checked rather than only
+ *	the closest tree leaf).  Kept vertices are numbered in the order
+ *	they are first seen.
+ *
+ *	On return vmap[i] holds the index of the output vertex input
+ *	vertex i was merged into, and *overts holds the kept vertices
+ *	(freed by the caller with bu_free).  Exact duplicates are found
+ *	using up to ncpu threads (ncpu <= 0 uses all available CPUs);
+ *	the result does not depend on the number of threads.
+ *
+ *	Returns the number of vertices in *overts.  Input holding a NaN
+ *	or infinite coordinate is refused: 0 is returned and *overts is
+ *	set to NULL.
+ */
+BG_EXPORT extern size_t bg_vert_weld(fastf_t **overts,
+				     size_t *vmap,
+				     const fastf_t *verts,
+				     size_t nverts,
+				     fastf_t local_tol_sq,
+				     int ncpu);
+
 
 __END_DECLS
 
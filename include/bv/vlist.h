@@ -65,6 +65,7 @@ __BEGIN_DECLS
 struct bv_vlist  {
     struct bu_list l;		/**< @brief magic, forw, back */
     size_t nused;		/**< @brief elements 0..nused active */
+    size_t gen;			/**< @brief renewed by BV_GET_VLIST, see bv_vlist_gen() */
     int cmd[BV_VLIST_CHUNK];	/**< @brief VL_CMD_* */
     point_t pt[BV_VLIST_CHUNK];	/**< @brief associated 3-point/vect */
 };
@@ -107,6 +108,7 @@ struct bv_vlist  {
 	    BU_LIST_DEQUEUE(&((p)->l)); \
 	} \
 	(p)->nused = 0; \
+	(p)->gen = bv_vlist_gen(); \
     } while (0)
 
 /** Place an entire chain of bv_vlist structs on the freelist _free_hd */
@@ -180,6 +182,15 @@ struct bv_vlist  {
 
 
 BV_EXPORT extern size_t bv_vlist_cmd_cnt(struct bv_vlist *vlist);
+
+/**
+ * Returns a new generation number, never returned before.  BV_GET_VLIST
+ * stamps each chunk with one as it is put to use, so a chunk recycled
+ * through a free list can't be mistaken for the one it used to be.
+ * Code caching data derived from a vlist can key it on the gen and
+ * nused of each chunk.
+ */
+BV_EXPORT extern size_t bv_vlist_gen(void);
 BV_EXPORT extern int bv_vlist_bbox(struct bu_list *vlistp, point_t *bmin, point_t *bmax, size_t *length, int *dispmode);
 
 
@@ -29,6 +29,7 @@
 #include "common.h"
 
 #include <math.h>
+#include <stddef.h> /* for size_t */
 
 __BEGIN_DECLS
 
@@ -121,6 +122,71 @@ FFT_EXPORT extern void icfft(COMPLEX *dat, int num);
  */
 FFT_EXPORT extern void cdiv(COMPLEX *result, COMPLEX *val1, COMPLEX *val2);
 
+/**
+ * @brief
+ * Planned transforms.
+ *
+ * A plan is made once for a transform length and then executed any
+ * number of times.  Any length is supported: lengths made of factors
+ * 2, 3 and 4 are fastest and large prime factors are slowest.  Plans
+ * are not modified by executing them, so one plan may be used by many
+ * threads at once, e.g. to run the members of a batch in parallel.
+ *
+ * Forward transforms are unscaled and inverse transforms are scaled by
+ * 1/n, as with cfft() and icfft(), so a round trip is the identity.
+ */
+struct fft_plan;
+
+#define FFT_FORWARD -1	/**< direction: exp(-2 pi i nk/N) */
+#define FFT_INVERSE 1	/**< direction: exp(+2 pi i nk/N), scaled by 1/N */
+
+#define FFT_REAL 0x1	/**< plan flag: real input/output transforms */
+
+/**
+ * Create a plan for transforms of length n.  With FFT_REAL set in
+ * flags the plan is for fft_plan_rexec() and fft_plan_irexec(),
+ * otherwise for fft_plan_exec().  Returns NULL if n < 1.
+ */
+FFT_EXPORT extern struct fft_plan *fft_plan_create(int n, int flags);
+
+/**
+ * Free a plan.
+ */
+FFT_EXPORT extern void fft_plan_destroy(struct fft_plan *p);
+
+/**
+ * Returns the transform length of a plan.
+ */
+FFT_EXPORT extern int fft_plan_size(const struct fft_plan *p);
+
+/**
+ * Complex transform of n values in place, with dir FFT_FORWARD or
+ * FFT_INVERSE.
+ */
+FFT_EXPORT extern void fft_plan_exec(const struct fft_plan *p, COMPLEX *dat, int dir);
+
+/**
+ * Forward transform of n real values into bins 0 through n/2 of out,
+ * which must hold n/2+1 values.  The remaining bins are the complex
+ * conjugates of these.  in may be the same memory as out.
+ */
+FFT_EXPORT extern void fft_plan_rexec(const struct fft_plan *p, const double *in, COMPLEX *out);
+
+/**
+ * Inverse of fft_plan_rexec(): bins 0 through n/2 of a spectrum with
+ * conjugate symmetry to n real values.  in may be the same memory as
+ * out.
+ */
+FFT_EXPORT extern void fft_plan_irexec(const struct fft_plan *p, const COMPLEX *in, double *out);
+
+/**
+ * Batched versions of the above, for count signals stored one after
+ * the other (n values per signal, or n/2+1 for real spectra).
+ */
+FFT_EXPORT extern void fft_plan_exec_batch(const struct fft_plan *p, COMPLEX *dat, size_t count, int dir);
+FFT_EXPORT extern void fft_plan_rexec_batch(const struct fft_plan *p, const double *in, COMPLEX *out, size_t count);
+FFT_EXPORT extern void fft_plan_irexec_batch(const struct fft_plan *p, const COMPLEX *in, double *out, size_t count);
+
 /* These should come from a generated header, but until
  * CMake is live we'll just add the ones used by our current code */
 FFT_EXPORT extern void rfft256(register double X[]);
@@ -86,6 +86,44 @@ GCV_EXPORT extern union tree *gcv_region_end(struct db_tree_state *tsp, const st
 GCV_EXPORT extern union tree *gcv_region_end_mc(struct db_tree_state *tsp, const struct db_full_path *pathp, union tree *curtree, void *client_data);
 
 
+/**
+ * A region consisting of a single BoT, as handed to the bot_func
+ * callback of gcv_walk_tree().
+ */
+struct gcv_bot_region
+{
+    const struct db_full_path *pathp;	/**< @brief path to the region */
+    const struct db_tree_state *tsp;	/**< @brief tree state at the region (ids, material, color) */
+    size_t num_vertices;
+    const fastf_t *vertices;		/**< @brief 3 per vertex, in mm, with all matrices applied */
+    size_t num_faces;
+    const int *faces;			/**< @brief 3 per face, counter-clockwise unless the BoT is unoriented */
+};
+
+/**
+ * Walk the trees below argv[] exactly as db_walk_tree() would, except
+ * that regions whose trees reduce to a single BoT (possibly through
+ * unions of nested combinations) are not tessellated.  Instead the
+ * BoT's own triangles, transformed into place, are passed to
+ * bot_func.  BoTs are loaded in parallel, but bot_func is called
+ * serially, once per region and in tree walk order, after all other
+ * regions have gone through reg_end_func.  ncpu is only used for the
+ * db_walk_tree() of the remaining regions.
+ *
+ * If bot_func is NULL this is just db_walk_tree().
+ */
+GCV_EXPORT extern int gcv_walk_tree(struct db_i *dbip,
+				    int argc,
+				    const char **argv,
+				    int ncpu,
+				    const struct db_tree_state *init_state,
+				    int (*reg_start_func)(struct db_tree_state *, const struct db_full_path *, const struct rt_comb_internal *, void *),
+				    union tree *(*reg_end_func)(struct db_tree_state *, const struct db_full_path *, union tree *, void *),
+				    union tree *(*leaf_func)(struct db_tree_state *, const struct db_full_path *, struct rt_db_internal *, void *),
+				    void (*bot_func)(const struct gcv_bot_region *, void *),
+				    void *client_data);
+
+
 GCV_EXPORT extern union tree *gcv_bottess_region_end(struct db_tree_state *tsp, const struct db_full_path *pathp, union tree *curtree, void *client_data);
 
 
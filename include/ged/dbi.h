@@ -411,6 +411,7 @@ class GED_EXPORT DbiState {
 		);
 
 	void populate_maps(struct directory *dp, unsigned long long phash, int reset);
+	void populate_all();
 	unsigned long long update_dp(struct directory *dp, int reset);
 	unsigned int color_int(struct bu_color *);
 	int int_color(struct bu_color *c, unsigned int);
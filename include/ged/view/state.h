@@ -149,6 +149,23 @@ struct draw_update_data_t {
 /* Defined in view.cpp */
 GED_EXPORT extern int ged_view_update(struct ged *gedp);
 
+/* Defined in draw.cpp */
+
+/**
+ * Adaptive CSG wireframes invalidated by a view change are regenerated
+ * in background threads, largest on screen first, and displayed as v is
+ * redrawn.  Returns the number of objects in v whose new wireframe is
+ * not yet displayed - applications that don't redraw continuously
+ * should schedule another redraw of v while this is non-zero.
+ */
+GED_EXPORT extern size_t ged_csg_lod_pending(struct bview *v);
+
+/**
+ * Drop any adaptive CSG wireframe work for v.  Must be called before v
+ * is freed.
+ */
+GED_EXPORT extern void ged_csg_lod_view_free(struct bview *v);
+
 /**
  * Erase all currently displayed geometry and draw the specified object(s)
  */
@@ -55,7 +55,9 @@ typedef enum {
 
 typedef enum {
     ICV_DATA_DOUBLE,
-    ICV_DATA_UCHAR
+    ICV_DATA_UCHAR,
+    ICV_DATA_USHORT,
+    ICV_DATA_FLOAT
 } ICV_DATA;
 
 /* Define Various Flags */
@@ -97,6 +99,36 @@ typedef struct icv_image icv_image_t;
  */
 #define ICV_IMAGE_IS_INITIALIZED(_i) (((struct icv_image *)(_i) != ICV_IMAGE_NULL) && LIKELY((_i)->magic == ICV_IMAGE_MAGIC))
 
+/**
+ * An image whose channels are kept in their native type
+ * (ICV_DATA_UCHAR, ICV_DATA_USHORT or ICV_DATA_FLOAT) rather than
+ * converted to double.  Integer channels span 0 to their type's
+ * maximum, float channels 0.0 to 1.0.
+ *
+ * If tile is zero, pixels are stored in scanline order from the
+ * bottom left, as in struct icv_image.  Otherwise the image is cut
+ * into tile x tile pixel squares, each stored contiguously in
+ * scanline order, with the squares themselves in scanline order.
+ * Squares along the top and right edges are padded to full size.
+ * Use icv_npixel() and icv_nspan() rather than indexing data.
+ */
+struct icv_nimage {
+    uint32_t magic;
+    ICV_COLOR_SPACE color_space;
+    ICV_DATA type;
+    size_t width, height, channels;
+    size_t tile;
+    void *data;
+};
+
+typedef struct icv_nimage icv_nimage_t;
+#define ICV_NIMAGE_NULL ((struct icv_nimage *)0)
+
+/**
+ * returns truthfully whether a icv_nimage has been initialized.
+ */
+#define ICV_NIMAGE_IS_INITIALIZED(_i) (((struct icv_nimage *)(_i) != ICV_NIMAGE_NULL) && LIKELY((_i)->magic == ICV_NIMAGE_MAGIC))
+
 /* Validation Macros */
 /**
  * Validates input icv_struct, if failure (in validation) returns -1
@@ -0,0 +1,161 @@
+/*                        N A T I V E . H
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @addtogroup icv_native
+ *
+ * @brief
+ * Images stored in their native channel type.
+ *
+ * An icv_image_t holds every channel as a double, which takes eight
+ * times the memory of an 8 bit image and makes every operation sweep
+ * doubles.  An icv_nimage_t keeps 8 bit, 16 bit or float channels as
+ * they are, optionally in square tiles, and the operations below work
+ * on them directly, spreading rows across all available processors.
+ * icv_n2image() and icv_image2n() convert to and from icv_image_t for
+ * everything else.
+ *
+ */
+
+#ifndef ICV_NATIVE_H
+#define ICV_NATIVE_H
+
+#include "common.h"
+#include <stddef.h> /* for size_t */
+#include "bu/mime.h"
+#include "icv/defines.h"
+#include "icv/filters.h"
+#include "icv/ops.h"
+
+__BEGIN_DECLS
+
+/** @{ */
+/** @file icv/native.h */
+
+/**
+ * Allocate a zeroed image.
+ *
+ * @param width Width of the image to be created
+ * @param height Height of the image to be created
+ * @param color_space Color space of the image (RGB, grayscale)
+ * @param type Channel type: ICV_DATA_UCHAR, ICV_DATA_USHORT or ICV_DATA_FLOAT
+ * @param tile Edge of the square tiles in pixels, or 0 for scanline order
+ * @return the new image, or NULL if type is not supported
+ */
+ICV_EXPORT extern icv_nimage_t *icv_ncreate(size_t width, size_t height, ICV_COLOR_SPACE color_space, ICV_DATA type, size_t tile);
+
+/**
+ * Free an image and its data.
+ */
+ICV_EXPORT extern int icv_ndestroy(icv_nimage_t *img);
+
+/**
+ * Returns the address of the first channel of pixel (x, y), where
+ * (0, 0) is the bottom left.
+ */
+ICV_EXPORT extern void *icv_npixel(const icv_nimage_t *img, size_t x, size_t y);
+
+/**
+ * Returns how many pixels, starting at (x, y) and moving right, are
+ * stored contiguously: the rest of the row in scanline order, or the
+ * rest of the tile row otherwise.
+ */
+ICV_EXPORT extern size_t icv_nspan(const icv_nimage_t *img, size_t x, size_t y);
+
+/**
+ * Load a file into a native image, as icv_read() does.  8 bit PIX,
+ * BW and PNG data are read without conversion and 16 bit PNG data is
+ * kept as ICV_DATA_USHORT.  Other formats are read with icv_read()
+ * and converted, with DPIX becoming ICV_DATA_FLOAT.
+ *
+ * @param tile Edge of the square tiles in pixels, or 0 for scanline order
+ */
+ICV_EXPORT extern icv_nimage_t *icv_nread(const char *filename, bu_mime_image_t format, size_t width, size_t height, size_t tile);
+
+/**
+ * Save a native image, as icv_write() does.  8 bit images written as
+ * PIX or BW with a matching number of channels are written directly;
+ * everything else goes through icv_write().
+ *
+ * @return on success 0, on failure -1 with log messages.
+ */
+ICV_EXPORT extern int icv_nwrite(const icv_nimage_t *img, const char *filename, bu_mime_image_t format);
+
+/**
+ * Returns a new icv_image_t holding the pixels of img as doubles.
+ */
+ICV_EXPORT extern icv_image_t *icv_n2image(const icv_nimage_t *img);
+
+/**
+ * Returns a new native image holding the pixels of img, converted to
+ * type and laid out as requested.  Values outside 0 to 1 are clamped
+ * for integer types.
+ */
+ICV_EXPORT extern icv_nimage_t *icv_image2n(const icv_image_t *img, ICV_DATA type, size_t tile);
+
+/**
+ * Native version of icv_diff().  Pixels are compared as 8 bit RGB
+ * values, so images of different types or layouts can be compared,
+ * and gray pixels compare equal to RGB pixels with equal channels.
+ * Returns 1 if there are any differences, else 0.
+ */
+ICV_EXPORT extern int icv_ndiff(int *matching, int *off_by_1, int *off_by_many, const icv_nimage_t *img1, const icv_nimage_t *img2);
+
+/**
+ * Native version of icv_diffimg().  Returns an 8 bit RGB image in
+ * scanline order, or NULL if the images differ in size.
+ */
+ICV_EXPORT extern icv_nimage_t *icv_ndiffimg(const icv_nimage_t *img1, const icv_nimage_t *img2);
+
+/**
+ * Native version of icv_pdiff().
+ */
+ICV_EXPORT extern uint32_t icv_npdiff(const icv_nimage_t *img1, const icv_nimage_t *img2);
+
+/**
+ * Filter an image in place with a 3x3 kernel of the given type, as
+ * documented for icv_filter(), treating pixels outside the image as
+ * zero.  Results are clamped to the range of integer types.
+ *
+ * @return 0 on success and -1 on failure.
+ */
+ICV_EXPORT extern int icv_nfilter(icv_nimage_t *img, ICV_FILTER filter_type);
+
+/**
+ * Resize an image in place, with the same methods and arguments as
+ * icv_resize().
+ *
+ * @return 0 on success and -1 on failure.
+ */
+ICV_EXPORT extern int icv_nresize(icv_nimage_t *img, ICV_RESIZE_METHOD method, size_t out_width, size_t out_height, size_t factor);
+
+/** @} */
+
+__END_DECLS
+
+#endif /* ICV_NATIVE_H */
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
@@ -178,6 +178,71 @@ RT_EXPORT extern int rt_comb_import5(struct rt_db_internal *ip, const struct bu_
  */
 RT_EXPORT extern int db_comb_children(struct db_i *dbip, struct rt_comb_internal *comb, struct directory ***children, int **bool_ops, matp_t **mats);
 
+
+/* comb_cache.cpp */
+
+/**
+ * Enable a cache on dbip of imported combinations, of the matrix and
+ * boolean operation applied to each of their members, and of the
+ * bounding boxes of objects and whole comb hierarchies.  Entries are
+ * filled in as they are asked for and dropped via the database change
+ * callbacks whenever an object is modified, added or removed, so
+ * repeated path evaluation on an unchanged hierarchy doesn't go back
+ * to the database.  db_open() and db_open_inmem() enable the cache
+ * unless the LIBRT_COMB_CACHE environment variable is set to 0.
+ *
+ * Returns 0 on success (including when the cache is already enabled)
+ * and -1 on error.
+ */
+RT_EXPORT extern int db_comb_cache_enable(struct db_i *dbip);
+
+/**
+ * Release the comb cache on dbip, if one is enabled.  db_close does
+ * this automatically.
+ */
+RT_EXPORT extern void db_comb_cache_disable(struct db_i *dbip);
+
+/**
+ * Return the imported form of combination dp, read from the database
+ * with resp the first time it is asked for.  The result belongs to the
+ * cache and must not be modified or freed.  It holds a reference that
+ * must be dropped with db_comb_cache_release(); until then it stays
+ * valid even if dp is changed or removed (it just no longer reflects
+ * the database), but not past db_comb_cache_disable() or db_close().
+ *
+ * Returns NULL if dbip has no comb cache or dp is not a combination
+ * that can be imported.
+ */
+RT_EXPORT extern const struct rt_db_internal *db_comb_cache_get(struct db_i *dbip, struct directory *dp, struct resource *resp);
+
+/**
+ * Drop the reference to ip taken by db_comb_cache_get().
+ */
+RT_EXPORT extern void db_comb_cache_release(struct db_i *dbip, const struct rt_db_internal *ip);
+
+/**
+ * Find the member named name in combination cdp and return the matrix
+ * it is used with in m (identity if none) and, if op is not NULL, its
+ * boolean operation.  When comb instance specifiers are in use on
+ * dbip, inst selects which use of name (counting from 0) is wanted,
+ * otherwise the first use is returned.
+ *
+ * Returns 1 if the member was found, 0 if it was not, -1 if cdp could
+ * not be read and -2 if dbip has no comb cache.
+ */
+RT_EXPORT extern int db_comb_cache_member(mat_t m, int *op, struct db_i *dbip, struct directory *cdp, const char *name, int inst, struct resource *resp);
+
+/**
+ * Return the bounding box of dp, in its own coordinate system.  For a
+ * combination this is the box of its boolean tree with each member's
+ * matrix applied (subtracted members don't contribute); other objects
+ * are bounded as by rt_bound_instance().
+ *
+ * Returns 0 on success, -1 if dp can't be bounded and -2 if dbip has
+ * no comb cache.
+ */
+RT_EXPORT extern int db_comb_cache_bbox(point_t bmin, point_t bmax, struct db_i *dbip, struct directory *dp, struct resource *resp);
+
 #ifdef __cplusplus
 RT_EXPORT extern void
 rt_comb_brep(ON_Brep **b, const struct rt_db_internal *ip, const struct bn_tol *tol, const struct db_i *dbip);
@@ -206,6 +206,11 @@ db_diff3_dp(const struct db_i *left,
  * but is unchanged, unch_func() is called.  NULL may be
  * passed to skip any callback.
  *
+ * Objects are compared in parallel, and a diff_result for each is
+ * appended to diff_results in directory order.  Objects whose
+ * serialized forms are byte-identical are reported unchanged without
+ * being imported, so their param_diffs lists are left empty.
+ *
  * Returns an int with bit flags set according to the above
  * four diff categories.
  *
@@ -226,6 +231,9 @@ db_diff(const struct db_i *dbip_left,
  * right databases relative to the ancestor database, and provides
  * functional hooks for the various cases.
  *
+ * As with db_diff(), objects are compared in parallel and objects
+ * identical in all three databases are not imported.
+ *
  * Returns an int with bit flags set according to the above
  * diff3 categories.
  *
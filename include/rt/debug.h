@@ -84,7 +84,7 @@ __BEGIN_DECLS
 #define RT_DEBUG_HF		0x04000000	/**< @brief 27 Height Field solids */
 
 #define RT_DEBUG_MESHING	0x08000000	/**< @brief 28 Print meshing/triangulation details */
-#define RT_DEBUG_UNUSED_3	0x10000000	/**< @brief 29 Unassigned */
+#define RT_DEBUG_PROFILE	0x10000000	/**< @brief 29 Collect and report profiling counters, see rt/prof.h */
 #define RT_DEBUG_UNUSED_4	0x20000000	/**< @brief 30 Unassigned */
 
 /* Options which will cause the library to write binary debugging output */
@@ -96,7 +96,7 @@ __BEGIN_DECLS
     "\040PL_BOX" \
     "\037PL_SOLIDS" \
     "\036UNUSED_4" \
-    "\035UNUSED_3" \
+    "\035PROFILE" \
     "\034UNUSED_2" \
     "\033HF" \
     "\032EBM" \
@@ -60,6 +60,20 @@ __BEGIN_DECLS
  * need to (re)allocate massive numbers of individual vlists. */
 RT_EXPORT extern struct bu_list rt_vlfree;
 
+/**
+ * The vlist free list for the calling thread to use - rt_vlfree, unless the
+ * thread has supplied its own with rt_vlfree_set().  The adaptive plotting
+ * routines allocate from this list, so threads running them alongside other
+ * vlist work need a list of their own.
+ */
+RT_EXPORT extern struct bu_list *rt_vlfree_get(void);
+
+/**
+ * Use vlfree rather than rt_vlfree in the calling thread.  NULL goes back
+ * to rt_vlfree.
+ */
+RT_EXPORT extern void rt_vlfree_set(struct bu_list *vlfree);
+
 /**
  * Default librt-supplied resource structure for uniprocessor cases.  Because
  * only one of these structures can be used with each thread of execution (see
@@ -27,6 +27,7 @@
 
 #include "common.h"
 #include "vmath.h"
+#include "bu/mapped_file.h"
 #include "rt/defines.h"
 #include "rt/resource.h"
 
@@ -69,6 +70,53 @@ RT_EXPORT extern void rt_reduce_obj(struct rt_db_internal *dest, const struct rt
  */
 RT_EXPORT extern void rt_reduce_db(struct db_i *db, size_t num_preserved_attributes, const char * const * preserved_attributes, const struct bu_ptbl *preserved_combs_dirs);
 
+/**
+ * Fills len bytes at dest with data derived from the mapped file src.
+ * Returns non-zero on success.
+ */
+typedef int (*rt_sidecar_fill_t)(void *dest, size_t len, const struct bu_mapped_file *src, void *data);
+
+/**
+ * Returns a read-only mapped file holding len bytes of data derived
+ * from src, such as a converted or pre-filtered copy of an image.
+ * The result is kept in the LIBRT cache directory, keyed on the path,
+ * size and modification time of src and on kind, which names the
+ * conversion and must include any parameters it depends on.  It is
+ * built with fill() only if no valid copy exists yet, and is then
+ * shared by every user on the host through the page cache.
+ *
+ * The data is at apbuf (apbuflen bytes) of the returned file, which
+ * is released with bu_close_mapped_file().  Returns NULL if the cache
+ * is disabled or can't be used, in which case callers should build
+ * the data in memory themselves.
+ */
+RT_EXPORT extern struct bu_mapped_file *rt_sidecar_open(const struct bu_mapped_file *src, const char *kind, size_t len, rt_sidecar_fill_t fill, void *data);
+
+/**
+ * Sets mp->apbuf to len bytes of data derived from mp by fill(), as
+ * rt_sidecar_open() would produce it, unless another user of mp has
+ * already done so, and returns mp->apbuf.  If the cache can't be used
+ * the data is built in memory instead.  Either way it belongs to mp,
+ * which must then be released with rt_sidecar_close() rather than
+ * bu_close_mapped_file() so that the data is released along with it.
+ * Returns NULL if the data can't be built.
+ */
+RT_EXPORT extern void *rt_sidecar_apbuf(struct bu_mapped_file *mp, const char *kind, size_t len, rt_sidecar_fill_t fill, void *data);
+
+/**
+ * Releases a use of mp, along with the data attached to it by
+ * rt_sidecar_apbuf() if this was the last use.
+ */
+RT_EXPORT extern void rt_sidecar_close(struct bu_mapped_file *mp);
+
+/**
+ * Removes cached data made by rt_sidecar_open() from source files that
+ * have since been modified or removed.  This also happens
+ * automatically, once per process, before new data is cached.
+ * Returns the number of cache files removed.
+ */
+RT_EXPORT extern size_t rt_sidecar_prune(void);
+
 /* below are librt table implementation detail */
 
 RT_EXPORT extern int rt_generic_xform(struct rt_db_internal     *op,
@@ -65,6 +65,49 @@ RT_EXPORT extern int re_prep_solids(struct rt_i *rtip,
 				    char **solid_names,
 				    struct resource *resp);
 
+/**
+ * Keep a prepped rt_i current as its database is edited.
+ *
+ * argc/argv name the objects rtip was built from, exactly as they were
+ * passed to rt_gettrees(), and ncpus is the processor count used for
+ * rt_gettrees() and rt_prep_parallel().  Once called, rtip listens for
+ * database changes (see db_add_changed_clbk()) and remembers which of
+ * the objects it uses have been edited; nothing is done until the
+ * application calls rt_reprep_pending().  Calling this again replaces
+ * the previous object list.  Returns 0 on success, -1 on error.
+ */
+RT_EXPORT extern int rt_reprep_watch(struct rt_i *rtip,
+				     int argc,
+				     const char **argv,
+				     size_t ncpus);
+
+/**
+ * Stop tracking edits for rtip.  Called automatically by
+ * rt_free_rti().
+ */
+RT_EXPORT extern void rt_reprep_unwatch(struct rt_i *rtip);
+
+/**
+ * Bring a watched rt_i up to date with the edits made since the last
+ * call.  Must not be called while rays are being fired at rtip.
+ *
+ * Edited primitives are re-prepped in place: their soltabs are pulled
+ * out of the space partitioning tree, prepped again from the new
+ * database contents and re-inserted, and the model bounds are grown
+ * if needed.  Regions and all other soltabs are left untouched.
+ * Anything else that affects the geometry - combination or matrix
+ * edits, objects added to or removed from the tree, a primitive
+ * changing type - makes this fall back to rt_clean() followed by
+ * rt_gettrees() and, if rtip had been prepped, rt_prep_parallel().
+ *
+ * resp is used for reading the edited objects, rt_uniresource if
+ * NULL.  Returns 0 if nothing needed doing, 1 if only primitives were
+ * re-prepped, 2 if the model was rebuilt (any per-region application
+ * data, such as shaders, must then be set up again), or -1 on error.
+ */
+RT_EXPORT extern int rt_reprep_pending(struct rt_i *rtip,
+				       struct resource *resp);
+
 
 __END_DECLS
 
@@ -0,0 +1,156 @@
+/*                         P R O F . H
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @addtogroup rt_prof
+ * @brief
+ * Optional ray tracing instrumentation.
+ *
+ * When profiling is enabled, every struct resource carries a block of
+ * counters (re_prof) that only its own thread writes to, so nothing
+ * on the shooting path takes a lock.  Counters are summed across all
+ * of an rt_i's resources when a report is requested, and a report is
+ * produced automatically by rt_clean().
+ *
+ * Profiling is enabled by setting the LIBRT_PROF environment variable
+ * or the RT_DEBUG_PROFILE debug bit (rt -x 10000000) before resources
+ * are initialized.  If LIBRT_PROF names a file the JSON report is
+ * appended to it, otherwise it is printed with bu_log().  When
+ * disabled, re_prof is NULL and the only cost is a pointer test.
+ *
+ * Alongside the counters, a sampling profiler records what each
+ * resource's thread is doing (traversing the space partition, in a
+ * given primitive's shot routine, weaving, evaluating booleans or in
+ * the application's callbacks).  Shooting threads only store their
+ * current activity in their own re_prof; a separate sampler thread
+ * reads those LIBRT_PROF_HZ times a second (default 1000, 0 turns
+ * sampling off) and keeps the counts.  The sampler runs only while
+ * there are profiled resources.
+ */
+/** @{ */
+/** @file rt/prof.h */
+
+#ifndef RT_PROF_H
+#define RT_PROF_H
+
+#include "common.h"
+#include "bu/vls.h"
+#include "rt/defines.h"
+
+__BEGIN_DECLS
+
+struct rt_i;
+struct resource;
+struct seg;
+struct partition;
+
+/** Number of bins in the space partition descent depth histogram */
+#define RT_PROF_DEPTH_BINS 64
+
+/* Activities recorded by the sampling profiler */
+#define RT_PROF_ST_IDLE		0	/**< @brief not in rt_shootray() */
+#define RT_PROF_ST_TRAVERSE	1	/**< @brief stepping through the space partition */
+#define RT_PROF_ST_SHOT		2	/**< @brief in ft_shot() or ft_piece_shot() */
+#define RT_PROF_ST_WEAVE	3	/**< @brief rt_boolweave() */
+#define RT_PROF_ST_EVAL		4	/**< @brief rt_boolfinal() */
+#define RT_PROF_ST_HIT		5	/**< @brief the application's a_hit() or a_miss() */
+#define RT_PROF_ST_NSTATES	6
+
+/**
+ * Per-resource counters.  Indexed by primitive type (ID_xxx) where
+ * applicable.
+ */
+struct rt_prof {
+    uint64_t shots[ID_MAXIMUM+1];	/**< @brief ft_shot() and ft_piece_shot() calls */
+    uint64_t hits[ID_MAXIMUM+1];	/**< @brief calls which returned hits */
+    uint64_t shot_ns[ID_MAXIMUM+1];	/**< @brief time spent in those calls */
+    uint64_t cut_depth[RT_PROF_DEPTH_BINS];	/**< @brief cut tree depth of each cell entered */
+    uint64_t weaves;		/**< @brief rt_boolweave() calls */
+    uint64_t weave_segs;	/**< @brief segments handed to rt_boolweave() */
+    uint64_t final_partitions;	/**< @brief partitions passed to a_hit() */
+    uint64_t hit_rays;		/**< @brief rays which called a_hit() */
+
+    /* Sampling.  state is only written by the resource's own thread,
+     * the sample counts only by the sampler thread. */
+    volatile int state;		/**< @brief current activity << 16 | primitive ID */
+    uint64_t samples[RT_PROF_ST_NSTATES];	/**< @brief samples taken in each activity */
+    uint64_t shot_samples[ID_MAXIMUM+1];	/**< @brief RT_PROF_SHOT samples, by primitive type */
+};
+
+/**
+ * Returns non-zero if newly initialized resources will collect
+ * profiling counters.
+ */
+RT_EXPORT extern int rt_prof_enabled(void);
+
+/**
+ * Append a JSON report of the profiling counters summed over all the
+ * resources registered with rtip (and rt_uniresource) to json.
+ * Returns the number of resources which had counters.
+ *
+ * Counters are read without synchronization, so a report generated
+ * while rays are in flight is only approximate.
+ */
+RT_EXPORT extern int rt_prof_dump(struct bu_vls *json, struct rt_i *rtip);
+
+/**
+ * Zero the counters of every resource registered with rtip.
+ */
+RT_EXPORT extern void rt_prof_reset(struct rt_i *rtip);
+
+/* Hooks used by LIBRT itself */
+
+/** Allocate (or release, if profiling is off) resp->re_prof */
+RT_EXPORT extern void rt_prof_init_resource(struct resource *resp);
+/** Release resp->re_prof */
+RT_EXPORT extern void rt_prof_free_resource(struct resource *resp);
+/** Monotonic clock used to time primitive intersections, in ns */
+RT_EXPORT extern uint64_t rt_prof_clock(void);
+/** Record the segments on a list about to be woven */
+RT_EXPORT extern void rt_prof_weave(struct resource *resp, const struct seg *seghead);
+/** Record the final partitions handed to a_hit() */
+RT_EXPORT extern void rt_prof_partitions(struct resource *resp, const struct partition *PartHeadp);
+/** Report, if profiling is on, as part of rt_clean() */
+RT_EXPORT extern void rt_prof_report(struct rt_i *rtip);
+
+/** Record one primitive intersection call */
+#define RT_PROF_SHOT(_resp, _id, _ret, _t0) { \
+	struct rt_prof *_p = (_resp)->re_prof; \
+	_p->shots[(_id)]++; \
+	if ((_ret) > 0) _p->hits[(_id)]++; \
+	_p->shot_ns[(_id)] += rt_prof_clock() - (_t0); }
+
+/** Record the current activity (RT_PROF_xxx) for the sampler */
+#define RT_PROF_STATE(_resp, _state, _id) { \
+	if ((_resp)->re_prof) (_resp)->re_prof->state = ((_state) << 16) | (_id); }
+
+/** @} */
+
+__END_DECLS
+
+#endif /* RT_PROF_H */
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
@@ -38,6 +38,8 @@
 
 __BEGIN_DECLS
 
+struct rt_prof;
+
 /**
  * One of these structures is needed per thread of execution, usually
  * with calling applications creating an array with at least MAX_PSW
@@ -102,11 +104,13 @@ struct resource {
     long                re_tree_free;
     struct directory *  re_directory_hd;
     struct bu_ptbl      re_directory_blocks;    /**< @brief  Table of malloc'ed blocks */
+    /* Optional profiling counters, see rt/prof.h.  NULL when disabled */
+    struct rt_prof *    re_prof;
 };
 
 #define RESOURCE_NULL   ((struct resource *)0)
 #define RT_CK_RESOURCE(_p) BU_CKMAG(_p, RESOURCE_MAGIC, "struct resource")
-#define RT_RESOURCE_INIT_ZERO { RESOURCE_MAGIC, 0, BU_LIST_INIT_ZERO, BU_PTBL_INIT_ZERO, 0, 0, 0, BU_LIST_INIT_ZERO, 0, 0, 0, BU_LIST_INIT_ZERO, BU_LIST_INIT_ZERO, BU_LIST_INIT_ZERO, NULL, 0, NULL, 0, 0, 0, 0, 0, 0, 0, 0, NULL, 0, 0, 0, 0, BU_PTBL_INIT_ZERO, NULL, 0, 0, 0, NULL, BU_PTBL_INIT_ZERO }
+#define RT_RESOURCE_INIT_ZERO { RESOURCE_MAGIC, 0, BU_LIST_INIT_ZERO, BU_PTBL_INIT_ZERO, 0, 0, 0, BU_LIST_INIT_ZERO, 0, 0, 0, BU_LIST_INIT_ZERO, BU_LIST_INIT_ZERO, BU_LIST_INIT_ZERO, NULL, 0, NULL, 0, 0, 0, 0, 0, 0, 0, 0, NULL, 0, 0, 0, 0, BU_PTBL_INIT_ZERO, NULL, 0, 0, 0, NULL, BU_PTBL_INIT_ZERO, NULL }
 
 /**
  * Definition of global parallel-processing semaphores.
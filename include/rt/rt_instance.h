@@ -126,6 +126,8 @@ struct rt_i {
     /* Parameters for dynamic geometry */
     int                 rti_add_to_new_solids_list;
     struct bu_ptbl      rti_new_solids;
+    void *              rti_reprep_watch; /**< @brief  PRIVATE: database edit tracking, see rt_reprep_watch() */
+    void *              rti_instances;  /**< @brief  PRIVATE: prototype preps shared by instanced solids */
 };
 
 
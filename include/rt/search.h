@@ -124,6 +124,28 @@ RT_EXPORT extern int db_search(struct bu_ptbl *results,
 #define DB_SEARCH_RETURN_UNIQ_DP   0x4   /**< @brief Return the set of unique directory pointers instead of full paths */
 #define DB_SEARCH_QUIET            0x8   /**< @brief Silence all warnings */
 #define DB_SEARCH_PRINT_TOTAL	   0x10	 /**< @brief Print total number of items found in search */
+#define DB_SEARCH_PARALLEL         0x20  /**< @brief Evaluate filters on multiple threads when the filters allow it (results are identical to a serial search) */
+
+/**
+ * Enable an in-memory secondary index on dbip that db_search uses to
+ * answer -attr, -stdattr and -type filters without re-reading each
+ * object from the database.  The index maps attribute keys, key/value
+ * pairs and primitive types to the objects that have them.  It is
+ * built (reading objects in parallel) by the first search that uses
+ * one of those filters and is kept current via the database change
+ * callbacks.  db_open() enables the index unless the
+ * LIBRT_SEARCH_INDEX environment variable is set to 0.
+ *
+ * Returns 0 on success (including when the index is already enabled)
+ * and -1 on error.
+ */
+RT_EXPORT extern int db_search_index_enable(struct db_i *dbip);
+
+/**
+ * Release the db_search index on dbip, if one is enabled.  db_close
+ * does this automatically.
+ */
+RT_EXPORT extern void db_search_index_disable(struct db_i *dbip);
 
 /**
  * Properly free the table contents returned by db_search.  The bu_ptbl
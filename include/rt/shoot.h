@@ -93,6 +93,46 @@ __BEGIN_DECLS
 RT_EXPORT extern int rt_shootray(struct application *ap);
 
 
+/**
+ * @brief
+ * Test whether anything blocks a ray
+ *
+ * A visibility query for callers that only need a yes or no answer.
+ * The application is set up as for rt_shootray(), except that a_hit
+ * and a_miss are not used: no callbacks are made and no partition
+ * list is handed back.  Returns 1 if any non-air region occupies some
+ * part of the ray between its start point and dist (the whole ray if
+ * dist <= 0), including a region the ray starts inside, and 0 if not.
+ * A positive a_ray_length limits the query the same way.
+ *
+ * Segments of primitives whose regions are all plain unions settle
+ * the question as soon as they are found, without being woven into
+ * partitions, and tracing stops at the first such hit.  Other regions
+ * are boolean evaluated only as far as needed.
+ */
+RT_EXPORT extern int rt_shootray_occluded(struct application *ap, fastf_t dist);
+
+
+/**
+ * @brief
+ * Find the first region along a ray
+ *
+ * Like rt_shootray_occluded(), but finds the nearest non-air region
+ * on the ray.  Returns 1 if there is one, setting *dist (if non-NULL)
+ * to the distance at which the ray enters it and *regp (if non-NULL)
+ * to the region, or 0 if the ray hits nothing.  The distance is
+ * negative if the ray starts inside the region.  Tracing stops as
+ * soon as no closer hit is possible.  Regions entered beyond a
+ * positive a_ray_length are not reported.
+ *
+ * Overlaps are resolved with the application's a_overlap handler,
+ * exactly as rt_shootray() would, so *regp is the region rt_shootray()
+ * would report first.  When regp is NULL only the distance is wanted,
+ * and plain union regions are not boolean evaluated at all.
+ */
+RT_EXPORT extern int rt_shootray_first(struct application *ap, fastf_t *dist, struct region **regp);
+
+
 /**
  * @brief
  * Shoot a bundle of rays
@@ -240,6 +240,38 @@ else
 fi
 
 
+# === #6 and #7: G-buffer mode must find the same edges ===
+for n in 6 7 ; do
+    rm -f rtedge.$n.pix rtedge.${n}gb.pix rtedge.diff$n.pix
+
+    if test "x$n" = "x6" ; then
+	opts=""
+    else
+	opts="-c\"set bs=1 dr=1 dn=1 rc=1\""
+    fi
+
+    cmd="$RTEDGE -s 256 -o rtedge.$n.pix $opts rtedge.havoc.g havoc"
+    log "... rendering rtedge #$n: $cmd"
+    eval "$cmd" 2>> "$LOGFILE"
+
+    cmd="$RTEDGE -s 256 -o rtedge.${n}gb.pix $opts -c\"set gb=1\" rtedge.havoc.g havoc"
+    log "... rendering rtedge #$n with a G-buffer: $cmd"
+    eval "$cmd" 2>> "$LOGFILE"
+
+    cmd="$PIXDIFF rtedge.$n.pix rtedge.${n}gb.pix"
+    log "... comparing rtedge #$n: $cmd"
+    eval "$cmd" > rtedge.diff$n.pix 2>> "$LOGFILE"
+    NUMBER_WRONG=`tail -n1 "$LOGFILE" | tr , '\012' | awk '/many/ {print $1}'`
+
+    if [ "X$NUMBER_WRONG" = "X0" ] ; then
+	log "... -> rtedge.${n}gb.pix matches rtedge.$n.pix"
+    else
+	log "... -> rtedge.${n}gb.pix $NUMBER_WRONG off by many"
+	FAILURES="`expr $FAILURES + 1`"
+    fi
+done
+
+
 # === Summary ===
 
 if test $FAILURES -eq 0 ; then
@@ -0,0 +1,445 @@
+/*                       B A T C H . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file batch.cpp
+ *
+ * Parallel evaluation of a list of rays using the current NIRT state.
+ *
+ * The interactive shot path reports through the nirt_state itself and
+ * looks up every format key by name on every shot, which makes it
+ * inherently serial.  Here the output formats are compiled once into
+ * (printf fragment, key id) pairs, and each thread shoots with its own
+ * application, resource and output record.  Rays are processed in
+ * chunks, and each chunk's output is written in input order before the
+ * next one is read, so arbitrarily long ray lists stream through in
+ * bounded memory.
+ */
+
+#include "common.h"
+
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include "bu/parallel.h"
+#include "bu/vls.h"
+
+#include "./nirt.h"
+
+/* rays read, shot and written per pass */
+#define NIRT_BATCH_CHUNK 8192
+
+struct nirt_bfmt {
+    std::string fmt;
+    int key;
+};
+
+/* One report type's compiled format */
+typedef std::vector<struct nirt_bfmt> nirt_bfmt_vect;
+
+struct nirt_batch_fmts {
+    nirt_bfmt_vect ray, head, part, foot, miss, ovlp, gap;
+    /* nirt_cmd up to the ray, which each shot appends its own ray to */
+    std::string nirt_cmd_head;
+    bool use_nirt_cmd;
+    double base2local;
+};
+
+/* Per-thread shot state */
+struct nirt_batch_ctx {
+    const struct nirt_batch_fmts *f;
+    const std::set<std::string> *attrs;
+    int overlap_claims;
+    struct application ap;
+    struct resource *resp;
+    struct nirt_output_record vals;
+    nirt_seg seg;
+    std::string nirt_cmd;
+    struct bu_vls *out;
+};
+
+struct nirt_batch_data {
+    struct nirt_batch_ctx *ctx;
+    std::atomic<size_t> next_ctx;
+    std::atomic<size_t> next_ray;
+    size_t nrays;
+    const double *rays;
+    struct bu_vls *outs;
+    int backout;
+    double local2base;
+};
+
+
+static int
+_nirt_batch_compile(struct nirt_state *nss, struct nirt_batch_fmts *f, nirt_bfmt_vect &out, const std::vector<std::pair<std::string,std::string> > &in)
+{
+    out.clear();
+    for (size_t i = 0; i < in.size(); i++) {
+	struct nirt_bfmt bf;
+	bf.fmt = in[i].first;
+	bf.key = _nirt_key_id(in[i].second.c_str());
+	if (bf.key < 0) {
+	    nerr(nss, "Error: unknown output key %s\n", in[i].second.c_str());
+	    return -1;
+	}
+	if (bf.key == NIRT_KEY_NIRT_CMD)
+	    f->use_nirt_cmd = true;
+	/* adjacent literals collapse into one */
+	if (bf.key == NIRT_KEY_NONE && out.size() && out.back().key == NIRT_KEY_NONE) {
+	    out.back().fmt.append(bf.fmt);
+	    continue;
+	}
+	out.push_back(bf);
+    }
+    return 0;
+}
+
+
+static void
+_nirt_batch_report(struct nirt_batch_ctx *c, const nirt_bfmt_vect &fv)
+{
+    /* Keys not available for this report contribute nothing, as with
+     * the interactive path */
+    for (size_t i = 0; i < fv.size(); i++)
+	(void)_nirt_print_key(c->out, fv[i].fmt.c_str(), fv[i].key, &c->vals, c->f->base2local, c->nirt_cmd.c_str());
+}
+
+
+/* Mirrors _nirt_if_hit, without the plotting and diff bookkeeping */
+extern "C" int
+_nirt_batch_if_hit(struct application *ap, struct partition *part_head, struct seg *UNUSED(finished_segs))
+{
+    struct nirt_batch_ctx *c = (struct nirt_batch_ctx *)ap->a_uptr;
+    struct nirt_output_record *vals = &c->vals;
+    nirt_seg *s = &c->seg;
+    struct nirt_overlap *ovp;
+    struct partition *part;
+    point_t out_old = VINIT_ZERO;
+    double d_out_old = 0.0;
+    int part_nm = 0;
+
+    _nirt_batch_report(c, c->f->ray);
+    _nirt_batch_report(c, c->f->head);
+
+    if (c->overlap_claims == NIRT_OVLP_REBUILD_FASTGEN) {
+	rt_rebuild_overlaps(part_head, ap, 1);
+    } else if (c->overlap_claims == NIRT_OVLP_REBUILD_ALL) {
+	rt_rebuild_overlaps(part_head, ap, 0);
+    }
+
+    for (part = part_head->pt_forw; part != part_head; part = part->pt_forw) {
+	s->type = NIRT_PARTITION_SEG;
+
+	++part_nm;
+
+	_nirt_seg_part(s, vals, ap, part, *c->attrs);
+	if (part_nm > 1) VMOVE(s->gap_in, out_old);
+
+	if (part_nm > 1) {
+	    s->gap_los = d_out_old - s->d_in;
+	    if (s->gap_los > 0) {
+		s->type = NIRT_GAP_SEG;
+		_nirt_batch_report(c, c->f->gap);
+		s->type = NIRT_PARTITION_SEG;
+	    }
+	}
+	VMOVE(out_old, s->out);
+	d_out_old = s->d_out;
+
+	_nirt_batch_report(c, c->f->part);
+
+	while ((ovp = _nirt_find_ovlp(vals, part)) != NIRT_OVERLAP_NULL) {
+	    s->type = NIRT_OVERLAP_SEG;
+	    _nirt_seg_ovlp(s, vals, part, ovp);
+	    _nirt_batch_report(c, c->f->ovlp);
+	    _nirt_del_ovlp(ovp);
+	}
+    }
+
+    _nirt_batch_report(c, c->f->foot);
+
+    return HIT;
+}
+
+
+extern "C" int
+_nirt_batch_if_miss(struct application *ap)
+{
+    struct nirt_batch_ctx *c = (struct nirt_batch_ctx *)ap->a_uptr;
+    _nirt_batch_report(c, c->f->ray);
+    _nirt_batch_report(c, c->f->miss);
+    return MISS;
+}
+
+
+extern "C" int
+_nirt_batch_if_overlap(struct application *ap, struct partition *pp, struct region *reg1, struct region *reg2, struct partition *InputHdp)
+{
+    struct nirt_batch_ctx *c = (struct nirt_batch_ctx *)ap->a_uptr;
+    _nirt_add_ovlp(&c->vals, ap, pp, reg1, reg2);
+    return rt_defoverlap(ap, pp, reg1, reg2, InputHdp);
+}
+
+
+/* Set up the output record for one ray, the way the xyz, dir and s
+ * commands would have */
+static void
+_nirt_batch_setup_ray(struct nirt_batch_ctx *c, const double *ray, struct nirt_batch_data *d)
+{
+    struct nirt_output_record *r = &c->vals;
+
+    VSCALE(r->orig, ray, d->local2base);
+    VMOVE(r->dir, ray + 3);
+    VUNITIZE(r->dir);
+    _nirt_vals_dir2ae(r);
+    _nirt_vals_targ2grid(r);
+
+    if (d->backout) {
+	double bov = _nirt_backout_dist(c->ap.a_rt_i, r->orig, r->dir);
+	VJOIN1(r->orig, r->orig, -bov, r->dir);
+    }
+
+    VMOVE(c->ap.a_ray.r_pt, r->orig);
+    VMOVE(c->ap.a_ray.r_dir, r->dir);
+
+    /* As in the interactive path, nirt_cmd reports the backed out origin */
+    if (c->f->use_nirt_cmd) {
+	struct bu_vls rstr = BU_VLS_INIT_ZERO;
+	_nirt_cmd_str_ray(&rstr, r);
+	c->nirt_cmd = c->f->nirt_cmd_head + std::string(bu_vls_cstr(&rstr));
+	bu_vls_free(&rstr);
+    }
+
+    c->seg = nirt_seg();
+}
+
+
+static void
+_nirt_batch_worker(int UNUSED(cpu), void *ptr)
+{
+    struct nirt_batch_data *d = (struct nirt_batch_data *)ptr;
+    struct nirt_batch_ctx *c = &d->ctx[d->next_ctx++];
+    size_t i;
+
+    while ((i = d->next_ray++) < d->nrays) {
+	c->out = &d->outs[i];
+	_nirt_batch_setup_ray(c, &d->rays[6*i], d);
+	(void)rt_shootray(&c->ap);
+	_nirt_free_ovlps(&c->vals);
+    }
+}
+
+
+/* Read up to max rays into rays, returning the count or -1 on a parse error */
+static long
+_nirt_batch_read(struct nirt_state *nss, FILE *ifp, int binary, double *rays, size_t max, size_t *lineno)
+{
+    size_t n = 0;
+
+    if (binary) {
+	n = fread(rays, 6 * sizeof(double), max, ifp);
+	if (n < max && ferror(ifp)) {
+	    nerr(nss, "Error: failed reading binary ray list\n");
+	    return -1;
+	}
+	return (long)n;
+    }
+
+    struct bu_vls line = BU_VLS_INIT_ZERO;
+    while (n < max && bu_vls_gets(&line, ifp) >= 0) {
+	char *cp = bu_vls_addr(&line);
+	char *ep;
+	(*lineno)++;
+	for (char *p = cp; *p; p++) {
+	    if (*p == ',')
+		*p = ' ';
+	}
+	while (isspace((int)*cp))
+	    cp++;
+	if (*cp == '\0' || *cp == '#') {
+	    bu_vls_trunc(&line, 0);
+	    continue;
+	}
+	for (int j = 0; j < 6; j++) {
+	    rays[6*n+j] = strtod(cp, &ep);
+	    if (ep == cp) {
+		nerr(nss, "Error: line %zu of ray list: expected x y z dx dy dz\n", *lineno);
+		bu_vls_free(&line);
+		return -1;
+	    }
+	    cp = ep;
+	}
+	n++;
+	bu_vls_trunc(&line, 0);
+    }
+    bu_vls_free(&line);
+
+    return (long)n;
+}
+
+
+long
+nirt_batch(struct nirt_state *nss, FILE *ifp, int binary, FILE *ofp, int ncpu)
+{
+    struct nirt_batch_fmts f;
+    struct rt_i *rtip;
+    long total = 0;
+    size_t lineno = 0;
+    size_t i;
+
+    if (!nss || !nss->i->ap || !ifp || !ofp)
+	return -1;
+
+    rtip = _nirt_get_rtip(nss);
+    if (!rtip) {
+	nerr(nss, "Error: no active objects to shoot\n");
+	return -1;
+    }
+    if (nss->i->need_reprep) {
+	if (_nirt_raytrace_prep(nss)) {
+	    nerr(nss, "Error: raytrace prep failed!\n");
+	    return -1;
+	}
+    }
+    nss->i->ap->a_rt_i = rtip;
+    nss->i->ap->a_resource = _nirt_get_resource(nss);
+
+    f.use_nirt_cmd = false;
+    if (_nirt_batch_compile(nss, &f, f.ray, nss->i->fmt.ray)
+	|| _nirt_batch_compile(nss, &f, f.head, nss->i->fmt.head)
+	|| _nirt_batch_compile(nss, &f, f.part, nss->i->fmt.part)
+	|| _nirt_batch_compile(nss, &f, f.foot, nss->i->fmt.foot)
+	|| _nirt_batch_compile(nss, &f, f.miss, nss->i->fmt.miss)
+	|| _nirt_batch_compile(nss, &f, f.ovlp, nss->i->fmt.ovlp)
+	|| _nirt_batch_compile(nss, &f, f.gap, nss->i->fmt.gap))
+	return -1;
+    f.base2local = nss->i->base2local;
+    if (f.use_nirt_cmd) {
+	struct bu_vls c_nirtcmd = BU_VLS_INIT_ZERO;
+	if (_nirt_cmd_str_head(&c_nirtcmd, nss))
+	    f.nirt_cmd_head = std::string(bu_vls_cstr(&c_nirtcmd));
+	bu_vls_free(&c_nirtcmd);
+    }
+
+    size_t avail = bu_avail_cpus();
+    size_t nthreads = (ncpu > 0) ? (size_t)ncpu : avail;
+    if (nthreads > avail)
+	nthreads = avail;
+    /* resource slot 0 belongs to the interactive shots */
+    if (nthreads > MAX_PSW - 1)
+	nthreads = MAX_PSW - 1;
+    if (nthreads < 1)
+	nthreads = 1;
+
+    /* Thread 0 reuses the state's own resource, the rest get their own */
+    struct resource *res = (struct resource *)bu_calloc(nthreads, sizeof(struct resource), "batch resources");
+    struct nirt_batch_ctx *ctx = new struct nirt_batch_ctx[nthreads];
+    for (i = 0; i < nthreads; i++) {
+	struct nirt_batch_ctx *c = &ctx[i];
+	c->f = &f;
+	c->attrs = &nss->i->attrs;
+	c->overlap_claims = nss->i->overlap_claims;
+	if (i == 0) {
+	    c->resp = nss->i->ap->a_resource;
+	} else {
+	    c->resp = &res[i];
+	    rt_init_resource(c->resp, (int)i, rtip);
+	}
+	RT_APPLICATION_INIT(&c->ap);
+	c->ap.a_hit = _nirt_batch_if_hit;
+	c->ap.a_miss = _nirt_batch_if_miss;
+	c->ap.a_overlap = _nirt_batch_if_overlap;
+	c->ap.a_logoverlap = rt_silent_logoverlap;
+	c->ap.a_onehit = 0;
+	c->ap.a_purpose = "NIRT batch ray";
+	c->ap.a_rt_i = rtip;
+	c->ap.a_resource = c->resp;
+	c->ap.a_uptr = (void *)c;
+	memset(&c->vals, 0, sizeof(struct nirt_output_record));
+	c->vals.ovlp_list.forw = c->vals.ovlp_list.backw = &(c->vals.ovlp_list);
+	c->vals.seg = &c->seg;
+	c->out = NULL;
+    }
+
+    double *rays = (double *)bu_malloc(NIRT_BATCH_CHUNK * 6 * sizeof(double), "batch rays");
+    struct bu_vls *outs = (struct bu_vls *)bu_calloc(NIRT_BATCH_CHUNK, sizeof(struct bu_vls), "batch output");
+    for (i = 0; i < NIRT_BATCH_CHUNK; i++)
+	bu_vls_init(&outs[i]);
+
+    struct nirt_batch_data d;
+    d.ctx = ctx;
+    d.rays = rays;
+    d.outs = outs;
+    d.backout = nss->i->backout;
+    d.local2base = nss->i->local2base;
+
+    while (1) {
+	long n = _nirt_batch_read(nss, ifp, binary, rays, NIRT_BATCH_CHUNK, &lineno);
+	if (n < 0) {
+	    total = -1;
+	    break;
+	}
+	if (!n)
+	    break;
+
+	d.nrays = (size_t)n;
+	d.next_ray = 0;
+	d.next_ctx = 0;
+	size_t nworkers = (nthreads < (size_t)n) ? nthreads : (size_t)n;
+	bu_parallel(_nirt_batch_worker, nworkers, &d);
+
+	for (i = 0; i < (size_t)n; i++) {
+	    if (bu_vls_strlen(&outs[i]))
+		fwrite(bu_vls_cstr(&outs[i]), 1, bu_vls_strlen(&outs[i]), ofp);
+	    bu_vls_trunc(&outs[i], 0);
+	}
+	total += n;
+
+	if ((size_t)n < NIRT_BATCH_CHUNK)
+	    break;
+    }
+    fflush(ofp);
+
+    for (i = 0; i < NIRT_BATCH_CHUNK; i++)
+	bu_vls_free(&outs[i]);
+    bu_free(outs, "batch output");
+    bu_free(rays, "batch rays");
+
+    /* Unregister the extra resources before releasing them */
+    for (i = 1; i < nthreads; i++) {
+	rt_clean_resource_basic(rtip, &res[i]);
+	BU_PTBL_SET(&rtip->rti_resources, i, NULL);
+    }
+    bu_free(res, "batch resources");
+    delete[] ctx;
+
+    return total;
+}
+
+
+// Local Variables:
+// tab-width: 8
+// mode: C++
+// c-basic-offset: 4
+// indent-tabs-mode: t
+// c-file-style: "stroustrup"
+// End:
+// ex: shiftwidth=4 tabstop=8
@@ -48,8 +48,10 @@
 while (0)
 
 
+/* The part of the nirt_cmd string common to every shot: the command
+ * line and units, up to the ray itself */
 bool
-nirt_cmd_str(struct bu_vls *nirt_cmd, struct nirt_state *nss)
+_nirt_cmd_str_head(struct bu_vls *nirt_cmd, struct nirt_state *nss)
 {
     if (!nirt_cmd || !nss) return false;
 
@@ -80,21 +82,36 @@ nirt_cmd_str(struct bu_vls *nirt_cmd, struct nirt_state *nss)
     /* Make sure the units match */
     bu_vls_printf(&wstr, "units %s;", bu_units_string(nss->i->local2base));
 
-    std::string xyz_x = _nirt_dbl_to_str(nss->i->vals->orig[X], 0);
-    std::string xyz_y = _nirt_dbl_to_str(nss->i->vals->orig[Y], 0);
-    std::string xyz_z = _nirt_dbl_to_str(nss->i->vals->orig[Z], 0);
-    bu_vls_printf(&wstr, "xyz %s %s %s;", xyz_x.c_str(), xyz_y.c_str(), xyz_z.c_str());
+    bu_vls_printf(nirt_cmd, "%s", bu_vls_cstr(&wstr));
 
-    std::string dir_x = _nirt_dbl_to_str(nss->i->vals->dir[X], 0);
-    std::string dir_y = _nirt_dbl_to_str(nss->i->vals->dir[Y], 0);
-    std::string dir_z = _nirt_dbl_to_str(nss->i->vals->dir[Z], 0);
-    bu_vls_printf(&wstr, "dir %s %s %s;", dir_x.c_str(), dir_y.c_str(), dir_z.c_str());
+    bu_vls_free(&wstr);
+    return true;
+}
 
-    bu_vls_printf(&wstr, "s;q\"");
+/* The ray-specific tail of the nirt_cmd string */
+void
+_nirt_cmd_str_ray(struct bu_vls *nirt_cmd, const struct nirt_output_record *r)
+{
+    std::string xyz_x = _nirt_dbl_to_str(r->orig[X], 0);
+    std::string xyz_y = _nirt_dbl_to_str(r->orig[Y], 0);
+    std::string xyz_z = _nirt_dbl_to_str(r->orig[Z], 0);
+    bu_vls_printf(nirt_cmd, "xyz %s %s %s;", xyz_x.c_str(), xyz_y.c_str(), xyz_z.c_str());
 
-    bu_vls_printf(nirt_cmd, "%s", bu_vls_cstr(&wstr));
+    std::string dir_x = _nirt_dbl_to_str(r->dir[X], 0);
+    std::string dir_y = _nirt_dbl_to_str(r->dir[Y], 0);
+    std::string dir_z = _nirt_dbl_to_str(r->dir[Z], 0);
+    bu_vls_printf(nirt_cmd, "dir %s %s %s;", dir_x.c_str(), dir_y.c_str(), dir_z.c_str());
 
-    bu_vls_free(&wstr);
+    bu_vls_printf(nirt_cmd, "s;q\"");
+}
+
+
+bool
+nirt_cmd_str(struct bu_vls *nirt_cmd, struct nirt_state *nss)
+{
+    if (!_nirt_cmd_str_head(nirt_cmd, nss))
+	return false;
+    _nirt_cmd_str_ray(nirt_cmd, nss->i->vals);
     return true;
 }
 
@@ -278,26 +295,28 @@ _nirt_str_to_int(std::string s)
  * Conversions and Calculations *
  ********************************/
 
-static fastf_t
-d_calc(struct nirt_state *nss, point_t p)
+/* Distance along, and horizontal and vertical grid offsets across, the
+ * ray direction of r */
+fastf_t
+_nirt_calc_d(const struct nirt_output_record *r, const fastf_t *p)
 {
-    fastf_t ar = nss->i->vals->a * DEG2RAD;
-    fastf_t er = nss->i->vals->e * DEG2RAD;
+    fastf_t ar = r->a * DEG2RAD;
+    fastf_t er = r->e * DEG2RAD;
     return p[X] * cos(er) * cos(ar) + p[Y] * cos(er) * sin(ar) + p[Z] * sin(er);
 }
 
-static fastf_t
-h_calc(struct nirt_state *nss, point_t p)
+fastf_t
+_nirt_calc_h(const struct nirt_output_record *r, const fastf_t *p)
 {
-    fastf_t ar = nss->i->vals->a * DEG2RAD;
+    fastf_t ar = r->a * DEG2RAD;
     return p[X] * (-sin(ar)) + p[Y] * cos(ar);
 }
 
-static fastf_t
-v_calc(struct nirt_state *nss, point_t p)
+fastf_t
+_nirt_calc_v(const struct nirt_output_record *r, const fastf_t *p)
 {
-    fastf_t ar = nss->i->vals->a * DEG2RAD;
-    fastf_t er = nss->i->vals->e * DEG2RAD;
+    fastf_t ar = r->a * DEG2RAD;
+    fastf_t er = r->e * DEG2RAD;
     return p[X] * (-sin(er)) * cos(ar) + p[Y] * (-sin(er)) * sin(ar) + p[Z] * cos(er);
 }
 
@@ -310,22 +329,32 @@ static void _nirt_grid2targ(struct nirt_state *nss)
     nss->i->vals->orig[Z] =   nss->i->vals->v * cos(er) + nss->i->vals->d_orig * sin(er);
 }
 
+void _nirt_vals_targ2grid(struct nirt_output_record *r)
+{
+    double ar = r->a * DEG2RAD;
+    double er = r->e * DEG2RAD;
+    r->h = - r->orig[X] * sin(ar) + r->orig[Y] * cos(ar);
+    r->v = - r->orig[X] * cos(ar) * sin(er) - r->orig[Y] * sin(er) * sin(ar) + r->orig[Z] * cos(er);
+    r->d_orig =   r->orig[X] * cos(er) * cos(ar) + r->orig[Y] * cos(er) * sin(ar) + r->orig[Z] * sin(er);
+}
+
 void _nirt_targ2grid(struct nirt_state *nss)
 {
-    double ar = nss->i->vals->a * DEG2RAD;
-    double er = nss->i->vals->e * DEG2RAD;
-    nss->i->vals->h = - nss->i->vals->orig[X] * sin(ar) + nss->i->vals->orig[Y] * cos(ar);
-    nss->i->vals->v = - nss->i->vals->orig[X] * cos(ar) * sin(er) - nss->i->vals->orig[Y] * sin(er) * sin(ar) + nss->i->vals->orig[Z] * cos(er);
-    nss->i->vals->d_orig =   nss->i->vals->orig[X] * cos(er) * cos(ar) + nss->i->vals->orig[Y] * cos(er) * sin(ar) + nss->i->vals->orig[Z] * sin(er);
+    _nirt_vals_targ2grid(nss->i->vals);
 }
 
-void _nirt_dir2ae(struct nirt_state *nss)
+void _nirt_vals_dir2ae(struct nirt_output_record *r)
 {
-    int zeroes = ZERO(nss->i->vals->dir[Y]) && ZERO(nss->i->vals->dir[X]);
-    double square = sqrt(nss->i->vals->dir[X] * nss->i->vals->dir[X] + nss->i->vals->dir[Y] * nss->i->vals->dir[Y]);
+    int zeroes = ZERO(r->dir[Y]) && ZERO(r->dir[X]);
+    double square = sqrt(r->dir[X] * r->dir[X] + r->dir[Y] * r->dir[Y]);
 
-    nss->i->vals->a = zeroes ? 0.0 : atan2 (-(nss->i->vals->dir[Y]), -(nss->i->vals->dir[X])) / DEG2RAD;
-    nss->i->vals->e = atan2(-(nss->i->vals->dir[Z]), square) / DEG2RAD;
+    r->a = zeroes ? 0.0 : atan2 (-(r->dir[Y]), -(r->dir[X])) / DEG2RAD;
+    r->e = atan2(-(r->dir[Z]), square) / DEG2RAD;
+}
+
+void _nirt_dir2ae(struct nirt_state *nss)
+{
+    _nirt_vals_dir2ae(nss->i->vals);
 }
 
 static void _nirt_ae2dir(struct nirt_state *nss)
@@ -341,26 +370,27 @@ static void _nirt_ae2dir(struct nirt_state *nss)
     VMOVE(nss->i->vals->dir, dir);
 }
 
-static double _nirt_backout(struct nirt_state *nss)
+/* Distance to back a ray aimed at pt out along dir so that it starts
+ * outside the model */
+double
+_nirt_backout_dist(const struct rt_i *rtip, const fastf_t *pt, const fastf_t *dir)
 {
     double bov;
     point_t ray_point;
     vect_t diag, dvec, ray_dir, center_bsphere;
     fastf_t bsphere_diameter, dist_to_target, delta;
 
-    if (!nss || !nss->i->backout) return 0.0;
-
-    VMOVE(ray_point, nss->i->vals->orig);
-    VMOVE(ray_dir, nss->i->vals->dir);
+    VMOVE(ray_point, pt);
+    VMOVE(ray_dir, dir);
 
-    VSUB2(diag, nss->i->ap->a_rt_i->mdl_max, nss->i->ap->a_rt_i->mdl_min);
+    VSUB2(diag, rtip->mdl_max, rtip->mdl_min);
     bsphere_diameter = MAGNITUDE(diag);
 
     /*
      * calculate the distance from a plane normal to the ray direction through the center of
      * the bounding sphere and a plane normal to the ray direction through the aim point.
      */
-    VADD2SCALE(center_bsphere, nss->i->ap->a_rt_i->mdl_max, nss->i->ap->a_rt_i->mdl_min, 0.5);
+    VADD2SCALE(center_bsphere, rtip->mdl_max, rtip->mdl_min, 0.5);
 
     dist_to_target = DIST_PNT_PNT(center_bsphere, ray_point);
 
@@ -376,8 +406,15 @@ static double _nirt_backout(struct nirt_state *nss)
     return bov;
 }
 
-static fastf_t
-_nirt_get_obliq(fastf_t *ray, fastf_t *normal)
+static double _nirt_backout(struct nirt_state *nss)
+{
+    if (!nss || !nss->i->backout) return 0.0;
+
+    return _nirt_backout_dist(nss->i->ap->a_rt_i, nss->i->vals->orig, nss->i->vals->dir);
+}
+
+fastf_t
+nirt_get_obliq(const fastf_t *ray, const fastf_t *normal)
 {
     fastf_t cos_obl;
     fastf_t obliquity;
@@ -879,25 +916,180 @@ _nirt_print_fmt_cmd(struct bu_vls *ostr, char f, std::vector<std::pair<std::stri
     bu_vls_sprintf(ostr, "fmt %c \"%s\"%s\n", f, fmt_str.c_str(), fmt_keys.c_str());
 }
 
-/* Translate NIRT fmt substrings into fully evaluated printf output, while also
- * handling units on key values.  This should never be called using any fmt
- * string that hasn't been validated by _nirt_fmt_sp_validate and _nirt_fmt_sp_key_check */
-#define nirt_print_key(keystr,val) \
-    do {if (BU_STR_EQUAL(key, keystr)) { bu_vls_printf(ostr, fmt, val); return; } } \
-    while (0)
+/* Output keys by name.  This should never be used with a fmt string
+ * that hasn't been validated by _nirt_fmt_sp_validate and
+ * _nirt_fmt_sp_key_check */
+struct nirt_key_def {
+    const char *name;
+    int key;
+};
+
+static const struct nirt_key_def nirt_keys[] = {
+    {"nirt_cmd", NIRT_KEY_NIRT_CMD},
+    {"x_orig", NIRT_KEY_X_ORIG}, {"y_orig", NIRT_KEY_Y_ORIG}, {"z_orig", NIRT_KEY_Z_ORIG},
+    {"h", NIRT_KEY_H}, {"v", NIRT_KEY_V}, {"d_orig", NIRT_KEY_D_ORIG},
+    {"x_dir", NIRT_KEY_X_DIR}, {"y_dir", NIRT_KEY_Y_DIR}, {"z_dir", NIRT_KEY_Z_DIR},
+    {"a", NIRT_KEY_A}, {"e", NIRT_KEY_E},
+    {"x_in", NIRT_KEY_X_IN}, {"y_in", NIRT_KEY_Y_IN}, {"z_in", NIRT_KEY_Z_IN}, {"d_in", NIRT_KEY_D_IN},
+    {"x_out", NIRT_KEY_X_OUT}, {"y_out", NIRT_KEY_Y_OUT}, {"z_out", NIRT_KEY_Z_OUT}, {"d_out", NIRT_KEY_D_OUT},
+    {"los", NIRT_KEY_LOS}, {"scaled_los", NIRT_KEY_SCALED_LOS},
+    {"path_name", NIRT_KEY_PATH_NAME}, {"reg_name", NIRT_KEY_REG_NAME}, {"reg_id", NIRT_KEY_REG_ID},
+    {"obliq_in", NIRT_KEY_OBLIQ_IN}, {"obliq_out", NIRT_KEY_OBLIQ_OUT},
+    {"nm_x_in", NIRT_KEY_NM_X_IN}, {"nm_y_in", NIRT_KEY_NM_Y_IN}, {"nm_z_in", NIRT_KEY_NM_Z_IN},
+    {"nm_d_in", NIRT_KEY_NM_D_IN}, {"nm_h_in", NIRT_KEY_NM_H_IN}, {"nm_v_in", NIRT_KEY_NM_V_IN},
+    {"nm_x_out", NIRT_KEY_NM_X_OUT}, {"nm_y_out", NIRT_KEY_NM_Y_OUT}, {"nm_z_out", NIRT_KEY_NM_Z_OUT},
+    {"nm_d_out", NIRT_KEY_NM_D_OUT}, {"nm_h_out", NIRT_KEY_NM_H_OUT}, {"nm_v_out", NIRT_KEY_NM_V_OUT},
+    {"surf_num_in", NIRT_KEY_SURF_NUM_IN}, {"surf_num_out", NIRT_KEY_SURF_NUM_OUT},
+    {"claimant_count", NIRT_KEY_CLAIMANT_COUNT}, {"claimant_list", NIRT_KEY_CLAIMANT_LIST},
+    {"claimant_listn", NIRT_KEY_CLAIMANT_LISTN}, {"attributes", NIRT_KEY_ATTRIBUTES},
+    {"ov_reg1_name", NIRT_KEY_OV_REG1_NAME}, {"ov_reg1_id", NIRT_KEY_OV_REG1_ID},
+    {"ov_reg2_name", NIRT_KEY_OV_REG2_NAME}, {"ov_reg2_id", NIRT_KEY_OV_REG2_ID},
+    {"ov_sol_in", NIRT_KEY_OV_SOL_IN}, {"ov_sol_out", NIRT_KEY_OV_SOL_OUT}, {"ov_los", NIRT_KEY_OV_LOS},
+    {"ov_x_in", NIRT_KEY_OV_X_IN}, {"ov_y_in", NIRT_KEY_OV_Y_IN}, {"ov_z_in", NIRT_KEY_OV_Z_IN},
+    {"ov_d_in", NIRT_KEY_OV_D_IN}, {"ov_x_out", NIRT_KEY_OV_X_OUT}, {"ov_y_out", NIRT_KEY_OV_Y_OUT},
+    {"ov_z_out", NIRT_KEY_OV_Z_OUT}, {"ov_d_out", NIRT_KEY_OV_D_OUT},
+    {"x_gap_in", NIRT_KEY_X_GAP_IN}, {"y_gap_in", NIRT_KEY_Y_GAP_IN}, {"z_gap_in", NIRT_KEY_Z_GAP_IN},
+    {"gap_los", NIRT_KEY_GAP_LOS},
+    {NULL, NIRT_KEY_NONE}
+};
+
+int
+_nirt_key_id(const char *key)
+{
+    if (!key || !strlen(key))
+	return NIRT_KEY_NONE;
+    for (const struct nirt_key_def *k = nirt_keys; k->name; k++) {
+	if (BU_STR_EQUAL(k->name, key))
+	    return k->key;
+    }
+    return -1;
+}
+
+/* Translate a NIRT fmt substring and its key into fully evaluated printf
+ * output, handling units on key values.  Returns 0 if the key isn't
+ * available for r's current segment type. */
+int
+_nirt_print_key(struct bu_vls *o, const char *fmt, int key, const struct nirt_output_record *r, fastf_t base2local, const char *nirt_cmd)
+{
+    if (!o || !fmt || !r)
+	return 0;
+
+    const nirt_seg *s = r->seg;
+    fastf_t b2l = base2local;
+    int part = s && (s->type == NIRT_PARTITION_SEG || s->type == NIRT_ALL_SEG);
+    int ovlp = s && (s->type == NIRT_OVERLAP_SEG || s->type == NIRT_ALL_SEG);
+    int gap = s && (s->type == NIRT_GAP_SEG || s->type == NIRT_ALL_SEG);
+
+    switch (key) {
+	case NIRT_KEY_NONE: bu_vls_printf(o, "%s", fmt); return 1;
+	case NIRT_KEY_NIRT_CMD:
+	    if (!nirt_cmd)
+		return 0;
+	    bu_vls_printf(o, fmt, nirt_cmd);
+	    return 1;
+	case NIRT_KEY_X_ORIG: bu_vls_printf(o, fmt, r->orig[X] * b2l); return 1;
+	case NIRT_KEY_Y_ORIG: bu_vls_printf(o, fmt, r->orig[Y] * b2l); return 1;
+	case NIRT_KEY_Z_ORIG: bu_vls_printf(o, fmt, r->orig[Z] * b2l); return 1;
+	case NIRT_KEY_H: bu_vls_printf(o, fmt, r->h * b2l); return 1;
+	case NIRT_KEY_V: bu_vls_printf(o, fmt, r->v * b2l); return 1;
+	case NIRT_KEY_D_ORIG: bu_vls_printf(o, fmt, r->d_orig * b2l); return 1;
+	case NIRT_KEY_X_DIR: bu_vls_printf(o, fmt, r->dir[X]); return 1;
+	case NIRT_KEY_Y_DIR: bu_vls_printf(o, fmt, r->dir[Y]); return 1;
+	case NIRT_KEY_Z_DIR: bu_vls_printf(o, fmt, r->dir[Z]); return 1;
+	case NIRT_KEY_A: bu_vls_printf(o, fmt, r->a); return 1;
+	case NIRT_KEY_E: bu_vls_printf(o, fmt, r->e); return 1;
+	default: break;
+    }
+
+    if (part || gap) {
+	switch (key) {
+	    case NIRT_KEY_X_IN: bu_vls_printf(o, fmt, s->in[X] * b2l); return 1;
+	    case NIRT_KEY_Y_IN: bu_vls_printf(o, fmt, s->in[Y] * b2l); return 1;
+	    case NIRT_KEY_Z_IN: bu_vls_printf(o, fmt, s->in[Z] * b2l); return 1;
+	    default: break;
+	}
+    }
+
+    if (part) {
+	switch (key) {
+	    case NIRT_KEY_D_IN: bu_vls_printf(o, fmt, s->d_in * b2l); return 1;
+	    case NIRT_KEY_X_OUT: bu_vls_printf(o, fmt, s->out[X] * b2l); return 1;
+	    case NIRT_KEY_Y_OUT: bu_vls_printf(o, fmt, s->out[Y] * b2l); return 1;
+	    case NIRT_KEY_Z_OUT: bu_vls_printf(o, fmt, s->out[Z] * b2l); return 1;
+	    case NIRT_KEY_D_OUT: bu_vls_printf(o, fmt, s->d_out * b2l); return 1;
+	    case NIRT_KEY_LOS: bu_vls_printf(o, fmt, s->los * b2l); return 1;
+	    case NIRT_KEY_SCALED_LOS: bu_vls_printf(o, fmt, s->scaled_los * b2l); return 1;
+	    case NIRT_KEY_PATH_NAME: bu_vls_printf(o, fmt, s->path_name.c_str()); return 1;
+	    case NIRT_KEY_REG_NAME: bu_vls_printf(o, fmt, s->reg_name.c_str()); return 1;
+	    case NIRT_KEY_REG_ID: bu_vls_printf(o, fmt, s->reg_id); return 1;
+	    case NIRT_KEY_OBLIQ_IN: bu_vls_printf(o, fmt, s->obliq_in); return 1;
+	    case NIRT_KEY_OBLIQ_OUT: bu_vls_printf(o, fmt, s->obliq_out); return 1;
+	    case NIRT_KEY_NM_X_IN: bu_vls_printf(o, fmt, s->nm_in[X]); return 1;
+	    case NIRT_KEY_NM_Y_IN: bu_vls_printf(o, fmt, s->nm_in[Y]); return 1;
+	    case NIRT_KEY_NM_Z_IN: bu_vls_printf(o, fmt, s->nm_in[Z]); return 1;
+	    case NIRT_KEY_NM_D_IN: bu_vls_printf(o, fmt, s->nm_d_in); return 1;
+	    case NIRT_KEY_NM_H_IN: bu_vls_printf(o, fmt, s->nm_h_in); return 1;
+	    case NIRT_KEY_NM_V_IN: bu_vls_printf(o, fmt, s->nm_v_in); return 1;
+	    case NIRT_KEY_NM_X_OUT: bu_vls_printf(o, fmt, s->nm_out[X]); return 1;
+	    case NIRT_KEY_NM_Y_OUT: bu_vls_printf(o, fmt, s->nm_out[Y]); return 1;
+	    case NIRT_KEY_NM_Z_OUT: bu_vls_printf(o, fmt, s->nm_out[Z]); return 1;
+	    case NIRT_KEY_NM_D_OUT: bu_vls_printf(o, fmt, s->nm_d_out); return 1;
+	    case NIRT_KEY_NM_H_OUT: bu_vls_printf(o, fmt, s->nm_h_out); return 1;
+	    case NIRT_KEY_NM_V_OUT: bu_vls_printf(o, fmt, s->nm_v_out); return 1;
+	    case NIRT_KEY_SURF_NUM_IN: bu_vls_printf(o, fmt, s->surf_num_in); return 1;
+	    case NIRT_KEY_SURF_NUM_OUT: bu_vls_printf(o, fmt, s->surf_num_out); return 1;
+	    case NIRT_KEY_CLAIMANT_COUNT: bu_vls_printf(o, fmt, s->claimant_count); return 1;
+	    case NIRT_KEY_CLAIMANT_LIST: bu_vls_printf(o, fmt, s->claimant_list.c_str()); return 1;
+	    case NIRT_KEY_CLAIMANT_LISTN: bu_vls_printf(o, fmt, s->claimant_listn.c_str()); return 1;
+	    case NIRT_KEY_ATTRIBUTES: bu_vls_printf(o, fmt, s->attributes.c_str()); return 1;
+	    default: break;
+	}
+    }
+
+    if (ovlp) {
+	switch (key) {
+	    case NIRT_KEY_OV_REG1_NAME: bu_vls_printf(o, fmt, s->ov_reg1_name.c_str()); return 1;
+	    case NIRT_KEY_OV_REG1_ID: bu_vls_printf(o, fmt, s->ov_reg1_id); return 1;
+	    case NIRT_KEY_OV_REG2_NAME: bu_vls_printf(o, fmt, s->ov_reg2_name.c_str()); return 1;
+	    case NIRT_KEY_OV_REG2_ID: bu_vls_printf(o, fmt, s->ov_reg2_id); return 1;
+	    case NIRT_KEY_OV_SOL_IN: bu_vls_printf(o, fmt, s->ov_sol_in.c_str()); return 1;
+	    case NIRT_KEY_OV_SOL_OUT: bu_vls_printf(o, fmt, s->ov_sol_out.c_str()); return 1;
+	    case NIRT_KEY_OV_LOS: bu_vls_printf(o, fmt, s->ov_los * b2l); return 1;
+	    case NIRT_KEY_OV_X_IN: bu_vls_printf(o, fmt, s->ov_in[X] * b2l); return 1;
+	    case NIRT_KEY_OV_Y_IN: bu_vls_printf(o, fmt, s->ov_in[Y] * b2l); return 1;
+	    case NIRT_KEY_OV_Z_IN: bu_vls_printf(o, fmt, s->ov_in[Z] * b2l); return 1;
+	    case NIRT_KEY_OV_D_IN: bu_vls_printf(o, fmt, s->ov_d_in * b2l); return 1;
+	    case NIRT_KEY_OV_X_OUT: bu_vls_printf(o, fmt, s->ov_out[X] * b2l); return 1;
+	    case NIRT_KEY_OV_Y_OUT: bu_vls_printf(o, fmt, s->ov_out[Y] * b2l); return 1;
+	    case NIRT_KEY_OV_Z_OUT: bu_vls_printf(o, fmt, s->ov_out[Z] * b2l); return 1;
+	    case NIRT_KEY_OV_D_OUT: bu_vls_printf(o, fmt, s->ov_d_out * b2l); return 1;
+	    default: break;
+	}
+    }
+
+    if (gap) {
+	switch (key) {
+	    case NIRT_KEY_X_GAP_IN: bu_vls_printf(o, fmt, s->gap_in[X] * b2l); return 1;
+	    case NIRT_KEY_Y_GAP_IN: bu_vls_printf(o, fmt, s->gap_in[Y] * b2l); return 1;
+	    case NIRT_KEY_Z_GAP_IN: bu_vls_printf(o, fmt, s->gap_in[Z] * b2l); return 1;
+	    case NIRT_KEY_GAP_LOS: bu_vls_printf(o, fmt, s->gap_los * b2l); return 1;
+	    default: break;
+	}
+    }
+
+    return 0;
+}
 
 void
 _nirt_print_fmt_substr(struct nirt_state *nss, struct bu_vls *ostr, const char *fmt, const char *key, struct nirt_output_record *r, fastf_t base2local)
 {
     if (!ostr || !fmt || !r) return;
-    if (!key || !strlen(key)) {
-	bu_vls_printf(ostr, "%s", fmt);
-	return;
-    }
+
+    int k = _nirt_key_id(key);
 
     /* nirt_cmd is a special key to allow a nirt output to reproduce a command that would recreate
      * the execution. */
-    if (BU_STR_EQUAL(key, "nirt_cmd")) {
+    if (k == NIRT_KEY_NIRT_CMD) {
 	struct bu_vls c_nirtcmd = BU_VLS_INIT_ZERO;
 	if (nirt_cmd_str(&c_nirtcmd, nss)) {
 	    bu_vls_printf(ostr, fmt, bu_vls_cstr(&c_nirtcmd));
@@ -908,85 +1100,11 @@ _nirt_print_fmt_substr(struct nirt_state *nss, struct bu_vls *ostr, const char *
 	return;
     }
 
-    nirt_print_key("x_orig", r->orig[X] * base2local);
-    nirt_print_key("y_orig", r->orig[Y] * base2local);
-    nirt_print_key("z_orig", r->orig[Z] * base2local);
-    nirt_print_key("h", r->h * base2local);
-    nirt_print_key("v", r->v * base2local);
-    nirt_print_key("d_orig", r->d_orig * base2local);
-    nirt_print_key("x_dir", r->dir[X]);
-    nirt_print_key("y_dir", r->dir[Y]);
-    nirt_print_key("z_dir", r->dir[Z]);
-    nirt_print_key("a", r->a);
-    nirt_print_key("e", r->e);
+    if (_nirt_print_key(ostr, fmt, k, r, base2local, NULL))
+	return;
 
     if (!r->seg || r->seg->type == 0) return;
 
-    if (r->seg->type == NIRT_PARTITION_SEG || r->seg->type == NIRT_ALL_SEG) {
-	nirt_print_key("x_in", r->seg->in[X] * base2local);
-	nirt_print_key("y_in", r->seg->in[Y] * base2local);
-	nirt_print_key("z_in", r->seg->in[Z] * base2local);
-	nirt_print_key("d_in", r->seg->d_in * base2local);
-	nirt_print_key("x_out", r->seg->out[X] * base2local);
-	nirt_print_key("y_out", r->seg->out[Y] * base2local);
-	nirt_print_key("z_out", r->seg->out[Z] * base2local);
-	nirt_print_key("d_out", r->seg->d_out * base2local);
-	nirt_print_key("los", r->seg->los * base2local);
-	nirt_print_key("scaled_los", r->seg->scaled_los * base2local);
-	nirt_print_key("path_name", r->seg->path_name.c_str());
-	nirt_print_key("reg_name", r->seg->reg_name.c_str());
-	nirt_print_key("reg_id", r->seg->reg_id);
-	nirt_print_key("obliq_in", r->seg->obliq_in);
-	nirt_print_key("obliq_out", r->seg->obliq_out);
-	nirt_print_key("nm_x_in", r->seg->nm_in[X]);
-	nirt_print_key("nm_y_in", r->seg->nm_in[Y]);
-	nirt_print_key("nm_z_in", r->seg->nm_in[Z]);
-	nirt_print_key("nm_d_in", r->seg->nm_d_in);
-	nirt_print_key("nm_h_in", r->seg->nm_h_in);
-	nirt_print_key("nm_v_in", r->seg->nm_v_in);
-	nirt_print_key("nm_x_out", r->seg->nm_out[X]);
-	nirt_print_key("nm_y_out", r->seg->nm_out[Y]);
-	nirt_print_key("nm_z_out", r->seg->nm_out[Z]);
-	nirt_print_key("nm_d_out", r->seg->nm_d_out);
-	nirt_print_key("nm_h_out", r->seg->nm_h_out);
-	nirt_print_key("nm_v_out", r->seg->nm_v_out);
-	nirt_print_key("surf_num_in", r->seg->surf_num_in);
-	nirt_print_key("surf_num_out", r->seg->surf_num_out);
-	nirt_print_key("claimant_count", r->seg->claimant_count);
-	nirt_print_key("claimant_list", r->seg->claimant_list.c_str());
-	nirt_print_key("claimant_listn", r->seg->claimant_listn.c_str());
-	nirt_print_key("attributes", r->seg->attributes.c_str());
-    }
-
-    if (r->seg->type == NIRT_OVERLAP_SEG || r->seg->type == NIRT_ALL_SEG) {
-	nirt_print_key("ov_reg1_name", r->seg->ov_reg1_name.c_str());
-	nirt_print_key("ov_reg1_id", r->seg->ov_reg1_id);
-	nirt_print_key("ov_reg2_name", r->seg->ov_reg2_name.c_str());
-	nirt_print_key("ov_reg2_id", r->seg->ov_reg2_id);
-	nirt_print_key("ov_sol_in", r->seg->ov_sol_in.c_str());
-	nirt_print_key("ov_sol_out", r->seg->ov_sol_out.c_str());
-	nirt_print_key("ov_los", r->seg->ov_los * base2local);
-	nirt_print_key("ov_x_in", r->seg->ov_in[X] * base2local);
-	nirt_print_key("ov_y_in", r->seg->ov_in[Y] * base2local);
-	nirt_print_key("ov_z_in", r->seg->ov_in[Z] * base2local);
-	nirt_print_key("ov_d_in", r->seg->ov_d_in * base2local);
-	nirt_print_key("ov_x_out", r->seg->ov_out[X] * base2local);
-	nirt_print_key("ov_y_out", r->seg->ov_out[Y] * base2local);
-	nirt_print_key("ov_z_out", r->seg->ov_out[Z] * base2local);
-	nirt_print_key("ov_d_out", r->seg->ov_d_out * base2local);
-    }
-
-    if (r->seg->type == NIRT_GAP_SEG || r->seg->type == NIRT_ALL_SEG) {
-	nirt_print_key("x_in", r->seg->in[X] * base2local);
-	nirt_print_key("y_in", r->seg->in[Y] * base2local);
-	nirt_print_key("z_in", r->seg->in[Z] * base2local);
-
-	nirt_print_key("x_gap_in", r->seg->gap_in[X] * base2local);
-	nirt_print_key("y_gap_in", r->seg->gap_in[Y] * base2local);
-	nirt_print_key("z_gap_in", r->seg->gap_in[Z] * base2local);
-	nirt_print_key("gap_los", r->seg->gap_los * base2local);
-    }
-
     /* TODO - the fmt command should ideally do checking on format definition
      * to preclude the possibility of needing these error checks... */
     switch (r->seg->type) {
@@ -1054,23 +1172,23 @@ _nirt_report(struct nirt_state *nss, char type, struct nirt_output_record *r)
  * Raytracing Callbacks *
  ************************/
 
-static struct nirt_overlap *
-_nirt_find_ovlp(struct nirt_state *nss, struct partition *pp)
+struct nirt_overlap *
+_nirt_find_ovlp(struct nirt_output_record *r, struct partition *pp)
 {
     struct nirt_overlap *op;
 
-    for (op = nss->i->vals->ovlp_list.forw; op != &(nss->i->vals->ovlp_list); op = op->forw) {
+    for (op = r->ovlp_list.forw; op != &(r->ovlp_list); op = op->forw) {
 	if (((pp->pt_inhit->hit_dist <= op->in_dist)
 		    && (op->in_dist <= pp->pt_outhit->hit_dist)) ||
 		((pp->pt_inhit->hit_dist <= op->out_dist)
 		 && (op->in_dist <= pp->pt_outhit->hit_dist)))
 	    break;
     }
-    return (op == &(nss->i->vals->ovlp_list)) ? NIRT_OVERLAP_NULL : op;
+    return (op == &(r->ovlp_list)) ? NIRT_OVERLAP_NULL : op;
 }
 
 
-static void
+void
 _nirt_del_ovlp(struct nirt_overlap *op)
 {
     op->forw->backw = op->backw;
@@ -1078,6 +1196,39 @@ _nirt_del_ovlp(struct nirt_overlap *op)
     bu_free((char *)op, "free op in del_ovlp");
 }
 
+
+/* Record an overlap reported by librt, for the hit callback to report
+ * alongside the partition it falls in */
+void
+_nirt_add_ovlp(struct nirt_output_record *r, struct application *ap, struct partition *pp, struct region *reg1, struct region *reg2)
+{
+    struct nirt_overlap *o;
+    BU_ALLOC(o, struct nirt_overlap);
+    o->ap = ap;
+    o->pp = pp;
+    o->reg1 = reg1;
+    o->reg2 = reg2;
+    o->in_dist = pp->pt_inhit->hit_dist;
+    o->out_dist = pp->pt_outhit->hit_dist;
+    VJOIN1(o->in_point, ap->a_ray.r_pt, pp->pt_inhit->hit_dist, ap->a_ray.r_dir);
+    VJOIN1(o->out_point, ap->a_ray.r_pt, pp->pt_outhit->hit_dist, ap->a_ray.r_dir);
+
+    /* Insert the new overlap into the list of overlaps */
+    o->forw = r->ovlp_list.forw;
+    o->backw = &(r->ovlp_list);
+    o->forw->backw = o;
+    r->ovlp_list.forw = o;
+}
+
+
+void
+_nirt_free_ovlps(struct nirt_output_record *r)
+{
+    while (r->ovlp_list.forw != &(r->ovlp_list))
+	_nirt_del_ovlp(r->ovlp_list.forw);
+}
+
+
 void
 _nirt_init_ovlp(struct nirt_state *nss)
 {
@@ -1085,6 +1236,103 @@ _nirt_init_ovlp(struct nirt_state *nss)
 }
 
 
+static std::string
+_nirt_basename(const char *path)
+{
+    char *b = bu_path_basename(path, NULL);
+    std::string ret(b);
+    bu_free(b, "basename");
+    return ret;
+}
+
+
+/* Fill in the partition values of s from part.  Gap values depend on the
+ * previous partition and are left to the caller. */
+void
+_nirt_seg_part(nirt_seg *s, const struct nirt_output_record *r, struct application *ap, struct partition *part, const std::set<std::string> &attrs)
+{
+    RT_HIT_NORMAL(s->nm_in, part->pt_inhit, part->pt_inseg->seg_stp,
+	    &ap->a_ray, part->pt_inflip);
+    RT_HIT_NORMAL(s->nm_out, part->pt_outhit, part->pt_outseg->seg_stp,
+	    &ap->a_ray, part->pt_outflip);
+    VMOVE(s->in, part->pt_inhit->hit_point);
+    VMOVE(s->out, part->pt_outhit->hit_point);
+
+    s->d_in = _nirt_calc_d(r, s->in);
+    s->d_out = _nirt_calc_d(r, s->out);
+    s->nm_d_in = _nirt_calc_d(r, s->nm_in);
+    s->nm_h_in = _nirt_calc_h(r, s->nm_in);
+    s->nm_v_in = _nirt_calc_v(r, s->nm_in);
+
+    s->nm_d_out = _nirt_calc_d(r, s->nm_out);
+    s->nm_h_out = _nirt_calc_h(r, s->nm_out);
+    s->nm_v_out = _nirt_calc_v(r, s->nm_out);
+
+    s->los = s->d_in - s->d_out;
+    s->scaled_los = 0.01 * s->los * part->pt_regionp->reg_los;
+
+    s->path_name = std::string(part->pt_regionp->reg_name);
+    s->reg_name = _nirt_basename(part->pt_regionp->reg_name);
+    s->reg_id = part->pt_regionp->reg_regionid;
+    s->surf_num_in = part->pt_inhit->hit_surfno;
+    s->surf_num_out = part->pt_outhit->hit_surfno;
+    s->obliq_in = nirt_get_obliq(ap->a_ray.r_dir, s->nm_in);
+    s->obliq_out = nirt_get_obliq(ap->a_ray.r_dir, s->nm_out);
+
+    s->claimant_list = std::string();
+    s->claimant_listn = std::string();
+    if (part->pt_overlap_reg == 0) {
+	s->claimant_count = 1;
+    } else {
+	struct region **rpp;
+	s->claimant_count = 0;
+	for (rpp = part->pt_overlap_reg; *rpp != REGION_NULL; ++rpp) {
+	    if (s->claimant_count) {
+		s->claimant_list.push_back(' ');
+	    }
+	    s->claimant_count++;
+	    s->claimant_list.append(_nirt_basename((*rpp)->reg_name));
+	}
+
+	/* insert newlines instead of spaces for listn */
+	s->claimant_listn = s->claimant_list;
+	std::replace(s->claimant_listn.begin(), s->claimant_listn.end(), ' ', '\n');
+    }
+
+    s->attributes = std::string();
+    std::set<std::string>::const_iterator a_it;
+    for (a_it = attrs.begin(); a_it != attrs.end(); a_it++) {
+	const char *key = (*a_it).c_str();
+	const char *val = bu_avs_get(&part->pt_regionp->attr_values, key);
+	if (val != NULL) {
+	    s->attributes.append(key);
+	    s->attributes.append("=");
+	    s->attributes.append(val);
+	    s->attributes.append(" ");
+	}
+    }
+}
+
+
+/* Fill in the overlap values of s from ovp, which lies in part */
+void
+_nirt_seg_ovlp(nirt_seg *s, const struct nirt_output_record *r, struct partition *part, const struct nirt_overlap *ovp)
+{
+    s->ov_reg1_name = _nirt_basename(ovp->reg1->reg_name);
+    s->ov_reg2_name = _nirt_basename(ovp->reg2->reg_name);
+    s->ov_reg1_id = ovp->reg1->reg_regionid;
+    s->ov_reg2_id = ovp->reg2->reg_regionid;
+    s->ov_sol_in = std::string(part->pt_inseg->seg_stp->st_dp->d_namep);
+    s->ov_sol_out = std::string(part->pt_outseg->seg_stp->st_dp->d_namep);
+    VMOVE(s->ov_in, ovp->in_point);
+    VMOVE(s->ov_out, ovp->out_point);
+
+    s->ov_d_in = r->d_orig - ovp->in_dist; // TODO looks sketchy in NIRT - did they really mean target(D) ?? -> (VTI_XORIG + 3 -> VTI_H)
+    s->ov_d_out = r->d_orig - ovp->out_dist; // TODO looks sketchy in NIRT - did they really mean target(D) ?? -> (VTI_XORIG + 3 -> VTI_H)
+    s->ov_los = s->ov_d_in - s->ov_d_out;
+}
+
+
 extern "C" int
 _nirt_if_hit(struct application *ap, struct partition *part_head, struct seg *UNUSED(finished_segs))
 {
@@ -1119,30 +1367,12 @@ _nirt_if_hit(struct application *ap, struct partition *part_head, struct seg *UN
 	++part_nm;
 
 	/* Update the output values */
-	RT_HIT_NORMAL(s->nm_in, part->pt_inhit, part->pt_inseg->seg_stp,
-		&ap->a_ray, part->pt_inflip);
-	RT_HIT_NORMAL(s->nm_out, part->pt_outhit, part->pt_outseg->seg_stp,
-		&ap->a_ray, part->pt_outflip);
-	VMOVE(s->in, part->pt_inhit->hit_point);
-	VMOVE(s->out, part->pt_outhit->hit_point);
+	_nirt_seg_part(s, vals, ap, part, nss->i->attrs);
 	if (part_nm > 1) VMOVE(s->gap_in, out_old);
 
 	ndbg(nss, ANALYZE_DEBUG_NIRT_HITS, "Partition %d entry: (%g, %g, %g) exit: (%g, %g, %g)\n",
 		part_nm, V3ARGS(s->in), V3ARGS(s->out));
 
-	s->d_in = d_calc(nss, s->in);
-	s->d_out = d_calc(nss, s->out);
-	s->nm_d_in = d_calc(nss, s->nm_in);
-	s->nm_h_in = h_calc(nss, s->nm_in);
-	s->nm_v_in = v_calc(nss, s->nm_in);
-
-	s->nm_d_out = d_calc(nss, s->nm_out);
-	s->nm_h_out = h_calc(nss, s->nm_out);
-	s->nm_v_out = v_calc(nss, s->nm_out);
-
-	s->los = s->d_in - s->d_out;
-	s->scaled_los = 0.01 * s->los * part->pt_regionp->reg_los;
-
 	if (part_nm > 1) {
 	    /* old d_out - new d_in */
 	    s->gap_los = d_out_old - s->d_in;
@@ -1169,59 +1399,6 @@ _nirt_if_hit(struct application *ap, struct partition *part_head, struct seg *UN
 	VMOVE(out_old, s->out); // Stash the out value for gap_los calculation in the next partition
 	d_out_old = s->d_out; // Stash the d_out value for gap_los calculation in the next partition
 
-	s->path_name = std::string(part->pt_regionp->reg_name);
-	{
-	    char *tmp_regname = (char *)bu_calloc(s->path_name.size() + 1, sizeof(char), "tmp reg_name");
-	    bu_path_basename(part->pt_regionp->reg_name, tmp_regname);
-	    s->reg_name = std::string(tmp_regname);	
-	    bu_free(tmp_regname, "tmp reg_name");
-	}
-
-	s->reg_id = part->pt_regionp->reg_regionid;
-	s->surf_num_in = part->pt_inhit->hit_surfno;
-	s->surf_num_out = part->pt_outhit->hit_surfno;
-	s->obliq_in = _nirt_get_obliq(ap->a_ray.r_dir, s->nm_in);
-	s->obliq_out = _nirt_get_obliq(ap->a_ray.r_dir, s->nm_out);
-
-	s->claimant_list = std::string();
-	s->claimant_listn = std::string();
-	if (part->pt_overlap_reg == 0) {
-	    s->claimant_count = 1;
-	} else {
-	    struct region **rpp;
-	    struct bu_vls tmpcp = BU_VLS_INIT_ZERO;
-	    s->claimant_count = 0;
-	    for (rpp = part->pt_overlap_reg; *rpp != REGION_NULL; ++rpp) {
-		char *base = NULL;
-		if (s->claimant_count) {
-		    s->claimant_list.push_back(' ');
-		}
-		s->claimant_count++;
-		bu_vls_sprintf(&tmpcp, "%s", (*rpp)->reg_name);
-		base = bu_path_basename(bu_vls_cstr(&tmpcp), NULL);
-		s->claimant_list.append(base);
-		bu_free(base, "bu_path_basename");
-	    }
-	    bu_vls_free(&tmpcp);
-
-	    /* insert newlines instead of spaces for listn */
-	    s->claimant_listn = s->claimant_list;
-	    s->claimant_listn.replace(s->claimant_listn.begin(), s->claimant_listn.end(), ' ', '\n');
-	}
-
-	s->attributes = std::string();
-	std::set<std::string>::iterator a_it;
-	for (a_it = nss->i->attrs.begin(); a_it != nss->i->attrs.end(); a_it++) {
-	    const char *key = (*a_it).c_str();
-	    const char *val = bu_avs_get(&part->pt_regionp->attr_values, key);
-	    if (val != NULL) {
-		s->attributes.append(key);
-		s->attributes.append("=");
-		s->attributes.append(val);
-		s->attributes.append(" ");
-	    }
-	}
-
 	_nirt_report(nss, 'p', vals);
 
 	/* vlist segment for hit */
@@ -1237,35 +1414,11 @@ _nirt_if_hit(struct application *ap, struct partition *part_head, struct seg *UN
 	/* done with hit portion - if diff, stash */
 	_nirt_diff_add_seg(nss, s);
 
-	while ((ovp = _nirt_find_ovlp(nss, part)) != NIRT_OVERLAP_NULL) {
+	while ((ovp = _nirt_find_ovlp(vals, part)) != NIRT_OVERLAP_NULL) {
 
 	    s->type = NIRT_OVERLAP_SEG;
 
-	    // TODO - do this more cleanly
-	    char *copy_ovlp_reg1 = bu_strdup(ovp->reg1->reg_name);
-	    char *copy_ovlp_reg2 = bu_strdup(ovp->reg2->reg_name);
-	    char *t1 = (char *)bu_calloc(strlen(copy_ovlp_reg1), sizeof(char), "if_hit sval2");
-	    bu_path_basename(copy_ovlp_reg1, t1);
-	    s->ov_reg1_name = std::string(t1);
-	    bu_free(t1, "t1");
-	    bu_free(copy_ovlp_reg1, "cp1");
-	    char *t2 = (char *)bu_calloc(strlen(copy_ovlp_reg2), sizeof(char), "if_hit sval3");
-	    bu_path_basename(copy_ovlp_reg2, t2);
-	    s->ov_reg2_name = std::string(t2);
-	    bu_free(t2, "t2");
-	    bu_free(copy_ovlp_reg2, "cp2");
-
-
-	    s->ov_reg1_id = ovp->reg1->reg_regionid;
-	    s->ov_reg2_id = ovp->reg2->reg_regionid;
-	    s->ov_sol_in = std::string(part->pt_inseg->seg_stp->st_dp->d_namep);
-	    s->ov_sol_out = std::string(part->pt_outseg->seg_stp->st_dp->d_namep);
-	    VMOVE(s->ov_in, ovp->in_point);
-	    VMOVE(s->ov_out, ovp->out_point);
-
-	    s->ov_d_in = vals->d_orig - ovp->in_dist; // TODO looks sketchy in NIRT - did they really mean target(D) ?? -> (VTI_XORIG + 3 -> VTI_H)
-	    s->ov_d_out = vals->d_orig - ovp->out_dist; // TODO looks sketchy in NIRT - did they really mean target(D) ?? -> (VTI_XORIG + 3 -> VTI_H)
-	    s->ov_los = s->ov_d_in - s->ov_d_out;
+	    _nirt_seg_ovlp(s, vals, part, ovp);
 
 	    _nirt_report(nss, 'o', vals);
 
@@ -1324,22 +1477,7 @@ extern "C" int
 _nirt_if_overlap(struct application *ap, struct partition *pp, struct region *reg1, struct region *reg2, struct partition *InputHdp)
 {
     struct nirt_state *nss = (struct nirt_state *)ap->a_uptr;
-    struct nirt_overlap *o;
-    BU_ALLOC(o, struct nirt_overlap);
-    o->ap = ap;
-    o->pp = pp;
-    o->reg1 = reg1;
-    o->reg2 = reg2;
-    o->in_dist = pp->pt_inhit->hit_dist;
-    o->out_dist = pp->pt_outhit->hit_dist;
-    VJOIN1(o->in_point, ap->a_ray.r_pt, pp->pt_inhit->hit_dist, ap->a_ray.r_dir);
-    VJOIN1(o->out_point, ap->a_ray.r_pt, pp->pt_outhit->hit_dist, ap->a_ray.r_dir);
-
-    /* Insert the new overlap into the list of overlaps */
-    o->forw = nss->i->vals->ovlp_list.forw;
-    o->backw = &(nss->i->vals->ovlp_list);
-    o->forw->backw = o;
-    nss->i->vals->ovlp_list.forw = o;
+    _nirt_add_ovlp(nss->i->vals, ap, pp, reg1, reg2);
 
     /* Match current BRL-CAD default behavior */
     return rt_defoverlap (ap, pp, reg1, reg2, InputHdp);
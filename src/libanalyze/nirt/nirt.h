@@ -408,15 +408,63 @@ double _nirt_str_to_dbl(std::string s, size_t p);
 
 int _nirt_str_to_int(std::string s);
 
+bool nirt_cmd_str(struct bu_vls *nirt_cmd, struct nirt_state *nss);
+bool _nirt_cmd_str_head(struct bu_vls *nirt_cmd, struct nirt_state *nss);
+void _nirt_cmd_str_ray(struct bu_vls *nirt_cmd, const struct nirt_output_record *r);
+
+fastf_t _nirt_calc_d(const struct nirt_output_record *r, const fastf_t *p);
+fastf_t _nirt_calc_h(const struct nirt_output_record *r, const fastf_t *p);
+fastf_t _nirt_calc_v(const struct nirt_output_record *r, const fastf_t *p);
+
 void _nirt_targ2grid(struct nirt_state *nss);
+void _nirt_vals_targ2grid(struct nirt_output_record *r);
+
+fastf_t nirt_get_obliq(const fastf_t *ray, const fastf_t *normal);
 
 void _nirt_dir2ae(struct nirt_state *nss);
+void _nirt_vals_dir2ae(struct nirt_output_record *r);
+
+double _nirt_backout_dist(const struct rt_i *rtip, const fastf_t *pt, const fastf_t *dir);
 
 struct rt_i * _nirt_get_rtip(struct nirt_state *nss);
 struct resource * _nirt_get_resource(struct nirt_state *nss);
 void _nirt_init_ovlp(struct nirt_state *nss);
 int _nirt_raytrace_prep(struct nirt_state *nss);
 
+/* Shot bookkeeping shared by the interactive and batch callbacks */
+void _nirt_add_ovlp(struct nirt_output_record *r, struct application *ap, struct partition *pp, struct region *reg1, struct region *reg2);
+struct nirt_overlap *_nirt_find_ovlp(struct nirt_output_record *r, struct partition *pp);
+void _nirt_del_ovlp(struct nirt_overlap *op);
+void _nirt_free_ovlps(struct nirt_output_record *r);
+void _nirt_seg_part(nirt_seg *s, const struct nirt_output_record *r, struct application *ap, struct partition *part, const std::set<std::string> &attrs);
+void _nirt_seg_ovlp(nirt_seg *s, const struct nirt_output_record *r, struct partition *part, const struct nirt_overlap *ovp);
+
+/* Every key nirt knows how to report */
+enum nirt_key {
+    NIRT_KEY_NONE = 0, NIRT_KEY_NIRT_CMD,
+    /* ray */
+    NIRT_KEY_X_ORIG, NIRT_KEY_Y_ORIG, NIRT_KEY_Z_ORIG, NIRT_KEY_H, NIRT_KEY_V, NIRT_KEY_D_ORIG,
+    NIRT_KEY_X_DIR, NIRT_KEY_Y_DIR, NIRT_KEY_Z_DIR, NIRT_KEY_A, NIRT_KEY_E,
+    /* partition (x_in, y_in and z_in are also available to gaps) */
+    NIRT_KEY_X_IN, NIRT_KEY_Y_IN, NIRT_KEY_Z_IN, NIRT_KEY_D_IN, NIRT_KEY_X_OUT, NIRT_KEY_Y_OUT, NIRT_KEY_Z_OUT,
+    NIRT_KEY_D_OUT, NIRT_KEY_LOS, NIRT_KEY_SCALED_LOS, NIRT_KEY_PATH_NAME, NIRT_KEY_REG_NAME, NIRT_KEY_REG_ID,
+    NIRT_KEY_OBLIQ_IN, NIRT_KEY_OBLIQ_OUT, NIRT_KEY_NM_X_IN, NIRT_KEY_NM_Y_IN, NIRT_KEY_NM_Z_IN,
+    NIRT_KEY_NM_D_IN, NIRT_KEY_NM_H_IN, NIRT_KEY_NM_V_IN, NIRT_KEY_NM_X_OUT, NIRT_KEY_NM_Y_OUT,
+    NIRT_KEY_NM_Z_OUT, NIRT_KEY_NM_D_OUT, NIRT_KEY_NM_H_OUT, NIRT_KEY_NM_V_OUT, NIRT_KEY_SURF_NUM_IN,
+    NIRT_KEY_SURF_NUM_OUT, NIRT_KEY_CLAIMANT_COUNT, NIRT_KEY_CLAIMANT_LIST,
+    NIRT_KEY_CLAIMANT_LISTN, NIRT_KEY_ATTRIBUTES,
+    /* overlap */
+    NIRT_KEY_OV_REG1_NAME, NIRT_KEY_OV_REG1_ID, NIRT_KEY_OV_REG2_NAME, NIRT_KEY_OV_REG2_ID,
+    NIRT_KEY_OV_SOL_IN, NIRT_KEY_OV_SOL_OUT, NIRT_KEY_OV_LOS, NIRT_KEY_OV_X_IN, NIRT_KEY_OV_Y_IN,
+    NIRT_KEY_OV_Z_IN, NIRT_KEY_OV_D_IN, NIRT_KEY_OV_X_OUT, NIRT_KEY_OV_Y_OUT, NIRT_KEY_OV_Z_OUT,
+    NIRT_KEY_OV_D_OUT,
+    /* gap */
+    NIRT_KEY_X_GAP_IN, NIRT_KEY_Y_GAP_IN, NIRT_KEY_Z_GAP_IN, NIRT_KEY_GAP_LOS
+};
+
+int _nirt_key_id(const char *key);
+int _nirt_print_key(struct bu_vls *o, const char *fmt, int key, const struct nirt_output_record *r, fastf_t base2local, const char *nirt_cmd);
+
 
 void _nirt_diff_create(struct nirt_state *nss);
 void _nirt_diff_destroy(struct nirt_state *nss);
@@ -0,0 +1,227 @@
+/*                   N I R T _ B A T C H . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file nirt_batch.cpp
+ *
+ * nirt_batch must produce exactly the output the interactive commands
+ * do when the same rays are shot one at a time with "dir", "xyz" and
+ * "s".  The test geometry has overlapping regions, a gap and a miss,
+ * and the formats cover every report type, including nirt_cmd.
+ */
+
+#include "common.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "bu/app.h"
+#include "bu/file.h"
+#include "bu/vls.h"
+#include "raytrace.h"
+#include "wdb.h"
+#include "analyze.h"
+
+#define NIRT_BATCH_TEST_FILE "nirt_batch_test.g"
+
+static const char *fmts[] = {
+    "fmt r \"%s\\n%.9f %.9f %.9f %.9f %.9f %.9f %.9f %.9f %.9f %.9f %.9f\\n\" nirt_cmd x_orig y_orig z_orig h v d_orig x_dir y_dir z_dir a e",
+    "fmt h \"head\\n\"",
+    "fmt p \"%s %s %d %.9f %.9f %.9f %.9f %.9f %.9f %.9f %.9f %.9f %.9f %.9f %.9f %d %d %s|%s\\n\" path_name reg_name reg_id x_in d_in x_out d_out los scaled_los obliq_in obliq_out nm_x_in nm_d_in nm_h_in nm_v_in surf_num_in claimant_count claimant_list attributes",
+    "fmt o \"%s %d %s %d %s %s %.9f %.9f %.9f %.9f\\n\" ov_reg1_name ov_reg1_id ov_reg2_name ov_reg2_id ov_sol_in ov_sol_out ov_los ov_x_in ov_d_in ov_d_out",
+    "fmt g \"%.9f %.9f %.9f\\n\" x_gap_in x_in gap_los",
+    "fmt f \"foot\\n\"",
+    "fmt m \"miss %.9f %.9f\\n\" h v",
+    NULL
+};
+
+/* target point and direction */
+static const double rays[][6] = {
+    {20, 5, 5, -1, 0, 0},
+    {20, 2, 8, -1, 0, 0},
+    {10, 5, 5, -1, -0.2, -0.1},
+    {7, 5, 5, 0, 0, -1},
+    {30, 5, 5, 1, 0.05, 0},
+    {0, 50, 50, -1, 0, 0}
+};
+#define NRAYS (sizeof(rays) / sizeof(rays[0]))
+
+static int
+out_hook(struct nirt_state *ns, void *u_data)
+{
+    struct bu_vls *out = (struct bu_vls *)u_data;
+    struct bu_vls tmp = BU_VLS_INIT_ZERO;
+    nirt_log(&tmp, ns, NIRT_OUT);
+    bu_vls_printf(out, "%s", bu_vls_cstr(&tmp));
+    bu_vls_free(&tmp);
+    return 0;
+}
+
+static void
+make_geometry(const char *file)
+{
+    struct rt_wdb *wdbp = wdb_fopen(file);
+    struct wmember head;
+    point_t min, max, center;
+
+    if (!wdbp)
+	bu_exit(1, "ERROR: unable to create %s\n", file);
+
+    /* two boxes overlapping over 5 <= x <= 10 ... */
+    VSET(min, 0, 0, 0);
+    VSET(max, 10, 10, 10);
+    mk_rpp(wdbp, "box1.s", min, max);
+    VSET(min, 5, 0, 0);
+    VSET(max, 15, 10, 10);
+    mk_rpp(wdbp, "box2.s", min, max);
+    /* ... and a sphere past a gap */
+    VSET(center, 30, 5, 5);
+    mk_sph(wdbp, "sph.s", center, 4);
+
+    const char *solids[] = {"box1.s", "box2.s", "sph.s"};
+    const char *regions[] = {"box1.r", "box2.r", "sph.r"};
+    BU_LIST_INIT(&head.l);
+    for (int i = 0; i < 3; i++) {
+	struct wmember rhead;
+	BU_LIST_INIT(&rhead.l);
+	(void)mk_addmember(solids[i], &rhead.l, NULL, WMOP_UNION);
+	mk_comb(wdbp, regions[i], &rhead.l, 1, NULL, NULL, NULL, i + 1, 0, 0, 100, 0, 0, 0);
+	(void)mk_addmember(regions[i], &head.l, NULL, WMOP_UNION);
+    }
+    mk_lcomb(wdbp, "all.g", &head, 0, NULL, NULL, NULL, 0);
+    db5_update_attribute("sph.r", "material_id", "7", wdbp->dbip);
+
+    wdb_close(wdbp);
+}
+
+static int
+batch_output(std::string &out, struct nirt_state *ns, int ncpu)
+{
+    FILE *ifp = tmpfile();
+    FILE *ofp = tmpfile();
+    if (!ifp || !ofp)
+	bu_exit(1, "ERROR: unable to create temporary files\n");
+
+    for (size_t i = 0; i < NRAYS; i++)
+	fprintf(ifp, "%.17g %.17g %.17g %.17g %.17g %.17g\n", rays[i][0], rays[i][1], rays[i][2], rays[i][3], rays[i][4], rays[i][5]);
+    rewind(ifp);
+
+    long n = nirt_batch(ns, ifp, 0, ofp, ncpu);
+
+    out.clear();
+    rewind(ofp);
+    char buf[4096];
+    size_t len;
+    while ((len = fread(buf, 1, sizeof(buf), ofp)) > 0)
+	out.append(buf, len);
+
+    fclose(ifp);
+    fclose(ofp);
+
+    if (n != (long)NRAYS) {
+	bu_log("nirt_batch (%d threads) shot %ld rays, expected %zu\n", ncpu, n, NRAYS);
+	return 1;
+    }
+    return 0;
+}
+
+int
+main(int argc, const char **argv)
+{
+    struct nirt_state *ns;
+    struct db_i *dbip;
+    struct bu_vls out = BU_VLS_INIT_ZERO;
+    struct bu_vls ncmd = BU_VLS_INIT_ZERO;
+    std::string batch;
+    int ret = 0;
+
+    bu_setprogname(argv[0]);
+
+    if (argc != 1)
+	bu_exit(1, "Usage: %s\n", argv[0]);
+
+    make_geometry(NIRT_BATCH_TEST_FILE);
+
+    dbip = db_open(NIRT_BATCH_TEST_FILE, DB_OPEN_READONLY);
+    if (dbip == DBI_NULL || db_dirbuild(dbip) < 0)
+	bu_exit(1, "ERROR: unable to read %s\n", NIRT_BATCH_TEST_FILE);
+
+    BU_GET(ns, struct nirt_state);
+    if (nirt_init(ns) == -1 || nirt_init_dbip(ns, dbip) == -1)
+	bu_exit(1, "ERROR: nirt initialization failed\n");
+    db_close(dbip);
+
+    (void)nirt_udata(ns, (void *)&out);
+    nirt_hook(ns, &out_hook, NIRT_OUT);
+
+    if (nirt_exec(ns, "attr material_id") < 0 || nirt_exec(ns, "draw all.g") < 0)
+	bu_exit(1, "ERROR: unable to set up the nirt state\n");
+    for (int i = 0; fmts[i]; i++) {
+	if (nirt_exec(ns, fmts[i]) < 0)
+	    bu_exit(1, "ERROR: %s failed\n", fmts[i]);
+    }
+
+    /* The reference: each ray shot interactively */
+    bu_vls_trunc(&out, 0);
+    for (size_t i = 0; i < NRAYS; i++) {
+	bu_vls_sprintf(&ncmd, "dir %.17g %.17g %.17g; xyz %.17g %.17g %.17g; s", rays[i][3], rays[i][4], rays[i][5], rays[i][0], rays[i][1], rays[i][2]);
+	if (nirt_exec(ns, bu_vls_cstr(&ncmd)) < 0)
+	    bu_exit(1, "ERROR: %s failed\n", bu_vls_cstr(&ncmd));
+    }
+    std::string interactive(bu_vls_cstr(&out));
+    bu_vls_trunc(&out, 0);
+
+    /* Make sure the rays exercise what they're meant to */
+    if (interactive.find("box1.r 1 box2.r 2") == std::string::npos && interactive.find("box2.r 2 box1.r 1") == std::string::npos) {
+	bu_log("interactive shots reported no overlaps:\n%s\n", interactive.c_str());
+	ret = 1;
+    }
+    if (interactive.find("miss ") == std::string::npos || interactive.find("material_id=7") == std::string::npos) {
+	bu_log("interactive shots reported no miss or attributes:\n%s\n", interactive.c_str());
+	ret = 1;
+    }
+
+    /* Serial and threaded batches must both match it */
+    int ncpus[] = {1, 4};
+    for (int i = 0; i < 2; i++) {
+	ret += batch_output(batch, ns, ncpus[i]);
+	if (batch != interactive) {
+	    bu_log("nirt_batch (%d threads) output differs from the interactive output\n", ncpus[i]);
+	    bu_log("interactive:\n%s\nbatch:\n%s\n", interactive.c_str(), batch.c_str());
+	    ret++;
+	}
+    }
+
+    nirt_destroy(ns);
+    BU_PUT(ns, struct nirt_state);
+    bu_vls_free(&out);
+    bu_vls_free(&ncmd);
+    bu_file_delete(NIRT_BATCH_TEST_FILE);
+
+    return (ret) ? 1 : 0;
+}
+
+// Local Variables:
+// tab-width: 8
+// mode: C++
+// c-basic-offset: 4
+// indent-tabs-mode: t
+// c-file-style: "stroustrup"
+// End:
+// ex: shiftwidth=4 tabstop=8
@@ -26,6 +26,13 @@
  * The use case that motivated trying it is simplifying nasty plate mode BoTs
  * ahead of extrusion.
  *
+ * Large meshes (scans in particular) are decimated in parallel.  The active
+ * points are split into slabs along the longest axis of the mesh, with slab
+ * boundaries chosen from a histogram so each holds about the same number of
+ * points, and each slab is clustered independently.  Slab boundaries always
+ * fall between snapping cells, so no cluster is ever split between two slabs
+ * and there is nothing to lock or stitch along the seams - the result does not
+ * depend on the number of threads used.
  */
 
 #include "common.h"
@@ -33,16 +40,211 @@
 #include <inttypes.h>
 
 #include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <cstring>
-#include <unordered_map>
-#include <unordered_set>
+#include <limits>
 #include <vector>
 
 #include "bu/malloc.h"
 #include "bu/log.h"
+#include "bu/parallel.h"
 #include "bn/tol.h"
 #include "bg/trimesh.h"
 
+#define DEC_CHUNK 65536
+#define DEC_HIST_BINS 4096
+#define DEC_MAX_PARTS 256
+
+/* Snapped cell coordinates of a point, ordered so that the points of a
+ * cell are adjacent and in index order */
+struct dec_key {
+    int64_t c[3];
+    int idx;
+    bool operator<(const dec_key &o) const {
+	if (c[0] != o.c[0])
+	    return c[0] < o.c[0];
+	if (c[1] != o.c[1])
+	    return c[1] < o.c[1];
+	if (c[2] != o.c[2])
+	    return c[2] < o.c[2];
+	return idx < o.idx;
+    }
+};
+
+struct dec_data {
+    const int *faces;
+    int nfaces;
+    const point_t *p;
+    double scale;
+    int axis;
+    int64_t cmin;
+    double cspan;
+    std::vector<int> act;		/* active points, ascending */
+    std::vector<uint16_t> bins;		/* histogram bin of each active point */
+    size_t nchunks;
+    size_t nparts;
+    std::vector<size_t> hist;		/* nchunks x DEC_HIST_BINS */
+    std::vector<size_t> bin_part;	/* DEC_HIST_BINS */
+    std::vector<size_t> counts;		/* nchunks x nparts */
+    std::vector<size_t> offsets;	/* nchunks x nparts */
+    std::vector<size_t> part_start;	/* nparts + 1 */
+    std::vector<int> order;
+    std::vector<int> old_to_new;
+    std::vector<size_t> merged;		/* per part */
+    std::vector<size_t> targets;	/* per part */
+    size_t nfchunks;
+    std::vector<std::vector<int>> kept;	/* per face chunk */
+    std::atomic<size_t> next;
+};
+
+static inline int64_t
+dec_coord(fastf_t v, double scale)
+{
+    return static_cast<int64_t>(std::round(v * scale));
+}
+
+static void
+dec_hist_worker(int UNUSED(cpu), void *data)
+{
+    struct dec_data *d = (struct dec_data *)data;
+    size_t c;
+    while ((c = d->next.fetch_add(1)) < d->nchunks) {
+	size_t start = c * DEC_CHUNK;
+	size_t end = std::min(start + DEC_CHUNK, d->act.size());
+	size_t *h = &d->hist[c * DEC_HIST_BINS];
+	for (size_t i = start; i < end; i++) {
+	    double f = (double)(dec_coord(d->p[d->act[i]][d->axis], d->scale) - d->cmin) / d->cspan;
+	    size_t b = (f > 0) ? (size_t)(f * DEC_HIST_BINS) : 0;
+	    if (b >= DEC_HIST_BINS)
+		b = DEC_HIST_BINS - 1;
+	    d->bins[i] = (uint16_t)b;
+	    h[b]++;
+	}
+    }
+}
+
+static void
+dec_count_worker(int UNUSED(cpu), void *data)
+{
+    struct dec_data *d = (struct dec_data *)data;
+    size_t c;
+    while ((c = d->next.fetch_add(1)) < d->nchunks) {
+	size_t start = c * DEC_CHUNK;
+	size_t end = std::min(start + DEC_CHUNK, d->act.size());
+	size_t *cnt = &d->counts[c * d->nparts];
+	for (size_t i = start; i < end; i++)
+	    cnt[d->bin_part[d->bins[i]]]++;
+    }
+}
+
+static void
+dec_scatter_worker(int UNUSED(cpu), void *data)
+{
+    struct dec_data *d = (struct dec_data *)data;
+    size_t c;
+    while ((c = d->next.fetch_add(1)) < d->nchunks) {
+	size_t start = c * DEC_CHUNK;
+	size_t end = std::min(start + DEC_CHUNK, d->act.size());
+	size_t *off = &d->offsets[c * d->nparts];
+	for (size_t i = start; i < end; i++)
+	    d->order[off[d->bin_part[d->bins[i]]]++] = d->act[i];
+    }
+}
+
+static void
+dec_part_worker(int UNUSED(cpu), void *data)
+{
+    struct dec_data *d = (struct dec_data *)data;
+    std::vector<dec_key> keys;
+    size_t part;
+    while ((part = d->next.fetch_add(1)) < d->nparts) {
+	keys.clear();
+	for (size_t j = d->part_start[part]; j < d->part_start[part+1]; j++) {
+	    dec_key k;
+	    k.idx = d->order[j];
+	    for (int i = 0; i < 3; i++)
+		k.c[i] = dec_coord(d->p[k.idx][i], d->scale);
+	    keys.push_back(k);
+	}
+	std::sort(keys.begin(), keys.end());
+
+	size_t g0 = 0;
+	while (g0 < keys.size()) {
+	    size_t g1 = g0 + 1;
+	    while (g1 < keys.size() && !memcmp(keys[g1].c, keys[g0].c, sizeof(keys[g0].c)))
+		g1++;
+
+	    if (g1 - g0 == 1) {
+		d->old_to_new[keys[g0].idx] = keys[g0].idx;
+		g0 = g1;
+		continue;
+	    }
+
+	    // Multiple points - find the average value.
+	    point_t vavg = VINIT_ZERO;
+	    for (size_t j = g0; j < g1; j++)
+		VADD2(vavg, vavg, d->p[keys[j].idx]);
+	    VSCALE(vavg, vavg, 1.0/(double)(g1 - g0));
+
+	    // Find the actual point closest to the average.  Points are
+	    // visited in index order, so ties go to the lowest index.
+	    int cavg = keys[g0].idx;
+	    double dsqd = DIST_PNT_PNT_SQ(vavg, d->p[cavg]);
+	    for (size_t j = g0 + 1; j < g1; j++) {
+		double ndsqd = DIST_PNT_PNT_SQ(vavg, d->p[keys[j].idx]);
+		if (ndsqd < dsqd) {
+		    dsqd = ndsqd;
+		    cavg = keys[j].idx;
+		}
+	    }
+
+	    // Point all the points in the cell to the closest average point
+	    for (size_t j = g0; j < g1; j++)
+		d->old_to_new[keys[j].idx] = cavg;
+	    d->merged[part] += g1 - g0 - 1;
+	    d->targets[part]++;
+	    g0 = g1;
+	}
+    }
+}
+
+static void
+dec_face_worker(int UNUSED(cpu), void *data)
+{
+    struct dec_data *d = (struct dec_data *)data;
+    size_t c;
+    while ((c = d->next.fetch_add(1)) < d->nfchunks) {
+	size_t start = c * DEC_CHUNK;
+	size_t end = std::min(start + DEC_CHUNK, (size_t)d->nfaces);
+	std::vector<int> &nf = d->kept[c];
+	for (size_t i = start; i < end; i++) {
+	    int f_ind[3];
+	    f_ind[0] = d->old_to_new[d->faces[3*i+0]];
+	    f_ind[1] = d->old_to_new[d->faces[3*i+1]];
+	    f_ind[2] = d->old_to_new[d->faces[3*i+2]];
+
+	    // Skip faces made degenerate by the snapping
+	    if (f_ind[0] == f_ind[1] || f_ind[0] == f_ind[2] || f_ind[1] == f_ind[2])
+		continue;
+
+	    nf.push_back(f_ind[0]);
+	    nf.push_back(f_ind[1]);
+	    nf.push_back(f_ind[2]);
+	}
+    }
+}
+
+static void
+dec_run(void (*func)(int, void *), size_t threads, struct dec_data *d)
+{
+    d->next = 0;
+    if (threads > 1)
+	bu_parallel(func, threads, (void *)d);
+    else
+	(*func)(0, (void *)d);
+}
+
 int trimesh_decimate_simple(
 	int **ofaces, int *n_ofaces,
 	int *ifaces, int n_ifaces, point_t *p, int n_p, struct bg_trimesh_decimation_settings *s)
@@ -53,18 +255,37 @@ int trimesh_decimate_simple(
     if (s->method != BG_TRIMESH_DECIMATION_METHOD_DEFAULT)
 	return BRLCAD_ERROR;
 
+    size_t avail = bu_avail_cpus();
+    size_t threads = (!s->max_threads || s->max_threads > avail) ? avail : s->max_threads;
+    if (threads > MAX_PSW)
+	threads = MAX_PSW;
+    if (threads < 1)
+	threads = 1;
+
+    struct dec_data d;
+    d.faces = ifaces;
+    d.nfaces = n_ifaces;
+    d.p = p;
+
     // Find the active points in the mesh - don't assume all points in p are active
-    std::unordered_set<int> active_pnts;
-    for (int i = 0; i < n_ifaces*3; i++)
-	active_pnts.insert(ifaces[i]);
+    std::vector<char> used(n_p, 0);
+    for (int i = 0; i < n_ifaces*3; i++) {
+	if (ifaces[i] < 0 || ifaces[i] >= n_p)
+	    return BRLCAD_ERROR;
+	used[ifaces[i]] = 1;
+    }
+    for (int i = 0; i < n_p; i++) {
+	if (used[i])
+	    d.act.push_back(i);
+    }
+    std::vector<char>().swap(used);
 
     // Bound the active points
     point_t bbmin, bbmax;
     VSETALL(bbmin, INFINITY);
     VSETALL(bbmax, -INFINITY);
-    std::unordered_set<int>::iterator p_it;
-    for (p_it = active_pnts.begin(); p_it != active_pnts.end(); p_it++) {
-	VMINMAX(bbmin, bbmax, p[*p_it]);
+    for (size_t i = 0; i < d.act.size(); i++) {
+	VMINMAX(bbmin, bbmax, p[d.act[i]]);
     }
     // Find the largest numerical value
     double maxval = fabs(bbmin[0]);
@@ -95,100 +316,102 @@ int trimesh_decimate_simple(
 	return BRLCAD_ERROR;
     }
 
-    // We will be binning the points into a series of nested unordered sets
-    // based on snapping the x,y,z coordinates to integers.
-    std::unordered_map<int, int64_t> xint;
-    std::unordered_map<int, int64_t> yint;
-    std::unordered_map<int, int64_t> zint;
-    std::unordered_map<int64_t, std::unordered_map<int64_t, std::unordered_map<int64_t, std::unordered_set<int>>>> pbins;
-    // First, snap point values
-    for (p_it = active_pnts.begin(); p_it != active_pnts.end(); p_it++) {
-	xint[*p_it] = static_cast<int64_t>(std::round(p[*p_it][X] * scale));
-	yint[*p_it] = static_cast<int64_t>(std::round(p[*p_it][Y] * scale));
-	zint[*p_it] = static_cast<int64_t>(std::round(p[*p_it][Z] * scale));
-	//bu_log("%d: %ld %ld %ld\n", *p_it, xint[*p_it], yint[*p_it], zint[*p_it]);
+    // Split along the longest axis of the active points
+    d.scale = scale;
+    d.axis = X;
+    for (int i = Y; i <= Z; i++) {
+	if (bbmax[i] - bbmin[i] > bbmax[d.axis] - bbmin[d.axis])
+	    d.axis = i;
     }
-    // Second, assign point indices
-    for (p_it = active_pnts.begin(); p_it != active_pnts.end(); p_it++) {
-	pbins[xint[*p_it]][yint[*p_it]][zint[*p_it]].insert(*p_it);
+    d.cmin = dec_coord(bbmin[d.axis], scale);
+    d.cspan = (double)(dec_coord(bbmax[d.axis], scale) - d.cmin) + 1.0;
+
+    size_t nact = d.act.size();
+    d.nchunks = (nact + DEC_CHUNK - 1) / DEC_CHUNK;
+    d.nparts = (threads > 1) ? std::min((size_t)DEC_MAX_PARTS, threads * 4) : 1;
+    d.nparts = std::max((size_t)1, std::min(d.nparts, nact / DEC_CHUNK + 1));
+    size_t pthreads = std::min(threads, d.nchunks);
+
+    // Histogram the points along the split axis and cut it into parts of
+    // roughly equal point counts.  Parts are runs of histogram bins, and
+    // bins are runs of snapping cells, so a cell never spans two parts.
+    d.bins.resize(nact);
+    d.hist.assign(d.nchunks * DEC_HIST_BINS, 0);
+    dec_run(dec_hist_worker, pthreads, &d);
+
+    d.bin_part.resize(DEC_HIST_BINS);
+    size_t cum = 0;
+    size_t part = 0;
+    for (size_t b = 0; b < DEC_HIST_BINS; b++) {
+	d.bin_part[b] = part;
+	for (size_t c = 0; c < d.nchunks; c++)
+	    cum += d.hist[c * DEC_HIST_BINS + b];
+	if (part + 1 < d.nparts && cum >= (part + 1) * nact / d.nparts)
+	    part++;
     }
+    std::vector<size_t>().swap(d.hist);
 
-    // For each of the bins with more than one point, find the point closest to the average and use that as our
-    // target output point for the bin.
-    size_t old_merged = 0;
-    size_t mtgt_cnt = 0;
-    std::unordered_map<int, int> old_to_new;
-    std::unordered_map<int64_t, std::unordered_map<int64_t, std::unordered_map<int64_t, std::unordered_set<int>>>>::iterator px_it;
-    for (px_it = pbins.begin(); px_it != pbins.end(); ++px_it) {
-	std::unordered_map<int64_t, std::unordered_map<int64_t, std::unordered_set<int>>>::iterator  py_it;
-	for (py_it = px_it->second.begin(); py_it != px_it->second.end(); ++py_it) {
-	    std::unordered_map<int64_t, std::unordered_set<int>>::iterator  pz_it;
-	    for (pz_it = py_it->second.begin(); pz_it != py_it->second.end(); ++pz_it) {
-		std::unordered_set<int> &cbin = pz_it->second;
-		if (cbin.size() == 1)
-		    old_to_new[*cbin.begin()] = *cbin.begin();
-		if (cbin.size() > 1) {
-		    old_merged += cbin.size() - 1;
-		    mtgt_cnt++;
-		    // Multiple points - find the average value.
-		    point_t vavg = VINIT_ZERO;
-		    std::unordered_set<int>::iterator b_it;
-		    for (b_it = cbin.begin(); b_it != cbin.end(); ++b_it) {
-			VADD2(vavg, vavg, p[*b_it]);
-		    }
-		    VSCALE(vavg, vavg, 1/cbin.size());
-		    // Find the actual point closest to the average
-		    int cavg = *cbin.begin();
-		    double dsqd = DIST_PNT_PNT_SQ(vavg, p[*cbin.begin()]);
-		    for (b_it = cbin.begin(); b_it != cbin.end(); ++b_it) {
-			double ndsqd = DIST_PNT_PNT_SQ(vavg, p[*b_it]);
-			if (ndsqd < dsqd) {
-			    dsqd = ndsqd;
-			    cavg = *b_it;
-			}
-		    }
-		    // Point all the points in the bin to the closest average point
-		    for (b_it = cbin.begin(); b_it != cbin.end(); ++b_it) {
-			old_to_new[*b_it] = cavg;
-		    }
-		}
-	    }
+    // Gather each part's points, keeping them in index order
+    d.counts.assign(d.nchunks * d.nparts, 0);
+    dec_run(dec_count_worker, pthreads, &d);
+
+    d.offsets.resize(d.nchunks * d.nparts);
+    d.part_start.resize(d.nparts + 1);
+    size_t pos = 0;
+    for (size_t pt = 0; pt < d.nparts; pt++) {
+	d.part_start[pt] = pos;
+	for (size_t c = 0; c < d.nchunks; c++) {
+	    d.offsets[c * d.nparts + pt] = pos;
+	    pos += d.counts[c * d.nparts + pt];
 	}
     }
+    d.part_start[d.nparts] = pos;
 
-    // Iterate over faces, assigning any that are not degenerate with the new mapping to a new face array.
-    std::vector<int> nfaces;
-    for (int i = 0; i < n_ifaces; i++) {
-	int f_ind[3];
-	f_ind[0] = old_to_new[ifaces[3*i+0]];
-	f_ind[1] = old_to_new[ifaces[3*i+1]];
-	f_ind[2] = old_to_new[ifaces[3*i+2]];
+    d.order.resize(nact);
+    dec_run(dec_scatter_worker, pthreads, &d);
+    std::vector<uint16_t>().swap(d.bins);
+    std::vector<int>().swap(d.act);
 
-	if (f_ind[0] == f_ind[1])
-	    continue;
-	if (f_ind[0] == f_ind[2])
-	    continue;
-	if (f_ind[1] == f_ind[2])
-	    continue;
+    // Cluster the parts
+    d.old_to_new.assign(n_p, -1);
+    d.merged.assign(d.nparts, 0);
+    d.targets.assign(d.nparts, 0);
+    dec_run(dec_part_worker, std::min(threads, d.nparts), &d);
+    std::vector<int>().swap(d.order);
 
-	// Not degenerate - assign
-	nfaces.push_back(f_ind[0]);
-	nfaces.push_back(f_ind[1]);
-	nfaces.push_back(f_ind[2]);
+    size_t old_merged = 0;
+    size_t mtgt_cnt = 0;
+    for (size_t pt = 0; pt < d.nparts; pt++) {
+	old_merged += d.merged[pt];
+	mtgt_cnt += d.targets[pt];
     }
 
+    // Remap the faces, dropping any that are now degenerate
+    d.nfchunks = ((size_t)n_ifaces + DEC_CHUNK - 1) / DEC_CHUNK;
+    d.kept.resize(d.nfchunks);
+    dec_run(dec_face_worker, std::min(threads, d.nfchunks), &d);
+
+    size_t nfaces = 0;
+    for (size_t c = 0; c < d.nfchunks; c++)
+	nfaces += d.kept[c].size() / 3;
+
     if (old_merged)
 	bu_vls_printf(&s->msgs, "redirected %zd pnts to %zd new targets\n", old_merged, mtgt_cnt);
-    if (n_ifaces != (int)(nfaces.size()/3))
-	bu_vls_printf(&s->msgs, "removed %d faces\n", n_ifaces - (int)(nfaces.size()/3));
+    if ((size_t)n_ifaces != nfaces)
+	bu_vls_printf(&s->msgs, "removed %d faces\n", n_ifaces - (int)nfaces);
 
-    if (!nfaces.size())
+    if (!nfaces)
 	return BRLCAD_ERROR;
 
-    (*ofaces) = (int *)bu_calloc(nfaces.size(), sizeof(int), "ofaces");
-    for (size_t i = 0; i < nfaces.size(); i++)
-	(*ofaces)[i] = nfaces[i];
-    *n_ofaces = (int)(nfaces.size()/3);
+    (*ofaces) = (int *)bu_calloc(nfaces * 3, sizeof(int), "ofaces");
+    pos = 0;
+    for (size_t c = 0; c < d.nfchunks; c++) {
+	if (!d.kept[c].size())
+	    continue;
+	memcpy(&(*ofaces)[pos], d.kept[c].data(), d.kept[c].size() * sizeof(int));
+	pos += d.kept[c].size();
+    }
+    *n_ofaces = (int)nfaces;
 
     return BRLCAD_OK;
 }
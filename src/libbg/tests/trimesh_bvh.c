@@ -0,0 +1,282 @@
+/*                   T R I M E S H _ B V H . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+
+#include "common.h"
+
+#include <stdio.h>
+
+#include "bu.h"
+#include "bg/tri_tri.h"
+#include "bg/trimesh.h"
+
+#define NTRI 400
+#define GRID 12
+#define CUBE_TRI (12*GRID*GRID)
+
+static unsigned long seed = 12345;
+
+static fastf_t
+rnd(void)
+{
+    seed = (seed * 1103515245UL + 12345UL) & 0x7fffffffUL;
+    return (fastf_t)seed / (fastf_t)0x7fffffffUL;
+}
+
+/* NTRI small triangles scattered through the unit cube, each with its own vertices */
+static void
+soup(int *faces, point_t *verts)
+{
+    for (int i = 0; i < NTRI; i++) {
+	point_t c;
+	VSET(c, rnd(), rnd(), rnd());
+	for (int j = 0; j < 3; j++) {
+	    VSET(verts[3*i+j], c[X] + 0.2*(rnd() - 0.5), c[Y] + 0.2*(rnd() - 0.5), c[Z] + 0.2*(rnd() - 0.5));
+	    faces[3*i+j] = 3*i+j;
+	}
+    }
+}
+
+static int
+shares_vert(const int *faces, int a, int b)
+{
+    for (int i = 0; i < 3; i++) {
+	for (int j = 0; j < 3; j++) {
+	    if (faces[3*a+i] == faces[3*b+j])
+		return 1;
+	}
+    }
+    return 0;
+}
+
+static int
+brute_isect(const int *f1, point_t *v1, const int *f2, point_t *v2, int self, int *pairs)
+{
+    int n = 0;
+    for (int i = 0; i < NTRI; i++) {
+	for (int j = (self) ? i + 1 : 0; j < NTRI; j++) {
+	    if (self && shares_vert(f1, i, j))
+		continue;
+	    if (bg_tri_tri_isect(v1[f1[3*i]], v1[f1[3*i+1]], v1[f1[3*i+2]],
+				 v2[f2[3*j]], v2[f2[3*j+1]], v2[f2[3*j+2]])) {
+		pairs[2*n+0] = i;
+		pairs[2*n+1] = j;
+		n++;
+	    }
+	}
+    }
+    return n;
+}
+
+static int
+check_pairs(const char *label, const int *expected, int nexpected, const int *pairs, size_t npairs)
+{
+    if ((size_t)nexpected != npairs) {
+	bu_log("%s: expected %d pairs, got %zu\n", label, nexpected, npairs);
+	return 1;
+    }
+    for (int i = 0; i < 2*nexpected; i++) {
+	if (expected[i] != pairs[i]) {
+	    bu_log("%s: pair %d differs\n", label, i/2);
+	    return 1;
+	}
+    }
+    return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+    static int f1[3*NTRI], f2[3*NTRI];
+    static point_t v1[3*NTRI], v2[3*NTRI];
+    static int expected[2*NTRI*NTRI];
+    int *pairs = NULL;
+    size_t npairs;
+    int nexpected;
+    int ret = 0;
+
+    bu_setprogname(argv[0]);
+
+    if (argc != 1)
+	bu_exit(1, "Usage: %s\n", argv[0]);
+
+    soup(f1, v1);
+    soup(f2, v2);
+
+    struct bg_trimesh_bvh *b1 = bg_trimesh_bvh_create(f1, NTRI, (const point_t *)v1, 3*NTRI);
+    struct bg_trimesh_bvh *b2 = bg_trimesh_bvh_create(f2, NTRI, (const point_t *)v2, 3*NTRI);
+    if (!b1 || !b2)
+	bu_exit(1, "BVH creation failed\n");
+
+    /* Mesh vs mesh, serial and threaded */
+    nexpected = brute_isect(f1, v1, f2, v2, 0, expected);
+    if (!nexpected)
+	bu_exit(1, "test meshes don't intersect\n");
+    for (int ncpu = 1; ncpu <= 4; ncpu += 3) {
+	npairs = bg_trimesh_bvh_isect(&pairs, b1, b2, ncpu);
+	ret += check_pairs("isect", expected, nexpected, pairs, npairs);
+	if (pairs)
+	    bu_free(pairs, "pairs");
+    }
+
+    /* Self intersection */
+    nexpected = brute_isect(f1, v1, f1, v1, 1, expected);
+    npairs = bg_trimesh_bvh_self_isect(&pairs, b1, NULL, 0);
+    ret += check_pairs("self_isect", expected, nexpected, pairs, npairs);
+    if (pairs)
+	bu_free(pairs, "pairs");
+
+    /* Box query */
+    {
+	point_t bmin = VINIT_ZERO;
+	point_t bmax = {0.5, 0.5, 0.5};
+	int *qfaces = NULL;
+	int nq = 0;
+	size_t nfound = bg_trimesh_bvh_query(&qfaces, b1, bmin, bmax);
+	for (int i = 0; i < NTRI; i++) {
+	    point_t tmin, tmax;
+	    VMOVE(tmin, v1[f1[3*i]]);
+	    VMOVE(tmax, v1[f1[3*i]]);
+	    VMINMAX(tmin, tmax, v1[f1[3*i+1]]);
+	    VMINMAX(tmin, tmax, v1[f1[3*i+2]]);
+	    if (V3RPP_OVERLAP(tmin, tmax, bmin, bmax)) {
+		if ((size_t)nq >= nfound || qfaces[nq] != i) {
+		    bu_log("query: face %d missing\n", i);
+		    ret++;
+		    break;
+		}
+		nq++;
+	    }
+	}
+	if ((size_t)nq != nfound) {
+	    bu_log("query: expected %d faces, got %zu\n", nq, nfound);
+	    ret++;
+	}
+	if (qfaces)
+	    bu_free(qfaces, "faces");
+    }
+
+    bg_trimesh_bvh_destroy(b1);
+    bg_trimesh_bvh_destroy(b2);
+
+    /* bg_trimesh_isect reports the faces involved */
+    {
+	int *if1 = NULL, *if2 = NULL;
+	int nf1 = 0, nf2 = 0;
+	int np = bg_trimesh_isect(NULL, NULL, NULL, NULL, &if1, &nf1, &if2, &nf2,
+				  f1, NTRI, v1, 3*NTRI, f2, NTRI, v2, 3*NTRI);
+	nexpected = brute_isect(f1, v1, f2, v2, 0, expected);
+	if (np != nexpected || !nf1 || !nf2 || nf1 > np || nf2 > np) {
+	    bu_log("bg_trimesh_isect: %d pairs, %d and %d faces (expected %d pairs)\n", np, nf1, nf2, nexpected);
+	    ret++;
+	}
+	if (if1)
+	    bu_free(if1, "faces");
+	if (if2)
+	    bu_free(if2, "faces");
+    }
+
+    /* A flat grid doesn't intersect itself */
+    {
+	static int gf[6*GRID*GRID];
+	static point_t gv[(GRID+1)*(GRID+1)];
+	for (int i = 0; i <= GRID; i++) {
+	    for (int j = 0; j <= GRID; j++)
+		VSET(gv[i*(GRID+1)+j], i, j, 0);
+	}
+	for (int i = 0; i < GRID; i++) {
+	    for (int j = 0; j < GRID; j++) {
+		int v = i*(GRID+1)+j;
+		int *f = &gf[6*(i*GRID+j)];
+		f[0] = v; f[1] = v+GRID+1; f[2] = v+GRID+2;
+		f[3] = v; f[4] = v+GRID+2; f[5] = v+1;
+	    }
+	}
+	struct bg_trimesh_bvh *g = bg_trimesh_bvh_create(gf, 2*GRID*GRID, (const point_t *)gv, (GRID+1)*(GRID+1));
+	npairs = bg_trimesh_bvh_self_isect(NULL, g, NULL, 0);
+	if (npairs) {
+	    bu_log("grid: %zu unexpected self intersections\n", npairs);
+	    ret++;
+	}
+	bg_trimesh_bvh_destroy(g);
+    }
+
+    /* Nor does a closed mesh whose triangles each have their own copies
+     * of the vertices, as many file formats store them.  The copies
+     * are jittered, but stay well within the tolerance. */
+    {
+	static int cf[3*CUBE_TRI];
+	static point_t cv[3*CUBE_TRI];
+	static const int quad[6] = {0, 1, 2, 0, 2, 3};
+	struct bn_tol tol = BN_TOL_INIT_TOL;
+	int nt = 0;
+	for (int a = 0; a < 3; a++) {
+	    for (int side = 0; side <= GRID; side += GRID) {
+		for (int i = 0; i < GRID; i++) {
+		    for (int j = 0; j < GRID; j++) {
+			point_t c[4];
+			for (int k = 0; k < 4; k++) {
+			    c[k][a] = side;
+			    c[k][(a+1)%3] = i + ((k == 1 || k == 2) ? 1 : 0);
+			    c[k][(a+2)%3] = j + ((k >= 2) ? 1 : 0);
+			}
+			for (int k = 0; k < 6; k++) {
+			    int v = 3*nt + k;
+			    VMOVE(cv[v], c[quad[k]]);
+			    cv[v][X] += ((v * 7919) % 13 - 6) * 1.0e-8;
+			    cv[v][Y] += ((v * 104729) % 11 - 5) * 1.0e-8;
+			    cf[v] = v;
+			}
+			nt += 2;
+		    }
+		}
+	    }
+	}
+	struct bg_trimesh_bvh *c = bg_trimesh_bvh_create(cf, CUBE_TRI, (const point_t *)cv, 3*CUBE_TRI);
+	if (!c)
+	    bu_exit(1, "BVH creation failed\n");
+	npairs = bg_trimesh_bvh_self_isect(NULL, c, &tol, 0);
+	if (npairs) {
+	    bu_log("unwelded cube: %zu unexpected self intersections\n", npairs);
+	    ret++;
+	}
+	/* Without the tolerance the neighbors are reported, so the
+	 * check above does depend on it */
+	if (!bg_trimesh_bvh_self_isect(NULL, c, NULL, 0)) {
+	    bu_log("unwelded cube: no neighbors found by index\n");
+	    ret++;
+	}
+	bg_trimesh_bvh_destroy(c);
+    }
+
+    if (ret)
+	bu_log("FAILED\n");
+
+    return (ret) ? 1 : 0;
+}
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
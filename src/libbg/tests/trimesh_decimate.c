@@ -0,0 +1,119 @@
+/*                T R I M E S H _ D E C I M A T E . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+
+#include "common.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "bu.h"
+#include "bg/trimesh.h"
+
+#define GRID 300
+
+static int
+decimate(int **ofaces, int *n_ofaces, int *faces, int nfaces, point_t *pnts, int npnts, size_t threads)
+{
+    struct bg_trimesh_decimation_settings s = BG_TRIMESH_DECIMATION_SETTINGS_INIT;
+    int ret;
+
+    s.feature_size = 2.0;
+    s.max_threads = threads;
+    ret = bg_trimesh_decimate(ofaces, n_ofaces, faces, nfaces, pnts, npnts, &s);
+    bu_vls_free(&s.msgs);
+    return ret;
+}
+
+int
+main(int UNUSED(argc), const char **argv)
+{
+    int ret = 0;
+    int npnts = GRID * GRID;
+    int nfaces = 2 * (GRID - 1) * (GRID - 1);
+    point_t *pnts = (point_t *)bu_calloc(npnts, sizeof(point_t), "pnts");
+    int *faces = (int *)bu_calloc(nfaces * 3, sizeof(int), "faces");
+    int *of1 = NULL;
+    int *ofn = NULL;
+    int nof1 = 0;
+    int nofn = 0;
+
+    bu_setprogname(argv[0]);
+
+    /* A gently rippled, slightly jittered grid, large enough to be
+     * split into several parts when decimated in parallel */
+    for (int j = 0; j < GRID; j++) {
+	for (int i = 0; i < GRID; i++) {
+	    int k = j * GRID + i;
+	    VSET(pnts[k], i * 0.1 + (k % 17) * 1.0e-4, j * 0.1, ((i * j) % 7) * 0.01);
+	}
+    }
+    for (int j = 0; j < GRID - 1; j++) {
+	for (int i = 0; i < GRID - 1; i++) {
+	    int a = j * GRID + i;
+	    int *f = &faces[6 * (j * (GRID - 1) + i)];
+	    f[0] = a; f[1] = a + 1; f[2] = a + GRID;
+	    f[3] = a + 1; f[4] = a + GRID + 1; f[5] = a + GRID;
+	}
+    }
+
+    if (decimate(&of1, &nof1, faces, nfaces, pnts, npnts, 1) != BRLCAD_OK ||
+	decimate(&ofn, &nofn, faces, nfaces, pnts, npnts, 0) != BRLCAD_OK) {
+	bu_log("decimation failed\n");
+	ret = 1;
+	goto done;
+    }
+
+    if (nof1 <= 0 || nof1 >= nfaces) {
+	bu_log("expected a reduced face count, got %d of %d\n", nof1, nfaces);
+	ret = 1;
+    }
+
+    /* The result must not depend on the number of threads */
+    if (nof1 != nofn || memcmp(of1, ofn, nof1 * 3 * sizeof(int))) {
+	bu_log("single and multi-threaded results differ (%d vs %d faces)\n", nof1, nofn);
+	ret = 1;
+    }
+
+    for (int i = 0; i < nof1; i++) {
+	int *f = &of1[3*i];
+	if (f[0] == f[1] || f[0] == f[2] || f[1] == f[2]) {
+	    bu_log("face %d is degenerate\n", i);
+	    ret = 1;
+	    break;
+	}
+    }
+
+done:
+    bu_free(of1, "ofaces");
+    bu_free(ofn, "ofaces");
+    bu_free(faces, "faces");
+    bu_free(pnts, "pnts");
+    return ret;
+}
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
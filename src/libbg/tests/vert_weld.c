@@ -0,0 +1,200 @@
+/*                     V E R T _ W E L D . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+
+#include "common.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include "bu.h"
+#include "bg/vert_tree.h"
+
+#define WELD_TOL_SQ 1.0e-6
+
+/* Straightforward greedy weld to check against */
+static size_t
+brute_weld(size_t *vmap, fastf_t *out, const fastf_t *verts, size_t nverts, fastf_t tol_sq)
+{
+    size_t nout = 0;
+    for (size_t i = 0; i < nverts; i++) {
+	size_t j;
+	for (j = 0; j < nout; j++) {
+	    if (DIST_PNT_PNT_SQ(&verts[i*3], &out[j*3]) <= tol_sq)
+		break;
+	}
+	if (j == nout) {
+	    VMOVE(&out[nout*3], &verts[i*3]);
+	    nout++;
+	}
+	vmap[i] = j;
+    }
+    return nout;
+}
+
+static int
+check_weld(const fastf_t *verts, size_t nverts, fastf_t tol_sq)
+{
+    int ret = 0;
+    size_t *bmap = (size_t *)bu_calloc(nverts, sizeof(size_t), "bmap");
+    size_t *vmap1 = (size_t *)bu_calloc(nverts, sizeof(size_t), "vmap1");
+    size_t *vmapn = (size_t *)bu_calloc(nverts, sizeof(size_t), "vmapn");
+    fastf_t *bverts = (fastf_t *)bu_calloc(nverts * 3, sizeof(fastf_t), "bverts");
+    fastf_t *verts1 = NULL;
+    fastf_t *vertsn = NULL;
+
+    size_t bcnt = brute_weld(bmap, bverts, verts, nverts, tol_sq);
+    size_t cnt1 = bg_vert_weld(&verts1, vmap1, verts, nverts, tol_sq, 1);
+    size_t cntn = bg_vert_weld(&vertsn, vmapn, verts, nverts, tol_sq, 0);
+
+    if (bcnt != cnt1 || bcnt != cntn) {
+	bu_log("tol_sq %g: expected %zu vertices, got %zu (1 cpu) and %zu (all cpus)\n", tol_sq, bcnt, cnt1, cntn);
+	ret = 1;
+    } else {
+	for (size_t i = 0; i < nverts; i++) {
+	    if (bmap[i] != vmap1[i] || bmap[i] != vmapn[i]) {
+		bu_log("tol_sq %g: vertex %zu mapped to %zu/%zu, expected %zu\n", tol_sq, i, vmap1[i], vmapn[i], bmap[i]);
+		ret = 1;
+		break;
+	    }
+	}
+	for (size_t i = 0; i < bcnt; i++) {
+	    if (!VNEAR_EQUAL(&bverts[i*3], &verts1[i*3], SMALL_FASTF) || !VNEAR_EQUAL(&bverts[i*3], &vertsn[i*3], SMALL_FASTF)) {
+		bu_log("tol_sq %g: output vertex %zu differs\n", tol_sq, i);
+		ret = 1;
+		break;
+	    }
+	}
+    }
+
+    bu_free(bmap, "bmap");
+    bu_free(vmap1, "vmap1");
+    bu_free(vmapn, "vmapn");
+    bu_free(bverts, "bverts");
+    bu_free(verts1, "welded vertices");
+    bu_free(vertsn, "welded vertices");
+    return ret;
+}
+
+/* Too many points for the brute force check, but enough distinct ones
+ * that the tolerance pass is split across threads - the result must
+ * not depend on the thread count */
+static int
+check_threads(size_t nverts, fastf_t tol_sq)
+{
+    int ret = 0;
+    fastf_t *verts = (fastf_t *)bu_calloc(nverts * 3, sizeof(fastf_t), "verts");
+    size_t *vmap1 = (size_t *)bu_calloc(nverts, sizeof(size_t), "vmap1");
+    size_t *vmapn = (size_t *)bu_calloc(nverts, sizeof(size_t), "vmapn");
+    fastf_t *verts1 = NULL;
+    fastf_t *vertsn = NULL;
+
+    for (size_t i = 0; i < nverts; i++) {
+	size_t l = (i * 104729) % 100003;
+	fastf_t *v = &verts[i*3];
+	VSET(v, (fastf_t)(l % 47) * 0.01, (fastf_t)((l / 47) % 47) * 0.01, (fastf_t)(l / 2209) * 0.01);
+	if (i % 3 == 0)
+	    v[X] += 1.0e-4 * (fastf_t)(i % 7);
+    }
+
+    size_t cnt1 = bg_vert_weld(&verts1, vmap1, verts, nverts, tol_sq, 1);
+    size_t cntn = bg_vert_weld(&vertsn, vmapn, verts, nverts, tol_sq, 0);
+    if (cnt1 != cntn) {
+	bu_log("%zu points, tol_sq %g: %zu vertices (1 cpu), %zu (all cpus)\n", nverts, tol_sq, cnt1, cntn);
+	ret = 1;
+    } else {
+	for (size_t i = 0; i < nverts; i++) {
+	    if (vmap1[i] != vmapn[i]) {
+		bu_log("%zu points, tol_sq %g: vertex %zu mapped to %zu (1 cpu), %zu (all cpus)\n", nverts, tol_sq, i, vmap1[i], vmapn[i]);
+		ret = 1;
+		break;
+	    }
+	}
+    }
+
+    bu_free(verts, "verts");
+    bu_free(vmap1, "vmap1");
+    bu_free(vmapn, "vmapn");
+    bu_free(verts1, "welded vertices");
+    bu_free(vertsn, "welded vertices");
+    return ret;
+}
+
+int
+main(int UNUSED(argc), const char **argv)
+{
+    int ret = 0;
+    size_t nverts = 3 * 2000;
+    fastf_t *verts = (fastf_t *)bu_calloc(nverts * 3, sizeof(fastf_t), "verts");
+
+    bu_setprogname(argv[0]);
+
+    /* Triangle soup over a small lattice, so most vertices are
+     * repeated exactly, with some jittered copies close enough (and
+     * some not close enough) to weld */
+    for (size_t i = 0; i < nverts; i++) {
+	size_t l = (i * 7919) % 343;
+	fastf_t *v = &verts[i*3];
+	VSET(v, (fastf_t)(l % 7), (fastf_t)((l / 7) % 7), (fastf_t)(l / 49));
+	if (i % 5 == 0)
+	    v[X] += 1.0e-4;
+	if (i % 11 == 0)
+	    v[Y] -= 1.0e-2;
+	if (i % 13 == 0)
+	    v[Z] = -0.0 * v[Z];
+    }
+
+    ret += check_weld(verts, nverts, WELD_TOL_SQ);
+    ret += check_weld(verts, nverts, 0.0);
+    ret += check_weld(verts, nverts, 0.25);
+    /* so small the grid cell size isn't representable */
+    ret += check_weld(verts, nverts, 1.0e-320);
+
+    ret += check_threads(400000, 1.0e-6);
+
+    /* Non-finite coordinates (e.g. from a malformed STL) are refused */
+    {
+	size_t vmap[3];
+	fastf_t *out = NULL;
+	fastf_t bad[9] = {0, 0, 0,  1, 0, 0,  0, 1, 0};
+	bad[4] = NAN;
+	if (bg_vert_weld(&out, vmap, bad, 3, WELD_TOL_SQ, 0) != 0 || out) {
+	    bu_log("non-finite input was not refused\n");
+	    ret = 1;
+	}
+	bad[4] = INFINITY;
+	if (bg_vert_weld(&out, vmap, bad, 3, WELD_TOL_SQ, 0) != 0 || out) {
+	    bu_log("infinite input was not refused\n");
+	    ret = 1;
+	}
+    }
+
+    bu_free(verts, "verts");
+    return (ret) ? 1 : 0;
+}
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
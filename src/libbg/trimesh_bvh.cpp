@@ -0,0 +1,397 @@
+/*                 T R I M E S H _ B V H . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file libbg/trimesh_bvh.cpp
+ *
+ * Triangle bounding volume hierarchy.
+ *
+ * The tree is stored as a flat array of nodes built top down by
+ * splitting each node's triangles at the median centroid along the
+ * longest axis of the centroid bounds.  Triangles are reordered so
+ * every leaf refers to a contiguous run of them, and each triangle's
+ * box is kept alongside it so leaf tests don't go back to the vertex
+ * array until a pair's boxes actually overlap.
+ *
+ * Mesh-mesh intersection walks the leaves of one tree, querying the
+ * other tree with each leaf's box.  Leaves are handed out to threads
+ * from a shared counter and each thread collects its own pairs, which
+ * are merged when it finishes and sorted at the end so the result
+ * doesn't depend on the number of threads.
+ */
+
+#include "common.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "vmath.h"
+#include "bu/malloc.h"
+#include "bu/parallel.h"
+#include "bg/tri_tri.h"
+#include "bg/trimesh.h"
+
+#define BVH_LEAF_SIZE 4
+
+struct bvh_box {
+    fastf_t min[3];
+    fastf_t max[3];
+};
+
+struct bvh_node {
+    struct bvh_box box;
+    size_t first;	/* first triangle (leaf) or left child (interior) */
+    size_t cnt;		/* triangle count, 0 for interior nodes */
+};
+
+struct bg_trimesh_bvh {
+    const int *faces;
+    const point_t *verts;
+    std::vector<bvh_node> nodes;
+    std::vector<int> tri;		/* face indices in leaf order */
+    std::vector<bvh_box> tbox;		/* boxes of tri[] */
+    std::vector<size_t> leaves;
+};
+
+static inline bool
+bvh_overlap(const struct bvh_box &a, const struct bvh_box &b)
+{
+    return (a.min[X] <= b.max[X] && a.max[X] >= b.min[X] &&
+	    a.min[Y] <= b.max[Y] && a.max[Y] >= b.min[Y] &&
+	    a.min[Z] <= b.max[Z] && a.max[Z] >= b.min[Z]);
+}
+
+static inline void
+bvh_box_init(struct bvh_box &b)
+{
+    VSETALL(b.min, INFINITY);
+    VSETALL(b.max, -INFINITY);
+}
+
+static inline void
+bvh_box_add(struct bvh_box &b, const struct bvh_box &o)
+{
+    VMIN(b.min, o.min);
+    VMAX(b.max, o.max);
+}
+
+
+extern "C" struct bg_trimesh_bvh *
+bg_trimesh_bvh_create(const int *faces, size_t num_faces, const point_t *vertices, size_t num_vertices)
+{
+    if (!faces || !num_faces || !vertices || !num_vertices)
+	return NULL;
+
+    for (size_t i = 0; i < num_faces * 3; i++) {
+	if (faces[i] < 0 || (size_t)faces[i] >= num_vertices)
+	    return NULL;
+    }
+
+    struct bg_trimesh_bvh *bvh = new bg_trimesh_bvh;
+    bvh->faces = faces;
+    bvh->verts = vertices;
+
+    std::vector<bvh_box> fbox(num_faces);
+    std::vector<fastf_t> cent(3 * num_faces);
+    for (size_t i = 0; i < num_faces; i++) {
+	const fastf_t *v0 = vertices[faces[3*i+0]];
+	const fastf_t *v1 = vertices[faces[3*i+1]];
+	const fastf_t *v2 = vertices[faces[3*i+2]];
+	VMOVE(fbox[i].min, v0);
+	VMOVE(fbox[i].max, v0);
+	VMINMAX(fbox[i].min, fbox[i].max, v1);
+	VMINMAX(fbox[i].min, fbox[i].max, v2);
+	VADD2SCALE(&cent[3*i], fbox[i].min, fbox[i].max, 0.5);
+    }
+
+    bvh->tri.resize(num_faces);
+    for (size_t i = 0; i < num_faces; i++)
+	bvh->tri[i] = (int)i;
+
+    /* (node, start, end) ranges of tri[] still to be split */
+    struct bvh_range {
+	size_t node, start, end;
+    };
+    std::vector<bvh_range> todo;
+
+    bvh->nodes.reserve(2 * (num_faces / BVH_LEAF_SIZE + 1));
+    bvh->nodes.push_back(bvh_node());
+    todo.push_back({0, 0, num_faces});
+
+    while (!todo.empty()) {
+	bvh_range r = todo.back();
+	todo.pop_back();
+
+	struct bvh_box box, cbox;
+	bvh_box_init(box);
+	bvh_box_init(cbox);
+	for (size_t i = r.start; i < r.end; i++) {
+	    int f = bvh->tri[i];
+	    bvh_box_add(box, fbox[f]);
+	    VMIN(cbox.min, &cent[3*f]);
+	    VMAX(cbox.max, &cent[3*f]);
+	}
+	bvh->nodes[r.node].box = box;
+
+	vect_t ext;
+	VSUB2(ext, cbox.max, cbox.min);
+	int axis = X;
+	if (ext[Y] > ext[axis])
+	    axis = Y;
+	if (ext[Z] > ext[axis])
+	    axis = Z;
+
+	/* Small ranges, or ones whose centroids coincide, become leaves */
+	if (r.end - r.start <= BVH_LEAF_SIZE || ext[axis] <= 0.0) {
+	    bvh->nodes[r.node].first = r.start;
+	    bvh->nodes[r.node].cnt = r.end - r.start;
+	    bvh->leaves.push_back(r.node);
+	    continue;
+	}
+
+	size_t mid = r.start + (r.end - r.start) / 2;
+	std::nth_element(bvh->tri.begin() + r.start, bvh->tri.begin() + mid, bvh->tri.begin() + r.end,
+			 [&cent, axis](int a, int b) {
+			     fastf_t ca = cent[3*a+axis];
+			     fastf_t cb = cent[3*b+axis];
+			     return (ca < cb || (ca == cb && a < b));
+			 });
+
+	size_t left = bvh->nodes.size();
+	bvh->nodes.push_back(bvh_node());
+	bvh->nodes.push_back(bvh_node());
+	bvh->nodes[r.node].first = left;
+	bvh->nodes[r.node].cnt = 0;
+	todo.push_back({left + 1, mid, r.end});
+	todo.push_back({left, r.start, mid});
+    }
+
+    bvh->tbox.resize(num_faces);
+    for (size_t i = 0; i < num_faces; i++)
+	bvh->tbox[i] = fbox[bvh->tri[i]];
+
+    return bvh;
+}
+
+
+extern "C" void
+bg_trimesh_bvh_destroy(struct bg_trimesh_bvh *bvh)
+{
+    delete bvh;
+}
+
+
+/* Call func(i) for each tri[] index i whose box overlaps box */
+template <typename F>
+static void
+bvh_visit(const struct bg_trimesh_bvh *bvh, const struct bvh_box &box, std::vector<size_t> &stack, F func)
+{
+    stack.clear();
+    stack.push_back(0);
+    while (!stack.empty()) {
+	const bvh_node &n = bvh->nodes[stack.back()];
+	stack.pop_back();
+	if (!bvh_overlap(n.box, box))
+	    continue;
+	if (!n.cnt) {
+	    stack.push_back(n.first + 1);
+	    stack.push_back(n.first);
+	    continue;
+	}
+	for (size_t i = n.first; i < n.first + n.cnt; i++) {
+	    if (bvh_overlap(bvh->tbox[i], box))
+		func(i);
+	}
+    }
+}
+
+
+static size_t
+bvh_output(int **out, std::vector<int> &v)
+{
+    if (out) {
+	*out = NULL;
+	if (!v.empty()) {
+	    *out = (int *)bu_malloc(v.size() * sizeof(int), "bvh output");
+	    std::copy(v.begin(), v.end(), *out);
+	}
+    }
+    return v.size();
+}
+
+
+extern "C" size_t
+bg_trimesh_bvh_query(int **ofaces, const struct bg_trimesh_bvh *bvh, const point_t bmin, const point_t bmax)
+{
+    std::vector<int> found;
+    if (bvh) {
+	struct bvh_box box;
+	VMOVE(box.min, bmin);
+	VMOVE(box.max, bmax);
+	std::vector<size_t> stack;
+	bvh_visit(bvh, box, stack, [&](size_t i) { found.push_back(bvh->tri[i]); });
+	std::sort(found.begin(), found.end());
+    }
+    return bvh_output(ofaces, found);
+}
+
+
+struct bvh_isect_data {
+    const struct bg_trimesh_bvh *a;
+    const struct bg_trimesh_bvh *b;
+    bool self;
+    fastf_t dist_sq;	/* coincident vertex distance, < 0 to compare indices only */
+    std::atomic<size_t> next;
+    std::mutex lock;
+    std::vector<std::pair<int, int>> found;
+};
+
+static inline bool
+bvh_tri_isect(const struct bg_trimesh_bvh *a, int fa, const struct bg_trimesh_bvh *b, int fb)
+{
+    /* bg_tri_tri_isect doesn't take const input */
+    point_t p[3], q[3];
+    for (int k = 0; k < 3; k++) {
+	VMOVE(p[k], a->verts[a->faces[3*fa+k]]);
+	VMOVE(q[k], b->verts[b->faces[3*fb+k]]);
+    }
+    return (bg_tri_tri_isect(p[0], p[1], p[2], q[0], q[1], q[2]) != 0);
+}
+
+/* Faces that share a vertex, either by index or, in meshes that haven't
+ * been welded, by position */
+static inline bool
+bvh_shared_vert(const struct bg_trimesh_bvh *bvh, int fa, int fb, fastf_t dist_sq)
+{
+    for (int i = 0; i < 3; i++) {
+	int va = bvh->faces[3*fa+i];
+	for (int j = 0; j < 3; j++) {
+	    int vb = bvh->faces[3*fb+j];
+	    if (va == vb)
+		return true;
+	    if (dist_sq >= 0 && DIST_PNT_PNT_SQ(bvh->verts[va], bvh->verts[vb]) <= dist_sq)
+		return true;
+	}
+    }
+    return false;
+}
+
+static void
+bvh_isect_worker(int UNUSED(cpu), void *data)
+{
+    struct bvh_isect_data *d = (struct bvh_isect_data *)data;
+    const struct bg_trimesh_bvh *a = d->a;
+    const struct bg_trimesh_bvh *b = d->b;
+    std::vector<std::pair<int, int>> found;
+    std::vector<size_t> stack;
+    size_t l;
+
+    while ((l = d->next.fetch_add(1)) < a->leaves.size()) {
+	const bvh_node &leaf = a->nodes[a->leaves[l]];
+	bvh_visit(b, leaf.box, stack, [&](size_t j) {
+		int fb = b->tri[j];
+		for (size_t i = leaf.first; i < leaf.first + leaf.cnt; i++) {
+		    int fa = a->tri[i];
+		    if (d->self && fa >= fb)
+			continue;
+		    if (!bvh_overlap(a->tbox[i], b->tbox[j]))
+			continue;
+		    if (d->self && bvh_shared_vert(a, fa, fb, d->dist_sq))
+			continue;
+		    if (bvh_tri_isect(a, fa, b, fb))
+			found.push_back(std::make_pair(fa, fb));
+		}
+	    });
+    }
+
+    if (found.empty())
+	return;
+    std::lock_guard<std::mutex> guard(d->lock);
+    d->found.insert(d->found.end(), found.begin(), found.end());
+}
+
+static size_t
+bvh_isect(int **pairs, const struct bg_trimesh_bvh *a, const struct bg_trimesh_bvh *b, bool self, const struct bn_tol *tol, int ncpu)
+{
+    if (pairs)
+	*pairs = NULL;
+    if (!a || !b || !bvh_overlap(a->nodes[0].box, b->nodes[0].box))
+	return 0;
+
+    size_t avail = bu_avail_cpus();
+    size_t threads = (ncpu <= 0 || (size_t)ncpu > avail) ? avail : (size_t)ncpu;
+    if (threads > MAX_PSW)
+	threads = MAX_PSW;
+    if (threads > a->leaves.size())
+	threads = a->leaves.size();
+    if (threads < 1)
+	threads = 1;
+
+    struct bvh_isect_data d;
+    d.a = a;
+    d.b = b;
+    d.self = self;
+    d.dist_sq = (tol) ? tol->dist_sq : -1.0;
+    d.next = 0;
+    if (threads > 1)
+	bu_parallel(bvh_isect_worker, threads, (void *)&d);
+    else
+	bvh_isect_worker(0, (void *)&d);
+
+    /* Threads finish in no particular order */
+    std::vector<std::pair<int, int>> &all = d.found;
+    std::sort(all.begin(), all.end());
+    size_t total = all.size();
+
+    if (pairs && total) {
+	*pairs = (int *)bu_malloc(2 * total * sizeof(int), "bvh isect pairs");
+	for (size_t i = 0; i < total; i++) {
+	    (*pairs)[2*i+0] = all[i].first;
+	    (*pairs)[2*i+1] = all[i].second;
+	}
+    }
+
+    return total;
+}
+
+
+extern "C" size_t
+bg_trimesh_bvh_isect(int **pairs, const struct bg_trimesh_bvh *a, const struct bg_trimesh_bvh *b, int ncpu)
+{
+    return bvh_isect(pairs, a, b, false, NULL, ncpu);
+}
+
+
+extern "C" size_t
+bg_trimesh_bvh_self_isect(int **pairs, const struct bg_trimesh_bvh *bvh, const struct bn_tol *tol, int ncpu)
+{
+    return bvh_isect(pairs, bvh, bvh, true, tol, ncpu);
+}
+
+
+// Local Variables:
+// tab-width: 8
+// mode: C++
+// c-basic-offset: 4
+// indent-tabs-mode: t
+// c-file-style: "stroustrup"
+// End:
+// ex: shiftwidth=4 tabstop=8
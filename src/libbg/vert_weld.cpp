@@ -0,0 +1,429 @@
+/*                   V E R T _ W E L D . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file libbg/vert_weld.cpp
+ *
+ * Bulk vertex welding using a spatial hash grid.
+ *
+ * Mesh importers typically see every vertex several times (binary STL
+ * stores each triangle's corners explicitly), so the weld is done in
+ * two passes.  The first collapses bit-identical coordinates: vertex
+ * hashes are computed in parallel, scattered (stably) into buckets,
+ * and each bucket is deduplicated independently.  The second pass
+ * merges each remaining distinct point, in input order, into the
+ * earliest kept vertex within tolerance, looking only in the 27 grid
+ * cells around it; the neighbor searches run in parallel and only the
+ * final choice among the candidates found is made serially.  Because
+ * an exact duplicate would have found the same match as its first
+ * occurrence, the result is the same as a serial greedy weld over the
+ * full input.
+ */
+
+#include "common.h"
+
+#include <atomic>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include "vmath.h"
+#include "bu/malloc.h"
+#include "bu/parallel.h"
+#include "bg/vert_tree.h"
+
+#define WELD_CHUNK 65536
+#define WELD_BUCKETS 256
+/* Use the high hash bits for buckets, the low ones for the per-bucket maps */
+#define WELD_BUCKET(_h) ((size_t)((_h) >> 56))
+
+struct weld_pt {
+    fastf_t v[3];
+    bool operator==(const weld_pt &o) const {
+	return (v[0] == o.v[0] && v[1] == o.v[1] && v[2] == o.v[2]);
+    }
+};
+
+static inline uint64_t
+weld_mix(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static inline uint64_t
+weld_pt_hash(const fastf_t *p)
+{
+    uint64_t h = 0;
+    for (int i = 0; i < 3; i++) {
+	double d = (double)p[i];
+	uint64_t bits;
+	/* -0.0 and 0.0 compare equal, so must hash equal */
+	if (d == 0.0)
+	    d = 0.0;
+	memcpy(&bits, &d, sizeof(bits));
+	h = weld_mix(h ^ bits);
+    }
+    return h;
+}
+
+struct weld_pt_hasher {
+    size_t operator()(const weld_pt &p) const {
+	return (size_t)weld_pt_hash(p.v);
+    }
+};
+
+struct weld_data {
+    const fastf_t *verts;
+    size_t nverts;
+    size_t nchunks;
+    std::vector<uint64_t> hashes;
+    std::vector<size_t> counts;		/* nchunks x WELD_BUCKETS */
+    std::vector<size_t> offsets;	/* nchunks x WELD_BUCKETS */
+    std::vector<size_t> bucket_start;	/* WELD_BUCKETS + 1 */
+    std::vector<size_t> order;
+    size_t *rep;
+    std::atomic<size_t> next;
+    std::atomic<bool> nonfinite;
+};
+
+static void
+weld_hash_worker(int UNUSED(cpu), void *data)
+{
+    struct weld_data *d = (struct weld_data *)data;
+    size_t c;
+    while ((c = d->next.fetch_add(1)) < d->nchunks) {
+	size_t start = c * WELD_CHUNK;
+	size_t end = (start + WELD_CHUNK < d->nverts) ? start + WELD_CHUNK : d->nverts;
+	size_t *cnt = &d->counts[c * WELD_BUCKETS];
+	for (size_t i = start; i < end; i++) {
+	    const fastf_t *p = &d->verts[i*3];
+	    if (!std::isfinite(p[0]) || !std::isfinite(p[1]) || !std::isfinite(p[2])) {
+		d->nonfinite = true;
+		continue;
+	    }
+	    uint64_t h = weld_pt_hash(p);
+	    d->hashes[i] = h;
+	    cnt[WELD_BUCKET(h)]++;
+	}
+    }
+}
+
+static void
+weld_scatter_worker(int UNUSED(cpu), void *data)
+{
+    struct weld_data *d = (struct weld_data *)data;
+    size_t c;
+    while ((c = d->next.fetch_add(1)) < d->nchunks) {
+	size_t start = c * WELD_CHUNK;
+	size_t end = (start + WELD_CHUNK < d->nverts) ? start + WELD_CHUNK : d->nverts;
+	size_t *off = &d->offsets[c * WELD_BUCKETS];
+	for (size_t i = start; i < end; i++)
+	    d->order[off[WELD_BUCKET(d->hashes[i])]++] = i;
+    }
+}
+
+static void
+weld_bucket_worker(int UNUSED(cpu), void *data)
+{
+    struct weld_data *d = (struct weld_data *)data;
+    std::unordered_map<weld_pt, size_t, weld_pt_hasher> first;
+    size_t b;
+    while ((b = d->next.fetch_add(1)) < WELD_BUCKETS) {
+	first.clear();
+	/* Indices within a bucket are in input order, so the first
+	 * occurrence of each point is the one recorded */
+	for (size_t j = d->bucket_start[b]; j < d->bucket_start[b+1]; j++) {
+	    size_t i = d->order[j];
+	    weld_pt p;
+	    VMOVE(p.v, &d->verts[i*3]);
+	    auto f = first.emplace(p, i);
+	    d->rep[i] = f.first->second;
+	}
+    }
+}
+
+
+/* Spatial grid used for the tolerance pass */
+
+struct weld_cell {
+    int64_t c[3];
+    bool operator==(const weld_cell &o) const {
+	return (c[0] == o.c[0] && c[1] == o.c[1] && c[2] == o.c[2]);
+    }
+};
+
+struct weld_cell_hasher {
+    size_t operator()(const weld_cell &k) const {
+	uint64_t h = weld_mix((uint64_t)k.c[0]);
+	h = weld_mix(h ^ (uint64_t)k.c[1]);
+	return (size_t)weld_mix(h ^ (uint64_t)k.c[2]);
+    }
+};
+
+static inline int64_t
+weld_cell_coord(fastf_t v, fastf_t inv_cell)
+{
+    /* Clamp rather than overflow for very small tolerances - far
+     * away points then share cells, which only costs distance checks.
+     * Input is known to be finite, but the product still might not be. */
+    double c = floor((double)v * inv_cell);
+    if (std::isnan(c))
+	return 0;
+    if (c > 4.0e18)
+	return (int64_t)4e18;
+    if (c < -4.0e18)
+	return (int64_t)-4e18;
+    return (int64_t)c;
+}
+
+
+/* Tolerance pass.  Each distinct point's candidates - the earlier
+ * distinct points within tolerance of it - are found in parallel from
+ * a grid of all the distinct points.  Which of those candidates are
+ * kept depends on the decisions made for earlier points, so that part
+ * is done serially, but it only has to look at the (short) candidate
+ * lists. */
+
+typedef std::unordered_map<weld_cell, std::vector<size_t>, weld_cell_hasher> weld_grid;
+
+struct weld_tol_data {
+    const fastf_t *verts;
+    const std::vector<size_t> *dist;	/* distinct points, in input order */
+    const std::vector<weld_cell> *cells;
+    const weld_grid *grid;
+    fastf_t local_tol_sq;
+    size_t nchunks;
+    std::vector<std::vector<size_t>> cand;	/* per chunk, positions in dist */
+    std::vector<std::vector<size_t>> cand_cnt;	/* per chunk, per point */
+    std::atomic<size_t> next;
+};
+
+static void
+weld_tol_worker(int UNUSED(cpu), void *data)
+{
+    struct weld_tol_data *d = (struct weld_tol_data *)data;
+    const std::vector<size_t> &dist = *d->dist;
+    std::vector<size_t> found;
+    size_t c;
+    while ((c = d->next.fetch_add(1)) < d->nchunks) {
+	size_t start = c * WELD_CHUNK;
+	size_t end = (start + WELD_CHUNK < dist.size()) ? start + WELD_CHUNK : dist.size();
+	std::vector<size_t> &cand = d->cand[c];
+	std::vector<size_t> &cnt = d->cand_cnt[c];
+	cnt.resize(end - start);
+	for (size_t pi = start; pi < end; pi++) {
+	    const fastf_t *p = &d->verts[dist[pi]*3];
+	    const weld_cell &k = (*d->cells)[pi];
+	    found.clear();
+	    for (int dx = -1; dx <= 1; dx++) {
+		for (int dy = -1; dy <= 1; dy++) {
+		    for (int dz = -1; dz <= 1; dz++) {
+			weld_cell n = {{k.c[0] + dx, k.c[1] + dy, k.c[2] + dz}};
+			auto g = d->grid->find(n);
+			if (g == d->grid->end())
+			    continue;
+			for (size_t o : g->second) {
+			    if (o >= pi)
+				break;
+			    if (DIST_PNT_PNT_SQ(p, &d->verts[dist[o]*3]) <= d->local_tol_sq)
+				found.push_back(o);
+			}
+		    }
+		}
+	    }
+	    cnt[pi - start] = found.size();
+	    cand.insert(cand.end(), found.begin(), found.end());
+	}
+    }
+}
+
+
+extern "C" size_t
+bg_vert_weld(fastf_t **overts, size_t *vmap, const fastf_t *verts, size_t nverts, fastf_t local_tol_sq, int ncpu)
+{
+    if (!overts || !vmap || !verts || !nverts) {
+	if (overts)
+	    *overts = NULL;
+	return 0;
+    }
+
+    size_t avail = bu_avail_cpus();
+    size_t threads = (ncpu <= 0 || (size_t)ncpu > avail) ? avail : (size_t)ncpu;
+    if (threads > MAX_PSW)
+	threads = MAX_PSW;
+    if (threads < 1)
+	threads = 1;
+
+    /* Pass 1 - collapse bit-identical points */
+    struct weld_data d;
+    d.verts = verts;
+    d.nverts = nverts;
+    d.nchunks = (nverts + WELD_CHUNK - 1) / WELD_CHUNK;
+    d.hashes.resize(nverts);
+    d.counts.assign(d.nchunks * WELD_BUCKETS, 0);
+    d.offsets.resize(d.nchunks * WELD_BUCKETS);
+    d.bucket_start.resize(WELD_BUCKETS + 1);
+    d.order.resize(nverts);
+    d.rep = (size_t *)bu_malloc(nverts * sizeof(size_t), "weld reps");
+    d.nonfinite = false;
+
+    size_t pthreads = (threads < d.nchunks) ? threads : d.nchunks;
+    d.next = 0;
+    if (pthreads > 1)
+	bu_parallel(weld_hash_worker, pthreads, (void *)&d);
+    else
+	weld_hash_worker(0, (void *)&d);
+
+    /* NaN and infinite coordinates can't be placed in the grid (or
+     * compared meaningfully) - refuse them */
+    if (d.nonfinite) {
+	bu_free(d.rep, "weld reps");
+	*overts = NULL;
+	return 0;
+    }
+
+    /* Bucket-major, chunk-minor offsets keep each bucket in input order */
+    size_t pos = 0;
+    for (size_t b = 0; b < WELD_BUCKETS; b++) {
+	d.bucket_start[b] = pos;
+	for (size_t c = 0; c < d.nchunks; c++) {
+	    d.offsets[c * WELD_BUCKETS + b] = pos;
+	    pos += d.counts[c * WELD_BUCKETS + b];
+	}
+    }
+    d.bucket_start[WELD_BUCKETS] = pos;
+
+    d.next = 0;
+    if (pthreads > 1)
+	bu_parallel(weld_scatter_worker, pthreads, (void *)&d);
+    else
+	weld_scatter_worker(0, (void *)&d);
+
+    d.next = 0;
+    if (threads > 1)
+	bu_parallel(weld_bucket_worker, threads, (void *)&d);
+    else
+	weld_bucket_worker(0, (void *)&d);
+
+    std::vector<uint64_t>().swap(d.hashes);
+    std::vector<size_t>().swap(d.order);
+
+    /* Pass 2 - greedy tolerance merge over the distinct points */
+    size_t ndistinct = 0;
+    for (size_t i = 0; i < nverts; i++) {
+	if (d.rep[i] == i)
+	    ndistinct++;
+    }
+
+    fastf_t *out = (fastf_t *)bu_malloc(ndistinct * 3 * sizeof(fastf_t), "welded vertices");
+    size_t nout = 0;
+
+    fastf_t inv_cell = (local_tol_sq > 0.0) ? 1.0 / sqrt(local_tol_sq) : 0.0;
+    if (local_tol_sq > 0.0 && std::isfinite(inv_cell)) {
+	std::vector<size_t> dist;
+	dist.reserve(ndistinct);
+	for (size_t i = 0; i < nverts; i++) {
+	    if (d.rep[i] == i)
+		dist.push_back(i);
+	}
+
+	/* Positions are added in order, so each cell's list is sorted */
+	std::vector<weld_cell> cells(ndistinct);
+	weld_grid grid;
+	grid.reserve(ndistinct);
+	for (size_t pi = 0; pi < ndistinct; pi++) {
+	    const fastf_t *p = &verts[dist[pi]*3];
+	    for (int j = 0; j < 3; j++)
+		cells[pi].c[j] = weld_cell_coord(p[j], inv_cell);
+	    grid[cells[pi]].push_back(pi);
+	}
+
+	struct weld_tol_data td;
+	td.verts = verts;
+	td.dist = &dist;
+	td.cells = &cells;
+	td.grid = &grid;
+	td.local_tol_sq = local_tol_sq;
+	td.nchunks = (ndistinct + WELD_CHUNK - 1) / WELD_CHUNK;
+	td.cand.resize(td.nchunks);
+	td.cand_cnt.resize(td.nchunks);
+	td.next = 0;
+	size_t tthreads = (threads < td.nchunks) ? threads : td.nchunks;
+	if (tthreads > 1)
+	    bu_parallel(weld_tol_worker, tthreads, (void *)&td);
+	else
+	    weld_tol_worker(0, (void *)&td);
+
+	/* Merge each point into its earliest kept candidate.  Output
+	 * indices increase with input order, so that is also the
+	 * smallest output index. */
+	std::vector<size_t> kept(ndistinct, SIZE_MAX);
+	for (size_t c = 0; c < td.nchunks; c++) {
+	    const std::vector<size_t> &cand = td.cand[c];
+	    size_t ci = 0;
+	    for (size_t k = 0; k < td.cand_cnt[c].size(); k++) {
+		size_t pi = c * WELD_CHUNK + k;
+		size_t match = SIZE_MAX;
+		for (size_t e = ci + td.cand_cnt[c][k]; ci < e; ci++) {
+		    if (kept[cand[ci]] < match)
+			match = kept[cand[ci]];
+		}
+		if (match == SIZE_MAX) {
+		    VMOVE(&out[nout*3], &verts[dist[pi]*3]);
+		    match = kept[pi] = nout++;
+		}
+		vmap[dist[pi]] = match;
+	    }
+	}
+	for (size_t i = 0; i < nverts; i++) {
+	    if (d.rep[i] != i)
+		vmap[i] = vmap[d.rep[i]];
+	}
+    } else {
+	for (size_t i = 0; i < nverts; i++) {
+	    if (d.rep[i] != i) {
+		vmap[i] = vmap[d.rep[i]];
+		continue;
+	    }
+	    VMOVE(&out[nout*3], &verts[i*3]);
+	    vmap[i] = nout++;
+	}
+    }
+
+    bu_free(d.rep, "weld reps");
+    *overts = out;
+    return nout;
+}
+
+
+// Local Variables:
+// tab-width: 8
+// mode: C++
+// c-basic-offset: 4
+// indent-tabs-mode: t
+// c-file-style: "stroustrup"
+// End:
+// ex: shiftwidth=4 tabstop=8
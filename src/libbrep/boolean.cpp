@@ -28,6 +28,10 @@
 #include "common.h"
 
 #include <assert.h>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
 #include <vector>
 #include <stack>
 #include <queue>
@@ -39,6 +43,7 @@
 
 #include "vmath.h"
 #include "bu/log.h"
+#include "bu/parallel.h"
 #include "brep/defines.h"
 #include "brep/boolean.h"
 #include "brep/intersect.h"
@@ -3436,6 +3441,254 @@ face_brep_location(const TrimmedFace *tface, const ON_Brep *brep, ON_SimpleArray
 }
 
 
+/* Broad phase for the face/face intersections: sweep and prune along
+ * X over the face bounding boxes, then apply the exact box distance
+ * test to the survivors.  The result is the same set of pairs, sorted
+ * the same way, as testing every face of brep1 against every face of
+ * brep2. */
+struct FaceBoxSpan {
+    double m_lo, m_hi;
+    int m_set;
+    int m_face;
+    ON_BoundingBox m_bbox;
+};
+
+
+static bool
+face_box_span_cmp(const FaceBoxSpan &a, const FaceBoxSpan &b)
+{
+    if (a.m_lo < b.m_lo)
+	return true;
+    if (b.m_lo < a.m_lo)
+	return false;
+    if (a.m_set != b.m_set)
+	return a.m_set < b.m_set;
+    return a.m_face < b.m_face;
+}
+
+
+static void
+get_intersection_candidates(
+    std::vector<std::pair<int, int> > &candidates,
+    const ON_Brep *brep1,
+    const ON_Brep *brep2,
+    const std::vector<int> &faces1,
+    const std::vector<int> &faces2)
+{
+    std::vector<FaceBoxSpan> spans;
+    spans.reserve(faces1.size() + faces2.size());
+    for (int set = 0; set < 2; set++) {
+	const ON_Brep *brep = (set) ? brep2 : brep1;
+	const std::vector<int> &faces = (set) ? faces2 : faces1;
+	for (size_t k = 0; k < faces.size(); k++) {
+	    FaceBoxSpan span;
+	    span.m_bbox = brep->m_F[faces[k]].BoundingBox();
+	    // pad by the full tolerance on both sides so the sweep never
+	    // rejects a pair the exact test would accept
+	    span.m_lo = span.m_bbox.m_min.x - INTERSECTION_TOL;
+	    span.m_hi = span.m_bbox.m_max.x + INTERSECTION_TOL;
+	    span.m_set = set;
+	    span.m_face = faces[k];
+	    spans.push_back(span);
+	}
+    }
+    std::sort(spans.begin(), spans.end(), face_box_span_cmp);
+
+    std::vector<const FaceBoxSpan *> active[2];
+    for (size_t k = 0; k < spans.size(); k++) {
+	const FaceBoxSpan &span = spans[k];
+	std::vector<const FaceBoxSpan *> &others = active[1 - span.m_set];
+
+	size_t l = 0;
+	while (l < others.size()) {
+	    if (others[l]->m_hi < span.m_lo) {
+		others[l] = others.back();
+		others.pop_back();
+		continue;
+	    }
+	    if (span.m_bbox.MinimumDistanceTo(others[l]->m_bbox) <= INTERSECTION_TOL) {
+		if (span.m_set)
+		    candidates.push_back(std::make_pair(others[l]->m_face, span.m_face));
+		else
+		    candidates.push_back(std::make_pair(span.m_face, others[l]->m_face));
+	    }
+	    l++;
+	}
+	active[span.m_set].push_back(&span);
+    }
+
+    std::sort(candidates.begin(), candidates.end());
+}
+
+
+struct SSIPairResult {
+    bool m_hit;
+    ON_SimpleArray<ON_Curve *> m_on1, m_on2;
+
+    SSIPairResult() : m_hit(false) {}
+};
+
+
+/* Subsurface trees are subdivided lazily as they are searched, so
+ * threads can't share them.  Each thread builds its own trees for the
+ * surfaces it works on. */
+struct SSIThreadTrees {
+    std::map<int, Subsurface *> m_t1, m_t2;
+};
+
+
+struct SSIPairJob {
+    const ON_Brep *m_brep1, *m_brep2;
+    const std::vector<std::pair<int, int> > *m_pairs;
+    std::vector<SSIPairResult> *m_results;
+    std::vector<Subsurface *> *m_st1, *m_st2;
+    std::vector<SSIThreadTrees> m_trees;
+    bool m_shared;
+    std::atomic<size_t> m_next;
+    std::mutex m_lock;
+    std::exception_ptr m_err;
+};
+
+
+static Subsurface *
+ssi_thread_tree(std::map<int, Subsurface *> &trees, const ON_Brep *brep, int si)
+{
+    std::map<int, Subsurface *>::iterator t_it = trees.find(si);
+    if (t_it != trees.end())
+	return t_it->second;
+    Subsurface *ss = new Subsurface(brep->m_S[si]->Duplicate());
+    trees[si] = ss;
+    return ss;
+}
+
+
+static void
+intersect_face_pair(SSIPairJob *job, int cpu, size_t k)
+{
+    const ON_Brep *brep1 = job->m_brep1;
+    const ON_Brep *brep2 = job->m_brep2;
+    int i = (*job->m_pairs)[k].first;
+    int j = (*job->m_pairs)[k].second;
+    SSIPairResult &r = (*job->m_results)[k];
+    int si1 = brep1->m_F[i].m_si;
+    int si2 = brep2->m_F[j].m_si;
+
+    ON_Surface *surf1 = brep1->m_S[si1];
+    ON_Surface *surf2 = brep2->m_S[si2];
+    if (is_same_surface(surf1, surf2)) {
+	return;
+    }
+
+    Subsurface *tree1, *tree2;
+    if (job->m_shared) {
+	tree1 = (*job->m_st1)[si1];
+	tree2 = (*job->m_st2)[si2];
+    } else {
+	tree1 = ssi_thread_tree(job->m_trees[cpu].m_t1, brep1, si1);
+	tree2 = ssi_thread_tree(job->m_trees[cpu].m_t2, brep2, si2);
+    }
+
+    // Possible enhancement: Some faces may share the same surface.
+    // We can store the result of SSI to avoid re-computation.
+    ON_ClassArray<ON_SSX_EVENT> events;
+    int results = ON_Intersect(surf1,
+			       surf2,
+			       events,
+			       INTERSECTION_TOL,
+			       0.0,
+			       0.0,
+			       NULL,
+			       NULL,
+			       NULL,
+			       NULL,
+			       tree1,
+			       tree2);
+    if (results <= 0) {
+	return;
+    }
+
+    r.m_hit = true;
+    for (int e = 0; e < events.Count(); e++) {
+	if (events[e].m_type == ON_SSX_EVENT::ssx_tangent ||
+	    events[e].m_type == ON_SSX_EVENT::ssx_transverse ||
+	    events[e].m_type == ON_SSX_EVENT::ssx_overlap)
+	{
+	    get_subcurves_inside_faces(r.m_on1, r.m_on2, brep1, brep2, i, j, &events[e]);
+	}
+    }
+}
+
+
+static void
+intersect_face_pairs_worker(int cpu, void *data)
+{
+    SSIPairJob *job = (SSIPairJob *)data;
+    size_t k;
+    while ((k = job->m_next.fetch_add(1)) < job->m_pairs->size()) {
+	try {
+	    intersect_face_pair(job, cpu, k);
+	} catch (...) {
+	    // hand the first failure back to the calling thread and
+	    // stop handing out work
+	    std::lock_guard<std::mutex> guard(job->m_lock);
+	    if (!job->m_err)
+		job->m_err = std::current_exception();
+	    job->m_next = job->m_pairs->size();
+	}
+    }
+}
+
+
+/* Run the surface/surface intersections for each candidate face pair.
+ * The pairs are independent, so they are spread across threads; each
+ * result lands in the slot matching its pair so the caller can merge
+ * them in a fixed order. */
+static void
+intersect_face_pairs(
+    std::vector<SSIPairResult> &results,
+    const std::vector<std::pair<int, int> > &pairs,
+    const ON_Brep *brep1,
+    const ON_Brep *brep2,
+    std::vector<Subsurface *> &st1,
+    std::vector<Subsurface *> &st2)
+{
+    size_t ncpu = bu_avail_cpus();
+    if (ncpu > MAX_PSW)
+	ncpu = MAX_PSW;
+    if (ncpu > pairs.size())
+	ncpu = pairs.size();
+    if (ncpu < 1)
+	ncpu = 1;
+
+    SSIPairJob job;
+    job.m_brep1 = brep1;
+    job.m_brep2 = brep2;
+    job.m_pairs = &pairs;
+    job.m_results = &results;
+    job.m_st1 = &st1;
+    job.m_st2 = &st2;
+    job.m_shared = (ncpu == 1);
+    job.m_next = 0;
+
+    if (job.m_shared) {
+	intersect_face_pairs_worker(0, (void *)&job);
+    } else {
+	job.m_trees.resize(ncpu);
+	bu_parallel(intersect_face_pairs_worker, ncpu, (void *)&job);
+	for (size_t c = 0; c < job.m_trees.size(); c++) {
+	    std::map<int, Subsurface *>::iterator t_it;
+	    for (t_it = job.m_trees[c].m_t1.begin(); t_it != job.m_trees[c].m_t1.end(); ++t_it)
+		delete t_it->second;
+	    for (t_it = job.m_trees[c].m_t2.begin(); t_it != job.m_trees[c].m_t2.end(); ++t_it)
+		delete t_it->second;
+	}
+    }
+
+    if (job.m_err)
+	std::rethrow_exception(job.m_err);
+}
+
+
 static ON_ClassArray<ON_SimpleArray<SSICurve> >
 get_face_intersection_curves(
     ON_SimpleArray<Subsurface *> &surf_tree1,
@@ -3502,21 +3755,17 @@ get_face_intersection_curves(
     //
     // We won't be able to distinguish between 1 and 3 at this stage, but we can narrow in
     // on which faces might fall into category 2 and what faces they might interact with.
-    std::set<std::pair<int, int> > intersection_candidates;
+    std::vector<int> active1, active2;
     for (int i = 0; i < face_count1; i++) {
-	if (unused1.find(i) == unused1.end() && finalform1.find(i) == finalform1.end()) {
-	    for (int j = 0; j < face_count2; j++) {
-		if (unused2.find(j) == unused2.end() &&  finalform2.find(j) == finalform2.end()) {
-		    // If the two faces don't interact according to their bounding boxes,
-		    // they won't be a source of events - otherwise, they must be checked.
-		    fastf_t face_dist = brep1->m_F[i].BoundingBox().MinimumDistanceTo(brep2->m_F[j].BoundingBox());
-		    if (face_dist <= INTERSECTION_TOL) {
-			intersection_candidates.insert(std::pair<int, int>(i, j));
-		    }
-		}
-	    }
-	}
+	if (unused1.find(i) == unused1.end() && finalform1.find(i) == finalform1.end())
+	    active1.push_back(i);
+    }
+    for (int j = 0; j < face_count2; j++) {
+	if (unused2.find(j) == unused2.end() && finalform2.find(j) == finalform2.end())
+	    active2.push_back(j);
     }
+    std::vector<std::pair<int, int> > intersection_candidates;
+    get_intersection_candidates(intersection_candidates, brep1, brep2, active1, active2);
 
     // For those not in category 2 an inside/outside test on the breps combined with the boolean op
     // should be enough to decide the issue, but there is a problem.  If *all* faces of a brep are
@@ -3539,8 +3788,8 @@ get_face_intersection_curves(
 
     if (DEBUG_BREP_BOOLEAN) {
 	//bu_log("Summary of brep status: \n unused1: %zd\n unused2: %zd\n finalform1: %zd\n finalform2 %zd\nintersection_candidates(%zd):\n", unused1.size(), unused2.size(), finalform1.size(), finalform2.size(), intersection_candidates.size());
-	for (std::set<std::pair<int, int> >::iterator it = intersection_candidates.begin(); it != intersection_candidates.end(); ++it) {
-	    bu_log("     (%d, %d)\n", (*it).first, (*it).second);
+	for (size_t k = 0; k < intersection_candidates.size(); k++) {
+	    bu_log("     (%d, %d)\n", intersection_candidates[k].first, intersection_candidates[k].second);
 	}
     }
 
@@ -3560,87 +3809,48 @@ get_face_intersection_curves(
     curves_array.SetCount(curves_array.Capacity());
 
     // calculate intersection curves
-    for (int i = 0; i < face_count1; i++) {
-
-	if ((int)st1.size() < brep1->m_F[i].m_si + 1)
+    std::vector<std::pair<int, int> > ssi_pairs;
+    for (size_t k = 0; k < intersection_candidates.size(); k++) {
+	int i = intersection_candidates[k].first;
+	int j = intersection_candidates[k].second;
+	if ((int)st1.size() < brep1->m_F[i].m_si + 1 || (int)st2.size() < brep2->m_F[j].m_si + 1)
 	    continue;
+	ssi_pairs.push_back(intersection_candidates[k]);
+    }
 
-	for (int j = 0; j < face_count2; j++) {
-	    if (intersection_candidates.find(std::pair<int, int>(i, j)) != intersection_candidates.end()) {
-		ON_Surface *surf1, *surf2;
-		ON_ClassArray<ON_SSX_EVENT> events;
-		int results = 0;
-		surf1 = brep1->m_S[brep1->m_F[i].m_si];
-		surf2 = brep2->m_S[brep2->m_F[j].m_si];
-		if (is_same_surface(surf1, surf2)) {
-		    continue;
-		}
-
-		if (surf_tree2.Count() < brep2->m_F[j].m_si + 1)
-		    continue;
-
-		// Possible enhancement: Some faces may share the same surface.
-		// We can store the result of SSI to avoid re-computation.
-		results = ON_Intersect(surf1,
-				       surf2,
-				       events,
-				       INTERSECTION_TOL,
-				       0.0,
-				       0.0,
-				       NULL,
-				       NULL,
-				       NULL,
-				       NULL,
-				       st1[brep1->m_F[i].m_si],
-				       st2[brep2->m_F[j].m_si]);
-		if (results <= 0) {
-		    continue;
-		}
-
-		//dplot->SSX(events, brep1, brep1->m_F[i].m_si, brep2, brep2->m_F[j].m_si);
-		//dplot->WriteLog();
-
-		ON_SimpleArray<ON_Curve *> face1_curves, face2_curves;
-		for (int k = 0; k < events.Count(); k++) {
-		    if (events[k].m_type == ON_SSX_EVENT::ssx_tangent ||
-			events[k].m_type == ON_SSX_EVENT::ssx_transverse ||
-			events[k].m_type == ON_SSX_EVENT::ssx_overlap)
-		    {
-			ON_SimpleArray<ON_Curve *> subcurves_on1, subcurves_on2;
-
-			get_subcurves_inside_faces(subcurves_on1,
-						   subcurves_on2, brep1, brep2, i, j, &events[k]);
-
-			for (int l = 0; l < subcurves_on1.Count(); ++l) {
-			    SSICurve ssi_on1;
-			    ssi_on1.m_curve = subcurves_on1[l];
-			    curves_array[i].Append(ssi_on1);
-
-			    face1_curves.Append(subcurves_on1[l]);
-			}
-			for (int l = 0; l < subcurves_on2.Count(); ++l) {
-			    SSICurve ssi_on2;
-			    ssi_on2.m_curve = subcurves_on2[l];
-			    curves_array[face_count1 + j].Append(ssi_on2);
+    std::vector<SSIPairResult> ssi_results(ssi_pairs.size());
+    intersect_face_pairs(ssi_results, ssi_pairs, brep1, brep2, st1, st2);
 
-			    face2_curves.Append(subcurves_on2[l]);
-			}
-		    }
-		}
-		//dplot->ClippedFaceCurves(surf1, surf2, face1_curves, face2_curves);
-		//dplot->WriteLog();
+    // merge in candidate order, so the curves on each face are always
+    // in the same order no matter how many threads did the work
+    for (size_t k = 0; k < ssi_pairs.size(); k++) {
+	int i = ssi_pairs[k].first;
+	int j = ssi_pairs[k].second;
+	SSIPairResult &r = ssi_results[k];
+	if (!r.m_hit)
+	    continue;
 
-		if (DEBUG_BREP_BOOLEAN) {
-		    // Look for coplanar faces
-		    ON_Plane surf1_plane, surf2_plane;
-		    if (surf1->IsPlanar(&surf1_plane) && surf2->IsPlanar(&surf2_plane)) {
-			/* We already checked for disjoint above, so the only remaining question is the normals */
-			if (surf1_plane.Normal().IsParallelTo(surf2_plane.Normal())) {
-			    bu_log("Faces brep1->%d and brep2->%d are coplanar and intersecting\n", i, j);
-			}
-		    }
+	for (int l = 0; l < r.m_on1.Count(); ++l) {
+	    SSICurve ssi_on1;
+	    ssi_on1.m_curve = r.m_on1[l];
+	    curves_array[i].Append(ssi_on1);
+	}
+	for (int l = 0; l < r.m_on2.Count(); ++l) {
+	    SSICurve ssi_on2;
+	    ssi_on2.m_curve = r.m_on2[l];
+	    curves_array[face_count1 + j].Append(ssi_on2);
+	}
+
+	if (DEBUG_BREP_BOOLEAN) {
+	    // Look for coplanar faces
+	    ON_Plane surf1_plane, surf2_plane;
+	    ON_Surface *surf1 = brep1->m_S[brep1->m_F[i].m_si];
+	    ON_Surface *surf2 = brep2->m_S[brep2->m_F[j].m_si];
+	    if (surf1->IsPlanar(&surf1_plane) && surf2->IsPlanar(&surf2_plane)) {
+		/* We already checked for disjoint above, so the only remaining question is the normals */
+		if (surf1_plane.Normal().IsParallelTo(surf2_plane.Normal())) {
+		    bu_log("Faces brep1->%d and brep2->%d are coplanar and intersecting\n", i, j);
 		}
-
 	    }
 	}
     }
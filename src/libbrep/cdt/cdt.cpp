@@ -26,10 +26,12 @@
  */
 
 #include "common.h"
+#include <atomic>
 #include <iostream>
 #include <numeric>
 #include <queue>
 #include <string>
+#include "bu/parallel.h"
 #include "bg/chull.h"
 #include "bg/tri_tri.h"
 #include "./cdt.h"
@@ -145,9 +147,12 @@ do_triangulation(struct ON_Brep_CDT_State *s_cdt, int fi)
 	    if (!edge) continue;
 	    const ON_Curve* crv = edge->EdgeCurveOf();
 	    if (!crv) continue;
-	    std::set<bedge_seg_t *> &epsegs = s_cdt->e2polysegs[edge->m_edge_index];
+	    // Faces may be triangulated concurrently - look up, don't insert
+	    std::map<int, std::set<bedge_seg_t *>>::const_iterator ep_it = s_cdt->e2polysegs.find(edge->m_edge_index);
+	    if (ep_it == s_cdt->e2polysegs.end()) continue;
+	    const std::set<bedge_seg_t *> &epsegs = ep_it->second;
 	    if (!epsegs.size()) continue;
-	    std::set<bedge_seg_t *>::iterator e_it;
+	    std::set<bedge_seg_t *>::const_iterator e_it;
 	    for (e_it = epsegs.begin(); e_it != epsegs.end(); e_it++) {
 		bedge_seg_t *b = *e_it;
 		double seg_dist = b->e_start->DistanceTo(*b->e_end);
@@ -197,6 +202,60 @@ do_triangulation(struct ON_Brep_CDT_State *s_cdt, int fi)
     return refine_triangulation(s_cdt, fmesh, 0, 0);
 }
 
+struct cdt_face_job {
+    struct ON_Brep_CDT_State *s_cdt;
+    const std::vector<int> *faces;
+    std::vector<int> *results;
+    std::atomic<size_t> next;
+};
+
+static void
+do_triangulation_worker(int UNUSED(cpu), void *data)
+{
+    struct cdt_face_job *job = (struct cdt_face_job *)data;
+    size_t i;
+    while ((i = job->next.fetch_add(1)) < job->faces->size())
+	(*job->results)[i] = (do_triangulation(job->s_cdt, (*job->faces)[i])) ? 1 : 0;
+}
+
+/* Each face's mesh is built from the (by now fixed) edge polygons and
+ * the face's own surface samples, so the faces can be triangulated
+ * independently.  The per-face containers in the state are std::maps;
+ * create every entry up front so the workers only ever look them up. */
+static void
+triangulate_faces(struct ON_Brep_CDT_State *s_cdt, const std::vector<int> &faces, std::vector<int> &results)
+{
+    results.resize(faces.size(), 0);
+
+    std::set<int> uniq(faces.begin(), faces.end());
+    size_t ncpu = cdt_ncpu(s_cdt, faces.size());
+
+    struct cdt_face_job job;
+    job.s_cdt = s_cdt;
+    job.faces = &faces;
+    job.results = &results;
+    job.next = 0;
+
+    // A face listed twice would be worked on by two threads at once
+    if (ncpu < 2 || uniq.size() != faces.size()) {
+	do_triangulation_worker(0, (void *)&job);
+	return;
+    }
+
+    for (size_t i = 0; i < faces.size(); i++) {
+	int fi = faces[i];
+	(void)s_cdt->fmeshes[fi];
+	(void)s_cdt->face_rtrees_2d[fi];
+	(void)s_cdt->face_rtrees_3d[fi];
+	(void)s_cdt->strim_pnts[fi];
+	(void)s_cdt->strim_norms[fi];
+	(*s_cdt->min_edge_seg_len)[fi] = DBL_MAX;
+	(*s_cdt->max_edge_seg_len)[fi] = 0;
+    }
+
+    bu_parallel(do_triangulation_worker, ncpu, (void *)&job);
+}
+
 ON_3dVector
 calc_trim_vnorm(ON_BrepVertex& v, ON_BrepTrim *trim)
 {
@@ -523,14 +582,19 @@ ON_Brep_CDT_Tessellate(struct ON_Brep_CDT_State *s_cdt, int face_cnt, int *faces
     int face_failures = 0;
     int face_successes = 0;
     int fc = ((face_cnt == 0) || !faces) ? s_cdt->brep->m_F.Count() : face_cnt;
+    std::vector<int> tri_faces;
+    std::vector<int> tri_results;
     for (int i = 0; i < fc; i++) {
 	int fi = ((face_cnt == 0) || !faces) ? i : faces[i];
-	if (fi < s_cdt->brep->m_F.Count()) {
-	    if (do_triangulation(s_cdt, fi)) {
-		face_successes++;
-	    } else {
-		face_failures++;
-	    }
+	if (fi < s_cdt->brep->m_F.Count())
+	    tri_faces.push_back(fi);
+    }
+    triangulate_faces(s_cdt, tri_faces, tri_results);
+    for (size_t i = 0; i < tri_results.size(); i++) {
+	if (tri_results[i]) {
+	    face_successes++;
+	} else {
+	    face_failures++;
 	}
     }
 
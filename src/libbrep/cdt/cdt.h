@@ -30,6 +30,7 @@
 #include <vector>
 #include <list>
 #include <map>
+#include <mutex>
 #include <stack>
 #include <iostream>
 #include <algorithm>
@@ -62,6 +63,9 @@
 
 #define BREP_PLANAR_TOL 0.05
 
+/* Below this many independent work items, threading isn't worth it */
+#define CDT_PARALLEL_MIN_SEGS 64
+
 /***************************************************/
 
 #define BREP_CDT_FAILED -3
@@ -141,6 +145,12 @@ struct ON_Brep_CDT_State {
     std::map<int, std::set<size_t>> face_ovlp_tris;
     std::map<int, std::vector<struct brep_face_ovlp_instance *>> face_ovlps;
     std::set<int> faces_to_update;
+
+    /* Threading - faces of one state are triangulated concurrently, so
+     * the point registry needs a lock, but independent states don't
+     * share one.  max_threads == 0 means use all available CPUs. */
+    std::mutex add_lock;
+    size_t max_threads;
 };
 
 ON_3dVector calc_trim_vnorm(ON_BrepVertex& v, ON_BrepTrim *trim);
@@ -152,6 +162,7 @@ std::set<cpolyedge_t *> split_singular_seg(struct ON_Brep_CDT_State *s_cdt, cpol
 std::vector<cpolyedge_t *> cdt_face_polyedges(struct ON_Brep_CDT_State *s_cdt, int face_index);
 void CDT_Add3DNorm(struct ON_Brep_CDT_State *s, ON_3dPoint *norm, ON_3dPoint *vert, int fid, int vid, int tid, int eid, fastf_t x2d, fastf_t y2d);
 void CDT_Add3DPnt(struct ON_Brep_CDT_State *s, ON_3dPoint *p, int fid, int vid, int tid, int eid, fastf_t x2d, fastf_t y2d);
+size_t cdt_ncpu(struct ON_Brep_CDT_State *s_cdt, size_t nitems);
 void CDT_Tol_Set(struct brep_cdt_tol *cdt, double dist, fastf_t md, double t_abs, double t_rel, double t_dist);
 void GetInteriorPoints(struct ON_Brep_CDT_State *s_cdt, int face_index);
 void cdt_tol_global_calc(struct ON_Brep_CDT_State *s);
@@ -26,9 +26,11 @@
  */
 
 #include "common.h"
+#include <atomic>
 #include <queue>
 #include <numeric>
 #include <iterator>
+#include "bu/parallel.h"
 #include "bg/chull.h"
 #include "./cdt.h"
 
@@ -1470,6 +1472,70 @@ tol_linear_edges_split(struct ON_Brep_CDT_State *s_cdt)
 
 }
 
+/* Check one trim segment's 2D box against the other segments on its
+ * face, recording in its split_status whether it needs to be split.
+ * Only the segment itself is written, and the rtree is only searched,
+ * so any number of these can run at once. */
+static void
+close_edge_check(struct ON_Brep_CDT_State *s_cdt, RTree<void *, double, 2> *rtree, cpolyedge_t *tseg)
+{
+    ON_2dPoint p2d1(tseg->polygon->pnts_2d[tseg->v2d[0]].first, tseg->polygon->pnts_2d[tseg->v2d[0]].second);
+    ON_2dPoint p2d2(tseg->polygon->pnts_2d[tseg->v2d[1]].first, tseg->polygon->pnts_2d[tseg->v2d[1]].second);
+
+    // Trim 2D bbox
+    ON_Line line(p2d1, p2d2);
+    ON_BoundingBox bb = line.BoundingBox();
+    bb.m_max.x = bb.m_max.x + ON_ZERO_TOLERANCE;
+    bb.m_max.y = bb.m_max.y + ON_ZERO_TOLERANCE;
+    bb.m_min.x = bb.m_min.x - ON_ZERO_TOLERANCE;
+    bb.m_min.y = bb.m_min.y - ON_ZERO_TOLERANCE;
+    double dist = p2d1.DistanceTo(p2d2);
+    double bdist = 0.5*dist;
+    double xdist = bb.m_max.x - bb.m_min.x;
+    double ydist = bb.m_max.y - bb.m_min.y;
+    if (xdist < bdist) {
+	bb.m_min.x = bb.m_min.x - 0.51*bdist;
+	bb.m_max.x = bb.m_max.x + 0.51*bdist;
+    }
+    if (ydist < bdist) {
+	bb.m_min.y = bb.m_min.y - 0.51*bdist;
+	bb.m_max.y = bb.m_max.y + 0.51*bdist;
+    }
+
+    double tMin[2];
+    tMin[0] = bb.Min().x;
+    tMin[1] = bb.Min().y;
+    double tMax[2];
+    tMax[0] = bb.Max().x;
+    tMax[1] = bb.Max().y;
+
+    //plot_ce_bbox(s_cdt, tseg, "c.p3");
+
+    // Edge context info
+    struct rtree_minsplit_context a_context;
+    a_context.s_cdt = s_cdt;
+    a_context.cseg = tseg;
+
+    // Do the search
+    rtree->Search(tMin, tMax, MinSplit2dCallback, (void *)&a_context);
+}
+
+struct close_edge_job {
+    struct ON_Brep_CDT_State *s_cdt;
+    RTree<void *, double, 2> *rtree;
+    std::vector<cpolyedge_t *> *ws;
+    std::atomic<size_t> next;
+};
+
+static void
+close_edge_worker(int UNUSED(cpu), void *data)
+{
+    struct close_edge_job *job = (struct close_edge_job *)data;
+    size_t i;
+    while ((i = job->next.fetch_add(1)) < job->ws->size())
+	close_edge_check(job->s_cdt, job->rtree, (*job->ws)[i]);
+}
+
 void
 refine_close_edges(struct ON_Brep_CDT_State *s_cdt)
 {
@@ -1490,52 +1556,20 @@ refine_close_edges(struct ON_Brep_CDT_State *s_cdt)
 
 	    bool split_check = false;
 
-	    // TODO - with the status determination being recorded in the cpolyedge_t structure
-	    // itself, this loop should be (in principle) suitable for bu_parallel - we're not
-	    // doing any splitting at this point - searching is a read only activity once
-	    // the initial data containers are set up
-	    std::vector<cpolyedge_t *>::iterator w_it;
-	    for (w_it = ws.begin(); w_it != ws.end(); w_it++) {
-		cpolyedge_t *tseg = *w_it;
-		ON_2dPoint p2d1(tseg->polygon->pnts_2d[tseg->v2d[0]].first, tseg->polygon->pnts_2d[tseg->v2d[0]].second);
-		ON_2dPoint p2d2(tseg->polygon->pnts_2d[tseg->v2d[1]].first, tseg->polygon->pnts_2d[tseg->v2d[1]].second);
-
-		// Trim 2D bbox
-		ON_Line line(p2d1, p2d2);
-		ON_BoundingBox bb = line.BoundingBox();
-		bb.m_max.x = bb.m_max.x + ON_ZERO_TOLERANCE;
-		bb.m_max.y = bb.m_max.y + ON_ZERO_TOLERANCE;
-		bb.m_min.x = bb.m_min.x - ON_ZERO_TOLERANCE;
-		bb.m_min.y = bb.m_min.y - ON_ZERO_TOLERANCE;
-		double dist = p2d1.DistanceTo(p2d2);
-		double bdist = 0.5*dist;
-		double xdist = bb.m_max.x - bb.m_min.x;
-		double ydist = bb.m_max.y - bb.m_min.y;
-		if (xdist < bdist) {
-		    bb.m_min.x = bb.m_min.x - 0.51*bdist;
-		    bb.m_max.x = bb.m_max.x + 0.51*bdist;
-		}
-		if (ydist < bdist) {
-		    bb.m_min.y = bb.m_min.y - 0.51*bdist;
-		    bb.m_max.y = bb.m_max.y + 0.51*bdist;
-		}
-
-		double tMin[2];
-		tMin[0] = bb.Min().x;
-		tMin[1] = bb.Min().y;
-		double tMax[2];
-		tMax[0] = bb.Max().x;
-		tMax[1] = bb.Max().y;
-
-		//plot_ce_bbox(s_cdt, tseg, "c.p3");
-
-		// Edge context info
-		struct rtree_minsplit_context a_context;
-		a_context.s_cdt = s_cdt;
-		a_context.cseg = tseg;
-
-		// Do the search
-		s_cdt->face_rtrees_2d[face.m_face_index].Search(tMin, tMax, MinSplit2dCallback, (void *)&a_context);
+	    // With the status determination being recorded in the cpolyedge_t
+	    // structure itself, the checks are independent - we're not doing
+	    // any splitting at this point, and searching is a read only
+	    // activity once the initial data containers are set up.
+	    struct close_edge_job job;
+	    job.s_cdt = s_cdt;
+	    job.rtree = &s_cdt->face_rtrees_2d[face.m_face_index];
+	    job.ws = &ws;
+	    job.next = 0;
+	    size_t ncpu = cdt_ncpu(s_cdt, ws.size());
+	    if (ncpu > 1 && ws.size() >= CDT_PARALLEL_MIN_SEGS) {
+		bu_parallel(close_edge_worker, ncpu, (void *)&job);
+	    } else {
+		close_edge_worker(0, (void *)&job);
 	    }
 
 	    // If we need to split, do so.  We need to process as a set,
@@ -1593,6 +1627,7 @@ refine_close_edges(struct ON_Brep_CDT_State *s_cdt)
 	    split_cnt++;
 
 	    if (split_check) {
+		std::vector<cpolyedge_t *>::iterator w_it;
 		ws = current_trims;
 		for (w_it = ws.begin(); w_it != ws.end(); w_it++) {
 		    // We don't want to zero this status information if this is
@@ -26,6 +26,7 @@
  */
 
 #include "common.h"
+#include "bu/parallel.h"
 #include "bu/str.h"
 #include "bg/tri_ray.h"
 #include "./cdt.h"
@@ -451,9 +452,12 @@ cdt_ainfo(int fid, int vid, int tid, int eid, fastf_t x2d, fastf_t y2d, fastf_t
     return a;
 }
 
+/* Faces are triangulated in parallel, and their surface samples are
+ * registered here */
 void
 CDT_Add3DPnt(struct ON_Brep_CDT_State *s, ON_3dPoint *p, int fid, int vid, int tid, int eid, fastf_t x2d, fastf_t y2d)
 {
+    std::lock_guard<std::mutex> guard(s->add_lock);
     s->w3dpnts->push_back(p);
     (*s->pnt_audit_info)[p] = cdt_ainfo(fid, vid, tid, eid, x2d, y2d, 0.0, 0.0, 0.0);
 }
@@ -461,10 +465,25 @@ CDT_Add3DPnt(struct ON_Brep_CDT_State *s, ON_3dPoint *p, int fid, int vid, int t
 void
 CDT_Add3DNorm(struct ON_Brep_CDT_State *s, ON_3dPoint *normal, ON_3dPoint *vert, int fid, int vid, int tid, int eid, fastf_t x2d, fastf_t y2d)
 {
+    std::lock_guard<std::mutex> guard(s->add_lock);
     s->w3dnorms->push_back(normal);
     (*s->pnt_audit_info)[normal] = cdt_ainfo(fid, vid, tid, eid, x2d, y2d, vert->x, vert->y, vert->z);
 }
 
+/* How many threads to use for nitems independent work items */
+size_t
+cdt_ncpu(struct ON_Brep_CDT_State *s_cdt, size_t nitems)
+{
+    size_t ncpu = bu_avail_cpus();
+    if (s_cdt->max_threads && ncpu > s_cdt->max_threads)
+	ncpu = s_cdt->max_threads;
+    if (ncpu > MAX_PSW)
+	ncpu = MAX_PSW;
+    if (ncpu > nitems)
+	ncpu = nitems;
+    return ncpu;
+}
+
 // Digest tessellation tolerances...
 void
 CDT_Tol_Set(struct brep_cdt_tol *cdt, double dist, fastf_t md, double t_abs, double t_rel, double t_dist)
@@ -535,6 +554,8 @@ ON_Brep_CDT_Create(void *bv, const char *objname)
 
     cdt->bot_pnt_to_on_pnt = new std::map<int, ON_3dPoint *>;
 
+    cdt->max_threads = 0;
+
     return cdt;
 }
 
@@ -0,0 +1,217 @@
+/*                     B O O L E A N . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file boolean.cpp
+ *
+ * ON_Boolean regression tests.  Overlapping boxes and spheres are
+ * combined and the vertices of the result are checked against the
+ * region the boolean should produce.  Evaluating the overlapping cases
+ * correctly depends on the face/face intersection curves, which the
+ * vertices of the result lie on, so an evaluation that skips the
+ * surface/surface intersections fails here.
+ */
+
+#define NOMINMAX
+
+#include "common.h"
+
+#include <cmath>
+
+#include "bu.h"
+#include "brep.h"
+
+#define BOOL_TOL 1.0e-3
+
+static ON_Brep *
+make_box(double x0, double y0, double z0, double x1, double y1, double z1)
+{
+    ON_3dPoint c[8] = {
+	ON_3dPoint(x0, y0, z0), ON_3dPoint(x1, y0, z0), ON_3dPoint(x1, y1, z0), ON_3dPoint(x0, y1, z0),
+	ON_3dPoint(x0, y0, z1), ON_3dPoint(x1, y0, z1), ON_3dPoint(x1, y1, z1), ON_3dPoint(x0, y1, z1)
+    };
+    return ON_BrepBox(c);
+}
+
+
+static ON_Brep *
+make_sph(double x, double y, double z, double r)
+{
+    ON_Sphere sph(ON_3dPoint(x, y, z), r);
+    return ON_BrepSphere(sph);
+}
+
+
+static bool
+has_vertex(const ON_Brep *b, double x, double y, double z)
+{
+    for (int i = 0; i < b->m_V.Count(); i++) {
+	if (b->m_V[i].point.DistanceTo(ON_3dPoint(x, y, z)) < BOOL_TOL)
+	    return true;
+    }
+    return false;
+}
+
+
+/* Evaluate op on a and b, and check that the result is a valid brep
+ * with nfaces faces (if nfaces >= 0) whose vertices span exactly
+ * [lo, hi].  An empty result is expected if lo is NULL. */
+static int
+check_bool(const char *name, const ON_Brep *a, const ON_Brep *b, op_type op, const double *lo, const double *hi, int nfaces, ON_Brep **result)
+{
+    ON_Brep *out = ON_Brep::New();
+    int ret = 0;
+
+    try {
+	if (ON_Boolean(out, a, b, op) < 0) {
+	    bu_log("%s: ON_Boolean failed\n", name);
+	    delete out;
+	    return 1;
+	}
+    } catch (...) {
+	bu_log("%s: ON_Boolean threw an exception\n", name);
+	delete out;
+	return 1;
+    }
+
+    if (!lo) {
+	if (out->m_F.Count()) {
+	    bu_log("%s: expected an empty result, got %d faces\n", name, out->m_F.Count());
+	    ret = 1;
+	}
+	delete out;
+	return ret;
+    }
+
+    if (!out->m_F.Count() || !out->m_V.Count()) {
+	bu_log("%s: empty result\n", name);
+	delete out;
+	return 1;
+    }
+
+    ON_wString wstr;
+    ON_TextLog tl(wstr);
+    if (!out->IsValid(&tl)) {
+	ON_String str(wstr);
+	bu_log("%s: result is not valid:\n%s\n", name, str.Array());
+	ret = 1;
+    }
+
+    if (nfaces >= 0 && out->m_F.Count() != nfaces) {
+	bu_log("%s: expected %d faces, got %d\n", name, nfaces, out->m_F.Count());
+	ret = 1;
+    }
+
+    ON_3dPoint vmin = out->m_V[0].point;
+    ON_3dPoint vmax = out->m_V[0].point;
+    for (int i = 1; i < out->m_V.Count(); i++) {
+	for (int j = 0; j < 3; j++) {
+	    vmin[j] = std::min(vmin[j], out->m_V[i].point[j]);
+	    vmax[j] = std::max(vmax[j], out->m_V[i].point[j]);
+	}
+    }
+    for (int j = 0; j < 3; j++) {
+	if (fabs(vmin[j] - lo[j]) > BOOL_TOL || fabs(vmax[j] - hi[j]) > BOOL_TOL) {
+	    bu_log("%s: result vertices span (%g %g %g) - (%g %g %g), expected (%g %g %g) - (%g %g %g)\n",
+		   name, vmin.x, vmin.y, vmin.z, vmax.x, vmax.y, vmax.z, lo[0], lo[1], lo[2], hi[0], hi[1], hi[2]);
+	    ret = 1;
+	    break;
+	}
+    }
+
+    if (result)
+	*result = out;
+    else
+	delete out;
+    return ret;
+}
+
+
+int
+main(int UNUSED(argc), const char **argv)
+{
+    int ret = 0;
+    ON_Brep *out = NULL;
+
+    bu_setprogname(argv[0]);
+
+    ON_Brep *a = make_box(0, 0, 0, 2, 2, 2);
+    ON_Brep *b = make_box(1, 1, 1, 3, 3, 3);
+    ON_Brep *c = make_box(3.5, 0, 0, 4.5, 1, 1);
+    ON_Brep *s = make_sph(2, 2, 2, 1);
+
+    const double o0[3] = {0, 0, 0};
+    const double o1[3] = {1, 1, 1};
+    const double o2[3] = {2, 2, 2};
+    const double o3[3] = {3, 3, 3};
+    const double c1[3] = {4.5, 2, 2};
+
+    /* Disjoint inputs are handled without any intersections */
+    ret += check_bool("box u disjoint box", a, c, BOOLEAN_UNION, o0, c1, 12, NULL);
+    ret += check_bool("box + disjoint box", a, c, BOOLEAN_INTERSECT, NULL, NULL, 0, NULL);
+    ret += check_bool("box - disjoint box", a, c, BOOLEAN_DIFF, o0, o2, 6, NULL);
+
+    /* Boxes overlapping at a corner */
+    ret += check_bool("box u box", a, b, BOOLEAN_UNION, o0, o3, -1, NULL);
+    ret += check_bool("box + box", a, b, BOOLEAN_INTERSECT, o1, o2, 6, &out);
+    if (out) {
+	for (int i = 0; i < 8; i++) {
+	    double x = (i & 1) ? 2 : 1;
+	    double y = (i & 2) ? 2 : 1;
+	    double z = (i & 4) ? 2 : 1;
+	    if (!has_vertex(out, x, y, z)) {
+		bu_log("box + box: no vertex at corner (%g %g %g)\n", x, y, z);
+		ret++;
+	    }
+	}
+	delete out;
+	out = NULL;
+    }
+    ret += check_bool("box - box", a, b, BOOLEAN_DIFF, o0, o2, -1, &out);
+    if (out) {
+	/* the new, inside corner */
+	if (!has_vertex(out, 1, 1, 1)) {
+	    bu_log("box - box: no vertex at (1 1 1)\n");
+	    ret++;
+	}
+	delete out;
+	out = NULL;
+    }
+
+    /* A sphere centered on a box corner */
+    ret += check_bool("box u sph", a, s, BOOLEAN_UNION, o0, o3, -1, NULL);
+    ret += check_bool("box + sph", a, s, BOOLEAN_INTERSECT, o1, o2, -1, NULL);
+    ret += check_bool("box - sph", a, s, BOOLEAN_DIFF, o0, o2, -1, NULL);
+
+    delete a;
+    delete b;
+    delete c;
+    delete s;
+
+    return (ret) ? 1 : 0;
+}
+
+
+// Local Variables:
+// tab-width: 8
+// mode: C++
+// c-basic-offset: 4
+// indent-tabs-mode: t
+// c-file-style: "stroustrup"
+// End:
+// ex: shiftwidth=4 tabstop=8
@@ -0,0 +1,187 @@
+/*                 C D T _ T H R E A D S . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file cdt_threads.cpp
+ *
+ * The CDT triangulates faces and checks close edges in parallel.  The
+ * meshes it produces must be identical to the ones a single threaded
+ * run produces, both for one state at a time and for several states
+ * tessellated concurrently.
+ */
+
+#define NOMINMAX
+
+#include "common.h"
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "bu.h"
+#include "brep.h"
+#include "../cdt/cdt.h"
+
+struct cdt_result {
+    int ret = -1;
+    std::vector<int> faces;
+    std::vector<fastf_t> vertices;
+    std::vector<int> face_normals;
+    std::vector<fastf_t> normals;
+};
+
+
+static void
+tessellate(cdt_result *r, ON_Brep *brep, size_t max_threads)
+{
+    int fcnt = 0, fncnt = 0, ncnt = 0, vcnt = 0;
+    int *faces = NULL;
+    fastf_t *vertices = NULL;
+    int *face_normals = NULL;
+    fastf_t *normals = NULL;
+
+    struct bg_tess_tol ttol = BG_TESS_TOL_INIT_ZERO;
+    ttol.abs = 0.0;
+    ttol.rel = 0.01;
+    ttol.norm = 10.0;
+
+    struct ON_Brep_CDT_State *s_cdt = ON_Brep_CDT_Create((void *)brep, "cdt_threads");
+    s_cdt->max_threads = max_threads;
+    ON_Brep_CDT_Tol_Set(s_cdt, &ttol);
+    r->ret = ON_Brep_CDT_Tessellate(s_cdt, 0, NULL);
+    if (r->ret != -1) {
+	ON_Brep_CDT_Mesh(&faces, &fcnt, &vertices, &vcnt, &face_normals, &fncnt, &normals, &ncnt, s_cdt, 0, NULL);
+	if (faces)
+	    r->faces.assign(faces, faces + 3*fcnt);
+	if (vertices)
+	    r->vertices.assign(vertices, vertices + 3*vcnt);
+	if (face_normals)
+	    r->face_normals.assign(face_normals, face_normals + 3*fncnt);
+	if (normals)
+	    r->normals.assign(normals, normals + 3*ncnt);
+	if (faces)
+	    bu_free(faces, "faces");
+	if (vertices)
+	    bu_free(vertices, "vertices");
+	if (face_normals)
+	    bu_free(face_normals, "face_normals");
+	if (normals)
+	    bu_free(normals, "normals");
+    }
+    ON_Brep_CDT_Destroy(s_cdt);
+}
+
+
+static int
+compare(const char *name, const char *mode, const cdt_result &expected, const cdt_result &r)
+{
+    if (expected.ret != r.ret) {
+	bu_log("%s (%s): tessellation returned %d, serial returned %d\n", name, mode, r.ret, expected.ret);
+	return 1;
+    }
+    if (expected.faces != r.faces || expected.face_normals != r.face_normals) {
+	bu_log("%s (%s): faces differ from the serial tessellation (%zu vs %zu)\n", name, mode, r.faces.size()/3, expected.faces.size()/3);
+	return 1;
+    }
+    /* Bit for bit - these must be computed the same way, not just to within tolerance */
+    if (expected.vertices.size() != r.vertices.size() || expected.normals.size() != r.normals.size() ||
+	(r.vertices.size() && memcmp(expected.vertices.data(), r.vertices.data(), r.vertices.size() * sizeof(fastf_t))) ||
+	(r.normals.size() && memcmp(expected.normals.data(), r.normals.data(), r.normals.size() * sizeof(fastf_t)))) {
+	bu_log("%s (%s): vertices differ from the serial tessellation\n", name, mode);
+	return 1;
+    }
+    return 0;
+}
+
+
+int
+main(int UNUSED(argc), const char **argv)
+{
+    int ret = 0;
+
+    bu_setprogname(argv[0]);
+
+    std::vector<ON_Brep *> breps;
+    std::vector<const char *> names;
+
+    ON_Sphere sph(ON_3dPoint(0, 0, 0), 10);
+    breps.push_back(ON_BrepSphere(sph));
+    names.push_back("sphere");
+
+    ON_Circle circ(ON_Plane(ON_3dPoint(0, 0, 0), ON_3dVector(0, 0, 1)), 5);
+    ON_Cylinder cyl(circ, 20);
+    breps.push_back(ON_BrepCylinder(cyl, true, true));
+    names.push_back("cylinder");
+
+    /* Enough faces that the triangulation is actually spread across
+     * threads */
+    ON_Brep *boxes = ON_Brep::New();
+    for (int i = 0; i < 16; i++) {
+	double x = 3.0 * i;
+	ON_3dPoint c[8] = {
+	    ON_3dPoint(x, 0, 0), ON_3dPoint(x + 2, 0, 0), ON_3dPoint(x + 2, 2, 0), ON_3dPoint(x, 2, 0),
+	    ON_3dPoint(x, 0, 2), ON_3dPoint(x + 2, 0, 2), ON_3dPoint(x + 2, 2, 2), ON_3dPoint(x, 2, 2)
+	};
+	ON_Brep *box = ON_BrepBox(c);
+	boxes->Append(*box);
+	delete box;
+    }
+    breps.push_back(boxes);
+    names.push_back("boxes");
+
+    std::vector<cdt_result> serial(breps.size());
+    for (size_t i = 0; i < breps.size(); i++) {
+	tessellate(&serial[i], breps[i], 1);
+	if (serial[i].ret == -1 || !serial[i].faces.size()) {
+	    bu_log("%s: serial tessellation failed\n", names[i]);
+	    ret = 1;
+	}
+    }
+
+    /* One state at a time, using all available threads */
+    for (size_t i = 0; i < breps.size(); i++) {
+	cdt_result r;
+	tessellate(&r, breps[i], 0);
+	ret += compare(names[i], "parallel", serial[i], r);
+    }
+
+    /* All states at once - each state must only contend with itself */
+    std::vector<cdt_result> concurrent(breps.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < breps.size(); i++)
+	threads.push_back(std::thread(tessellate, &concurrent[i], breps[i], 0));
+    for (size_t i = 0; i < threads.size(); i++)
+	threads[i].join();
+    for (size_t i = 0; i < breps.size(); i++)
+	ret += compare(names[i], "concurrent", serial[i], concurrent[i]);
+
+    for (size_t i = 0; i < breps.size(); i++)
+	delete breps[i];
+
+    return (ret) ? 1 : 0;
+}
+
+
+// Local Variables:
+// tab-width: 8
+// mode: C++
+// c-basic-offset: 4
+// indent-tabs-mode: t
+// c-file-style: "stroustrup"
+// End:
+// ex: shiftwidth=4 tabstop=8
@@ -24,6 +24,7 @@
  */
 
 #include "common.h"
+#include <atomic>
 #include <string.h>
 #include "vmath.h"
 #include "bu/log.h"
@@ -1816,6 +1817,15 @@ bv_view_print(const char *title, struct bview *v, int UNUSED(verbosity))
     bu_log("  maxMousedelta:%f\n", v->gv_maxMouseDelta);
 }
 
+size_t
+bv_vlist_gen(void)
+{
+    // Threads may each be filling vlists from their own free list, so
+    // the counter has to be atomic
+    static std::atomic<size_t> gen(0);
+    return ++gen;
+}
+
 // Local Variables:
 // tab-width: 8
 // mode: C++
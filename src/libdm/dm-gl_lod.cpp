@@ -29,6 +29,8 @@
 #include <stdio.h>
 #include <math.h>
 #include <string.h>
+#include <utility>
+#include <vector>
 #include "vmath.h"
 #include "bu.h"
 #include "bn.h"
@@ -539,6 +541,196 @@ gl_csg_lod(struct dm *dmp, struct bv_scene_obj *s)
     return BRLCAD_OK;
 }
 
+/* Retained drawing of standard vlist objects.  Wireframe and point vlists
+ * are packed once into a float vertex array with GL_LINES and GL_POINTS
+ * index arrays, and each frame draws them with one glDrawElements call per
+ * primitive type instead of replaying every vlist command.  The arrays are
+ * OpenGL 1.1 client side vertex arrays rather than buffer objects, so they
+ * work with every context libdm creates (including swrast's OSMesa) and
+ * are not tied to the context that was current when they were built. */
+struct gl_retained {
+    std::vector<GLfloat> verts;
+    std::vector<GLuint> lines;
+    std::vector<GLuint> points;
+    GLfloat line_width = 0.0;
+    GLfloat point_size = 0.0;
+
+    /* The gen and nused of each vlist chunk the arrays were built from,
+     * to catch vlist changes that didn't clear s->current.  Chunk
+     * addresses can't be used for this - a vlist freed and rebuilt from
+     * the same free list gets the same chunks back. */
+    std::vector<std::pair<size_t, size_t>> chunks;
+};
+
+static void
+retained_free_callback(struct bv_scene_obj *s)
+{
+    if (!s || !s->draw_data)
+	return;
+    struct gl_retained *r = (struct gl_retained *)s->draw_data;
+    delete r;
+    s->draw_data = NULL;
+    s->s_dlist_stale = 0;
+}
+
+static bool
+retained_current(struct bv_scene_obj *s, struct gl_retained *r)
+{
+    if (!s->current || s->s_dlist_stale)
+	return false;
+    size_t i = 0;
+    struct bv_vlist *tvp;
+    for (BU_LIST_FOR(tvp, bv_vlist, &s->s_vlist)) {
+	if (i == r->chunks.size() || r->chunks[i].first != tvp->gen || r->chunks[i].second != tvp->nused)
+	    return false;
+	i++;
+    }
+    return (i == r->chunks.size());
+}
+
+/* Pack the vlist.  Returns false if it holds anything other than lines and
+ * points, or changes widths or sizes part way through, in which case the
+ * caller falls back to gl_drawVList. */
+static bool
+retained_build(struct bv_scene_obj *s, struct gl_retained *r)
+{
+    enum { R_NONE, R_LINE, R_POINT } state = R_NONE;
+    GLuint prev = 0;
+
+    r->verts.clear();
+    r->lines.clear();
+    r->points.clear();
+    r->chunks.clear();
+    r->line_width = r->point_size = 0.0;
+
+    struct bv_vlist *tvp;
+    for (BU_LIST_FOR(tvp, bv_vlist, &s->s_vlist)) {
+	int *cmd = tvp->cmd;
+	point_t *pt = tvp->pt;
+	r->chunks.push_back(std::make_pair(tvp->gen, tvp->nused));
+	for (size_t i = 0; i < tvp->nused; i++, cmd++, pt++) {
+	    GLuint ind = (GLuint)(r->verts.size() / 3);
+	    switch (*cmd) {
+		case BV_VLIST_LINE_MOVE:
+		    state = R_LINE;
+		    break;
+		case BV_VLIST_LINE_DRAW:
+		    // As with glBegin/glEnd, a draw continues whatever
+		    // primitive is open
+		    if (state == R_LINE) {
+			r->lines.push_back(prev);
+			r->lines.push_back(ind);
+		    } else if (state == R_POINT) {
+			r->points.push_back(ind);
+		    } else {
+			continue;
+		    }
+		    break;
+		case BV_VLIST_POINT_DRAW:
+		    state = R_POINT;
+		    r->points.push_back(ind);
+		    break;
+		case BV_VLIST_LINE_WIDTH:
+		    if ((*pt)[0] > 0.0) {
+			if (r->lines.size() && !NEAR_EQUAL(r->line_width, (*pt)[0], SMALL_FASTF))
+			    return false;
+			r->line_width = (GLfloat)(*pt)[0];
+		    }
+		    continue;
+		case BV_VLIST_POINT_SIZE:
+		    if ((*pt)[0] > 0.0) {
+			if (r->points.size() && !NEAR_EQUAL(r->point_size, (*pt)[0], SMALL_FASTF))
+			    return false;
+			r->point_size = (GLfloat)(*pt)[0];
+		    }
+		    continue;
+		default:
+		    return false;
+	    }
+	    if (ind == UINT32_MAX)
+		return false;
+	    r->verts.push_back((GLfloat)(*pt)[X]);
+	    r->verts.push_back((GLfloat)(*pt)[Y]);
+	    r->verts.push_back((GLfloat)(*pt)[Z]);
+	    prev = ind;
+	}
+    }
+
+    return true;
+}
+
+static int
+gl_draw_retained(struct dm *dmp, struct bv_scene_obj *s)
+{
+    struct gl_vars *mvars = (struct gl_vars *)dmp->i->m_vars;
+    static float black[4] = {0.0, 0.0, 0.0, 0.0};
+    GLfloat originalLineWidth, originalPointSize;
+
+    // Objects still being generated change from frame to frame, so only
+    // retain the ones their producers have marked current.
+    if (!s->current || s->s_dlist_stale) {
+	retained_free_callback(s);
+	return BRLCAD_ERROR;
+    }
+
+    struct gl_retained *r = (struct gl_retained *)s->draw_data;
+    if (!r || !retained_current(s, r)) {
+	// The packed arrays sit alongside the vlist, so don't build them if
+	// memory is short.
+	ssize_t avail_mem = 0.5*bu_mem(BU_MEM_AVAIL, NULL);
+	size_t size_est = bu_list_len(&s->s_vlist) * BV_VLIST_CHUNK * (3*sizeof(GLfloat) + 2*sizeof(GLuint));
+	if (avail_mem <= 0 || size_est > (size_t)avail_mem) {
+	    retained_free_callback(s);
+	    return BRLCAD_ERROR;
+	}
+	if (!r) {
+	    r = new gl_retained;
+	    s->draw_data = (void *)r;
+	    s->s_dlist_free_callback = &retained_free_callback;
+	}
+	if (!retained_build(s, r)) {
+	    retained_free_callback(s);
+	    return BRLCAD_ERROR;
+	}
+    }
+
+    gl_debug_print(dmp, "gl_draw_retained", dmp->i->dm_debugLevel);
+
+    glGetFloatv(GL_POINT_SIZE, &originalPointSize);
+    glGetFloatv(GL_LINE_WIDTH, &originalLineWidth);
+
+    if (mvars->lighting_on && r->verts.size()) {
+	glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, mvars->i.wireColor);
+	glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, black);
+	glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, black);
+	glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, black);
+	if (mvars->transparency_on)
+	    glDisable(GL_BLEND);
+    }
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, r->verts.data());
+    if (r->lines.size()) {
+	if (r->line_width > 0.0)
+	    glLineWidth(r->line_width);
+	glDrawElements(GL_LINES, (GLsizei)r->lines.size(), GL_UNSIGNED_INT, r->lines.data());
+    }
+    if (r->points.size()) {
+	if (r->point_size > 0.0)
+	    glPointSize(r->point_size);
+	glDrawElements(GL_POINTS, (GLsizei)r->points.size(), GL_UNSIGNED_INT, r->points.data());
+    }
+    glDisableClientState(GL_VERTEX_ARRAY);
+
+    if (mvars->lighting_on && mvars->transparency_on)
+	glDisable(GL_BLEND);
+
+    glPointSize(originalPointSize);
+    glLineWidth(originalLineWidth);
+
+    return BRLCAD_OK;
+}
+
 extern "C"
 int gl_draw_obj(struct dm *dmp, struct bv_scene_obj *s)
 {
@@ -552,10 +744,10 @@ int gl_draw_obj(struct dm *dmp, struct bv_scene_obj *s)
     }
 
     // "Standard" vlist object drawing
-    if (bu_list_len(&s->s_vlist)) {
+    if (BU_LIST_NON_EMPTY(&s->s_vlist)) {
 	if (s->s_os->s_dmode == 4) {
 	    dm_draw_vlist_hidden_line(dmp, (struct bv_vlist *)&s->s_vlist);
-	} else {
+	} else if (gl_draw_retained(dmp, s) != BRLCAD_OK) {
 	    dm_draw_vlist(dmp, (struct bv_vlist *)&s->s_vlist);
 	}
 	return BRLCAD_OK;
@@ -0,0 +1,238 @@
+/*                    R E T A I N E D . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file retained.cpp
+ *
+ * Objects marked current are drawn by the OpenGL display managers from
+ * retained vertex arrays.  Using the headless swrast display manager,
+ * check that the retained drawing matches the immediate mode vlist
+ * replay, and that it notices vlist edits made without clearing
+ * s->current - including a vlist rebuilt from the very chunks it was
+ * freed to.
+ */
+
+#include "common.h"
+
+#include <string.h>
+
+#include "vmath.h"
+#include "bu/app.h"
+#include "bu/log.h"
+#include "bu/malloc.h"
+#include "bv/defines.h"
+#include "bv/util.h"
+#include "bv/vlist.h"
+#include "dm.h"
+
+#define IMG_SIZE 256
+#define NLINES 40
+
+/* Both paths rasterize the same lines and points, but allow for a few
+ * pixels where line ends meet */
+#define MAX_DIFF_PIXELS 16
+
+static unsigned char *
+draw(struct dm *dmp, struct bv_scene_obj *s, int retained)
+{
+    unsigned char *img = NULL;
+    mat_t idn;
+
+    MAT_IDN(idn);
+    s->current = retained;
+
+    dm_draw_begin(dmp);
+    dm_loadmatrix(dmp, idn, 0);
+    dm_loadpmatrix(dmp, NULL);
+    dm_set_fg(dmp, 255, 255, 0, 0, 1.0);
+    dm_set_line_attr(dmp, 1, 0);
+    dm_draw_obj(dmp, s);
+    dm_draw_end(dmp);
+
+    dm_get_display_image(dmp, &img, 0, 0);
+    return img;
+}
+
+static size_t
+lit_pixels(const unsigned char *img)
+{
+    size_t cnt = 0;
+    for (size_t i = 0; i < IMG_SIZE * IMG_SIZE; i++) {
+	if (img[3*i] || img[3*i+1] || img[3*i+2])
+	    cnt++;
+    }
+    return cnt;
+}
+
+static size_t
+diff_pixels(const unsigned char *a, const unsigned char *b)
+{
+    size_t cnt = 0;
+    for (size_t i = 0; i < IMG_SIZE * IMG_SIZE; i++) {
+	if (memcmp(&a[3*i], &b[3*i], 3))
+	    cnt++;
+    }
+    return cnt;
+}
+
+/* A fan of lines, with a point at the end of each, offset by shift */
+static void
+make_vlist(struct bv_scene_obj *s, fastf_t shift)
+{
+    point_t p;
+
+    for (int i = 0; i < NLINES; i++) {
+	fastf_t t = -0.9 + 1.8 * i / (NLINES - 1);
+	VSET(p, shift - 0.5, 0.9 * t, 0);
+	BV_ADD_VLIST(s->vlfree, &s->s_vlist, p, BV_VLIST_LINE_MOVE);
+	VSET(p, shift + 0.5, -0.9 * t, 0);
+	BV_ADD_VLIST(s->vlfree, &s->s_vlist, p, BV_VLIST_LINE_DRAW);
+	VSET(p, shift + 0.6, -0.9 * t, 0);
+	BV_ADD_VLIST(s->vlfree, &s->s_vlist, p, BV_VLIST_POINT_DRAW);
+    }
+}
+
+/* Draw the object retained, twice so the second draw reuses the
+ * arrays, and compare both with the immediate mode replay */
+static int
+check(const char *stage, struct dm *dmp, struct bv_scene_obj *s, unsigned char **ref)
+{
+    int ret = 0;
+    unsigned char *r1 = draw(dmp, s, 1);
+    unsigned char *r2 = draw(dmp, s, 1);
+    *ref = draw(dmp, s, 0);
+
+    if (lit_pixels(*ref) < NLINES) {
+	bu_log("%s: nothing drawn\n", stage);
+	ret++;
+    }
+    size_t d1 = diff_pixels(r1, *ref);
+    size_t d2 = diff_pixels(r2, *ref);
+    if (d1 > MAX_DIFF_PIXELS || d2 > MAX_DIFF_PIXELS) {
+	bu_log("%s: retained drawing differs from the vlist in %zu and %zu pixels\n", stage, d1, d2);
+	ret++;
+    }
+
+    bu_free(r1, "image");
+    bu_free(r2, "image");
+    return ret;
+}
+
+int
+main(int UNUSED(argc), const char **argv)
+{
+    struct bview *v;
+    struct dm *dmp;
+    struct bv_scene_obj *s;
+    unsigned char *ref1, *ref2, *ref3;
+    const char *acmd = "attach";
+    int ret = 0;
+
+    bu_setprogname(argv[0]);
+
+    BU_GET(v, struct bview);
+    bv_init(v, NULL);
+    v->gv_width = IMG_SIZE;
+    v->gv_height = IMG_SIZE;
+
+    dmp = dm_open((void *)v, NULL, "swrast", 1, &acmd);
+    if (!dmp)
+	bu_exit(1, "ERROR: unable to open the swrast display manager\n");
+    v->dmp = dmp;
+    dm_set_width(dmp, IMG_SIZE);
+    dm_set_height(dmp, IMG_SIZE);
+    dm_configure_win(dmp, 0);
+    dm_set_zbuffer(dmp, 1);
+    fastf_t windowbounds[6] = { -1, 1, -1, 1, -100, 100 };
+    dm_set_win_bounds(dmp, windowbounds);
+
+    s = bv_obj_get(v, BV_VIEW_OBJS | BV_LOCAL_OBJS);
+    make_vlist(s, 0.0);
+    ret += check("initial", dmp, s, &ref1);
+
+    /* Rebuild the vlist in place, without clearing s->current, after
+     * a retained draw has built the arrays.  With nothing else on the
+     * free list the same chunks come back in the same order, with the
+     * same counts. */
+    struct bu_list *first = BU_LIST_FIRST(bu_list, &s->s_vlist);
+    unsigned char *r = draw(dmp, s, 1);
+    bu_free(r, "image");
+    BV_FREE_VLIST(s->vlfree, &s->s_vlist);
+    make_vlist(s, 0.3);
+    if (BU_LIST_FIRST(bu_list, &s->s_vlist) != first)
+	bu_log("note: vlist chunks were not reused\n");
+    r = draw(dmp, s, 1);
+    ref2 = draw(dmp, s, 0);
+    if (diff_pixels(ref1, ref2) <= MAX_DIFF_PIXELS) {
+	bu_log("rebuilt: the test geometry didn't change the image\n");
+	ret++;
+    }
+    if (diff_pixels(r, ref2) > MAX_DIFF_PIXELS) {
+	bu_log("rebuilt: retained drawing wasn't updated for a rebuilt vlist\n");
+	ret++;
+    }
+    bu_free(r, "image");
+    bu_free(ref2, "image");
+    ret += check("rebuilt", dmp, s, &ref2);
+
+    /* Append to the last chunk, again leaving s->current set.  The
+     * check above finished with an immediate mode draw, so draw once
+     * retained to build the arrays first. */
+    r = draw(dmp, s, 1);
+    bu_free(r, "image");
+    point_t p;
+    VSET(p, -0.9, -0.9, 0);
+    BV_ADD_VLIST(s->vlfree, &s->s_vlist, p, BV_VLIST_LINE_MOVE);
+    VSET(p, 0.9, 0.9, 0);
+    BV_ADD_VLIST(s->vlfree, &s->s_vlist, p, BV_VLIST_LINE_DRAW);
+    r = draw(dmp, s, 1);
+    ref3 = draw(dmp, s, 0);
+    if (diff_pixels(r, ref3) > MAX_DIFF_PIXELS) {
+	bu_log("appended: retained drawing wasn't updated for an appended line\n");
+	ret++;
+    }
+    bu_free(r, "image");
+
+    /* An explicit stale flag forces a rebuild as well */
+    s->s_dlist_stale = 1;
+    bu_free(ref3, "image");
+    ret += check("flagged stale", dmp, s, &ref3);
+
+    bu_free(ref1, "image");
+    bu_free(ref2, "image");
+    bu_free(ref3, "image");
+
+    bv_obj_put(s);
+    dm_close(dmp);
+    v->dmp = NULL;
+    bv_free(v);
+    BU_PUT(v, struct bview);
+
+    if (ret)
+	bu_log("%d retained drawing checks failed\n", ret);
+    return (ret) ? 1 : 0;
+}
+
+// Local Variables:
+// tab-width: 8
+// mode: C++
+// c-basic-offset: 4
+// indent-tabs-mode: t
+// c-file-style: "stroustrup"
+// End:
+// ex: shiftwidth=4 tabstop=8
@@ -0,0 +1,619 @@
+/*                       F F T P L A N . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file libfft/fftplan.c
+ *
+ * Planned transforms of any length.
+ *
+ * A plan factors the length into radix 4, 2, 3 and larger prime
+ * stages and precomputes the input permutation and every twiddle
+ * factor, so executing it is nothing but butterflies.  The transform
+ * is an in-place mixed radix decimation in time: the permutation puts
+ * each sub-sequence in its own block, and stage s combines r(s) blocks
+ * of length m into one of length m*r(s).  Within a stage the innermost
+ * loops run over consecutive elements, which compilers vectorize.
+ *
+ * Real transforms of even length run a complex transform of half the
+ * length on the even/odd samples packed as one complex signal and
+ * untangle the halves afterwards.
+ *
+ * Plans are never modified once created, so one plan may be executed
+ * from any number of threads at once.
+ */
+
+#include "common.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>	/* for stderr */
+
+#include "fft.h"
+
+
+#define FFT_MAXSTAGES 32	/* enough for any int length */
+#define FFT_STACK_RADIX 32	/* larger generic radices use heap scratch */
+
+struct fft_plan {
+    int n;			/* transform length */
+    int flags;			/* FFT_REAL or 0 */
+    int cn;			/* length of the complex transform run */
+    int nstages;
+    int radix[FFT_MAXSTAGES];	/* stage radices, first stage first */
+    int twoff[FFT_MAXSTAGES];	/* offset of each stage's twiddles in tw */
+    int maxr;			/* largest generic (not 2, 3, 4) radix */
+    int *cycles;		/* permutation cycles, each ended by -1 */
+    COMPLEX *tw;		/* stage twiddles, [(q-1)*m + j] per stage */
+    COMPLEX *roots;		/* roots of unity of each generic radix */
+    int *rootoff;		/* offset of each stage's roots, or -1 */
+    COMPLEX *rtw;		/* even real: exp(-2 pi i k/n), k <= n/4 */
+};
+
+
+static void
+cexpi(COMPLEX *c, double num, double den)
+{
+    double theta = -2.0 * M_PI * num / den;
+    c->re = cos(theta);
+    c->im = sin(theta);
+}
+
+
+static int
+plan_factor(struct fft_plan *p)
+{
+    int n = p->cn;
+    int f;
+
+    p->nstages = 0;
+    while (n % 4 == 0) {
+	p->radix[p->nstages++] = 4;
+	n /= 4;
+    }
+    if (n % 2 == 0) {
+	p->radix[p->nstages++] = 2;
+	n /= 2;
+    }
+    for (f = 3; n > 1; f += 2) {
+	if ((long)f * f > n)
+	    f = n;		/* what is left is prime */
+	while (n % f == 0) {
+	    if (p->nstages >= FFT_MAXSTAGES)
+		return 0;
+	    p->radix[p->nstages++] = f;
+	    n /= f;
+	}
+    }
+    return 1;
+}
+
+
+/*
+ * Element i of the input belongs at position pos(i), where the last
+ * stage's radix is the most significant digit of i's reversal.  Store
+ * the permutation as cycles of the gather src[pos(i)] = i.
+ */
+static int
+plan_permutation(struct fft_plan *p)
+{
+    int n = p->cn;
+    int i, j, s, ncyc = 0;
+    int *src = (int *)calloc(n, sizeof(int));
+    char *done = (char *)calloc(n, 1);
+
+    if (!src || !done) {
+	free(src);
+	free(done);
+	return 0;
+    }
+
+    for (i = 0; i < n; i++) {
+	int x = i, size = n, pos = 0;
+	for (s = p->nstages - 1; s >= 0; s--) {
+	    size /= p->radix[s];
+	    pos += (x % p->radix[s]) * size;
+	    x /= p->radix[s];
+	}
+	src[pos] = i;
+    }
+
+    /* Worst case is n/2 two element cycles, each with its terminator */
+    p->cycles = (int *)calloc(n + n/2 + 1, sizeof(int));
+    if (!p->cycles) {
+	free(src);
+	free(done);
+	return 0;
+    }
+    for (i = 0; i < n; i++) {
+	if (done[i] || src[i] == i)
+	    continue;
+	for (j = i; !done[j]; j = src[j]) {
+	    p->cycles[ncyc++] = j;
+	    done[j] = 1;
+	}
+	p->cycles[ncyc++] = -1;
+    }
+    p->cycles[ncyc] = -1;	/* empty cycle ends the list */
+
+    free(src);
+    free(done);
+    return 1;
+}
+
+
+static int
+plan_twiddles(struct fft_plan *p)
+{
+    int s, j, q, m = 1, ntw = 0, nroots = 0;
+
+    for (s = 0; s < p->nstages; s++) {
+	int r = p->radix[s];
+	p->twoff[s] = ntw;
+	ntw += (r - 1) * m;
+	if (r != 2 && r != 3 && r != 4) {
+	    nroots += r;
+	    if (r > p->maxr)
+		p->maxr = r;
+	}
+	m *= r;
+    }
+
+    p->tw = (COMPLEX *)calloc(ntw + 1, sizeof(COMPLEX));
+    p->roots = (COMPLEX *)calloc(nroots + 1, sizeof(COMPLEX));
+    p->rootoff = (int *)calloc(p->nstages + 1, sizeof(int));
+    if (!p->tw || !p->roots || !p->rootoff)
+	return 0;
+
+    m = 1;
+    nroots = 0;
+    for (s = 0; s < p->nstages; s++) {
+	int r = p->radix[s];
+	COMPLEX *tw = p->tw + p->twoff[s];
+	for (q = 1; q < r; q++) {
+	    for (j = 0; j < m; j++)
+		cexpi(&tw[(q-1)*m + j], (double)j * q, (double)m * r);
+	}
+	p->rootoff[s] = -1;
+	if (r != 2 && r != 3 && r != 4) {
+	    p->rootoff[s] = nroots;
+	    for (q = 0; q < r; q++)
+		cexpi(&p->roots[nroots + q], q, r);
+	    nroots += r;
+	}
+	m *= r;
+    }
+
+    return 1;
+}
+
+
+struct fft_plan *
+fft_plan_create(int n, int flags)
+{
+    struct fft_plan *p;
+    int k;
+
+    if (n < 1) {
+	fprintf(stderr, "fft: can't plan a transform of length %d\n", n);
+	return NULL;
+    }
+
+    /* should not use bu_calloc() as libfft is not dependent upon libbu */
+    p = (struct fft_plan *)calloc(1, sizeof(struct fft_plan));
+    if (!p)
+	return NULL;
+    p->n = n;
+    p->flags = flags & FFT_REAL;
+    p->cn = (p->flags && n % 2 == 0) ? n / 2 : n;
+
+    if (!plan_factor(p) || !plan_permutation(p) || !plan_twiddles(p)) {
+	fft_plan_destroy(p);
+	return NULL;
+    }
+
+    if (p->flags && n % 2 == 0) {
+	p->rtw = (COMPLEX *)calloc(n / 4 + 1, sizeof(COMPLEX));
+	if (!p->rtw) {
+	    fft_plan_destroy(p);
+	    return NULL;
+	}
+	for (k = 0; k <= n / 4; k++)
+	    cexpi(&p->rtw[k], k, n);
+    }
+
+    return p;
+}
+
+
+void
+fft_plan_destroy(struct fft_plan *p)
+{
+    if (!p)
+	return;
+    free(p->cycles);
+    free(p->tw);
+    free(p->roots);
+    free(p->rootoff);
+    free(p->rtw);
+    free(p);
+}
+
+
+int
+fft_plan_size(const struct fft_plan *p)
+{
+    return (p) ? p->n : 0;
+}
+
+
+static void
+stage_radix2(COMPLEX *a, int n, int m, const COMPLEX *tw, double sgn)
+{
+    int b, j;
+    for (b = 0; b < n; b += 2*m) {
+	COMPLEX *a0 = a + b;
+	COMPLEX *a1 = a0 + m;
+	for (j = 0; j < m; j++) {
+	    double wr = tw[j].re, wi = sgn * tw[j].im;
+	    double tr = wr * a1[j].re - wi * a1[j].im;
+	    double ti = wr * a1[j].im + wi * a1[j].re;
+	    a1[j].re = a0[j].re - tr;
+	    a1[j].im = a0[j].im - ti;
+	    a0[j].re += tr;
+	    a0[j].im += ti;
+	}
+    }
+}
+
+
+static void
+stage_radix3(COMPLEX *a, int n, int m, const COMPLEX *tw, double sgn)
+{
+    const double s3 = sgn * 0.86602540378443864676372317075294;
+    int b, j;
+    for (b = 0; b < n; b += 3*m) {
+	COMPLEX *a0 = a + b;
+	COMPLEX *a1 = a0 + m;
+	COMPLEX *a2 = a1 + m;
+	for (j = 0; j < m; j++) {
+	    double w1r = tw[j].re, w1i = sgn * tw[j].im;
+	    double w2r = tw[m + j].re, w2i = sgn * tw[m + j].im;
+	    double t1r = w1r * a1[j].re - w1i * a1[j].im;
+	    double t1i = w1r * a1[j].im + w1i * a1[j].re;
+	    double t2r = w2r * a2[j].re - w2i * a2[j].im;
+	    double t2i = w2r * a2[j].im + w2i * a2[j].re;
+	    double sr = t1r + t2r, si = t1i + t2i;
+	    double dr = t1r - t2r, di = t1i - t2i;
+	    double mr = a0[j].re - 0.5 * sr, mi = a0[j].im - 0.5 * si;
+	    a0[j].re += sr;
+	    a0[j].im += si;
+	    /* (-i s3) * d */
+	    a1[j].re = mr + s3 * di;
+	    a1[j].im = mi - s3 * dr;
+	    a2[j].re = mr - s3 * di;
+	    a2[j].im = mi + s3 * dr;
+	}
+    }
+}
+
+
+static void
+stage_radix4(COMPLEX *a, int n, int m, const COMPLEX *tw, double sgn)
+{
+    int b, j;
+    for (b = 0; b < n; b += 4*m) {
+	COMPLEX *a0 = a + b;
+	COMPLEX *a1 = a0 + m;
+	COMPLEX *a2 = a1 + m;
+	COMPLEX *a3 = a2 + m;
+	for (j = 0; j < m; j++) {
+	    double w1r = tw[j].re, w1i = sgn * tw[j].im;
+	    double w2r = tw[m + j].re, w2i = sgn * tw[m + j].im;
+	    double w3r = tw[2*m + j].re, w3i = sgn * tw[2*m + j].im;
+	    double t1r = w1r * a1[j].re - w1i * a1[j].im;
+	    double t1i = w1r * a1[j].im + w1i * a1[j].re;
+	    double t2r = w2r * a2[j].re - w2i * a2[j].im;
+	    double t2i = w2r * a2[j].im + w2i * a2[j].re;
+	    double t3r = w3r * a3[j].re - w3i * a3[j].im;
+	    double t3i = w3r * a3[j].im + w3i * a3[j].re;
+	    double s0r = a0[j].re + t2r, s0i = a0[j].im + t2i;
+	    double d0r = a0[j].re - t2r, d0i = a0[j].im - t2i;
+	    double s1r = t1r + t3r, s1i = t1i + t3i;
+	    double d1r = t1r - t3r, d1i = t1i - t3i;
+	    a0[j].re = s0r + s1r;
+	    a0[j].im = s0i + s1i;
+	    a2[j].re = s0r - s1r;
+	    a2[j].im = s0i - s1i;
+	    /* (-i sgn) * d1 */
+	    a1[j].re = d0r + sgn * d1i;
+	    a1[j].im = d0i - sgn * d1r;
+	    a3[j].re = d0r - sgn * d1i;
+	    a3[j].im = d0i + sgn * d1r;
+	}
+    }
+}
+
+
+static void
+stage_generic(COMPLEX *a, int n, int m, int r, const COMPLEX *tw, const COMPLEX *roots, double sgn, COMPLEX *t)
+{
+    int b, j, q, k;
+    for (b = 0; b < n; b += r*m) {
+	for (j = 0; j < m; j++) {
+	    COMPLEX *aj = a + b + j;
+	    t[0] = aj[0];
+	    for (q = 1; q < r; q++) {
+		double wr = tw[(q-1)*m + j].re, wi = sgn * tw[(q-1)*m + j].im;
+		t[q].re = wr * aj[q*m].re - wi * aj[q*m].im;
+		t[q].im = wr * aj[q*m].im + wi * aj[q*m].re;
+	    }
+	    for (k = 0; k < r; k++) {
+		double sr = t[0].re, si = t[0].im;
+		int p = 0;
+		for (q = 1; q < r; q++) {
+		    double wr, wi;
+		    p += k;
+		    if (p >= r)
+			p -= r;
+		    wr = roots[p].re;
+		    wi = sgn * roots[p].im;
+		    sr += wr * t[q].re - wi * t[q].im;
+		    si += wr * t[q].im + wi * t[q].re;
+		}
+		aj[k*m].re = sr;
+		aj[k*m].im = si;
+	    }
+	}
+    }
+}
+
+
+/* Unscaled complex transform of length p->cn, in place */
+static void
+plan_run(const struct fft_plan *p, COMPLEX *a, int dir)
+{
+    double sgn = (dir == FFT_INVERSE) ? -1.0 : 1.0;
+    COMPLEX tbuf[FFT_STACK_RADIX];
+    COMPLEX *t = tbuf;
+    const int *c = p->cycles;
+    int s, m = 1;
+
+    /* Gather into digit reversed order, a cycle at a time */
+    while (*c >= 0) {
+	COMPLEX tmp = a[c[0]];
+	for (; c[1] >= 0; c++)
+	    a[c[0]] = a[c[1]];
+	a[c[0]] = tmp;
+	c += 2;
+    }
+
+    if (p->maxr > FFT_STACK_RADIX) {
+	t = (COMPLEX *)malloc(p->maxr * sizeof(COMPLEX));
+	if (!t) {
+	    fprintf(stderr, "fft: out of memory\n");
+	    return;
+	}
+    }
+
+    for (s = 0; s < p->nstages; s++) {
+	int r = p->radix[s];
+	const COMPLEX *tw = p->tw + p->twoff[s];
+	switch (r) {
+	    case 2:
+		stage_radix2(a, p->cn, m, tw, sgn);
+		break;
+	    case 3:
+		stage_radix3(a, p->cn, m, tw, sgn);
+		break;
+	    case 4:
+		stage_radix4(a, p->cn, m, tw, sgn);
+		break;
+	    default:
+		stage_generic(a, p->cn, m, r, tw, p->roots + p->rootoff[s], sgn, t);
+	}
+	m *= r;
+    }
+
+    if (t != tbuf)
+	free(t);
+}
+
+
+static void
+plan_scale(COMPLEX *a, int n, double scale)
+{
+    int i;
+    for (i = 0; i < n; i++) {
+	a[i].re *= scale;
+	a[i].im *= scale;
+    }
+}
+
+
+void
+fft_plan_exec(const struct fft_plan *p, COMPLEX *dat, int dir)
+{
+    if (!p || !dat)
+	return;
+    if (p->flags) {
+	fprintf(stderr, "fft: fft_plan_exec() needs a complex plan\n");
+	return;
+    }
+    plan_run(p, dat, dir);
+    if (dir == FFT_INVERSE)
+	plan_scale(dat, p->n, 1.0 / p->n);
+}
+
+
+void
+fft_plan_rexec(const struct fft_plan *p, const double *in, COMPLEX *out)
+{
+    int n, h, k;
+
+    if (!p || !in || !out)
+	return;
+    if (!p->flags) {
+	fprintf(stderr, "fft: fft_plan_rexec() needs a real plan\n");
+	return;
+    }
+    n = p->n;
+    h = n / 2;
+
+    if (n % 2) {
+	COMPLEX *z = (COMPLEX *)malloc(n * sizeof(COMPLEX));
+	if (!z) {
+	    fprintf(stderr, "fft: out of memory\n");
+	    return;
+	}
+	for (k = 0; k < n; k++) {
+	    z[k].re = in[k];
+	    z[k].im = 0.0;
+	}
+	plan_run(p, z, FFT_FORWARD);
+	memcpy(out, z, (h + 1) * sizeof(COMPLEX));
+	free(z);
+	return;
+    }
+
+    /* Transform even samples as the real part and odd as the imaginary */
+    if ((const void *)in != (void *)out)
+	memmove(out, in, n * sizeof(double));
+    plan_run(p, out, FFT_FORWARD);
+
+    /* X[k] = E[k] + w^k O[k], X[h-k] = conj(E[k] - w^k O[k]) */
+    {
+	double z0r = out[0].re, z0i = out[0].im;
+	out[0].re = z0r + z0i;
+	out[0].im = 0.0;
+	out[h].re = z0r - z0i;
+	out[h].im = 0.0;
+    }
+    for (k = 1; k <= h / 2; k++) {
+	COMPLEX zk = out[k], zc = out[h - k];
+	double er = 0.5 * (zk.re + zc.re), ei = 0.5 * (zk.im - zc.im);
+	double or_ = 0.5 * (zk.im + zc.im), oi = -0.5 * (zk.re - zc.re);
+	double wr = p->rtw[k].re, wi = p->rtw[k].im;
+	double tr = wr * or_ - wi * oi, ti = wr * oi + wi * or_;
+	out[k].re = er + tr;
+	out[k].im = ei + ti;
+	out[h - k].re = er - tr;
+	out[h - k].im = -(ei - ti);
+    }
+}
+
+
+void
+fft_plan_irexec(const struct fft_plan *p, const COMPLEX *in, double *out)
+{
+    int n, h, k;
+
+    if (!p || !in || !out)
+	return;
+    if (!p->flags) {
+	fprintf(stderr, "fft: fft_plan_irexec() needs a real plan\n");
+	return;
+    }
+    n = p->n;
+    h = n / 2;
+
+    if (n % 2) {
+	COMPLEX *z = (COMPLEX *)malloc(n * sizeof(COMPLEX));
+	if (!z) {
+	    fprintf(stderr, "fft: out of memory\n");
+	    return;
+	}
+	for (k = 0; k <= h; k++)
+	    z[k] = in[k];
+	for (k = h + 1; k < n; k++) {
+	    z[k].re = in[n - k].re;
+	    z[k].im = -in[n - k].im;
+	}
+	plan_run(p, z, FFT_INVERSE);
+	for (k = 0; k < n; k++)
+	    out[k] = z[k].re / n;
+	free(z);
+	return;
+    }
+
+    /* Rebuild the packed half length spectrum Z[k] = E[k] + i O[k] */
+    {
+	COMPLEX *z = (COMPLEX *)out;
+	double x0 = in[0].re, xh = in[h].re;
+	for (k = 1; k <= h / 2; k++) {
+	    COMPLEX xk = in[k], xc = in[h - k];
+	    double er = 0.5 * (xk.re + xc.re), ei = 0.5 * (xk.im - xc.im);
+	    double dr = 0.5 * (xk.re - xc.re), di = 0.5 * (xk.im + xc.im);
+	    /* O = d * conj(w^k) */
+	    double wr = p->rtw[k].re, wi = -p->rtw[k].im;
+	    double or_ = dr * wr - di * wi, oi = dr * wi + di * wr;
+	    z[k].re = er - oi;
+	    z[k].im = ei + or_;
+	    z[h - k].re = er + oi;
+	    z[h - k].im = -ei + or_;
+	}
+	z[0].re = 0.5 * (x0 + xh);
+	z[0].im = 0.5 * (x0 - xh);
+
+	plan_run(p, z, FFT_INVERSE);
+	plan_scale(z, h, 1.0 / h);
+    }
+}
+
+
+void
+fft_plan_exec_batch(const struct fft_plan *p, COMPLEX *dat, size_t count, int dir)
+{
+    size_t i;
+    if (!p || !dat)
+	return;
+    for (i = 0; i < count; i++)
+	fft_plan_exec(p, dat + i * p->n, dir);
+}
+
+
+void
+fft_plan_rexec_batch(const struct fft_plan *p, const double *in, COMPLEX *out, size_t count)
+{
+    size_t i;
+    if (!p || !in || !out)
+	return;
+    for (i = 0; i < count; i++)
+	fft_plan_rexec(p, in + i * p->n, out + i * (p->n / 2 + 1));
+}
+
+
+void
+fft_plan_irexec_batch(const struct fft_plan *p, const COMPLEX *in, double *out, size_t count)
+{
+    size_t i;
+    if (!p || !in || !out)
+	return;
+    for (i = 0; i < count; i++)
+	fft_plan_irexec(p, in + i * (p->n / 2 + 1), out + i * p->n);
+}
+
+
+/*
+ * Local Variables:
+ * mode: C
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
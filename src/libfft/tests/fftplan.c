@@ -0,0 +1,273 @@
+/*                      F F T P L A N . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file libfft/tests/fftplan.c
+ *
+ * Planned transforms must match a direct DFT.  Every length from 1 to
+ * 300 is checked, covering primes, odd and even composites and powers
+ * of two, along with a few larger lengths of each kind.  Complex,
+ * real and batched transforms are all checked, both directions.
+ */
+
+#include "common.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "fft.h"
+
+#define MAX_SMALL 300
+#define BATCH 3
+
+/* Errors relative to the size of the data */
+#define TOL 1.0e-11
+
+static const int large[] = {512, 1000, 1009, 2310, 4096, 4099, 6144, 0};
+
+static unsigned long seed = 1;
+
+static double
+rnd(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return (double)((seed >> 16) & 0x7fff) / 16384.0 - 1.0;
+}
+
+/* The DFT, summed directly.  The twiddle angles are taken mod n from a
+ * table, so they stay exact for large n. */
+static void
+dft(const COMPLEX *in, COMPLEX *out, int n, int dir)
+{
+    double *c = (double *)malloc(n * sizeof(double));
+    double *s = (double *)malloc(n * sizeof(double));
+    int j, k, m;
+
+    for (m = 0; m < n; m++) {
+	c[m] = cos(2.0 * M_PI * m / n);
+	s[m] = dir * sin(2.0 * M_PI * m / n);
+    }
+
+    for (k = 0; k < n; k++) {
+	double re = 0.0, im = 0.0;
+	for (j = 0, m = 0; j < n; j++) {
+	    re += in[j].re * c[m] - in[j].im * s[m];
+	    im += in[j].re * s[m] + in[j].im * c[m];
+	    m += k;
+	    if (m >= n)
+		m -= n;
+	}
+	if (dir == FFT_INVERSE) {
+	    re /= n;
+	    im /= n;
+	}
+	out[k].re = re;
+	out[k].im = im;
+    }
+
+    free(c);
+    free(s);
+}
+
+static double
+max_err(const COMPLEX *a, const COMPLEX *b, int n)
+{
+    double err = 0.0;
+    int i;
+
+    for (i = 0; i < n; i++) {
+	double e = fabs(a[i].re - b[i].re) + fabs(a[i].im - b[i].im);
+	if (e > err)
+	    err = e;
+    }
+    return err;
+}
+
+static int
+check(int n, const char *what, double err, double scale)
+{
+    if (err > TOL * scale) {
+	printf("n = %d: %s error %g\n", n, what, err);
+	return 1;
+    }
+    return 0;
+}
+
+static int
+check_complex(int n)
+{
+    struct fft_plan *p = fft_plan_create(n, 0);
+    COMPLEX *x = (COMPLEX *)malloc(n * BATCH * sizeof(COMPLEX));
+    COMPLEX *y = (COMPLEX *)malloc(n * BATCH * sizeof(COMPLEX));
+    COMPLEX *ref = (COMPLEX *)malloc(n * sizeof(COMPLEX));
+    double scale = 0.0;
+    int i, b, ret = 0;
+
+    if (!p || fft_plan_size(p) != n) {
+	printf("n = %d: bad complex plan\n", n);
+	ret = 1;
+	goto done;
+    }
+
+    for (i = 0; i < n * BATCH; i++) {
+	x[i].re = rnd();
+	x[i].im = rnd();
+    }
+    for (i = 0; i < n; i++)
+	scale += fabs(x[i].re) + fabs(x[i].im);
+
+    /* forward */
+    for (i = 0; i < n; i++)
+	y[i] = x[i];
+    fft_plan_exec(p, y, FFT_FORWARD);
+    dft(x, ref, n, FFT_FORWARD);
+    ret += check(n, "forward", max_err(y, ref, n), scale);
+
+    /* inverse, which scales by 1/n */
+    for (i = 0; i < n; i++)
+	y[i] = x[i];
+    fft_plan_exec(p, y, FFT_INVERSE);
+    dft(x, ref, n, FFT_INVERSE);
+    ret += check(n, "inverse", max_err(y, ref, n), scale / n);
+
+    /* a batch is the same as its members done one at a time */
+    for (i = 0; i < n * BATCH; i++)
+	y[i] = x[i];
+    fft_plan_exec_batch(p, y, BATCH, FFT_FORWARD);
+    for (b = 0; b < BATCH; b++) {
+	dft(x + b * n, ref, n, FFT_FORWARD);
+	ret += check(n, "batch forward", max_err(y + b * n, ref, n), scale);
+    }
+    fft_plan_exec_batch(p, y, BATCH, FFT_INVERSE);
+    ret += check(n, "batch round trip", max_err(y, x, n * BATCH), scale / n);
+
+done:
+    if (p)
+	fft_plan_destroy(p);
+    free(x);
+    free(y);
+    free(ref);
+    return ret;
+}
+
+static int
+check_real(int n)
+{
+    struct fft_plan *p = fft_plan_create(n, FFT_REAL);
+    int nb = n / 2 + 1;
+    double *x = (double *)malloc(n * BATCH * sizeof(double));
+    double *y = (double *)malloc(n * BATCH * sizeof(double));
+    COMPLEX *cx = (COMPLEX *)calloc(n, sizeof(COMPLEX));
+    COMPLEX *ref = (COMPLEX *)malloc(n * sizeof(COMPLEX));
+    COMPLEX *spec = (COMPLEX *)malloc(nb * BATCH * sizeof(COMPLEX));
+    double scale = 0.0, err;
+    int i, b, ret = 0;
+
+    if (!p || fft_plan_size(p) != n) {
+	printf("n = %d: bad real plan\n", n);
+	ret = 1;
+	goto done;
+    }
+
+    for (i = 0; i < n * BATCH; i++)
+	x[i] = rnd();
+    for (i = 0; i < n; i++)
+	scale += fabs(x[i]);
+
+    /* forward, against the first n/2+1 bins of the complex DFT */
+    for (i = 0; i < n; i++) {
+	cx[i].re = x[i];
+	cx[i].im = 0.0;
+    }
+    dft(cx, ref, n, FFT_FORWARD);
+    fft_plan_rexec(p, x, spec);
+    ret += check(n, "real forward", max_err(spec, ref, nb), scale);
+
+    /* inverse, back to the input */
+    fft_plan_irexec(p, spec, y);
+    err = 0.0;
+    for (i = 0; i < n; i++)
+	err = (fabs(y[i] - x[i]) > err) ? fabs(y[i] - x[i]) : err;
+    ret += check(n, "real round trip", err, scale / n);
+
+    /* batches */
+    fft_plan_rexec_batch(p, x, spec, BATCH);
+    for (b = 0; b < BATCH; b++) {
+	for (i = 0; i < n; i++) {
+	    cx[i].re = x[b * n + i];
+	    cx[i].im = 0.0;
+	}
+	dft(cx, ref, n, FFT_FORWARD);
+	ret += check(n, "real batch forward", max_err(spec + b * nb, ref, nb), scale);
+    }
+    fft_plan_irexec_batch(p, spec, y, BATCH);
+    err = 0.0;
+    for (i = 0; i < n * BATCH; i++)
+	err = (fabs(y[i] - x[i]) > err) ? fabs(y[i] - x[i]) : err;
+    ret += check(n, "real batch round trip", err, scale / n);
+
+done:
+    if (p)
+	fft_plan_destroy(p);
+    free(x);
+    free(y);
+    free(cx);
+    free(ref);
+    free(spec);
+    return ret;
+}
+
+int
+main(int ac, char *av[])
+{
+    int n, i, ret = 0;
+
+    if (ac > 1) {
+	fprintf(stderr, "Usage: %s\n", av[0]);
+	return 1;
+    }
+
+    if (fft_plan_create(0, 0) != NULL) {
+	printf("fft_plan_create accepted a length of 0\n");
+	ret++;
+    }
+
+    for (n = 1; n <= MAX_SMALL; n++) {
+	ret += check_complex(n);
+	ret += check_real(n);
+    }
+    for (i = 0; large[i]; i++) {
+	ret += check_complex(large[i]);
+	ret += check_real(large[i]);
+    }
+
+    if (ret)
+	printf("%d planned transform checks failed\n", ret);
+    return (ret) ? 1 : 0;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
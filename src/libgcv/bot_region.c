@@ -0,0 +1,454 @@
+/*                    B O T _ R E G I O N . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file libgcv/bot_region.c
+ *
+ * Tree walk for mesh writers that hands regions made of a single BoT
+ * straight to the writer, instead of converting the BoT to NMG,
+ * evaluating a trivial boolean and triangulating it again.
+ *
+ */
+
+#include "common.h"
+
+#include <string.h>
+
+#include "bu/parallel.h"
+#include "bg/trimesh.h"
+#include "rt/db_internal.h"
+#include "rt/db_io.h"
+#include "rt/global.h"
+#include "rt/resource.h"
+#include "rt/rt_instance.h"
+#include "rt/primitives/bot.h"
+#include "raytrace.h"
+#include "gcv.h"
+
+
+/* How deeply nested combs below a region are followed looking for the
+ * BoT before giving up and leaving the region to the normal path */
+#define GCV_BOT_MAX_DEPTH 32
+
+
+struct gcv_bot_task {
+    struct db_full_path path;
+    struct db_tree_state ts;
+    struct directory *dp;	/* the BoT */
+    mat_t mat;			/* accumulated transform to apply to it */
+
+    /* filled in by the loaders */
+    int ok;
+    int empty;			/* every face was degenerate */
+    struct gcv_bot_region region;
+};
+
+
+struct gcv_walk_state {
+    int (*reg_start_func)(struct db_tree_state *, const struct db_full_path *, const struct rt_comb_internal *, void *);
+    union tree *(*reg_end_func)(struct db_tree_state *, const struct db_full_path *, union tree *, void *);
+    union tree *(*leaf_func)(struct db_tree_state *, const struct db_full_path *, struct rt_db_internal *, void *);
+    void *client_data;
+
+    struct db_i *dbip;
+    struct bu_ptbl tasks;
+
+    /* per-batch loader state */
+    struct resource *res;
+    size_t batch_start;
+    size_t batch_end;
+    size_t next;
+};
+
+
+/*
+ * Report whether a BoT can be written directly: rt_bot_tess() refuses
+ * plate mode BoTs, so those (and anything that can't be checked, like
+ * v4 databases) are left to the normal path.  Only the mode byte at
+ * the start of the body is looked at; the BoT isn't imported.
+ */
+static int
+_gcv_bot_usable(struct db_i *dbip, struct directory *dp)
+{
+    struct bu_external ext = BU_EXTERNAL_INIT_ZERO;
+    struct db5_raw_internal raw;
+    const unsigned char *buf = NULL;
+    int mode = -1;
+
+    if (db_version(dbip) < 5)
+	return 0;
+
+    /* Read in place when the object is already in memory */
+    if (dp->d_flags & RT_DIR_INMEM) {
+	buf = (const unsigned char *)dp->d_un.ptr;
+    } else if (dbip->dbi_mf && dp->d_addr != RT_DIR_PHONY_ADDR && (size_t)(dp->d_addr + dp->d_len) <= dbip->dbi_mf->buflen) {
+	buf = (const unsigned char *)dbip->dbi_mf->buf + dp->d_addr;
+    } else {
+	if (db_get_external(&ext, dp, dbip) < 0)
+	    return 0;
+	buf = ext.ext_buf;
+    }
+
+    /* num_vertices, num_faces, orientation, then mode */
+    if (db5_get_raw_internal_ptr(&raw, buf) && raw.body.ext_nbytes > 2 * SIZEOF_NETWORK_LONG + 1)
+	mode = raw.body.ext_buf[2 * SIZEOF_NETWORK_LONG + 1];
+
+    if (ext.ext_buf)
+	bu_free_external(&ext);
+
+    return (mode == RT_BOT_SOLID || mode == RT_BOT_SURFACE);
+}
+
+
+/*
+ * Find the single BoT a comb tree reduces to.  Returns the number of
+ * leaves found (only 1 is useful to the caller), or -1 if the tree
+ * holds anything other than unions of combs and BoTs.
+ */
+static int
+_gcv_find_bot(struct db_i *dbip, const union tree *tp, const mat_t mat, int depth, struct directory **bot_dp, mat_t bot_mat)
+{
+    struct directory *dp;
+    struct rt_db_internal intern;
+    struct rt_comb_internal *comb;
+    mat_t nmat;
+    int lcnt, rcnt;
+
+    if (!tp)
+	return 0;
+
+    switch (tp->tr_op) {
+	case OP_UNION:
+	    lcnt = _gcv_find_bot(dbip, tp->tr_b.tb_left, mat, depth, bot_dp, bot_mat);
+	    if (lcnt < 0 || lcnt > 1)
+		return -1;
+	    rcnt = _gcv_find_bot(dbip, tp->tr_b.tb_right, mat, depth, bot_dp, bot_mat);
+	    if (rcnt < 0 || lcnt + rcnt > 1)
+		return -1;
+	    return lcnt + rcnt;
+	case OP_DB_LEAF:
+	    break;
+	default:
+	    /* Anything else needs a real boolean evaluation */
+	    return -1;
+    }
+
+    dp = db_lookup(dbip, tp->tr_l.tl_name, LOOKUP_QUIET);
+    if (dp == RT_DIR_NULL)
+	return -1;
+
+    if (tp->tr_l.tl_mat)
+	bn_mat_mul(nmat, mat, tp->tr_l.tl_mat);
+    else
+	MAT_COPY(nmat, mat);
+
+    if (!(dp->d_flags & RT_DIR_COMB)) {
+	if (dp->d_major_type != DB5_MAJORTYPE_BRLCAD || dp->d_minor_type != DB5_MINORTYPE_BRLCAD_BOT)
+	    return -1;
+	if (!_gcv_bot_usable(dbip, dp))
+	    return -1;
+	*bot_dp = dp;
+	MAT_COPY(bot_mat, nmat);
+	return 1;
+    }
+
+    if (depth >= GCV_BOT_MAX_DEPTH)
+	return -1;
+    if (rt_db_get_internal(&intern, dp, dbip, NULL, &rt_uniresource) < 0)
+	return -1;
+    comb = (struct rt_comb_internal *)intern.idb_ptr;
+    RT_CK_COMB(comb);
+    lcnt = _gcv_find_bot(dbip, comb->tree, nmat, depth + 1, bot_dp, bot_mat);
+    rt_db_free_internal(&intern);
+    return lcnt;
+}
+
+
+/* Called during the (serial) first pass of db_walk_tree */
+static int
+_gcv_walk_region_start(struct db_tree_state *tsp, const struct db_full_path *pathp, const struct rt_comb_internal *combp, void *client_data)
+{
+    struct gcv_walk_state *ws = (struct gcv_walk_state *)client_data;
+    struct gcv_bot_task *t;
+    struct directory *bot_dp = RT_DIR_NULL;
+    mat_t bot_mat;
+
+    if (ws->reg_start_func) {
+	int ret = ws->reg_start_func(tsp, pathp, combp, ws->client_data);
+	if (ret < 0)
+	    return ret;
+    }
+
+    /* Regions used in a subtraction or intersection above this point
+     * are left to the normal path */
+    if (tsp->ts_sofar & (TS_SOFAR_MINUS|TS_SOFAR_INTER))
+	return 0;
+
+    if (_gcv_find_bot(ws->dbip, combp->tree, tsp->ts_mat, 0, &bot_dp, bot_mat) != 1)
+	return 0;
+
+    BU_GET(t, struct gcv_bot_task);
+    memset(t, 0, sizeof(struct gcv_bot_task));
+    db_full_path_init(&t->path);
+    db_dup_full_path(&t->path, pathp);
+    db_dup_db_tree_state(&t->ts, tsp);
+    t->dp = bot_dp;
+    MAT_COPY(t->mat, bot_mat);
+    bu_ptbl_ins(&ws->tasks, (long *)t);
+
+    /* Handled here - keep db_walk_tree from tessellating it */
+    return -1;
+}
+
+
+static union tree *
+_gcv_walk_region_end(struct db_tree_state *tsp, const struct db_full_path *pathp, union tree *curtree, void *client_data)
+{
+    struct gcv_walk_state *ws = (struct gcv_walk_state *)client_data;
+    return ws->reg_end_func(tsp, pathp, curtree, ws->client_data);
+}
+
+
+static union tree *
+_gcv_walk_leaf(struct db_tree_state *tsp, const struct db_full_path *pathp, struct rt_db_internal *ip, void *client_data)
+{
+    struct gcv_walk_state *ws = (struct gcv_walk_state *)client_data;
+    return ws->leaf_func(tsp, pathp, ip, ws->client_data);
+}
+
+
+static void
+_gcv_bot_load(struct gcv_bot_task *t, struct db_i *dbip, struct resource *resp)
+{
+    struct rt_db_internal intern;
+    struct rt_bot_internal *bot;
+    size_t i, nfaces;
+
+    /* The import applies the matrix to the vertices */
+    if (rt_db_get_internal(&intern, t->dp, dbip, t->mat, resp) < 0)
+	return;
+    if (intern.idb_major_type != DB5_MAJORTYPE_BRLCAD || intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_BOT) {
+	rt_db_free_internal(&intern);
+	return;
+    }
+    bot = (struct rt_bot_internal *)intern.idb_ptr;
+    RT_BOT_CK_MAGIC(bot);
+
+    if (!bot->num_faces || !bot->faces || !bot->vertices) {
+	rt_db_free_internal(&intern);
+	return;
+    }
+
+    /* Drop the faces rt_bot_tess() skips: those with bad vertex
+     * indices and those degenerate at the tree state's tolerance */
+    nfaces = 0;
+    for (i = 0; i < bot->num_faces; i++) {
+	const int *f = &bot->faces[i*3];
+	if (f[0] < 0 || f[1] < 0 || f[2] < 0
+	    || (size_t)f[0] >= bot->num_vertices || (size_t)f[1] >= bot->num_vertices || (size_t)f[2] >= bot->num_vertices)
+	    continue;
+	if (!bg_3pnts_distinct(&bot->vertices[f[0]*3], &bot->vertices[f[1]*3], &bot->vertices[f[2]*3], t->ts.ts_tol)
+	    || bg_3pnts_collinear(&bot->vertices[f[0]*3], &bot->vertices[f[1]*3], &bot->vertices[f[2]*3], t->ts.ts_tol))
+	    continue;
+	if (nfaces != i)
+	    VMOVE(&bot->faces[nfaces*3], f);
+	nfaces++;
+    }
+    bot->num_faces = nfaces;
+    if (!bot->num_faces) {
+	/* Nothing left to write, which isn't an error */
+	rt_db_free_internal(&intern);
+	t->empty = 1;
+	return;
+    }
+
+    /* Match what rt_bot_tess() produces: clockwise BoTs are reversed,
+     * and unoriented solids are made consistent and outward facing */
+    if (bot->orientation == RT_BOT_CW) {
+	for (i = 0; i < bot->num_faces; i++) {
+	    int tmp = bot->faces[i*3+1];
+	    bot->faces[i*3+1] = bot->faces[i*3+2];
+	    bot->faces[i*3+2] = tmp;
+	}
+    } else if (bot->mode == RT_BOT_SOLID && bot->orientation == RT_BOT_UNORIENTED) {
+	fastf_t vol = 0.0;
+	(void)bg_trimesh_sync(bot->faces, bot->faces, (int)bot->num_faces);
+	for (i = 0; i < bot->num_faces; i++) {
+	    vect_t c;
+	    const fastf_t *v0 = &bot->vertices[bot->faces[i*3+0]*3];
+	    const fastf_t *v1 = &bot->vertices[bot->faces[i*3+1]*3];
+	    const fastf_t *v2 = &bot->vertices[bot->faces[i*3+2]*3];
+	    VCROSS(c, v1, v2);
+	    vol += VDOT(v0, c);
+	}
+	if (vol < 0.0) {
+	    for (i = 0; i < bot->num_faces; i++) {
+		int tmp = bot->faces[i*3+1];
+		bot->faces[i*3+1] = bot->faces[i*3+2];
+		bot->faces[i*3+2] = tmp;
+	    }
+	}
+    }
+
+    /* Take the arrays rather than copying them */
+    t->region.num_vertices = bot->num_vertices;
+    t->region.vertices = bot->vertices;
+    t->region.num_faces = bot->num_faces;
+    t->region.faces = bot->faces;
+    bot->vertices = NULL;
+    bot->faces = NULL;
+    bot->num_vertices = 0;
+    bot->num_faces = 0;
+    rt_db_free_internal(&intern);
+
+    t->region.pathp = &t->path;
+    t->region.tsp = &t->ts;
+    t->ok = 1;
+}
+
+
+static void
+_gcv_bot_load_worker(int cpu, void *data)
+{
+    struct gcv_walk_state *ws = (struct gcv_walk_state *)data;
+
+    while (1) {
+	size_t i;
+
+	bu_semaphore_acquire(BU_SEM_GENERAL);
+	i = ws->next++;
+	bu_semaphore_release(BU_SEM_GENERAL);
+	if (i >= ws->batch_end)
+	    break;
+
+	_gcv_bot_load((struct gcv_bot_task *)BU_PTBL_GET(&ws->tasks, i), ws->dbip, &ws->res[cpu]);
+    }
+}
+
+
+static void
+_gcv_bot_task_free(struct gcv_bot_task *t)
+{
+    if (t->region.vertices)
+	bu_free((void *)t->region.vertices, "BOT vertices");
+    if (t->region.faces)
+	bu_free((void *)t->region.faces, "BOT faces");
+    db_free_full_path(&t->path);
+    db_free_db_tree_state(&t->ts);
+    BU_PUT(t, struct gcv_bot_task);
+}
+
+
+int
+gcv_walk_tree(struct db_i *dbip,
+	      int argc,
+	      const char **argv,
+	      int ncpu,
+	      const struct db_tree_state *init_state,
+	      int (*reg_start_func)(struct db_tree_state *, const struct db_full_path *, const struct rt_comb_internal *, void *),
+	      union tree *(*reg_end_func)(struct db_tree_state *, const struct db_full_path *, union tree *, void *),
+	      union tree *(*leaf_func)(struct db_tree_state *, const struct db_full_path *, struct rt_db_internal *, void *),
+	      void (*bot_func)(const struct gcv_bot_region *, void *),
+	      void *client_data)
+{
+    struct gcv_walk_state ws;
+    size_t threads, batch, i;
+    int ret;
+
+    RT_CK_DBI(dbip);
+
+    if (!bot_func)
+	return db_walk_tree(dbip, argc, argv, ncpu, init_state, reg_start_func, reg_end_func, leaf_func, client_data);
+
+    memset(&ws, 0, sizeof(ws));
+    ws.reg_start_func = reg_start_func;
+    ws.reg_end_func = reg_end_func;
+    ws.leaf_func = leaf_func;
+    ws.client_data = client_data;
+    ws.dbip = dbip;
+    bu_ptbl_init(&ws.tasks, 64, "gcv bot regions");
+
+    ret = db_walk_tree(dbip, argc, argv, ncpu, init_state,
+		       _gcv_walk_region_start,
+		       (reg_end_func) ? _gcv_walk_region_end : NULL,
+		       (leaf_func) ? _gcv_walk_leaf : NULL,
+		       (void *)&ws);
+
+    if (!BU_PTBL_LEN(&ws.tasks)) {
+	bu_ptbl_free(&ws.tasks);
+	return ret;
+    }
+
+    /* Load the BoTs a batch at a time, in parallel, and hand them to
+     * the writer in walk order.  Batching bounds how many meshes are
+     * held in memory at once. */
+    threads = bu_avail_cpus();
+    if (threads > MAX_PSW)
+	threads = MAX_PSW;
+    ws.res = (struct resource *)bu_calloc(threads, sizeof(struct resource), "gcv bot resources");
+    for (i = 0; i < threads; i++)
+	rt_init_resource(&ws.res[i], (int)i, NULL);
+
+    batch = threads * 4;
+    for (ws.batch_start = 0; ws.batch_start < BU_PTBL_LEN(&ws.tasks); ws.batch_start = ws.batch_end) {
+	size_t bthreads;
+
+	ws.batch_end = ws.batch_start + batch;
+	if (ws.batch_end > BU_PTBL_LEN(&ws.tasks))
+	    ws.batch_end = BU_PTBL_LEN(&ws.tasks);
+	ws.next = ws.batch_start;
+
+	bthreads = ws.batch_end - ws.batch_start;
+	if (bthreads > threads)
+	    bthreads = threads;
+	if (bthreads > 1)
+	    bu_parallel(_gcv_bot_load_worker, bthreads, (void *)&ws);
+	else
+	    _gcv_bot_load_worker(0, (void *)&ws);
+
+	for (i = ws.batch_start; i < ws.batch_end; i++) {
+	    struct gcv_bot_task *t = (struct gcv_bot_task *)BU_PTBL_GET(&ws.tasks, i);
+	    if (t->ok) {
+		bot_func(&t->region, client_data);
+	    } else if (!t->empty) {
+		char *sofar = db_path_to_string(&t->path);
+		bu_log("gcv_walk_tree: unable to read BoT %s in region %s\n", t->dp->d_namep, sofar);
+		bu_free(sofar, "path string");
+	    }
+	    _gcv_bot_task_free(t);
+	}
+    }
+
+    for (i = 0; i < threads; i++)
+	rt_clean_resource_basic(NULL, &ws.res[i]);
+    bu_free(ws.res, "gcv bot resources");
+    bu_ptbl_free(&ws.tasks);
+
+    return ret;
+}
+
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
@@ -161,6 +161,15 @@ struct gfi_t {
 
 
 /* triangle indices type */
+/* Direct lookup table from libobj indexes to their position in a
+ * unique index array (uvi, uvni or utvi), covering min..min+len-1 */
+struct index_rank_t {
+    size_t *rank;        /* NULL when the unique array must be searched instead */
+    size_t min;
+    size_t len;
+};
+
+
 struct ti_t {
     void *index_arr_tri; /* triangle indices into vertex, normal, texture vertex lists */
     size_t num_tri;      /* number of triangles represented by index_arr_triangles */
@@ -175,6 +184,9 @@ struct ti_t {
     size_t num_uvi;      /* number of unique triangle vertex indexes in uvi array */
     size_t num_uvni;     /* number of unique triangle vertex normal index in uvni array */
     size_t num_utvi;     /* number of unique triangle texture vertex index in utvi array */
+    struct index_rank_t vr;   /* rank table for uvi */
+    struct index_rank_t vnr;  /* rank table for uvni */
+    struct index_rank_t tvr;  /* rank table for utvi */
     unsigned char bot_mode;        /* bot mode RT_BOT_PLATE, RT_BOT_PLATE_NOCOS, RT_BOT_SOLID, RT_BOT_SURFACE */
     fastf_t *bot_vertices;         /* array of floats for bot vertices [bot_num_vertices*3] */
     fastf_t *bot_thickness;        /* array of floats for face thickness [bot_num_faces] */
@@ -1562,6 +1574,129 @@ create_unique_indexes(struct ti_t *ti)
 }
 
 
+/*
+ * Build the sorted unique array of one kind of libobj index (the
+ * entries at offset 'off' of every 'stride' entries of
+ * ti->index_arr_tri) along with a table giving the position of each
+ * index in it.  The indexes used by a face grouping usually cover a
+ * compact range, so this takes two linear passes instead of a sort.
+ * Returns non-zero, allocating nothing, if the range is too sparse
+ * for a table to be worthwhile.
+ */
+static int
+create_unique_rank(struct ti_t *ti, size_t stride, size_t off, size_t **uniq, size_t *num_uniq, struct index_rank_t *r)
+{
+    size_t num_indexes = ti->num_tri * 3;
+    size_t *tmp_arr = (size_t *)ti->index_arr_tri;
+    size_t idx;
+    size_t min, max;
+
+    min = max = tmp_arr[off];
+    for (idx = 1; idx < num_indexes; idx++) {
+	size_t v = tmp_arr[idx * stride + off];
+	if (v < min)
+	    min = v;
+	if (v > max)
+	    max = v;
+    }
+    if (max - min > 4 * num_indexes + 1024)
+	return 1;
+
+    r->min = min;
+    r->len = max - min + 1;
+    r->rank = (size_t *)bu_calloc(r->len, sizeof(size_t), "index rank");
+
+    /* mark the indexes used, then number them in ascending order */
+    for (idx = 0; idx < num_indexes; idx++)
+	r->rank[tmp_arr[idx * stride + off] - min] = 1;
+    *num_uniq = 0;
+    for (idx = 0; idx < r->len; idx++) {
+	if (r->rank[idx])
+	    r->rank[idx] = ++(*num_uniq);
+    }
+
+    /* unused slots get an out of range rank */
+    *uniq = (size_t *)bu_calloc(*num_uniq, sizeof(size_t), "unique index array");
+    for (idx = 0; idx < r->len; idx++) {
+	if (r->rank[idx]) {
+	    r->rank[idx]--;
+	    (*uniq)[r->rank[idx]] = idx + min;
+	} else {
+	    r->rank[idx] = *num_uniq;
+	}
+    }
+
+    return 0;
+}
+
+
+/*
+ * Equivalent of populate_sort_indexes, sort_indexes and
+ * create_unique_indexes that also leaves rank tables for
+ * create_bot_int_arrays to look indexes up in.  Returns non-zero,
+ * having allocated nothing, if any of the index ranges is too sparse
+ * - the caller should then use the sorting route.
+ */
+int
+create_unique_indexes_ranked(struct ti_t *ti)
+{
+    size_t stride = 1;
+    size_t tv_off = 1;
+    size_t vn_off = 1;
+
+    if (ti->tri_type == FACE_TV || ti->tri_type == FACE_NV)
+	stride = 2;
+    if (ti->tri_type == FACE_TNV) {
+	stride = 3;
+	vn_off = 2;
+    }
+
+    if (create_unique_rank(ti, stride, 0, &ti->uvi, &ti->num_uvi, &ti->vr))
+	return 1;
+
+    if (ti->tri_type == FACE_NV || ti->tri_type == FACE_TNV) {
+	if (create_unique_rank(ti, stride, vn_off, &ti->uvni, &ti->num_uvni, &ti->vnr)) {
+	    bu_free(ti->uvi, "ti->uvi");
+	    bu_free(ti->vr.rank, "ti->vr.rank");
+	    ti->vr.rank = NULL;
+	    return 1;
+	}
+    }
+
+    if (ti->tri_type == FACE_TV || ti->tri_type == FACE_TNV) {
+	if (create_unique_rank(ti, stride, tv_off, &ti->utvi, &ti->num_utvi, &ti->tvr)) {
+	    bu_free(ti->uvi, "ti->uvi");
+	    bu_free(ti->vr.rank, "ti->vr.rank");
+	    ti->vr.rank = NULL;
+	    if (ti->vnr.rank) {
+		bu_free(ti->uvni, "ti->uvni");
+		bu_free(ti->vnr.rank, "ti->vnr.rank");
+		ti->vnr.rank = NULL;
+	    }
+	    return 1;
+	}
+    }
+
+    return 0;
+}
+
+
+/*
+ * Find the position of libobj index 'v' in the sorted unique index
+ * array 'uniq', from the rank table if there is one.  Returns NULL if
+ * it isn't there.
+ */
+static const size_t *
+unique_index_find(size_t v, const size_t *uniq, size_t num_uniq, const struct index_rank_t *r)
+{
+    if (!r->rank)
+	return (const size_t *)bsearch(&v, uniq, num_uniq, sizeof(size_t), (int (*)(const void *a, const void *b))comp_b);
+    if (v < r->min || v - r->min >= r->len || r->rank[v - r->min] >= num_uniq)
+	return NULL;
+    return &uniq[r->rank[v - r->min]];
+}
+
+
 /*
  * Free memory allocated for the contents of the triangle index
  * structure.
@@ -1701,7 +1836,7 @@ create_bot_float_arrays(struct ga_t *ga,
  * function and is expected to be freed once the bot primitive is
  * created. The unique sorted-indexes are freed by this function once
  * they are no longer needed. This function returns a non-zero value
- * (i.e. fails) if bsearch is unable to find a value. This function
+ * (i.e. fails) if an index can not be found. This function
  * should never fail unless there is a logic bug in this code.
  */
 int
@@ -1709,9 +1844,9 @@ create_bot_int_arrays(struct ti_t *ti)
 {
     size_t i = 0;
     size_t j = 0;
-    size_t *res_v = 0;
-    size_t *res_n = 0;
-    size_t *res_t = 0;
+    const size_t *res_v = 0;
+    const size_t *res_n = 0;
+    const size_t *res_t = 0;
 
     tri_arr_1D_t index_arr_tri_1D = NULL;
     tri_arr_2D_t index_arr_tri_2D = NULL;
@@ -1734,12 +1869,10 @@ create_bot_int_arrays(struct ti_t *ti)
 	index_arr_tri_1D = (tri_arr_1D_t)ti->index_arr_tri;
 	for (i = 0 ; i < ti->bot_num_faces ; i++) {
 	    for (j = 0 ; j < 3 ; j++) {
-		if ((res_v = (size_t *)bsearch(&(index_arr_tri_1D[i][j]),
-					       ti->uvi, ti->num_uvi, sizeof(size_t),
-					       (int (*)(const void *a, const void *b))comp_b)) ==
+		if ((res_v = unique_index_find(index_arr_tri_1D[i][j], ti->uvi, ti->num_uvi, &ti->vr)) ==
 		    (size_t *)NULL)
 		{
-		    bu_log("ERROR: FACE_V bsearch returned null, "
+		    bu_log("ERROR: FACE_V lookup returned null, "
 			   "face=(%zu)idx=(%zu)\n", i, j);
 		    return 1;
 		} else {
@@ -1754,20 +1887,17 @@ create_bot_int_arrays(struct ti_t *ti)
 	index_arr_tri_2D = (tri_arr_2D_t)ti->index_arr_tri;
 	for (i = 0 ; i < ti->bot_num_faces ; i++) {
 	    for (j = 0 ; j < 3 ; j++) {
-		if ((res_v = (size_t *)bsearch(&(index_arr_tri_2D[i][j][0]),
-					       ti->uvi, ti->num_uvi, sizeof(size_t),
-					       (int (*)(const void *a, const void *b))comp_b)) ==
+		if ((res_v = unique_index_find(index_arr_tri_2D[i][j][0], ti->uvi, ti->num_uvi, &ti->vr)) ==
 		    (size_t *)NULL)
 		{
-		    bu_log("ERROR: FACE_TV bsearch returned vertex null, "
+		    bu_log("ERROR: FACE_TV lookup returned vertex null, "
 			   "face=(%zu)idx=(%zu)\n", i, j);
 		    return 1;
 		} else {
 		    ti->bot_faces[(i*3)+j] = (int)(res_v - ti->uvi);
 		}
-		if ((res_t = (size_t*)bsearch(&(index_arr_tri_2D[i][j][1]), ti->utvi, ti->num_utvi, sizeof(size_t),
-					      (int (*)(const void *a, const void *b))comp_b)) == (size_t *)NULL) {
-		    bu_log("ERROR: FACE_TV bsearch returned texture null, face=(%zu)idx=(%zu)\n", i, j);
+		if ((res_t = unique_index_find(index_arr_tri_2D[i][j][1], ti->utvi, ti->num_utvi, &ti->tvr)) == (size_t *)NULL) {
+		    bu_log("ERROR: FACE_TV lookup returned texture null, face=(%zu)idx=(%zu)\n", i, j);
 		    return 1;
 		} else {
 		    ti->bot_textures[(i*3)+j] = (int)(res_t - ti->utvi);
@@ -1782,16 +1912,14 @@ create_bot_int_arrays(struct ti_t *ti)
 	index_arr_tri_2D = (tri_arr_2D_t)ti->index_arr_tri;
 	for (i = 0 ; i < ti->bot_num_faces ; i++) {
 	    for (j = 0 ; j < 3 ; j++) {
-		if ((res_v = (size_t*)bsearch(&(index_arr_tri_2D[i][j][0]), ti->uvi, ti->num_uvi, sizeof(size_t),
-					      (int (*)(const void *a, const void *b))comp_b)) == (size_t *)NULL) {
-		    bu_log("ERROR: FACE_NV bsearch returned vertex null, face=(%zu)idx=(%zu)\n", i, j);
+		if ((res_v = unique_index_find(index_arr_tri_2D[i][j][0], ti->uvi, ti->num_uvi, &ti->vr)) == (size_t *)NULL) {
+		    bu_log("ERROR: FACE_NV lookup returned vertex null, face=(%zu)idx=(%zu)\n", i, j);
 		    return 1;
 		} else {
 		    ti->bot_faces[(i*3)+j] = (int)(res_v - ti->uvi);
 		}
-		if ((res_n = (size_t*)bsearch(&(index_arr_tri_2D[i][j][1]), ti->uvni, ti->num_uvni, sizeof(size_t),
-					      (int (*)(const void *a, const void *b))comp_b)) == (size_t *)NULL) {
-		    bu_log("ERROR: FACE_NV bsearch returned normal null, face=(%zu)idx=(%zu)\n", i, j);
+		if ((res_n = unique_index_find(index_arr_tri_2D[i][j][1], ti->uvni, ti->num_uvni, &ti->vnr)) == (size_t *)NULL) {
+		    bu_log("ERROR: FACE_NV lookup returned normal null, face=(%zu)idx=(%zu)\n", i, j);
 		    return 1;
 		} else {
 		    ti->bot_face_normals[(i*3)+j] = (int)(res_n - ti->uvni);
@@ -1806,23 +1934,20 @@ create_bot_int_arrays(struct ti_t *ti)
 	index_arr_tri_3D = (tri_arr_3D_t)ti->index_arr_tri;
 	for (i = 0 ; i < ti->bot_num_faces ; i++) {
 	    for (j = 0 ; j < 3 ; j++) {
-		if ((res_v = (size_t*)bsearch(&(index_arr_tri_3D[i][j][0]), ti->uvi, ti->num_uvi, sizeof(size_t),
-					      (int (*)(const void *a, const void *b))comp_b)) == (size_t *)NULL) {
-		    bu_log("ERROR: FACE_TNV bsearch returned vertex null, face=(%zu)idx=(%zu)\n", i, j);
+		if ((res_v = unique_index_find(index_arr_tri_3D[i][j][0], ti->uvi, ti->num_uvi, &ti->vr)) == (size_t *)NULL) {
+		    bu_log("ERROR: FACE_TNV lookup returned vertex null, face=(%zu)idx=(%zu)\n", i, j);
 		    return 1;
 		} else {
 		    ti->bot_faces[(i*3)+j] = (int)(res_v - ti->uvi);
 		}
-		if ((res_t = (size_t*)bsearch(&(index_arr_tri_3D[i][j][1]), ti->utvi, ti->num_utvi, sizeof(size_t),
-					      (int (*)(const void *a, const void *b))comp_b)) == (size_t *)NULL) {
-		    bu_log("ERROR: FACE_TNV bsearch returned texture null, face=(%zu)idx=(%zu)\n", i, j);
+		if ((res_t = unique_index_find(index_arr_tri_3D[i][j][1], ti->utvi, ti->num_utvi, &ti->tvr)) == (size_t *)NULL) {
+		    bu_log("ERROR: FACE_TNV lookup returned texture null, face=(%zu)idx=(%zu)\n", i, j);
 		    return 1;
 		} else {
 		    ti->bot_textures[(i*3)+j] = (int)(res_t - ti->utvi);
 		}
-		if ((res_n = (size_t*)bsearch(&(index_arr_tri_3D[i][j][2]), ti->uvni, ti->num_uvni, sizeof(size_t),
-					      (int (*)(const void *a, const void *b))comp_b)) == (size_t *)NULL) {
-		    bu_log("ERROR: FACE_TNV bsearch returned normal null, face=(%zu)idx=(%zu)\n", i, j);
+		if ((res_n = unique_index_find(index_arr_tri_3D[i][j][2], ti->uvni, ti->num_uvni, &ti->vnr)) == (size_t *)NULL) {
+		    bu_log("ERROR: FACE_TNV lookup returned normal null, face=(%zu)idx=(%zu)\n", i, j);
 		    return 1;
 		} else {
 		    ti->bot_face_normals[(i*3)+j] = (int)(res_n - ti->uvni);
@@ -1833,6 +1958,13 @@ create_bot_int_arrays(struct ti_t *ti)
 	bu_free(ti->utvi, "ti->utvi");
 	bu_free(ti->uvni, "ti->uvni");
     }
+
+    /* free the rank tables, if create_unique_indexes_ranked made them */
+    bu_free(ti->vr.rank, "ti->vr.rank");
+    bu_free(ti->vnr.rank, "ti->vnr.rank");
+    bu_free(ti->tvr.rank, "ti->tvr.rank");
+    ti->vr.rank = ti->vnr.rank = ti->tvr.rank = NULL;
+
     return 0;
 }
 
@@ -2477,6 +2609,9 @@ output_to_bot(struct ga_t *ga,
     ti.num_uvi = 0;                  /* number of unique triangle vertex indexes in uvi array */
     ti.num_uvni = 0;                 /* number of unique triangle vertex normal index in uvni array */
     ti.num_utvi = 0;                 /* number of unique triangle texture vertex index in utvi array */
+    ti.vr.rank = (size_t *)NULL;     /* rank table for uvi */
+    ti.vnr.rank = (size_t *)NULL;    /* rank table for uvni */
+    ti.tvr.rank = (size_t *)NULL;    /* rank table for utvi */
     ti.bot_mode = 0;                 /* bot mode RT_BOT_PLATE, RT_BOT_PLATE_NOCOS, RT_BOT_SOLID,
 				      * RT_BOT_SURFACE
 				      */
@@ -2524,11 +2659,13 @@ output_to_bot(struct ga_t *ga,
 	return 0;
     }
 
-    populate_sort_indexes(&ti);
+    if (create_unique_indexes_ranked(&ti)) {
+	populate_sort_indexes(&ti);
 
-    sort_indexes(&ti);
+	sort_indexes(&ti);
 
-    create_unique_indexes(&ti);
+	create_unique_indexes(&ti);
+    }
 
     create_bot_float_arrays(ga, &ti, bot_thickness, conv_factor);
 
@@ -34,6 +34,7 @@
 
 #include "raytrace.h"
 #include "gcv/api.h"
+#include "gcv/util.h"
 
 #define V3ARGS_SCALE(v, factor)       (v)[X] * (factor), (v)[Y] * (factor), (v)[Z] * (factor)
 
@@ -477,6 +478,69 @@ do_region_end(struct db_tree_state *tsp, const struct db_full_path *pathp, union
 }
 
 
+/*
+ * Regions that are just a BoT are written straight from its vertices
+ * and faces, with face normals standing in for the vertexuse normals
+ * of the NMG path.
+ */
+static void
+bot_to_obj(const struct gcv_bot_region *reg, void *client_data)
+{
+    struct conversion_state *pstate = (struct conversion_state *)client_data;
+    const struct db_full_path *pathp = reg->pathp;
+    double scale = pstate->gcv_options->scale_factor;
+    size_t nnorms = 0;
+    size_t i;
+
+    pstate->regions_tried++;
+    pstate->regions_converted++;
+
+    if (pstate->obj_write_options->usemtl)
+	fprintf(pstate->fp, "usemtl %d_%d_%d\n", reg->tsp->ts_aircode, reg->tsp->ts_los, reg->tsp->ts_gmater);
+
+    fprintf(pstate->fp, "g %s", pathp->fp_names[0]->d_namep);
+    for (i=1; i<pathp->fp_len; i++)
+	fprintf(pstate->fp, "/%s", pathp->fp_names[i]->d_namep);
+    fprintf(pstate->fp, "\n");
+
+    for (i = 0; i < reg->num_vertices; i++)
+	fprintf(pstate->fp, "v %f %f %f\n", V3ARGS_SCALE(&reg->vertices[i*3], scale));
+
+    if (pstate->obj_write_options->do_normals) {
+	for (i = 0; i < reg->num_faces; i++) {
+	    const fastf_t *v0 = &reg->vertices[reg->faces[i*3+0]*3];
+	    const fastf_t *v1 = &reg->vertices[reg->faces[i*3+1]*3];
+	    const fastf_t *v2 = &reg->vertices[reg->faces[i*3+2]*3];
+	    vect_t e1, e2, normal;
+
+	    VSUB2(e1, v1, v0);
+	    VSUB2(e2, v2, v0);
+	    VCROSS(normal, e1, e2);
+	    if (MAGSQ(normal) > SMALL_FASTF)
+		VUNITIZE(normal);
+	    fprintf(pstate->fp, "vn %f %f %f\n", V3ARGS_SCALE(normal, scale));
+	}
+	nnorms = reg->num_faces;
+    }
+
+    for (i = 0; i < reg->num_faces; i++) {
+	long v0 = reg->faces[i*3+0] + 1 + (long)pstate->vert_offset;
+	long v1 = reg->faces[i*3+1] + 1 + (long)pstate->vert_offset;
+	long v2 = reg->faces[i*3+2] + 1 + (long)pstate->vert_offset;
+	if (nnorms) {
+	    long n = (long)i + 1 + (long)pstate->norm_offset;
+	    fprintf(pstate->fp, "f %ld//%ld %ld//%ld %ld//%ld\n", v0, n, v1, n, v2, n);
+	} else {
+	    fprintf(pstate->fp, "f %ld %ld %ld\n", v0, v1, v2);
+	}
+    }
+
+    pstate->vert_offset += reg->num_vertices;
+    pstate->norm_offset += nnorms;
+    pstate->regions_written++;
+}
+
+
 static void
 obj_write_create_opts(struct bu_opt_desc **options_desc, void **dest_options_data)
 {
@@ -545,8 +609,8 @@ obj_write(struct gcv_context *context, const struct gcv_opts *gcv_options, const
     fprintf(state.fp, "\n");
 
     /* Walk indicated tree(s).  Each region will be output separately */
-    (void) db_walk_tree(context->dbip, state.gcv_options->num_objects, (const char **)state.gcv_options->object_names,
-	    1, &tree_state, NULL, do_region_end, rt_booltree_leaf_tess, (void *)&state);
+    (void) gcv_walk_tree(context->dbip, state.gcv_options->num_objects, (const char **)state.gcv_options->object_names,
+	    1, &tree_state, NULL, do_region_end, rt_booltree_leaf_tess, bot_to_obj, (void *)&state);
 
     if (state.regions_tried) {
 	double percent = ((double)state.regions_converted * 100.0) / state.regions_tried;
@@ -106,20 +106,11 @@ write_verts(p_ply fp, struct bu_hash_tbl *t, struct conversion_state* pstate)
 }
 
 
-/* routine to output the faceted NMG representation of a BRL-CAD
- * region
- */
-static void
-nmg_to_ply(struct nmgregion *r, const struct db_full_path *pathp, int UNUSED(region_id), int UNUSED(material_id), struct db_tree_state *tsp, struct conversion_state* pstate)
+/* Track region colors and, when writing a file per region, create
+ * the region's file.  Returns -1 on failure. */
+static int
+ply_write_region_begin(struct conversion_state *pstate, const struct db_tree_state *tsp, const char *region_name, p_ply *ply_fpp, int color[3])
 {
-    struct model *m;
-    struct shell *s;
-    struct vertex *v;
-    char *region_name = NULL;
-    size_t nvertices = 0;
-    size_t nfaces = 0;
-    int color[3];
-    int reg_faces_pos = 0;
     p_ply ply_fp = NULL;
 
     VSCALE(color, tsp->ts_mater.ma_color, 255);
@@ -135,10 +126,6 @@ nmg_to_ply(struct nmgregion *r, const struct db_full_path *pathp, int UNUSED(reg
 	    pstate->color_info = 3;
 	}
     }
-    NMG_CK_REGION(r);
-    RT_CK_FULL_PATH(pathp);
-
-    region_name = db_path_to_string(pathp);
 
     if (pstate->ply_write_options->separate) {
 	/* Open output file */
@@ -170,13 +157,14 @@ nmg_to_ply(struct nmgregion *r, const struct db_full_path *pathp, int UNUSED(reg
 	    bu_hash_destroy(pstate->v_tbl_regs[pstate->cur_region]);
 	    bu_free(region_file, "region_file");
 	    bu_log("ERROR: Unable to create PLY file");
-	    goto free_nmg;
+	    return -1;
 	}
 	if (!ply_add_comment(ply_fp, "converted from BRL-CAD")) {
 	    bu_hash_destroy(pstate->v_tbl_regs[pstate->cur_region]);
 	    bu_free(region_file, "region_file");
+	    ply_close(ply_fp);
 	    bu_log("ERROR: Unable to write to PLY file");
-	    goto free_nmg;
+	    return -1;
 	}
 
 	comment = (char *) bu_calloc(strlen(region_name) + 14, sizeof(char), "comment");
@@ -186,6 +174,107 @@ nmg_to_ply(struct nmgregion *r, const struct db_full_path *pathp, int UNUSED(reg
 	bu_free(region_file, "region_file");
     }
 
+    *ply_fpp = ply_fp;
+    return 0;
+}
+
+
+/* Once the current region's faces and vertices have been collected,
+ * write them out if writing a file per region, and update the
+ * totals.  Returns -1 on failure. */
+static int
+ply_write_region_finish(struct conversion_state *pstate, const struct db_tree_state *tsp, p_ply ply_fp, const int color[3], size_t nfaces, size_t nvertices)
+{
+    if (nvertices >= INT_MAX) {
+	bu_hash_destroy(pstate->v_tbl_regs[pstate->cur_region]);
+	bu_log("ERROR: Number of vertices (%zu) exceeds integer limit!\n", nvertices);
+	return -1;
+    }
+
+    if (pstate->ply_write_options->separate) {
+	size_t fi;
+	size_t vi;
+	double *coords;
+
+	ply_add_element(ply_fp, "vertex", nvertices);
+	ply_add_scalar_property(ply_fp, "x", PLY_FLOAT);
+	ply_add_scalar_property(ply_fp, "y", PLY_FLOAT);
+	ply_add_scalar_property(ply_fp, "z", PLY_FLOAT);
+	ply_add_element(ply_fp, "face", nfaces);
+	ply_add_list_property(ply_fp, "vertex_indices", PLY_UCHAR, PLY_UINT);
+	if (tsp->ts_mater.ma_color_valid) {
+	    ply_add_scalar_property(ply_fp, "red", PLY_UCHAR);
+	    ply_add_scalar_property(ply_fp, "green", PLY_UCHAR);
+	    ply_add_scalar_property(ply_fp, "blue", PLY_UCHAR);
+	}
+	ply_write_header(ply_fp);
+
+	if (write_verts(ply_fp, pstate->v_tbl_regs[pstate->cur_region], pstate)) {
+	    bu_hash_destroy(pstate->v_tbl_regs[pstate->cur_region]);
+	    bu_log("ERROR: No coordinates found for vertex!\n");
+	    return -1;
+	}
+	for (fi = 0; fi < nfaces; fi++) {
+	    ply_write(ply_fp, 3);
+	    for (vi = 0; vi < 3; vi++) {
+		coords = (double *)bu_hash_get(pstate->v_tbl_regs[pstate->cur_region], (const unsigned char *)(pstate->f_regs[pstate->cur_region][fi] + vi), sizeof(long));
+		if (!coords) {
+		    bu_log("ERROR: No vertex found for face with index %ld!\n", pstate->f_regs[pstate->cur_region][fi][vi]);
+		    return -1;
+		}
+		ply_write(ply_fp, coords[3]);
+	    }
+	    if(tsp->ts_mater.ma_color_valid) {
+		ply_write(ply_fp, color[0]);
+		ply_write(ply_fp, color[1]);
+		ply_write(ply_fp, color[2]);
+	    }
+	}
+
+        pstate->v_order = 0;    // reset index for next file
+        ply_close(ply_fp);      
+    }
+
+    pstate->tot_polygons += nfaces;
+    pstate->tot_vertices += nvertices;
+
+    if (pstate->ply_write_options->separate) {
+	bu_hash_destroy(pstate->v_tbl_regs[pstate->cur_region]);
+	/* the face indices are one block, starting at the first face */
+	if (nfaces)
+	    bu_free(pstate->f_regs[pstate->cur_region][0], "v_ind");
+	bu_free(pstate->f_regs[pstate->cur_region], "reg_faces");
+    }
+    pstate->cur_region++;
+    return 0;
+}
+
+
+/* routine to output the faceted NMG representation of a BRL-CAD
+ * region
+ */
+static void
+nmg_to_ply(struct nmgregion *r, const struct db_full_path *pathp, int UNUSED(region_id), int UNUSED(material_id), struct db_tree_state *tsp, struct conversion_state* pstate)
+{
+    struct model *m;
+    struct shell *s;
+    struct vertex *v;
+    char *region_name = NULL;
+    size_t nvertices = 0;
+    size_t nfaces = 0;
+    int color[3];
+    int reg_faces_pos = 0;
+    long *f_ind = NULL;
+    p_ply ply_fp = NULL;
+
+    NMG_CK_REGION(r);
+    RT_CK_FULL_PATH(pathp);
+
+    region_name = db_path_to_string(pathp);
+
+    if (ply_write_region_begin(pstate, tsp, region_name, &ply_fp, color) < 0)
+	goto free_nmg;
+
     m = r->m_p;
     NMG_CK_MODEL(m);
 
@@ -230,6 +319,7 @@ nmg_to_ply(struct nmgregion *r, const struct db_full_path *pathp, int UNUSED(reg
     pstate->f_sizes[pstate->cur_region] = (int) nfaces;
     pstate->v_tbl_regs[pstate->cur_region] = bu_hash_create(nfaces * 3);
     pstate->f_regs[pstate->cur_region] = (long **) bu_calloc(nfaces, sizeof(long *), "reg_faces");
+    f_ind = (long *) bu_calloc(nfaces * 3, sizeof(long), "v_ind");
     pstate->v_regs[pstate->cur_region] = (double **) bu_calloc(nfaces * 3, sizeof(double *), "reg_verts"); /* chose to do this over dynamic array, but I may be wrong */
 
     /* count number of vertices and put them into the hash table */
@@ -246,7 +336,7 @@ nmg_to_ply(struct nmgregion *r, const struct db_full_path *pathp, int UNUSED(reg
 	    for (BU_LIST_FOR(lu, loopuse, &fu->lu_hd)) {
 		struct edgeuse *eu;
 		int v_ind_pos = 0;
-		pstate->f_regs[pstate->cur_region][reg_faces_pos] = (long *) bu_calloc(3, sizeof(long), "v_ind");
+		pstate->f_regs[pstate->cur_region][reg_faces_pos] = &f_ind[reg_faces_pos * 3];
 		NMG_CK_LOOPUSE(lu);
 		if (BU_LIST_FIRST_MAGIC(&lu->down_hd) != NMG_EDGEUSE_MAGIC)
 		    continue;
@@ -287,66 +377,10 @@ nmg_to_ply(struct nmgregion *r, const struct db_full_path *pathp, int UNUSED(reg
 	}
     }
 
-    if (nvertices >= INT_MAX) {
-	bu_hash_destroy(pstate->v_tbl_regs[pstate->cur_region]);
-	bu_log("ERROR: Number of vertices (%zu) exceeds integer limit!\n", nvertices);
+    if (ply_write_region_finish(pstate, tsp, ply_fp, color, nfaces, nvertices) < 0)
 	goto free_nmg;
-    }
-
-    if (pstate->ply_write_options->separate) {
-	size_t fi;
-	size_t vi;
-	double *coords;
-
-	ply_add_element(ply_fp, "vertex", nvertices);
-	ply_add_scalar_property(ply_fp, "x", PLY_FLOAT);
-	ply_add_scalar_property(ply_fp, "y", PLY_FLOAT);
-	ply_add_scalar_property(ply_fp, "z", PLY_FLOAT);
-	ply_add_element(ply_fp, "face", nfaces);
-	ply_add_list_property(ply_fp, "vertex_indices", PLY_UCHAR, PLY_UINT);
-	if (tsp->ts_mater.ma_color_valid) {
-	    ply_add_scalar_property(ply_fp, "red", PLY_UCHAR);
-	    ply_add_scalar_property(ply_fp, "green", PLY_UCHAR);
-	    ply_add_scalar_property(ply_fp, "blue", PLY_UCHAR);
-	}
-	ply_write_header(ply_fp);
-
-	if (write_verts(ply_fp, pstate->v_tbl_regs[pstate->cur_region], pstate)) {
-	    bu_hash_destroy(pstate->v_tbl_regs[pstate->cur_region]);
-	    bu_log("ERROR: No coordinates found for vertex!\n");
-	    goto free_nmg;
-	}
-	for (fi = 0; fi < nfaces; fi++) {
-	    ply_write(ply_fp, 3);
-	    for (vi = 0; vi < 3; vi++) {
-		coords = (double *)bu_hash_get(pstate->v_tbl_regs[pstate->cur_region], (const unsigned char *)(pstate->f_regs[pstate->cur_region][fi] + vi), sizeof(long));
-		if (!coords) {
-		    bu_log("ERROR: No vertex found for face with index %ld!\n", pstate->f_regs[pstate->cur_region][fi][vi]);
-		    goto free_nmg;
-		}
-		ply_write(ply_fp, coords[3]);
-	    }
-	    if(tsp->ts_mater.ma_color_valid) {
-		ply_write(ply_fp, color[0]);
-		ply_write(ply_fp, color[1]);
-		ply_write(ply_fp, color[2]);
-	    }
-	    bu_free(pstate->f_regs[pstate->cur_region][fi], "v_ind");
-	}
-
-        pstate->v_order = 0;    // reset index for next file
-        ply_close(ply_fp);      
-    }
-
-    pstate->tot_polygons += nfaces;
-    pstate->tot_vertices += nvertices;
 
-    if (pstate->ply_write_options->separate) {
-	bu_hash_destroy(pstate->v_tbl_regs[pstate->cur_region]);
-	bu_free(pstate->f_regs[pstate->cur_region], "reg_faces");
-    }
     bu_free(region_name, "region_name");
-    pstate->cur_region++;
     return;
 
 free_nmg:
@@ -368,6 +402,83 @@ free_nmg:
 }
 
 
+/* Regions that are just a BoT are collected straight from its faces,
+ * keyed on the BoT's own vertex indices */
+static void
+bot_to_ply(const struct gcv_bot_region *reg, void *client_data)
+{
+    struct conversion_state *pstate = (struct conversion_state *)client_data;
+    char *region_name;
+    int color[3];
+    size_t fi, vi;
+    p_ply ply_fp = NULL;
+    long **f_reg;
+    long *f_ind;
+    double **v_reg;
+    double *v_coords;
+    struct bu_hash_tbl *v_tbl;
+
+    pstate->regions_tried++;
+    pstate->regions_converted++;
+
+    if ((size_t)pstate->cur_region >= pstate->tot_regions) {
+	bu_log("ERROR: More regions than counted!\n");
+	return;
+    }
+
+    /* RPly library cannot handle faces and vertices greater than the
+     * integer limit
+     */
+    if (reg->num_faces >= INT_MAX || reg->num_vertices >= INT_MAX) {
+	bu_log("ERROR: Number of faces (%zu) or vertices (%zu) exceeds integer limit!\n", reg->num_faces, reg->num_vertices);
+	return;
+    }
+
+    region_name = db_path_to_string(reg->pathp);
+    if (ply_write_region_begin(pstate, reg->tsp, region_name, &ply_fp, color) < 0) {
+	bu_free(region_name, "region_name");
+	return;
+    }
+
+    if (pstate->ply_write_options->verbose || pstate->gcv_options->verbosity_level)
+	bu_log("Converting BoT triangles to PLY format for region %s\n", region_name);
+
+    v_tbl = bu_hash_create(reg->num_vertices);
+    f_reg = (long **)bu_calloc(reg->num_faces, sizeof(long *), "reg_faces");
+    v_reg = (double **)bu_calloc(reg->num_vertices, sizeof(double *), "reg_verts");
+    f_ind = (long *)bu_calloc(reg->num_faces * 3, sizeof(long), "v_ind");
+    v_coords = (double *)bu_calloc(reg->num_vertices * 4, sizeof(double), "v_coords");
+
+    for (vi = 0; vi < reg->num_vertices; vi++) {
+	long key = (long)vi;
+	v_reg[vi] = &v_coords[vi*4];
+	VMOVE(v_reg[vi], &reg->vertices[vi*3]);
+	(void)bu_hash_set(v_tbl, (const uint8_t *)&key, sizeof(long), (void *)v_reg[vi]);
+    }
+    for (fi = 0; fi < reg->num_faces; fi++) {
+	f_reg[fi] = &f_ind[fi*3];
+	f_reg[fi][0] = reg->faces[fi*3+0];
+	f_reg[fi][1] = reg->faces[fi*3+1];
+	f_reg[fi][2] = reg->faces[fi*3+2];
+    }
+
+    pstate->f_sizes[pstate->cur_region] = (int)reg->num_faces;
+    pstate->v_tbl_regs[pstate->cur_region] = v_tbl;
+    pstate->f_regs[pstate->cur_region] = f_reg;
+    pstate->v_regs[pstate->cur_region] = v_reg;
+
+    if (ply_write_region_finish(pstate, reg->tsp, ply_fp, color, reg->num_faces, reg->num_vertices) < 0) {
+	if (ply_fp)
+	    ply_close(ply_fp);
+	bu_free(region_name, "region_name");
+	bu_exit(1, NULL);
+    }
+
+    pstate->regions_written++;
+    bu_free(region_name, "region_name");
+}
+
+
 static void
 process_triangulation(struct nmgregion *r, const struct db_full_path *pathp, struct db_tree_state *tsp, struct conversion_state* pstate)
 {
@@ -718,14 +829,15 @@ ply_write_gcv(struct gcv_context* context, const struct gcv_opts* gcv_options, c
     state.v_tbl_regs = (struct bu_hash_tbl **) bu_calloc(state.tot_regions, sizeof(struct bu_hash_tbl*), "v_tbl_regs");
 
     /* Walk indicated tree(s).  Each region will be output separately */
-    (void) db_walk_tree(state.dbip, 
-    			gcv_options->num_objects, 
+    (void) gcv_walk_tree(state.dbip,
+			gcv_options->num_objects,
 			(const char**)gcv_options->object_names,
 			1,		/* ncpu */
 			&tree_state,
 			0,		/* take all regions */
 			do_region_end,
 			rt_booltree_leaf_tess,
+			bot_to_ply,	/* BoT regions are written directly */
 			(void*)&state);
 
     if (state.ply_write_options->verbose || state.gcv_options->verbosity_level)
@@ -774,8 +886,9 @@ ply_write_gcv(struct gcv_context* context, const struct gcv_opts* gcv_options, c
 		    ply_write(ply_fp, state.all_colors[1]);
 		    ply_write(ply_fp, state.all_colors[2]);
 		}
-		bu_free(state.f_regs[ri][fi], "v_ind");
 	    }
+	    if (state.f_sizes[ri])
+		bu_free(state.f_regs[ri][0], "v_ind");
 	    bu_free(state.f_regs[ri], "reg_faces");
 	    bu_hash_destroy(state.v_tbl_regs[ri]);
 	}
@@ -38,8 +38,9 @@
 #include "bnetwork.h"
 #include "bio.h"
 
-#include "bu/cv.h"
 #include "bu/getopt.h"
+#include "bu/mapped_file.h"
+#include "bu/parallel.h"
 #include "bu/path.h"
 #include "bu/units.h"
 #include "bu/vls.h"
@@ -70,8 +71,10 @@ struct conversion_state
     struct rt_wdb *fd_out;	/* Resulting BRL-CAD file */
 
     struct wmember all_head;
-    struct bg_vert_tree *tree;
-    int *bot_faces;	        /* array of ints (indices into tree->the_array array) three per face */
+    fastf_t *facet_verts;	/* ASCII facet vertices, nine per facet, as read */
+    size_t facet_vsize;		/* current size of the facet_verts array, in facets */
+    size_t facet_vcurr;		/* current facet */
+    int *bot_faces;	        /* array of ints (indices into the welded vertices) three per face */
 
     int id_no;	            	/* Ident numbers */
     int bot_fsize;		/* current size of the bot_faces array */
@@ -79,26 +82,71 @@ struct conversion_state
 };
 
 
-/* Size of blocks of faces to malloc */
+/* Size of blocks of facets to malloc */
 #define BOT_FBLOCK 128
 
 #define MAX_LINE_SIZE 512
 
 
 static void
-Add_face(struct conversion_state *pstate, int face[3])
+Add_facet(struct conversion_state *pstate, const fastf_t fverts[9])
 {
-    if (!pstate->bot_faces) {
-	pstate->bot_faces = (int *)bu_malloc(3 * BOT_FBLOCK * sizeof(int), "bot_faces");
-	pstate->bot_fsize = BOT_FBLOCK;
-	pstate->bot_fcurr = 0;
-    } else if (pstate->bot_fcurr >= pstate->bot_fsize) {
-	pstate->bot_fsize += BOT_FBLOCK;
-	pstate->bot_faces = (int *)bu_realloc((void *)pstate->bot_faces, 3 * pstate->bot_fsize * sizeof(int), "bot_faces increase");
+    if (pstate->facet_vcurr >= pstate->facet_vsize) {
+	pstate->facet_vsize = (pstate->facet_vsize) ? pstate->facet_vsize * 2 : BOT_FBLOCK;
+	pstate->facet_verts = (fastf_t *)bu_realloc((void *)pstate->facet_verts, 9 * pstate->facet_vsize * sizeof(fastf_t), "facet_verts");
     }
 
-    VMOVE(&pstate->bot_faces[3*pstate->bot_fcurr], face);
-    pstate->bot_fcurr++;
+    memcpy(&pstate->facet_verts[9*pstate->facet_vcurr], fverts, 9 * sizeof(fastf_t));
+    pstate->facet_vcurr++;
+}
+
+
+/* Merge the shared vertices of num_facets facets (nine coordinates
+ * each, in verts) and build pstate->bot_faces from them, dropping the
+ * faces that end up degenerate.  Returns the number of faces, or -1 if
+ * the facets hold coordinates that aren't finite numbers. */
+static int
+Weld_facets(struct conversion_state *pstate, const fastf_t *fverts, size_t num_facets, fastf_t **verts, size_t *num_verts, int *degenerate_count)
+{
+    size_t i;
+    size_t *vmap = (size_t *)bu_malloc(num_facets * 3 * sizeof(size_t), "stl vertex map");
+
+    *num_verts = bg_vert_weld(verts, vmap, fverts, num_facets * 3, pstate->gcv_options->calculational_tolerance.dist_sq, 0);
+    if (!*verts) {
+	bu_free(vmap, "stl vertex map");
+	return -1;
+    }
+
+    /* Faces are written in place, since there can be no more of them
+     * than there are facets */
+    pstate->bot_faces = (int *)bu_realloc(pstate->bot_faces, num_facets * 3 * sizeof(int), "bot_faces");
+    pstate->bot_fsize = (int)num_facets;
+    pstate->bot_fcurr = 0;
+    for (i = 0; i < num_facets; i++) {
+	int *tmp_face = &pstate->bot_faces[3*pstate->bot_fcurr];
+	tmp_face[0] = (int)vmap[i*3];
+	tmp_face[1] = (int)vmap[i*3+1];
+	tmp_face[2] = (int)vmap[i*3+2];
+
+	/* check for degenerate faces */
+	if (tmp_face[0] == tmp_face[1] || tmp_face[0] == tmp_face[2] || tmp_face[1] == tmp_face[2]) {
+	    (*degenerate_count)++;
+	    continue;
+	}
+
+	if (pstate->gcv_options->debug_mode) {
+	    int n;
+
+	    bu_log("Making Face:\n");
+	    for (n=0; n<3; n++)
+		bu_log("\tvertex #%d: (%g %g %g)\n", tmp_face[n], V3ARGS(&(*verts)[3*tmp_face[n]]));
+	}
+
+	pstate->bot_fcurr++;
+    }
+    bu_free(vmap, "stl vertex map");
+
+    return pstate->bot_fcurr;
 }
 
 static int
@@ -164,6 +212,8 @@ Convert_part_ascii(struct conversion_state *pstate, char line[MAX_LINE_SIZE])
     struct wmember head;
     vect_t normal={0, 0, 0};
     int solid_in_region=0;
+    fastf_t *verts = NULL;
+    size_t num_verts = 0;
 
     BU_LIST_INIT(&head.l);
 
@@ -238,7 +288,7 @@ Convert_part_ascii(struct conversion_state *pstate, char line[MAX_LINE_SIZE])
 	} else if (!bu_strncmp(&line1[start], "outer loop", 10) || !bu_strncmp(&line1[start], "OUTER LOOP", 10)) {
 	    int endloop=0;
 	    int vert_no=0;
-	    int tmp_face[3] = {0, 0, 0};
+	    fastf_t fverts[9];
 
 	    while (!endloop) {
 		if (bu_fgets(line1, MAX_LINE_SIZE, pstate->fd_in) == NULL)
@@ -257,48 +307,44 @@ Convert_part_ascii(struct conversion_state *pstate, char line[MAX_LINE_SIZE])
 		    if (vert_no > 2) {
 			int n;
 
-			bu_log("Non-triangular loop:\n");
+			bu_log("Non-triangular loop, ignoring extra vertex:\n");
 			for (n=0; n<3; n++)
-			    bu_log("\t(%g %g %g)\n", V3ARGS(&pstate->tree->the_array[tmp_face[n]]));
+			    bu_log("\t(%g %g %g)\n", V3ARGS(&fverts[3*n]));
 
 			bu_log("\t(%g %g %g)\n", x, y, z);
+			continue;
 		    }
-		    x *= pstate->gcv_options->scale_factor;
-		    y *= pstate->gcv_options->scale_factor;
-		    z *= pstate->gcv_options->scale_factor;
-		    tmp_face[vert_no++] = bg_vert_tree_add( pstate->tree,x, y, z, pstate->gcv_options->calculational_tolerance.dist_sq);
+		    VSET(&fverts[3*vert_no], x, y, z);
+		    VSCALE(&fverts[3*vert_no], &fverts[3*vert_no], pstate->gcv_options->scale_factor);
+		    vert_no++;
 		} else {
 		    bu_log("Unrecognized line: %s\n", line1);
 		}
 	    }
 
-	    /* check for degenerate faces */
-	    if (tmp_face[0] == tmp_face[1]) {
+	    /* too few vertices to make a face */
+	    if (vert_no < 3) {
 		degenerate_count++;
 		continue;
 	    }
 
-	    if (tmp_face[0] == tmp_face[2]) {
-		degenerate_count++;
-		continue;
-	    }
-
-	    if (tmp_face[1] == tmp_face[2]) {
-		degenerate_count++;
-		continue;
-	    }
-
-	    if (pstate->gcv_options->debug_mode) {
-		int n;
-
-		bu_log("Making Face:\n");
-		for (n=0; n<3; n++)
-		    bu_log("\tvertex #%d: (%g %g %g)\n", tmp_face[n], V3ARGS(&pstate->tree->the_array[3*tmp_face[n]]));
+	    if (pstate->gcv_options->debug_mode)
 		VPRINT(" normal", normal);
-	    }
 
-	    Add_face(pstate, tmp_face);
-	    face_count++;
+	    Add_facet(pstate, fverts);
+	}
+    }
+
+    /* Merge the shared vertices of all the part's facets at once,
+     * rather than searching a vertex tree as each one is read */
+    if (pstate->facet_vcurr) {
+	face_count = Weld_facets(pstate, pstate->facet_verts, pstate->facet_vcurr, &verts, &num_verts, &degenerate_count);
+	pstate->facet_vcurr = 0;
+	if (face_count < 0) {
+	    bu_log("\t%s has vertices that are not finite numbers, ignoring\n", bu_vls_cstr(&region_name));
+	    bu_vls_free(&region_name);
+	    bu_vls_free(&solid_name);
+	    return;
 	}
     }
 
@@ -307,6 +353,7 @@ Convert_part_ascii(struct conversion_state *pstate, char line[MAX_LINE_SIZE])
 	bu_log("\t%s has no solid parts, ignoring\n", bu_vls_cstr(&region_name));
 	if (degenerate_count)
 	    bu_log("\t%d faces were degenerate\n", degenerate_count);
+	bu_free(verts, "welded vertices");
 	bu_vls_free(&region_name);
 	bu_vls_free(&solid_name);
 
@@ -316,9 +363,9 @@ Convert_part_ascii(struct conversion_state *pstate, char line[MAX_LINE_SIZE])
 	    bu_log("\t%d faces were degenerate\n", degenerate_count);
     }
 
-    mk_bot(pstate->fd_out, bu_vls_cstr(&solid_name), RT_BOT_SOLID, RT_BOT_UNORIENTED, 0, pstate->tree->curr_vert, pstate->bot_fcurr,
-	   pstate->tree->the_array, pstate->bot_faces, NULL, NULL);
-    bg_vert_tree_clean(pstate->tree);
+    mk_bot(pstate->fd_out, bu_vls_cstr(&solid_name), RT_BOT_SOLID, RT_BOT_UNORIENTED, 0, num_verts, pstate->bot_fcurr,
+	   verts, pstate->bot_faces, NULL, NULL);
+    bu_free(verts, "welded vertices");
 
     if (db5_update_attribute(bu_vls_cstr(&solid_name), "importer", "gcv-stl", pstate->fd_out->dbip))
         bu_bomb("db5_update_attribute() failed");
@@ -349,99 +396,130 @@ Convert_part_ascii(struct conversion_state *pstate, char line[MAX_LINE_SIZE])
     return;
 }
 
-/* Byte swaps a 4-byte val */
-static void stl_read_lswap(unsigned int *v)
+/* Decode a little-endian IEEE float */
+static float
+stl_read_lefloat(const unsigned char *b)
 {
-    unsigned int r;
-
-    r = *v;
-    *v = ((r & 0xff) << 24) | ((r & 0xff00) << 8) | ((r & 0xff0000) >> 8)
-	| ((r & 0xff000000) >> 24);
+    uint32_t u = (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
 }
 
-static void
-Convert_part_binary(struct conversion_state *pstate)
-{
-    unsigned char buf[51];
-    unsigned long num_facets=0;
-    float flts[12];
-    vect_t normal;
-    int tmp_face[3];
-    struct wmember head;
-    struct bu_vls solid_name = BU_VLS_INIT_ZERO;
-    struct bu_vls region_name = BU_VLS_INIT_ZERO;
-    int face_count=0;
-    int degenerate_count=0;
-    size_t ret;
 
-    bu_vls_strcat(&solid_name, "s.stl");
-    bu_vls_strcat(&region_name, "r.stl");
-    bu_log("\tUsing solid name: %s\n", bu_vls_cstr(&solid_name));
+#define STL_BINARY_HEADER_SIZE 84
+#define STL_BINARY_FACET_SIZE 50
+#define STL_BINARY_CHUNK 16384
 
+struct stl_binary_decode {
+    const unsigned char *facets;
+    size_t num_facets;
+    fastf_t scale_factor;
+    fastf_t *verts;		/* 9 per facet, in file order */
+    size_t nchunks;
+    size_t next_chunk;
+};
 
-    ret = fread(buf, 4, 1, pstate->fd_in);
-    if (ret != 1)
-	perror("fread");
 
-    /* swap bytes to convert from Little-endian to network order (big-endian) */
-    stl_read_lswap((unsigned int *)buf);
+/* Facet records are fixed size, so each thread simply grabs the next
+ * unclaimed chunk of them and decodes it in place. */
+static void
+stl_binary_decode_worker(int UNUSED(cpu), void *data)
+{
+    struct stl_binary_decode *d = (struct stl_binary_decode *)data;
 
-    /* now use our network to native host format conversion tools */
-    num_facets = ntohl(*(uint32_t *)buf);
+    while (1) {
+	size_t c, i;
 
-    bu_log("\t%ld facets\n", num_facets);
-    while (fread(buf, 48, 1, pstate->fd_in)) {
-	int i;
-	double pt[3];
+	bu_semaphore_acquire(BU_SEM_GENERAL);
+	c = d->next_chunk++;
+	bu_semaphore_release(BU_SEM_GENERAL);
+	if (c >= d->nchunks)
+	    break;
 
-	/* swap bytes to convert from Little-endian to network order (big-endian) */
-	for (i=0; i<12; i++) {
-	    stl_read_lswap((unsigned int *)&buf[i*4]);
+	for (i = c * STL_BINARY_CHUNK; i < d->num_facets && i < (c + 1) * STL_BINARY_CHUNK; i++) {
+	    /* skip the normal - only the vertices are used */
+	    const unsigned char *rec = d->facets + i * STL_BINARY_FACET_SIZE + 12;
+	    int j;
+	    for (j = 0; j < 9; j++)
+		d->verts[i*9 + j] = stl_read_lefloat(&rec[j*4]) * d->scale_factor;
 	}
+    }
+}
 
-	/* now use our network to native host format conversion tools */
-	bu_cv_ntohf((unsigned char *)flts, buf, 12);
 
-	/* unused attribute byte count */
-	ret = fread(buf, 2, 1, pstate->fd_in);
-	if (ret != 1)
-	    perror("fread");
+static void
+Convert_part_binary(struct conversion_state *pstate)
+{
+    char header[81];
+    struct bu_mapped_file *mf;
+    struct stl_binary_decode decode;
+    const unsigned char *buf;
+    size_t num_facets = 0;
+    size_t hdr_facets;
+    size_t num_verts;
+    fastf_t *verts;
+    struct wmember head;
+    struct bu_vls solid_name = BU_VLS_INIT_ZERO;
+    struct bu_vls region_name = BU_VLS_INIT_ZERO;
+    size_t ncpu;
+    int face_count=0;
+    int degenerate_count=0;
 
-	VMOVE(normal, flts);
-	VSCALE(pt, &flts[3], pstate->gcv_options->scale_factor);
-	tmp_face[0] = bg_vert_tree_add(pstate->tree, V3ARGS(pt), pstate->gcv_options->calculational_tolerance.dist_sq);
-	VSCALE(pt, &flts[6], pstate->gcv_options->scale_factor);
-	tmp_face[1] = bg_vert_tree_add(pstate->tree, V3ARGS(pt), pstate->gcv_options->calculational_tolerance.dist_sq);
-	VSCALE(pt, &flts[9], pstate->gcv_options->scale_factor);
-	tmp_face[2] = bg_vert_tree_add(pstate->tree, V3ARGS(pt), pstate->gcv_options->calculational_tolerance.dist_sq);
+    mf = bu_open_mapped_file(pstate->input_file, NULL);
+    if (!mf || mf->buflen < STL_BINARY_HEADER_SIZE) {
+	if (mf)
+	    bu_close_mapped_file(mf);
+	bu_exit(EXIT_FAILURE, "Unexpected EOF in input file!\n");
+    }
+    buf = (const unsigned char *)mf->buf;
 
-	/* check for degenerate faces */
-	if (tmp_face[0] == tmp_face[1]) {
-	    degenerate_count++;
-	    continue;
-	}
+    memcpy(header, buf, 80);
+    header[80] = '\0';
+    bu_log("header data:\n%s\n\n", header);
 
-	if (tmp_face[0] == tmp_face[2]) {
-	    degenerate_count++;
-	    continue;
-	}
+    bu_vls_strcat(&solid_name, "s.stl");
+    bu_vls_strcat(&region_name, "r.stl");
+    bu_log("\tUsing solid name: %s\n", bu_vls_cstr(&solid_name));
 
-	if (tmp_face[1] == tmp_face[2]) {
-	    degenerate_count++;
-	    continue;
-	}
+    hdr_facets = (size_t)buf[80] | ((size_t)buf[81] << 8) | ((size_t)buf[82] << 16) | ((size_t)buf[83] << 24);
+    bu_log("\t%ld facets\n", (long)hdr_facets);
 
-	if (pstate->gcv_options->debug_mode) {
-	    int n;
+    /* As before, trust the file length rather than the header count.
+     * A final record missing only its attribute bytes is still used. */
+    num_facets = (mf->buflen - STL_BINARY_HEADER_SIZE + 2) / STL_BINARY_FACET_SIZE;
+    if (num_facets != hdr_facets)
+	bu_log("\tfile holds %ld facets\n", (long)num_facets);
 
-	    bu_log("Making Face:\n");
-	    for (n=0; n<3; n++)
-		bu_log("\tvertex #%d: (%g %g %g)\n", tmp_face[n], V3ARGS(&pstate->tree->the_array[3*tmp_face[n]]));
-	    VPRINT(" normal", normal);
-	}
+    if (!num_facets) {
+	bu_close_mapped_file(mf);
+	bu_log("\tpart has no solid parts, ignoring\n");
+	return;
+    }
 
-	Add_face(pstate, tmp_face);
-	face_count++;
+    /* Decode all the facet vertices */
+    decode.facets = buf + STL_BINARY_HEADER_SIZE;
+    decode.num_facets = num_facets;
+    decode.scale_factor = pstate->gcv_options->scale_factor;
+    decode.verts = (fastf_t *)bu_malloc(num_facets * 9 * sizeof(fastf_t), "stl facet vertices");
+    decode.nchunks = (num_facets + STL_BINARY_CHUNK - 1) / STL_BINARY_CHUNK;
+    decode.next_chunk = 0;
+    ncpu = bu_avail_cpus();
+    if (ncpu > decode.nchunks)
+	ncpu = decode.nchunks;
+    if (ncpu > 1)
+	bu_parallel(stl_binary_decode_worker, ncpu, (void *)&decode);
+    else
+	stl_binary_decode_worker(0, (void *)&decode);
+
+    bu_close_mapped_file(mf);
+
+    /* Merge shared vertices */
+    face_count = Weld_facets(pstate, decode.verts, num_facets, &verts, &num_verts, &degenerate_count);
+    bu_free(decode.verts, "stl facet vertices");
+    if (face_count < 0) {
+	bu_log("\tpart has vertices that are not finite numbers, ignoring\n");
+	return;
     }
 
     /* Check if this part has any solid parts */
@@ -449,6 +527,7 @@ Convert_part_binary(struct conversion_state *pstate)
 	bu_log("\tpart has no solid parts, ignoring\n");
 	if (degenerate_count)
 	    bu_log("\t%d faces were degenerate\n", degenerate_count);
+	bu_free(verts, "welded vertices");
 	return;
     } else {
 	if (degenerate_count)
@@ -456,8 +535,8 @@ Convert_part_binary(struct conversion_state *pstate)
     }
 
     mk_bot(pstate->fd_out, bu_vls_cstr(&solid_name), RT_BOT_SOLID, RT_BOT_UNORIENTED, 0,
-	   pstate->tree->curr_vert, pstate->bot_fcurr, pstate->tree->the_array, pstate->bot_faces, NULL, NULL);
-    bg_vert_tree_clean(pstate->tree);
+	   num_verts, pstate->bot_fcurr, verts, pstate->bot_faces, NULL, NULL);
+    bu_free(verts, "welded vertices");
 
     if (db5_update_attribute(bu_vls_cstr(&solid_name), "importer", "gcv-stl", pstate->fd_out->dbip))
         bu_bomb("db5_update_attribute() failed");
@@ -493,17 +572,6 @@ Convert_input(struct conversion_state *pstate)
     char line[ MAX_LINE_SIZE ];
 
     if (pstate->stl_read_options->binary) {
-	if (fread(line, 80, 1, pstate->fd_in) < 1) {
-	    if (feof(pstate->fd_in)) {
-		bu_exit(EXIT_FAILURE, "Unexpected EOF in input file!\n");
-	    } else {
-		bu_log("Error reading input file\n");
-		perror("gcv-stl");
-		bu_exit(EXIT_FAILURE, "Error reading input file\n");
-	    }
-	}
-	line[80] = '\0';
-	bu_log("header data:\n%s\n\n", line);
 	Convert_part_binary(pstate);
     } else {
 	while (bu_fgets(line, MAX_LINE_SIZE, pstate->fd_in) != NULL) {
@@ -585,11 +653,11 @@ stl_read(struct gcv_context *context, const struct gcv_opts *gcv_options, const
 
     BU_LIST_INIT(&state.all_head.l);
 
-    /* create a tree structure to hold the input vertices */
-    state.tree = bg_vert_tree_create();
-
     Convert_input(&state);
 
+    bu_free(state.facet_verts, "facet_verts");
+    bu_free(state.bot_faces, "bot_faces");
+
     /* make a top level group */
     mk_lcomb(wdbp, "all", &state.all_head, 0, (char *)NULL, (char *)NULL, (unsigned char *)NULL, 0);
 
@@ -86,6 +86,9 @@ struct conversion_state
     size_t tot_polygons;
 
     struct bu_list *vlfree;
+
+    unsigned char *bbuf;		/* pending binary facet records */
+    size_t bbuf_len;
 };
 
 
@@ -116,19 +119,71 @@ stl_write_lswap(unsigned int *v)
 }
 
 
+/* Facets are accumulated and written to binary output in blocks of
+ * this many, rather than with a write() per facet */
+#define STL_WRITE_FACET_BLOCK 4096
+
+
 static void
-nmg_to_stl(struct nmgregion *r, const struct db_full_path *pathp, struct db_tree_state* UNUSED(tsp), void *client_data)
+stl_write_flush(struct conversion_state *pstate)
+{
+    if (!pstate->bbuf_len)
+	return;
+
+    if (write(pstate->bfd, pstate->bbuf, pstate->bbuf_len) < 0)
+	perror("write");
+    pstate->bbuf_len = 0;
+}
+
+
+/* Write one triangle, either as ASCII or as a binary facet record */
+static void
+stl_write_facet(struct conversion_state *pstate, const fastf_t *normal, const fastf_t *v0, const fastf_t *v1, const fastf_t *v2)
+{
+    const fastf_t *verts[3] = {v0, v1, v2};
+    double scale = pstate->gcv_options->scale_factor;
+    int i;
+
+    if (!pstate->stl_write_options->binary) {
+	fprintf(pstate->fp, "  facet normal %f %f %f\n", V3ARGS(normal));
+	fprintf(pstate->fp, "    outer loop\n");
+	for (i = 0; i < 3; i++) {
+	    fprintf(pstate->fp, "      vertex ");
+	    fprintf(pstate->fp, "%f %f %f\n", V3ARGS_SCALE(verts[i], scale));
+	}
+	fprintf(pstate->fp, "    endloop\n");
+	fprintf(pstate->fp, "  endfacet\n");
+    } else {
+	float flts[12];
+	unsigned char *vert_buffer;
+
+	if (!pstate->bbuf)
+	    pstate->bbuf = (unsigned char *)bu_malloc(50 * STL_WRITE_FACET_BLOCK, "stl facet buffer");
+	if (pstate->bbuf_len + 50 > 50 * STL_WRITE_FACET_BLOCK)
+	    stl_write_flush(pstate);
+	vert_buffer = pstate->bbuf + pstate->bbuf_len;
+	memset(vert_buffer, 0, 50);
+
+	VMOVE(flts, normal);
+	for (i = 0; i < 3; i++)
+	    VSET_SCALE(&flts[3 + i*3], verts[i], scale);
+
+	bu_cv_htonf(vert_buffer, (const unsigned char *)flts, 12);
+	for (i=0; i<12; i++) {
+	    stl_write_lswap((unsigned int *)&vert_buffer[i*4]);
+	}
+	pstate->bbuf_len += 50;
+    }
+}
+
+
+/* Set up output for a region - opening its own file if writing one
+ * file per region.  Returns the region's path string. */
+static char *
+stl_write_region_begin(struct conversion_state *pstate, const struct db_full_path *pathp)
 {
-    struct model *m;
-    struct shell *s;
-    struct vertex *v;
     char *region_name;
-    int region_polys=0;
     int ret;
-    struct conversion_state * const pstate = (struct conversion_state *)client_data;
-
-    NMG_CK_REGION(r);
-    RT_CK_FULL_PATH(pathp);
 
     region_name = db_path_to_string(pathp);
 
@@ -195,13 +250,64 @@ nmg_to_stl(struct nmgregion *r, const struct db_full_path *pathp, struct db_tree
 	}
     }
 
-    m = r->m_p;
-    NMG_CK_MODEL(m);
-
     /* Write pertinent info for this region */
     if (!pstate->stl_write_options->binary)
 	fprintf(pstate->fp, "solid %s\n", (region_name+1));
 
+    return region_name;
+}
+
+
+static void
+stl_write_region_end(struct conversion_state *pstate, char *region_name, int region_polys)
+{
+    int ret;
+
+    if (!pstate->stl_write_options->binary)
+	fprintf(pstate->fp, "endsolid %s\n", (region_name+1));
+
+    if (pstate->stl_write_options->output_directory) {
+	if (pstate->stl_write_options->binary) {
+	    unsigned char tot_buffer[4];
+
+	    stl_write_flush(pstate);
+
+	    /* Re-position pointer to 80th byte */
+	    bu_lseek(pstate->bfd, 80, SEEK_SET);
+
+	    /* Write out number of triangles */
+	    *(uint32_t *)tot_buffer = htonl((unsigned long)region_polys);
+	    stl_write_lswap((unsigned int *)tot_buffer);
+	    ret = write(pstate->bfd, tot_buffer, 4);
+	    if (ret < 0)
+		perror("write");
+	    close(pstate->bfd);
+	} else {
+	    fclose(pstate->fp);
+	}
+    }
+    bu_free(region_name, "region name");
+}
+
+
+static void
+nmg_to_stl(struct nmgregion *r, const struct db_full_path *pathp, struct db_tree_state* UNUSED(tsp), void *client_data)
+{
+    struct model *m;
+    struct shell *s;
+    struct vertex *v;
+    char *region_name;
+    int region_polys=0;
+    struct conversion_state * const pstate = (struct conversion_state *)client_data;
+
+    NMG_CK_REGION(r);
+    RT_CK_FULL_PATH(pathp);
+
+    region_name = stl_write_region_begin(pstate, pathp);
+
+    m = r->m_p;
+    NMG_CK_MODEL(m);
+
     /* triangulate model */
     nmg_triangulate_model(m, pstate->vlfree, &pstate->gcv_options->calculational_tolerance);
 
@@ -236,42 +342,23 @@ nmg_to_stl(struct nmgregion *r, const struct db_full_path *pathp, struct db_tree
 	    {
 		struct edgeuse *eu;
 		int vert_count=0;
-		float flts[12];
-		float *flt_ptr = NULL;
-		unsigned char vert_buffer[50];
+		const fastf_t *tri[3] = {NULL, NULL, NULL};
 
 		NMG_CK_LOOPUSE(lu);
 
 		if (BU_LIST_FIRST_MAGIC(&lu->down_hd) != NMG_EDGEUSE_MAGIC)
 		    continue;
 
-		memset(vert_buffer, 0, sizeof(vert_buffer));
-
-		if (!pstate->stl_write_options->binary) {
-		    fprintf(pstate->fp, "  facet normal %f %f %f\n", V3ARGS(facet_normal));
-		    fprintf(pstate->fp, "    outer loop\n");
-		} else {
-		    flt_ptr = flts;
-		    VMOVE(flt_ptr, facet_normal);
-		    flt_ptr += 3;
-		}
-
 		/* check vertex numbers for each triangle */
 		for (BU_LIST_FOR (eu, edgeuse, &lu->down_hd))
 		{
 		    NMG_CK_EDGEUSE(eu);
 
-		    vert_count++;
-
 		    v = eu->vu_p->v_p;
 		    NMG_CK_VERTEX(v);
-		    if (!pstate->stl_write_options->binary) {
-			fprintf(pstate->fp, "      vertex ");
-			fprintf(pstate->fp, "%f %f %f\n", V3ARGS_SCALE(v->vg_p->coord, pstate->gcv_options->scale_factor));
-		    } else {
-			VSET_SCALE(flt_ptr, v->vg_p->coord, pstate->gcv_options->scale_factor);
-			flt_ptr += 3;
-		    }
+		    if (vert_count < 3)
+			tri[vert_count] = v->vg_p->coord;
+		    vert_count++;
 		}
 		if (vert_count > 3)
 		{
@@ -281,47 +368,55 @@ nmg_to_stl(struct nmgregion *r, const struct db_full_path *pathp, struct db_tree
 		}
 		else if (vert_count < 3)
 		    continue;
-		if (!pstate->stl_write_options->binary) {
-		    fprintf(pstate->fp, "    endloop\n");
-		    fprintf(pstate->fp, "  endfacet\n");
-		} else {
-		    int i;
-
-		    bu_cv_htonf(vert_buffer, (const unsigned char *)flts, 12);
-		    for (i=0; i<12; i++) {
-			stl_write_lswap((unsigned int *)&vert_buffer[i*4]);
-		    }
-		    ret = write(pstate->bfd, vert_buffer, 50);
-		    if (ret < 0)
-			perror("write");
-		}
+
+		stl_write_facet(pstate, facet_normal, tri[0], tri[1], tri[2]);
 		pstate->tot_polygons++;
 		region_polys++;
 	    }
 	}
     }
-    if (!pstate->stl_write_options->binary)
-	fprintf(pstate->fp, "endsolid %s\n", (region_name+1));
 
-    if (pstate->stl_write_options->output_directory) {
-	if (pstate->stl_write_options->binary) {
-	    unsigned char tot_buffer[4];
+    stl_write_region_end(pstate, region_name, region_polys);
+}
 
-	    /* Re-position pointer to 80th byte */
-	    bu_lseek(pstate->bfd, 80, SEEK_SET);
 
-	    /* Write out number of triangles */
-	    *(uint32_t *)tot_buffer = htonl((unsigned long)region_polys);
-	    stl_write_lswap((unsigned int *)tot_buffer);
-	    ret = write(pstate->bfd, tot_buffer, 4);
-	    if (ret < 0)
-		perror("write");
-	    close(pstate->bfd);
-	} else {
-	    fclose(pstate->fp);
+/* Regions that are just a BoT are written straight from its faces */
+static void
+bot_to_stl(const struct gcv_bot_region *reg, void *client_data)
+{
+    struct gcv_region_end_data *gcvwriter = (struct gcv_region_end_data *)client_data;
+    struct conversion_state * const pstate = (struct conversion_state *)gcvwriter->client_data;
+    char *region_name;
+    int region_polys = 0;
+    size_t i;
+
+    region_name = stl_write_region_begin(pstate, reg->pathp);
+
+    for (i = 0; i < reg->num_faces; i++) {
+	const fastf_t *v0 = &reg->vertices[reg->faces[i*3+0]*3];
+	const fastf_t *v1 = &reg->vertices[reg->faces[i*3+1]*3];
+	const fastf_t *v2 = &reg->vertices[reg->faces[i*3+2]*3];
+	vect_t e1, e2, normal;
+
+	VSUB2(e1, v1, v0);
+	VSUB2(e2, v2, v0);
+	VCROSS(normal, e1, e2);
+	if (MAGSQ(normal) < SMALL_FASTF) {
+	    /* zero area - nothing to draw */
+	    continue;
 	}
+	VUNITIZE(normal);
+
+	stl_write_facet(pstate, normal, v0, v1, v2);
+	pstate->tot_polygons++;
+	region_polys++;
     }
-    bu_free(region_name, "region name");
+
+    pstate->regions_tried++;
+    pstate->regions_converted++;
+    pstate->regions_written++;
+
+    stl_write_region_end(pstate, region_name, region_polys);
 }
 
 
@@ -420,12 +515,13 @@ stl_write(struct gcv_context *context, const struct gcv_opts *gcv_options, const
     state.vlfree = &rt_vlfree;
 
     /* Walk indicated tree(s).  Each region will be output separately */
-    (void) db_walk_tree(state.dbip, gcv_options->num_objects, (const char **)gcv_options->object_names,
+    (void) gcv_walk_tree(state.dbip, gcv_options->num_objects, (const char **)gcv_options->object_names,
 	    1,
 	    &tree_state,
 	    0,			/* take all regions */
 	    (gcv_options->tessellation_algorithm == GCV_TESS_MARCHING_CUBES)?gcv_region_end_mc:gcv_region_end,
 	    (gcv_options->tessellation_algorithm == GCV_TESS_MARCHING_CUBES)?NULL:rt_booltree_leaf_tess,
+	    bot_to_stl,		/* BoT regions are written directly */
 	    (void *)&gcvwriter);
 
     if (state.regions_tried>0) {
@@ -448,6 +544,8 @@ stl_write(struct gcv_context *context, const struct gcv_opts *gcv_options, const
 	if (state.stl_write_options->binary) {
 	    unsigned char tot_buffer[4];
 
+	    stl_write_flush(&state);
+
 	    /* Re-position pointer to 80th byte */
 	    bu_lseek(state.bfd, 80, SEEK_SET);
 
@@ -464,6 +562,8 @@ stl_write(struct gcv_context *context, const struct gcv_opts *gcv_options, const
     }
 
     /* Release dynamic storage */
+    if (state.bbuf)
+	bu_free(state.bbuf, "stl facet buffer");
     nmg_km(state.the_model);
     rt_vlist_cleanup();
 
@@ -572,7 +572,7 @@ extern "C" int
 _bot_cmd_isect(void *bs, int argc, const char **argv)
 {
     const char *usage_string = "bot [options] isect <objname> <objname2>";
-    const char *purpose_string = "(TODO) Test if BoT <objname> intersects with BoT <objname2>";
+    const char *purpose_string = "Test if BoT <objname> intersects with BoT <objname2>";
     if (_bot_cmd_msgs(bs, argc, argv, usage_string, purpose_string)) {
 	return BRLCAD_OK;
     }
@@ -612,9 +612,22 @@ _bot_cmd_isect(void *bs, int argc, const char **argv)
     int *faces_1 = bot->faces;
     int *faces_2 = bot_2->faces;
 
-    (void)bg_trimesh_isect(NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-			   faces_1, fc_1, verts_1, vc_1, faces_2, fc_2, verts_2, vc_2);
+    int *isect_1 = NULL, *isect_2 = NULL;
+    int ni_1 = 0, ni_2 = 0;
+    int npairs = bg_trimesh_isect(NULL, NULL, NULL, NULL, &isect_1, &ni_1, &isect_2, &ni_2,
+				  faces_1, fc_1, verts_1, vc_1, faces_2, fc_2, verts_2, vc_2);
 
+    if (!npairs) {
+	bu_vls_printf(gb->gedp->ged_result_str, "%s and %s do not intersect", argv[0], argv[1]);
+    } else {
+	bu_vls_printf(gb->gedp->ged_result_str, "%d intersecting face pairs (%d faces of %s, %d faces of %s)",
+		      npairs, ni_1, argv[0], ni_2, argv[1]);
+    }
+
+    if (isect_1)
+	bu_free(isect_1, "isect faces");
+    if (isect_2)
+	bu_free(isect_2, "isect faces");
     rt_db_free_internal(&intern_2);
 
     return BRLCAD_OK;
@@ -609,6 +609,78 @@ _bot_cmd_open_edges(void *bs, int argc, const char **argv)
 }
 
 
+extern "C" int
+_bot_cmd_self_isect(void *bs, int argc, const char **argv)
+{
+    const char *usage_string = "bot [options] check self_isect <objname>";
+    const char *purpose_string = "Check BoT for faces which intersect other, non-adjacent faces";
+    if (_bot_check_msgs(bs, argc, argv, usage_string, purpose_string)) {
+	return BRLCAD_OK;
+    }
+
+    struct _ged_bot_icheck *gib = (struct _ged_bot_icheck *)bs;
+
+    struct rt_bot_internal *bot = (struct rt_bot_internal *)(gib->gb->intern->idb_ptr);
+    struct bu_color *color = gib->gb->color;
+
+    struct bg_trimesh_bvh *bvh = bg_trimesh_bvh_create(bot->faces, bot->num_faces, (const point_t *)bot->vertices, bot->num_vertices);
+    if (!bvh) {
+	bu_vls_printf(gib->vls, "0");
+	return BRLCAD_OK;
+    }
+
+    /* Imported meshes often aren't welded, so neighbors are found by
+     * position as well as by index */
+    struct rt_wdb *wdbp = wdb_dbopen(gib->gb->gedp->dbip, RT_WDB_TYPE_DB_DEFAULT);
+    int *pairs = NULL;
+    size_t npairs = bg_trimesh_bvh_self_isect(gib->gb->visualize ? &pairs : NULL, bvh, &wdbp->wdb_tol, 0);
+    bg_trimesh_bvh_destroy(bvh);
+
+    if (npairs && gib->gb->visualize) {
+	/* Each face once, whichever side of the pair it is on */
+	int *flags = (int *)bu_calloc(bot->num_faces, sizeof(int), "isect face flags");
+	for (size_t i = 0; i < 2 * npairs; i++)
+	    flags[pairs[i]] = 1;
+	struct bg_trimesh_faces *isect_faces = make_faces((int)bot->num_faces);
+	for (size_t i = 0; i < bot->num_faces; i++) {
+	    if (flags[i])
+		isect_faces->faces[isect_faces->count++] = (int)i;
+	}
+	bu_free(flags, "isect face flags");
+
+	struct bg_trimesh_edges *isect_edges = face_edges(*isect_faces, bot);
+	bg_free_trimesh_faces(isect_faces);
+	BU_FREE(isect_faces, struct bg_trimesh_faces);
+
+	struct bg_trimesh_edges *all_edges = edges_from_bot(bot);
+	struct bg_trimesh_edges *other_edges = edges_not_in_lists(*all_edges, isect_edges, 1);
+	bg_free_trimesh_edges(all_edges);
+	BU_FREE(all_edges, struct bg_trimesh_edges);
+
+	struct bu_vls si_name = BU_VLS_INIT_ZERO;
+	bu_vls_sprintf(&si_name, "%s_self_isect", gib->gb->dp->d_namep);
+
+	draw_edges(gib->gb->gedp, bot, isect_edges->count, isect_edges->edges, color, bu_vls_cstr(&si_name));
+	struct bu_color red = BU_COLOR_INIT_ZERO;
+	bu_color_from_str(&red, "255/0/0");
+	draw_edges(gib->gb->gedp, bot, other_edges->count, other_edges->edges, &red, bu_vls_cstr(&si_name));
+
+	bu_vls_free(&si_name);
+
+	bg_free_trimesh_edges(isect_edges);
+	BU_FREE(isect_edges, struct bg_trimesh_edges);
+	bg_free_trimesh_edges(other_edges);
+	BU_FREE(other_edges, struct bg_trimesh_edges);
+    }
+    if (pairs)
+	bu_free(pairs, "isect pairs");
+
+    bu_vls_printf(gib->vls, npairs ? "1" : "0");
+
+    return BRLCAD_OK;
+}
+
+
 extern "C" int
 _bot_cmd_solid(void *bs, int argc, const char **argv)
 {
@@ -734,6 +806,7 @@ const struct bu_cmdtab _bot_check_cmds[] = {
     { "flipped_edges", _bot_cmd_flipped_edges},
     { "manifold",      _bot_cmd_manifold},
     { "open_edges",    _bot_cmd_open_edges},
+    { "self_isect",    _bot_cmd_self_isect},
     { "solid",         _bot_cmd_solid},
     { (char *)NULL,      NULL}
 };
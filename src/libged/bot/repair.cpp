@@ -74,6 +74,19 @@ bot_repair(struct rt_bot_internal *bot, struct rt_bot_repair_info *i)
     return obot;
 }
 
+// Repair closes the mesh but doesn't untangle it - count the face pairs
+// that still cut through each other
+static size_t
+bot_self_isect(struct rt_bot_internal *bot, const struct bn_tol *tol)
+{
+    struct bg_trimesh_bvh *bvh = bg_trimesh_bvh_create(bot->faces, bot->num_faces, (const point_t *)bot->vertices, bot->num_vertices);
+    if (!bvh)
+	return 0;
+    size_t npairs = bg_trimesh_bvh_self_isect(NULL, bvh, tol, 0);
+    bg_trimesh_bvh_destroy(bvh);
+    return npairs;
+}
+
 static void
 repair_usage(struct bu_vls *str, const char *cmd, struct bu_opt_desc *d) {
     char *option_help = bu_opt_describe(d, NULL);
@@ -193,6 +206,10 @@ _bot_cmd_repair(void *bs, int argc, const char **argv)
 	    continue;
 	}
 
+	// Check before writing, since writing releases mbot
+	struct rt_wdb *wdbp = wdb_dbopen(gb->gedp->dbip, RT_WDB_TYPE_DB_DEFAULT);
+	size_t isect_cnt = bot_self_isect(mbot, &wdbp->wdb_tol);
+
 	// If we're repairing and we were able to fix it, write out the result
 	struct rt_db_internal intern;
 	RT_DB_INTERNAL_INIT(&intern);
@@ -229,6 +246,8 @@ _bot_cmd_repair(void *bs, int argc, const char **argv)
 	}
 
 	bu_vls_printf(gb->gedp->ged_result_str, "Repair completed successfully and written to %s\n", rname);
+	if (isect_cnt)
+	    bu_vls_printf(gb->gedp->ged_result_str, "Warning - %s has %zu self-intersecting face pairs\n", rname, isect_cnt);
 
 	rt_db_free_internal(gb->intern);
 	BU_PUT(gb->intern, struct rt_db_internal);
@@ -30,10 +30,14 @@
 #include "common.h"
 
 #include <algorithm>
+#include <cstdio>
 #include <map>
 #include <thread>
 #include <fstream>
 #include <sstream>
+#ifdef HAVE_SYS_STAT_H
+#  include <sys/stat.h>
+#endif
 
 extern "C" {
 #include "lmdb.h"
@@ -44,10 +48,14 @@ extern "C" {
 #include "vmath.h"
 #include "bu/app.h"
 #include "bu/color.h"
+#include "bu/file.h"
 #include "bu/hash.h"
 #include "bu/path.h"
 #include "bu/opt.h"
+#include "bu/parallel.h"
+#include "bu/process.h"
 #include "bu/sort.h"
+#include "bu/time.h"
 #include "bv/lod.h"
 #include "raytrace.h"
 #include "ged/defines.h"
@@ -414,6 +422,559 @@ populate_walk_tree(union tree *tp, void *d, int subtract_skip, int p_op,
     }
 }
 
+/* Pull the drawing related attribute values out of an object's avs.
+ * Values not set on the object come back as region_flag 0, region_id -1,
+ * color_inherit 0 and cval INT_MAX. */
+static void
+dbi_avs_values(int *region_flag, int *region_id, int *color_inherit, unsigned int *cval, struct bu_attribute_value_set *avs)
+{
+    // Check for region flag.
+    const char *region_flag_str = bu_avs_get(avs, "region");
+    *region_flag = (region_flag_str && (BU_STR_EQUAL(region_flag_str, "R") || BU_STR_EQUAL(region_flag_str, "1"))) ? 1 : 0;
+
+    // Check for region id.  For drawing purposes this needs to be a number.
+    *region_id = -1;
+    const char *region_id_val = bu_avs_get(avs, "region_id");
+    if (region_id_val)
+	bu_opt_int(NULL, 1, &region_id_val, (void *)region_id);
+
+    *color_inherit = (BU_STR_EQUAL(bu_avs_get(avs, "inherit"), "1")) ? 1 : 0;
+
+    // Color (note that the rt_material_head colors and a region_id may
+    // override this, as might a parent comb with color and the inherit
+    // flag both set.
+    *cval = INT_MAX;
+    const char *color_val = bu_avs_get(avs, "color");
+    if (!color_val)
+	color_val = bu_avs_get(avs, "rgb");
+    if (color_val) {
+	struct bu_color c = BU_COLOR_INIT_ZERO;
+	int r, g, b;
+	bu_opt_color(NULL, 1, &color_val, (void *)&c);
+	bu_color_to_rgb_ints(&c, &r, &g, &b);
+	*cval = r + (g << 8) + (b << 16);
+    }
+}
+
+static void
+dbi_apply_attrs(DbiState *dbis, unsigned long long hash, int region_flag, int attr_region_id, int color_inherit, unsigned int cval)
+{
+    // If a region flag is set but a region_id is not, there is an implicit
+    // assumption that the region_id is to be regarded as 0.  Not sure this
+    // will always be true, but right now region table based coloring works
+    // that way in existing BRL-CAD code (see the example m35.g model's
+    // all.g/component/power.train/r75 for an instance of this)
+    if (region_flag && attr_region_id == -1)
+	attr_region_id = 0;
+
+    if (attr_region_id != -1)
+	dbis->region_id[hash] = attr_region_id;
+    if (color_inherit)
+	dbis->c_inherit[hash] = color_inherit;
+    if (cval != INT_MAX)
+	dbis->rgb[hash] = cval;
+}
+
+
+/* On open, everything update_dp() would work out for each object - the
+ * comb member lists with their ops and matrices, plus the drawing
+ * attributes - is saved to a snapshot file in the Dbi cache directory.
+ * The data is kept in columns (one array per field) so it can be read
+ * and written in a few large blocks, with the file's size and mtime (to
+ * the nanosecond where the platform has it) in the header.  If those
+ * still match on the next open every record is used as is.  Otherwise
+ * an object that has moved or changed size in the file is read from the
+ * database again, and one still in its old place - which may have been
+ * rewritten in place - is content hashed and only read again if the
+ * hash differs from the one recorded for it.
+ *
+ * Changing the layout requires incrementing DBI_SNAPSHOT_FORMAT. */
+#define DBI_SNAPSHOT_FILE "dbistate"
+#define DBI_SNAPSHOT_MAGIC "DBISTATE"
+#define DBI_SNAPSHOT_FORMAT 2
+
+struct dbi_snapshot_hdr {
+    char magic[8];
+    uint32_t format;
+    uint32_t endian;	// 1 as written - the snapshot is a local cache, not a portable file
+    uint64_t file_size;
+    int64_t file_mtime;	// nanoseconds
+    uint64_t nobj;
+    uint64_t nchild;
+    uint64_t nnames;
+    uint64_t nmats;
+};
+
+struct dbi_columns {
+    // Per object
+    std::vector<uint64_t> hash;		// name hash
+    std::vector<uint64_t> chash;	// content hash of the on-disk object
+    std::vector<int64_t> addr;		// d_addr and d_len when recorded
+    std::vector<uint64_t> len;
+    std::vector<int32_t> region_flag;
+    std::vector<int32_t> region_id;
+    std::vector<int32_t> color_inherit;
+    std::vector<uint32_t> cval;
+    std::vector<uint64_t> child_off;	// nobj + 1 offsets into the per child columns
+    // Per comb member
+    std::vector<uint64_t> name_off;	// offset of the member's name in names
+    std::vector<int32_t> op;
+    std::vector<int64_t> mat;		// index into mats, -1 for identity
+    std::string names;			// NUL terminated member names
+    std::vector<double> mats;		// 16 values per matrix
+};
+
+// An object whose record has to be built from the database
+struct dbi_obj_rec {
+    struct directory *dp = NULL;
+    uint64_t chash = 0;
+    int region_flag = 0;
+    int region_id = -1;
+    int color_inherit = 0;
+    unsigned int cval = INT_MAX;
+    std::vector<std::string> names;
+    std::vector<int> ops;
+    std::vector<int64_t> mat;
+    std::vector<double> mats;
+};
+
+struct dbi_fill_state {
+    struct db_i *dbip;
+    struct directory **dps;	// objects to content hash ...
+    uint64_t *chashes;
+    struct dbi_obj_rec *recs;	// ... or records to build
+    size_t count;
+    size_t current;		// semaphored
+    size_t nworkers;		// semaphored
+    struct resource *res;
+};
+
+static uint64_t
+dbi_obj_chash(struct db_i *dbip, struct directory *dp)
+{
+    struct bu_external ext = BU_EXTERNAL_INIT_ZERO;
+    if (db_get_external(&ext, dp, dbip) < 0)
+	return 0;
+    uint64_t chash = bu_data_hash(ext.ext_buf, ext.ext_nbytes);
+    bu_free_external(&ext);
+    return chash;
+}
+
+static void
+dbi_rec_leaf(void *client_data, const char *name, matp_t c_m, int op)
+{
+    struct dbi_obj_rec *r = (struct dbi_obj_rec *)client_data;
+    r->names.push_back(std::string(name));
+    r->ops.push_back(op);
+    if (!c_m) {
+	r->mat.push_back(-1);
+	return;
+    }
+    r->mat.push_back((int64_t)(r->mats.size() / 16));
+    for (int i = 0; i < 16; i++)
+	r->mats.push_back(c_m[i]);
+}
+
+static void
+dbi_rec_fill(struct dbi_obj_rec *r, struct db_i *dbip, struct resource *resp)
+{
+    struct directory *dp = r->dp;
+    r->chash = dbi_obj_chash(dbip, dp);
+
+    if (dp->d_flags & RT_DIR_COMB) {
+	struct rt_db_internal in;
+	if (rt_db_get_internal(&in, dp, dbip, NULL, resp) >= 0) {
+	    struct rt_comb_internal *comb = (struct rt_comb_internal *)in.idb_ptr;
+	    if (comb->tree)
+		populate_walk_tree(comb->tree, (void *)r, 0, OP_UNION, dbi_rec_leaf);
+	    rt_db_free_internal(&in);
+	}
+    }
+
+    struct bu_attribute_value_set avs = BU_AVS_INIT_ZERO;
+    db5_get_attributes(dbip, &avs, dp);
+    dbi_avs_values(&r->region_flag, &r->region_id, &r->color_inherit, &r->cval, &avs);
+    bu_avs_free(&avs);
+}
+
+static void
+dbi_fill_worker(int UNUSED(cpu), void *data)
+{
+    struct dbi_fill_state *s = (struct dbi_fill_state *)data;
+
+    bu_semaphore_acquire(BU_SEM_GENERAL);
+    struct resource *resp = &s->res[s->nworkers++];
+    bu_semaphore_release(BU_SEM_GENERAL);
+
+    while (1) {
+	bu_semaphore_acquire(BU_SEM_GENERAL);
+	size_t mine = s->current++;
+	bu_semaphore_release(BU_SEM_GENERAL);
+
+	if (mine >= s->count)
+	    break;
+
+	if (s->recs) {
+	    dbi_rec_fill(&s->recs[mine], s->dbip, resp);
+	} else {
+	    s->chashes[mine] = dbi_obj_chash(s->dbip, s->dps[mine]);
+	}
+    }
+}
+
+static void
+dbi_fill_parallel(struct dbi_fill_state *s)
+{
+    if (!s->count)
+	return;
+    size_t ncpu = (size_t)bu_avail_cpus();
+    ncpu = std::max((size_t)1, std::min(ncpu, s->count));
+    std::vector<struct resource> res(ncpu);
+    for (size_t i = 0; i < ncpu; i++)
+	rt_init_resource(&res[i], (int)i, NULL);
+    s->current = 0;
+    s->nworkers = 0;
+    s->res = res.data();
+    bu_parallel(dbi_fill_worker, ncpu, (void *)s);
+    for (size_t i = 0; i < ncpu; i++)
+	rt_clean_resource_basic(NULL, &res[i]);
+}
+
+static bool
+dbi_file_stamp(uint64_t *size, int64_t *mtime, const char *filename)
+{
+    if (!filename)
+	return false;
+#ifdef HAVE_SYS_STAT_H
+    struct stat sb;
+    if (stat(filename, &sb) != 0 || !S_ISREG(sb.st_mode))
+	return false;
+    *size = (uint64_t)sb.st_size;
+#if defined(__APPLE__)
+    *mtime = (int64_t)sb.st_mtimespec.tv_sec * 1000000000 + (int64_t)sb.st_mtimespec.tv_nsec;
+#elif defined(_WIN32)
+    *mtime = (int64_t)sb.st_mtime * 1000000000;
+#else
+    *mtime = (int64_t)sb.st_mtim.tv_sec * 1000000000 + (int64_t)sb.st_mtim.tv_nsec;
+#endif
+    return true;
+#else
+    return false;
+#endif
+}
+
+template <typename T>
+static void
+dbi_col_write(std::ofstream &f, const std::vector<T> &v)
+{
+    if (v.size())
+	f.write(reinterpret_cast<const char *>(v.data()), v.size() * sizeof(T));
+}
+
+template <typename T>
+static bool
+dbi_col_read(std::ifstream &f, std::vector<T> &v, uint64_t n)
+{
+    v.resize(n);
+    if (n)
+	f.read(reinterpret_cast<char *>(v.data()), n * sizeof(T));
+    return f.good();
+}
+
+static bool
+dbi_snapshot_write(const struct dbi_columns &c, uint64_t fsize, int64_t fmtime, const char *path)
+{
+    struct dbi_snapshot_hdr hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, DBI_SNAPSHOT_MAGIC, sizeof(hdr.magic));
+    hdr.format = DBI_SNAPSHOT_FORMAT;
+    hdr.endian = 1;
+    hdr.file_size = fsize;
+    hdr.file_mtime = fmtime;
+    hdr.nobj = c.hash.size();
+    hdr.nchild = c.op.size();
+    hdr.nnames = c.names.size();
+    hdr.nmats = c.mats.size() / 16;
+
+    // Write to the side and move into place, so a reader never sees a
+    // partial snapshot.  The temporary name is unique to this writer, so
+    // two processes opening the same file can't write into each other's.
+    char tmpname[MAXPATHLEN] = {'\0'};
+    snprintf(tmpname, MAXPATHLEN, "%s.%d.%d.%lld", path, bu_pid(), bu_parallel_id(), (long long int)bu_gettime());
+    std::string tmp(tmpname);
+    std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+    if (!f.is_open())
+	return false;
+    f.write(reinterpret_cast<const char *>(&hdr), sizeof(hdr));
+    dbi_col_write(f, c.hash);
+    dbi_col_write(f, c.chash);
+    dbi_col_write(f, c.addr);
+    dbi_col_write(f, c.len);
+    dbi_col_write(f, c.region_flag);
+    dbi_col_write(f, c.region_id);
+    dbi_col_write(f, c.color_inherit);
+    dbi_col_write(f, c.cval);
+    dbi_col_write(f, c.child_off);
+    dbi_col_write(f, c.name_off);
+    dbi_col_write(f, c.op);
+    dbi_col_write(f, c.mat);
+    if (c.names.size())
+	f.write(c.names.data(), c.names.size());
+    dbi_col_write(f, c.mats);
+    f.close();
+    if (!f) {
+	bu_file_delete(tmp.c_str());
+	return false;
+    }
+    if (std::rename(tmp.c_str(), path)) {
+	bu_file_delete(path);
+	if (std::rename(tmp.c_str(), path)) {
+	    bu_file_delete(tmp.c_str());
+	    return false;
+	}
+    }
+    return true;
+}
+
+static bool
+dbi_snapshot_read(struct dbi_columns &c, struct dbi_snapshot_hdr &hdr, const char *path)
+{
+    std::ifstream f(path, std::ios::binary);
+    if (!f.is_open())
+	return false;
+    f.seekg(0, std::ios::end);
+    uint64_t flen = (uint64_t)f.tellg();
+    f.seekg(0, std::ios::beg);
+    if (flen < sizeof(hdr))
+	return false;
+    f.read(reinterpret_cast<char *>(&hdr), sizeof(hdr));
+    if (!f.good() || memcmp(hdr.magic, DBI_SNAPSHOT_MAGIC, sizeof(hdr.magic)) || hdr.format != DBI_SNAPSHOT_FORMAT || hdr.endian != 1)
+	return false;
+
+    // Don't trust the counts until they agree with the file length
+    uint64_t left = flen - sizeof(hdr);
+    if (hdr.nobj > left || hdr.nchild > left || hdr.nnames > left || hdr.nmats > left)
+	return false;
+    uint64_t expected = hdr.nobj * (2 * sizeof(uint64_t) + sizeof(int64_t) + sizeof(uint64_t) + 3 * sizeof(int32_t) + sizeof(uint32_t) + sizeof(uint64_t))
+	+ sizeof(uint64_t) + hdr.nchild * (sizeof(uint64_t) + sizeof(int32_t) + sizeof(int64_t))
+	+ hdr.nnames + hdr.nmats * 16 * sizeof(double);
+    if (expected != left)
+	return false;
+
+    if (!dbi_col_read(f, c.hash, hdr.nobj) ||
+	    !dbi_col_read(f, c.chash, hdr.nobj) ||
+	    !dbi_col_read(f, c.addr, hdr.nobj) ||
+	    !dbi_col_read(f, c.len, hdr.nobj) ||
+	    !dbi_col_read(f, c.region_flag, hdr.nobj) ||
+	    !dbi_col_read(f, c.region_id, hdr.nobj) ||
+	    !dbi_col_read(f, c.color_inherit, hdr.nobj) ||
+	    !dbi_col_read(f, c.cval, hdr.nobj) ||
+	    !dbi_col_read(f, c.child_off, hdr.nobj + 1) ||
+	    !dbi_col_read(f, c.name_off, hdr.nchild) ||
+	    !dbi_col_read(f, c.op, hdr.nchild) ||
+	    !dbi_col_read(f, c.mat, hdr.nchild))
+	return false;
+    c.names.resize(hdr.nnames);
+    if (hdr.nnames)
+	f.read(&c.names[0], hdr.nnames);
+    if (!f.good() || !dbi_col_read(f, c.mats, hdr.nmats * 16))
+	return false;
+
+    // Check the offsets, so using them later can't run off the end
+    if (c.child_off[0] != 0 || c.child_off[hdr.nobj] != hdr.nchild)
+	return false;
+    for (uint64_t i = 0; i < hdr.nobj; i++) {
+	if (c.child_off[i] > c.child_off[i+1])
+	    return false;
+    }
+    if (hdr.nchild && (!hdr.nnames || c.names[hdr.nnames - 1] != '\0'))
+	return false;
+    for (uint64_t i = 0; i < hdr.nchild; i++) {
+	if (c.name_off[i] >= hdr.nnames || c.mat[i] < -1 || c.mat[i] >= (int64_t)hdr.nmats)
+	    return false;
+    }
+    return true;
+}
+
+static void
+dbi_columns_add(struct dbi_columns &c, uint64_t hash, uint64_t chash, struct directory *dp, int region_flag, int region_id, int color_inherit, unsigned int cval)
+{
+    c.hash.push_back(hash);
+    c.chash.push_back(chash);
+    c.addr.push_back((int64_t)dp->d_addr);
+    c.len.push_back((uint64_t)dp->d_len);
+    c.region_flag.push_back(region_flag);
+    c.region_id.push_back(region_id);
+    c.color_inherit.push_back(color_inherit);
+    c.cval.push_back(cval);
+}
+
+static void
+dbi_columns_add_child(struct dbi_columns &c, const char *name, int op, const double *m)
+{
+    c.name_off.push_back(c.names.size());
+    c.names.append(name);
+    c.names.push_back('\0');
+    c.op.push_back(op);
+    if (!m) {
+	c.mat.push_back(-1);
+	return;
+    }
+    c.mat.push_back((int64_t)(c.mats.size() / 16));
+    c.mats.insert(c.mats.end(), m, m + 16);
+}
+
+
+void
+DbiState::populate_all()
+{
+    std::vector<struct directory *> dps;
+    for (int i = 0; i < RT_DBNHASH; i++) {
+	struct directory *dp;
+	for (dp = dbip->dbi_Head[i]; dp != RT_DIR_NULL; dp = dp->d_forw) {
+	    if (dp->d_flags & DB_LS_HIDDEN)
+		continue;
+	    dps.push_back(dp);
+	}
+    }
+
+    // See what the snapshot from the last open (if any) has to offer.
+    // Without a file on disk to check it against, we can't use one.
+    char spath[MAXPATHLEN] = {'\0'};
+    uint64_t fsize = 0;
+    int64_t fmtime = 0;
+    bool have_stamp = (dcache && dbi_file_stamp(&fsize, &fmtime, dbip->dbi_filename));
+    if (have_stamp)
+	bu_dir(spath, MAXPATHLEN, BU_DIR_CACHE, DBI_CACHEDIR, bu_vls_cstr(dcache->fname), DBI_SNAPSHOT_FILE, NULL);
+    struct dbi_columns old;
+    struct dbi_snapshot_hdr hdr;
+    bool have_old = (have_stamp && bu_file_exists(spath, NULL) && dbi_snapshot_read(old, hdr, spath));
+    bool unchanged = (have_old && hdr.file_size == fsize && hdr.file_mtime == fmtime);
+
+    std::unordered_map<uint64_t, size_t> old_ind;
+    for (size_t i = 0; i < old.hash.size(); i++)
+	old_ind[old.hash[i]] = i;
+
+    // Match objects to their old records.  If the file has changed since
+    // the snapshot was written, records are only good for objects whose
+    // contents are the same.  An object that has moved or changed size
+    // is rebuilt without hashing it first (old_src remembers its record,
+    // for checking the rebuilt content hash against); one still in its
+    // old place may have been rewritten in place, so it is hashed.
+    std::vector<uint64_t> hashes(dps.size());
+    std::vector<int64_t> src(dps.size(), -1);
+    std::vector<int64_t> old_src(dps.size(), -1);
+    std::vector<size_t> check;
+    for (size_t i = 0; i < dps.size(); i++) {
+	hashes[i] = bu_data_hash(dps[i]->d_namep, strlen(dps[i]->d_namep)*sizeof(char));
+	std::unordered_map<uint64_t, size_t>::iterator o_it = old_ind.find(hashes[i]);
+	if (o_it == old_ind.end())
+	    continue;
+	size_t o = o_it->second;
+	if (unchanged) {
+	    src[i] = (int64_t)o;
+	    continue;
+	}
+	if (old.addr[o] != (int64_t)dps[i]->d_addr || old.len[o] != (uint64_t)dps[i]->d_len) {
+	    old_src[i] = (int64_t)o;
+	    continue;
+	}
+	src[i] = (int64_t)o;
+	check.push_back(i);
+    }
+    if (check.size()) {
+	std::vector<struct directory *> cdps(check.size());
+	std::vector<uint64_t> chashes(check.size());
+	for (size_t i = 0; i < check.size(); i++)
+	    cdps[i] = dps[check[i]];
+	struct dbi_fill_state s;
+	memset(&s, 0, sizeof(s));
+	s.dbip = dbip;
+	s.dps = cdps.data();
+	s.chashes = chashes.data();
+	s.count = check.size();
+	dbi_fill_parallel(&s);
+	for (size_t i = 0; i < check.size(); i++) {
+	    if (chashes[i] == old.chash[src[check[i]]])
+		continue;
+	    // Whatever the attribute cache has for this object is out of
+	    // date too
+	    clear_cache(dps[check[i]]);
+	    src[check[i]] = -1;
+	}
+    }
+
+    // Build records for everything else
+    std::vector<struct dbi_obj_rec> recs;
+    std::vector<size_t> rec_ind(dps.size(), 0);
+    for (size_t i = 0; i < dps.size(); i++) {
+	if (src[i] >= 0)
+	    continue;
+	rec_ind[i] = recs.size();
+	recs.push_back(dbi_obj_rec());
+	recs.back().dp = dps[i];
+    }
+    if (recs.size()) {
+	struct dbi_fill_state s;
+	memset(&s, 0, sizeof(s));
+	s.dbip = dbip;
+	s.recs = recs.data();
+	s.count = recs.size();
+	dbi_fill_parallel(&s);
+    }
+    for (size_t i = 0; i < dps.size(); i++) {
+	if (old_src[i] >= 0 && recs[rec_ind[i]].chash != old.chash[old_src[i]])
+	    clear_cache(dps[i]);
+    }
+
+    // Assemble the current columns
+    struct dbi_columns cols;
+    cols.child_off.push_back(0);
+    for (size_t i = 0; i < dps.size(); i++) {
+	if (src[i] >= 0) {
+	    size_t o = (size_t)src[i];
+	    dbi_columns_add(cols, hashes[i], old.chash[o], dps[i], old.region_flag[o], old.region_id[o], old.color_inherit[o], old.cval[o]);
+	    for (uint64_t k = old.child_off[o]; k < old.child_off[o+1]; k++) {
+		const double *m = (old.mat[k] < 0) ? NULL : &old.mats[old.mat[k] * 16];
+		dbi_columns_add_child(cols, old.names.c_str() + old.name_off[k], old.op[k], m);
+	    }
+	} else {
+	    struct dbi_obj_rec &r = recs[rec_ind[i]];
+	    dbi_columns_add(cols, hashes[i], r.chash, dps[i], r.region_flag, r.region_id, r.color_inherit, r.cval);
+	    for (size_t k = 0; k < r.names.size(); k++) {
+		const double *m = (r.mat[k] < 0) ? NULL : &r.mats[r.mat[k] * 16];
+		dbi_columns_add_child(cols, r.names[k].c_str(), r.ops[k], m);
+	    }
+	}
+	cols.child_off.push_back(cols.op.size());
+    }
+
+    // Populate the maps, just as update_dp would
+    for (size_t i = 0; i < dps.size(); i++) {
+	unsigned long long hash = hashes[i];
+	d_map[hash] = dps[i];
+	if (dps[i]->d_flags & RT_DIR_COMB) {
+	    struct walk_data d;
+	    d.dbis = this;
+	    d.phash = hash;
+	    for (uint64_t k = cols.child_off[i]; k < cols.child_off[i+1]; k++) {
+		mat_t m;
+		matp_t mp = NULL;
+		if (cols.mat[k] >= 0) {
+		    for (int j = 0; j < 16; j++)
+			m[j] = cols.mats[cols.mat[k] * 16 + j];
+		    mp = m;
+		}
+		populate_leaf((void *)&d, cols.names.c_str() + cols.name_off[k], mp, cols.op[k]);
+	    }
+	}
+	dbi_apply_attrs(this, hash, cols.region_flag[i], cols.region_id[i], cols.color_inherit[i], cols.cval[i]);
+    }
+
+    if (have_stamp && (!unchanged || recs.size() || old.hash.size() != dps.size()))
+	dbi_snapshot_write(cols, fsize, fmtime, spath);
+}
+
 
 DbiState::DbiState(struct ged *ged_p)
 {
@@ -434,12 +995,7 @@ DbiState::DbiState(struct ged *ged_p)
     // Set up cache
     dcache = dbi_cache_open(dbip->dbi_filename);
 
-    for (int i = 0; i < RT_DBNHASH; i++) {
-	struct directory *dp;
-	for (dp = dbip->dbi_Head[i]; dp != RT_DIR_NULL; dp = dp->d_forw) {
-	    update_dp(dp, 0);
-	}
-    }
+    populate_all();
 }
 
 
@@ -476,19 +1032,32 @@ DbiState::populate_maps(struct directory *dp, unsigned long long phash, int rese
 	if (reset && pv_it != p_v.end()) {
 	    pv_it->second.clear();
 	}
+	// The comb cache shares imported combs with librt's path
+	// evaluation - only read the comb ourselves if it isn't enabled
 	struct rt_db_internal in;
-	if (rt_db_get_internal(&in, dp, dbip, NULL, res) < 0)
-	    return;
-	struct rt_comb_internal *comb = (struct rt_comb_internal *)in.idb_ptr;
-	if (!comb->tree)
+	const struct rt_db_internal *ip = db_comb_cache_get(dbip, dp, res);
+	if (!ip) {
+	    if (rt_db_get_internal(&in, dp, dbip, NULL, res) < 0)
+		return;
+	}
+	struct rt_comb_internal *comb = (struct rt_comb_internal *)((ip) ? ip->idb_ptr : in.idb_ptr);
+	if (!comb->tree) {
+	    if (ip)
+		db_comb_cache_release(dbip, ip);
+	    else
+		rt_db_free_internal(&in);
 	    return;
+	}
 
 	std::unordered_map<unsigned long long, unsigned long long> i_count;
 	struct walk_data d;
 	d.dbis = this;
 	d.phash = phash;
 	populate_walk_tree(comb->tree, (void *)&d, 0, OP_UNION, populate_leaf);
-	rt_db_free_internal(&in);
+	if (ip)
+	    db_comb_cache_release(dbip, ip);
+	else
+	    rt_db_free_internal(&in);
     }
 }
 
@@ -890,89 +1459,44 @@ DbiState::update_dp(struct directory *dp, int reset)
     cache_done(dcache);
 
 
-    if (need_region_flag_avs) {
-	if (!loaded_avs) {
-	    db5_get_attributes(dbip, &c_avs, dp);
-	    loaded_avs = true;
-	}
-	// Check for region flag.
-	const char *region_flag_str = bu_avs_get(&c_avs, "region");
-	if (region_flag_str && (BU_STR_EQUAL(region_flag_str, "R") || BU_STR_EQUAL(region_flag_str, "1"))) {
-	    region_flag = 1;
-	}
-
-	std::stringstream s;
-	s.write(reinterpret_cast<const char *>(&region_flag), sizeof(region_flag));
-	cache_write(dcache, hash, CACHE_REGION_FLAG, s);
-    }
+    if (need_region_flag_avs || need_region_id_avs || need_color_inherit_avs || need_cval_avs) {
+	db5_get_attributes(dbip, &c_avs, dp);
+	loaded_avs = true;
 
+	int a_region_flag, a_region_id, a_color_inherit;
+	unsigned int a_cval;
+	dbi_avs_values(&a_region_flag, &a_region_id, &a_color_inherit, &a_cval, &c_avs);
 
-    if (need_region_id_avs) {
-	if (!loaded_avs) {
-	    db5_get_attributes(dbip, &c_avs, dp);
-	    loaded_avs = true;
+	if (need_region_flag_avs) {
+	    region_flag = a_region_flag;
+	    std::stringstream s;
+	    s.write(reinterpret_cast<const char *>(&region_flag), sizeof(region_flag));
+	    cache_write(dcache, hash, CACHE_REGION_FLAG, s);
 	}
-	// Check for region id.  For drawing purposes this needs to be a number.
-	const char *region_id_val = bu_avs_get(&c_avs, "region_id");
-	if (region_id_val)
-	    bu_opt_int(NULL, 1, &region_id_val, (void *)&attr_region_id);
-
-	std::stringstream s;
-	s.write(reinterpret_cast<const char *>(&attr_region_id), sizeof(attr_region_id));
-	cache_write(dcache, hash, CACHE_REGION_ID, s);
-    }
 
-    if (need_color_inherit_avs) {
-	if (!loaded_avs) {
-	    db5_get_attributes(dbip, &c_avs, dp);
-	    loaded_avs = true;
+	if (need_region_id_avs) {
+	    attr_region_id = a_region_id;
+	    std::stringstream s;
+	    s.write(reinterpret_cast<const char *>(&attr_region_id), sizeof(attr_region_id));
+	    cache_write(dcache, hash, CACHE_REGION_ID, s);
 	}
-	color_inherit = (BU_STR_EQUAL(bu_avs_get(&c_avs, "inherit"), "1")) ? 1 : 0;
-
-	std::stringstream s;
-	s.write(reinterpret_cast<const char *>(&color_inherit), sizeof(color_inherit));
-	cache_write(dcache, hash, CACHE_INHERIT_FLAG, s);
-    }
 
-    if (need_cval_avs) {
-	if (!loaded_avs) {
-	    db5_get_attributes(dbip, &c_avs, dp);
-	    loaded_avs = true;
-	}
-	// Color (note that the rt_material_head colors and a region_id may
-	// override this, as might a parent comb with color and the inherit
-	// flag both set.
-	rgb.erase(hash);
-	struct bu_color c = BU_COLOR_INIT_ZERO;
-	const char *color_val = bu_avs_get(&c_avs, "color");
-	if (!color_val)
-	    color_val = bu_avs_get(&c_avs, "rgb");
-	if (color_val){
-	    bu_opt_color(NULL, 1, &color_val, (void *)&c);
-	    cval = color_int(&c);
-	    bu_log("have color: %u\n", cval);
+	if (need_color_inherit_avs) {
+	    color_inherit = a_color_inherit;
+	    std::stringstream s;
+	    s.write(reinterpret_cast<const char *>(&color_inherit), sizeof(color_inherit));
+	    cache_write(dcache, hash, CACHE_INHERIT_FLAG, s);
 	}
 
-	std::stringstream s;
-	s.write(reinterpret_cast<const char *>(&cval), sizeof(cval));
-	cache_write(dcache, hash, CACHE_COLOR, s);
+	if (need_cval_avs) {
+	    cval = a_cval;
+	    std::stringstream s;
+	    s.write(reinterpret_cast<const char *>(&cval), sizeof(cval));
+	    cache_write(dcache, hash, CACHE_COLOR, s);
+	}
     }
 
-    // If a region flag is set but a region_id is not, there is an implicit
-    // assumption that the region_id is to be regarded as 0.  Not sure this
-    // will always be true, but right now region table based coloring works
-    // that way in existing BRL-CAD code (see the example m35.g model's
-    // all.g/component/power.train/r75 for an instance of this)
-    if (region_flag && attr_region_id == -1)
-	attr_region_id = 0;
-
-
-    if (attr_region_id != -1)
-	region_id[hash] = attr_region_id;
-    if (color_inherit)
-	c_inherit[hash] = color_inherit;
-    if (cval != INT_MAX)
-	rgb[hash] = cval;
+    dbi_apply_attrs(this, hash, region_flag, attr_region_id, color_inherit, cval);
 
     // Done with attributes
     if (loaded_avs) {
@@ -1299,7 +1823,13 @@ DbiState::get_bbox(point_t *bbmin, point_t *bbmax, matp_t curr_mat, unsigned lon
 	struct bn_tol tol = BN_TOL_INIT_TOL;
 	mat_t m;
 	MAT_IDN(m);
-	int bret = rt_bound_instance(&bmin, &bmax, dp, dbip, &ttol, &tol, &m, res);
+	// Combs are bounded through their children above - for anything
+	// else, prefer the bounds librt's comb cache may already have
+	int bret = -2;
+	if (!(dp->d_flags & RT_DIR_COMB))
+	    bret = db_comb_cache_bbox(bmin, bmax, dbip, dp, res);
+	if (bret == -2)
+	    bret = rt_bound_instance(&bmin, &bmax, dp, dbip, &ttol, &tol, &m, res);
 	if (bret != -1) {
 	    have_bbox = true;
 
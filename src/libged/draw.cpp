@@ -25,8 +25,18 @@
 
 #include "common.h"
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <set>
+#include <string>
+#include <thread>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <stdlib.h>
 #include <ctype.h>
@@ -37,6 +47,7 @@
 #include "bu/cmd.h"
 #include "bu/hash.h"
 #include "bu/opt.h"
+#include "bu/parallel.h"
 #include "bu/sort.h"
 #include "bu/str.h"
 #include "bv/defines.h"
@@ -104,6 +115,520 @@ draw_free_data(struct bv_scene_obj *s)
 }
 
 
+/* Does vo's adaptive wireframe need to be regenerated for v? */
+static bool
+csg_wireframe_stale(struct bv_scene_obj *vo, struct bview *v)
+{
+    // Check curve scale
+    if (!NEAR_EQUAL(vo->curve_scale, v->gv_s->curve_scale, SMALL_FASTF))
+	return true;
+    // Check point scale
+    if (!NEAR_EQUAL(vo->point_scale, v->gv_s->point_scale, SMALL_FASTF))
+	return true;
+    // Check view scale
+    fastf_t delta = vo->view_scale * 0.1/vo->view_scale;
+    if (!NEAR_EQUAL(vo->view_scale, v->gv_scale, delta))
+	return true;
+    return false;
+}
+
+static void
+csg_wireframe_sync(struct bv_scene_obj *vo, struct bview *v)
+{
+    vo->curve_scale = v->gv_s->curve_scale;
+    vo->point_scale = v->gv_s->point_scale;
+    vo->view_scale = v->gv_scale;
+}
+
+static void
+csg_wireframe_clear(struct bv_scene_obj *vo)
+{
+    struct bu_list *p;
+    while (BU_LIST_WHILE(p, bu_list, &vo->s_vlist)) {
+	BU_LIST_DEQUEUE(p);
+	struct bv_vlist *pv = (struct bv_vlist *)p;
+	BU_FREE(pv, struct bv_vlist);
+    }
+}
+
+// If the object is not visible in the scene, don't change the data.  This
+// check is useful in orthographic camera mode, where we zoom in on a
+// narrow subset of the model and far away objects are still rendered in
+// full detail.  If we have a perspective matrix active don't make this
+// check, since far away objects outside the view obb will be visible.
+static bool
+csg_wireframe_visible(struct bv_scene_obj *vo, struct bview *v)
+{
+    if (v->gv_perspective > SMALL_FASTF)
+	return true;
+    return bg_sat_aabb_obb(vo->bmin, vo->bmax, v->obb_center, v->obb_extent1, v->obb_extent2, v->obb_extent3) ? true : false;
+}
+
+/* Approximate size of vo on screen, in pixels */
+static fastf_t
+csg_wireframe_pixels(struct bv_scene_obj *vo, struct bview *v)
+{
+    fastf_t size = vo->s_size;
+    if (vo->bmin[X] <= vo->bmax[X] && vo->bmin[Y] <= vo->bmax[Y] && vo->bmin[Z] <= vo->bmax[Z])
+	size = DIST_PNT_PNT(vo->bmin, vo->bmax);
+    if (v->gv_size < SMALL_FASTF || !v->gv_width)
+	return MAX_FASTF;
+    return size / (v->gv_size / (fastf_t)v->gv_width);
+}
+
+
+/*
+ * View driven scheduling of adaptive CSG wireframe updates.
+ *
+ * A zoom invalidates the adaptive wireframe of every drawn CSG
+ * primitive at once.  Rather than regenerating each one as the display
+ * manager happens to reach it, the first object drawn after a view
+ * change gathers every stale object for the view, skips the ones
+ * outside the view volume and queues the rest, largest on screen first,
+ * for a set of background threads.  Objects too small to show any more
+ * detail keep their current wireframe.  Each object keeps displaying
+ * its old wireframe until the new one is ready, and finished wireframes
+ * are swapped in as the view is redrawn (see ged_csg_lod_pending()), so
+ * the display refines progressively while zooming and panning stay
+ * interactive.  Another view change drops whatever the old one left
+ * queued.
+ *
+ * The threads only work from copies - the object's on-disk form, the
+ * tolerances and the view settings as of the start of the pass.  Scene
+ * objects and views are only touched by the drawing thread.
+ */
+#define CSG_LOD_MIN_PIXELS 2.0
+
+/* What the adaptive plotters see of the view */
+struct csg_lod_snapshot {
+    struct bview v;
+    struct bview_settings s;
+};
+
+struct csg_lod_job {
+    /* drawing thread only */
+    struct bview *v;
+    struct bv_scene_obj *vo;
+
+    /* worker input */
+    std::shared_ptr<struct csg_lod_snapshot> snap;
+    struct db_i *dbip;
+    struct bu_external ext;
+    std::string name;
+    struct bn_tol tol;
+    fastf_t s_size;
+
+    /* worker output */
+    struct bu_list vhead;
+    int ret;
+
+    /* protected by csg_lod_pool::lock */
+    bool running;
+    bool cancelled;
+};
+
+struct csg_lod_pool {
+    std::mutex lock;
+    std::condition_variable work;
+    std::condition_variable finished;
+    std::deque<struct csg_lod_job *> queue;
+    std::vector<struct csg_lod_job *> done;
+    std::atomic<size_t> ndone;
+    std::vector<std::thread> threads;
+    struct resource *res;
+    bool shutdown;
+
+    csg_lod_pool();
+    ~csg_lod_pool();
+};
+
+struct csg_lod_view_state {
+    mat_t model2view;
+    fastf_t size;
+    int width;
+    int height;
+    fastf_t curve_scale;
+    fastf_t point_scale;
+    std::shared_ptr<struct csg_lod_snapshot> snap;
+    /* queued, running, or finished and waiting to be displayed */
+    std::unordered_map<struct bv_scene_obj *, struct csg_lod_job *> jobs;
+};
+
+static std::unordered_map<struct bview *, csg_lod_view_state> csg_lod_views;
+
+static void
+csg_lod_worker(struct csg_lod_pool *p, struct resource *resp)
+{
+    // The adaptive plotters normally allocate from the shared rt_vlfree
+    // list, which isn't safe to use alongside the drawing thread.
+    // Nothing is ever freed to this list, so every vlist block handed
+    // back is freshly allocated.
+    struct bu_list vlfree;
+    BU_LIST_INIT(&vlfree);
+    rt_vlfree_set(&vlfree);
+
+    std::unique_lock<std::mutex> lk(p->lock);
+    while (1) {
+	p->work.wait(lk, [p]{ return p->shutdown || !p->queue.empty(); });
+	if (p->shutdown)
+	    break;
+	struct csg_lod_job *j = p->queue.front();
+	p->queue.pop_front();
+
+	if (!j->cancelled) {
+	    j->running = true;
+	    lk.unlock();
+
+	    struct rt_db_internal dbintern;
+	    RT_DB_INTERNAL_INIT(&dbintern);
+	    if (rt_db_external5_to_internal5(&dbintern, &j->ext, j->name.c_str(), j->dbip, NULL, resp) >= 0) {
+		if (dbintern.idb_meth && dbintern.idb_meth->ft_adaptive_plot)
+		    j->ret = dbintern.idb_meth->ft_adaptive_plot(&j->vhead, &dbintern, &j->tol, &j->snap->v, j->s_size);
+		rt_db_free_internal(&dbintern);
+	    }
+
+	    lk.lock();
+	    j->running = false;
+	}
+	p->done.push_back(j);
+	p->ndone = p->done.size();
+	p->finished.notify_all();
+    }
+
+    rt_vlfree_set(NULL);
+}
+
+csg_lod_pool::csg_lod_pool() : ndone(0), shutdown(false)
+{
+    size_t nthreads = bu_avail_cpus();
+    const char *tstr = getenv("GED_CSG_LOD_THREADS");
+    if (tstr && atoi(tstr) > 0)
+	nthreads = (size_t)atoi(tstr);
+    nthreads = std::min(nthreads, (size_t)MAX_PSW);
+
+    res = (struct resource *)bu_calloc(nthreads, sizeof(struct resource), "csg lod resources");
+    for (size_t i = 0; i < nthreads; i++)
+	rt_init_resource(&res[i], (int)i, NULL);
+    for (size_t i = 0; i < nthreads; i++)
+	threads.push_back(std::thread(csg_lod_worker, this, &res[i]));
+}
+
+// Jobs still queued are abandoned at shutdown - the threads only need
+// to finish what they're working on.
+csg_lod_pool::~csg_lod_pool()
+{
+    {
+	std::lock_guard<std::mutex> lk(lock);
+	shutdown = true;
+    }
+    work.notify_all();
+    for (size_t i = 0; i < threads.size(); i++)
+	threads[i].join();
+}
+
+static struct csg_lod_pool &
+csg_lod_pool_get(void)
+{
+    static struct csg_lod_pool pool;
+    return pool;
+}
+
+static void
+csg_lod_job_free(struct csg_lod_job *j)
+{
+    struct bu_list *p;
+    while (BU_LIST_WHILE(p, bu_list, &j->vhead)) {
+	BU_LIST_DEQUEUE(p);
+	struct bv_vlist *pv = (struct bv_vlist *)p;
+	BU_FREE(pv, struct bv_vlist);
+    }
+    bu_free_external(&j->ext);
+    delete j;
+}
+
+static struct csg_lod_job *
+csg_lod_job_create(struct bv_scene_obj *vo, struct bview *v, csg_lod_view_state &vs)
+{
+    struct draw_update_data_t *d = (struct draw_update_data_t *)vo->s_i_data;
+    struct db_full_path *fp = (struct db_full_path *)vo->s_path;
+    struct directory *dp = (fp) ? DB_FULL_PATH_CUR_DIR(fp) : (struct directory *)vo->dp;
+    if (!dp || !d->dbip)
+	return NULL;
+
+    struct csg_lod_job *j = new csg_lod_job;
+    BU_EXTERNAL_INIT(&j->ext);
+    if (db_get_external(&j->ext, dp, d->dbip) < 0) {
+	delete j;
+	return NULL;
+    }
+    j->v = v;
+    j->vo = vo;
+    j->snap = vs.snap;
+    j->dbip = d->dbip;
+    j->name = std::string(dp->d_namep);
+    j->tol = *d->tol;
+    j->s_size = vo->s_size;
+    BU_LIST_INIT(&j->vhead);
+    j->ret = -1;
+    j->running = false;
+    j->cancelled = false;
+    return j;
+}
+
+/* Queue regeneration of vos, in the order given */
+static void
+csg_lod_submit(std::vector<struct bv_scene_obj *> &vos, struct bview *v, csg_lod_view_state &vs)
+{
+    std::vector<struct csg_lod_job *> jobs;
+    for (size_t i = 0; i < vos.size(); i++) {
+	struct csg_lod_job *j = csg_lod_job_create(vos[i], v, vs);
+	if (!j)
+	    continue;
+	vs.jobs[vos[i]] = j;
+	jobs.push_back(j);
+    }
+    if (jobs.empty())
+	return;
+
+    struct csg_lod_pool &p = csg_lod_pool_get();
+    {
+	std::lock_guard<std::mutex> lk(p.lock);
+	p.queue.insert(p.queue.end(), jobs.begin(), jobs.end());
+    }
+    p.work.notify_all();
+}
+
+/* Drop all of v's outstanding work.  Queued jobs are freed now, running
+ * and finished ones when they're next collected. */
+static void
+csg_lod_cancel(csg_lod_view_state &vs, bool wait)
+{
+    if (vs.jobs.empty())
+	return;
+
+    struct csg_lod_pool &p = csg_lod_pool_get();
+    std::vector<struct csg_lod_job *> unqueued;
+    {
+	std::unique_lock<std::mutex> lk(p.lock);
+	std::unordered_map<struct bv_scene_obj *, struct csg_lod_job *>::iterator j_it;
+	for (j_it = vs.jobs.begin(); j_it != vs.jobs.end(); j_it++)
+	    j_it->second->cancelled = true;
+	std::deque<struct csg_lod_job *>::iterator q_end;
+	q_end = std::remove_if(p.queue.begin(), p.queue.end(), [&unqueued](struct csg_lod_job *j) {
+		if (!j->cancelled)
+		    return false;
+		unqueued.push_back(j);
+		return true;
+		});
+	p.queue.erase(q_end, p.queue.end());
+
+	// Callers freeing the view may be about to close the database
+	// the running jobs are reading from.
+	if (wait) {
+	    p.finished.wait(lk, [&vs]{
+		    std::unordered_map<struct bv_scene_obj *, struct csg_lod_job *>::iterator r_it;
+		    for (r_it = vs.jobs.begin(); r_it != vs.jobs.end(); r_it++) {
+			if (r_it->second->running)
+			    return false;
+		    }
+		    return true;
+		    });
+	}
+    }
+    vs.jobs.clear();
+
+    for (size_t i = 0; i < unqueued.size(); i++)
+	csg_lod_job_free(unqueued[i]);
+}
+
+/* vo is going away - drop any work queued for it */
+static void
+csg_lod_forget(struct bv_scene_obj *vo)
+{
+    std::unordered_map<struct bview *, csg_lod_view_state>::iterator v_it;
+    for (v_it = csg_lod_views.begin(); v_it != csg_lod_views.end(); v_it++) {
+	std::unordered_map<struct bv_scene_obj *, struct csg_lod_job *>::iterator j_it = v_it->second.jobs.find(vo);
+	if (j_it == v_it->second.jobs.end())
+	    continue;
+	struct csg_lod_job *j = j_it->second;
+	v_it->second.jobs.erase(j_it);
+
+	// Left in the queue, the workers skip it.  A job already running
+	// is allowed to finish, since the object's database may be about
+	// to close.
+	struct csg_lod_pool &p = csg_lod_pool_get();
+	std::unique_lock<std::mutex> lk(p.lock);
+	j->cancelled = true;
+	p.finished.wait(lk, [j]{ return !j->running; });
+    }
+}
+
+/* Display whatever the workers have finished for v */
+static void
+csg_lod_collect(struct bview *v, csg_lod_view_state &vs)
+{
+    struct csg_lod_pool &p = csg_lod_pool_get();
+    if (!p.ndone)
+	return;
+
+    std::vector<struct csg_lod_job *> finished;
+    {
+	std::lock_guard<std::mutex> lk(p.lock);
+	size_t keep = 0;
+	for (size_t i = 0; i < p.done.size(); i++) {
+	    struct csg_lod_job *j = p.done[i];
+	    if (j->cancelled || j->v == v) {
+		finished.push_back(j);
+	    } else {
+		p.done[keep++] = j;
+	    }
+	}
+	p.done.resize(keep);
+	p.ndone = keep;
+    }
+
+    for (size_t i = 0; i < finished.size(); i++) {
+	struct csg_lod_job *j = finished[i];
+	if (!j->cancelled) {
+	    struct bv_scene_obj *vo = j->vo;
+	    vs.jobs.erase(vo);
+	    vo->curve_scale = j->snap->s.curve_scale;
+	    vo->point_scale = j->snap->s.point_scale;
+	    vo->view_scale = j->snap->v.gv_scale;
+	    if (j->ret >= 0 || BU_LIST_NON_EMPTY(&j->vhead)) {
+		csg_wireframe_clear(vo);
+		BU_LIST_APPEND_LIST(&vo->s_vlist, &j->vhead);
+		bv_obj_stale(vo);
+	    }
+	}
+	csg_lod_job_free(j);
+    }
+}
+
+static void
+csg_lod_gather(std::vector<struct bv_scene_obj *> &stale, struct bv_scene_obj *s, struct bview *v)
+{
+    for (size_t i = 0; i < BU_PTBL_LEN(&s->children); i++) {
+	struct bv_scene_obj *sc = (struct bv_scene_obj *)BU_PTBL_GET(&s->children, i);
+	csg_lod_gather(stale, sc, v);
+    }
+    if (!(s->s_type_flags & BV_DB_OBJS) || s->s_flag == DOWN)
+	return;
+    struct bv_scene_obj *vo = bv_obj_for_view(s, v);
+    if (!vo || !(vo->s_type_flags & BV_CSG_LOD) || !vo->s_i_data)
+	return;
+    if (!csg_wireframe_visible(vo, v) || !csg_wireframe_stale(vo, v))
+	return;
+    stale.push_back(vo);
+}
+
+static int csg_wireframe_update(struct bv_scene_obj *vo, struct bview *v, int flag);
+
+/* Queue every visible, stale object in v for regeneration */
+static void
+csg_lod_pass(struct bview *v, csg_lod_view_state &vs)
+{
+    std::vector<struct bv_scene_obj *> stale;
+    struct bu_ptbl *db_objs = bv_view_objs(v, BV_DB_OBJS);
+    if (!db_objs)
+	return;
+    for (size_t i = 0; i < BU_PTBL_LEN(db_objs); i++) {
+	struct bv_scene_obj *g = (struct bv_scene_obj *)BU_PTBL_GET(db_objs, i);
+	csg_lod_gather(stale, g, v);
+    }
+
+    std::vector<std::pair<fastf_t, struct bv_scene_obj *>> queued;
+    for (size_t i = 0; i < stale.size(); i++) {
+	struct bv_scene_obj *vo = stale[i];
+	fastf_t pixels = csg_wireframe_pixels(vo, v);
+
+	// Nothing more would be visible - keep what we have
+	if (pixels < CSG_LOD_MIN_PIXELS && BU_LIST_NON_EMPTY(&vo->s_vlist)) {
+	    csg_wireframe_sync(vo, v);
+	    continue;
+	}
+
+	// The workers read the v5 format - plot anything older here
+	struct draw_update_data_t *d = (struct draw_update_data_t *)vo->s_i_data;
+	if (d->dbip && db_version(d->dbip) < 5) {
+	    csg_wireframe_update(vo, v, 1);
+	    continue;
+	}
+
+	queued.push_back(std::make_pair(pixels, vo));
+    }
+
+    std::stable_sort(queued.begin(), queued.end(), [](const std::pair<fastf_t, struct bv_scene_obj *> &a, const std::pair<fastf_t, struct bv_scene_obj *> &b) {
+	return a.first > b.first;
+    });
+    std::vector<struct bv_scene_obj *> vos;
+    for (size_t i = 0; i < queued.size(); i++)
+	vos.push_back(queued[i].second);
+    csg_lod_submit(vos, v, vs);
+}
+
+/* Called for each CSG LoD object as v is drawn.  Starts a new pass if
+ * the view has changed since the last one, and displays any wireframes
+ * finished since the last redraw. */
+static void
+csg_lod_schedule(struct bv_scene_obj *vo, struct bview *v)
+{
+    csg_lod_view_state &vs = csg_lod_views[v];
+
+    if (!vs.snap || memcmp(vs.model2view, v->gv_model2view, sizeof(mat_t)) ||
+	    !NEAR_EQUAL(vs.size, v->gv_size, SMALL_FASTF) ||
+	    vs.width != v->gv_width || vs.height != v->gv_height ||
+	    !NEAR_EQUAL(vs.curve_scale, v->gv_s->curve_scale, SMALL_FASTF) ||
+	    !NEAR_EQUAL(vs.point_scale, v->gv_s->point_scale, SMALL_FASTF)) {
+	MAT_COPY(vs.model2view, v->gv_model2view);
+	vs.size = v->gv_size;
+	vs.width = v->gv_width;
+	vs.height = v->gv_height;
+	vs.curve_scale = v->gv_s->curve_scale;
+	vs.point_scale = v->gv_s->point_scale;
+
+	csg_lod_cancel(vs, false);
+
+	std::shared_ptr<struct csg_lod_snapshot> snap = std::make_shared<struct csg_lod_snapshot>();
+	snap->v = *v;
+	snap->s = *v->gv_s;
+	snap->v.gv_s = &snap->s;
+	vs.snap = snap;
+
+	csg_lod_pass(v, vs);
+    }
+
+    csg_lod_collect(v, vs);
+
+    // Anything that went stale without a view change - a newly drawn
+    // object, say - is queued on its own.
+    if (csg_wireframe_visible(vo, v) && csg_wireframe_stale(vo, v) && vs.jobs.find(vo) == vs.jobs.end()) {
+	std::vector<struct bv_scene_obj *> vos;
+	vos.push_back(vo);
+	csg_lod_submit(vos, v, vs);
+    }
+}
+
+size_t
+ged_csg_lod_pending(struct bview *v)
+{
+    std::unordered_map<struct bview *, csg_lod_view_state>::iterator v_it = csg_lod_views.find(v);
+    if (v_it == csg_lod_views.end())
+	return 0;
+    return v_it->second.jobs.size();
+}
+
+void
+ged_csg_lod_view_free(struct bview *v)
+{
+    std::unordered_map<struct bview *, csg_lod_view_state>::iterator v_it = csg_lod_views.find(v);
+    if (v_it == csg_lod_views.end())
+	return;
+    csg_lod_cancel(v_it->second, true);
+    csg_lod_views.erase(v_it);
+}
+
+
 static int
 csg_wireframe_update(struct bv_scene_obj *vo, struct bview *v, int flag)
 {
@@ -118,44 +643,27 @@ csg_wireframe_update(struct bv_scene_obj *vo, struct bview *v, int flag)
 
     vo->csg_obj = 1;
 
-    // If the object is not visible in the scene, don't change the data.  This
-    // check is useful in orthographic camera mode, where we zoom in on a
-    // narrow subset of the model and far away objects are still rendered in
-    // full detail.  If we have a perspective matrix active don't make this
-    // check, since far away objects outside the view obb will be visible.
+    if (!flag) {
+	// View change - let the scheduler regenerate this object along
+	// with everything else the change invalidated.  Offscreen objects
+	// still go through the scheduler, so a view showing none of its
+	// objects drops work queued for the previous view.
+	csg_lod_schedule(vo, v);
+	return (csg_wireframe_stale(vo, v)) ? 0 : 1;
+    }
+
     //bu_log("min: %f %f %f max: %f %f %f\n", V3ARGS(vo->bmin), V3ARGS(vo->bmax));
-    if (!(v->gv_perspective > SMALL_FASTF) && !bg_sat_aabb_obb(vo->bmin, vo->bmax, v->obb_center, v->obb_extent1, v->obb_extent2, v->obb_extent3))
+    if (!csg_wireframe_visible(vo, v))
 	return 0;
 
-    bool rework = (flag) ? true : false;
-
-    // Check point scale
-    if (!rework && !NEAR_EQUAL(vo->curve_scale, vo->s_v->gv_s->curve_scale, SMALL_FASTF))
-	rework = true;
-    // Check point scale
-    if (!rework && !NEAR_EQUAL(vo->point_scale, vo->s_v->gv_s->point_scale, SMALL_FASTF))
-	rework = true;
-    if (!rework) {
-	// Check view scale
-	fastf_t delta = vo->view_scale * 0.1/vo->view_scale;
-	if (!NEAR_EQUAL(vo->view_scale, v->gv_scale, delta))
-	    rework = true;
-    }
-    if (!rework)
-	return 0;
+    // Plotting here supersedes anything the scheduler has queued
+    csg_lod_forget(vo);
 
     // We're going to redraw - sync with view
-    vo->curve_scale = v->gv_s->curve_scale;
-    vo->point_scale = v->gv_s->point_scale;
-    vo->view_scale = v->gv_scale;
+    csg_wireframe_sync(vo, v);
 
     // Clear out existing vlists
-    struct bu_list *p;
-    while (BU_LIST_WHILE(p, bu_list, &vo->s_vlist)) {
-	BU_LIST_DEQUEUE(p);
-	struct bv_vlist *pv = (struct bv_vlist *)p;
-	BU_FREE(pv, struct bv_vlist);
-    }
+    csg_wireframe_clear(vo);
 
     struct draw_update_data_t *d = (struct draw_update_data_t *)vo->s_i_data;
     struct db_full_path *fp = (struct db_full_path *)vo->s_path;
@@ -173,10 +681,18 @@ csg_wireframe_update(struct bv_scene_obj *vo, struct bview *v, int flag)
 	vo->s_type_flags |= BV_CSG_LOD;
 	bv_obj_stale(vo);
     }
+    rt_db_free_internal(ip);
 
     return 1;
 }
 
+static void
+csg_wireframe_free(struct bv_scene_obj *vo)
+{
+    csg_lod_forget(vo);
+    draw_free_data(vo);
+}
+
 struct ged_full_detail_clbk_data {
     struct db_i *dbip;
     struct directory *dp;
@@ -577,7 +1093,7 @@ wireframe_plot(struct bv_scene_obj *s, struct bview *v, struct rt_db_internal *i
 	    // We're adaptive - have to plot when the view changes.  Set the
 	    // callbacks
 	    vo->s_update_callback = &csg_wireframe_update;
-	    vo->s_free_callback = &draw_free_data;
+	    vo->s_free_callback = &csg_wireframe_free;
 
 	    // Mark type as CSG LoD
 	    vo->s_type_flags |= BV_CSG_LOD;
@@ -190,6 +190,7 @@ ged_free(struct ged *gedp)
 
     for (size_t i = 0; i < BU_PTBL_LEN(&gedp->ged_free_views); i++) {
 	struct bview *gdvp = (struct bview *)BU_PTBL_GET(&gedp->ged_free_views, i);
+	ged_csg_lod_view_free(gdvp);
 	bv_free(gdvp);
 	bu_free((void *)gdvp, "bv");
     }
@@ -345,7 +345,9 @@ ged_search_core(struct ged *gedp, int argc, const char *argv_orig[])
     int optcnt;
     int aflag = 0; /* flag controlling whether hidden objects are examined */
     int wflag = 0; /* flag controlling whether to fail quietly or not */
-    int flags = 0;
+    /* librt falls back to a serial search for filters (like -exec)
+     * that can't be evaluated concurrently */
+    int flags = DB_SEARCH_PARALLEL;
     int want_help = 0;
     int plan_argv = 1;
     int plan_found = 0;
@@ -627,14 +629,23 @@ ged_search_core(struct ged *gedp, int argc, const char *argv_orig[])
 		    BU_ALLOC(search_results, struct bu_ptbl);
 		    bu_ptbl_init(search_results, 8, "initialize search result table");
 
+		    /* Search all objects in one pass, rather than one
+		     * db_search call per object, so librt can spread the
+		     * work over multiple threads */
+		    struct bu_ptbl all_dps = BU_PTBL_INIT_ZERO;
+		    bu_ptbl_init(&all_dps, 1024, "all objects");
 		    for (k = 0; k < RT_DBNHASH; k++) {
 			struct directory *dp;
 			for (dp = gedp->dbip->dbi_Head[k]; dp != RT_DIR_NULL; dp = dp->d_forw) {
 			    if (dp->d_addr != RT_DIR_PHONY_ADDR) {
-				(void)db_search(search_results, flags, bu_vls_addr(&search_string), 1, &dp, gedp->dbip, clbk, u1, u2);
+				bu_ptbl_ins(&all_dps, (long *)dp);
 			    }
 			}
 		    }
+		    if (BU_PTBL_LEN(&all_dps)) {
+			(void)db_search(search_results, flags, bu_vls_addr(&search_string), (int)BU_PTBL_LEN(&all_dps), (struct directory **)BU_PTBL_BASEADDR(&all_dps), gedp->dbip, clbk, u1, u2);
+		    }
+		    bu_ptbl_free(&all_dps);
 
 		    search_cnt += search_print_objs_to_vls(search_results, gedp->ged_result_str);
 
@@ -0,0 +1,284 @@
+/*                     C S G _ L O D . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file csg_lod.cpp
+ *
+ * View driven regeneration of adaptive CSG wireframes.  After a zoom,
+ * only the objects left in view may be regenerated, largest on screen
+ * first, and ged_csg_lod_pending() must count down to zero as their new
+ * wireframes are displayed.  Panning away from everything must drop
+ * whatever was still queued.
+ */
+
+#include "common.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <bu.h>
+#include <ged.h>
+#include "wdb.h"
+
+#define CSG_LOD_TEST_FILE "csg_lod_test.g"
+#define NSPH 16
+#define SPACING 100.0
+#define MAX_FRAMES 6000		/* 10ms apart */
+
+extern "C" void ged_changed_callback(struct db_i *UNUSED(dbip), struct directory *dp, int mode, void *u_data);
+
+static struct bv_scene_obj *vos[NSPH];
+
+/* A row of spheres along X, each larger than the last */
+static void
+make_geometry(void)
+{
+    struct rt_wdb *wdbp;
+    struct wmember head;
+    point_t center;
+    char name[32];
+
+    bu_file_delete(CSG_LOD_TEST_FILE);
+    wdbp = wdb_fopen(CSG_LOD_TEST_FILE);
+    if (!wdbp)
+	bu_exit(1, "ERROR: unable to create %s\n", CSG_LOD_TEST_FILE);
+
+    BU_LIST_INIT(&head.l);
+    for (int i = 0; i < NSPH; i++) {
+	snprintf(name, sizeof(name), "s%02d.s", i);
+	VSET(center, i * SPACING, 0, 0);
+	mk_sph(wdbp, name, center, 5.0 + 2.0 * i);
+	(void)mk_addmember(name, &head.l, NULL, WMOP_UNION);
+    }
+    mk_lcomb(wdbp, "all.g", &head, 0, NULL, NULL, NULL, 0);
+    wdb_close(wdbp);
+}
+
+/* Find the view objects for the spheres */
+static void
+find_vos(struct bv_scene_obj *s, struct bview *v)
+{
+    for (size_t i = 0; i < BU_PTBL_LEN(&s->children); i++)
+	find_vos((struct bv_scene_obj *)BU_PTBL_GET(&s->children, i), v);
+    struct bv_scene_obj *vo = bv_obj_for_view(s, v);
+    if (!vo)
+	return;
+    const char *n = strrchr(bu_vls_cstr(&vo->s_name), '/');
+    n = (n) ? n + 1 : bu_vls_cstr(&vo->s_name);
+    int i;
+    if (sscanf(n, "s%d.s", &i) == 1 && i >= 0 && i < NSPH)
+	vos[i] = vo;
+}
+
+/* What a display manager does for each drawn object in a redraw */
+static void
+frame_obj(struct bv_scene_obj *s, struct bview *v)
+{
+    if (s->s_flag == DOWN)
+	return;
+    for (size_t i = 0; i < BU_PTBL_LEN(&s->children); i++)
+	frame_obj((struct bv_scene_obj *)BU_PTBL_GET(&s->children, i), v);
+    if (!(s->s_type_flags & BV_DB_OBJS))
+	return;
+    struct bv_scene_obj *vo = bv_obj_for_view(s, v);
+    if (vo && vo->s_update_callback)
+	(*vo->s_update_callback)(vo, v, 0);
+}
+
+static void
+frame(struct bview *v)
+{
+    struct bu_ptbl *db_objs = bv_view_objs(v, BV_DB_OBJS);
+    for (size_t i = 0; db_objs && i < BU_PTBL_LEN(db_objs); i++)
+	frame_obj((struct bv_scene_obj *)BU_PTBL_GET(db_objs, i), v);
+}
+
+static void
+set_view(struct bview *v, fastf_t x, fastf_t size)
+{
+    point_t c;
+    VSET(c, x, 0, 0);
+    MAT_IDN(v->gv_center);
+    MAT_DELTAS_VEC_NEG(v->gv_center, c);
+    v->gv_size = size;
+    v->gv_isize = 1.0 / size;
+    v->gv_scale = 0.5 * size;
+    bv_update(v);
+}
+
+static bool
+current(struct bview *v, int i)
+{
+    return NEAR_EQUAL(vos[i]->view_scale, v->gv_scale, SMALL_FASTF);
+}
+
+/* The generation of the first vlist block, which grows with the order
+ * the wireframes were built in */
+static size_t
+first_gen(int i)
+{
+    if (BU_LIST_IS_EMPTY(&vos[i]->s_vlist))
+	return 0;
+    return BU_LIST_FIRST(bv_vlist, &vos[i]->s_vlist)->gen;
+}
+
+/* Redraw until nothing is pending, checking that every visible object
+ * is either displayed or still pending.  Returns the number of failed
+ * checks. */
+static int
+redraw(const char *stage, struct bview *v, int first_vis, int last_vis)
+{
+    int nvis = last_vis - first_vis + 1;
+
+    for (int f = 0; f < MAX_FRAMES; f++) {
+	frame(v);
+	size_t pending = ged_csg_lod_pending(v);
+	int ncurrent = 0;
+	for (int i = first_vis; i <= last_vis; i++)
+	    ncurrent += (current(v, i)) ? 1 : 0;
+	if (pending + ncurrent != (size_t)nvis) {
+	    bu_log("%s: frame %d: %zu objects pending and %d displayed, expected %d in all\n", stage, f, pending, ncurrent, nvis);
+	    return 1;
+	}
+	if (!pending)
+	    return 0;
+	bu_snooze(10000);
+    }
+
+    bu_log("%s: wireframes still pending after %d frames\n", stage, MAX_FRAMES);
+    return 1;
+}
+
+int
+main(int ac, char *av[])
+{
+    struct ged *gedp;
+    const char *s_av[4] = {NULL};
+    fastf_t scale[NSPH];
+    int ret = 0;
+
+    bu_setprogname(av[0]);
+
+    if (ac != 1)
+	bu_exit(1, "Usage: %s\n", av[0]);
+
+    /* One worker, so the wireframes are built in queue order */
+    bu_setenv("GED_CSG_LOD_THREADS", "1", 1);
+
+    make_geometry();
+
+    gedp = ged_open("db", CSG_LOD_TEST_FILE, 1);
+    if (!gedp)
+	bu_exit(1, "ERROR: unable to open %s\n", CSG_LOD_TEST_FILE);
+    gedp->dbi_state = new DbiState(gedp);
+    gedp->new_cmd_forms = 1;
+    db_add_changed_clbk(gedp->dbip, &ged_changed_callback, (void *)gedp);
+
+    BU_ALLOC(gedp->ged_gvp, struct bview);
+    bv_init(gedp->ged_gvp, &gedp->ged_views);
+    bv_set_add_view(&gedp->ged_views, gedp->ged_gvp);
+    bu_ptbl_ins(&gedp->ged_free_views, (long *)gedp->ged_gvp);
+    bu_vls_sprintf(&gedp->ged_gvp->gv_name, "default");
+
+    struct bview *v = gedp->ged_gvp;
+    v->gv_width = 512;
+    v->gv_height = 512;
+    v->gv_s->adaptive_plot_csg = 1;
+
+    /* Looking down Z, with the row of spheres across the view */
+    MAT_IDN(v->gv_rotation);
+    bv_update(v);
+
+    s_av[0] = "draw";
+    s_av[1] = "all.g";
+    s_av[2] = NULL;
+    ged_exec_draw(gedp, 2, s_av);
+
+    s_av[0] = "autoview";
+    s_av[1] = NULL;
+    ged_exec_autoview(gedp, 1, s_av);
+
+    struct bu_ptbl *db_objs = bv_view_objs(v, BV_DB_OBJS);
+    for (size_t i = 0; db_objs && i < BU_PTBL_LEN(db_objs); i++)
+	find_vos((struct bv_scene_obj *)BU_PTBL_GET(db_objs, i), v);
+    for (int i = 0; i < NSPH; i++) {
+	if (!vos[i])
+	    bu_exit(1, "ERROR: no adaptive wireframe for sphere %d\n", i);
+    }
+
+    /* Everything is in view to start with */
+    ret += redraw("autoview", v, 0, NSPH - 1);
+    for (int i = 0; i < NSPH; i++) {
+	if (!current(v, i)) {
+	    bu_log("autoview: sphere %d was not regenerated\n", i);
+	    ret++;
+	}
+	scale[i] = vos[i]->view_scale;
+    }
+
+    /* Zoom in on spheres 9, 10 and 11 - the nearest of the others is
+     * well outside the view */
+    set_view(v, 10 * SPACING, 3 * SPACING);
+    ret += redraw("zoom", v, 9, 11);
+    for (int i = 0; i < NSPH; i++) {
+	bool visible = (i >= 9 && i <= 11);
+	if (visible && !current(v, i)) {
+	    bu_log("zoom: visible sphere %d was not regenerated\n", i);
+	    ret++;
+	}
+	if (!visible && !NEAR_EQUAL(vos[i]->view_scale, scale[i], SMALL_FASTF)) {
+	    bu_log("zoom: offscreen sphere %d was regenerated\n", i);
+	    ret++;
+	}
+    }
+
+    /* Largest on screen first */
+    if (!(first_gen(11) < first_gen(10) && first_gen(10) < first_gen(9))) {
+	bu_log("zoom: wireframes built in the order %zu %zu %zu (spheres 9, 10, 11), expected the largest first\n",
+	       first_gen(9), first_gen(10), first_gen(11));
+	ret++;
+    }
+
+    /* Zoom in further, then pan away from everything before redrawing
+     * again - nothing may be left pending for the abandoned view */
+    set_view(v, 10 * SPACING, 2 * SPACING);
+    frame(v);
+    set_view(v, -10 * SPACING, 2 * SPACING);
+    frame(v);
+    if (ged_csg_lod_pending(v)) {
+	bu_log("pan: %zu objects pending in an empty view\n", ged_csg_lod_pending(v));
+	ret++;
+    }
+
+    ged_close(gedp);
+    bu_file_delete(CSG_LOD_TEST_FILE);
+
+    if (ret)
+	bu_log("%d adaptive wireframe scheduling checks failed\n", ret);
+    return (ret) ? 1 : 0;
+}
+
+
+// Local Variables:
+// tab-width: 8
+// mode: C++
+// c-basic-offset: 4
+// indent-tabs-mode: t
+// c-file-style: "stroustrup"
+// End:
+// ex: shiftwidth=4 tabstop=8
@@ -0,0 +1,278 @@
+/*                D B I _ S N A P S H O T . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file dbi_snapshot.cpp
+ *
+ * A DbiState set up from the snapshot saved by an earlier open must have
+ * the same maps as one built from scratch - both when the database is
+ * untouched and after edits, including edits that rewrite objects in
+ * place without changing the file's size.
+ */
+
+#include "common.h"
+
+#include <stdio.h>
+
+#include <bu.h>
+#include <ged.h>
+#include "wdb.h"
+
+#define SNAPSHOT_TEST_FILE "dbi_snapshot_test.g"
+#define CACHE_DIR_A "dbi_snapshot_cache_a"
+#define CACHE_DIR_B "dbi_snapshot_cache_b"
+
+struct dbi_maps {
+    std::unordered_map<unsigned long long, std::unordered_set<unsigned long long>> p_c;
+    std::unordered_map<unsigned long long, std::vector<unsigned long long>> p_v;
+    std::unordered_map<unsigned long long, unsigned long long> i_map;
+    std::unordered_map<unsigned long long, std::unordered_map<unsigned long long, std::vector<fastf_t>>> matrices;
+    std::unordered_map<unsigned long long, int> region_id;
+    std::unordered_map<unsigned long long, unsigned int> rgb;
+};
+
+static void
+make_geometry(void)
+{
+    struct rt_wdb *wdbp;
+    struct wmember head;
+    unsigned char red[3] = {255, 0, 0};
+    point_t center;
+    mat_t m;
+
+    bu_file_delete(SNAPSHOT_TEST_FILE);
+    wdbp = wdb_fopen(SNAPSHOT_TEST_FILE);
+    if (!wdbp)
+	bu_exit(1, "ERROR: unable to create %s\n", SNAPSHOT_TEST_FILE);
+
+    VSET(center, 0, 0, 0);
+    mk_sph(wdbp, "s1.s", center, 10.0);
+    mk_sph(wdbp, "s2.s", center, 5.0);
+    mk_sph(wdbp, "s3.s", center, 3.0);
+
+    /* A region with an ID and a color */
+    BU_LIST_INIT(&head.l);
+    MAT_IDN(m);
+    MAT_DELTAS(m, 10, 0, 0);
+    (void)mk_addmember("s1.s", &head.l, m, WMOP_UNION);
+    (void)mk_addmember("s2.s", &head.l, NULL, WMOP_SUBTRACT);
+    mk_lrcomb(wdbp, "r1.r", &head, 1, NULL, NULL, red, 100, 0, 0, 0, 0);
+
+    /* Two instances of the region and a placed sphere */
+    BU_LIST_INIT(&head.l);
+    (void)mk_addmember("r1.r", &head.l, NULL, WMOP_UNION);
+    MAT_DELTAS(m, 0, 50, 0);
+    (void)mk_addmember("r1.r", &head.l, m, WMOP_UNION);
+    MAT_DELTAS(m, 0, 0, 50);
+    (void)mk_addmember("s3.s", &head.l, m, WMOP_UNION);
+    mk_lcomb(wdbp, "c.c", &head, 0, NULL, NULL, NULL, 0);
+
+    BU_LIST_INIT(&head.l);
+    (void)mk_addmember("c.c", &head.l, NULL, WMOP_UNION);
+    mk_lcomb(wdbp, "top.g", &head, 0, NULL, NULL, NULL, 0);
+
+    wdb_close(wdbp);
+}
+
+/* Set up a DbiState with the given cache directory and copy its maps */
+static void
+capture(struct dbi_maps *m, struct ged *gedp, const char *cdir)
+{
+    char dir[MAXPATHLEN] = {'\0'};
+    bu_dir(dir, MAXPATHLEN, BU_DIR_CURR, cdir, NULL);
+    if (!bu_file_exists(dir, NULL))
+	bu_mkdir(dir);
+    bu_setenv("BU_DIR_CACHE", dir, 1);
+
+    DbiState *dbis = new DbiState(gedp);
+    m->p_c = dbis->p_c;
+    m->p_v = dbis->p_v;
+    m->i_map = dbis->i_map;
+    m->matrices = dbis->matrices;
+    m->region_id = dbis->region_id;
+    m->rgb = dbis->rgb;
+    delete dbis;
+}
+
+static int
+compare(const char *stage, const struct dbi_maps *a, const struct dbi_maps *b)
+{
+    int ret = 0;
+    if (a->p_c != b->p_c) {
+	bu_log("%s: p_c differs\n", stage);
+	ret++;
+    }
+    if (a->p_v != b->p_v) {
+	bu_log("%s: p_v differs\n", stage);
+	ret++;
+    }
+    if (a->i_map != b->i_map) {
+	bu_log("%s: i_map differs\n", stage);
+	ret++;
+    }
+    if (a->matrices != b->matrices) {
+	bu_log("%s: matrices differ\n", stage);
+	ret++;
+    }
+    if (a->region_id != b->region_id) {
+	bu_log("%s: region_id differs\n", stage);
+	ret++;
+    }
+    if (a->rgb != b->rgb) {
+	bu_log("%s: rgb differs\n", stage);
+	ret++;
+    }
+    return ret;
+}
+
+static union tree *
+find_leaf(union tree *tp, const char *name)
+{
+    if (!tp)
+	return NULL;
+    switch (tp->tr_op) {
+	case OP_DB_LEAF:
+	    return (BU_STR_EQUAL(tp->tr_l.tl_name, name)) ? tp : NULL;
+	case OP_UNION:
+	case OP_INTERSECT:
+	case OP_SUBTRACT:
+	case OP_XOR:
+	    {
+		union tree *l = find_leaf(tp->tr_b.tb_left, name);
+		return (l) ? l : find_leaf(tp->tr_b.tb_right, name);
+	    }
+	default:
+	    return NULL;
+    }
+}
+
+/* Edits that keep every object's size, so they are written in place
+ * and leave the file the same size as well */
+static int
+edit_in_place(struct db_i *dbip)
+{
+    struct rt_db_internal in;
+    struct directory *dp = db_lookup(dbip, "c.c", LOOKUP_QUIET);
+    if (!dp || rt_db_get_internal(&in, dp, dbip, NULL, &rt_uniresource) < 0)
+	return 1;
+    struct rt_comb_internal *comb = (struct rt_comb_internal *)in.idb_ptr;
+    union tree *leaf = find_leaf(comb->tree, "s3.s");
+    if (!leaf || !leaf->tr_l.tl_mat) {
+	rt_db_free_internal(&in);
+	return 1;
+    }
+    MAT_DELTAS(leaf->tr_l.tl_mat, 0, 0, -50);
+    if (rt_db_put_internal(dp, dbip, &in, &rt_uniresource) < 0)
+	return 1;
+
+    if (db5_update_attribute("r1.r", "region_id", "200", dbip) < 0)
+	return 1;
+    if (db5_update_attribute("r1.r", "rgb", "0/0/255", dbip) < 0)
+	return 1;
+    return 0;
+}
+
+int
+main(int ac, char *av[])
+{
+    struct ged *gedp;
+    struct dbi_maps fresh, reopened;
+    uint64_t size_before, size_after;
+    int ret = 0;
+
+    bu_setprogname(av[0]);
+
+    if (ac != 1)
+	bu_exit(1, "Usage: %s\n", av[0]);
+
+    make_geometry();
+
+    gedp = ged_open("db", SNAPSHOT_TEST_FILE, 1);
+    if (!gedp)
+	bu_exit(1, "ERROR: unable to open %s\n", SNAPSHOT_TEST_FILE);
+
+    /* The first open builds everything and writes the snapshot, the
+     * second is set up from it */
+    capture(&fresh, gedp, CACHE_DIR_A);
+    capture(&reopened, gedp, CACHE_DIR_A);
+    ret += compare("unchanged", &fresh, &reopened);
+
+    /* Give the edits a later mtime than the snapshot recorded, even
+     * with a coarse file system clock */
+    bu_snooze(50000);
+    size_before = (uint64_t)bu_file_size(SNAPSHOT_TEST_FILE);
+    if (edit_in_place(gedp->dbip))
+	bu_exit(1, "ERROR: unable to edit %s\n", SNAPSHOT_TEST_FILE);
+    size_after = (uint64_t)bu_file_size(SNAPSHOT_TEST_FILE);
+    if (size_before != size_after)
+	bu_log("note: in place edits changed the file size\n");
+
+    struct dbi_maps edited;
+    capture(&reopened, gedp, CACHE_DIR_A);
+    capture(&edited, gedp, CACHE_DIR_B);
+    ret += compare("edited in place", &edited, &reopened);
+    if (fresh.matrices == edited.matrices || fresh.region_id == edited.region_id || fresh.rgb == edited.rgb) {
+	bu_log("edits: the test edits didn't change the maps\n");
+	ret++;
+    }
+
+    /* Edits that move objects - a comb gains a member */
+    struct directory *dp = db_lookup(gedp->dbip, "top.g", LOOKUP_QUIET);
+    struct rt_db_internal in;
+    if (!dp || rt_db_get_internal(&in, dp, gedp->dbip, NULL, &rt_uniresource) < 0)
+	bu_exit(1, "ERROR: unable to read top.g\n");
+    struct rt_comb_internal *comb = (struct rt_comb_internal *)in.idb_ptr;
+    union tree *leaf;
+    BU_GET(leaf, union tree);
+    RT_TREE_INIT(leaf);
+    leaf->tr_l.tl_op = OP_DB_LEAF;
+    leaf->tr_l.tl_name = bu_strdup("s2.s");
+    union tree *u;
+    BU_GET(u, union tree);
+    RT_TREE_INIT(u);
+    u->tr_b.tb_op = OP_UNION;
+    u->tr_b.tb_left = comb->tree;
+    u->tr_b.tb_right = leaf;
+    comb->tree = u;
+    if (rt_db_put_internal(dp, gedp->dbip, &in, &rt_uniresource) < 0)
+	bu_exit(1, "ERROR: unable to write top.g\n");
+
+    bu_dirclear(CACHE_DIR_B);
+    capture(&reopened, gedp, CACHE_DIR_A);
+    capture(&edited, gedp, CACHE_DIR_B);
+    ret += compare("resized", &edited, &reopened);
+
+    ged_close(gedp);
+    bu_dirclear(CACHE_DIR_A);
+    bu_dirclear(CACHE_DIR_B);
+    bu_file_delete(SNAPSHOT_TEST_FILE);
+
+    if (ret)
+	bu_log("%d snapshot checks failed\n", ret);
+    return (ret) ? 1 : 0;
+}
+
+
+// Local Variables:
+// tab-width: 8
+// mode: C++
+// c-basic-offset: 4
+// indent-tabs-mode: t
+// c-file-style: "stroustrup"
+// End:
+// ex: shiftwidth=4 tabstop=8
@@ -26,7 +26,7 @@
 
 #include "bu/log.h"
 #include "bu/malloc.h"
-#include "icv.h"
+#include "icv_private.h"
 
 #include "vmath.h"
 
@@ -34,8 +34,12 @@
 
 /* private functions */
 
-static void
-get_kernel(ICV_FILTER filter_type, double *kern, double *offset)
+/*
+ * Fill the 3x3 kernel and output offset for filter_type.  Returns 0,
+ * or -1 if the filter is not implemented.  Shared with native.cpp.
+ */
+int
+icv_filter_kernel(ICV_FILTER filter_type, double *kern, double *offset)
 {
     switch (filter_type) {
 	case ICV_FILTER_LOW_PASS :
@@ -82,10 +86,9 @@ get_kernel(ICV_FILTER filter_type, double *kern, double *offset)
 	    break;
 	default :
 	    bu_log("Filter Type not Implemented.\n");
-	    bu_free(kern, "Freeing Kernel, Wrong filter");
-	    kern = NULL;
+	    return -1;
     }
-    return;
+    return 0;
 }
 
 static void
@@ -167,73 +170,48 @@ get_kernel3(ICV_FILTER3 filter_type, double *kern, double *offset)
 int
 icv_filter(icv_image_t *img, ICV_FILTER filter_type)
 {
-    double *kern = NULL, *kern_p = NULL;
-    double c_val;
-    double *out_data, *in_data, *data_p;
+    double kern[KERN_DEFAULT*KERN_DEFAULT];
     double offset = 0;
-    size_t k_dim = KERN_DEFAULT, k_dim_half, k_dim_half_ceil;
-    size_t size;
-    size_t h, w, k, i;
-    size_t widthstep;
-    size_t index, n_index; /**< index is the index of the pixel in
-			      * out image and n_index corresponds to
-			      * the nearby pixel in input image
-			      */
-
-    /* TODO A new Functionality. Update the get_kernel function to
-     * accommodate the generalized kernel length. This can be based
-     * upon a library of filters or closed form definitions.
-     */
+    double c_val;
+    double *out_data, *in_data;
+    size_t h, w, c, k, i;
+    size_t ch, widthstep;
 
     ICV_IMAGE_VAL_INT(img);
 
-    kern = (double *)bu_malloc(k_dim*k_dim*sizeof(double), "icv_filter : Kernel Allocation");
-    get_kernel(filter_type, kern, &offset);
-
-    if (!kern)
+    if (icv_filter_kernel(filter_type, kern, &offset) < 0)
 	return -1;
 
-    widthstep = img->width*img->channels;
+    ch = img->channels;
+    widthstep = img->width*ch;
 
     in_data = img->data;
-    size = img->height*img->width*img->channels;
     /* Replaces data pointer in place */
-    img->data = out_data = (double*)bu_malloc(size*sizeof(double), "icv_filter : out_image_data");
+    img->data = out_data = (double*)bu_malloc(img->height*widthstep*sizeof(double), "icv_filter : out_image_data");
 
-    /* Kernel Dimension is always considered to be odd*/
-    k_dim_half = k_dim/2*img->channels;
-    k_dim_half_ceil = (k_dim - k_dim/2)*img->channels;
-    index = 0;
+    /* Convolve each channel with the kernel centered on the pixel.
+     * Pixels outside the image are taken to be zero.
+     */
     for (h = 0; h < img->height; h++) {
-	VMOVEN(out_data, in_data+index, k_dim_half);
-	out_data+=k_dim_half;
-
-	for (w = 0; w < widthstep - k_dim*img->channels; w++) {
-	    c_val = 0;
-	    kern_p = kern;
-
-	    for (k = 0; k <= k_dim; k++) {
-		n_index = index + (k-(k_dim/2))*widthstep;
-		data_p = in_data + n_index;
-		for (i = 0; i<=k_dim; i++) {
-		    /* Ensures that the arguments are given a zero value for
-		     * out of bound pixels. Thus behaves similar to zero padding
-		     */
-		    if (n_index < size) {
-			c_val += (*kern_p++)*(*data_p);
-			data_p += img->channels;
-			/* Ensures out bound in image */
-			n_index += img->channels;
+	for (w = 0; w < img->width; w++) {
+	    for (c = 0; c < ch; c++) {
+		c_val = offset;
+		for (k = 0; k < KERN_DEFAULT; k++) {
+		    size_t y = h + k;
+		    if (y < 1 || y > img->height)
+			continue;
+		    y--;
+		    for (i = 0; i < KERN_DEFAULT; i++) {
+			size_t x = w + i;
+			if (x < 1 || x > img->width)
+			    continue;
+			x--;
+			c_val += kern[k*KERN_DEFAULT + i] * in_data[y*widthstep + x*ch + c];
 		    }
 		}
+		*out_data++ = c_val;
 	    }
-	    *out_data = c_val + offset;
-	    out_data++;
-	    index++;
 	}
-	index = (h+1)*widthstep;
-	VMOVEN(out_data,in_data+index -k_dim_half_ceil*img->channels,k_dim_half_ceil*img->channels );
-	out_data+= k_dim_half_ceil;
     }
     bu_free(in_data, "icv:filter Input Image Data");
     return 0;
@@ -20,12 +20,21 @@
 
 #include "common.h"
 #include "bu/mime.h"
+#include "bu/vls.h"
 #include "bio.h" /* for O_BINARY */
 #include "icv.h"
 
 #ifndef ICV_PRIVATE_H
 #define ICV_PRIVATE_H
 
+__BEGIN_DECLS
+
+/* defined in fileformat.c */
+extern bu_mime_image_t icv_guess_file_format(const char *filename, struct bu_vls *trimmedname);
+
+/* defined in native.cpp */
+extern void icv_nrow8(const icv_nimage_t *img, size_t y, unsigned char *rgb);
+
 /* defined in bw.c */
 extern icv_image_t *bw_read(FILE *fp, size_t width, size_t height);
 extern int bw_write(icv_image_t *bif, FILE *fp);
@@ -41,15 +50,21 @@ extern int dpix_write(icv_image_t *bif, FILE *fp);
 /* defined in png.c */
 extern icv_image_t* png_read(FILE *fp);
 extern int png_write(icv_image_t *bif, FILE *fp);
+extern icv_nimage_t* png_nread(FILE *fp, size_t tile);
 
 /* defined in ppm.c */
 extern icv_image_t* ppm_read(FILE *fp);
 extern int ppm_write(icv_image_t *bif, FILE *fp);
 
+/* defined in filter.c */
+extern int icv_filter_kernel(ICV_FILTER filter_type, double *kern, double *offset);
+
 /* defined in rle.c */
 extern icv_image_t* rle_read(FILE *fp);
 extern int rle_write(icv_image_t *bif, FILE *fp);
 
+__END_DECLS
+
 #endif /* ICV_PRIVATE_H */
 
 /*
@@ -0,0 +1,822 @@
+/*                      N A T I V E . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file libicv/native.cpp
+ *
+ * Images kept in their native channel type, optionally tiled.
+ *
+ * The operations here are written once as templates over the channel
+ * type and work a row at a time, a row being walked as a sequence of
+ * contiguous spans so that the same loops serve tiled and scanline
+ * images.  Rows are handed out to all available processors.
+ */
+
+#include "common.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include "bu/log.h"
+#include "bu/malloc.h"
+#include "bu/parallel.h"
+#include "bu/str.h"
+#include "icv_private.h"
+
+/* rows handed to a processor at a time */
+#define ICV_ROW_CHUNK 16
+
+
+/* Channel type traits.  max is the value of a full intensity channel
+ * and to8() quantizes a channel as icv_data2uchar() would.
+ */
+template <typename T> struct icv_chan;
+
+template <> struct icv_chan<unsigned char> {
+    static constexpr double max = 255.0;
+    static inline int to8(unsigned char v) { return v; }
+};
+
+template <> struct icv_chan<uint16_t> {
+    static constexpr double max = 65535.0;
+    static inline int to8(uint16_t v) { return (int)((v * 255 + 32767) / 65535); }
+};
+
+template <> struct icv_chan<float> {
+    static constexpr double max = 1.0;
+    static inline int to8(float v) {
+	long l = lrint(v * 255.0);
+	return (l < 0) ? 0 : ((l > 255) ? 255 : (int)l);
+    }
+};
+
+/* Store v, in units of the channel's max, clamping integer types */
+template <typename T>
+static inline T
+icv_chan_store(double v)
+{
+    if (v <= 0.0)
+	return 0;
+    if (v >= icv_chan<T>::max)
+	return (T)icv_chan<T>::max;
+    return (T)lrint(v);
+}
+
+template <>
+inline float
+icv_chan_store<float>(double v)
+{
+    return (float)v;
+}
+
+
+static size_t
+type_size(ICV_DATA type)
+{
+    switch (type) {
+	case ICV_DATA_UCHAR:
+	    return sizeof(unsigned char);
+	case ICV_DATA_USHORT:
+	    return sizeof(uint16_t);
+	case ICV_DATA_FLOAT:
+	    return sizeof(float);
+	default:
+	    return 0;
+    }
+}
+
+
+/* Call f<T>(args...) for the channel type of img */
+#define ICV_NDISPATCH(_img, _f, ...) \
+    switch ((_img)->type) { \
+	case ICV_DATA_UCHAR: \
+	    _f<unsigned char>(__VA_ARGS__); \
+	    break; \
+	case ICV_DATA_USHORT: \
+	    _f<uint16_t>(__VA_ARGS__); \
+	    break; \
+	default: \
+	    _f<float>(__VA_ARGS__); \
+	    break; \
+    }
+
+
+struct icv_rows {
+    std::atomic<size_t> next;
+    size_t height;
+    const std::function<void(size_t)> *func;
+};
+
+
+static void
+icv_rows_worker(int UNUSED(cpu), void *data)
+{
+    struct icv_rows *r = (struct icv_rows *)data;
+    size_t y;
+
+    while ((y = r->next.fetch_add(ICV_ROW_CHUNK)) < r->height) {
+	size_t end = (y + ICV_ROW_CHUNK < r->height) ? y + ICV_ROW_CHUNK : r->height;
+	for (; y < end; y++)
+	    (*r->func)(y);
+    }
+}
+
+
+/* Run func on every row index below height, in parallel when there
+ * are enough rows to go around.
+ */
+static void
+icv_parallel_rows(size_t height, const std::function<void(size_t)> &func)
+{
+    size_t ncpu = bu_avail_cpus();
+    if (ncpu > MAX_PSW)
+	ncpu = MAX_PSW;
+    if (ncpu > height / ICV_ROW_CHUNK)
+	ncpu = height / ICV_ROW_CHUNK;
+
+    if (ncpu < 2) {
+	for (size_t y = 0; y < height; y++)
+	    func(y);
+	return;
+    }
+
+    struct icv_rows r;
+    r.next = 0;
+    r.height = height;
+    r.func = &func;
+    bu_parallel(icv_rows_worker, ncpu, &r);
+}
+
+
+/* Copy row y of img, as raw channel values, to out */
+template <typename T>
+static void
+icv_rowf(const icv_nimage_t *img, size_t y, double *out)
+{
+    for (size_t x = 0; x < img->width; ) {
+	size_t n = icv_nspan(img, x, y);
+	const T *p = (const T *)icv_npixel(img, x, y);
+	double *o = out + x * img->channels;
+	for (size_t i = 0; i < n * img->channels; i++)
+	    o[i] = p[i];
+	x += n;
+    }
+}
+
+
+/* Store raw channel values from in as row y of img */
+template <typename T>
+static void
+icv_rowstore(icv_nimage_t *img, size_t y, const double *in)
+{
+    for (size_t x = 0; x < img->width; ) {
+	size_t n = icv_nspan(img, x, y);
+	T *p = (T *)icv_npixel(img, x, y);
+	const double *v = in + x * img->channels;
+	for (size_t i = 0; i < n * img->channels; i++)
+	    p[i] = icv_chan_store<T>(v[i]);
+	x += n;
+    }
+}
+
+
+template <typename T>
+static void
+icv_row8(const icv_nimage_t *img, size_t y, unsigned char *rgb)
+{
+    size_t ch = img->channels;
+
+    for (size_t x = 0; x < img->width; ) {
+	size_t n = icv_nspan(img, x, y);
+	const T *p = (const T *)icv_npixel(img, x, y);
+	unsigned char *o = rgb + x * 3;
+	if (ch >= 3) {
+	    for (size_t i = 0; i < n; i++, p += ch, o += 3) {
+		o[0] = (unsigned char)icv_chan<T>::to8(p[0]);
+		o[1] = (unsigned char)icv_chan<T>::to8(p[1]);
+		o[2] = (unsigned char)icv_chan<T>::to8(p[2]);
+	    }
+	} else {
+	    for (size_t i = 0; i < n; i++, p += ch, o += 3)
+		o[0] = o[1] = o[2] = (unsigned char)icv_chan<T>::to8(p[0]);
+	}
+	x += n;
+    }
+}
+
+
+void
+icv_nrow8(const icv_nimage_t *img, size_t y, unsigned char *rgb)
+{
+    ICV_NDISPATCH(img, icv_row8, img, y, rgb);
+}
+
+
+/* Replace the pixels, size and layout of img with those of src,
+ * which is freed.
+ */
+static void
+icv_nswap(icv_nimage_t *img, icv_nimage_t *src)
+{
+    bu_free(img->data, "icv_nimage data");
+    img->data = src->data;
+    img->width = src->width;
+    img->height = src->height;
+    img->tile = src->tile;
+    src->data = NULL;
+    bu_free(src, "icv_nimage");
+}
+
+
+/* begin public functions */
+
+icv_nimage_t *
+icv_ncreate(size_t width, size_t height, ICV_COLOR_SPACE color_space, ICV_DATA type, size_t tile)
+{
+    icv_nimage_t *img;
+    size_t channels, npix;
+
+    if (!type_size(type)) {
+	bu_log("icv_ncreate : unsupported channel type\n");
+	return NULL;
+    }
+
+    switch (color_space) {
+	case ICV_COLOR_SPACE_RGB :
+	    channels = 3;
+	    break;
+	case ICV_COLOR_SPACE_GRAY :
+	    channels = 1;
+	    break;
+	default :
+	    bu_log("icv_ncreate : Color Space Not Defined\n");
+	    return NULL;
+    }
+
+    if (tile) {
+	size_t across = (width + tile - 1) / tile;
+	size_t down = (height + tile - 1) / tile;
+	npix = across * down * tile * tile;
+    } else {
+	npix = width * height;
+    }
+
+    BU_ALLOC(img, struct icv_nimage);
+    img->magic = ICV_NIMAGE_MAGIC;
+    img->color_space = color_space;
+    img->type = type;
+    img->width = width;
+    img->height = height;
+    img->channels = channels;
+    img->tile = tile;
+    img->data = bu_calloc(npix ? npix : 1, channels * type_size(type), "icv_nimage data");
+    return img;
+}
+
+
+int
+icv_ndestroy(icv_nimage_t *img)
+{
+    if (!ICV_NIMAGE_IS_INITIALIZED(img))
+	return -1;
+
+    if (img->data)
+	bu_free(img->data, "icv_nimage data");
+    img->magic = 0;
+    bu_free(img, "icv_nimage");
+    return 0;
+}
+
+
+void *
+icv_npixel(const icv_nimage_t *img, size_t x, size_t y)
+{
+    size_t off;
+
+    if (img->tile) {
+	size_t t = img->tile;
+	size_t across = (img->width + t - 1) / t;
+	off = ((y / t) * across + x / t) * t * t + (y % t) * t + x % t;
+    } else {
+	off = y * img->width + x;
+    }
+    return (char *)img->data + off * img->channels * type_size(img->type);
+}
+
+
+size_t
+icv_nspan(const icv_nimage_t *img, size_t x, size_t UNUSED(y))
+{
+    size_t n = img->width - x;
+
+    if (img->tile && img->tile - x % img->tile < n)
+	n = img->tile - x % img->tile;
+    return n;
+}
+
+
+icv_image_t *
+icv_n2image(const icv_nimage_t *img)
+{
+    if (!ICV_NIMAGE_IS_INITIALIZED(img))
+	return NULL;
+
+    icv_image_t *out = icv_create(img->width, img->height, img->color_space);
+    double scale = 1.0;
+    switch (img->type) {
+	case ICV_DATA_UCHAR:
+	    scale = 1.0 / icv_chan<unsigned char>::max;
+	    break;
+	case ICV_DATA_USHORT:
+	    scale = 1.0 / icv_chan<uint16_t>::max;
+	    break;
+	default:
+	    break;
+    }
+
+    icv_parallel_rows(img->height, [&](size_t y) {
+	double *row = out->data + y * img->width * img->channels;
+	ICV_NDISPATCH(img, icv_rowf, img, y, row);
+	for (size_t i = 0; i < img->width * img->channels; i++)
+	    row[i] *= scale;
+    });
+    return out;
+}
+
+
+icv_nimage_t *
+icv_image2n(const icv_image_t *img, ICV_DATA type, size_t tile)
+{
+    ICV_IMAGE_VAL_PTR(img);
+
+    icv_nimage_t *out = icv_ncreate(img->width, img->height, img->color_space, type, tile);
+    if (!out)
+	return NULL;
+    if (out->channels != img->channels) {
+	bu_log("icv_image2n : channel count does not match color space\n");
+	icv_ndestroy(out);
+	return NULL;
+    }
+
+    double scale = 1.0;
+    switch (type) {
+	case ICV_DATA_UCHAR:
+	    scale = icv_chan<unsigned char>::max;
+	    break;
+	case ICV_DATA_USHORT:
+	    scale = icv_chan<uint16_t>::max;
+	    break;
+	default:
+	    break;
+    }
+
+    icv_parallel_rows(img->height, [&](size_t y) {
+	std::vector<double> row(img->width * img->channels);
+	const double *in = img->data + y * img->width * img->channels;
+	for (size_t i = 0; i < row.size(); i++)
+	    row[i] = in[i] * scale;
+	ICV_NDISPATCH(out, icv_rowstore, out, y, row.data());
+    });
+    return out;
+}
+
+
+icv_nimage_t *
+icv_nread(const char *filename, bu_mime_image_t format, size_t width, size_t height, size_t tile)
+{
+    if (format == BU_MIME_IMAGE_AUTO)
+	format = icv_guess_file_format(filename, NULL);
+
+    if (format != BU_MIME_IMAGE_PIX && format != BU_MIME_IMAGE_BW && format != BU_MIME_IMAGE_PNG) {
+	icv_image_t *dimg = icv_read(filename, format, width, height);
+	if (!dimg)
+	    return NULL;
+	ICV_DATA type = (format == BU_MIME_IMAGE_DPIX) ? ICV_DATA_FLOAT : ICV_DATA_UCHAR;
+	icv_nimage_t *img = icv_image2n(dimg, type, tile);
+	icv_destroy(dimg);
+	return img;
+    }
+
+    FILE *fp = (!filename) ? stdin : fopen(filename, "rb");
+    if (!fp) {
+	bu_log("ERROR: Cannot open file %s for reading\n", filename);
+	return NULL;
+    }
+    if (!filename)
+	setmode(fileno(fp), O_BINARY);
+
+    icv_nimage_t *img = NULL;
+    if (format == BU_MIME_IMAGE_PNG) {
+	img = png_nread(fp, tile);
+    } else {
+	ICV_COLOR_SPACE cs = (format == BU_MIME_IMAGE_PIX) ? ICV_COLOR_SPACE_RGB : ICV_COLOR_SPACE_GRAY;
+	size_t ch = (format == BU_MIME_IMAGE_PIX) ? 3 : 1;
+
+	if (!width || !height) {
+	    /* size unknown, read it all as a single line */
+	    std::vector<unsigned char> buf;
+	    unsigned char chunk[BU_PAGE_SIZE];
+	    size_t got;
+	    while ((got = fread(chunk, 1, sizeof(chunk), fp)) > 0)
+		buf.insert(buf.end(), chunk, chunk + got);
+	    if (buf.size() >= ch) {
+		img = icv_ncreate(buf.size() / ch, 1, cs, ICV_DATA_UCHAR, tile);
+		for (size_t x = 0; x < img->width; ) {
+		    size_t n = icv_nspan(img, x, 0);
+		    memcpy(icv_npixel(img, x, 0), buf.data() + x * ch, n * ch);
+		    x += n;
+		}
+	    }
+	} else {
+	    img = icv_ncreate(width, height, cs, ICV_DATA_UCHAR, tile);
+	    if (!tile) {
+		/* a short file leaves the remaining pixels zero */
+		(void)fread(img->data, 1, width * height * ch, fp);
+	    } else {
+		std::vector<unsigned char> row(width * ch);
+		for (size_t y = 0; y < height; y++) {
+		    if (fread(row.data(), 1, row.size(), fp) != row.size())
+			break;
+		    for (size_t x = 0; x < width; ) {
+			size_t n = icv_nspan(img, x, y);
+			memcpy(icv_npixel(img, x, y), row.data() + x * ch, n * ch);
+			x += n;
+		    }
+		}
+	    }
+	    if (ferror(fp)) {
+		bu_log("icv_nread: Error Occurred while Reading\n");
+		icv_ndestroy(img);
+		img = NULL;
+	    }
+	}
+    }
+
+    if (filename)
+	fclose(fp);
+    return img;
+}
+
+
+int
+icv_nwrite(const icv_nimage_t *img, const char *filename, bu_mime_image_t format)
+{
+    struct bu_vls ofilename = BU_VLS_INIT_ZERO;
+    const char *ofname = filename;
+    bu_mime_image_t oformat = format;
+    int ret = BRLCAD_OK;
+
+    if (!ICV_NIMAGE_IS_INITIALIZED(img))
+	return BRLCAD_ERROR;
+
+    if (oformat == BU_MIME_IMAGE_AUTO) {
+	oformat = icv_guess_file_format(filename, &ofilename);
+	if (filename)
+	    ofname = bu_vls_cstr(&ofilename);
+    }
+
+    if (img->type != ICV_DATA_UCHAR
+	|| !((oformat == BU_MIME_IMAGE_PIX && img->channels == 3)
+	     || (oformat == BU_MIME_IMAGE_BW && img->channels == 1))) {
+	icv_image_t *dimg = icv_n2image(img);
+	bu_vls_free(&ofilename);
+	if (!dimg)
+	    return BRLCAD_ERROR;
+	ret = icv_write(dimg, filename, format);
+	icv_destroy(dimg);
+	return ret;
+    }
+
+    FILE *fp = (ofname == NULL) ? stdout : fopen(ofname, "wb");
+    if (UNLIKELY(fp == NULL)) {
+	perror("fopen");
+	bu_log("ERROR: icv_nwrite failed to get a FILE pointer for %s\n", filename);
+	bu_vls_free(&ofilename);
+	return BRLCAD_ERROR;
+    }
+    if (!ofname)
+	setmode(fileno(fp), O_BINARY);
+
+    if (!img->tile) {
+	size_t nbytes = img->width * img->height * img->channels;
+	if (fwrite(img->data, 1, nbytes, fp) != nbytes)
+	    ret = BRLCAD_ERROR;
+    } else {
+	for (size_t y = 0; y < img->height && ret == BRLCAD_OK; y++) {
+	    for (size_t x = 0; x < img->width; ) {
+		size_t n = icv_nspan(img, x, y);
+		if (fwrite(icv_npixel(img, x, y), 1, n * img->channels, fp) != n * img->channels) {
+		    ret = BRLCAD_ERROR;
+		    break;
+		}
+		x += n;
+	    }
+	}
+    }
+    if (ret != BRLCAD_OK)
+	bu_log("icv_nwrite : Short Write\n");
+
+    fflush(fp);
+    if (ofname)
+	fclose(fp);
+    bu_vls_free(&ofilename);
+    return ret;
+}
+
+
+int
+icv_ndiff(int *matching, int *off_by_1, int *off_by_many, const icv_nimage_t *img1, const icv_nimage_t *img2)
+{
+    if (!ICV_NIMAGE_IS_INITIALIZED(img1) || !ICV_NIMAGE_IS_INITIALIZED(img2))
+	return -1;
+
+    std::atomic<long> n_match(0), n_off1(0), n_many(0);
+    size_t s1 = img1->width * img1->height;
+    size_t s2 = img2->width * img2->height;
+    size_t smin = (s1 < s2) ? s1 : s2;
+    size_t smax = (s1 > s2) ? s1 : s2;
+    int same_width = (img1->width == img2->width);
+
+    /* Like icv_diff, pixels are paired by their position in scanline
+     * order, which is their location when the images match in width.
+     */
+    icv_parallel_rows(img1->height, [&](size_t y) {
+	size_t first = y * img1->width;
+	if (first >= smin)
+	    return;
+	size_t n = (smin - first < img1->width) ? smin - first : img1->width;
+	std::vector<unsigned char> a(img1->width * 3), b(img1->width * 3);
+	std::vector<unsigned char> b2(img2->width * 3);
+	icv_nrow8(img1, y, a.data());
+	if (same_width) {
+	    icv_nrow8(img2, y, b.data());
+	} else {
+	    size_t cached = (size_t)-1;
+	    for (size_t i = 0; i < n; i++) {
+		size_t p = first + i;
+		size_t y2 = p / img2->width;
+		if (y2 != cached) {
+		    icv_nrow8(img2, y2, b2.data());
+		    cached = y2;
+		}
+		memcpy(&b[i * 3], &b2[(p % img2->width) * 3], 3);
+	    }
+	}
+	long m = 0, o1 = 0, om = 0;
+	for (size_t i = 0; i < n; i++) {
+	    int dcnt = (a[i*3+0] != b[i*3+0]) + (a[i*3+1] != b[i*3+1]) + (a[i*3+2] != b[i*3+2]);
+	    m += (dcnt == 0);
+	    o1 += (dcnt == 1);
+	    om += (dcnt > 1);
+	}
+	n_match += m;
+	n_off1 += o1;
+	n_many += om;
+    });
+
+    if (smin != smax)
+	n_many += (long)(smax - smin);
+
+    if (matching)
+	(*matching) += (int)n_match;
+    if (off_by_1)
+	(*off_by_1) += (int)n_off1;
+    if (off_by_many)
+	(*off_by_many) += (int)n_many;
+
+    return (n_off1 || n_many) ? 1 : 0;
+}
+
+
+icv_nimage_t *
+icv_ndiffimg(const icv_nimage_t *img1, const icv_nimage_t *img2)
+{
+    if (!ICV_NIMAGE_IS_INITIALIZED(img1) || !ICV_NIMAGE_IS_INITIALIZED(img2) || !img1->width)
+	return NULL;
+
+    if ((img1->width != img2->width) || (img1->height != img2->height)) {
+	bu_log("icv_ndiffimg : Image Parameters not Equal");
+	return NULL;
+    }
+
+    icv_nimage_t *out = icv_ncreate(img1->width, img1->height, ICV_COLOR_SPACE_RGB, ICV_DATA_UCHAR, 0);
+
+    icv_parallel_rows(img1->height, [&](size_t y) {
+	std::vector<unsigned char> a(img1->width * 3), b(img1->width * 3);
+	unsigned char *od = (unsigned char *)icv_npixel(out, 0, y);
+	icv_nrow8(img1, y, a.data());
+	icv_nrow8(img2, y, b.data());
+	for (size_t i = 0; i < img1->width; i++) {
+	    int r1 = a[i*3+0], g1 = a[i*3+1], b1 = a[i*3+2];
+	    int dcnt = (r1 != b[i*3+0]) + (g1 != b[i*3+1]) + (b1 != b[i*3+2]);
+	    unsigned char p;
+	    switch (dcnt) {
+		case 0:
+		    p = (unsigned char)(((22937 * r1 + 36044 * g1 + 6553 * b1) >> 17) / 2);
+		    break;
+		case 1:
+		    p = 0xC0;
+		    break;
+		default:
+		    p = 0xFF;
+	    }
+	    od[3*i+0] = od[3*i+1] = od[3*i+2] = p;
+	}
+    });
+    return out;
+}
+
+
+template <typename T>
+static void
+icv_nfilter_row(const icv_nimage_t *img, icv_nimage_t *out, size_t y, const double *kern, double offset)
+{
+    size_t ch = img->channels;
+    size_t stride = img->width * ch;
+    std::vector<double> rows(3 * stride, 0.0), res(stride);
+
+    /* rows below and above the image are zero */
+    for (int k = 0; k < 3; k++) {
+	if ((k == 0 && y == 0) || (k == 2 && y + 1 >= img->height))
+	    continue;
+	icv_rowf<T>(img, y + k - 1, &rows[k * stride]);
+    }
+
+    offset *= icv_chan<T>::max;
+    for (size_t x = 0; x < img->width; x++) {
+	for (size_t c = 0; c < ch; c++) {
+	    double v = offset;
+	    for (int k = 0; k < 3; k++) {
+		const double *r = &rows[k * stride];
+		if (x > 0)
+		    v += kern[k*3+0] * r[(x-1)*ch + c];
+		v += kern[k*3+1] * r[x*ch + c];
+		if (x + 1 < img->width)
+		    v += kern[k*3+2] * r[(x+1)*ch + c];
+	    }
+	    res[x*ch + c] = v;
+	}
+    }
+    icv_rowstore<T>(out, y, res.data());
+}
+
+
+int
+icv_nfilter(icv_nimage_t *img, ICV_FILTER filter_type)
+{
+    double kern[9];
+    double offset = 0;
+
+    if (!ICV_NIMAGE_IS_INITIALIZED(img))
+	return -1;
+
+    if (icv_filter_kernel(filter_type, kern, &offset) < 0)
+	return -1;
+
+    icv_nimage_t *out = icv_ncreate(img->width, img->height, img->color_space, img->type, img->tile);
+
+    icv_parallel_rows(img->height, [&](size_t y) {
+	ICV_NDISPATCH(img, icv_nfilter_row, img, out, y, kern, offset);
+    });
+
+    icv_nswap(img, out);
+    return 0;
+}
+
+
+template <typename T>
+static void
+icv_nshrink_row(const icv_nimage_t *img, icv_nimage_t *out, size_t j, size_t factor)
+{
+    size_t ch = img->channels;
+    std::vector<double> row(img->width * ch), acc(out->width * ch, 0.0);
+
+    for (size_t py = 0; py < factor; py++) {
+	icv_rowf<T>(img, j * factor + py, row.data());
+	for (size_t i = 0; i < out->width; i++)
+	    for (size_t px = 0; px < factor; px++)
+		for (size_t c = 0; c < ch; c++)
+		    acc[i*ch + c] += row[(i*factor + px)*ch + c];
+    }
+    for (size_t k = 0; k < acc.size(); k++)
+	acc[k] /= (double)(factor * factor);
+    icv_rowstore<T>(out, j, acc.data());
+}
+
+
+template <typename T>
+static void
+icv_nbinterp_row(const icv_nimage_t *img, icv_nimage_t *out, size_t j, double xstep, double ystep)
+{
+    size_t ch = img->channels;
+    std::vector<double> low(img->width * ch), upp(img->width * ch), res(out->width * ch);
+    double y = j * ystep;
+    double dy = y - (int)y;
+
+    icv_rowf<T>(img, (size_t)y, low.data());
+    icv_rowf<T>(img, (size_t)(y + 1), upp.data());
+
+    for (size_t i = 0; i < out->width; i++) {
+	double x = i * xstep;
+	double dx = x - (int)x;
+	const double *low_c = &low[(size_t)x * ch];
+	const double *upp_c = &upp[(size_t)x * ch];
+	for (size_t c = 0; c < ch; c++) {
+	    double mid1 = low_c[c] + dx * (low_c[c + ch] - low_c[c]);
+	    double mid2 = upp_c[c] + dx * (upp_c[c + ch] - upp_c[c]);
+	    res[i*ch + c] = mid1 + dy * (mid2 - mid1);
+	}
+    }
+    icv_rowstore<T>(out, j, res.data());
+}
+
+
+int
+icv_nresize(icv_nimage_t *img, ICV_RESIZE_METHOD method, size_t out_width, size_t out_height, size_t factor)
+{
+    double xstep = 0, ystep = 0;
+
+    if (!ICV_NIMAGE_IS_INITIALIZED(img))
+	return -1;
+
+    switch (method) {
+	case ICV_RESIZE_UNDERSAMPLE :
+	case ICV_RESIZE_SHRINK :
+	    if (UNLIKELY(factor < 1)) {
+		bu_log("Cannot shrink image to 0 factor, factor should be a positive value.");
+		return -1;
+	    }
+	    out_width = img->width / factor;
+	    out_height = img->height / factor;
+	    break;
+	case ICV_RESIZE_NINTERP :
+	case ICV_RESIZE_BINTERP :
+	    if (!out_width || !out_height || img->width < 2 || img->height < 2)
+		return -1;
+	    xstep = (double)(img->width - 1) / (double)out_width - 1.0e-6;
+	    ystep = (double)(img->height - 1) / (double)out_height - 1.0e-6;
+	    if ((xstep < 1.0 && ystep > 1.0) || (xstep > 1.0 && ystep < 1.0)) {
+		bu_log("Operation unsupported.  Cannot stretch one dimension while compressing the other.\n");
+		return -1;
+	    }
+	    break;
+	default :
+	    bu_log("icv_nresize : Invalid Option to resize");
+	    return -1;
+    }
+
+    icv_nimage_t *out = icv_ncreate(out_width, out_height, img->color_space, img->type, img->tile);
+    size_t psize = img->channels * type_size(img->type);
+
+    icv_parallel_rows(out_height, [&](size_t j) {
+	switch (method) {
+	    case ICV_RESIZE_UNDERSAMPLE :
+		for (size_t i = 0; i < out_width; i++)
+		    memcpy(icv_npixel(out, i, j), icv_npixel(img, i * factor, j * factor), psize);
+		break;
+	    case ICV_RESIZE_SHRINK :
+		ICV_NDISPATCH(img, icv_nshrink_row, img, out, j, factor);
+		break;
+	    case ICV_RESIZE_NINTERP :
+		for (size_t i = 0; i < out_width; i++)
+		    memcpy(icv_npixel(out, i, j), icv_npixel(img, (size_t)(i * xstep), (size_t)(j * ystep)), psize);
+		break;
+	    default :
+		ICV_NDISPATCH(img, icv_nbinterp_row, img, out, j, xstep, ystep);
+		break;
+	}
+    });
+
+    icv_nswap(img, out);
+    return 0;
+}
+
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C++
+ * c-basic-offset: 4
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
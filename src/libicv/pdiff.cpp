@@ -34,7 +34,7 @@
 
 #include "PImgHash.h"
 
-#include "icv.h"
+#include "icv_private.h"
 
 #include "bio.h"
 #include "bu/log.h"
@@ -77,16 +77,41 @@ load_icv(icv_image_t *img, imghash::Preprocess *prep)
 }
 
 
-extern "C" uint32_t
-icv_pdiff(icv_image_t *img1, icv_image_t *img2)
+static void
+load_nicv(const icv_nimage_t *img, imghash::Preprocess *prep)
 {
-    if (!img1 || !img2)
-	return -1;
+    std::vector<uint8_t> row(img->width * 3);
+    prep->start(img->height, img->width, 3);
+    for (size_t i = 0; i < img->height; i++) {
+	icv_nrow8(img, img->height - 1 - i, row.data());
+	prep->add_row(row.data());
+    }
+}
+
 
+static uint32_t
+pdiff_images(const imghash::Image<float> &pimg1, const imghash::Image<float> &pimg2)
+{
     std::unique_ptr<imghash::Hasher> hasher;
     int dct_size = 4; // 1024 bits
     hasher = std::make_unique<imghash::DCTHasher>(8 * dct_size, true);
 
+    auto hash1 = hasher->apply(pimg1);
+    auto hash2 = hasher->apply(pimg2);
+
+    //std::cout << "hash1:" << format_hash(hash1) << "\n";
+    //std::cout << "hash2:" << format_hash(hash2) << "\n";
+
+    return hasher->hamming_distance(hash1, hash2);
+}
+
+
+extern "C" uint32_t
+icv_pdiff(icv_image_t *img1, icv_image_t *img2)
+{
+    if (!img1 || !img2)
+	return -1;
+
     int d1 = (img1->width < img1->height) ? img1->width : img1->height;
     imghash::Preprocess prep1(d1, d1);
     load_icv(img1, &prep1);
@@ -97,13 +122,27 @@ icv_pdiff(icv_image_t *img1, icv_image_t *img2)
     load_icv(img2, &prep2);
     imghash::Image<float> pimg2 = prep2.stop();
 
-    auto hash1 = hasher->apply(pimg1);
-    auto hash2 = hasher->apply(pimg2);
+    return pdiff_images(pimg1, pimg2);
+}
 
-    //std::cout << "hash1:" << format_hash(hash1) << "\n";
-    //std::cout << "hash2:" << format_hash(hash2) << "\n";
 
-    return hasher->hamming_distance(hash1, hash2);
+extern "C" uint32_t
+icv_npdiff(const icv_nimage_t *img1, const icv_nimage_t *img2)
+{
+    if (!ICV_NIMAGE_IS_INITIALIZED(img1) || !ICV_NIMAGE_IS_INITIALIZED(img2))
+	return -1;
+
+    int d1 = (img1->width < img1->height) ? img1->width : img1->height;
+    imghash::Preprocess prep1(d1, d1);
+    load_nicv(img1, &prep1);
+    imghash::Image<float> pimg1 = prep1.stop();
+
+    int d2 = (img2->width < img2->height) ? img2->width : img2->height;
+    imghash::Preprocess prep2(d2, d2);
+    load_nicv(img2, &prep2);
+    imghash::Image<float> pimg2 = prep2.stop();
+
+    return pdiff_images(pimg1, pimg2);
 }
 
 /*
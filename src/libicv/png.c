@@ -21,6 +21,7 @@
 #include "common.h"
 
 #include <stdlib.h>
+#include <string.h>
 #include "png.h"
 
 #include "bio.h"
@@ -79,39 +80,40 @@ png_write(icv_image_t *bif, FILE *fp)
     return BRLCAD_OK;
 }
 
-icv_image_t *
-png_read(FILE *fp)
+/*
+ * Check the signature and set up png_p and info_p to deliver RGB rows
+ * of 8 bit channels, or of 16 bit channels if keep_16 is set and the
+ * file has them.  Returns the bit depth of the rows, or 0 on failure.
+ */
+static int
+png_read_start(FILE *fp, png_structp *png_pp, png_infop *info_pp, int keep_16)
 {
     if (UNLIKELY(!fp))
-	return NULL;
+	return 0;
 
     char header[8];
     if (fread(header, 8, 1, fp) != 1) {
 	bu_log("png-pix: ERROR: Failed while reading file header!!!\n");
-	return NULL;
+	return 0;
     }
 
     if (png_sig_cmp((png_bytep)header, 0, 8)) {
 	bu_log("png-pix: This is not a PNG file!!!\n");
-	return NULL;
+	return 0;
     }
 
     png_structp png_p = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
     if (!png_p) {
 	bu_log("png-pix: png_create_read_struct() failed!!\n");
-	return NULL;
+	return 0;
     }
 
     png_infop info_p = png_create_info_struct(png_p);
     if (!info_p) {
 	bu_log("png-pix: png_create_info_struct() failed!!\n");
-	return NULL;
+	return 0;
     }
 
-    icv_image_t *bif;
-    BU_ALLOC(bif, struct icv_image);
-    ICV_IMAGE_INIT(bif);
-
     png_init_io(png_p, fp);
     png_set_sig_bytes(png_p, 8);
     png_read_info(png_p, info_p);
@@ -121,10 +123,12 @@ png_read(FILE *fp)
     }
     png_set_expand(png_p);
     int bit_depth = png_get_bit_depth(png_p, info_p);
-    if (bit_depth == 16) png_set_strip_16(png_p);
-
-    bif->width = png_get_image_width(png_p, info_p);
-    bif->height = png_get_image_height(png_p, info_p);
+    if (bit_depth == 16 && !keep_16) {
+	png_set_strip_16(png_p);
+	bit_depth = 8;
+    }
+    if (bit_depth < 8)
+	bit_depth = 8;
 
     png_color_16p input_backgrd;
     if (png_get_bKGD(png_p, info_p, &input_backgrd)) {
@@ -141,6 +145,27 @@ png_read(FILE *fp)
 
     png_read_update_info(png_p, info_p);
 
+    *png_pp = png_p;
+    *info_pp = info_p;
+    return bit_depth;
+}
+
+
+icv_image_t *
+png_read(FILE *fp)
+{
+    png_structp png_p;
+    png_infop info_p;
+
+    if (!png_read_start(fp, &png_p, &info_p, 0))
+	return NULL;
+
+    icv_image_t *bif;
+    BU_ALLOC(bif, struct icv_image);
+    ICV_IMAGE_INIT(bif);
+
+    bif->width = png_get_image_width(png_p, info_p);
+    bif->height = png_get_image_height(png_p, info_p);
 
     /* allocate memory for image */
     unsigned char *image = (unsigned char *)bu_calloc(1, bif->width*bif->height*3, "image");
@@ -163,6 +188,63 @@ png_read(FILE *fp)
 }
 
 
+icv_nimage_t *
+png_nread(FILE *fp, size_t tile)
+{
+    png_structp png_p;
+    png_infop info_p;
+    int bit_depth = png_read_start(fp, &png_p, &info_p, 1);
+
+    if (!bit_depth)
+	return NULL;
+
+    size_t width = png_get_image_width(png_p, info_p);
+    size_t height = png_get_image_height(png_p, info_p);
+    ICV_DATA type = (bit_depth == 16) ? ICV_DATA_USHORT : ICV_DATA_UCHAR;
+    icv_nimage_t *img = icv_ncreate(width, height, ICV_COLOR_SPACE_RGB, type, tile);
+    size_t rowbytes = png_get_rowbytes(png_p, info_p);
+    unsigned char *image = NULL;
+    unsigned char **rows = (unsigned char **)bu_calloc(height, sizeof(unsigned char *), "png_nread : rows");
+
+    /* PNG rows run top to bottom.  8 bit scanline images can be read
+     * in place, anything else is read whole and then scattered.
+     */
+    if (type == ICV_DATA_UCHAR && !tile) {
+	for (size_t i = 0; i < height; i++)
+	    rows[height - 1 - i] = (unsigned char *)icv_npixel(img, 0, i);
+    } else {
+	image = (unsigned char *)bu_malloc(rowbytes * height, "png_nread : image");
+	for (size_t i = 0; i < height; i++)
+	    rows[height - 1 - i] = image + i * rowbytes;
+    }
+
+    png_read_image(png_p, rows);
+    png_read_end(png_p, NULL);
+
+    for (size_t y = 0; image && y < height; y++) {
+	for (size_t x = 0; x < width; ) {
+	    size_t n = icv_nspan(img, x, y);
+	    if (type == ICV_DATA_UCHAR) {
+		memcpy(icv_npixel(img, x, y), image + y*rowbytes + x*3, n*3);
+	    } else {
+		/* 16 bit values are stored big endian */
+		uint16_t *dp = (uint16_t *)icv_npixel(img, x, y);
+		const unsigned char *cp = image + y*rowbytes + x*3*2;
+		for (size_t c = 0; c < n*3; c++, cp += 2)
+		    dp[c] = (uint16_t)((cp[0] << 8) | cp[1]);
+	    }
+	    x += n;
+	}
+    }
+
+    if (image)
+	bu_free(image, "png_nread : image");
+    bu_free(rows, "png_nread : rows");
+    png_destroy_read_struct(&png_p, &info_p, NULL);
+    return img;
+}
+
+
 /*
  * Local Variables:
  * mode: C
@@ -298,6 +298,7 @@ shrink_image(icv_image_t* bif, size_t factor)
     double *p;
     size_t facsq, py, px;
     size_t x, y, c;
+    size_t out_width, out_height;
     size_t widthstep =  bif->width*bif->channels;
     if (UNLIKELY(factor < 1)) {
 	bu_log("Cannot shrink image to 0 factor, factor should be a positive value.");
@@ -308,15 +309,20 @@ shrink_image(icv_image_t* bif, size_t factor)
     res_p = bif->data;
     p = (double *)bu_malloc(bif->channels*sizeof(double), "shrink_image : Pixel Values Temp Buffer");
 
-    for (y = 0; y < bif->height; y += factor)
-	for (x = 0; x < bif->width; x += factor) {
+    /* Partial blocks at the right and top edges are dropped.  Output
+     * pixels never overtake the input still to be read, so this can
+     * be done in place. */
+    out_width = bif->width/factor;
+    out_height = bif->height/factor;
+    for (y = 0; y < out_height*factor; y += factor)
+	for (x = 0; x < out_width*factor; x += factor) {
 
 	    for (c = 0; c < bif->channels; c++) {
 		p[c]= 0;
 	    }
 
 	    for (py = 0; py < factor; py++) {
-		data_p = bif->data + (y+py)*widthstep;
+		data_p = bif->data + (y+py)*widthstep + x*bif->channels;
 		for (px = 0; px < factor; px++) {
 		    for (c = 0; c < bif->channels; c++) {
 			p[c] += *data_p++;
@@ -327,9 +333,10 @@ shrink_image(icv_image_t* bif, size_t factor)
 	    for (c = 0; c < bif->channels; c++)
 		*res_p++ = p[c]/facsq;
 	}
+    bu_free(p, "shrink_image : Pixel Values Temp Buffer");
 
-    bif->width = (int)bif->width/factor;
-    bif->height = (int)bif->height/factor;
+    bif->width = out_width;
+    bif->height = out_height;
     bif->data = (double *)bu_realloc(bif->data, (size_t)(bif->width*bif->height*bif->channels)*sizeof(double), "shrink_image : Reallocation");
 
     return 0;
@@ -351,15 +358,16 @@ under_sample(icv_image_t* bif, size_t factor)
     widthstep = bif->width*bif->channels;
     res_p = bif->data;
 
-    for (y = 0; y < bif->height; y += factor) {
+    /* As in shrink_image, partial blocks are dropped */
+    for (y = 0; y < (bif->height/factor)*factor; y += factor) {
 	data_p = bif->data + widthstep*y;
-	for (x = 0; x < bif->width;
+	for (x = 0; x < (bif->width/factor)*factor;
 	     x += factor, res_p += bif->channels, data_p += factor * bif->channels)
 	    VMOVEN(res_p, data_p, bif->channels);
     }
 
-    bif->width = (int)bif->width/factor;
-    bif->height = (int)bif->height/factor;
+    bif->width = bif->width/factor;
+    bif->height = bif->height/factor;
     bif->data = (double *)bu_realloc(bif->data, (size_t)(bif->width*bif->height*bif->channels)*sizeof(double), "under_sample : Reallocation");
 
     return 0;
@@ -0,0 +1,251 @@
+/*                    I C V _ N A T I V E . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file icv_native.c
+ *
+ * Checks that native images agree with each other across channel
+ * types and layouts, and with the double based images.
+ *
+ */
+
+#include "common.h"
+
+#include <math.h>
+
+#include "bu/app.h"
+#include "bu/log.h"
+#include "icv.h"
+
+#define W 67
+#define H 45
+
+/* Tolerances against the double images: floats are stored exactly,
+ * 8 bit channels are rounded to the nearest level */
+#define FLOAT_TOL 1.0e-5
+#define UCHAR_TOL (0.5 / 255.0 + 1.0e-6)
+
+/* An operation run on both the double and the native images */
+struct op {
+    const char *name;
+    int filter;
+    ICV_FILTER filter_type;
+    ICV_RESIZE_METHOD method;
+    size_t width, height, factor;
+};
+
+static const struct op ops[] = {
+    {"low pass", 1, ICV_FILTER_LOW_PASS, ICV_RESIZE_SHRINK, 0, 0, 0},
+    {"laplacian", 1, ICV_FILTER_LAPLACIAN, ICV_RESIZE_SHRINK, 0, 0, 0},
+    {"shrink", 0, ICV_FILTER_NULL, ICV_RESIZE_SHRINK, 0, 0, 3},
+    {"undersample", 0, ICV_FILTER_NULL, ICV_RESIZE_UNDERSAMPLE, 0, 0, 3},
+    {"ninterp", 0, ICV_FILTER_NULL, ICV_RESIZE_NINTERP, 100, 70, 0},
+    {"binterp up", 0, ICV_FILTER_NULL, ICV_RESIZE_BINTERP, 100, 70, 0},
+    {"binterp down", 0, ICV_FILTER_NULL, ICV_RESIZE_BINTERP, 30, 20, 0},
+    {NULL, 0, ICV_FILTER_NULL, ICV_RESIZE_SHRINK, 0, 0, 0}
+};
+
+
+static icv_image_t *
+dpattern(void)
+{
+    icv_image_t *dimg = icv_create(W, H, ICV_COLOR_SPACE_RGB);
+    size_t i;
+
+    for (i = 0; i < W*H*3; i++)
+	dimg->data[i] = (double)((i * 37) % 256) / 255.0;
+
+    return dimg;
+}
+
+
+static icv_nimage_t *
+pattern(ICV_DATA type, size_t tile)
+{
+    icv_image_t *dimg = dpattern();
+    icv_nimage_t *img = icv_image2n(dimg, type, tile);
+    icv_destroy(dimg);
+    return img;
+}
+
+
+static int
+check_same(const char *what, const icv_nimage_t *a, const icv_nimage_t *b)
+{
+    int matching = 0, off_by_1 = 0, off_by_many = 0;
+
+    if (icv_ndiff(&matching, &off_by_1, &off_by_many, a, b) || matching != (int)(a->width * a->height)) {
+	bu_log("%s: %d matching, %d off by 1, %d off by many\n", what, matching, off_by_1, off_by_many);
+	return 1;
+    }
+    return 0;
+}
+
+
+/* Compare a native image with a double image, channel by channel.
+ * Integer channels can't hold values outside [0, 1], so the reference
+ * is clamped for those. */
+static int
+check_close(const char *what, const icv_nimage_t *img, const icv_image_t *ref, double tol)
+{
+    icv_image_t *dimg = icv_n2image(img);
+    size_t i, bad = 0;
+    int clamp = (img->type != ICV_DATA_FLOAT);
+
+    if (!dimg || dimg->width != ref->width || dimg->height != ref->height || dimg->channels != ref->channels) {
+	bu_log("%s: %zu x %zu, expected %zu x %zu\n", what, img->width, img->height, ref->width, ref->height);
+	if (dimg)
+	    icv_destroy(dimg);
+	return 1;
+    }
+
+    for (i = 0; i < ref->width*ref->height*ref->channels; i++) {
+	double r = ref->data[i];
+	if (clamp)
+	    r = (r < 0.0) ? 0.0 : ((r > 1.0) ? 1.0 : r);
+	if (fabs(dimg->data[i] - r) > tol) {
+	    if (!bad)
+		bu_log("%s: channel %zu is %g, expected %g\n", what, i, dimg->data[i], r);
+	    bad++;
+	}
+    }
+    icv_destroy(dimg);
+
+    if (bad) {
+	bu_log("%s: %zu of %zu channels differ\n", what, bad, ref->width*ref->height*ref->channels);
+	return 1;
+    }
+    return 0;
+}
+
+
+/* Run an operation on the double image and on fresh native images,
+ * which must come out the same */
+static int
+check_op(const struct op *o)
+{
+    icv_image_t *ref = dpattern();
+    icv_nimage_t *f32 = pattern(ICV_DATA_FLOAT, 0);
+    icv_nimage_t *u8t = pattern(ICV_DATA_UCHAR, 16);
+    char what[64];
+    int ret = 0;
+
+    if (o->filter) {
+	ret += (icv_filter(ref, o->filter_type) < 0);
+	ret += (icv_nfilter(f32, o->filter_type) < 0);
+	ret += (icv_nfilter(u8t, o->filter_type) < 0);
+    } else {
+	ret += (icv_resize(ref, o->method, o->width, o->height, o->factor) < 0);
+	ret += (icv_nresize(f32, o->method, o->width, o->height, o->factor) < 0);
+	ret += (icv_nresize(u8t, o->method, o->width, o->height, o->factor) < 0);
+    }
+    if (ret) {
+	bu_log("%s: operation failed\n", o->name);
+    } else {
+	snprintf(what, sizeof(what), "%s (float)", o->name);
+	ret += check_close(what, f32, ref, FLOAT_TOL);
+	snprintf(what, sizeof(what), "%s (8 bit tiled)", o->name);
+	ret += check_close(what, u8t, ref, UCHAR_TOL);
+    }
+
+    icv_destroy(ref);
+    icv_ndestroy(f32);
+    icv_ndestroy(u8t);
+    return ret;
+}
+
+
+int
+main(int UNUSED(argc), char *argv[])
+{
+    int ret = 0;
+    int matching = 0, off_by_1 = 0, off_by_many = 0;
+    icv_nimage_t *u8, *u8t, *u16t, *f32;
+    icv_image_t *dimg;
+    unsigned char *p;
+    const struct op *o;
+
+    bu_setprogname(argv[0]);
+
+    u8 = pattern(ICV_DATA_UCHAR, 0);
+    u8t = pattern(ICV_DATA_UCHAR, 16);
+    u16t = pattern(ICV_DATA_USHORT, 8);
+    f32 = pattern(ICV_DATA_FLOAT, 0);
+
+    /* the same pixels whatever the type and layout */
+    ret += check_same("tiled", u8, u8t);
+    ret += check_same("16 bit", u8, u16t);
+    ret += check_same("float", u8, f32);
+
+    /* and the same as the double image they were made from */
+    dimg = dpattern();
+    ret += check_close("icv_n2image round trip", u8t, dimg, UCHAR_TOL);
+    ret += check_close("icv_n2image round trip (16 bit)", u16t, dimg, 0.5 / 65535.0 + 1.0e-9);
+    ret += check_close("icv_n2image round trip (float)", f32, dimg, FLOAT_TOL);
+    icv_destroy(dimg);
+
+    /* a changed pixel is found in the right place */
+    p = (unsigned char *)icv_npixel(u8t, 40, 30);
+    p[1] ^= 0x80;
+    matching = off_by_1 = off_by_many = 0;
+    if (!icv_ndiff(&matching, &off_by_1, &off_by_many, u8, u8t) || off_by_1 != 1 || off_by_many != 0) {
+	bu_log("icv_ndiff: missed a changed pixel\n");
+	ret++;
+    }
+    p[1] ^= 0x80;
+
+    /* operations give the same result on every layout */
+    icv_nfilter(u8, ICV_FILTER_LOW_PASS);
+    icv_nfilter(u8t, ICV_FILTER_LOW_PASS);
+    ret += check_same("icv_nfilter", u8, u8t);
+
+    icv_nresize(u8, ICV_RESIZE_SHRINK, 0, 0, 3);
+    icv_nresize(u8t, ICV_RESIZE_SHRINK, 0, 0, 3);
+    ret += check_same("icv_nresize", u8, u8t);
+    if (u8->width != W/3 || u8->height != H/3) {
+	bu_log("icv_nresize: wrong size %zu x %zu\n", u8->width, u8->height);
+	ret++;
+    }
+
+    icv_nresize(u8, ICV_RESIZE_BINTERP, 100, 70, 0);
+    icv_nresize(u8t, ICV_RESIZE_BINTERP, 100, 70, 0);
+    ret += check_same("icv_nresize binterp", u8, u8t);
+
+    /* and the same result as icv_filter and icv_resize */
+    for (o = ops; o->name; o++)
+	ret += check_op(o);
+
+    icv_ndestroy(u8);
+    icv_ndestroy(u8t);
+    icv_ndestroy(u16t);
+    icv_ndestroy(f32);
+
+    if (ret)
+	bu_log("%d native image checks failed\n", ret);
+    return ret;
+}
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
@@ -26,15 +26,28 @@
 #include "common.h"
 
 #include <stddef.h>
+#include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <ctype.h>
 
 #include "vmath.h"
+#include "bu/parallel.h"
 #include "raytrace.h"
 #include "optical.h"
 
 
+/* Footprints of at least this many texels are filtered from the
+ * summed-area table instead of by visiting every texel.
+ */
+#define TXT_SAT_MIN 64
+
+/* Box sums are taken in modular 32 bit arithmetic, which is exact
+ * as long as the true sum fits.  Larger footprints use the loop.
+ */
+#define TXT_SAT_MAX ((fastf_t)(UINT32_MAX / 255))
+
+
 #define TXT_NAME_LEN 128
 struct txt_specific {
     int tx_transp[3];	/* RGB for transparency */
@@ -51,6 +64,9 @@ struct txt_specific {
     char tx_datasrc; /* which type of datasource */
     struct rt_binunif_internal *tx_binunifp;  /* db internal object when TXT_SRC_OBJECT */
     struct bu_mapped_file *tx_mp;    /* mapped file when TXT_SRC_FILE */
+    const uint32_t *tx_sat;	/* summed-area table, built on first use */
+    uint32_t *tx_sat_buf;	/* tx_sat storage owned by this texture, if any */
+    int tx_sat_failed;	/* boolean: texture data can't support a table */
 };
 #define TX_NULL ((struct txt_specific *)0)
 #define TX_O(m) bu_offsetof(struct txt_specific, m)
@@ -130,9 +146,11 @@ txt_transp_hook(const struct bu_structparse *sdp,
  * (there is no specific unload_datasource function).
  */
 static int
-txt_load_datasource(struct txt_specific *texture, struct db_i *dbInstance, const size_t size)
+txt_load_datasource(struct txt_specific *texture, struct db_i *dbInstance, int pixelbytes)
 {
     struct directory *dirEntry;
+    const size_t size = (size_t)texture->tx_w * texture->tx_n * pixelbytes;
+    char appl[64];
 
     RT_CK_DBI(dbInstance);
 
@@ -194,7 +212,12 @@ txt_load_datasource(struct txt_specific *texture, struct db_i *dbInstance, const
      */
     if (((texture->tx_datasrc==TXT_SRC_AUTO) && (texture->tx_binunifp==NULL)) || (texture->tx_datasrc==TXT_SRC_FILE)) {
 
-	texture->tx_mp = bu_open_mapped_file_with_path(dbInstance->dbi_filepath,	bu_vls_addr(&texture->tx_name), NULL);
+	/* tag the mapping with the layout so that mp->apbuf, which
+	 * holds the summed-area table, is only shared by textures that
+	 * read the file the same way.
+	 */
+	snprintf(appl, sizeof(appl), "txt.%dx%dx%d", texture->tx_w, texture->tx_n, pixelbytes);
+	texture->tx_mp = bu_open_mapped_file_with_path(dbInstance->dbi_filepath,	bu_vls_addr(&texture->tx_name), appl);
 
 	if (texture->tx_mp==NULL)
 	    return -1;				/* FAIL */
@@ -216,6 +239,126 @@ txt_load_datasource(struct txt_specific *texture, struct db_i *dbInstance, const
 }
 
 
+struct txt_sat_info {
+    const unsigned char *pix;
+    int w, n, ch;
+};
+
+
+/*
+ * Build the summed-area table of a w x n image with ch bytes per
+ * pixel.  Entry (x, y) of the table, for 0 <= x <= w and 0 <= y <= n,
+ * holds ch per-channel sums of all pixels left of column x and below
+ * line y.  Suitable for use as an rt_sidecar_fill_t.
+ */
+static int
+txt_sat_fill(void *dest, size_t UNUSED(len), const struct bu_mapped_file *UNUSED(src), void *data)
+{
+    struct txt_sat_info *info = (struct txt_sat_info *)data;
+    size_t row = (size_t)(info->w + 1) * info->ch;
+    uint32_t *sat = (uint32_t *)dest;
+    uint32_t line[3];
+    int x, y, c;
+
+    memset(sat, 0, row * sizeof(uint32_t));
+
+    for (y = 0; y < info->n; y++) {
+	const uint32_t *prev = sat + y * row;
+	uint32_t *cur = sat + (y + 1) * row;
+	const unsigned char *cp = info->pix + (size_t)y * info->w * info->ch;
+
+	for (c = 0; c < info->ch; c++)
+	    cur[c] = line[c] = 0;
+
+	for (x = 1; x <= info->w; x++) {
+	    for (c = 0; c < info->ch; c++) {
+		line[c] += *cp++;
+		cur[x * info->ch + c] = prev[x * info->ch + c] + line[c];
+	    }
+	}
+    }
+    return 1;
+}
+
+
+/*
+ * Make tp->tx_sat available, building it if this is its first use.
+ * Tables for mapped files are hung off mp->apbuf, and kept in a
+ * sidecar where possible, so that every region and process using the
+ * image shares one copy.  Returns 0 if there can be no table, in which
+ * case the texture is filtered texel by texel.
+ */
+static int
+txt_sat_prep(struct txt_specific *tp, int ch)
+{
+    struct txt_sat_info info;
+    size_t len = (size_t)tp->tx_w * tp->tx_n * ch;
+    size_t nbytes = (size_t)(tp->tx_w + 1) * (tp->tx_n + 1) * ch * sizeof(uint32_t);
+
+    if (tp->tx_sat)
+	return 1;
+    if (tp->tx_sat_failed)
+	return 0;
+
+    info.w = tp->tx_w;
+    info.n = tp->tx_n;
+    info.ch = ch;
+
+    /* short images wrap around in the lookup, which a table can't do */
+    if (tp->tx_mp && tp->tx_mp->buflen >= len) {
+	const uint32_t *sat;
+	char kind[64];
+
+	info.pix = (const unsigned char *)tp->tx_mp->buf;
+	snprintf(kind, sizeof(kind), "txt_sat.%dx%dx%d", tp->tx_w, tp->tx_n, ch);
+	sat = (const uint32_t *)rt_sidecar_apbuf(tp->tx_mp, kind, nbytes, txt_sat_fill, &info);
+
+	if (sat) {
+	    bu_semaphore_acquire(RT_SEM_MODEL);
+	    tp->tx_sat = sat;
+	    bu_semaphore_release(RT_SEM_MODEL);
+	    return 1;
+	}
+    }
+
+    if (tp->tx_binunifp && tp->tx_binunifp->count >= len) {
+	uint32_t *buf = (uint32_t *)bu_malloc(nbytes, "txt_sat_prep table");
+
+	info.pix = (const unsigned char *)tp->tx_binunifp->u.uint8;
+	(void)txt_sat_fill(buf, nbytes, NULL, &info);
+
+	bu_semaphore_acquire(RT_SEM_MODEL);
+	if (tp->tx_sat) {
+	    bu_free(buf, "txt_sat_prep table");
+	} else {
+	    tp->tx_sat_buf = buf;
+	    tp->tx_sat = buf;
+	}
+	bu_semaphore_release(RT_SEM_MODEL);
+	return 1;
+    }
+
+    tp->tx_sat_failed = 1;
+    return 0;
+}
+
+
+/*
+ * Sum of channel c over columns x0 <= x < x1 of lines y0 <= y < y1.
+ */
+static inline fastf_t
+txt_sat_sum(const struct txt_specific *tp, int ch, int c, int x0, int y0, int x1, int y1)
+{
+    const uint32_t *sat = tp->tx_sat;
+    size_t row = (size_t)(tp->tx_w + 1) * ch;
+    uint32_t sum;
+
+    sum = sat[y1 * row + x1 * ch + c] - sat[y0 * row + x1 * ch + c]
+	- sat[y1 * row + x0 * ch + c] + sat[y0 * row + x0 * ch + c];
+    return (fastf_t)sum;
+}
+
+
 /*
  * Given a u, v coordinate within the texture (0 <= u, v <= 1.0),
  * return a pointer to the relevant pixel.
@@ -332,6 +475,54 @@ txt_render(struct application *ap, const struct partition *pp, struct shadework
 	r = *cp++;
 	g = *cp++;
 	b = *cp;
+    } else if ((dx + 1.0) * (dy + 1.0) >= TXT_SAT_MIN
+	       && (dx + 1.0) * (dy + 1.0) <= TXT_SAT_MAX
+	       && xmax > xmin && ymax > ymin
+	       && txt_sat_prep(tp, 3)) {
+	/* Area weighted average of the footprint from the table.
+	 * Interior texels have unit weight; the partial coverage of
+	 * the first and last column and line is taken off the full
+	 * sum, adding back the corners where they overlap.
+	 */
+	fastf_t xstart, xstop, ystart, ystop;
+	fastf_t fx0, fx1, fy0, fy1;
+	fastf_t sum[3];
+	int x0, x1, y0, y1;
+	int c;
+
+	xstart = xmin * (tp->tx_w-1);
+	xstop = xmax * (tp->tx_w-1);
+	ystart = ymin * (tp->tx_n-1);
+	ystop = ymax * (tp->tx_n-1);
+
+	x0 = xstart;
+	x1 = xstop;
+	y0 = ystart;
+	y1 = ystop;
+
+	fx0 = xstart - x0;
+	fx1 = x1 + 1 - xstop;
+	fy0 = ystart - y0;
+	fy1 = y1 + 1 - ystop;
+
+	if (optical_debug & OPTICAL_DEBUG_SHADE)
+	    bu_log("	 averaging from  (%g %g) to (%g %g) by table\n", xstart, ystart, xstop, ystop);
+
+	for (c = 0; c < 3; c++) {
+	    sum[c] = txt_sat_sum(tp, 3, c, x0, y0, x1+1, y1+1)
+		- fx0 * txt_sat_sum(tp, 3, c, x0, y0, x0+1, y1+1)
+		- fx1 * txt_sat_sum(tp, 3, c, x1, y0, x1+1, y1+1)
+		- fy0 * txt_sat_sum(tp, 3, c, x0, y0, x1+1, y0+1)
+		- fy1 * txt_sat_sum(tp, 3, c, x0, y1, x1+1, y1+1)
+		+ fx0 * fy0 * txt_sat_sum(tp, 3, c, x0, y0, x0+1, y0+1)
+		+ fx0 * fy1 * txt_sat_sum(tp, 3, c, x0, y1, x0+1, y1+1)
+		+ fx1 * fy0 * txt_sat_sum(tp, 3, c, x1, y0, x1+1, y0+1)
+		+ fx1 * fy1 * txt_sat_sum(tp, 3, c, x1, y1, x1+1, y1+1);
+	    sum[c] /= (xstop - xstart) * (ystop - ystart);
+	}
+	r = sum[0];
+	g = sum[1];
+	b = sum[2];
     } else {
 	/* Calculate weighted average of cells in footprint */
 
@@ -550,24 +741,30 @@ bwtxt_render(struct application *ap, const struct partition *pp, struct shadewor
     if (dx < 1) dx = 1;
     if (dy < 1) dy = 1;
     bw = 0;
-    for (line = 0; line < dy; line++) {
-	register unsigned char *cp=NULL;
-	register unsigned char *ep;
+    if ((fastf_t)dx * dy >= TXT_SAT_MIN && (fastf_t)dx * dy <= TXT_SAT_MAX
+	&& x + dx <= tp->tx_w && y + dy <= tp->tx_n
+	&& txt_sat_prep(tp, 1)) {
+	bw = txt_sat_sum(tp, 1, 0, x, y, x + dx, y + dy);
+    } else {
+	for (line = 0; line < dy; line++) {
+	    register unsigned char *cp=NULL;
+	    register unsigned char *ep;
 
-	if (tp->tx_mp) {
-	    cp = ((unsigned char *)(tp->tx_mp->buf)) +
-		(y+line) * tp->tx_w + x;
-	} else if (tp->tx_binunifp) {
-	    cp = ((unsigned char *)(tp->tx_binunifp->u.uint8)) +
-		(y+line) * tp->tx_w + x;
-	} else {
-	    /* not reachable */
-	    bu_bomb("sh_text.c -- Unable to read datasource\n");
-	}
+	    if (tp->tx_mp) {
+		cp = ((unsigned char *)(tp->tx_mp->buf)) +
+		    (y+line) * tp->tx_w + x;
+	    } else if (tp->tx_binunifp) {
+		cp = ((unsigned char *)(tp->tx_binunifp->u.uint8)) +
+		    (y+line) * tp->tx_w + x;
+	    } else {
+		/* not reachable */
+		bu_bomb("sh_text.c -- Unable to read datasource\n");
+	    }
 
-	ep = cp + dx;
-	while (cp < ep) {
-	    bw += *cp++;
+	    ep = cp + dx;
+	    while (cp < ep) {
+		bw += *cp++;
+	    }
 	}
     }
 
@@ -617,6 +814,9 @@ txt_setup(register struct region *rp, struct bu_vls *matparm, void **dpp, const
     tp->tx_datasrc = 0; /* source is auto-located by default */
     tp->tx_binunifp = NULL;
     tp->tx_mp = NULL;
+    tp->tx_sat = NULL;
+    tp->tx_sat_buf = NULL;
+    tp->tx_sat_failed = 0;
 
     /* load given values */
     if (bu_struct_parse(matparm, txt_parse, (char *)tp, NULL) < 0) {
@@ -634,8 +834,17 @@ txt_setup(register struct region *rp, struct bu_vls *matparm, void **dpp, const
 
     if (BU_STR_EQUAL(mfp->mf_name, "bwtexture")) pixelbytes = 1;
 
+    /* LIBOPTICAL_TXT_SAT=0 filters every footprint texel by texel,
+     * which is what the tables are checked against.
+     */
+    {
+	const char *sat_env = getenv("LIBOPTICAL_TXT_SAT");
+	if (sat_env && BU_STR_EQUAL(sat_env, "0"))
+	    tp->tx_sat_failed = 1;
+    }
+
     /* load the texture from its datasource */
-    if (txt_load_datasource(tp, rtip->rti_dbip, tp->tx_w * tp->tx_n * pixelbytes)<0) {
+    if (txt_load_datasource(tp, rtip->rti_dbip, pixelbytes)<0) {
 	bu_log("\nERROR: txt_setup() %s %s could not be loaded [source was %s]\n", rp->reg_name, bu_vls_addr(&tp->tx_name), tp->tx_datasrc==TXT_SRC_OBJECT?"object":tp->tx_datasrc==TXT_SRC_FILE?"file":"auto");
 	return -1;
     }
@@ -664,7 +873,10 @@ txt_free(void *cp)
 
     bu_vls_free(&tp->tx_name);
     if (tp->tx_binunifp) rt_binunif_free(tp->tx_binunifp);
-    bu_close_mapped_file(tp->tx_mp);
+    /* releases the table along with the last use of the file */
+    rt_sidecar_close(tp->tx_mp);
+    if (tp->tx_sat_buf) bu_free(tp->tx_sat_buf, "txt_free sat");
+    tp->tx_sat = tp->tx_sat_buf = NULL;
     tp->tx_binunifp = (struct rt_binunif_internal *)NULL; /* sanity */
     tp->tx_mp = (struct bu_mapped_file *)NULL; /* sanity */
     BU_PUT(cp, struct txt_specific);
@@ -0,0 +1,234 @@
+/*                       S H _ T E X T . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file sh_text.c
+ *
+ * The texture and bwtexture shaders filter large footprints from a
+ * summed-area table.  The colors they return must match the texel by
+ * texel loop (selected with LIBOPTICAL_TXT_SAT=0), in the middle of the
+ * texture and for footprints clamped at its edges.
+ */
+
+#include "common.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "bu/app.h"
+#include "bu/env.h"
+#include "bu/file.h"
+#include "bu/log.h"
+#include "bu/str.h"
+#include "vmath.h"
+#include "raytrace.h"
+#include "optical.h"
+#include "wdb.h"
+
+#define TXT_TEST_DB "sh_text_test.g"
+#define TXT_TEST_PIX "sh_text_test.pix"
+#define TXT_TEST_BW "sh_text_test.bw"
+#define TXT_TEST_CACHE "sh_text_test_cache"
+#define TXT_TEST_W 97
+#define TXT_TEST_N 83
+
+/* u, v, du, dv */
+static const fastf_t footprints[][4] = {
+    {0.5, 0.5, 0.05, 0.05},		/* middle */
+    {0.31, 0.67, 0.1, 0.04},		/* wider than it is tall */
+    {0.43, 0.29, 0.125, 0.125},		/* largest that isn't clamped */
+    {0.6, 0.4, 0.5, 0.3},		/* du and dv clamped to 1/8 */
+    {0.01, 0.5, 0.06, 0.06},		/* left edge */
+    {0.995, 0.5, 0.06, 0.06},		/* right edge */
+    {0.5, 0.002, 0.05, 0.08},		/* bottom edge */
+    {0.5, 0.998, 0.08, 0.05},		/* top edge */
+    {0.001, 0.001, 0.1, 0.1},		/* lower left corner */
+    {0.999, 0.999, 0.125, 0.125},	/* upper right corner */
+    {0.999, 0.001, 0.07, 0.11}		/* lower right corner */
+};
+
+static void
+write_texture(const char *name, size_t len, unsigned long seed)
+{
+    FILE *fp = fopen(name, "wb");
+    size_t i;
+
+    if (!fp)
+	bu_exit(1, "ERROR: unable to write %s\n", name);
+    for (i = 0; i < len; i++) {
+	seed = seed * 1103515245 + 12345;
+	(void)putc((int)((seed >> 16) & 0xff), fp);
+    }
+    fclose(fp);
+}
+
+static const struct mfuncs *
+find_shader(const struct mfuncs *head, const char *name)
+{
+    const struct mfuncs *mfp;
+
+    for (mfp = head; mfp && mfp->mf_name; mfp = mfp->mf_forw) {
+	if (BU_STR_EQUAL(mfp->mf_name, name))
+	    return mfp;
+    }
+    bu_exit(1, "ERROR: no %s shader\n", name);
+    return NULL;
+}
+
+static void *
+setup(const struct mfuncs *mfp, struct region *rp, const char *file, int sat, struct rt_i *rtip)
+{
+    struct bu_vls parm = BU_VLS_INIT_ZERO;
+    void *dp = NULL;
+
+    bu_setenv("LIBOPTICAL_TXT_SAT", (sat) ? "1" : "0", 1);
+    bu_vls_sprintf(&parm, "file=%s w=%d n=%d", file, TXT_TEST_W, TXT_TEST_N);
+    if (mfp->mf_setup(rp, &parm, &dp, mfp, rtip) < 0)
+	bu_exit(1, "ERROR: unable to set up the %s shader\n", mfp->mf_name);
+    bu_vls_free(&parm);
+    return dp;
+}
+
+static void
+render(const struct mfuncs *mfp, void *dp, const fastf_t *fp, vect_t color)
+{
+    struct application ap;
+    struct partition pt;
+    struct shadework sw;
+
+    RT_APPLICATION_INIT(&ap);
+    memset(&pt, 0, sizeof(pt));
+    pt.pt_magic = PT_MAGIC;
+    memset(&sw, 0, sizeof(sw));
+    sw.sw_uv.uv_u = fp[0];
+    sw.sw_uv.uv_v = fp[1];
+    sw.sw_uv.uv_du = fp[2];
+    sw.sw_uv.uv_dv = fp[3];
+
+    (void)mfp->mf_render(&ap, &pt, &sw, dp);
+    VMOVE(color, sw.sw_color);
+}
+
+static int
+compare(const struct mfuncs *mfp, const char *file, struct region *rp, struct rt_i *rtip)
+{
+    void *loop = setup(mfp, rp, file, 0, rtip);
+    void *sat = setup(mfp, rp, file, 1, rtip);
+    size_t i;
+    int ret = 0;
+
+    for (i = 0; i < sizeof(footprints) / sizeof(footprints[0]); i++) {
+	vect_t expected, color;
+	render(mfp, loop, footprints[i], expected);
+	render(mfp, sat, footprints[i], color);
+	if (!VNEAR_EQUAL(color, expected, 1.0e-6)) {
+	    bu_log("%s: uv=(%g %g) duv=(%g %g): table gave (%.9g %.9g %.9g), loop gave (%.9g %.9g %.9g)\n",
+		   mfp->mf_name, footprints[i][0], footprints[i][1], footprints[i][2], footprints[i][3],
+		   V3ARGS(color), V3ARGS(expected));
+	    ret++;
+	}
+    }
+
+    mfp->mf_free(sat);
+    mfp->mf_free(loop);
+    return ret;
+}
+
+static size_t
+sidecar_cnt(const char *dir)
+{
+    char **files = NULL;
+    size_t cnt = bu_file_list(dir, "*.sidecar", &files);
+    bu_argv_free(cnt, files);
+    return cnt;
+}
+
+int
+main(int argc, char *argv[])
+{
+    char root[MAXPATHLEN] = {'\0'};
+    char dir[MAXPATHLEN] = {'\0'};
+    struct mfuncs *head = NULL;
+    struct region reg;
+    struct rt_wdb *wdbp;
+    struct db_i *dbip;
+    struct rt_i *rtip;
+    int ret = 0;
+
+    bu_setprogname(argv[0]);
+
+    if (argc != 1)
+	bu_exit(1, "Usage: %s\n", argv[0]);
+
+    bu_dir(root, MAXPATHLEN, BU_DIR_CURR, TXT_TEST_CACHE, NULL);
+    bu_dir(dir, MAXPATHLEN, root, "sidecar", NULL);
+    if (bu_file_directory(root))
+	bu_dirclear(root);
+    bu_setenv("LIBRT_CACHE", root, 1);
+
+    write_texture(TXT_TEST_PIX, (size_t)TXT_TEST_W * TXT_TEST_N * 3, 1);
+    write_texture(TXT_TEST_BW, (size_t)TXT_TEST_W * TXT_TEST_N, 2);
+
+    /* the shaders look their files up next to the database */
+    bu_file_delete(TXT_TEST_DB);
+    wdbp = wdb_fopen(TXT_TEST_DB);
+    if (!wdbp)
+	bu_exit(1, "ERROR: unable to create %s\n", TXT_TEST_DB);
+    wdb_close(wdbp);
+    dbip = db_open(TXT_TEST_DB, DB_OPEN_READONLY);
+    if (!dbip || db_dirbuild(dbip) < 0)
+	bu_exit(1, "ERROR: unable to open %s\n", TXT_TEST_DB);
+    rtip = rt_new_rti(dbip);
+
+    memset(&reg, 0, sizeof(reg));
+    reg.l.magic = RT_REGION_MAGIC;
+    reg.reg_name = "sh_text_test.r";
+
+    optical_shader_init(&head);
+
+    ret += compare(find_shader(head, "texture"), TXT_TEST_PIX, &reg, rtip);
+    ret += compare(find_shader(head, "bwtexture"), TXT_TEST_BW, &reg, rtip);
+
+    /* make sure the tables were actually used */
+    if (sidecar_cnt(dir) != 2) {
+	bu_log("expected a table for each texture, found %zu\n", sidecar_cnt(dir));
+	ret++;
+    }
+
+    rt_free_rti(rtip);
+    db_close(dbip);
+    bu_file_delete(TXT_TEST_DB);
+    bu_file_delete(TXT_TEST_PIX);
+    bu_file_delete(TXT_TEST_BW);
+    bu_dirclear(root);
+
+    if (ret)
+	bu_log("%d texture filtering checks failed\n", ret);
+    return (ret) ? 1 : 0;
+}
+
+
+/*
+ * Local Variables:
+ * mode: C
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
@@ -26,11 +26,13 @@
 #include "common.h"
 
 #include <QOpenGLWidget>
+#include <QTimer>
 #include <QtGlobal>
 
 extern "C" {
 #include "bu/malloc.h"
 }
+#include "ged/view/state.h"
 #include "bindings.h"
 #include "qtcad/QgGL.h"
 
@@ -44,6 +46,9 @@ extern "C" {
 #define QTGL_ZMIN -2048
 #define QTGL_ZMAX 2047
 
+// How often to redraw while adaptive wireframes are being regenerated
+#define QTGL_LOD_REDRAW_MSEC 50
+
 QgGL::QgGL(QWidget *parent, struct fb *fbp)
     : QOpenGLWidget(parent), ifp(fbp)
 {
@@ -78,6 +83,7 @@ QgGL::~QgGL()
     if (ifp && !fb_get_standalone(ifp)) {
 	fb_close_existing(ifp);
     }
+    ged_csg_lod_view_free(local_v);
     BU_PUT(local_v, struct bv);
 }
 
@@ -158,6 +164,11 @@ void QgGL::paintGL()
     dm_set_dirty(dmp, 0);
     dm_draw_objs(v, draw_custom, draw_udata);
     dm_draw_end(dmp);
+
+    // Wireframes still being regenerated in the background show up on a
+    // later redraw - keep redrawing until they're all in
+    if (ged_csg_lod_pending(v))
+	QTimer::singleShot(QTGL_LOD_REDRAW_MSEC, this, &QgGL::need_update);
 }
 
 void QgGL::resizeGL(int, int)
@@ -28,11 +28,13 @@
 
 #include <QImage>
 #include <QPainter>
+#include <QTimer>
 #include <QtGlobal>
 
 extern "C" {
 #include "bu/malloc.h"
 }
+#include "ged/view/state.h"
 #include "bindings.h"
 #include "qtcad/QgSW.h"
 
@@ -46,6 +48,9 @@ extern "C" {
 #define QTSW_ZMIN -100
 #define QTSW_ZMAX 100
 
+// How often to redraw while adaptive wireframes are being regenerated
+#define QTSW_LOD_REDRAW_MSEC 50
+
 QgSW::QgSW(QWidget *parent, struct fb *fbp)
     : QWidget(parent), ifp(fbp)
 {
@@ -79,6 +84,7 @@ QgSW::~QgSW()
     if (ifp && !fb_get_standalone(ifp)) {
 	fb_close_existing(ifp);
     }
+    ged_csg_lod_view_free(local_v);
     BU_PUT(local_v, struct bv);
 }
 
@@ -168,6 +174,11 @@ void QgSW::paintEvent(QPaintEvent *e)
     dm_draw_objs(v, draw_custom, draw_udata);
     dm_draw_end(dmp);
 
+    // Wireframes still being regenerated in the background show up on a
+    // later redraw - keep redrawing until they're all in
+    if (ged_csg_lod_pending(v))
+	QTimer::singleShot(QTSW_LOD_REDRAW_MSEC, this, &QgSW::need_update);
+
     // Set up a QImage with the rendered output..
     unsigned char *dm_image;
     if (dm_get_display_image(dmp, &dm_image, 1, 1)) {
@@ -0,0 +1,537 @@
+/*                  C O M B _ C A C H E . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file comb_cache.cpp
+ *
+ * Cache of imported combinations, member matrices and bounding boxes.
+ *
+ * Evaluating a full path (its matrix, boolean operation or bounds)
+ * means importing every combination along it, and interactive work on
+ * a deep hierarchy evaluates the same paths over and over.  The cache
+ * keeps each combination's imported form, with its members' names,
+ * matrices and operations flattened out for quick lookup, keyed on the
+ * directory pointer.  Bounding boxes of primitives and whole comb
+ * hierarchies are kept alongside.
+ *
+ * A change to an object drops its own entries.  Since a comb's bounds
+ * depend on everything below it, any change (including an addition,
+ * which may supply a previously missing member) also drops all the
+ * comb bounding boxes - they are cheap to rebuild from the cached
+ * combs and primitive boxes.
+ *
+ * Entries are reference counted.  One that is dropped while still in
+ * use (by another thread, or by a caller of db_comb_cache_get()) is
+ * only unlinked, and freed when its last user releases it.  Nothing
+ * is cached from a lookup that raced with a change, and failed
+ * imports aren't cached at all, so they are retried on the next call.
+ */
+
+#include "common.h"
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "vmath.h"
+#include "bn/mat.h"
+#include "raytrace.h"
+
+
+struct comb_cache_member {
+    std::string name;
+    int op;
+    int have_mat;
+    mat_t mat;
+};
+
+
+struct comb_cache_entry {
+    struct rt_db_internal intern;
+    std::vector<comb_cache_member> members;
+    int refs = 0;
+    int stale = 0;	/* no longer in the cache, free when refs reaches 0 */
+};
+
+
+struct comb_cache_bbox {
+    int state;		/* 1 = valid, -1 = can't be bounded */
+    point_t bmin;
+    point_t bmax;
+};
+
+
+class DbCombCache {
+    public:
+	DbCombCache(struct db_i *d);
+	~DbCombCache();
+
+	comb_cache_entry *comb(struct directory *dp, struct resource *resp);
+	void release(comb_cache_entry *e);
+	int bbox(point_t bmin, point_t bmax, struct directory *dp, struct resource *resp, std::unordered_set<struct directory *> &active);
+	void invalidate(struct directory *dp, int mode);
+
+	struct db_i *dbip;
+	std::mutex lock;
+	unsigned long long gen = 0;	/* bumped on every change */
+	std::unordered_map<struct directory *, comb_cache_entry *> combs;
+	/* every allocated entry, cached or stale, keyed for release */
+	std::unordered_map<const struct rt_db_internal *, comb_cache_entry *> entries;
+	std::unordered_map<struct directory *, comb_cache_bbox> prim_bboxes;
+	std::unordered_map<struct directory *, comb_cache_bbox> comb_bboxes;
+};
+
+
+static void
+comb_cache_entry_free(comb_cache_entry *e)
+{
+    if (!e)
+	return;
+    rt_db_free_internal(&e->intern);
+    delete e;
+}
+
+
+static void
+comb_cache_changed_clbk(struct db_i *UNUSED(dbip), struct directory *dp, int mode, void *u_data)
+{
+    DbCombCache *cc = (DbCombCache *)u_data;
+    if (!cc || !dp)
+	return;
+
+    std::lock_guard<std::mutex> guard(cc->lock);
+    cc->invalidate(dp, mode);
+}
+
+
+DbCombCache::DbCombCache(struct db_i *d)
+{
+    dbip = d;
+    db_add_changed_clbk(dbip, comb_cache_changed_clbk, (void *)this);
+}
+
+
+DbCombCache::~DbCombCache()
+{
+    db_rm_changed_clbk(dbip, comb_cache_changed_clbk, (void *)this);
+    /* Anything still referenced at this point is the caller's error -
+     * the database is going away */
+    for (auto &e : entries)
+	comb_cache_entry_free(e.second);
+}
+
+
+/* Caller must hold the lock */
+void
+DbCombCache::invalidate(struct directory *dp, int mode)
+{
+    gen++;
+    comb_bboxes.clear();
+
+    /* A new object has nothing cached under its pointer */
+    if (mode == 1)
+	return;
+
+    auto c_it = combs.find(dp);
+    if (c_it != combs.end()) {
+	comb_cache_entry *e = c_it->second;
+	combs.erase(c_it);
+	if (e->refs) {
+	    e->stale = 1;
+	} else {
+	    entries.erase(&e->intern);
+	    comb_cache_entry_free(e);
+	}
+    }
+    prim_bboxes.erase(dp);
+}
+
+
+void
+DbCombCache::release(comb_cache_entry *e)
+{
+    if (!e)
+	return;
+
+    std::lock_guard<std::mutex> guard(lock);
+    e->refs--;
+    if (!e->refs && e->stale) {
+	entries.erase(&e->intern);
+	comb_cache_entry_free(e);
+    }
+}
+
+
+/* Record each member leaf, with the operation _db_comb_instance()
+ * reports for it: left operands are unions, right operands take the
+ * operation of their parent node. */
+static void
+comb_cache_members(std::vector<comb_cache_member> &members, union tree *tp, int op)
+{
+    if (!tp)
+	return;
+    RT_CK_TREE(tp);
+
+    switch (tp->tr_op) {
+	case OP_DB_LEAF:
+	    {
+		comb_cache_member m;
+		m.name = std::string(tp->tr_l.tl_name);
+		m.op = op;
+		m.have_mat = (tp->tr_l.tl_mat) ? 1 : 0;
+		if (tp->tr_l.tl_mat) {
+		    MAT_COPY(m.mat, tp->tr_l.tl_mat);
+		} else {
+		    MAT_IDN(m.mat);
+		}
+		members.push_back(m);
+	    }
+	    return;
+	case OP_UNION:
+	case OP_INTERSECT:
+	case OP_SUBTRACT:
+	case OP_XOR:
+	    comb_cache_members(members, tp->tr_b.tb_left, OP_UNION);
+	    comb_cache_members(members, tp->tr_b.tb_right, tp->tr_op);
+	    return;
+	default:
+	    bu_log("comb_cache_members: bad op %d\n", tp->tr_op);
+	    return;
+    }
+}
+
+
+/* Returns the entry for dp with a reference taken, which the caller
+ * must drop with release(), or NULL if dp can't be imported. */
+comb_cache_entry *
+DbCombCache::comb(struct directory *dp, struct resource *resp)
+{
+    unsigned long long igen;
+
+    if (!(dp->d_flags & RT_DIR_COMB))
+	return NULL;
+
+    {
+	std::lock_guard<std::mutex> guard(lock);
+	auto c_it = combs.find(dp);
+	if (c_it != combs.end()) {
+	    c_it->second->refs++;
+	    return c_it->second;
+	}
+	igen = gen;
+    }
+
+    /* Import without holding the lock, so concurrent lookups aren't
+     * serialized behind the I/O. */
+    comb_cache_entry *e = new comb_cache_entry;
+    RT_DB_INTERNAL_INIT(&e->intern);
+    if (rt_db_get_internal(&e->intern, dp, dbip, NULL, resp) < 0) {
+	delete e;
+	return NULL;
+    }
+    if (e->intern.idb_major_type != DB5_MAJORTYPE_BRLCAD || e->intern.idb_minor_type != ID_COMBINATION) {
+	comb_cache_entry_free(e);
+	return NULL;
+    }
+    struct rt_comb_internal *comb = (struct rt_comb_internal *)e->intern.idb_ptr;
+    RT_CK_COMB(comb);
+    /* As db_recurse() does, so db_walk_tree() can use the entry as is */
+    db5_sync_attr_to_comb(comb, &e->intern.idb_avs, dp);
+    comb_cache_members(e->members, comb->tree, OP_UNION);
+
+    std::lock_guard<std::mutex> guard(lock);
+    auto c_it = combs.find(dp);
+    if (c_it != combs.end()) {
+	/* Another thread got here first */
+	comb_cache_entry_free(e);
+	c_it->second->refs++;
+	return c_it->second;
+    }
+    e->refs = 1;
+    entries[&e->intern] = e;
+    if (gen != igen) {
+	/* The database changed during the import, which may or may
+	 * not have been read before the change - use it this once */
+	e->stale = 1;
+    } else {
+	combs[dp] = e;
+    }
+    return e;
+}
+
+
+static void
+comb_cache_bbox_xform(point_t bmin, point_t bmax, const mat_t mat, const point_t cmin, const point_t cmax)
+{
+    VSETALL(bmin, INFINITY);
+    VSETALL(bmax, -INFINITY);
+    for (int i = 0; i < 8; i++) {
+	point_t corner, tcorner;
+	VSET(corner,
+	     (i & 1) ? cmax[X] : cmin[X],
+	     (i & 2) ? cmax[Y] : cmin[Y],
+	     (i & 4) ? cmax[Z] : cmin[Z]);
+	MAT4X3PNT(tcorner, mat, corner);
+	VMINMAX(bmin, bmax, tcorner);
+    }
+}
+
+
+/* Bound a comb's boolean tree.  Returns 0 with the box set, or -1 if
+ * nothing in the tree can be bounded. */
+static int
+comb_cache_tree_bbox(point_t bmin, point_t bmax, DbCombCache *cc, union tree *tp, struct resource *resp, std::unordered_set<struct directory *> &active)
+{
+    point_t lmin, lmax, rmin, rmax;
+    int lret, rret;
+
+    if (!tp)
+	return -1;
+    RT_CK_TREE(tp);
+
+    switch (tp->tr_op) {
+	case OP_DB_LEAF:
+	    {
+		struct directory *dp = db_lookup(cc->dbip, tp->tr_l.tl_name, LOOKUP_QUIET);
+		if (!dp)
+		    return -1;
+		if (cc->bbox(lmin, lmax, dp, resp, active) < 0)
+		    return -1;
+		if (tp->tr_l.tl_mat && !bn_mat_is_identity(tp->tr_l.tl_mat)) {
+		    comb_cache_bbox_xform(bmin, bmax, tp->tr_l.tl_mat, lmin, lmax);
+		} else {
+		    VMOVE(bmin, lmin);
+		    VMOVE(bmax, lmax);
+		}
+	    }
+	    return 0;
+	case OP_SUBTRACT:
+	    return comb_cache_tree_bbox(bmin, bmax, cc, tp->tr_b.tb_left, resp, active);
+	case OP_INTERSECT:
+	    lret = comb_cache_tree_bbox(lmin, lmax, cc, tp->tr_b.tb_left, resp, active);
+	    rret = comb_cache_tree_bbox(rmin, rmax, cc, tp->tr_b.tb_right, resp, active);
+	    if (lret < 0 || rret < 0)
+		return -1;
+	    VMAX(lmin, rmin);
+	    VMIN(lmax, rmax);
+	    if (lmin[X] > lmax[X] || lmin[Y] > lmax[Y] || lmin[Z] > lmax[Z])
+		return -1;
+	    VMOVE(bmin, lmin);
+	    VMOVE(bmax, lmax);
+	    return 0;
+	case OP_UNION:
+	case OP_XOR:
+	    lret = comb_cache_tree_bbox(lmin, lmax, cc, tp->tr_b.tb_left, resp, active);
+	    rret = comb_cache_tree_bbox(rmin, rmax, cc, tp->tr_b.tb_right, resp, active);
+	    if (lret < 0 && rret < 0)
+		return -1;
+	    VSETALL(bmin, INFINITY);
+	    VSETALL(bmax, -INFINITY);
+	    if (lret == 0) {
+		VMINMAX(bmin, bmax, lmin);
+		VMINMAX(bmin, bmax, lmax);
+	    }
+	    if (rret == 0) {
+		VMINMAX(bmin, bmax, rmin);
+		VMINMAX(bmin, bmax, rmax);
+	    }
+	    return 0;
+	default:
+	    return -1;
+    }
+}
+
+
+int
+DbCombCache::bbox(point_t bmin, point_t bmax, struct directory *dp, struct resource *resp, std::unordered_set<struct directory *> &active)
+{
+    int is_comb = (dp->d_flags & RT_DIR_COMB) ? 1 : 0;
+    std::unordered_map<struct directory *, comb_cache_bbox> &bboxes = (is_comb) ? comb_bboxes : prim_bboxes;
+
+    {
+	std::lock_guard<std::mutex> guard(lock);
+	auto b_it = bboxes.find(dp);
+	if (b_it != bboxes.end()) {
+	    VMOVE(bmin, b_it->second.bmin);
+	    VMOVE(bmax, b_it->second.bmax);
+	    return (b_it->second.state == 1) ? 0 : -1;
+	}
+    }
+
+    comb_cache_bbox b;
+    VSETALL(b.bmin, INFINITY);
+    VSETALL(b.bmax, -INFINITY);
+    b.state = -1;
+
+    unsigned long long bgen;
+    {
+	std::lock_guard<std::mutex> guard(lock);
+	bgen = gen;
+    }
+
+    if (is_comb) {
+	/* A cyclic reference can't be bounded */
+	if (!active.insert(dp).second)
+	    return -1;
+	comb_cache_entry *e = comb(dp, resp);
+	if (e) {
+	    struct rt_comb_internal *c = (struct rt_comb_internal *)e->intern.idb_ptr;
+	    if (comb_cache_tree_bbox(b.bmin, b.bmax, this, c->tree, resp, active) == 0)
+		b.state = 1;
+	    release(e);
+	}
+	active.erase(dp);
+    } else {
+	struct bg_tess_tol ttol = BG_TESS_TOL_INIT_ZERO;
+	struct bn_tol tol = BN_TOL_INIT_TOL;
+	mat_t m;
+	MAT_IDN(m);
+	if (rt_bound_instance(&b.bmin, &b.bmax, dp, dbip, &ttol, &tol, &m, resp) != -1)
+	    b.state = 1;
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+    if (gen == bgen)
+	bboxes[dp] = b;
+    VMOVE(bmin, b.bmin);
+    VMOVE(bmax, b.bmax);
+    return (b.state == 1) ? 0 : -1;
+}
+
+
+int
+db_comb_cache_enable(struct db_i *dbip)
+{
+    if (!dbip)
+	return -1;
+    RT_CK_DBI(dbip);
+
+    if (dbip->dbi_comb_cache)
+	return 0;
+
+    dbip->dbi_comb_cache = (void *)new DbCombCache(dbip);
+    return 0;
+}
+
+
+void
+db_comb_cache_disable(struct db_i *dbip)
+{
+    if (!dbip || !dbip->dbi_comb_cache)
+	return;
+
+    DbCombCache *cc = (DbCombCache *)dbip->dbi_comb_cache;
+    dbip->dbi_comb_cache = NULL;
+    delete cc;
+}
+
+
+const struct rt_db_internal *
+db_comb_cache_get(struct db_i *dbip, struct directory *dp, struct resource *resp)
+{
+    if (!dbip || !dbip->dbi_comb_cache || !dp)
+	return NULL;
+    RT_CK_DIR(dp);
+
+    DbCombCache *cc = (DbCombCache *)dbip->dbi_comb_cache;
+    comb_cache_entry *e = cc->comb(dp, (resp) ? resp : &rt_uniresource);
+    return (e) ? &e->intern : NULL;
+}
+
+
+void
+db_comb_cache_release(struct db_i *dbip, const struct rt_db_internal *ip)
+{
+    if (!dbip || !dbip->dbi_comb_cache || !ip)
+	return;
+
+    DbCombCache *cc = (DbCombCache *)dbip->dbi_comb_cache;
+    comb_cache_entry *e = NULL;
+    {
+	std::lock_guard<std::mutex> guard(cc->lock);
+	auto e_it = cc->entries.find(ip);
+	if (e_it == cc->entries.end()) {
+	    bu_log("db_comb_cache_release: %p is not a comb cache entry\n", (const void *)ip);
+	    return;
+	}
+	e = e_it->second;
+    }
+    cc->release(e);
+}
+
+
+int
+db_comb_cache_member(mat_t m, int *op, struct db_i *dbip, struct directory *cdp, const char *name, int inst, struct resource *resp)
+{
+    if (!dbip || !dbip->dbi_comb_cache)
+	return -2;
+    if (!cdp || !name)
+	return -1;
+    RT_CK_DIR(cdp);
+
+    DbCombCache *cc = (DbCombCache *)dbip->dbi_comb_cache;
+    comb_cache_entry *e = cc->comb(cdp, (resp) ? resp : &rt_uniresource);
+    if (!e)
+	return -1;
+
+    int icnt = 0;
+    int ret = 0;
+    for (size_t i = 0; i < e->members.size(); i++) {
+	const comb_cache_member &cm = e->members[i];
+	if (!BU_STR_EQUAL(cm.name.c_str(), name))
+	    continue;
+	if (UNLIKELY(dbip->dbi_use_comb_instance_ids) && icnt++ != inst)
+	    continue;
+	if (m)
+	    MAT_COPY(m, cm.mat);
+	if (op)
+	    (*op) = cm.op;
+	ret = 1;
+	break;
+    }
+    cc->release(e);
+
+    return ret;
+}
+
+
+int
+db_comb_cache_bbox(point_t bmin, point_t bmax, struct db_i *dbip, struct directory *dp, struct resource *resp)
+{
+    if (!dbip || !dbip->dbi_comb_cache)
+	return -2;
+    if (!dp)
+	return -1;
+    RT_CK_DIR(dp);
+
+    DbCombCache *cc = (DbCombCache *)dbip->dbi_comb_cache;
+    std::unordered_set<struct directory *> active;
+    return cc->bbox(bmin, bmax, dp, (resp) ? resp : &rt_uniresource, active);
+}
+
+
+// Local Variables:
+// tab-width: 8
+// mode: C++
+// c-basic-offset: 4
+// indent-tabs-mode: t
+// c-file-style: "stroustrup"
+// End:
+// ex: shiftwidth=4 tabstop=8
@@ -594,8 +594,8 @@ rt_ck_overlap(const vect_t min, const vect_t max, const struct soltab *stp, cons
     }
 
     /* RPP overlaps, invoke per-solid method for detailed check */
-    if (OBJ[stp->st_id].ft_classify &&
-	OBJ[stp->st_id].ft_classify(stp, min, max, &rtip->rti_tol) == BG_CLASSIFY_OUTSIDE)
+    if (stp->st_meth->ft_classify &&
+	stp->st_meth->ft_classify(stp, min, max, &rtip->rti_tol) == BG_CLASSIFY_OUTSIDE)
 	return 0;
 
     /* don't know, check it */
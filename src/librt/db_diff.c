@@ -34,6 +34,7 @@
 #include <errno.h>
 #include "bio.h"
 
+#include "bu/parallel.h"
 #include "vmath.h"
 #include "rt/geom.h"
 #include "raytrace.h"
@@ -286,7 +287,7 @@ struct diff_elements {
 };
 
 static void
-get_diff_components(struct diff_elements *el, const struct db_i *dbip, const struct directory *dp)
+get_diff_components(struct diff_elements *el, const struct db_i *dbip, const struct directory *dp, struct resource *resp)
 {
     el->name = NULL;
     el->idb_ptr = NULL;
@@ -326,7 +327,7 @@ get_diff_components(struct diff_elements *el, const struct db_i *dbip, const str
     /* Now deal with more normal objects */
     BU_GET(el->intern, struct rt_db_internal);
     RT_DB_INTERNAL_INIT(el->intern);
-    if (rt_db_get_internal(el->intern, dp, dbip, (fastf_t *)NULL, &rt_uniresource) < 0) {
+    if (rt_db_get_internal(el->intern, dp, dbip, (fastf_t *)NULL, resp) < 0) {
 	/* Arrgh - No internal representation */
 	rt_db_free_internal(el->intern);
 	BU_PUT(el->intern, struct rt_db_internal);
@@ -435,14 +436,15 @@ diff_dp_attr_unchgd(const char *attr_name, const char *attr_val, void *data)
     return avp->state;
 }
 
-int
-db_diff_dp(const struct db_i *left,
+static int
+diff_dp(const struct db_i *left,
 	const struct db_i *right,
 	const struct directory *left_dp,
 	const struct directory *right_dp,
 	const struct bn_tol *diff_tol,
 	db_compare_criteria_t flags,
-	struct diff_result *ext_result)
+	struct diff_result *ext_result,
+	struct resource *resp)
 {
     int state = DIFF_EMPTY;
 
@@ -466,8 +468,8 @@ db_diff_dp(const struct db_i *left,
     if (left_dp) result->dp_left = left_dp;
     if (right_dp) result->dp_right = right_dp;
 
-    get_diff_components(&left_components, left, left_dp);
-    get_diff_components(&right_components, right, right_dp);
+    get_diff_components(&left_components, left, left_dp, resp);
+    get_diff_components(&right_components, right, right_dp, resp);
 
     if (flags == DB_COMPARE_ALL || flags & DB_COMPARE_PARAM) {
 
@@ -505,89 +507,15 @@ db_diff_dp(const struct db_i *left,
 }
 
 int
-db_diff(const struct db_i *dbip1,
-	const struct db_i *dbip2,
+db_diff_dp(const struct db_i *left,
+	const struct db_i *right,
+	const struct directory *left_dp,
+	const struct directory *right_dp,
 	const struct bn_tol *diff_tol,
 	db_compare_criteria_t flags,
-	struct bu_ptbl *results)
+	struct diff_result *ext_result)
 {
-    int state = DIFF_EMPTY;
-    struct directory *dp1=RT_DIR_NULL, *dp2=RT_DIR_NULL;
-
-    /* look at all objects in this database */
-    FOR_ALL_DIRECTORY_START(dp1, dbip1) {
-	struct bu_external ext1 = BU_EXTERNAL_INIT_ZERO;
-	struct bu_external ext2 = BU_EXTERNAL_INIT_ZERO;
-	int extern_state = DIFF_UNCHANGED;
-	struct diff_result *result = NULL;
-	BU_GET(result, struct diff_result);
-	diff_init_result(result, diff_tol, dp1->d_namep);
-
-	/* determine the status of this object in the other database */
-	dp2 = db_lookup(dbip2, dp1->d_namep, 0);
-
-	/* If we're checking everything, we want a sanity check to make sure we spot it when the objects differ */
-	if (flags == DB_COMPARE_ALL && dp1 != RT_DIR_NULL && dp1->d_major_type != DB5_MAJORTYPE_ATTRIBUTE_ONLY && dp2 != RT_DIR_NULL && dp2->d_major_type != DB5_MAJORTYPE_ATTRIBUTE_ONLY) {
-	    if (db_get_external(&ext1, dp1, dbip1) || db_get_external(&ext2, dp2, dbip2)) {
-		bu_log("WARNING: Unexpected failure reading serialized data for %s and %s\n", dp1->d_namep, dp2->d_namep);
-	    } else {
-		if (db_diff_external(&ext1, &ext2)) {extern_state = DIFF_CHANGED;}
-	    }
-	    bu_free_external(&ext1);
-	    bu_free_external(&ext2);
-	}
-
-	/* Do internal diffs */
-	if (flags == DB_COMPARE_ALL || flags & DB_COMPARE_PARAM) {
-	    state |= db_diff_dp(dbip1, dbip2, dp1, dp2, diff_tol, DB_COMPARE_PARAM, result);
-	}
-	if (flags == DB_COMPARE_ALL || flags & DB_COMPARE_ATTRS) {
-	    state |= db_diff_dp(dbip1, dbip2, dp1, dp2, diff_tol, DB_COMPARE_ATTRS, result);
-	}
-	if (flags == DB_COMPARE_ALL && state == DIFF_UNCHANGED && extern_state == DIFF_CHANGED) {
-	    //bu_log("WARNING: internal and bu_external comparison disagree for %s and %s\n", dp1->d_namep, dp2->d_namep);
-	}
-
-	if (results) {
-	    bu_ptbl_ins(results, (long *)result);
-	} else {
-	    diff_free_result(result);
-	    BU_PUT(result, struct diff_result);
-	}
-
-    } FOR_ALL_DIRECTORY_END;
-
-    /* now look for objects in the other database that aren't here */
-    FOR_ALL_DIRECTORY_START(dp2, dbip2) {
-
-	/* determine the status of this object in the other database */
-	dp1 = db_lookup(dbip1, dp2->d_namep, 0);
-
-	/* By this point, any differences will be additions */
-	if (dp1 == RT_DIR_NULL) {
-	    struct diff_result *result;
-	    BU_GET(result, struct diff_result);
-	    diff_init_result(result, diff_tol, dp2->d_namep);
-
-	    /* Do internal diffs */
-	    if (flags == DB_COMPARE_ALL || flags & DB_COMPARE_PARAM) {
-		state |= db_diff_dp(dbip1, dbip2, dp1, dp2, diff_tol, DB_COMPARE_PARAM, result);
-	    }
-	    if (flags == DB_COMPARE_ALL || flags & DB_COMPARE_ATTRS) {
-		state |= db_diff_dp(dbip1, dbip2, dp1, dp2, diff_tol, DB_COMPARE_ATTRS, result);
-	    }
-
-	    if (results) {
-		bu_ptbl_ins(results, (long *)result);
-	    } else {
-		diff_free_result(result);
-		BU_PUT(result, struct diff_result);
-	    }
-	}
-
-    } FOR_ALL_DIRECTORY_END;
-
-    return state;
+    return diff_dp(left, right, left_dp, right_dp, diff_tol, flags, ext_result, &rt_uniresource);
 }
 
 int
@@ -790,8 +718,8 @@ diff3_dp_attr_unchgd(const char *attr_name, const char *attr_val, void *data)
     return avp->state;
 }
 
-int
-db_diff3_dp(const struct db_i *left,
+static int
+diff3_dp(const struct db_i *left,
 	const struct db_i *ancestor,
 	const struct db_i *right,
 	const struct directory *left_dp,
@@ -799,7 +727,8 @@ db_diff3_dp(const struct db_i *left,
 	const struct directory *right_dp,
 	const struct bn_tol *diff3_tol,
 	db_compare_criteria_t flags,
-	struct diff_result *ext_result)
+	struct diff_result *ext_result,
+	struct resource *resp)
 {
     int state = DIFF_EMPTY;
 
@@ -826,9 +755,9 @@ db_diff3_dp(const struct db_i *left,
     if (ancestor_dp) result->dp_ancestor = ancestor_dp;
     if (right_dp) result->dp_right = right_dp;
 
-    get_diff_components(&left_components, left, left_dp);
-    get_diff_components(&ancestor_components, ancestor, ancestor_dp);
-    get_diff_components(&right_components, right, right_dp);
+    get_diff_components(&left_components, left, left_dp, resp);
+    get_diff_components(&ancestor_components, ancestor, ancestor_dp, resp);
+    get_diff_components(&right_components, right, right_dp, resp);
 
     if (flags == DB_COMPARE_ALL || flags & DB_COMPARE_PARAM) {
 
@@ -874,140 +803,385 @@ db_diff3_dp(const struct db_i *left,
 }
 
 int
-db_diff3(const struct db_i *dbip_left,
-	const struct db_i *dbip_ancestor,
-	const struct db_i *dbip_right,
+db_diff3_dp(const struct db_i *left,
+	const struct db_i *ancestor,
+	const struct db_i *right,
+	const struct directory *left_dp,
+	const struct directory *ancestor_dp,
+	const struct directory *right_dp,
 	const struct bn_tol *diff3_tol,
 	db_compare_criteria_t flags,
-	struct bu_ptbl *results)
+	struct diff_result *ext_result)
+{
+    return diff3_dp(left, ancestor, right, left_dp, ancestor_dp, right_dp, diff3_tol, flags, ext_result, &rt_uniresource);
+}
+
+
+/* One object to compare, by name, across the databases */
+struct diff_task {
+    const struct directory *dp_left;
+    const struct directory *dp_ancestor;
+    const struct directory *dp_right;
+    struct diff_result *result;
+    int state;
+};
+
+struct diff_run {
+    const struct db_i *left;
+    const struct db_i *ancestor;	/* NULL for a two-way diff */
+    const struct db_i *right;
+    const struct bn_tol *tol;
+    db_compare_criteria_t flags;
+    struct diff_task *tasks;
+    size_t ntasks;
+    size_t next;
+    struct resource *res;
+};
+
+
+/*
+ * Read an object's serialized form.  Returns 0 on success.
+ */
+static int
+diff_get_external(struct bu_external *ext, const struct directory *dp, const struct db_i *dbip)
+{
+    BU_EXTERNAL_INIT(ext);
+    if (db_get_external(ext, dp, dbip) < 0) {
+	bu_log("WARNING: Unexpected failure reading serialized data for %s\n", dp->d_namep);
+	bu_free_external(ext);
+	return -1;
+    }
+    return 0;
+}
+
+
+/*
+ * Fill in the result for an object whose serialized form is the same
+ * in every database, without comparing it against itself.  The states
+ * and entries match what the full comparison reports.  When parameters
+ * are wanted the object is imported once to list them as unchanged;
+ * otherwise only its attributes are parsed out of ext.  Returns -1 if
+ * the object can't be handled this way and needs the full comparison.
+ */
+static int
+diff_unchanged(struct diff_run *r, struct diff_task *t, const struct bu_external *ext, struct resource *resp)
 {
+    struct db5_raw_internal raw;
+    struct bu_attribute_value_set avs;
+    struct bu_attribute_value_pair *avp;
+    int attr_only;
     int state = DIFF_EMPTY;
-    struct directory *dp_ancestor=RT_DIR_NULL, *dp_left=RT_DIR_NULL, *dp_right=RT_DIR_NULL;
+    struct diff_result *result = t->result;
+    int (*unchgd)(const char *, const char *, void *) = (r->ancestor) ? diff3_dp_attr_unchgd : diff_dp_attr_unchgd;
 
-    /* Step 1: look at all objects in the ancestor database */
-    FOR_ALL_DIRECTORY_START(dp_ancestor, dbip_ancestor) {
-	struct bu_external ext_left = BU_EXTERNAL_INIT_ZERO;
-	struct bu_external ext_ancestor = BU_EXTERNAL_INIT_ZERO;
-	struct bu_external ext_right = BU_EXTERNAL_INIT_ZERO;
-	struct diff_result *result = NULL;
-	int ancestor_state = DIFF_EMPTY;
-	int extern_state = DIFF_UNCHANGED;
-	BU_GET(result, struct diff_result);
-	diff_init_result(result, diff3_tol, dp_ancestor->d_namep);
+    if (db_version((struct db_i *)r->left) < 5)
+	return -1;
 
-	dp_left = db_lookup(dbip_left, dp_ancestor->d_namep, 0);
-	dp_right = db_lookup(dbip_right, dp_ancestor->d_namep, 0);
+    if (r->flags == DB_COMPARE_ALL || r->flags & DB_COMPARE_PARAM) {
+	struct diff_elements el;
+	get_diff_components(&el, r->left, t->dp_left, resp);
+	if (el.bin_obj) {
+	    free_diff_components(&el);
+	    return -1;
+	}
 
-	/* If we're checking everything, we want a sanity check to make sure we spot it when the objects differ */
-	if (flags == DB_COMPARE_ALL &&
-		dp_left != RT_DIR_NULL && dp_left->d_major_type != DB5_MAJORTYPE_ATTRIBUTE_ONLY &&
-		dp_ancestor != RT_DIR_NULL && dp_ancestor->d_major_type != DB5_MAJORTYPE_ATTRIBUTE_ONLY &&
-		dp_right != RT_DIR_NULL && dp_right->d_major_type != DB5_MAJORTYPE_ATTRIBUTE_ONLY) {
-	    if (db_get_external(&ext_left, dp_left, dbip_left) || db_get_external(&ext_ancestor, dp_ancestor, dbip_ancestor) || db_get_external(&ext_right, dp_right, dbip_right)) {
-		bu_log("WARNING: unexpected failure reading serialized data for %s and %s\n", dp_left->d_namep, dp_ancestor->d_namep);
-	    } else {
-		if (db_diff_external(&ext_left, &ext_right) || db_diff_external(&ext_left, &ext_ancestor)) {extern_state = DIFF_CHANGED;}
+	result->dp_left = t->dp_left;
+	result->dp_ancestor = t->dp_ancestor;
+	result->dp_right = t->dp_right;
+
+	for (BU_AVS_FOR(avp, el.params))
+	    result->param_state |= (*unchgd)(avp->name, avp->value, (void *)result->param_diffs);
+	if (el.bin_params && el.idb_ptr && result->param_state == DIFF_EMPTY)
+	    result->param_state |= DIFF_UNCHANGED;
+
+	if (r->flags == DB_COMPARE_ALL || r->flags & DB_COMPARE_ATTRS) {
+	    for (BU_AVS_FOR(avp, el.attrs)) {
+		/* diff3_dp() records attribute states with the parameters */
+		if (r->ancestor) {
+		    result->param_state |= (*unchgd)(avp->name, avp->value, (void *)result->attr_diffs);
+		} else {
+		    result->attr_state |= (*unchgd)(avp->name, avp->value, (void *)result->attr_diffs);
+		}
 	    }
-	    bu_free_external(&ext_left);
-	    bu_free_external(&ext_ancestor);
-	    bu_free_external(&ext_right);
 	}
+	free_diff_components(&el);
 
-	/* Do internal diffs */
-	if (flags == DB_COMPARE_ALL || flags & DB_COMPARE_PARAM) {
-	    ancestor_state |= db_diff3_dp(dbip_left, dbip_ancestor, dbip_right, dp_left, dp_ancestor, dp_right, diff3_tol, DB_COMPARE_PARAM, result);
+	state |= result->param_state;
+	state |= result->attr_state;
+	return state;
+    }
+
+    /* Attributes only - no need to import the object */
+    if (db5_get_raw_internal_ptr(&raw, ext->ext_buf) == NULL)
+	return -1;
+
+    attr_only = (raw.major_type == DB5_MAJORTYPE_ATTRIBUTE_ONLY);
+    bu_avs_init_empty(&avs);
+    if (raw.attributes.ext_buf) {
+	if (db5_import_attributes(&avs, &raw.attributes) < 0) {
+	    bu_avs_free(&avs);
+	    return -1;
 	}
-	if (flags == DB_COMPARE_ALL || flags & DB_COMPARE_ATTRS) {
-	    ancestor_state |= db_diff3_dp(dbip_left, dbip_ancestor, dbip_right, dp_left, dp_ancestor, dp_right, diff3_tol, DB_COMPARE_ATTRS, result);
+	if (!attr_only)
+	    (void)db5_standardize_avs(&avs);
+    }
+
+    result->dp_left = t->dp_left;
+    result->dp_ancestor = t->dp_ancestor;
+    result->dp_right = t->dp_right;
+
+    for (BU_AVS_FOR(avp, &avs)) {
+	if (r->ancestor) {
+	    result->param_state |= (*unchgd)(avp->name, avp->value, (void *)result->attr_diffs);
+	} else {
+	    result->attr_state |= (*unchgd)(avp->name, avp->value, (void *)result->attr_diffs);
 	}
-	if (flags == DB_COMPARE_ALL && (ancestor_state == DIFF_UNCHANGED || ancestor_state == DIFF_EMPTY) && extern_state == DIFF_CHANGED) {
-	    //bu_log("WARNING: internal and bu_external comparison disagree\n");
+    }
+    bu_avs_free(&avs);
+
+    state |= result->param_state;
+    state |= result->attr_state;
+    return state;
+}
+
+
+/*
+ * Returns 1 if all of the task's objects exist and have identical
+ * serialized forms, leaving the left one in ext, and 0 otherwise.
+ */
+static int
+diff_task_identical(struct diff_run *r, struct diff_task *t, struct bu_external *ext)
+{
+    struct bu_external other;
+    int same;
+
+    if (!t->dp_left || !t->dp_right || (r->ancestor && !t->dp_ancestor))
+	return 0;
+
+    if (diff_get_external(ext, t->dp_left, r->left))
+	return 0;
+
+    if (diff_get_external(&other, t->dp_right, r->right)) {
+	bu_free_external(ext);
+	return 0;
+    }
+    same = !db_diff_external(ext, &other);
+    bu_free_external(&other);
+
+    if (same && r->ancestor) {
+	if (diff_get_external(&other, t->dp_ancestor, r->ancestor)) {
+	    same = 0;
+	} else {
+	    same = !db_diff_external(ext, &other);
+	    bu_free_external(&other);
 	}
+    }
 
-	if (results) {
-	    bu_ptbl_ins(results, (long *)result);
+    if (!same)
+	bu_free_external(ext);
+    return same;
+}
+
+
+static void
+diff_task_run(struct diff_run *r, struct diff_task *t, struct resource *resp)
+{
+    const struct directory *dp = (t->dp_ancestor) ? t->dp_ancestor : ((t->dp_left) ? t->dp_left : t->dp_right);
+    struct bu_external ext;
+    int state;
+
+    BU_GET(t->result, struct diff_result);
+    diff_init_result(t->result, r->tol, dp->d_namep);
+
+    /* Byte-identical objects can't differ, so skip the import */
+    if (diff_task_identical(r, t, &ext)) {
+	state = diff_unchanged(r, t, &ext, resp);
+	bu_free_external(&ext);
+	if (state >= 0) {
+	    t->state = state;
+	    return;
+	}
+    }
+
+    if (r->flags == DB_COMPARE_ALL || r->flags & DB_COMPARE_PARAM) {
+	if (r->ancestor) {
+	    t->state |= diff3_dp(r->left, r->ancestor, r->right, t->dp_left, t->dp_ancestor, t->dp_right, r->tol, DB_COMPARE_PARAM, t->result, resp);
+	} else {
+	    t->state |= diff_dp(r->left, r->right, t->dp_left, t->dp_right, r->tol, DB_COMPARE_PARAM, t->result, resp);
+	}
+    }
+    if (r->flags == DB_COMPARE_ALL || r->flags & DB_COMPARE_ATTRS) {
+	if (r->ancestor) {
+	    t->state |= diff3_dp(r->left, r->ancestor, r->right, t->dp_left, t->dp_ancestor, t->dp_right, r->tol, DB_COMPARE_ATTRS, t->result, resp);
 	} else {
-	    diff_free_result(result);
-	    BU_PUT(result, struct diff_result);
+	    t->state |= diff_dp(r->left, r->right, t->dp_left, t->dp_right, r->tol, DB_COMPARE_ATTRS, t->result, resp);
 	}
-	state |= ancestor_state;
+    }
+}
 
-    } FOR_ALL_DIRECTORY_END;
 
-    FOR_ALL_DIRECTORY_START(dp_left, dbip_left) {
-	dp_ancestor = db_lookup(dbip_ancestor, dp_left->d_namep, 0);
-	if (dp_ancestor == RT_DIR_NULL) {
-	    struct bu_external ext_left, ext_right;
-	    int left_state = DIFF_EMPTY;
-	    int extern_state = DIFF_UNCHANGED;
-	    struct diff_result *result;
-	    BU_GET(result, struct diff_result);
-	    diff_init_result(result, diff3_tol, dp_left->d_namep);
+static void
+diff_worker(int cpu, void *data)
+{
+    struct diff_run *r = (struct diff_run *)data;
+    size_t i;
+
+    while (1) {
+	bu_semaphore_acquire(BU_SEM_GENERAL);
+	i = r->next++;
+	bu_semaphore_release(BU_SEM_GENERAL);
+	if (i >= r->ntasks)
+	    return;
+	diff_task_run(r, &r->tasks[i], &r->res[cpu]);
+    }
+}
 
-	    dp_right = db_lookup(dbip_right, dp_left->d_namep, 0);
 
-	    /* If we're checking everything, we want a sanity check to make sure we spot it when the objects differ */
-	    if (flags == DB_COMPARE_ALL &&
-		    dp_left != RT_DIR_NULL && dp_left->d_major_type != DB5_MAJORTYPE_ATTRIBUTE_ONLY &&
-		    dp_right != RT_DIR_NULL && dp_right->d_major_type != DB5_MAJORTYPE_ATTRIBUTE_ONLY) {
-		if (db_get_external(&ext_left, dp_left, dbip_left) || db_get_external(&ext_right, dp_right, dbip_right)) {
-		    bu_log("WARNING: Unexpected failure reading serialized data\n");
-		} else {
-		    if (db_diff_external(&ext_left, &ext_right)) {extern_state = DIFF_CHANGED;}
-		}
-		bu_free_external(&ext_left);
-		bu_free_external(&ext_right);
-	    }
+static void
+diff_task_add(struct diff_run *r, size_t *cap, const struct directory *dp_left, const struct directory *dp_ancestor, const struct directory *dp_right)
+{
+    struct diff_task *t;
 
-	    /* Do internal diffs */
-	    if (flags == DB_COMPARE_ALL || flags & DB_COMPARE_PARAM) {
-		left_state |= db_diff3_dp(dbip_left, dbip_ancestor, dbip_right, dp_left, NULL, dp_right, diff3_tol, DB_COMPARE_PARAM, result);
-	    }
-	    if (flags == DB_COMPARE_ALL || flags & DB_COMPARE_ATTRS) {
-		left_state |= db_diff3_dp(dbip_left, dbip_ancestor, dbip_right, dp_left, NULL, dp_right, diff3_tol, DB_COMPARE_ATTRS, result);
-	    }
-	    if (flags == DB_COMPARE_ALL && (left_state == DIFF_UNCHANGED || left_state == DIFF_EMPTY) && extern_state == DIFF_CHANGED) {
-		//bu_log("WARNING: internal and bu_external comparison disagree");
-	    }
+    if (r->ntasks == *cap) {
+	*cap = (*cap) ? *cap * 2 : 1024;
+	r->tasks = (struct diff_task *)bu_realloc(r->tasks, *cap * sizeof(struct diff_task), "diff tasks");
+    }
+    t = &r->tasks[r->ntasks++];
+    t->dp_left = dp_left;
+    t->dp_ancestor = dp_ancestor;
+    t->dp_right = dp_right;
+    t->result = NULL;
+    t->state = DIFF_EMPTY;
+}
 
-	    if (results) {
-		bu_ptbl_ins(results, (long *)result);
-	    } else {
-		diff_free_result(result);
-		BU_PUT(result, struct diff_result);
-	    }
 
-	    state |= left_state;
+/*
+ * Compare all the queued objects, spread over the available
+ * processors, then hand back the results in queue order.
+ */
+static int
+diff_run_tasks(struct diff_run *r, struct bu_ptbl *results)
+{
+    int state = DIFF_EMPTY;
+    size_t threads = bu_avail_cpus();
+    size_t i;
+
+    if (threads > MAX_PSW)
+	threads = MAX_PSW;
+    if (threads > r->ntasks)
+	threads = r->ntasks;
+    if (threads < 1)
+	threads = 1;
+
+    r->next = 0;
+    r->res = (struct resource *)bu_calloc(threads, sizeof(struct resource), "diff resources");
+    for (i = 0; i < threads; i++)
+	rt_init_resource(&r->res[i], (int)i, NULL);
+
+    if (threads > 1) {
+	bu_parallel(diff_worker, threads, (void *)r);
+    } else {
+	diff_worker(0, (void *)r);
+    }
+
+    for (i = 0; i < r->ntasks; i++) {
+	struct diff_task *t = &r->tasks[i];
+	state |= t->state;
+	if (results) {
+	    bu_ptbl_ins(results, (long *)t->result);
+	} else {
+	    diff_free_result(t->result);
+	    BU_PUT(t->result, struct diff_result);
 	}
+    }
+
+    for (i = 0; i < threads; i++)
+	rt_clean_resource_basic(NULL, &r->res[i]);
+    bu_free(r->res, "diff resources");
+    if (r->tasks)
+	bu_free(r->tasks, "diff tasks");
+
+    return state;
+}
 
+
+int
+db_diff(const struct db_i *dbip1,
+	const struct db_i *dbip2,
+	const struct bn_tol *diff_tol,
+	db_compare_criteria_t flags,
+	struct bu_ptbl *results)
+{
+    struct directory *dp1=RT_DIR_NULL, *dp2=RT_DIR_NULL;
+    struct diff_run r;
+    size_t cap = 0;
+
+    memset(&r, 0, sizeof(struct diff_run));
+    r.left = dbip1;
+    r.right = dbip2;
+    r.tol = diff_tol;
+    r.flags = flags;
+
+    /* look at all objects in this database */
+    FOR_ALL_DIRECTORY_START(dp1, dbip1) {
+	/* determine the status of this object in the other database */
+	dp2 = db_lookup(dbip2, dp1->d_namep, 0);
+	diff_task_add(&r, &cap, dp1, NULL, dp2);
     } FOR_ALL_DIRECTORY_END;
 
-    FOR_ALL_DIRECTORY_START(dp_right, dbip_right) {
-	dp_ancestor = db_lookup(dbip_ancestor, dp_right->d_namep, 0);
-	dp_left = db_lookup(dbip_left, dp_right->d_namep, 0);
-	if (dp_ancestor == RT_DIR_NULL && dp_left == RT_DIR_NULL) {
-	    struct diff_result *result;
-	    BU_GET(result, struct diff_result);
-	    diff_init_result(result, diff3_tol, dp_right->d_namep);
-
-	    /* Do internal diffs */
-	    if (flags == DB_COMPARE_ALL || flags & DB_COMPARE_PARAM) {
-		state |= db_diff3_dp(dbip_left, dbip_ancestor, dbip_right, dp_left, dp_ancestor, dp_right, diff3_tol, DB_COMPARE_PARAM, result);
-	    }
-	    if (flags == DB_COMPARE_ALL || flags & DB_COMPARE_ATTRS) {
-		state |= db_diff3_dp(dbip_left, dbip_ancestor, dbip_right, dp_left, dp_ancestor, dp_right, diff3_tol, DB_COMPARE_ATTRS, result);
-	    }
+    /* now look for objects in the other database that aren't here */
+    FOR_ALL_DIRECTORY_START(dp2, dbip2) {
+	/* By this point, any differences will be additions */
+	if (db_lookup(dbip1, dp2->d_namep, 0) == RT_DIR_NULL)
+	    diff_task_add(&r, &cap, NULL, NULL, dp2);
+    } FOR_ALL_DIRECTORY_END;
 
-	    if (results) {
-		bu_ptbl_ins(results, (long *)result);
-	    } else {
-		diff_free_result(result);
-		BU_PUT(result, struct diff_result);
-	    }
+    return diff_run_tasks(&r, results);
+}
+
+
+int
+db_diff3(const struct db_i *dbip_left,
+	const struct db_i *dbip_ancestor,
+	const struct db_i *dbip_right,
+	const struct bn_tol *diff3_tol,
+	db_compare_criteria_t flags,
+	struct bu_ptbl *results)
+{
+    struct directory *dp_ancestor=RT_DIR_NULL, *dp_left=RT_DIR_NULL, *dp_right=RT_DIR_NULL;
+    struct diff_run r;
+    size_t cap = 0;
+
+    memset(&r, 0, sizeof(struct diff_run));
+    r.left = dbip_left;
+    r.ancestor = dbip_ancestor;
+    r.right = dbip_right;
+    r.tol = diff3_tol;
+    r.flags = flags;
+
+    /* Step 1: look at all objects in the ancestor database */
+    FOR_ALL_DIRECTORY_START(dp_ancestor, dbip_ancestor) {
+	dp_left = db_lookup(dbip_left, dp_ancestor->d_namep, 0);
+	dp_right = db_lookup(dbip_right, dp_ancestor->d_namep, 0);
+	diff_task_add(&r, &cap, dp_left, dp_ancestor, dp_right);
+    } FOR_ALL_DIRECTORY_END;
+
+    /* Step 2: objects new in the left database, and possibly the right */
+    FOR_ALL_DIRECTORY_START(dp_left, dbip_left) {
+	if (db_lookup(dbip_ancestor, dp_left->d_namep, 0) == RT_DIR_NULL) {
+	    dp_right = db_lookup(dbip_right, dp_left->d_namep, 0);
+	    diff_task_add(&r, &cap, dp_left, NULL, dp_right);
 	}
     } FOR_ALL_DIRECTORY_END;
 
-    return state;
+    /* Step 3: objects new only in the right database */
+    FOR_ALL_DIRECTORY_START(dp_right, dbip_right) {
+	if (db_lookup(dbip_ancestor, dp_right->d_namep, 0) == RT_DIR_NULL &&
+	    db_lookup(dbip_left, dp_right->d_namep, 0) == RT_DIR_NULL)
+	    diff_task_add(&r, &cap, NULL, NULL, dp_right);
+    } FOR_ALL_DIRECTORY_END;
+
+    return diff_run_tasks(&r, results);
 }
 
 /*
@@ -426,6 +426,12 @@ db_comb_has_instance(int *bval, const struct db_i *dbip, struct directory *cdp,
     if (!(cdp->d_flags & RT_DIR_COMB))
 	return 0;
 
+    /* As with _db_comb_instance, bval is only reported for specific instances */
+    int *cbval = (dbip->dbi_use_comb_instance_ids) ? bval : NULL;
+    int cret = db_comb_cache_member(NULL, cbval, (struct db_i *)dbip, cdp, dp->d_namep, itarget, &rt_uniresource);
+    if (cret != -2)
+	return (cret > 0) ? 1 : 0;
+
     struct rt_db_internal in;
     struct rt_comb_internal *comb;
     if (rt_db_get_internal(&in, cdp, dbip, NULL, &rt_uniresource) < 0)
@@ -834,6 +840,10 @@ _comb_instance_matrix(matp_t m, const struct db_i *dbip, struct directory *cdp,
     if (!(cdp->d_flags & RT_DIR_COMB))
 	return 0;
 
+    int cret = db_comb_cache_member(m, NULL, (struct db_i *)dbip, cdp, dp->d_namep, itarget, resp);
+    if (cret != -2)
+	return (cret > 0) ? 1 : 0;
+
     struct rt_db_internal in;
     struct rt_comb_internal *comb;
     if (rt_db_get_internal(&in, cdp, dbip, NULL, resp) < 0)
@@ -890,6 +900,10 @@ _comb_instance_bool_op(int *bval, const struct db_i *dbip, struct directory *cdp
     if (!(cdp->d_flags & RT_DIR_COMB))
 	return 0;
 
+    int cret = db_comb_cache_member(NULL, bval, (struct db_i *)dbip, cdp, dp->d_namep, itarget, resp);
+    if (cret != -2)
+	return (cret > 0) ? 1 : 0;
+
     struct rt_db_internal in;
     struct rt_comb_internal *comb;
     if (rt_db_get_internal(&in, cdp, dbip, NULL, resp) < 0)
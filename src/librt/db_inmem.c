@@ -41,6 +41,7 @@
 #include "vmath.h"
 #include "rt/db4.h"
 #include "raytrace.h"
+#include "librt_private.h"
 
 
 #define DEFAULT_DB_TITLE "Untitled BRL-CAD Database"
@@ -87,6 +88,16 @@ db_open_inmem(void)
     dbip->dbi_use_comb_instance_ids = 0;
     dbip->dbi_magic = DBI_MAGIC;		/* Now it's valid */
 
+    /* Same rules as db_open */
+    const char *search_index = getenv("LIBRT_SEARCH_INDEX");
+    if (!BU_STR_EQUAL(search_index, "0")) {
+	db_search_index_enable(dbip);
+    }
+    const char *comb_cache = getenv("LIBRT_COMB_CACHE");
+    if (!BU_STR_EQUAL(comb_cache, "0")) {
+	db_comb_cache_enable(dbip);
+    }
+
     /* These wdb modes aren't valid for an in-mem db */
     dbip->dbi_wdbp = NULL;
     dbip->dbi_wdbp_a = NULL;
@@ -144,11 +155,15 @@ db_create_inmem(void) {
 void
 db_inmem(struct directory *dp, struct bu_external *ext, int flags, struct db_i *dbip)
 {
+    int replaced = 0;
+
     BU_CK_EXTERNAL(ext);
     RT_CK_DIR(dp);
 
-    if (dp->d_flags & RT_DIR_INMEM)
+    if (dp->d_flags & RT_DIR_INMEM) {
+	replaced = (dp->d_un.ptr != NULL);
 	bu_free(dp->d_un.ptr, "db_inmem() ext ptr");
+    }
     dp->d_un.ptr = ext->ext_buf;
     if (db_version(dbip) < 5) {
 	/* DB_MINREC granule size */
@@ -161,6 +176,15 @@ db_inmem(struct directory *dp, struct bu_external *ext, int flags, struct db_i *
     /* Empty out the external structure, but leave it w/valid magic */
     ext->ext_buf = (uint8_t *)NULL;
     ext->ext_nbytes = 0;
+
+    /* Replacing an existing object is a modification (db_diradd has
+     * already reported new ones) */
+    if (replaced && BU_PTBL_IS_INITIALIZED(&dbip->dbi_changed_clbks)) {
+	for (size_t i = 0; i < BU_PTBL_LEN(&dbip->dbi_changed_clbks); i++) {
+	    struct dbi_changed_clbk *cb = (struct dbi_changed_clbk *)BU_PTBL_GET(&dbip->dbi_changed_clbks, i);
+	    (*cb->f)(dbip, dp, 0, cb->u_data);
+	}
+    }
 }
 
 
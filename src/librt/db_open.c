@@ -250,6 +250,19 @@ db_open(const char *name, const char *mode)
 
     dbip->dbi_magic = DBI_MAGIC;		/* Now it's valid */
 
+    /* Index attributes and types for db_search (built by the first
+     * search that needs it) */
+    const char *search_index = getenv("LIBRT_SEARCH_INDEX");
+    if (!BU_STR_EQUAL(search_index, "0")) {
+	db_search_index_enable(dbip);
+    }
+
+    /* Cache combs, member matrices and bounds for path evaluation */
+    const char *comb_cache = getenv("LIBRT_COMB_CACHE");
+    if (!BU_STR_EQUAL(comb_cache, "0")) {
+	db_comb_cache_enable(dbip);
+    }
+
     /* determine version */
     dbip->dbi_version = 0; /* make db_version() calculate */
     dbip->dbi_version = db_version(dbip);
@@ -438,6 +451,11 @@ db_close(register struct db_i *dbip)
 
     /* ready to free the database -- use count is now zero */
 
+    /* drop the search index and comb cache while the change
+     * callbacks are intact */
+    db_search_index_disable(dbip);
+    db_comb_cache_disable(dbip);
+
     /* free up any mapped files */
     bu_close_mapped_file(dbip->dbi_mf);
     bu_free_mapped_files(0);
@@ -30,6 +30,8 @@
 
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include <math.h>
 #include <string.h>
@@ -706,6 +708,7 @@ db_follow_path(
     long depth)		/* # arcs in new_path to use */
 {
     struct rt_db_internal intern;
+    const struct rt_db_internal *cintern;
     struct rt_comb_internal *comb;
     struct directory *comb_dp;	/* combination's dp */
     struct directory *dp;	/* element's dp */
@@ -805,25 +808,43 @@ db_follow_path(
 	    bu_log("db_follow_path() at %s/%s\n", comb_dp->d_namep, dp->d_namep);
 	}
 
-	/* Load the combination object into memory */
-	if (rt_db_get_internal(&intern, comb_dp, tsp->ts_dbip, NULL, tsp->ts_resp) < 0)
-	    goto fail;
-	comb = (struct rt_comb_internal *)intern.idb_ptr;
+	/* Load the combination object into memory, unless the comb
+	 * cache already has it */
+	cintern = db_comb_cache_get(tsp->ts_dbip, comb_dp, tsp->ts_resp);
+	if (cintern) {
+	    comb = (struct rt_comb_internal *)cintern->idb_ptr;
+	} else {
+	    if (rt_db_get_internal(&intern, comb_dp, tsp->ts_dbip, NULL, tsp->ts_resp) < 0)
+		goto fail;
+	    comb = (struct rt_comb_internal *)intern.idb_ptr;
+	}
 	RT_CK_COMB(comb);
-	if (db_apply_state_from_comb(tsp, total_path, comb) < 0)
+	if (db_apply_state_from_comb(tsp, total_path, comb) < 0) {
+	    if (cintern)
+		db_comb_cache_release(tsp->ts_dbip, cintern);
+	    else
+		rt_db_free_internal(&intern);
 	    goto fail;
+	}
 
 	/* Crawl tree searching for specified leaf */
 	if (UNLIKELY(tsp->ts_dbip->dbi_use_comb_instance_ids))
 	    c_inst_map.clear();
 	if (db_apply_state_from_one_member2(tsp, total_path, dp->d_namep, 0, comb->tree, itarget, (void *)&c_inst_map) <= 0) {
 	    bu_log("db_follow_path() ERROR: unable to apply member %s state\n", dp->d_namep);
+	    if (cintern)
+		db_comb_cache_release(tsp->ts_dbip, cintern);
+	    else
+		rt_db_free_internal(&intern);
 	    goto fail;
 	}
 	/* Found it, state has been applied, sofar applied, member's
 	 * directory entry pushed onto total_path
 	 */
-	rt_db_free_internal(&intern);
+	if (cintern)
+	    db_comb_cache_release(tsp->ts_dbip, cintern);
+	else
+	    rt_db_free_internal(&intern);
 
 	/* If member is a leaf, handle leaf processing too. */
 	if ((dp->d_flags & RT_DIR_COMB) == 0) {
@@ -1865,6 +1886,113 @@ _db_gettree_leaf(struct db_tree_state *tsp, const struct db_full_path *pathp, st
 }
 
 
+static union tree *_db_recurse(struct db_tree_state *tsp, struct db_full_path *pathp, struct combined_tree_state **region_start_statepp, void *client_data, int use_ccache);
+
+struct db_comb_prefetch_state {
+    struct db_i *dbip;
+    struct rt_i *rtip;
+    struct directory **dps;
+    const struct rt_db_internal **interns;
+    size_t count;
+    size_t current;		/* semaphored */
+};
+
+
+static void
+_db_comb_prefetch_worker(int cpu, void *arg)
+{
+    struct db_comb_prefetch_state *cps = (struct db_comb_prefetch_state *)arg;
+    struct resource *resp;
+    size_t mine;
+
+    if (cps->rtip == NULL || cpu == 0) {
+	resp = &rt_uniresource;
+    } else {
+	resp = (struct resource *)BU_PTBL_GET(&cps->rtip->rti_resources, cpu);
+	if (resp == NULL)
+	    resp = &rt_uniresource;
+    }
+    RT_CK_RESOURCE(resp);
+
+    while (1) {
+	bu_semaphore_acquire(RT_SEM_WORKER);
+	mine = cps->current++;
+	bu_semaphore_release(RT_SEM_WORKER);
+
+	if (mine >= cps->count)
+	    break;
+
+	cps->interns[mine] = db_comb_cache_get(cps->dbip, cps->dps[mine], resp);
+    }
+}
+
+
+static void
+_db_comb_prefetch_leaf(struct db_i *dbip, struct rt_comb_internal *UNUSED(comb), union tree *comb_leaf, void *seen, void *next, void *UNUSED(user_ptr3), void *UNUSED(user_ptr4))
+{
+    std::unordered_set<struct directory *> *sp = (std::unordered_set<struct directory *> *)seen;
+    std::vector<struct directory *> *nv = (std::vector<struct directory *> *)next;
+
+    struct directory *dp = db_lookup(dbip, comb_leaf->tr_l.tl_name, LOOKUP_QUIET);
+    if (!dp || !(dp->d_flags & RT_DIR_COMB) || dp->d_addr == RT_DIR_PHONY_ADDR)
+	return;
+
+    /* Queue each combination once, however many times it is used */
+    if (sp->insert(dp).second)
+	nv->push_back(dp);
+}
+
+
+/**
+ * Import into the database's comb cache, in parallel, every
+ * combination db_walk_tree() will visit above the regions (and the
+ * regions themselves), one level of the hierarchy at a time.  The walk
+ * itself stays serial so region start callbacks are made in the usual
+ * order, but it no longer waits on the database, and each shared
+ * subassembly is imported once no matter how many times it is
+ * referenced.  The parallel per-region walk takes the region
+ * combinations from the cache as well.
+ *
+ * References are dropped as soon as each level has been scanned, so
+ * the walk holds nothing beyond what the cache itself keeps.  Without
+ * a comb cache on dbip there is nothing to fill, and the walk imports
+ * each combination when it gets to it.
+ */
+static void
+_db_comb_prefetch(struct db_i *dbip, struct rt_i *rtip, int ncpu, std::vector<struct directory *> &level)
+{
+    size_t avail = (ncpu > 0) ? (size_t)ncpu : bu_avail_cpus();
+
+    if (!dbip->dbi_comb_cache)
+	return;
+
+    std::unordered_set<struct directory *> seen(level.begin(), level.end());
+    while (!level.empty()) {
+	struct db_comb_prefetch_state cps;
+	std::vector<const struct rt_db_internal *> interns(level.size(), NULL);
+	cps.dbip = dbip;
+	cps.rtip = rtip;
+	cps.dps = level.data();
+	cps.interns = interns.data();
+	cps.count = level.size();
+	cps.current = 0;
+	bu_parallel(_db_comb_prefetch_worker, (avail < level.size()) ? avail : level.size(), (void *)&cps);
+
+	/* Gather the next level in a fixed order */
+	std::vector<struct directory *> next;
+	for (size_t i = 0; i < level.size(); i++) {
+	    if (!interns[i])
+		continue;
+	    struct rt_comb_internal *comb = (struct rt_comb_internal *)interns[i]->idb_ptr;
+	    if (!comb->region_flag && comb->tree)
+		db_tree_funcleaf(dbip, comb, comb->tree, _db_comb_prefetch_leaf, (void *)&seen, (void *)&next, NULL, NULL);
+	    db_comb_cache_release(dbip, interns[i]);
+	}
+	level.swap(next);
+    }
+}
+
+
 struct db_walk_parallel_state {
     uint32_t magic;
     union tree **reg_trees;
@@ -1929,7 +2057,7 @@ _db_walk_subtree(
 	    if (UNLIKELY(ctsp->cts_s.ts_dbip->dbi_use_comb_instance_ids)) {
 		curtree = db_recurse2(&ctsp->cts_s, &ctsp->cts_p, region_start_statepp, client_data, cmap);
 	    } else {
-		curtree = db_recurse(&ctsp->cts_s, &ctsp->cts_p, region_start_statepp, client_data);
+		curtree = _db_recurse(&ctsp->cts_s, &ctsp->cts_p, region_start_statepp, client_data, 1);
 	    }
 	    if (curtree == TREE_NULL) {
 		char *str;
@@ -2100,26 +2228,45 @@ db_walk_tree(struct db_i *dbip,
     }
     RT_CK_RESOURCE(resp);
 
-    /* Walk each of the given path strings */
+    /* First, establish context from each of the given path strings */
+    std::vector<struct db_tree_state> tss(argc);
+    std::vector<struct db_full_path> paths(argc);
+    std::vector<int> found(argc, 0);
+    std::vector<struct directory *> roots;
     for (i = 0; i < argc; i++) {
-	union tree *curtree;
-	struct db_tree_state ts;
-	struct db_full_path path;
-	struct combined_tree_state *region_start_statep;
+	tss[i] = *init_state;	/* struct copy */
+	tss[i].ts_dbip = dbip;
+	tss[i].ts_resp = resp;
+	db_full_path_init(&paths[i]);
 
-	ts = *init_state;	/* struct copy */
-	ts.ts_dbip = dbip;
-	ts.ts_resp = resp;
-	db_full_path_init(&path);
-
-	/* First, establish context from given path */
-	if (db_follow_path_for_state(&ts, &path, argv[i],
+	if (db_follow_path_for_state(&tss[i], &paths[i], argv[i],
 				     LOOKUP_NOISY) < 0) {
 	    bu_log ("db_walk_tree: warning - %s not found.\n",
 		    argv[i]);
 	    ++ something_not_found;
 	    continue;	/* ERROR */
 	}
+	found[i] = 1;
+
+	struct directory *dp = (paths[i].fp_len > 0) ? DB_FULL_PATH_CUR_DIR(&paths[i]) : RT_DIR_NULL;
+	if (dp && (dp->d_flags & RT_DIR_COMB) && dp->d_addr != RT_DIR_PHONY_ADDR)
+	    roots.push_back(dp);
+    }
+
+    if (!dbip->dbi_use_comb_instance_ids)
+	_db_comb_prefetch(dbip, init_state->ts_rtip, ncpu, roots);
+
+    for (i = 0; i < argc; i++) {
+	union tree *curtree;
+	struct db_tree_state ts;
+	struct db_full_path path;
+	struct combined_tree_state *region_start_statep;
+
+	if (!found[i])
+	    continue;
+
+	ts = tss[i];		/* struct copy */
+	path = paths[i];	/* struct copy, freed below */
 	if (path.fp_len <= 0) {
 	    continue;	/* e.g., null combination */
 	}
@@ -2140,7 +2287,7 @@ db_walk_tree(struct db_i *dbip,
 	    std::unordered_map<std::string, int> c_inst_map;
 	    curtree = db_recurse2(&ts, &path, &region_start_statep, client_data, (void *)&c_inst_map);
 	} else {
-	    curtree = db_recurse(&ts, &path, &region_start_statep, client_data);
+	    curtree = _db_recurse(&ts, &path, &region_start_statep, client_data, 1);
 	}
 	if (region_start_statep)
 	    db_free_combined_tree_state(region_start_statep);
@@ -2168,8 +2315,9 @@ db_walk_tree(struct db_i *dbip,
 	}
     }
 
-    if (whole_tree == TREE_NULL)
+    if (whole_tree == TREE_NULL) {
 	return -1;	/* ERROR, nothing worked */
+    }
 
 
     /*
@@ -2879,7 +3027,7 @@ db_apply_state_from_one_member(
  * Helper routine for db_recurse()
  */
 static void
-_db_recurse_subtree_old(union tree *tp, struct db_tree_state *msp, struct db_full_path *pathp, struct combined_tree_state **region_start_statepp, void *client_data)
+_db_recurse_subtree_old(union tree *tp, struct db_tree_state *msp, struct db_full_path *pathp, struct combined_tree_state **region_start_statepp, void *client_data, int use_ccache)
 {
     struct db_tree_state memb_state;
     union tree *subtree;
@@ -2928,7 +3076,7 @@ _db_recurse_subtree_old(union tree *tp, struct db_tree_state *msp, struct db_ful
 	    }
 
 	    /* Recursive call */
-	    if ((subtree = db_recurse(&memb_state, pathp, region_start_statepp, client_data)) != TREE_NULL) {
+	    if ((subtree = _db_recurse(&memb_state, pathp, region_start_statepp, client_data, use_ccache)) != TREE_NULL) {
 		union tree *tmp;
 
 		/* graft subtree on in place of 'tp' leaf node */
@@ -2959,12 +3107,12 @@ _db_recurse_subtree_old(union tree *tp, struct db_tree_state *msp, struct db_ful
 	case OP_INTERSECT:
 	case OP_SUBTRACT:
 	case OP_XOR:
-	    _db_recurse_subtree_old(tp->tr_b.tb_left, &memb_state, pathp, region_start_statepp, client_data);
+	    _db_recurse_subtree_old(tp->tr_b.tb_left, &memb_state, pathp, region_start_statepp, client_data, use_ccache);
 	    if (tp->tr_op == OP_SUBTRACT)
 		memb_state.ts_sofar |= TS_SOFAR_MINUS;
 	    else if (tp->tr_op == OP_INTERSECT)
 		memb_state.ts_sofar |= TS_SOFAR_INTER;
-	    _db_recurse_subtree_old(tp->tr_b.tb_right, &memb_state, pathp, region_start_statepp, client_data);
+	    _db_recurse_subtree_old(tp->tr_b.tb_right, &memb_state, pathp, region_start_statepp, client_data, use_ccache);
 	    break;
 
 	default:
@@ -2977,11 +3125,17 @@ out:
     return;
 }
 
-union tree *
-db_recurse(struct db_tree_state *tsp, struct db_full_path *pathp, struct combined_tree_state **region_start_statepp, void *client_data)
+/**
+ * db_recurse(), taking combinations from the database's comb cache (see
+ * _db_comb_prefetch()) when use_ccache is set and dbip has one, rather
+ * than importing them.
+ */
+static union tree *
+_db_recurse(struct db_tree_state *tsp, struct db_full_path *pathp, struct combined_tree_state **region_start_statepp, void *client_data, int use_ccache)
 {
     struct directory *dp;
     struct rt_db_internal intern;
+    const struct rt_db_internal *cintern = NULL;
     union tree *curtree = TREE_NULL;
 
     RT_CK_DBTS(tsp);
@@ -3018,18 +3172,27 @@ db_recurse(struct db_tree_state *tsp, struct db_full_path *pathp, struct combine
 	struct db_tree_state nts;
 	int is_region;
 
-	if (rt_db_get_internal(&intern, dp, tsp->ts_dbip, NULL, tsp->ts_resp) < 0) {
-	    bu_log("db_recurse() rt_db_get_internal(%s) FAIL\n", dp->d_namep);
-	    curtree = TREE_NULL;		/* FAIL */
-	    goto out;
+	if (use_ccache)
+	    cintern = db_comb_cache_get(tsp->ts_dbip, dp, tsp->ts_resp);
+
+	if (cintern) {
+	    /* Already imported and synced, and shared - only read it */
+	    comb = (struct rt_comb_internal *)cintern->idb_ptr;
+	} else {
+	    if (rt_db_get_internal(&intern, dp, tsp->ts_dbip, NULL, tsp->ts_resp) < 0) {
+		bu_log("db_recurse() rt_db_get_internal(%s) FAIL\n", dp->d_namep);
+		curtree = TREE_NULL;		/* FAIL */
+		goto out;
+	    }
+	    comb = (struct rt_comb_internal *)intern.idb_ptr;
+	    RT_CK_COMB(comb);
+	    db5_sync_attr_to_comb(comb, &intern.idb_avs, dp);
 	}
 
 	/* Handle inheritance of material property. */
 	db_dup_db_tree_state(&nts, tsp);
 
-	comb = (struct rt_comb_internal *)intern.idb_ptr;
 	RT_CK_COMB(comb);
-	db5_sync_attr_to_comb(comb, &intern.idb_avs, dp);
 	if ((is_region = db_apply_state_from_comb(&nts, pathp, comb)) < 0) {
 	    db_free_db_tree_state(&nts);
 	    curtree = TREE_NULL;		/* FAIL */
@@ -3040,7 +3203,7 @@ db_recurse(struct db_tree_state *tsp, struct db_full_path *pathp, struct combine
 	    struct combined_tree_state *ctsp;
 
 	    /* get attribute/value structure */
-	    bu_avs_merge(&nts.ts_attrs, &intern.idb_avs);
+	    bu_avs_merge(&nts.ts_attrs, (cintern) ? &cintern->idb_avs : &intern.idb_avs);
 
 	    /*
 	     * This is the start of a new region.  If handler rejects
@@ -3080,7 +3243,18 @@ db_recurse(struct db_tree_state *tsp, struct db_full_path *pathp, struct combine
 	    }
 	}
 
-	if (comb->tree) {
+	if (comb->tree && cintern) {
+	    /* Copy the tree, leaving the cached one intact */
+	    curtree = db_dup_subtree(comb->tree, tsp->ts_resp);
+	    RT_CK_TREE(curtree);
+	    comb = NULL;
+	    db_comb_cache_release(tsp->ts_dbip, cintern);
+	    cintern = NULL;
+
+	    _db_recurse_subtree_old(curtree, &nts, pathp, region_start_statepp, client_data, use_ccache);
+	    if (curtree)
+		RT_CK_TREE(curtree);
+	} else if (comb->tree) {
 	    /* Steal tree from combination, so it won't be freed */
 	    curtree = comb->tree;
 	    comb->tree = TREE_NULL;
@@ -3091,7 +3265,7 @@ db_recurse(struct db_tree_state *tsp, struct db_full_path *pathp, struct combine
 	    rt_db_free_internal(&intern);
 	    comb = NULL;
 
-	    _db_recurse_subtree_old(curtree, &nts, pathp, region_start_statepp, client_data);
+	    _db_recurse_subtree_old(curtree, &nts, pathp, region_start_statepp, client_data, use_ccache);
 	    if (curtree)
 		RT_CK_TREE(curtree);
 	} else {
@@ -3187,6 +3361,8 @@ out:
     if (intern.idb_ptr != NULL) {
 	rt_db_free_internal(&intern);
     }
+    if (cintern)
+	db_comb_cache_release(tsp->ts_dbip, cintern);
     if (RT_G_DEBUG&RT_DEBUG_TREEWALK) {
 	char *sofar = db_path_to_string(pathp);
 	bu_log("db_recurse() return curtree=%p, pathp='%s', *statepp=%p\n",
@@ -3198,6 +3374,12 @@ out:
     return curtree;
 }
 
+union tree *
+db_recurse(struct db_tree_state *tsp, struct db_full_path *pathp, struct combined_tree_state **region_start_statepp, void *client_data)
+{
+    return _db_recurse(tsp, pathp, region_start_statepp, client_data, 0);
+}
+
 
 /** @} */
 
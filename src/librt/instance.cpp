@@ -0,0 +1,474 @@
+/*                    I N S T A N C E . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @addtogroup ray */
+/** @{ */
+/** @file librt/instance.cpp
+ *
+ * Shared preparation of primitives placed many times.
+ *
+ * rt_find_or_create_identical_solid() only merges references whose
+ * matrices are equal, so a fastener used 50,000 times in 50,000
+ * places would otherwise be prepped 50,000 times.  For the primitive
+ * types listed in instance_type_ok(), the second and later placements
+ * of an object are instead given instance soltabs: each still has its
+ * own bounds, bit number and region list, but st_specific only holds
+ * the rigid transform into the space of one private "prototype"
+ * soltab, prepped once per object.  The instance methods move the ray
+ * into prototype space, shoot the prototype, and move the results
+ * back.  As the transform is rigid, hit distances are unchanged.
+ *
+ * Placements that would scale, shear or project the prototype are
+ * prepped as ordinary solids.
+ */
+
+#include "common.h"
+
+#include <mutex>
+#include <unordered_map>
+
+#include <math.h>
+#include <string.h>
+
+#include "vmath.h"
+#include "bn/mat.h"
+#include "raytrace.h"
+
+#include "./cache.h"
+#include "./librt_private.h"
+
+
+struct instance_proto {
+    std::mutex lock;		/* held while the prototype is prepped or freed */
+    struct soltab *stp;		/* prepped prototype, or NULL */
+    long uses;			/* instance soltabs sharing stp */
+    int failed;			/* prototype prep failed, don't retry */
+};
+
+
+struct instance_registry {
+    std::mutex lock;
+    std::unordered_map<const struct directory *, struct instance_proto *> protos;
+};
+
+
+struct instance_specific {
+    struct instance_proto *proto;
+    mat_t to_proto;		/* model space to prototype space */
+    mat_t from_proto;		/* prototype space to model space */
+};
+
+
+static struct rt_functab instance_functab[ID_MAX_SOLID+1];
+static std::once_flag instance_functab_once;
+
+
+/*
+ * Types whose prep is expensive and whose methods don't depend on
+ * anything outside st_specific and the hit.
+ */
+static int
+instance_type_ok(int id)
+{
+    return (id == ID_BOT);
+}
+
+
+/*
+ * A rotation plus translation.  Reflections are orthonormal too, but
+ * they turn a solid inside out, so they are left to a full prep.
+ */
+static int
+instance_mat_is_rigid(const mat_t m, const struct bn_tol *tol)
+{
+    if (!ZERO(m[12]) || !ZERO(m[13]) || !ZERO(m[14]) || !NEAR_EQUAL(m[15], 1.0, tol->perp))
+	return 0;
+
+    for (int i = 0; i < 3; i++) {
+	for (int j = i; j < 3; j++) {
+	    fastf_t d = VDOT(&m[i*4], &m[j*4]);
+	    if (!NEAR_EQUAL(d, (i == j) ? 1.0 : 0.0, tol->perp))
+		return 0;
+	}
+    }
+
+    vect_t c;
+    VCROSS(c, &m[0], &m[4]);
+    return (VDOT(c, &m[8]) > 0.0);
+}
+
+
+static void
+instance_ray_to_proto(struct xray *out, const struct xray *in, const struct instance_specific *isp)
+{
+    *out = *in;
+    MAT4X3PNT(out->r_pt, isp->to_proto, in->r_pt);
+    MAT4X3VEC(out->r_dir, isp->to_proto, in->r_dir);
+}
+
+
+static void
+instance_hit_xform(struct hit *hitp, const mat_t xform)
+{
+    point_t pt;
+    vect_t norm;
+
+    MAT4X3PNT(pt, xform, hitp->hit_point);
+    MAT4X3VEC(norm, xform, hitp->hit_normal);
+    VMOVE(hitp->hit_point, pt);
+    VMOVE(hitp->hit_normal, norm);
+}
+
+
+static int
+instance_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct seg *seghead)
+{
+    struct instance_specific *isp = (struct instance_specific *)stp->st_specific;
+    struct soltab *proto = isp->proto->stp;
+    struct xray ray;
+    struct seg segs;
+    struct seg *segp;
+    int ret;
+
+    instance_ray_to_proto(&ray, rp, isp);
+
+    BU_LIST_INIT(&segs.l);
+    ret = proto->st_meth->ft_shot(proto, &ray, ap, &segs);
+    if (ret <= 0)
+	return ret;
+
+    /* Hand the segments back as belonging to this instance, with
+     * normals in model space and rays that outlive this call.
+     */
+    for (BU_LIST_FOR(segp, seg, &segs.l)) {
+	segp->seg_stp = stp;
+	instance_hit_xform(&segp->seg_in, isp->from_proto);
+	instance_hit_xform(&segp->seg_out, isp->from_proto);
+	if (segp->seg_in.hit_rayp == &ray)
+	    segp->seg_in.hit_rayp = rp;
+	if (segp->seg_out.hit_rayp == &ray)
+	    segp->seg_out.hit_rayp = rp;
+    }
+    BU_LIST_APPEND_LIST(&seghead->l, &segs.l);
+
+    return ret;
+}
+
+
+static void
+instance_norm(struct hit *hitp, struct soltab *stp, struct xray *rp)
+{
+    struct instance_specific *isp = (struct instance_specific *)stp->st_specific;
+    struct soltab *proto = isp->proto->stp;
+    struct xray ray;
+    struct xray *rayp = hitp->hit_rayp;
+
+    if (!proto->st_meth->ft_norm)
+	return;
+
+    instance_ray_to_proto(&ray, rp, isp);
+    instance_hit_xform(hitp, isp->to_proto);
+    proto->st_meth->ft_norm(hitp, proto, &ray);
+    instance_hit_xform(hitp, isp->from_proto);
+    hitp->hit_rayp = rayp;
+}
+
+
+static void
+instance_uv(struct application *ap, struct soltab *stp, struct hit *hitp, struct uvcoord *uvp)
+{
+    struct instance_specific *isp = (struct instance_specific *)stp->st_specific;
+    struct soltab *proto = isp->proto->stp;
+    struct hit hit = *hitp;
+
+    if (!proto->st_meth->ft_uv)
+	return;
+
+    instance_hit_xform(&hit, isp->to_proto);
+    proto->st_meth->ft_uv(ap, proto, &hit, uvp);
+}
+
+
+static void
+instance_curve(struct curvature *cvp, struct hit *hitp, struct soltab *stp)
+{
+    struct instance_specific *isp = (struct instance_specific *)stp->st_specific;
+    struct soltab *proto = isp->proto->stp;
+    struct hit hit = *hitp;
+    vect_t pdir;
+
+    if (!proto->st_meth->ft_curve)
+	return;
+
+    instance_hit_xform(&hit, isp->to_proto);
+    proto->st_meth->ft_curve(cvp, &hit, proto);
+    MAT4X3VEC(pdir, isp->from_proto, cvp->crv_pdir);
+    VMOVE(cvp->crv_pdir, pdir);
+}
+
+
+static void
+instance_print(const struct soltab *stp)
+{
+    const struct instance_specific *isp = (const struct instance_specific *)stp->st_specific;
+    const struct soltab *proto = isp->proto->stp;
+
+    bu_log("instance of shared %s prep\n", proto->st_meth->ft_label);
+    bn_mat_print("to prototype", isp->to_proto);
+    if (proto->st_meth->ft_print)
+	proto->st_meth->ft_print(proto);
+}
+
+
+static void
+instance_proto_free(struct soltab *proto)
+{
+    if (proto->st_aradius > 0 && proto->st_meth->ft_free)
+	proto->st_meth->ft_free(proto);
+    if (proto->st_matp)
+	bu_free((char *)proto->st_matp, "instance proto st_matp");
+    bu_free((char *)proto, "instance proto soltab");
+}
+
+
+static void
+instance_free(struct soltab *stp)
+{
+    struct instance_specific *isp = (struct instance_specific *)stp->st_specific;
+    struct instance_proto *p = isp->proto;
+
+    {
+	std::lock_guard<std::mutex> guard(p->lock);
+	if (--p->uses <= 0 && p->stp) {
+	    instance_proto_free(p->stp);
+	    p->stp = NULL;
+	}
+    }
+
+    BU_PUT(isp, struct instance_specific);
+    stp->st_specific = NULL;
+}
+
+
+static void
+instance_functab_init(void)
+{
+    for (int id = 0; id <= ID_MAX_SOLID; id++) {
+	if (!instance_type_ok(id))
+	    continue;
+	struct rt_functab *ft = &instance_functab[id];
+	*ft = OBJ[id];
+	ft->ft_shot = instance_shot;
+	ft->ft_norm = instance_norm;
+	ft->ft_uv = instance_uv;
+	ft->ft_curve = instance_curve;
+	ft->ft_print = instance_print;
+	ft->ft_free = instance_free;
+	ft->ft_piece_shot = NULL;
+	ft->ft_piece_hitsegs = NULL;
+	ft->ft_classify = NULL;
+	ft->ft_vshot = NULL;
+    }
+}
+
+
+static struct instance_proto *
+instance_proto_get(struct rt_i *rtip, const struct directory *dp)
+{
+    struct instance_registry *reg;
+
+    bu_semaphore_acquire(RT_SEM_MODEL);
+    if (!rtip->rti_instances)
+	rtip->rti_instances = (void *)new instance_registry;
+    reg = (struct instance_registry *)rtip->rti_instances;
+    bu_semaphore_release(RT_SEM_MODEL);
+
+    std::lock_guard<std::mutex> guard(reg->lock);
+    struct instance_proto *&p = reg->protos[dp];
+    if (!p) {
+	p = new instance_proto;
+	p->stp = NULL;
+	p->uses = 0;
+	p->failed = 0;
+    }
+    return p;
+}
+
+
+/*
+ * Prep a private soltab for stp's object in stp's placement.  It is
+ * never linked into the rt_i solid lists.
+ */
+static struct soltab *
+instance_proto_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_cache *cache)
+{
+    struct rt_i *rtip = stp->st_rtip;
+    struct soltab *proto;
+    int ret;
+
+    BU_ALLOC(proto, struct soltab);
+    proto->l.magic = RT_SOLTAB_MAGIC;
+    proto->l2.magic = RT_SOLTAB2_MAGIC;
+    proto->st_rtip = rtip;
+    proto->st_dp = stp->st_dp;
+    proto->st_uses = 1;
+    proto->st_id = stp->st_id;
+    proto->st_meth = &OBJ[stp->st_id];
+    if (stp->st_matp) {
+	proto->st_matp = (matp_t)bu_malloc(sizeof(mat_t), "instance proto st_matp");
+	MAT_COPY(proto->st_matp, stp->st_matp);
+    }
+    VSETALL(proto->st_max, -INFINITY);
+    VSETALL(proto->st_min,  INFINITY);
+
+    if (rtip->rti_dbip->dbi_version > 4) {
+	ret = rt_cache_prep(cache, proto, ip);
+    } else {
+	ret = rt_obj_prep(proto, ip, rtip);
+    }
+    if (ret || proto->st_id != stp->st_id || proto->st_aradius <= 0) {
+	instance_proto_free(proto);
+	return NULL;
+    }
+    return proto;
+}
+
+
+int
+rt_instance_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_cache *cache)
+{
+    struct rt_i *rtip;
+    struct instance_proto *p;
+    struct soltab *proto;
+    mat_t inst_inv;
+
+    RT_CK_SOLTAB(stp);
+    rtip = stp->st_rtip;
+    RT_CK_RTI(rtip);
+
+#ifdef USE_OPENCL
+    /* The OpenCL packers read st_specific directly */
+    return 1;
+#endif
+
+    /* Applications asking for one soltab per path get full preps, and
+     * the first placement of any object is prepped in place.
+     */
+    if (rtip->rti_dont_instance || !instance_type_ok(stp->st_id) || stp->st_dp->d_uses < 2)
+	return 1;
+
+    if (stp->st_matp) {
+	if (!bn_mat_inverse(inst_inv, stp->st_matp))
+	    return 1;
+    } else {
+	MAT_IDN(inst_inv);
+    }
+
+    std::call_once(instance_functab_once, instance_functab_init);
+
+    p = instance_proto_get(rtip, stp->st_dp);
+
+    std::lock_guard<std::mutex> guard(p->lock);
+    if (!p->stp) {
+	if (p->failed)
+	    return 1;
+	p->stp = instance_proto_prep(stp, ip, cache);
+	if (!p->stp) {
+	    p->failed = 1;
+	    return 1;
+	}
+    }
+    proto = p->stp;
+
+    struct instance_specific *isp;
+    BU_GET(isp, struct instance_specific);
+    if (proto->st_matp) {
+	bn_mat_mul(isp->to_proto, proto->st_matp, inst_inv);
+    } else {
+	MAT_COPY(isp->to_proto, inst_inv);
+    }
+    if (!instance_mat_is_rigid(isp->to_proto, &rtip->rti_tol)) {
+	BU_PUT(isp, struct instance_specific);
+	return 1;
+    }
+    bn_mat_inv(isp->from_proto, isp->to_proto);
+    isp->proto = p;
+    p->uses++;
+
+    stp->st_specific = (void *)isp;
+    stp->st_meth = &instance_functab[stp->st_id];
+    stp->st_aradius = proto->st_aradius;
+    stp->st_bradius = proto->st_bradius;
+    stp->st_npieces = 0;
+    MAT4X3PNT(stp->st_center, isp->from_proto, proto->st_center);
+
+    /* Bound the moved box corners, clipped to the bounding sphere */
+    VSETALL(stp->st_max, -INFINITY);
+    VSETALL(stp->st_min,  INFINITY);
+    for (int i = 0; i < 8; i++) {
+	point_t c, wc;
+	VSET(c,
+	     (i & 1) ? proto->st_max[X] : proto->st_min[X],
+	     (i & 2) ? proto->st_max[Y] : proto->st_min[Y],
+	     (i & 4) ? proto->st_max[Z] : proto->st_min[Z]);
+	MAT4X3PNT(wc, isp->from_proto, c);
+	VMINMAX(stp->st_min, stp->st_max, wc);
+    }
+    for (int i = X; i <= Z; i++) {
+	stp->st_min[i] = FMAX(stp->st_min[i], stp->st_center[i] - stp->st_bradius);
+	stp->st_max[i] = FMIN(stp->st_max[i], stp->st_center[i] + stp->st_bradius);
+    }
+
+    return 0;
+}
+
+
+void
+rt_instance_clean(struct rt_i *rtip)
+{
+    struct instance_registry *reg;
+
+    RT_CK_RTI(rtip);
+    reg = (struct instance_registry *)rtip->rti_instances;
+    if (!reg)
+	return;
+
+    /* Instance soltabs release their prototypes as they are freed, so
+     * anything left was prepped but never used.
+     */
+    for (auto &e : reg->protos) {
+	if (e.second->stp)
+	    instance_proto_free(e.second->stp);
+	delete e.second;
+    }
+    delete reg;
+    rtip->rti_instances = NULL;
+}
+
+
+/** @} */
+
+// Local Variables:
+// tab-width: 8
+// mode: C++
+// c-basic-offset: 4
+// indent-tabs-mode: t
+// c-file-style: "stroustrup"
+// End:
+// ex: shiftwidth=4 tabstop=8
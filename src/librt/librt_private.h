@@ -125,6 +125,27 @@ extern void rt_plot_cell(const union cutter *cutp, struct rt_shootray_status *ss
 extern int cyclic_path(const struct db_full_path *fp, const char *test_name, long int depth);
 
 
+/* instance.cpp */
+
+struct rt_cache;
+
+/**
+ * Called by the gettree leaf function on a newly created soltab whose
+ * st_id and st_meth are set, in place of its prep.  If stp is a later
+ * placement of an object type that supports it and the placement is a
+ * rigid motion of a shared prototype prep, stp is set up as an
+ * instance of that prototype and 0 is returned.  Otherwise nothing is
+ * changed and non-zero is returned, and stp must be prepped normally.
+ */
+extern int rt_instance_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_cache *cache);
+
+/**
+ * Release the prototype registry of an rt_i.  Called by rt_clean()
+ * after all the soltabs are freed.
+ */
+extern void rt_instance_clean(struct rt_i *rtip);
+
+
 /* db_diff.c */
 
 /**
@@ -227,6 +248,30 @@ extern void plot_ellipse(
 extern int _rt_tcl_list_to_int_array(const char *list, int **array, int *array_len);
 extern int _rt_tcl_list_to_fastf_array(const char *list, fastf_t **array, int *array_len);
 
+/* search.cpp */
+/* Classification of a non-combination object, as used by the -type
+ * filter.  label points to static storage (either the primitive's
+ * ft_label or one of the arb4-arb8/invalid strings). */
+struct db_search_type_info {
+    int valid;		/* 0 if not a BRL-CAD geometry object */
+    const char *label;
+    int is_shape;
+    int is_plate;
+    int is_volume;
+};
+extern int db_search_type_info_get(struct db_search_type_info *info, struct directory *dp, struct db_i *dbip, struct resource *resp);
+
+/* search_index.cpp - the lookups return -2 if dbip has no search index
+ * or the index isn't current for dp, in which case the caller reads the
+ * object itself.  db_search_index_sync builds the index or brings it up
+ * to date after edits, and must not be called while a search is being
+ * evaluated. */
+extern int db_search_index_sync(struct db_i *dbip);
+extern int db_search_index_attr(struct db_i *dbip, struct directory *dp, const char *key, const char *value);
+extern int db_search_index_avs(struct db_i *dbip, struct directory *dp, int (*avs_chk)(struct bu_attribute_value_set *, void *), void *data);
+extern int db_search_index_type(struct db_search_type_info *info, struct db_i *dbip, struct directory *dp);
+extern int db_search_index_has_type(struct db_i *dbip, struct directory *dp, const char *label);
+
 /* view.c */
 extern fastf_t solid_point_spacing(const struct bview *gvp, fastf_t solid_width);
 extern fastf_t view_avg_sample_spacing(const struct bview *gvp);
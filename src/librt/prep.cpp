@@ -28,8 +28,10 @@
 
 #include "common.h"
 
+#include <set>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <stdlib.h>
 #include <stddef.h>
@@ -47,6 +49,8 @@
 #include "optical.h"
 #include "optical/plastic.h"
 
+#include "./librt_private.h"
+
 
 extern void rt_ck(struct rt_i *rtip);
 
@@ -155,6 +159,7 @@ rt_free_rti(struct rt_i *rtip)
 {
     RT_CK_RTI(rtip);
 
+    rt_reprep_unwatch(rtip);
     rt_clean(rtip);
 
 #if 0
@@ -893,6 +898,9 @@ rt_init_resource(struct resource *resp, int cpu_num, struct rt_i *rtip)
     resp->re_boolstack = NULL;
     resp->re_boolslen = 0;
 
+    /* Must precede setting the magic number */
+    rt_prof_init_resource(resp);
+
     resp->re_cpu = cpu_num;
     resp->re_magic = RESOURCE_MAGIC;
 
@@ -1013,6 +1021,8 @@ rt_clean_resource_basic(struct rt_i *rtip, struct resource *resp)
     /* Release the state variables for 'solid pieces' */
     rt_res_pieces_clean(resp, rtip);
 
+    rt_prof_free_resource(resp);
+
     /* invalidate the resource */
     if (resp != &rt_uniresource)
 	resp->re_magic = 0;
@@ -1171,6 +1181,7 @@ rt_clean(struct rt_i *rtip)
 	}
     }
     rtip->nsolids = 0;
+    rt_instance_clean(rtip);
 
     /* Clean out the array of pointers to regions, if any */
     if (rtip->Regions) {
@@ -1205,6 +1216,9 @@ rt_clean(struct rt_i *rtip)
 	rtip->rti_Solids = (struct soltab **)0;
     }
 
+    /* Report profiling counters before the resources are cleaned */
+    rt_prof_report(rtip);
+
     /*
      * Clean out every cpu's "struct resource".  These are provided by
      * the caller's application (or are defaulted to rt_uniresource)
@@ -2081,6 +2095,332 @@ rt_reprep(struct rt_i *rtip, struct rt_reprep_obj_list *objs, struct resource *r
 }
 
 
+/* State kept for rt_reprep_watch() */
+struct reprep_watch {
+    std::vector<std::string> tops;	/* rt_gettrees() arguments */
+    size_t ncpus;
+    std::set<std::string> names;	/* everything the tops reference */
+    std::set<std::string> edited;	/* primitives changed since last update */
+    int rebuild;			/* non-primitive change seen */
+};
+
+
+static void
+reprep_watch_leaf(struct db_i *dbip, struct rt_comb_internal *UNUSED(comb), union tree *comb_leaf, void *user_ptr1, void *UNUSED(user_ptr2), void *UNUSED(user_ptr3), void *UNUSED(user_ptr4));
+
+/* Record name and, if it is a combination, everything below it.  Names
+ * that don't exist (yet) are recorded too, since creating one of them
+ * changes the geometry.
+ */
+static void
+reprep_watch_collect(struct db_i *dbip, const char *name, struct reprep_watch *w)
+{
+    struct directory *dp;
+    struct rt_db_internal intern;
+
+    if (!w->names.insert(std::string(name)).second)
+	return;
+
+    dp = db_lookup(dbip, name, LOOKUP_QUIET);
+    if (dp == RT_DIR_NULL || !(dp->d_flags & RT_DIR_COMB))
+	return;
+
+    if (rt_db_get_internal(&intern, dp, dbip, NULL, &rt_uniresource) < 0)
+	return;
+
+    struct rt_comb_internal *comb = (struct rt_comb_internal *)intern.idb_ptr;
+    RT_CK_COMB(comb);
+    if (comb->tree)
+	db_tree_funcleaf(dbip, comb, comb->tree, reprep_watch_leaf, (void *)w, NULL, NULL, NULL);
+    rt_db_free_internal(&intern);
+}
+
+
+static void
+reprep_watch_leaf(struct db_i *dbip, struct rt_comb_internal *UNUSED(comb), union tree *comb_leaf, void *user_ptr1, void *UNUSED(user_ptr2), void *UNUSED(user_ptr3), void *UNUSED(user_ptr4))
+{
+    RT_CK_TREE(comb_leaf);
+    reprep_watch_collect(dbip, comb_leaf->tr_l.tl_name, (struct reprep_watch *)user_ptr1);
+}
+
+
+static void
+reprep_watch_names(struct rt_i *rtip, struct reprep_watch *w)
+{
+    w->names.clear();
+    for (size_t i = 0; i < w->tops.size(); i++) {
+	/* Top objects may be given as paths, every element of which
+	 * contributes a matrix.
+	 */
+	struct db_full_path path;
+	db_full_path_init(&path);
+	if (db_string_to_path(&path, rtip->rti_dbip, w->tops[i].c_str()) < 0 || !path.fp_len) {
+	    w->names.insert(w->tops[i]);
+	    db_free_full_path(&path);
+	    continue;
+	}
+	for (size_t j = 0; j + 1 < path.fp_len; j++)
+	    w->names.insert(std::string(path.fp_names[j]->d_namep));
+	reprep_watch_collect(rtip->rti_dbip, DB_FULL_PATH_CUR_DIR(&path)->d_namep, w);
+	db_free_full_path(&path);
+    }
+}
+
+
+static void
+reprep_watch_changed(struct db_i *UNUSED(dbip), struct directory *dp, int mode, void *u_data)
+{
+    struct reprep_watch *w = (struct reprep_watch *)u_data;
+
+    if (!dp || !dp->d_namep)
+	return;
+
+    std::string name(dp->d_namep);
+    if (w->names.find(name) == w->names.end())
+	return;
+
+    if (mode == 0 && !(dp->d_flags & RT_DIR_COMB)) {
+	w->edited.insert(name);
+    } else {
+	w->rebuild = 1;
+    }
+}
+
+
+int
+rt_reprep_watch(struct rt_i *rtip, int argc, const char **argv, size_t ncpus)
+{
+    struct reprep_watch *w;
+
+    RT_CK_RTI(rtip);
+    if (argc < 1 || !argv)
+	return -1;
+
+    w = (struct reprep_watch *)rtip->rti_reprep_watch;
+    if (!w) {
+	w = new reprep_watch;
+	if (db_add_changed_clbk(rtip->rti_dbip, reprep_watch_changed, (void *)w)) {
+	    delete w;
+	    return -1;
+	}
+	rtip->rti_reprep_watch = (void *)w;
+    }
+
+    w->tops.clear();
+    for (int i = 0; i < argc; i++)
+	w->tops.push_back(std::string(argv[i]));
+    w->ncpus = ncpus;
+    w->edited.clear();
+    w->rebuild = 0;
+    reprep_watch_names(rtip, w);
+
+    return 0;
+}
+
+
+void
+rt_reprep_unwatch(struct rt_i *rtip)
+{
+    struct reprep_watch *w;
+
+    RT_CK_RTI(rtip);
+    w = (struct reprep_watch *)rtip->rti_reprep_watch;
+    if (!w)
+	return;
+
+    if (rtip->rti_dbip)
+	(void)db_rm_changed_clbk(rtip->rti_dbip, reprep_watch_changed, (void *)w);
+    delete w;
+    rtip->rti_reprep_watch = NULL;
+}
+
+
+/* Prep one soltab again from the current database contents, moving it
+ * in the space partitioning tree if rtip has already been prepped.
+ * Returns 0 on success, or 1 if the change can't be made in place.
+ */
+static int
+reprep_soltab(struct rt_i *rtip, struct soltab *stp, struct resource *resp, int prepped)
+{
+    struct rt_db_internal intern;
+    int old_id = stp->st_id;
+    long old_npieces = stp->st_npieces;
+    int ret;
+
+    if (rt_db_get_internal(&intern, (struct directory *)stp->st_dp, rtip->rti_dbip, stp->st_matp, resp) < 0)
+	return 1;
+    if (intern.idb_type <= 0 || intern.idb_type > ID_MAX_SOLID) {
+	rt_db_free_internal(&intern);
+	return 1;
+    }
+
+    /* The old bounds select the cells to remove the solid from */
+    if (prepped) {
+	remove_from_bsp(stp, &rtip->rti_inf_box, &rtip->rti_tol);
+	remove_from_bsp(stp, &rtip->rti_CutHead, &rtip->rti_tol);
+    }
+
+    if (stp->st_aradius > 0 && stp->st_meth->ft_free)
+	stp->st_meth->ft_free(stp);
+    stp->st_specific = NULL;
+    stp->st_aradius = 0;
+    stp->st_bradius = 0;
+    stp->st_npieces = 0;
+    VSETALL(stp->st_max, -INFINITY);
+    VSETALL(stp->st_min,  INFINITY);
+
+    stp->st_id = intern.idb_type;
+    stp->st_meth = &OBJ[intern.idb_type];
+    ret = rt_obj_prep(stp, &intern, rtip);
+    rt_db_free_internal(&intern);
+
+    /* The per-type solid tables and the piece state indices can't be
+     * patched, so those changes need a full rebuild.
+     */
+    if (ret || stp->st_id != old_id || (old_npieces > 1) != (stp->st_npieces > 1)) {
+	bu_log("rt_reprep_pending(%s): unable to re-prep in place\n", stp->st_dp->d_namep);
+	return 1;
+    }
+
+    if (stp->st_aradius < INFINITY) {
+	VMINMAX(rtip->mdl_min, rtip->mdl_max, stp->st_min);
+	VMINMAX(rtip->mdl_min, rtip->mdl_max, stp->st_max);
+    }
+
+    if (!prepped)
+	return 0;
+
+    if (stp->st_npieces > 1) {
+	/* Size each processor's "already shot" bits for the new pieces */
+	for (size_t i = 0; i < BU_PTBL_LEN(&rtip->rti_resources); i++) {
+	    struct resource *re = (struct resource *)BU_PTBL_GET(&rtip->rti_resources, i);
+	    if (!re || !re->re_pieces)
+		continue;
+	    struct rt_piecestate *psp = &re->re_pieces[stp->st_piecestate_num];
+	    if (psp->magic != RT_PIECESTATE_MAGIC)
+		continue;
+	    bu_bitv_free(psp->shot);
+	    psp->shot = bu_bitv_new(stp->st_npieces);
+	    psp->cutp = CUTTER_NULL;
+	}
+    }
+
+    if (stp->st_aradius >= INFINITY) {
+	insert_in_bsp(stp, &rtip->rti_inf_box);
+    } else {
+	insert_in_bsp(stp, &rtip->rti_CutHead);
+    }
+
+    /* As in rt_prep_parallel(), piece RPPs are only needed for cutting */
+    if (stp->st_piece_rpps) {
+	bu_free((char *)stp->st_piece_rpps, "st_piece_rpps[]");
+	stp->st_piece_rpps = NULL;
+    }
+
+    return 0;
+}
+
+
+int
+rt_reprep_pending(struct rt_i *rtip, struct resource *resp)
+{
+    struct reprep_watch *w;
+    int prepped;
+    int rebuild;
+    point_t old_min, old_max;
+
+    RT_CK_RTI(rtip);
+    w = (struct reprep_watch *)rtip->rti_reprep_watch;
+    if (!w || (!w->rebuild && w->edited.empty()))
+	return 0;
+    if (!resp)
+	resp = &rt_uniresource;
+    RT_CK_RESOURCE(resp);
+
+    prepped = !rtip->needprep;
+    rebuild = w->rebuild;
+    VMOVE(old_min, rtip->mdl_min);
+    VMOVE(old_max, rtip->mdl_max);
+
+    std::set<std::string>::iterator n_it;
+    for (n_it = w->edited.begin(); !rebuild && n_it != w->edited.end(); n_it++) {
+	struct directory *dp = db_lookup(rtip->rti_dbip, n_it->c_str(), LOOKUP_QUIET);
+	int found = 0;
+
+	if (dp == RT_DIR_NULL || (dp->d_flags & RT_DIR_COMB)) {
+	    rebuild = 1;
+	    break;
+	}
+
+	/* One soltab per distinct matrix this primitive is used with */
+	struct bu_list *mid = BU_LIST_FIRST(bu_list, &dp->d_use_hd);
+	while (mid != &dp->d_use_hd) {
+	    struct soltab *stp = BU_LIST_MAIN_PTR(soltab, mid, l2);
+	    RT_CK_SOLTAB(stp);
+	    mid = BU_LIST_PNEXT(bu_list, mid);
+	    if (stp->st_rtip != rtip)
+		continue;
+	    found = 1;
+	    if (reprep_soltab(rtip, stp, resp, prepped)) {
+		rebuild = 1;
+		break;
+	    }
+	}
+
+	/* Used by the tree but not prepped, e.g. a previous prep
+	 * failure, so there is nothing to patch.
+	 */
+	if (!found)
+	    rebuild = 1;
+    }
+
+    w->edited.clear();
+    w->rebuild = 0;
+
+    if (rebuild) {
+	std::vector<const char *> av;
+	for (size_t i = 0; i < w->tops.size(); i++)
+	    av.push_back(w->tops[i].c_str());
+
+	rt_clean(rtip);
+	if (rt_gettrees(rtip, (int)av.size(), av.data(), w->ncpus) < 0) {
+	    bu_log("rt_reprep_pending(): rt_gettrees() failed\n");
+	    return -1;
+	}
+	if (prepped)
+	    rt_prep_parallel(rtip, (int)w->ncpus);
+	reprep_watch_names(rtip, w);
+	return 2;
+    }
+
+    if (prepped && (!VNEAR_EQUAL(rtip->mdl_min, old_min, SMALL_FASTF)
+		    || !VNEAR_EQUAL(rtip->mdl_max, old_max, SMALL_FASTF)))
+    {
+	/* Model RPP grew: keep the rounding done by rt_prep_parallel()
+	 * and stretch the outer cells to fill it.
+	 */
+	fastf_t bb[6];
+	vect_t diag;
+
+	rtip->mdl_min[X] = floor(rtip->mdl_min[X]);
+	rtip->mdl_min[Y] = floor(rtip->mdl_min[Y]);
+	rtip->mdl_min[Z] = floor(rtip->mdl_min[Z]);
+	rtip->mdl_max[X] = ceil(rtip->mdl_max[X]);
+	rtip->mdl_max[Y] = ceil(rtip->mdl_max[Y]);
+	rtip->mdl_max[Z] = ceil(rtip->mdl_max[Z]);
+	VSUB2(diag, rtip->mdl_max, rtip->mdl_min);
+	rtip->rti_radius = 0.5 * MAGNITUDE(diag);
+
+	VSETALL(bb, INFINITY);
+	VSETALL(&bb[3], -INFINITY);
+	fill_out_bsp(rtip, &rtip->rti_CutHead, resp, bb);
+    }
+
+    return 1;
+}
+
+
+
 /** @} */
 
 
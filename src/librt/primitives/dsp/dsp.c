@@ -65,6 +65,7 @@
 
 /* private header */
 #include "./dsp.h"
+#include "../../sidecar.h"
 
 
 #define FULL_DSP_DEBUGGING 1
@@ -91,36 +92,27 @@ struct dsp_rpp {
 
 
 /**
- * This structure contains a bounding box for a portion of the DSP
- * along with information about sub-bounding boxes, and what layer
- * (resolution) of the DSP this box bounds
+ * The bounding boxes for the DSP are kept as a pyramid of elevation
+ * ranges.  Layer 0 has one entry per cell of the DSP, and each entry
+ * of layer N covers a DIM_BB_CHILDREN x DIM_BB_CHILDREN block of
+ * layer N-1 (fewer along the far X and Y borders).  The X and Y
+ * extents of an entry follow from its position in the layer, so only
+ * the Z range is stored and no child pointers are needed.
  */
-struct dsp_bb {
-    uint32_t magic;
-    struct dsp_rpp dspb_rpp;	/* our bounding box */
-    /*
-     * the next two elements indicate the number and locations of
-     * sub-bounding rpps.
-     *
-     * dsp_b_ch_dim is typically DIM_BB_CHILDREN, DIM_BB_CHILDREN
-     * except for "border" areas of the array
-     */
-    unsigned short dspb_subcell_size;/* XXX This is not yet computed */
-    unsigned short dspb_ch_dim[2];	/* dimensions of children[] */
-    struct dsp_bb *dspb_children[NUM_BB_CHILDREN];
+struct dsp_zrange {
+    unsigned short zmin;
+    unsigned short zmax;
 };
 
 
-#define MAGIC_dsp_bb 234
-#define DSP_BB_CK(_p) BU_CKMAG(_p, MAGIC_dsp_bb, "dsp_bb")
 /*
  * This structure provides a handle to all of the bounding boxes for
  * the DSP at a particular resolution.
  */
-#define LAYER(l, x, y) l->p[l->dim[1]*y+x]
 struct dsp_bb_layer {
     unsigned int dim[2]; /* the dimensions of the array at element p */
-    struct dsp_bb *p; /* array of dsp_bb's for this level */
+    unsigned int cell_size; /* DSP cells spanned by each element */
+    struct dsp_zrange *p; /* elevation ranges for this level */
 };
 
 # define XCNT(_p) (((struct rt_dsp_internal *)_p)->dsp_xcnt)
@@ -162,7 +154,8 @@ struct dsp_specific {
     int ysiz;
     int layers;
     struct dsp_bb_layer *layer;
-    struct dsp_bb *bb_array;
+    struct dsp_zrange *bb_array;	/* all layers, contiguous */
+    struct bu_mapped_file *bb_mp;	/* sidecar holding bb_array, if any */
 };
 
 
@@ -210,6 +203,25 @@ static const vect_t dsp_pl[BBOX_PLANES] = {
 };
 
 
+/**
+ * Fill in the bounding box of element (x, y) of a bounding box layer
+ */
+static inline void
+dsp_layer_rpp(const struct dsp_specific *dsp, int l, unsigned int x, unsigned int y, struct dsp_rpp *rpp)
+{
+    const struct dsp_bb_layer *lp = &dsp->layer[l];
+    const struct dsp_zrange *zr = &lp->p[y * lp->dim[X] + x];
+    unsigned int xmax = (x + 1) * lp->cell_size;
+    unsigned int ymax = (y + 1) * lp->cell_size;
+
+    if (xmax > (unsigned int)dsp->xsiz) xmax = dsp->xsiz;
+    if (ymax > (unsigned int)dsp->ysiz) ymax = dsp->ysiz;
+
+    VSET(rpp->dsp_min, x * lp->cell_size, y * lp->cell_size, zr->zmin);
+    VSET(rpp->dsp_max, xmax, ymax, zr->zmax);
+}
+
+
 static void
 hook_verify(const struct bu_structparse *sp,
 	    const char *sp_name,
@@ -337,10 +349,10 @@ plot_rpp(FILE *fp, struct bound_rpp *rpp, int r, int g, int b)
 
 
 /**
- * Plot a dsp_bb structure
+ * Plot a DSP bounding box
  */
 static void
-plot_dsp_bb(FILE *fp, struct dsp_bb *dsp_bb,
+plot_dsp_bb(FILE *fp, const struct dsp_rpp *dsp_rpp,
 	    struct dsp_specific *dsp,
 	    int r, int g, int b, int blather)
 {
@@ -348,12 +360,10 @@ plot_dsp_bb(FILE *fp, struct dsp_bb *dsp_bb,
     struct bound_rpp rpp;
     point_t pt;
 
-    DSP_BB_CK(dsp_bb);
-
-    VMOVE(pt, dsp_bb->dspb_rpp.dsp_min); /* int->float conversion */
+    VMOVE(pt, dsp_rpp->dsp_min); /* int->float conversion */
     MAT4X3PNT(rpp.min, stom, pt);
 
-    VMOVE(pt, dsp_bb->dspb_rpp.dsp_max); /* int->float conversion */
+    VMOVE(pt, dsp_rpp->dsp_max); /* int->float conversion */
     MAT4X3PNT(rpp.max, stom, pt);
 
     if (blather)
@@ -369,13 +379,13 @@ plot_dsp_bb(FILE *fp, struct dsp_bb *dsp_bb,
  */
 static FILE *
 draw_dsp_bb(int *plotnum,
-	    struct dsp_bb *dsp_bb,
+	    const struct dsp_rpp *dsp_rpp,
 	    struct dsp_specific *dsp,
 	    int r, int g, int b)
 {
     char buf[64];
     FILE *fp;
-    struct dsp_bb bb;
+    struct dsp_rpp bb;
 
     sprintf(buf, "dsp_bb%03d.plot3", (*plotnum)++);
     if ((fp=fopen(buf, "wb")) == (FILE *)NULL) {
@@ -384,8 +394,8 @@ draw_dsp_bb(int *plotnum,
     }
 
     bu_log("plotting %s", buf);
-    bb = *dsp_bb; /* struct copy */
-    bb.dspb_rpp.dsp_min[Z] = 0.0;
+    bb = *dsp_rpp; /* struct copy */
+    bb.dsp_min[Z] = 0;
     plot_dsp_bb(fp, &bb, dsp, r, g, b, 1);
 
     return fp;
@@ -403,7 +413,7 @@ static void
 plot_layers(struct dsp_specific *dsp_sp)
 {
     FILE *fp;
-    int l, n;
+    int l;
     unsigned int x, y;
     char buf[32];
     static int colors[7][3] = {
@@ -416,7 +426,7 @@ plot_layers(struct dsp_specific *dsp_sp)
 	{255, 255, 255}
     };
     int r, g, b, c;
-    struct dsp_bb *d_bb;
+    struct dsp_rpp rpp;
 
     for (l = 0; l < dsp_sp->layers; l++) {
 	bu_semaphore_acquire(BU_SEM_SYSCALL);
@@ -438,9 +448,8 @@ plot_layers(struct dsp_specific *dsp_sp)
 
 	for (y = 0; y < dsp_sp->layer[l].dim[Y]; y+= 2) {
 	    for (x = 0; x < dsp_sp->layer[l].dim[X]; x+= 2) {
-		n = y * dsp_sp->layer[l].dim[X] + x;
-		d_bb = &dsp_sp->layer[l].p[n];
-		plot_dsp_bb(fp, d_bb, dsp_sp, r, g, b, 0);
+		dsp_layer_rpp(dsp_sp, l, x, y, &rpp);
+		plot_dsp_bb(fp, &rpp, dsp_sp, r, g, b, 0);
 
 	    }
 	}
@@ -457,7 +466,7 @@ plot_layers(struct dsp_specific *dsp_sp)
  */
 static void
 plot_cell_top(struct isect_stuff *isect,
-	      struct dsp_bb *dsp_bb,
+	      struct dsp_rpp *rpp,
 	      point_t A,
 	      point_t B,
 	      point_t C,
@@ -481,8 +490,6 @@ plot_cell_top(struct isect_stuff *isect,
 	{128, 255, 255},
     };
 
-    DSP_BB_CK(dsp_bb);
-
     bu_semaphore_acquire(BU_SEM_SYSCALL);
     if (style)
 	sprintf(buf, "dsp_cell_isect%04d.plot3", cnt++);
@@ -500,7 +507,7 @@ plot_cell_top(struct isect_stuff *isect,
 	bu_log("plotting %s flags 0x%x\n\t", buf, hitflags);
     }
 
-    plot_dsp_bb(fp, dsp_bb, isect->dsp, 128, 128, 128, 1);
+    plot_dsp_bb(fp, rpp, isect->dsp, 128, 128, 128, 1);
 
     /* plot the triangulation */
     pl_color(fp, 255, 255, 255);
@@ -620,74 +627,43 @@ rt_dsp_print(register const struct soltab *stp)
 }
 
 
-/**
- * compute bounding boxes for each cell, then compute bounding boxes
- * for collections of bounding boxes
- */
+/* point each layer at its portion of the pyramid starting at base */
 static void
-dsp_layers(struct dsp_specific *dsp, unsigned short *d_min, unsigned short *d_max)
+dsp_layers_point(struct dsp_specific *dsp, struct dsp_zrange *base)
 {
-    int idx, curr_layer, xs, ys, xv, yv, tot;
-    unsigned int x, y, i, j, k;
-    unsigned short dsp_min, dsp_max;
-    unsigned short elev;
-    struct dsp_bb *dsp_bb;
-    struct dsp_rpp *t;
-    struct dsp_bb_layer *curr, *prev;
-    unsigned short subcell_size;
+    int l;
 
-    /* First we compute the total number of struct dsp_bb's we will need */
-    xs = dsp->xsiz;
-    ys = dsp->ysiz;
-    tot = xs * ys;
-    /*    bu_log("layer %d   %dx%d\n", 0, xs, ys); */
-    dsp->layers = 1;
-    while (xs > 1 || ys > 1) {
-	xv = xs / DIM_BB_CHILDREN;
-	yv = ys / DIM_BB_CHILDREN;
-	if (xs % DIM_BB_CHILDREN) xv++;
-	if (ys % DIM_BB_CHILDREN) yv++;
-
-#ifdef FULL_DSP_DEBUGGING
-	if (RT_G_DEBUG & RT_DEBUG_HF)
-	    bu_log("layer %d   %dx%d\n", dsp->layers, xv, yv);
-#endif
-	tot += xv * yv;
-
-	if (xv > 0) xs = xv;
-	else xs = 1;
-
-	if (yv > 0) ys = yv;
-	else ys = 1;
-	dsp->layers++;
-    }
-
-
-#ifdef FULL_DSP_DEBUGGING
-    if (RT_G_DEBUG & RT_DEBUG_HF)
-	bu_log("%d layers total\n", dsp->layers);
-#endif
+    dsp->layer[0].p = base;
+    for (l = 1; l < dsp->layers; l++)
+	dsp->layer[l].p = &dsp->layer[l-1].p[(size_t)dsp->layer[l-1].dim[X] * dsp->layer[l-1].dim[Y]];
+}
 
-    /* allocate the struct dsp_bb's we will need */
-    dsp->layer = (struct dsp_bb_layer *)bu_malloc(dsp->layers * sizeof(struct dsp_bb_layer),
-			   "dsp_bb_layers array");
-    dsp->bb_array = (struct dsp_bb *)bu_malloc(tot * sizeof(struct dsp_bb), "dsp_bb array");
 
-    /* now we fill in the "lowest" layer of struct dsp_bb's from the
-     * raw data
-     */
-    dsp->layer[0].dim[X] = dsp->xsiz;
-    dsp->layer[0].dim[Y] = dsp->ysiz;
-    dsp->layer[0].p = dsp->bb_array;
+/**
+ * compute the elevation range of each cell, then compute the ranges
+ * for successively coarser blocks of cells.  Suitable for use as a
+ * sidecar_fill_t.
+ */
+static int
+dsp_layers_fill(void *dest, size_t UNUSED(len), const struct bu_mapped_file *UNUSED(src), void *data)
+{
+    struct dsp_specific *dsp = (struct dsp_specific *)data;
+    int curr_layer;
+    unsigned int x, y, i, j;
+    unsigned short elev;
+    struct dsp_zrange *zr;
+    struct dsp_bb_layer *curr, *prev;
 
-    dsp_min = 0xffff;
-    dsp_max = 0;
+    dsp_layers_point(dsp, (struct dsp_zrange *)dest);
 
+    /* fill in the "lowest" layer from the raw data */
     for (y = 0; y < YSIZ(dsp); y++) {
 
 	unsigned short cell_min = 0xffff;
 	unsigned short cell_max = 0;
 
+	zr = &dsp->layer[0].p[(size_t)y * XSIZ(dsp)];
+
 	for (x = 0; x < XSIZ(dsp); x++) {
 
 	    elev = DSP(&dsp->dsp_i, x, y);
@@ -705,131 +681,160 @@ dsp_layers(struct dsp_specific *dsp, unsigned short *d_min, unsigned short *d_ma
 	    V_MIN(cell_min, elev);
 	    V_MAX(cell_max, elev);
 
-	    /* factor the cell min/max into the overall min/max */
-	    V_MIN(dsp_min, cell_min);
-	    V_MAX(dsp_max, cell_max);
-
-	    /* fill in the dsp_rpp cell min/max */
-	    i = y*XSIZ(dsp) + x;
-	    dsp_bb = &dsp->layer[0].p[i];
-	    VSET(dsp_bb->dspb_rpp.dsp_min, x, y, cell_min);
-	    VSET(dsp_bb->dspb_rpp.dsp_max, x+1, y+1, cell_max);
-
-	    dsp_bb->dspb_subcell_size = 0;
-
-	    /* There are no "children" of a layer 0 element */
-	    dsp_bb->dspb_ch_dim[X] = 0;
-	    dsp_bb->dspb_ch_dim[Y] = 0;
-	    for (k = 0; k < NUM_BB_CHILDREN; k++) {
-		dsp_bb->dspb_children[k] =
-		    (struct dsp_bb *)NULL;
-	    }
-	    dsp_bb->magic = MAGIC_dsp_bb;
-
-	    /* XXX should we compute the triangle orientation and
-	     * save it here too?
-	     */
+	    zr[x].zmin = cell_min;
+	    zr[x].zmax = cell_max;
 	}
     }
 
-    *d_min = dsp_min;
-    *d_max = dsp_max;
-
-
     if (RT_G_DEBUG & RT_DEBUG_HF)
 	bu_log("layer 0 filled\n");
 
-    subcell_size = 1;
-
     /* now we compute successive layers from the initial layer */
     for (curr_layer = 1; curr_layer < dsp->layers; curr_layer++) {
-	/* compute the number of cells in each direction for this layer */
-
-	xs = dsp->layer[curr_layer-1].dim[X];
-	if (xs % DIM_BB_CHILDREN)
-	    dsp->layer[curr_layer].dim[X] =
-		xs / DIM_BB_CHILDREN + 1;
-	else
-	    dsp->layer[curr_layer].dim[X] =
-		xs / DIM_BB_CHILDREN;
-
-	ys = dsp->layer[curr_layer-1].dim[Y];
-	if (ys % DIM_BB_CHILDREN)
-	    dsp->layer[curr_layer].dim[Y] =
-		ys / DIM_BB_CHILDREN + 1;
-	else
-	    dsp->layer[curr_layer].dim[Y] =
-		ys / DIM_BB_CHILDREN;
-
-	/* set the start of the array for this layer */
-	dsp->layer[curr_layer].p =
-	    &dsp->layer[curr_layer-1].p[dsp->layer[curr_layer-1].dim[X] * dsp->layer[curr_layer-1].dim[Y] ];
-
 	curr = &dsp->layer[curr_layer];
 	prev = &dsp->layer[curr_layer-1];
 
 	if (RT_G_DEBUG & RT_DEBUG_HF)
-	    bu_log("layer %d  subcell size %d\n", curr_layer, subcell_size);
+	    bu_log("layer %d  subcell size %u\n", curr_layer, prev->cell_size);
 
 	/* walk the grid and fill in the values for this layer */
 	for (y = 0; y < curr->dim[Y]; y++) {
 	    for (x = 0; x < curr->dim[X]; x++) {
-		int n, xp, yp;
 		/* x, y are in the coordinates in the current
 		 * layer.  xp, yp are the coordinates of the
 		 * same area in the previous (lower) layer.
 		 */
-		xp = x * DIM_BB_CHILDREN;
-		yp = y * DIM_BB_CHILDREN;
+		unsigned int xp = x * DIM_BB_CHILDREN;
+		unsigned int yp = y * DIM_BB_CHILDREN;
+
+		zr = &curr->p[(size_t)y * curr->dim[X] + x];
+		zr->zmin = 0xffff;
+		zr->zmax = 0;
+
+		for (j = 0; j < DIM_BB_CHILDREN && (yp+j) < prev->dim[Y]; j++) {
+		    const struct dsp_zrange *t = &prev->p[(size_t)(yp+j) * prev->dim[X] + xp];
+		    for (i = 0; i < DIM_BB_CHILDREN && (xp+i) < prev->dim[X]; i++) {
+			V_MIN(zr->zmin, t[i].zmin);
+			V_MAX(zr->zmax, t[i].zmax);
+		    }
+		}
+	    }
+	}
+    }
 
-		/* initialize the current dsp_bb cell */
-		dsp_bb = &curr->p[y*curr->dim[X]+x];
-		dsp_bb->magic = MAGIC_dsp_bb;
-		n = lrint(pow((double)DIM_BB_CHILDREN, (double)curr_layer));
-		VSET(dsp_bb->dspb_rpp.dsp_min,
-		     x * n, y * n, 0x0ffff);
-		VSET(dsp_bb->dspb_rpp.dsp_max,
-		     x * n, y * n, 0);
+    return 1;
+}
 
-		/* record the dimensions of our children */
-		dsp_bb->dspb_subcell_size = subcell_size;
 
+/**
+ * build the bounding box pyramid for a DSP, and return the overall
+ * elevation range.  For DSPs with data files the pyramid is kept in a
+ * sidecar so that it is only computed once and is shared between
+ * processes.
+ */
+static void
+dsp_layers(struct dsp_specific *dsp, unsigned short *d_min, unsigned short *d_max)
+{
+    int curr_layer;
+    unsigned int xs, ys;
+    size_t tot;
+    struct dsp_bb_layer *top;
 
-		tot = 0;
-		i = 0;
-		for (j = 0; j < DIM_BB_CHILDREN && (yp+j)<prev->dim[Y]; j++) {
-		    for (i = 0; i < DIM_BB_CHILDREN && (xp+i)<prev->dim[X]; i++) {
+    /* First we compute the dimensions of each layer, and the total
+     * number of ranges we will need
+     */
+    xs = dsp->xsiz;
+    ys = dsp->ysiz;
+    tot = (size_t)xs * ys;
+    dsp->layers = 1;
+    while (xs > 1 || ys > 1) {
+	xs = (xs + DIM_BB_CHILDREN - 1) / DIM_BB_CHILDREN;
+	ys = (ys + DIM_BB_CHILDREN - 1) / DIM_BB_CHILDREN;
+	if (!xs) xs = 1;
+	if (!ys) ys = 1;
 
-			idx = (yp+j) * prev->dim[X] + xp+i;
+#ifdef FULL_DSP_DEBUGGING
+	if (RT_G_DEBUG & RT_DEBUG_HF)
+	    bu_log("layer %d   %ux%u\n", dsp->layers, xs, ys);
+#endif
+	tot += (size_t)xs * ys;
+	dsp->layers++;
+    }
 
-			t = &prev->p[ idx ].dspb_rpp;
 
-			VMINMAX(dsp_bb->dspb_rpp.dsp_min,
-				dsp_bb->dspb_rpp.dsp_max, t->dsp_min);
-			VMINMAX(dsp_bb->dspb_rpp.dsp_min,
-				dsp_bb->dspb_rpp.dsp_max, t->dsp_max);
+#ifdef FULL_DSP_DEBUGGING
+    if (RT_G_DEBUG & RT_DEBUG_HF)
+	bu_log("%d layers total\n", dsp->layers);
+#endif
 
-			dsp_bb->dspb_children[tot++] = &prev->p[ idx ];
+    dsp->layer = (struct dsp_bb_layer *)bu_malloc(dsp->layers * sizeof(struct dsp_bb_layer),
+						   "dsp_bb_layers array");
 
-		    }
-		}
+    dsp->layer[0].dim[X] = dsp->xsiz;
+    dsp->layer[0].dim[Y] = dsp->ysiz;
+    dsp->layer[0].cell_size = 1;
+    for (curr_layer = 1; curr_layer < dsp->layers; curr_layer++) {
+	struct dsp_bb_layer *curr = &dsp->layer[curr_layer];
+	struct dsp_bb_layer *prev = &dsp->layer[curr_layer-1];
 
-		dsp_bb->dspb_ch_dim[X] = i;
-		dsp_bb->dspb_ch_dim[Y] = j;
-	    }
-	}
-	subcell_size *= DIM_BB_CHILDREN;
+	curr->dim[X] = (prev->dim[X] + DIM_BB_CHILDREN - 1) / DIM_BB_CHILDREN;
+	curr->dim[Y] = (prev->dim[Y] + DIM_BB_CHILDREN - 1) / DIM_BB_CHILDREN;
+	if (!curr->dim[X]) curr->dim[X] = 1;
+	if (!curr->dim[Y]) curr->dim[Y] = 1;
+	curr->cell_size = prev->cell_size * DIM_BB_CHILDREN;
     }
 
+    /* all of the layers share a single allocation, finest first */
+    dsp->bb_mp = NULL;
+    if ((dsp->dsp_i.dsp_datasrc == RT_DSP_SRC_FILE || dsp->dsp_i.dsp_datasrc == RT_DSP_SRC_V4_FILE)
+	&& dsp->dsp_i.dsp_mp && dsp->dsp_i.dsp_buf)
+    {
+	char kind[64];
+	snprintf(kind, sizeof(kind), "dsp_bb.%ux%u", XCNT(dsp), YCNT(dsp));
+	dsp->bb_mp = sidecar_open(dsp->dsp_i.dsp_mp, kind, tot * sizeof(struct dsp_zrange), dsp_layers_fill, dsp);
+    }
+
+    if (dsp->bb_mp) {
+	dsp->bb_array = (struct dsp_zrange *)dsp->bb_mp->apbuf;
+    } else {
+	dsp->bb_array = (struct dsp_zrange *)bu_malloc(tot * sizeof(struct dsp_zrange), "dsp_bb array");
+	(void)dsp_layers_fill(dsp->bb_array, tot * sizeof(struct dsp_zrange), NULL, dsp);
+    }
+    dsp_layers_point(dsp, dsp->bb_array);
+
+    /* the single element of the top layer spans the whole DSP */
+    top = &dsp->layer[dsp->layers-1];
+    *d_min = top->p[0].zmin;
+    *d_max = top->p[0].zmax;
+
 #ifdef PLOT_LAYERS
     if (RT_G_DEBUG & RT_DEBUG_HF) {
 	plot_layers(dsp);
 	bu_log("_  x:%u y:%u min %d max %d\n",
-	       XCNT(dsp), YCNT(dsp), dsp_min, dsp_max);
+	       XCNT(dsp), YCNT(dsp), *d_min, *d_max);
     }
 #endif
 }
 
+
+/**
+ * release the bounding box layers built by dsp_layers()
+ */
+static void
+dsp_layers_free(struct dsp_specific *dsp)
+{
+    if (dsp->bb_mp)
+	bu_close_mapped_file(dsp->bb_mp);
+    else if (dsp->bb_array)
+	bu_free(dsp->bb_array, "dsp_bb array");
+    if (dsp->layer)
+	bu_free(dsp->layer, "dsp_bb_layers array");
+    dsp->bb_mp = NULL;
+    dsp->bb_array = NULL;
+    dsp->layer = NULL;
+    dsp->layers = 0;
+}
+
 /**
  * Calculate the bounding box for a dsp.
  */
@@ -888,6 +893,7 @@ rt_dsp_bbox(struct rt_db_internal *ip, point_t *min, point_t *max, const struct
 
     /* compute the multi-resolution bounding boxes */
     dsp_layers(&ds, &dsp_min, &dsp_max);
+    dsp_layers_free(&ds);
 
 
     /* record the distance to each of the bounding planes */
@@ -1741,7 +1747,7 @@ check_bbpt_hit_elev(int i,	/* indicates face of cell */
  * 1 Terminate intersection computation
  */
 static int
-isect_ray_cell_top(struct isect_stuff *isect, struct dsp_bb *dsp_bb)
+isect_ray_cell_top(struct isect_stuff *isect, struct dsp_rpp *rpp)
 {
     point_t A, B, C, D, P;
     int x, y;
@@ -1759,7 +1765,6 @@ isect_ray_cell_top(struct isect_stuff *isect, struct dsp_bb *dsp_bb)
 	memset(hits+x, 0, sizeof(struct hit));
 
     dlog("isect_ray_cell_top\n");
-    DSP_BB_CK(dsp_bb);
 
     /* assign the values for the corner points
      *
@@ -1769,17 +1774,17 @@ isect_ray_cell_top(struct isect_stuff *isect, struct dsp_bb *dsp_bb)
      *  |    |
      *  A----B
      */
-    x = dsp_bb->dspb_rpp.dsp_min[X];
-    y = dsp_bb->dspb_rpp.dsp_min[Y];
+    x = rpp->dsp_min[X];
+    y = rpp->dsp_min[Y];
     VSET(A, x, y, DSP(&isect->dsp->dsp_i, x, y));
 
-    x = dsp_bb->dspb_rpp.dsp_max[X];
+    x = rpp->dsp_max[X];
     VSET(B, x, y, DSP(&isect->dsp->dsp_i, x, y));
 
-    y = dsp_bb->dspb_rpp.dsp_max[Y];
+    y = rpp->dsp_max[Y];
     VSET(D, x, y, DSP(&isect->dsp->dsp_i, x, y));
 
-    x = dsp_bb->dspb_rpp.dsp_min[X];
+    x = rpp->dsp_min[X];
     VSET(C, x, y, DSP(&isect->dsp->dsp_i, x, y));
 
 
@@ -1795,7 +1800,7 @@ isect_ray_cell_top(struct isect_stuff *isect, struct dsp_bb *dsp_bb)
 	VMOVE(hits[1].hit_point, p2);
 	hits[1].hit_dist = isect->r.r_max;
 
-	plot_cell_top(isect, dsp_bb, A, B, C, D, hits, 3, 0);
+	plot_cell_top(isect, rpp, A, B, C, D, hits, 3, 0);
     }
 #endif
 
@@ -1809,8 +1814,8 @@ isect_ray_cell_top(struct isect_stuff *isect, struct dsp_bb *dsp_bb)
 	VMOVE(hits[0].hit_point, P);
 	VMOVE(hits[0].hit_normal, dsp_pl[isect->dmin]);
 	/* vpriv */
-	hits[0].hit_vpriv[X] = dsp_bb->dspb_rpp.dsp_min[X];
-	hits[0].hit_vpriv[Y] = dsp_bb->dspb_rpp.dsp_min[Y];
+	hits[0].hit_vpriv[X] = rpp->dsp_min[X];
+	hits[0].hit_vpriv[Y] = rpp->dsp_min[Y];
 	/* private */
 	hits[0].hit_surfno = isect->dmin;
 
@@ -1836,8 +1841,8 @@ isect_ray_cell_top(struct isect_stuff *isect, struct dsp_bb *dsp_bb)
 	VMOVE(hits[3].hit_point, P);
 	VMOVE(hits[3].hit_normal, dsp_pl[isect->dmax]);
 	/* vpriv */
-	hits[3].hit_vpriv[X] = dsp_bb->dspb_rpp.dsp_min[X];
-	hits[3].hit_vpriv[Y] = dsp_bb->dspb_rpp.dsp_min[Y];
+	hits[3].hit_vpriv[X] = rpp->dsp_min[X];
+	hits[3].hit_vpriv[Y] = rpp->dsp_min[Y];
 	/* private */
 	hits[3].hit_surfno = isect->dmax;
 
@@ -1855,14 +1860,14 @@ isect_ray_cell_top(struct isect_stuff *isect, struct dsp_bb *dsp_bb)
     }
 
 
-    (void)permute_cell(A, B, C, D, isect->dsp, &dsp_bb->dspb_rpp);
+    (void)permute_cell(A, B, C, D, isect->dsp, rpp);
 
     if ((cond=isect_ray_triangle(isect, B, D, A, &hits[1], ab_first)) > 0.0) {
 	/* hit triangle */
 
 	/* record cell */
-	hits[1].hit_vpriv[X] = dsp_bb->dspb_rpp.dsp_min[X];
-	hits[1].hit_vpriv[Y] = dsp_bb->dspb_rpp.dsp_min[Y];
+	hits[1].hit_vpriv[X] = rpp->dsp_min[X];
+	hits[1].hit_vpriv[Y] = rpp->dsp_min[Y];
 	hits[1].hit_surfno = ZTOP; /* indicate we hit the top */
 
 	hitcount++;
@@ -1878,8 +1883,8 @@ isect_ray_cell_top(struct isect_stuff *isect, struct dsp_bb *dsp_bb)
 	/* hit triangle */
 
 	/* record cell */
-	hits[2].hit_vpriv[X] = dsp_bb->dspb_rpp.dsp_min[X];
-	hits[2].hit_vpriv[Y] = dsp_bb->dspb_rpp.dsp_min[Y];
+	hits[2].hit_vpriv[X] = rpp->dsp_min[X];
+	hits[2].hit_vpriv[Y] = rpp->dsp_min[Y];
 	hits[2].hit_surfno = ZTOP; /* indicate we hit the top */
 
 	hitcount++;
@@ -1913,7 +1918,7 @@ isect_ray_cell_top(struct isect_stuff *isect, struct dsp_bb *dsp_bb)
     if (RT_G_DEBUG & RT_DEBUG_HF) {
 	bu_log("hitcount: %d flags: 0x%0x\n", hitcount, hitf);
 
-	plot_cell_top(isect, dsp_bb, A, B, C, D, hits, hitf, 1);
+	plot_cell_top(isect, rpp, A, B, C, D, hits, hitf, 1);
 	for (i = 0; i < 4; i++) {
 	    if (hitf & (1<<i)) {
 		fastf_t v = VDOT(isect->r.r_dir, hits[i].hit_normal);
@@ -1956,8 +1961,8 @@ isect_ray_cell_top(struct isect_stuff *isect, struct dsp_bb *dsp_bb)
 		}
 
 		/* int/float conv */
-		VMOVE(bbmin, dsp_bb->dspb_rpp.dsp_min);
-		VMOVE(bbmax, dsp_bb->dspb_rpp.dsp_max);
+		VMOVE(bbmin, rpp->dsp_min);
+		VMOVE(bbmax, rpp->dsp_max);
 
 		/* create seg with hits[i].hit_point as out point */
 		if (add_seg(isect, hitp, &hits[i], bbmin, bbmax, 255, 255, 255))
@@ -1993,7 +1998,7 @@ isect_ray_cell_top(struct isect_stuff *isect, struct dsp_bb *dsp_bb)
 	hits[1].hit_dist = isect->r.r_max;
 
 	if (RT_G_DEBUG & RT_DEBUG_HF)
-	    plot_cell_top(isect, dsp_bb, A, B, C, D, hits, 3, 0);
+	    plot_cell_top(isect, rpp, A, B, C, D, hits, 3, 0);
     }
     return 0;
 }
@@ -2143,40 +2148,54 @@ dsp_in_rpp(struct isect_stuff *isect,
 
 #ifdef ORDERED_ISECT
 static int
-isect_ray_dsp_bb(struct isect_stuff *isect, struct dsp_bb *dsp_bb);
+isect_ray_dsp_bb(struct isect_stuff *isect, int layer, unsigned int bx, unsigned int by);
 
 
 /**
+ * Walk the children of element (bx, by) of a bounding box layer in
+ * the order the ray passes through them.  Children whose highest
+ * point lies below the ray over the whole of the ray's span across
+ * them are skipped without being intersected.
+ *
  * Return
  * 0 continue intersection calculations
  * 1 Terminate intersection computation
  */
 static int
 recurse_dsp_bb(struct isect_stuff *isect,
-	       struct dsp_bb *dsp_bb,
-	       point_t minpt, /* entry point of dsp_bb */
-	       point_t UNUSED(maxpt), /* exit point of dsp_bb */
-	       point_t bbmin, /* min point of bb (Z=0) */
-	       point_t UNUSED(bbmax)) /* max point of bb */
+	       int layer,
+	       unsigned int bx,
+	       unsigned int by,
+	       point_t minpt, /* entry point of the box */
+	       point_t bbmin) /* min point of box (Z=0) */
 {
     fastf_t tDX;		/* dist along ray to span 1 cell in X dir */
     fastf_t tDY;		/* dist along ray to span 1 cell in Y dir */
     fastf_t tX, tY;	/* dist from hit pt. to next cell boundary */
-    fastf_t curr_dist;
-    short cX, cY;	/* coordinates of current cell */
-    short cs;		/* cell X, Y dimension */
-    short stepX, stepY;	/* dist to step in child array for each dir */
-    short stepPX, stepPY;
-    fastf_t out_dist;
-    struct dsp_bb **p;
+    fastf_t curr_dist, next_dist;
+    fastf_t z_in, z_out;
+    int cX, cY;		/* coordinates of current cell */
+    int cs;		/* cell X, Y dimension */
+    int stepX, stepY;	/* dist to step in child array for each dir */
+    int ch_dim[2];	/* number of children in each dir */
+    unsigned int xp, yp;	/* first child in the child layer */
+    fastf_t out_dist, ray_max;
+    const struct dsp_bb_layer *ch = &isect->dsp->layer[layer-1];
+    const struct dsp_zrange *zr;
     fastf_t *stom = &isect->dsp->dsp_i.dsp_stom[0];
     point_t pt, v;
     int loop = 0;
 
-    DSP_BB_CK(dsp_bb);
+    /* locate our children in the next lower layer */
+    xp = bx * DIM_BB_CHILDREN;
+    yp = by * DIM_BB_CHILDREN;
+    ch_dim[X] = ch->dim[X] - xp;
+    ch_dim[Y] = ch->dim[Y] - yp;
+    if (ch_dim[X] > DIM_BB_CHILDREN) ch_dim[X] = DIM_BB_CHILDREN;
+    if (ch_dim[Y] > DIM_BB_CHILDREN) ch_dim[Y] = DIM_BB_CHILDREN;
 
     /* compute the size of a cell in each direction */
-    cs = dsp_bb->dspb_subcell_size;
+    cs = ch->cell_size;
 
     /* compute current cell */
     cX = (minpt[X] - bbmin[X]) / cs;
@@ -2185,20 +2204,21 @@ recurse_dsp_bb(struct isect_stuff *isect,
     /* a little bounds checking because a hit on XMAX or YMAX looks
      * like it should be in the next cell outside the box
      */
-    if (cX >= dsp_bb->dspb_ch_dim[X]) cX = dsp_bb->dspb_ch_dim[X] - 1;
-    if (cY >= dsp_bb->dspb_ch_dim[Y]) cY = dsp_bb->dspb_ch_dim[Y] - 1;
+    if (cX >= ch_dim[X]) cX = ch_dim[X] - 1;
+    if (cY >= ch_dim[Y]) cY = ch_dim[Y] - 1;
+    if (cX < 0) cX = 0;
+    if (cY < 0) cY = 0;
 
 #ifdef FULL_DSP_DEBUGGING
     dlog("recurse_dsp_bb  cell size: %d  current cell: %d %d\n",
 	 cs, cX, cY);
-    dlog("dspb_ch_dim x:%d  y:%d\n",
-	 dsp_bb->dspb_ch_dim[X], dsp_bb->dspb_ch_dim[Y]);
+    dlog("ch_dim x:%d  y:%d\n", ch_dim[X], ch_dim[Y]);
 #endif
 
     tX = tY = curr_dist = isect->r.r_min;
 
     if (isect->r.r_dir[X] < 0.0) {
-	stepPX = stepX = -1;
+	stepX = -1;
 	/* tDX is the distance along the ray we have to travel to
 	 * traverse a cell (travel a unit distance) along the X axis
 	 * of the grid
@@ -2210,7 +2230,7 @@ recurse_dsp_bb(struct isect_stuff *isect,
 	 */
 	tX += ((bbmin[X] + (cX * cs)) - minpt[X]) / isect->r.r_dir[X];
     } else {
-	stepPX = stepX = 1;
+	stepX = 1;
 	tDX = cs / isect->r.r_dir[X];
 
 	if (isect->r.r_dir[X] > 0.0)
@@ -2220,15 +2240,11 @@ recurse_dsp_bb(struct isect_stuff *isect,
     }
 
     if (isect->r.r_dir[Y] < 0) {
-	/* distance in dspb_children we have to move to step in Y dir
-	 */
 	stepY = -1;
-	stepPY = -dsp_bb->dspb_ch_dim[X];
 	tDY = -cs / isect->r.r_dir[Y];
 	tY += ((bbmin[Y] + (cY * cs)) - minpt[Y]) / isect->r.r_dir[Y];
     } else {
 	stepY = 1;
-	stepPY = dsp_bb->dspb_ch_dim[X];
 	tDY = cs / isect->r.r_dir[Y];
 
 	if (isect->r.r_dir[Y] > 0.0)
@@ -2237,58 +2253,64 @@ recurse_dsp_bb(struct isect_stuff *isect,
 	    tY = MAX_FASTF;
     }
 
+    /* the children overwrite isect->r.r_max, so keep our own copy */
+    ray_max = isect->r.r_max;
+
     /* factor in the tolerance to the out-distance */
-    out_dist = isect->r.r_max - isect->tol->dist;
+    out_dist = ray_max - isect->tol->dist;
 
-    p = &dsp_bb->dspb_children[dsp_bb->dspb_ch_dim[X] * cY + cX];
 #ifdef FULL_DSP_DEBUGGING
     dlog("tX:%g tY:%g\n", tX, tY);
-
 #endif
 
     do {
-	/* intersect with the current cell */
-	if (RT_G_DEBUG & RT_DEBUG_HF) {
-	    if (loop)
-		bu_log("\nisect sub-cell %d %d  curr_dist:%g out_dist: %g",
-		       cX, cY, curr_dist, out_dist);
-	    else {
-		bu_log("isect sub-cell %d %d  curr_dist:%g out_dist %g",
-		       cX, cY, curr_dist, out_dist);
-		loop = 1;
+	/* skip children the ray passes entirely above */
+	next_dist = (tX < tY) ? tX : tY;
+	if (next_dist > ray_max)
+	    next_dist = ray_max;
+	z_in = isect->r.r_pt[Z] + curr_dist * isect->r.r_dir[Z];
+	z_out = isect->r.r_pt[Z] + next_dist * isect->r.r_dir[Z];
+	zr = &ch->p[(size_t)(yp + cY) * ch->dim[X] + xp + cX];
+
+	if (z_in > zr->zmax && z_out > zr->zmax) {
+#ifdef FULL_DSP_DEBUGGING
+	    dlog("skipping sub-cell %d %d, ray above %d\n", cX, cY, zr->zmax);
+#endif
+	} else {
+	    /* intersect with the current cell */
+	    if (RT_G_DEBUG & RT_DEBUG_HF) {
+		if (loop)
+		    bu_log("\nisect sub-cell %d %d  curr_dist:%g out_dist: %g",
+			   cX, cY, curr_dist, out_dist);
+		else {
+		    bu_log("isect sub-cell %d %d  curr_dist:%g out_dist %g",
+			   cX, cY, curr_dist, out_dist);
+		    loop = 1;
+		}
+		VJOIN1(pt, isect->r.r_pt, curr_dist, isect->r.r_dir);
+		MAT4X3PNT(v, stom, pt);
+		bu_log("pt %g %g %g\n", V3ARGS(v));
 	    }
-	    VJOIN1(pt, isect->r.r_pt, curr_dist, isect->r.r_dir);
-	    MAT4X3PNT(v, stom, pt);
-	    bu_log("pt %g %g %g\n", V3ARGS(v));
-	}
 
-	/* get pointer to the current child cell.  Note the extra
-	 * level of indirection.  We want to march p through
-	 * dspb_children using pointer addition, but dspb_children
-	 * contains pointers.  We need to be sure to increment the
-	 * offset in the array, not the child pointer.
-	 */
-
-	if (RT_G_DEBUG & RT_DEBUG_HF)
-	    bu_log_indent_delta(4);
+	    if (RT_G_DEBUG & RT_DEBUG_HF)
+		bu_log_indent_delta(4);
 
-	if (isect_ray_dsp_bb(isect, *p)) return 1;
+	    if (isect_ray_dsp_bb(isect, layer-1, xp + cX, yp + cY)) return 1;
 
-	if (RT_G_DEBUG & RT_DEBUG_HF)
-	    bu_log_indent_delta(-4);
+	    if (RT_G_DEBUG & RT_DEBUG_HF)
+		bu_log_indent_delta(-4);
+	}
 
 	/* figure out which cell is next */
 	if (tX < tY) {
-	    cX += stepX;  /* track cell offset for debugging */
-	    p += stepPX;
+	    cX += stepX;
 #ifdef FULL_DSP_DEBUGGING
 	    dlog("stepping X to %d because %g < %g\n", cX, tX, tY);
 #endif
 	    curr_dist = tX;
 	    tX += tDX;
 	} else {
-	    cY += stepY;  /* track cell offset for debugging */
-	    p += stepPY;
+	    cY += stepY;
 #ifdef FULL_DSP_DEBUGGING
 	    dlog("stepping Y to %d because %g >= %g\n", cY, tX, tY);
 #endif
@@ -2299,8 +2321,8 @@ recurse_dsp_bb(struct isect_stuff *isect,
 	dlog("curr_dist %g, out_dist %g\n", curr_dist, out_dist);
 #endif
     } while (curr_dist < out_dist &&
-	     cX < dsp_bb->dspb_ch_dim[X] && cX >= 0 &&
-	     cY < dsp_bb->dspb_ch_dim[Y] && cY >= 0);
+	     cX < ch_dim[X] && cX >= 0 &&
+	     cY < ch_dim[Y] && cY >= 0);
 
     return 0;
 }
@@ -2309,16 +2331,17 @@ recurse_dsp_bb(struct isect_stuff *isect,
 #endif
 
 /**
- * Intersect a ray with a DSP bounding box.  This is the primary child
- * of rt_dsp_shot()
+ * Intersect a ray with element (bx, by) of a DSP bounding box layer.
+ * This is the primary child of rt_dsp_shot()
  *
  * Return
  * 0 continue intersection calculations
  * 1 Terminate intersection computation
  */
 static int
-isect_ray_dsp_bb(struct isect_stuff *isect, struct dsp_bb *dsp_bb)
+isect_ray_dsp_bb(struct isect_stuff *isect, int layer, unsigned int bx, unsigned int by)
 {
+    struct dsp_rpp dsp_rpp;
     point_t bbmin, bbmax;
     point_t minpt, maxpt;
     fastf_t min_z;
@@ -2329,25 +2352,19 @@ isect_ray_dsp_bb(struct isect_stuff *isect, struct dsp_bb *dsp_bb)
     point_t pt;
     struct xray *r = &isect->r; /* Does this buy us anything? */
 
-    if (dsp_bb) {
-	DSP_BB_CK(dsp_bb);
-    } else {
-	bu_log("%s:%d null ptr pixel %d %d\n",
-	       __FILE__, __LINE__, isect->ap->a_x,  isect->ap->a_y);
-	bu_bomb("");
-    }
+    dsp_layer_rpp(isect->dsp, layer, bx, by, &dsp_rpp);
 
     if (RT_G_DEBUG & RT_DEBUG_HF) {
 	bu_log("\nisect_ray_dsp_bb((%d, %d, %d) (%d, %d, %d))\n",
-	       V3ARGS(dsp_bb->dspb_rpp.dsp_min),
-	       V3ARGS(dsp_bb->dspb_rpp.dsp_max));
+	       V3ARGS(dsp_rpp.dsp_min),
+	       V3ARGS(dsp_rpp.dsp_max));
     }
 
     /* check to see if we miss the RPP for this area entirely */
-    VMOVE(bbmax, dsp_bb->dspb_rpp.dsp_max);
+    VMOVE(bbmax, dsp_rpp.dsp_max);
     VSET(bbmin,
-	 dsp_bb->dspb_rpp.dsp_min[X],
-	 dsp_bb->dspb_rpp.dsp_min[Y], 0.0);
+	 dsp_rpp.dsp_min[X],
+	 dsp_rpp.dsp_min[Y], 0.0);
 
 
     if (! dsp_in_rpp(isect, bbmin, bbmax)) {
@@ -2355,7 +2372,7 @@ isect_ray_dsp_bb(struct isect_stuff *isect, struct dsp_bb *dsp_bb)
 
 	if (RT_G_DEBUG & RT_DEBUG_HF) {
 	    bu_log("missed... ");
-	    fclose(draw_dsp_bb(&plotnum, dsp_bb, isect->dsp, 0, 150, 0));
+	    fclose(draw_dsp_bb(&plotnum, &dsp_rpp, isect->dsp, 0, 150, 0));
 	}
 
 	return 0;
@@ -2376,7 +2393,7 @@ isect_ray_dsp_bb(struct isect_stuff *isect, struct dsp_bb *dsp_bb)
 	stom = &isect->dsp->dsp_i.dsp_stom[0];
 
 	bu_log("hit b-box ");
-	fp = draw_dsp_bb(&plotnum, dsp_bb, isect->dsp, 200, 200, 100);
+	fp = draw_dsp_bb(&plotnum, &dsp_rpp, isect->dsp, 200, 200, 100);
 
 	pl_color(fp, 150, 150, 255);
 	MAT4X3PNT(pt, stom, minpt);
@@ -2391,7 +2408,7 @@ isect_ray_dsp_bb(struct isect_stuff *isect, struct dsp_bb *dsp_bb)
     /* if both hits are UNDER the top of the "foundation" pillar, we
      * can just add a segment for that range and return
      */
-    min_z = dsp_bb->dspb_rpp.dsp_min[Z];
+    min_z = dsp_rpp.dsp_min[Z];
 
     if (minpt[Z] < min_z && maxpt[Z] < min_z) {
 	/* add hit segment */
@@ -2423,8 +2440,8 @@ isect_ray_dsp_bb(struct isect_stuff *isect, struct dsp_bb *dsp_bb)
 	     * VMOVE(seg_out.hit_point, maxpt);
 	     */
 	    /* create a special bounding box for plotting purposes */
-	    VMOVE(bbmax,  dsp_bb->dspb_rpp.dsp_max);
-	    VMOVE(bbmin,  dsp_bb->dspb_rpp.dsp_min);
+	    VMOVE(bbmax,  dsp_rpp.dsp_max);
+	    VMOVE(bbmin,  dsp_rpp.dsp_min);
 	    bbmax[Z] = bbmin[Z];
 	    bbmin[Z] = 0.0;
 	}
@@ -2437,18 +2454,19 @@ isect_ray_dsp_bb(struct isect_stuff *isect, struct dsp_bb *dsp_bb)
     /* We've hit something where we might be going through the
      * boundary.  We've got to intersect the children
      */
-    if (dsp_bb->dspb_ch_dim[0]) {
+    if (layer > 0) {
 #ifdef ORDERED_ISECT
-	return recurse_dsp_bb(isect, dsp_bb, minpt, maxpt, bbmin, bbmax);
+	return recurse_dsp_bb(isect, layer, bx, by, minpt, bbmin);
 #else
-	int i;
+	const struct dsp_bb_layer *ch = &isect->dsp->layer[layer-1];
+	unsigned int i, j;
 	/* there are children, so we recurse */
-	i = dsp_bb->dspb_ch_dim[X] * dsp_bb->dspb_ch_dim[Y] - 1;
 	if (RT_G_DEBUG & RT_DEBUG_HF)
 	    bu_log_indent_delta(4);
 
-	for (; i >= 0; i--)
-	    isect_ray_dsp_bb(isect, dsp_bb->dspb_children[i]);
+	for (j = by * DIM_BB_CHILDREN; j < (by+1) * DIM_BB_CHILDREN && j < ch->dim[Y]; j++)
+	    for (i = bx * DIM_BB_CHILDREN; i < (bx+1) * DIM_BB_CHILDREN && i < ch->dim[X]; i++)
+		isect_ray_dsp_bb(isect, layer-1, i, j);
 
 	if (RT_G_DEBUG & RT_DEBUG_HF)
 	    bu_log_indent_delta(-4);
@@ -2474,11 +2492,11 @@ isect_ray_dsp_bb(struct isect_stuff *isect, struct dsp_bb *dsp_bb)
      * just pass through the "foundation " pillar underneath (see test
      * above)
      */
-    bbmin[Z] = dsp_bb->dspb_rpp.dsp_min[Z];
+    bbmin[Z] = dsp_rpp.dsp_min[Z];
     if (dsp_in_rpp(isect, bbmin, bbmax)) {
 	/* hit rpp */
 
-	isect_ray_cell_top(isect, dsp_bb);
+	isect_ray_cell_top(isect, &dsp_rpp);
     }
 
 
@@ -2486,7 +2504,7 @@ isect_ray_dsp_bb(struct isect_stuff *isect, struct dsp_bb *dsp_bb)
      * ray may have entered through the top of the pillar, possibly
      * after having come down through the triangles above
      */
-    bbmax[Z] = dsp_bb->dspb_rpp.dsp_min[Z];
+    bbmax[Z] = dsp_rpp.dsp_min[Z];
     bbmin[Z] = 0.0;
     if (dsp_in_rpp(isect, bbmin, bbmax)) {
 	/* hit rpp */
@@ -2583,8 +2601,8 @@ rt_dsp_shot(struct soltab *stp, register struct xray *rp, struct application *ap
 	       V3ARGS(isect.r.r_dir));
     }
 
-    /* We look at the topmost layer of the bounding-box tree and make
-     * sure that it has dimension 1.  Otherwise, something is wrong
+    /* We look at the topmost layer of the bounding-box pyramid and
+     * make sure that it has dimension 1.  Otherwise, something is wrong
      */
     if (isect.dsp->layer[isect.dsp->layers-1].dim[X] != 1 ||
 	isect.dsp->layer[isect.dsp->layers-1].dim[Y] != 1) {
@@ -2595,7 +2613,7 @@ rt_dsp_shot(struct soltab *stp, register struct xray *rp, struct application *ap
 
 
     /* intersect the ray with the bounding rpps */
-    (void)isect_ray_dsp_bb(&isect, isect.dsp->layer[isect.dsp->layers-1].p);
+    (void)isect_ray_dsp_bb(&isect, isect.dsp->layers-1, 0, 0);
 
     /* if we missed it all, give up now */
     if (BU_LIST_IS_EMPTY(&isect.seglist))
@@ -3079,8 +3097,10 @@ rt_dsp_free(register struct soltab *stp)
     switch (dsp->dsp_i.dsp_datasrc) {
 	case RT_DSP_SRC_V4_FILE:
 	case RT_DSP_SRC_FILE:
-	    bu_close_mapped_file(dsp->dsp_i.dsp_mp);
-	    if (dsp->dsp_i.dsp_buf) {
+	    /* the converted data, if any, belongs to the file */
+	    if (dsp->dsp_i.dsp_mp) {
+		sidecar_close(dsp->dsp_i.dsp_mp);
+	    } else if (dsp->dsp_i.dsp_buf) {
 		bu_free(dsp->dsp_i.dsp_buf, "dsp fake data");
 	    }
 	    break;
@@ -3088,6 +3108,8 @@ rt_dsp_free(register struct soltab *stp)
 	    break;
     }
 
+    dsp_layers_free(dsp);
+
     BU_PUT(dsp, struct dsp_specific);
 }
 
@@ -3958,6 +3980,26 @@ rt_dsp_tess(struct nmgregion **r, struct model *m, struct rt_db_internal *ip, co
 }
 
 
+/**
+ * Convert network order DSP elevations in src to host order.
+ * Suitable for use as a sidecar_fill_t.
+ */
+static int
+dsp_swap_fill(void *dest, size_t len, const struct bu_mapped_file *src, void *UNUSED(data))
+{
+    size_t count = len / sizeof(unsigned short);
+    size_t got;
+
+    got = bu_cv_w_cookie(dest, bu_cv_cookie("hus"), len,
+			 src->buf, bu_cv_cookie("nus"), count);
+    if (got != count) {
+	bu_log("got %zu != count %zu", got, count);
+	bu_bomb("\n");
+    }
+    return 1;
+}
+
+
 /**
  * Retrieve data for DSP from external file.
  * Returns:
@@ -3995,25 +4037,23 @@ get_file_data(struct rt_dsp_internal *dsp_ip, const struct db_i *dbip)
 	return -1;
     }
 
+    /* another instance may have already converted this file */
+    if (mf->apbuf) {
+	dsp_ip->dsp_buf = (short unsigned int *)mf->apbuf;
+	return 0;
+    }
+
     in_cookie = bu_cv_cookie("nus"); /* data is network unsigned short */
     out_cookie = bu_cv_cookie("hus");
 
     if (bu_cv_optimize(in_cookie) != bu_cv_optimize(out_cookie)) {
-	size_t got;
 	/* if we're on a little-endian machine we convert the input
-	 * file from network to host format
+	 * file from network to host format.  Converted data is kept in
+	 * a sidecar where possible so that other processes can share
+	 * it.
 	 */
 	count = dsp_ip->dsp_xcnt * dsp_ip->dsp_ycnt;
-	mf->apbuflen = count * sizeof(unsigned short);
-	mf->apbuf = bu_malloc(mf->apbuflen, "apbuf");
-
-	got = bu_cv_w_cookie(mf->apbuf, out_cookie, mf->apbuflen,
-			     mf->buf,    in_cookie, count);
-	if (got != (size_t)count) {
-	    bu_log("got %zu != count %d", got, count);
-	    bu_bomb("\n");
-	}
-	dsp_ip->dsp_buf = (short unsigned int *)dsp_ip->dsp_mp->apbuf;
+	dsp_ip->dsp_buf = (short unsigned int *)sidecar_apbuf(mf, "dsp.hus", count * sizeof(unsigned short), dsp_swap_fill, NULL);
     } else {
 	dsp_ip->dsp_buf = (short unsigned int *)dsp_ip->dsp_mp->buf;
     }
@@ -4558,7 +4598,7 @@ rt_dsp_ifree(struct rt_db_internal *ip)
     dsp_ip = (struct rt_dsp_internal *)ip->idb_ptr;
     RT_DSP_CK_MAGIC(dsp_ip);
 
-    bu_close_mapped_file(dsp_ip->dsp_mp);
+    sidecar_close(dsp_ip->dsp_mp);
 
     if (dsp_ip->dsp_bip) {
 	dsp_ip->dsp_bip->idb_meth->ft_ifree((struct rt_db_internal *) dsp_ip->dsp_bip);
@@ -44,6 +44,7 @@
 #include "raytrace.h"
 #include "../fixpt.h"
 #include "../../librt_private.h"
+#include "../../sidecar.h"
 
 
 struct rt_ebm_specific {
@@ -587,6 +588,49 @@ rt_ebm_dda(register struct xray *rp, struct soltab *stp, struct application *ap,
 }
 
 
+/**
+ * Copy the bitmap in src into the zero padded layout used by bit().
+ * Suitable for use as a sidecar_fill_t.
+ */
+static int
+ebm_bitmap_fill(void *dest, size_t len, const struct bu_mapped_file *src, void *data)
+{
+    struct rt_ebm_internal *eip = (struct rt_ebm_internal *)data;
+    const unsigned char *cp = (const unsigned char *)src->buf;
+    unsigned char *dp = (unsigned char *)dest;
+    size_t row = eip->xdim + BIT_XWIDEN*2;
+    size_t y;
+
+    memset(dest, 0, len);
+
+    /* Because of in-memory padding, copy each scanline separately */
+    for (y = 0; y < eip->ydim; y++) {
+	memcpy(&dp[(y+BIT_YWIDEN)*row + BIT_XWIDEN], cp, eip->xdim);
+	cp += eip->xdim;
+    }
+    return 1;
+}
+
+
+/**
+ * If this is the first use of a file, prepare the padded bitmap in
+ * mp->apbuf.  The bitmap is kept in a sidecar where possible, so that
+ * other processes using the same file share it.
+ */
+static void
+ebm_prep_bitmap(struct rt_ebm_internal *eip, struct bu_mapped_file *mp)
+{
+    size_t nbytes = (eip->xdim+BIT_XWIDEN*2)*(eip->ydim+BIT_YWIDEN*2);
+    char kind[64];
+
+    if (mp->apbuf)
+	return;
+
+    snprintf(kind, sizeof(kind), "ebm.%ux%u", eip->xdim, eip->ydim);
+    (void)sidecar_apbuf(mp, kind, nbytes, ebm_bitmap_fill, eip);
+}
+
+
 /**
  * Retrieve data for EBM from external file.
  * Returns:
@@ -597,7 +641,6 @@ static int
 get_file_data(struct rt_ebm_internal *eip, const struct db_i *dbip)
 {
     struct bu_mapped_file *mp;
-    int nbytes;
 
     /* get file */
     mp = bu_open_mapped_file_with_path(dbip->dbi_filepath, eip->name, "ebm");
@@ -613,32 +656,7 @@ get_file_data(struct rt_ebm_internal *eip, const struct db_i *dbip)
 	return -1;
     }
 
-    nbytes = (eip->xdim+BIT_XWIDEN*2)*(eip->ydim+BIT_YWIDEN*2);
-
-    /* If first use of this file, prepare in-memory buffer */
-    if (!mp->apbuf) {
-	size_t y;
-	unsigned char* cp;
-
-	/* Prevent a multi-processor race */
-	bu_semaphore_acquire(RT_SEM_MODEL);
-	if (mp->apbuf) {
-	    /* someone else beat us, nothing more to do */
-	    bu_semaphore_release(RT_SEM_MODEL);
-	    return 0;
-	}
-	mp->apbuf = (uint8_t *)bu_calloc(1, nbytes, "rt_ebm_import4 bitmap");
-	mp->apbuflen = nbytes;
-	bu_semaphore_release(RT_SEM_MODEL);
-
-	/* Because of in-memory padding, read each scanline separately */
-	cp = (unsigned char*)mp->buf;
-	for (y = 0; y < eip->ydim; y++) {
-	    /* bit() addresses into mp->apbuf */
-	    memcpy(bit(eip, 0, y), cp, eip->xdim);
-	    cp += eip->xdim;
-	}
-    }
+    ebm_prep_bitmap(eip, mp);
     return 0;
 }
 
@@ -801,7 +819,6 @@ rt_ebm_import4(struct rt_db_internal *ip, const struct bu_external *ep, const fa
     union record *rp;
     register struct rt_ebm_internal *eip;
     struct bu_vls str = BU_VLS_INIT_ZERO;
-    int nbytes;
     mat_t tmat;
     struct bu_mapped_file *mp;
 
@@ -867,33 +884,7 @@ rt_ebm_import4(struct rt_db_internal *ip, const struct bu_external *ep, const fa
 	goto fail;
     }
 
-    nbytes = (eip->xdim+BIT_XWIDEN*2)*(eip->ydim+BIT_YWIDEN*2);
-
-    /* If first use of this file, prepare in-memory buffer */
-    if (!mp->apbuf) {
-	size_t y;
-	unsigned char *cp;
-
-	/* Prevent a multi-processor race */
-	bu_semaphore_acquire(RT_SEM_MODEL);
-	if (mp->apbuf) {
-	    /* someone else beat us, nothing more to do */
-	    bu_semaphore_release(RT_SEM_MODEL);
-	    return 0;
-	}
-	mp->apbuf = (unsigned char *)bu_calloc(1, nbytes, "rt_ebm_import4 bitmap");
-	mp->apbuflen = nbytes;
-
-	bu_semaphore_release(RT_SEM_MODEL);
-
-	/* Because of in-memory padding, read each scanline separately */
-	cp = (unsigned char *)mp->buf;
-	for (y = 0; y < eip->ydim; y++) {
-	    /* bit() addresses into mp->apbuf */
-	    memcpy(bit(eip, 0, y), cp, eip->xdim);
-	    cp += eip->xdim;
-	}
-    }
+    ebm_prep_bitmap(eip, mp);
     return 0;
 }
 
@@ -1104,7 +1095,7 @@ rt_ebm_ifree(struct rt_db_internal *ip)
     eip = (struct rt_ebm_internal *)ip->idb_ptr;
     RT_EBM_CK_MAGIC(eip);
 
-    bu_close_mapped_file(eip->mp);
+    sidecar_close(eip->mp);
 
     eip->magic = 0;			/* sanity */
     eip->mp = (struct bu_mapped_file *)0;
@@ -1329,7 +1320,7 @@ rt_ebm_free(struct soltab *stp)
     register struct rt_ebm_specific *ebmp =
 	(struct rt_ebm_specific *)stp->st_specific;
 
-    bu_close_mapped_file(ebmp->ebm_i.mp);
+    sidecar_close(ebmp->ebm_i.mp);
 
     BU_PUT(ebmp, struct rt_ebm_specific);
 }
@@ -873,7 +873,7 @@ rt_ehy_adaptive_plot(struct bu_list *vhead, struct rt_db_internal *ip, const str
     int i, num_curve_points, num_ellipse_points, num_curves;
     struct rt_ehy_internal *ehy;
     struct rt_pnt_node *pts_r1, *pts_r2, *node, *node1, *node2;
-    struct bu_list *vlfree = &rt_vlfree;
+    struct bu_list *vlfree = rt_vlfree_get();
 
     fastf_t point_spacing = solid_point_spacing(v, s_size);
 
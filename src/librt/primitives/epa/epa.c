@@ -837,7 +837,7 @@ rt_epa_adaptive_plot(struct bu_list *vhead, struct rt_db_internal *ip, const str
     BU_CK_LIST_HEAD(vhead);
     RT_CK_DB_INTERNAL(ip);
 
-    struct bu_list *vlfree = &rt_vlfree;
+    struct bu_list *vlfree = rt_vlfree_get();
     epa = (struct rt_epa_internal *)ip->idb_ptr;
     if (!epa_is_valid(epa)) {
 	return -2;
@@ -58,6 +58,7 @@
 #include "nmg.h"
 #include "rt/geom.h"
 #include "raytrace.h"
+#include "../../sidecar.h"
 
 
 #define HF_O(m) bu_offsetof(struct rt_hf_internal, m)
@@ -1633,7 +1634,7 @@ rt_hf_free(struct soltab *stp)
     struct hf_specific *hf =
 	(struct hf_specific *)stp->st_specific;
 
-    bu_close_mapped_file(hf->hf_mp);
+    sidecar_close(hf->hf_mp);
     hf->hf_mp = (struct bu_mapped_file *)0;
 
     BU_PUT(hf, struct hf_specific);
@@ -1910,6 +1911,36 @@ rt_hf_tess(struct nmgregion **r, struct model *m, struct rt_db_internal *ip, con
 }
 
 
+struct hf_cv {
+    int in_cookie;
+    int out_cookie;
+    size_t count;
+    const char *name;
+};
+
+
+/**
+ * Convert HF data from its file format to the internal one.
+ * Suitable for use as a sidecar_fill_t.
+ */
+static int
+hf_cv_fill(void *dest, size_t len, const struct bu_mapped_file *src, void *data)
+{
+    struct hf_cv *cv = (struct hf_cv *)data;
+    size_t got;
+
+    got = bu_cv_w_cookie(dest, cv->out_cookie, len,
+			 src->buf, cv->in_cookie, cv->count);
+    if (got != cv->count) {
+	bu_log("rt_hf_import4(%s) bu_cv_w_cookie count=%zu, got=%zu\n",
+	       cv->name, cv->count, got);
+	/* a short conversion must not be shared */
+	return 0;
+    }
+    return 1;
+}
+
+
 /**
  * Import an HF from the database format to the internal format.
  * Apply modeling transformations as well.
@@ -1926,7 +1957,9 @@ rt_hf_import4(struct rt_db_internal *ip, const struct bu_external *ep, const fas
     int in_len;
     int out_cookie;
     size_t count;
-    size_t got;
+    struct hf_cv cv;
+    size_t len;
+    char kind[64];
 
     if (dbip) RT_CK_DBI(dbip);
 
@@ -2048,25 +2081,32 @@ rt_hf_import4(struct rt_db_internal *ip, const struct bu_external *ep, const fas
 
     /* Transform external data to internal format -- short or double */
     if (xip->shorts) {
-	mp->apbuflen = sizeof(unsigned short) * count;
+	len = sizeof(unsigned short) * count;
 	out_cookie = bu_cv_cookie("hus");
     } else {
-	mp->apbuflen = sizeof(double) * count;
+	len = sizeof(double) * count;
 	out_cookie = bu_cv_cookie("hd");
     }
 
     if (bu_cv_optimize(in_cookie) == bu_cv_optimize(out_cookie)) {
 	/* Don't replicate the data, just reuse the pointer */
+	mp->apbuflen = len;
 	mp->apbuf = mp->buf;
 	return 0;		/* OK */
     }
 
-    mp->apbuf = (void *)bu_malloc(mp->apbuflen, "rt_hf_import4 apbuf[]");
-    got = bu_cv_w_cookie(mp->apbuf, out_cookie, mp->apbuflen,
-			 mp->buf, in_cookie, count);
-    if (got != count) {
-	bu_log("rt_hf_import4(%s) bu_cv_w_cookie count=%zu, got=%zu\n",
-	       xip->dfile, count, got);
+    /* Share converted data with other processes through a sidecar
+     * where possible.
+     */
+    cv.in_cookie = in_cookie;
+    cv.out_cookie = out_cookie;
+    cv.count = count;
+    cv.name = xip->dfile;
+    snprintf(kind, sizeof(kind), "hf.%s.%s", xip->fmt, (xip->shorts) ? "hus" : "hd");
+    if (!sidecar_apbuf(mp, kind, len, hf_cv_fill, &cv)) {
+	sidecar_close(mp);
+	xip->mp = NULL;
+	goto err1;
     }
 
     return 0;			/* OK */
@@ -2195,7 +2235,7 @@ rt_hf_ifree(struct rt_db_internal *ip)
     RT_HF_CK_MAGIC(xip);
     xip->magic = 0;			/* sanity */
 
-    bu_close_mapped_file(xip->mp);
+    sidecar_close(xip->mp);
 
     bu_free((char *)xip, "hf ifree");
     ip->idb_ptr = ((void *)0);	/* sanity */
@@ -958,7 +958,7 @@ rt_rhc_adaptive_plot(struct bu_list *vhead, struct rt_db_internal *ip, const str
     BU_CK_LIST_HEAD(vhead);
     RT_CK_DB_INTERNAL(ip);
 
-    struct bu_list *vlfree = &rt_vlfree;
+    struct bu_list *vlfree = rt_vlfree_get();
     rhc = (struct rt_rhc_internal *)ip->idb_ptr;
     if (!rhc_is_valid(rhc)) {
 	return -2;
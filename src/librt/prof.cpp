@@ -0,0 +1,434 @@
+/*                       P R O F . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file librt/prof.cpp
+ *
+ * Per-resource profiling counters, the sampling profiler and their
+ * JSON report.  See rt/prof.h for how profiling is enabled.
+ */
+
+#include "common.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#include "bu/malloc.h"
+#include "bu/str.h"
+#include "bu/vls.h"
+#include "raytrace.h"
+
+
+int
+rt_prof_enabled(void)
+{
+    if (RT_G_DEBUG & RT_DEBUG_PROFILE)
+	return 1;
+
+    const char *env = getenv("LIBRT_PROF");
+    if (!env || BU_STR_EQUAL(env, "0"))
+	return 0;
+    return 1;
+}
+
+
+/* Sample rate, from LIBRT_PROF_HZ */
+static int
+prof_sample_hz(void)
+{
+    const char *env = getenv("LIBRT_PROF_HZ");
+    if (!env || !strlen(env))
+	return 1000;
+    int hz = atoi(env);
+    return (hz > 0) ? hz : 0;
+}
+
+
+/*
+ * The sampler thread.  Each tick it reads the state of every
+ * registered rt_prof and counts it.  Only the sampler writes the
+ * sample counts, and shooting threads only write their own state, so
+ * the hot path never locks; the registry lock is only taken when a
+ * resource is initialized or cleaned.  The thread is started with the
+ * first profiled resource and stopped when the last one goes away.
+ */
+class prof_sampler {
+public:
+    ~prof_sampler() {
+	std::lock_guard<std::mutex> c(ctl);
+	stop_thread();
+    }
+
+    void add(struct rt_prof *p) {
+	std::lock_guard<std::mutex> c(ctl);
+	{
+	    std::lock_guard<std::mutex> g(lock);
+	    profs.insert(p);
+	}
+	if (!thr.joinable()) {
+	    hz = prof_sample_hz();
+	    if (hz <= 0)
+		return;
+	    stop = false;
+	    thr = std::thread(&prof_sampler::run, this);
+	}
+    }
+
+    void remove(struct rt_prof *p) {
+	std::lock_guard<std::mutex> c(ctl);
+	bool empty;
+	{
+	    std::lock_guard<std::mutex> g(lock);
+	    profs.erase(p);
+	    empty = profs.empty();
+	}
+	if (empty)
+	    stop_thread();
+    }
+
+    int rate() {
+	std::lock_guard<std::mutex> c(ctl);
+	return (thr.joinable()) ? hz : 0;
+    }
+
+private:
+    /* ctl serializes starting and stopping the thread, lock guards the
+     * registry against the thread */
+    std::mutex ctl;
+    std::mutex lock;
+    std::condition_variable cv;
+    std::set<struct rt_prof *> profs;
+    std::thread thr;
+    bool stop = false;
+    int hz = 0;
+
+    /* caller holds ctl */
+    void stop_thread() {
+	if (!thr.joinable())
+	    return;
+	{
+	    std::lock_guard<std::mutex> g(lock);
+	    stop = true;
+	}
+	cv.notify_all();
+	thr.join();
+    }
+
+    void run() {
+	std::chrono::nanoseconds period(1000000000LL / hz);
+	std::unique_lock<std::mutex> l(lock);
+	while (!stop) {
+	    if (cv.wait_for(l, period, [this]{ return stop; }))
+		break;
+	    for (struct rt_prof *p : profs) {
+		int st = p->state;
+		int activity = st >> 16;
+		int id = st & 0xffff;
+		if (activity < 0 || activity >= RT_PROF_ST_NSTATES)
+		    continue;
+		p->samples[activity]++;
+		if (activity == RT_PROF_ST_SHOT && id <= ID_MAXIMUM)
+		    p->shot_samples[id]++;
+	    }
+	}
+    }
+};
+
+
+static prof_sampler &
+prof_get_sampler(void)
+{
+    static prof_sampler sampler;
+    return sampler;
+}
+
+
+void
+rt_prof_init_resource(struct resource *resp)
+{
+    if (!resp)
+	return;
+
+    /* A resource that has never been initialized (or has been
+     * cleaned) doesn't own anything yet */
+    if (resp->re_magic != RESOURCE_MAGIC)
+	resp->re_prof = NULL;
+
+    if (!rt_prof_enabled()) {
+	rt_prof_free_resource(resp);
+	return;
+    }
+
+    if (!resp->re_prof) {
+	BU_ALLOC(resp->re_prof, struct rt_prof);
+	prof_get_sampler().add(resp->re_prof);
+    }
+}
+
+
+void
+rt_prof_free_resource(struct resource *resp)
+{
+    if (!resp || !resp->re_prof)
+	return;
+    prof_get_sampler().remove(resp->re_prof);
+    bu_free(resp->re_prof, "struct rt_prof");
+    resp->re_prof = NULL;
+}
+
+
+uint64_t
+rt_prof_clock(void)
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+void
+rt_prof_weave(struct resource *resp, const struct seg *seghead)
+{
+    struct seg *segp;
+
+    if (!resp || !resp->re_prof || !seghead)
+	return;
+
+    resp->re_prof->weaves++;
+    for (BU_LIST_FOR(segp, seg, &(seghead->l)))
+	resp->re_prof->weave_segs++;
+}
+
+
+void
+rt_prof_partitions(struct resource *resp, const struct partition *PartHeadp)
+{
+    const struct partition *pp;
+
+    if (!resp || !resp->re_prof || !PartHeadp)
+	return;
+
+    resp->re_prof->hit_rays++;
+    for (pp = PartHeadp->pt_forw; pp != PartHeadp; pp = pp->pt_forw)
+	resp->re_prof->final_partitions++;
+}
+
+
+struct prof_totals {
+    struct rt_prof p;
+    long seglen, segget, segfree;
+    long partlen, partget, partfree;
+    int cnt;
+};
+
+
+static void
+prof_accumulate(struct prof_totals *t, const struct resource *resp)
+{
+    const struct rt_prof *p = resp->re_prof;
+
+    t->seglen += resp->re_seglen;
+    t->segget += resp->re_segget;
+    t->segfree += resp->re_segfree;
+    t->partlen += resp->re_partlen;
+    t->partget += resp->re_partget;
+    t->partfree += resp->re_partfree;
+
+    if (!p)
+	return;
+
+    t->cnt++;
+    for (int i = 0; i <= ID_MAXIMUM; i++) {
+	t->p.shots[i] += p->shots[i];
+	t->p.hits[i] += p->hits[i];
+	t->p.shot_ns[i] += p->shot_ns[i];
+    }
+    for (int i = 0; i < RT_PROF_DEPTH_BINS; i++)
+	t->p.cut_depth[i] += p->cut_depth[i];
+    t->p.weaves += p->weaves;
+    t->p.weave_segs += p->weave_segs;
+    t->p.final_partitions += p->final_partitions;
+    t->p.hit_rays += p->hit_rays;
+    for (int i = 0; i < RT_PROF_ST_NSTATES; i++)
+	t->p.samples[i] += p->samples[i];
+    for (int i = 0; i <= ID_MAXIMUM; i++)
+	t->p.shot_samples[i] += p->shot_samples[i];
+}
+
+
+/* Visit rtip's resources plus rt_uniresource, each exactly once */
+static void
+prof_for_resources(struct rt_i *rtip, void (*func)(struct resource *, void *), void *data)
+{
+    int have_uni = 0;
+
+    if (rtip && BU_LIST_MAGIC_EQUAL(&rtip->rti_resources.l, BU_PTBL_MAGIC)) {
+	struct resource **rpp;
+	for (BU_PTBL_FOR(rpp, (struct resource **), &rtip->rti_resources)) {
+	    if (*rpp == NULL || (*rpp)->re_magic != RESOURCE_MAGIC)
+		continue;
+	    if (*rpp == &rt_uniresource)
+		have_uni = 1;
+	    func(*rpp, data);
+	}
+    }
+    if (!have_uni && rt_uniresource.re_magic == RESOURCE_MAGIC)
+	func(&rt_uniresource, data);
+}
+
+
+static void
+prof_sum(struct resource *resp, void *data)
+{
+    prof_accumulate((struct prof_totals *)data, resp);
+}
+
+
+static void
+prof_zero(struct resource *resp, void *UNUSED(data))
+{
+    if (!resp->re_prof)
+	return;
+
+    /* The thread may be mid-ray - keep its current activity */
+    int state = resp->re_prof->state;
+    memset(resp->re_prof, 0, sizeof(struct rt_prof));
+    resp->re_prof->state = state;
+}
+
+
+int
+rt_prof_dump(struct bu_vls *json, struct rt_i *rtip)
+{
+    struct prof_totals t;
+    int first;
+
+    if (!json)
+	return 0;
+
+    memset(&t, 0, sizeof(t));
+    prof_for_resources(rtip, prof_sum, &t);
+
+    bu_vls_printf(json, "{\"resources\": %d", t.cnt);
+    if (rtip)
+	bu_vls_printf(json, ", \"rays\": %zu", rtip->rti_nrays);
+
+    bu_vls_printf(json, ", \"primitives\": {");
+    first = 1;
+    for (int i = 0; i <= ID_MAXIMUM; i++) {
+	if (!t.p.shots[i])
+	    continue;
+	bu_vls_printf(json, "%s\"%s\": {\"shots\": %llu, \"hits\": %llu, \"ns\": %llu, \"ns_per_shot\": %.1f}",
+		      (first) ? "" : ", ",
+		      OBJ[i].ft_label,
+		      (unsigned long long)t.p.shots[i],
+		      (unsigned long long)t.p.hits[i],
+		      (unsigned long long)t.p.shot_ns[i],
+		      (double)t.p.shot_ns[i] / (double)t.p.shots[i]);
+	first = 0;
+    }
+    bu_vls_printf(json, "}");
+
+    /* Trailing empty bins are left off the histogram */
+    int ndepth = RT_PROF_DEPTH_BINS;
+    while (ndepth > 0 && !t.p.cut_depth[ndepth-1])
+	ndepth--;
+    bu_vls_printf(json, ", \"cut_depth\": [");
+    for (int i = 0; i < ndepth; i++)
+	bu_vls_printf(json, "%s%llu", (i) ? ", " : "", (unsigned long long)t.p.cut_depth[i]);
+    bu_vls_printf(json, "]");
+
+    bu_vls_printf(json, ", \"boolweave\": {\"calls\": %llu, \"segs\": %llu}",
+		  (unsigned long long)t.p.weaves,
+		  (unsigned long long)t.p.weave_segs);
+    bu_vls_printf(json, ", \"partitions\": {\"hit_rays\": %llu, \"final\": %llu}",
+		  (unsigned long long)t.p.hit_rays,
+		  (unsigned long long)t.p.final_partitions);
+    bu_vls_printf(json, ", \"seg\": {\"allocated\": %ld, \"get\": %ld, \"free\": %ld}",
+		  t.seglen, t.segget, t.segfree);
+    bu_vls_printf(json, ", \"partition\": {\"allocated\": %ld, \"get\": %ld, \"free\": %ld}",
+		  t.partlen, t.partget, t.partfree);
+
+    static const char *state_names[RT_PROF_ST_NSTATES] = {"idle", "traverse", "shot", "weave", "eval", "hit"};
+    bu_vls_printf(json, ", \"samples\": {\"hz\": %d", prof_get_sampler().rate());
+    for (int i = 0; i < RT_PROF_ST_NSTATES; i++)
+	bu_vls_printf(json, ", \"%s\": %llu", state_names[i], (unsigned long long)t.p.samples[i]);
+    bu_vls_printf(json, ", \"shot_by_primitive\": {");
+    first = 1;
+    for (int i = 0; i <= ID_MAXIMUM; i++) {
+	if (!t.p.shot_samples[i])
+	    continue;
+	bu_vls_printf(json, "%s\"%s\": %llu", (first) ? "" : ", ", OBJ[i].ft_label, (unsigned long long)t.p.shot_samples[i]);
+	first = 0;
+    }
+    bu_vls_printf(json, "}}");
+
+    bu_vls_printf(json, "}");
+
+    return t.cnt;
+}
+
+
+void
+rt_prof_reset(struct rt_i *rtip)
+{
+    prof_for_resources(rtip, prof_zero, NULL);
+}
+
+
+void
+rt_prof_report(struct rt_i *rtip)
+{
+    struct bu_vls json = BU_VLS_INIT_ZERO;
+
+    if (!rt_prof_enabled())
+	return;
+
+    if (rt_prof_dump(&json, rtip) <= 0) {
+	bu_vls_free(&json);
+	return;
+    }
+
+    const char *env = getenv("LIBRT_PROF");
+    FILE *fp = NULL;
+    if (env && strlen(env) && !BU_STR_EQUAL(env, "1"))
+	fp = fopen(env, "a");
+    if (fp) {
+	fprintf(fp, "%s\n", bu_vls_cstr(&json));
+	fclose(fp);
+    } else {
+	bu_log("librt profile: %s\n", bu_vls_cstr(&json));
+    }
+    bu_vls_free(&json);
+
+    rt_prof_reset(rtip);
+}
+
+
+// Local Variables:
+// tab-width: 8
+// mode: C++
+// c-basic-offset: 4
+// indent-tabs-mode: t
+// c-file-style: "stroustrup"
+// End:
+// ex: shiftwidth=4 tabstop=8
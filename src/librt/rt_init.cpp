@@ -66,6 +66,21 @@ struct librt_initializer {
 static librt_initializer LIBRT;
 
 
+static thread_local struct bu_list *thread_vlfree = NULL;
+
+struct bu_list *
+rt_vlfree_get(void)
+{
+    return (thread_vlfree) ? thread_vlfree : &rt_vlfree;
+}
+
+void
+rt_vlfree_set(struct bu_list *vlfree)
+{
+    thread_vlfree = vlfree;
+}
+
+
 // Local Variables:
 // tab-width: 8
 // mode: C++
@@ -82,8 +82,11 @@
 
 #include "common.h"
 
+#include <algorithm>
+#include <atomic>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 
 #include <string.h>
 #include <stdlib.h>
@@ -101,6 +104,7 @@
 
 #include "bu/cmd.h"
 #include "bu/opt.h"
+#include "bu/parallel.h"
 #include "bu/path.h"
 
 #include "rt/db4.h"
@@ -377,6 +381,7 @@ f_below(struct db_plan_t *plan, struct db_node_t *db_node, struct db_i *dbip, st
     db_dup_full_path(&parent_path, db_node->path);
     DB_FULL_PATH_POP(&parent_path);
     curr_node.path = &parent_path;
+    curr_node.resp = db_node->resp;
     distance = db_node->path->fp_len - parent_path.fp_len;
 
     while ((parent_path.fp_len > 0) && (state == 0) && !(db_node->flags & DB_SEARCH_FLAT)) {
@@ -430,6 +435,7 @@ f_above(struct db_plan_t *plan, struct db_node_t *db_node, struct db_i *dbip, st
 		curr_node.path = this_path;
 		curr_node.flags = db_node->flags;
 		curr_node.full_paths = full_paths;
+		curr_node.resp = db_node->resp;
 
 		state = find_execute_nested_plans(dbip, NULL, &curr_node, plan->p_un._bl_data[0]);
 		if (state)
@@ -871,6 +877,21 @@ c_objparam(char *pattern, char ***UNUSED(ignored), int UNUSED(unused), struct db
 }
 
 
+struct attr_chk_data {
+    const char *keystr;
+    const char *value;
+    int checkval;
+    int strcomparison;
+};
+
+static int
+attr_chk(struct bu_attribute_value_set *avs, void *data)
+{
+    struct attr_chk_data *ad = (struct attr_chk_data *)data;
+    return avs_check(ad->keystr, ad->value, ad->checkval, ad->strcomparison, avs);
+}
+
+
 /*
  * -attr functions --
  *
@@ -883,6 +904,7 @@ f_attr(struct db_plan_t *plan, struct db_node_t *db_node, struct db_i *dbip, str
     struct bu_vls attribname = BU_VLS_INIT_ZERO;
     struct bu_vls value = BU_VLS_INIT_ZERO;
     struct bu_attribute_value_set avs;
+    int iret = -2;
     int checkval = 0;
     int strcomparison = 0;
     size_t i;
@@ -920,6 +942,34 @@ f_attr(struct db_plan_t *plan, struct db_node_t *db_node, struct db_i *dbip, str
 	return 0;
     }
 
+    /* If the database has a search index, answer from it rather than
+     * reading the object's attributes from disk.  The presence of a
+     * literal key, or string equality with a literal value, is a
+     * direct lookup - anything else is checked against the indexed
+     * attributes. */
+    if (!strpbrk(bu_vls_cstr(&attribname), "*?[\\")) {
+	if (!checkval)
+	    iret = db_search_index_attr(dbip, dp, bu_vls_cstr(&attribname), NULL);
+	if (checkval == 1 && strcomparison && !strpbrk(bu_vls_cstr(&value), "*?[\\"))
+	    iret = db_search_index_attr(dbip, dp, bu_vls_cstr(&attribname), bu_vls_cstr(&value));
+    }
+    if (iret == -2) {
+	struct attr_chk_data ad;
+	ad.keystr = bu_vls_cstr(&attribname);
+	ad.value = bu_vls_cstr(&value);
+	ad.checkval = checkval;
+	ad.strcomparison = strcomparison;
+	iret = db_search_index_avs(dbip, dp, attr_chk, (void *)&ad);
+    }
+    if (iret != -2) {
+	ret = (iret > 0) ? 1 : 0;
+	bu_vls_free(&attribname);
+	bu_vls_free(&value);
+	if (!ret)
+	    db_node->matched_filters = 0;
+	return ret;
+    }
+
     bu_avs_init_empty(&avs);
     if (db5_get_attributes(dbip, &avs, dp) < 0) {
 	bu_avs_free(&avs);
@@ -949,6 +999,34 @@ c_attr(char *pattern, char ***UNUSED(ignored), int UNUSED(unused), struct db_pla
 }
 
 
+/* True if avs holds only "standard" attributes (and at least one) */
+static int
+stdattr_chk(struct bu_attribute_value_set *avs, void *UNUSED(data))
+{
+    struct bu_attribute_value_pair *avpp;
+    int found_nonstd_attr = 0;
+    int found_attr = 0;
+
+    for (BU_AVS_FOR(avpp, avs)) {
+	found_attr = 1;
+	if (!BU_STR_EQUAL(avpp->name, "GIFTmater") &&
+	    !BU_STR_EQUAL(avpp->name, "aircode") &&
+	    !BU_STR_EQUAL(avpp->name, "inherit") &&
+	    !BU_STR_EQUAL(avpp->name, "los") &&
+	    !BU_STR_EQUAL(avpp->name, "material_id") &&
+	    !BU_STR_EQUAL(avpp->name, "oshader") &&
+	    !BU_STR_EQUAL(avpp->name, "region") &&
+	    !BU_STR_EQUAL(avpp->name, "region_id") &&
+	    !BU_STR_EQUAL(avpp->name, "rgb")) {
+
+	    found_nonstd_attr = 1;
+	}
+    }
+
+    return (!found_nonstd_attr && found_attr) ? 1 : 0;
+}
+
+
 /*
  * -stdattr function --
  *
@@ -960,11 +1038,9 @@ c_attr(char *pattern, char ***UNUSED(ignored), int UNUSED(unused), struct db_pla
 static int
 f_stdattr(struct db_plan_t *UNUSED(plan), struct db_node_t *db_node, struct db_i *dbip, struct bu_ptbl *UNUSED(results))
 {
-    struct bu_attribute_value_pair *avpp;
     struct bu_attribute_value_set avs;
     struct directory *dp;
-    int found_nonstd_attr = 0;
-    int found_attr = 0;
+    int ret;
 
     /* Get attributes for object and check all of them to see if there
      * is not a match to the standard attributes.  If any is found
@@ -977,37 +1053,17 @@ f_stdattr(struct db_plan_t *UNUSED(plan), struct db_node_t *db_node, struct db_i
 	return 0;
     }
 
-    bu_avs_init_empty(&avs);
-    if (db5_get_attributes(dbip, &avs, dp) < 0) {
+    ret = db_search_index_avs(dbip, dp, stdattr_chk, NULL);
+    if (ret == -2) {
+	bu_avs_init_empty(&avs);
+	ret = (db5_get_attributes(dbip, &avs, dp) < 0) ? 0 : stdattr_chk(&avs, NULL);
 	bu_avs_free(&avs);
-	db_node->matched_filters = 0;
-	return 0;
-    }
-
-    for (BU_AVS_FOR(avpp, &avs)) {
-	found_attr = 1;
-	if (!BU_STR_EQUAL(avpp->name, "GIFTmater") &&
-	    !BU_STR_EQUAL(avpp->name, "aircode") &&
-	    !BU_STR_EQUAL(avpp->name, "inherit") &&
-	    !BU_STR_EQUAL(avpp->name, "los") &&
-	    !BU_STR_EQUAL(avpp->name, "material_id") &&
-	    !BU_STR_EQUAL(avpp->name, "oshader") &&
-	    !BU_STR_EQUAL(avpp->name, "region") &&
-	    !BU_STR_EQUAL(avpp->name, "region_id") &&
-	    !BU_STR_EQUAL(avpp->name, "rgb")) {
-
-	    found_nonstd_attr = 1;
-	}
     }
 
-    bu_avs_free(&avs);
-
-    if (!found_nonstd_attr && found_attr) {
+    if (ret > 0)
 	return 1;
-    } else {
-	db_node->matched_filters = 0;
-	return 0;
-    }
+    db_node->matched_filters = 0;
+    return 0;
 }
 
 
@@ -1023,6 +1079,124 @@ c_stdattr(char *UNUSED(pattern), char ***UNUSED(ignored), int UNUSED(unused), st
 }
 
 
+/*
+ * Classify a non-combination object for the -type filter.  Most
+ * primitives can be classified from the directory entry alone - only
+ * ARBs, BoTs and BREPs need to be unpacked to determine their
+ * specific sub-type, plate or volume status.
+ */
+int
+db_search_type_info_get(struct db_search_type_info *info, struct directory *dp, struct db_i *dbip, struct resource *resp)
+{
+    struct rt_db_internal intern;
+    struct rt_bot_internal *bot_ip;
+    const struct bn_tol arb_tol = BN_TOL_INIT_TOL;
+    int minor_type;
+    int need_intern = 1;
+
+    if (!info || !dp || !dbip)
+	return -1;
+
+    info->valid = 0;
+    info->label = NULL;
+    info->is_shape = 0;
+    info->is_plate = 0;
+    info->is_volume = 0;
+
+    if (db_version(dbip) > 4 && dp->d_major_type == DB5_MAJORTYPE_BRLCAD) {
+	switch (dp->d_minor_type) {
+	    case DB5_MINORTYPE_BRLCAD_ARB8:
+	    case DB5_MINORTYPE_BRLCAD_BOT:
+	    case DB5_MINORTYPE_BRLCAD_BREP:
+		break;
+	    default:
+		if (dp->d_minor_type > 0 && dp->d_minor_type < ID_MAXIMUM && OBJ[dp->d_minor_type].ft_label[0] != '\0')
+		    need_intern = 0;
+		break;
+	}
+    }
+
+    if (!need_intern) {
+	minor_type = dp->d_minor_type;
+	info->label = OBJ[minor_type].ft_label;
+    } else {
+	RT_DB_INTERNAL_INIT(&intern);
+	if (rt_db_get_internal(&intern, dp, dbip, (fastf_t *)NULL, (resp) ? resp : &rt_uniresource) < 0)
+	    return -1;
+	if (intern.idb_major_type != DB5_MAJORTYPE_BRLCAD) {
+	    rt_db_free_internal(&intern);
+	    return 0;
+	}
+	minor_type = intern.idb_minor_type;
+
+	switch (minor_type) {
+	    case DB5_MINORTYPE_BRLCAD_ARB8:
+		switch (rt_arb_std_type(&intern, &arb_tol)) {
+		    case ARB4:
+			info->label = "arb4";
+			break;
+		    case ARB5:
+			info->label = "arb5";
+			break;
+		    case ARB6:
+			info->label = "arb6";
+			break;
+		    case ARB7:
+			info->label = "arb7";
+			break;
+		    case ARB8:
+			info->label = "arb8";
+			break;
+		    default:
+			info->label = "invalid";
+			break;
+		}
+		info->is_volume = 1;
+		break;
+	    case DB5_MINORTYPE_BRLCAD_BOT:
+		bot_ip = (struct rt_bot_internal *)intern.idb_ptr;
+		info->is_plate = (bot_ip->mode == RT_BOT_PLATE || bot_ip->mode == RT_BOT_PLATE_NOCOS);
+		info->is_volume = (bot_ip->mode == RT_BOT_SOLID);
+		info->label = intern.idb_meth->ft_label;
+		break;
+	    case DB5_MINORTYPE_BRLCAD_BREP:
+		info->is_plate = (rt_brep_plate_mode(&intern)) ? 1 : 0;
+		info->is_volume = !info->is_plate;
+		info->label = intern.idb_meth->ft_label;
+		break;
+	    default:
+		info->is_volume = 1;
+		info->label = intern.idb_meth->ft_label;
+		break;
+	}
+	rt_db_free_internal(&intern);
+    }
+
+    /* Match anything that doesn't define a 2D or 3D shape - unfortunately, this list will have to
+     * be updated manually unless/until some functionality is added to generate it */
+    if (minor_type != DB5_MINORTYPE_BRLCAD_ANNOT &&
+	minor_type != DB5_MINORTYPE_BRLCAD_COMBINATION &&
+	minor_type != DB5_MINORTYPE_BRLCAD_CONSTRAINT &&
+	minor_type != DB5_MINORTYPE_BRLCAD_DATUM &&
+	minor_type != DB5_MINORTYPE_BRLCAD_GRIP &&
+	minor_type != DB5_MINORTYPE_BRLCAD_JOINT &&
+	minor_type != DB5_MINORTYPE_BRLCAD_PNTS &&
+	minor_type != DB5_MINORTYPE_BRLCAD_SCRIPT &&
+	minor_type != DB5_MINORTYPE_BRLCAD_SUBMODEL
+       ) {
+	info->is_shape = 1;
+    }
+
+    if (!need_intern)
+	info->is_volume = 1;
+    if (!info->is_shape || minor_type == DB5_MINORTYPE_BRLCAD_SKETCH)
+	info->is_volume = 0;
+
+    info->valid = 1;
+    return 1;
+}
+
+
 /*
  * -type function --
  *
@@ -1034,12 +1208,10 @@ c_stdattr(char *UNUSED(pattern), char ***UNUSED(ignored), int UNUSED(unused), st
 static int
 f_type(struct db_plan_t *plan, struct db_node_t *db_node, struct db_i *dbip, struct bu_ptbl *UNUSED(results))
 {
-    struct rt_db_internal intern;
+    struct db_search_type_info info;
     struct directory *dp;
-    struct rt_bot_internal *bot_ip;
     int type_match = 0;
-    int type;
-    const struct bn_tol arb_tol = BN_TOL_INIT_TOL;
+    int ret;
 
     dp = DB_FULL_PATH_CUR_DIR(db_node->path);
     if (!dp)
@@ -1066,108 +1238,39 @@ f_type(struct db_plan_t *plan, struct db_node_t *db_node, struct db_i *dbip, str
 
     }
 
-    if (rt_db_get_internal(&intern, dp, dbip, (fastf_t *)NULL, &rt_uniresource) < 0)
+    /* If the database has a search index, a literal type name is a
+     * direct lookup and the classification is cached there for
+     * everything else - otherwise work it out from the object */
+    if (!strpbrk(plan->p_un._type_data, "*?[\\") &&
+	!BU_STR_EQUAL(plan->p_un._type_data, "shape") &&
+	!BU_STR_EQUAL(plan->p_un._type_data, "plate") &&
+	!BU_STR_EQUAL(plan->p_un._type_data, "volume")) {
+	ret = db_search_index_has_type(dbip, dp, plan->p_un._type_data);
+	if (ret >= 0) {
+	    type_match = ret;
+	    goto return_label;
+	}
+    }
+    ret = db_search_index_type(&info, dbip, dp);
+    if (ret == -2)
+	ret = db_search_type_info_get(&info, dp, dbip, db_node->resp);
+    if (ret < 0)
 	return 0;
-    if (intern.idb_major_type != DB5_MAJORTYPE_BRLCAD) {
-	rt_db_free_internal(&intern);
+    if (!info.valid) {
 	db_node->matched_filters = 0;
 	return 0;
     }
 
-    switch (intern.idb_minor_type) {
-	case DB5_MINORTYPE_BRLCAD_ARB8:
-	    type = rt_arb_std_type(&intern, &arb_tol);
-	    switch (type) {
-		case ARB4:
-		    type_match = (!bu_path_match(plan->p_un._type_data, "arb4", 0));
-		    break;
-		case ARB5:
-		    type_match = (!bu_path_match(plan->p_un._type_data, "arb5", 0));
-		    break;
-		case ARB6:
-		    type_match = (!bu_path_match(plan->p_un._type_data, "arb6", 0));
-		    break;
-		case ARB7:
-		    type_match = (!bu_path_match(plan->p_un._type_data, "arb7", 0));
-		    break;
-		case ARB8:
-		    type_match = (!bu_path_match(plan->p_un._type_data, "arb8", 0));
-		    break;
-		default:
-		    type_match = (!bu_path_match(plan->p_un._type_data, "invalid", 0));
-		    break;
-	    }
-	    break;
-	default:
-	    type_match = !bu_path_match(plan->p_un._type_data, intern.idb_meth->ft_label, 0);
-	    break;
-    }
+    type_match = !bu_path_match(plan->p_un._type_data, info.label, 0);
 
-    /* Match anything that doesn't define a 2D or 3D shape - unfortunately, this list will have to
-     * be updated manually unless/until some functionality is added to generate it */
-    if (!bu_path_match(plan->p_un._type_data, "shape", 0) &&
-	intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_ANNOT &&
-	intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_COMBINATION &&
-	intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_CONSTRAINT &&
-	intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_DATUM &&
-	intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_GRIP &&
-	intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_JOINT &&
-	intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_PNTS &&
-	intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_SCRIPT &&
-	intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_SUBMODEL
-	) {
+    if (!bu_path_match(plan->p_un._type_data, "shape", 0) && info.is_shape)
 	type_match = 1;
-    }
-
-    if (!bu_path_match(plan->p_un._type_data, "plate", 0)) {
-	switch (intern.idb_minor_type) {
-	    case DB5_MINORTYPE_BRLCAD_BOT:
-		bot_ip = (struct rt_bot_internal *)intern.idb_ptr;
-		if (bot_ip->mode == RT_BOT_PLATE || bot_ip->mode == RT_BOT_PLATE_NOCOS) {
-		    type_match = 1;
-		}
-		break;
-	    case DB5_MINORTYPE_BRLCAD_BREP:
-		if (rt_brep_plate_mode(&intern)) {
-		    type_match = 1;
-		}
-		break;
-	    default:
-		break;
-	}
-    }
-
-    if (!bu_path_match(plan->p_un._type_data, "volume", 0) &&
-	    intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_ANNOT &&
-	    intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_COMBINATION &&
-	    intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_CONSTRAINT &&
-	    intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_DATUM &&
-	    intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_GRIP &&
-	    intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_JOINT &&
-	    intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_PNTS &&
-	    intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_SCRIPT &&
-	    intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_SUBMODEL &&
-	    intern.idb_minor_type != DB5_MINORTYPE_BRLCAD_SKETCH) {
-	switch (intern.idb_minor_type) {
-	    case DB5_MINORTYPE_BRLCAD_BOT:
-		bot_ip = (struct rt_bot_internal *)intern.idb_ptr;
-		if (bot_ip->mode == RT_BOT_SOLID) {
-		    type_match = 1;
-		}
-		break;
-	    case DB5_MINORTYPE_BRLCAD_BREP:
-		if (!rt_brep_plate_mode(&intern)) {
-		    type_match = 1;
-		}
-		break;
-	    default:
-		type_match = 1;
-		break;
-	}
-    }
 
+    if (!bu_path_match(plan->p_un._type_data, "plate", 0) && info.is_plate)
+	type_match = 1;
 
-    rt_db_free_internal(&intern);
+    if (!bu_path_match(plan->p_un._type_data, "volume", 0) && info.is_volume)
+	type_match = 1;
 
 return_label:
 
@@ -2501,6 +2604,193 @@ find_execute_plans(struct db_i *dbip, struct bu_ptbl *results, struct db_node_t
 }
 
 
+/* Below this many candidate nodes, the thread setup costs more than
+ * the evaluation itself. */
+#define SEARCH_PARALLEL_MIN_NODES 256
+#define SEARCH_PARALLEL_CHUNK 64
+
+/*
+ * Report whether every filter in the plan is safe to evaluate
+ * concurrently on different nodes.  These filters only look at the
+ * node's path and read (never write) the database, and any object
+ * imports they do go through the node's per-thread resource.  Anything
+ * else - most importantly -exec, whose callback may do arbitrary
+ * things - forces a serial search.
+ */
+static int
+plan_parallel_safe(struct db_plan_t *plan)
+{
+    struct db_plan_t *p;
+    for (p = plan; p; p = p->next) {
+	switch (p->type) {
+	    case N_NAME:
+	    case N_INAME:
+	    case N_REGEX:
+	    case N_IREGEX:
+	    case N_STDATTR:
+	    case N_TYPE:
+	    case N_SIZE:
+	    case N_DEPTH:
+	    case N_MINDEPTH:
+	    case N_MAXDEPTH:
+	    case N_BOOL:
+	    case N_PATH:
+	    case N_PRINT:
+		break;
+	    case N_ATTR:
+		/* -param shares the N_ATTR node type */
+		if (p->eval != f_attr)
+		    return 0;
+		break;
+	    case N_NOT:
+	    case N_EXPR:
+		if (!plan_parallel_safe(p->p_un._p_data[0]))
+		    return 0;
+		break;
+	    case N_OR:
+		if (!plan_parallel_safe(p->p_un._p_data[0]) || !plan_parallel_safe(p->p_un._p_data[1]))
+		    return 0;
+		break;
+	    default:
+		return 0;
+	}
+    }
+    return 1;
+}
+
+
+struct search_parallel_data {
+    struct db_i *dbip;
+    struct db_plan_t *plan;
+    struct bu_ptbl *nodes;
+    struct bu_ptbl *full_paths;
+    int flags;
+    int collect;
+    struct resource *resp;
+    int *matched;
+    struct bu_ptbl **node_results;
+    std::atomic<size_t> next;
+};
+
+
+static void
+search_parallel_worker(int cpu, void *data)
+{
+    struct search_parallel_data *d = (struct search_parallel_data *)data;
+    struct bu_ptbl scratch = BU_PTBL_INIT_ZERO;
+    size_t node_cnt = BU_PTBL_LEN(d->nodes);
+
+    bu_ptbl_init(&scratch, 8, "search worker results");
+
+    while (1) {
+	size_t start = d->next.fetch_add(SEARCH_PARALLEL_CHUNK);
+	if (start >= node_cnt)
+	    break;
+	size_t end = std::min(start + SEARCH_PARALLEL_CHUNK, node_cnt);
+	for (size_t i = start; i < end; i++) {
+	    struct db_node_t curr_node;
+	    curr_node.path = (struct db_full_path *)BU_PTBL_GET(d->nodes, i);
+	    curr_node.full_paths = d->full_paths;
+	    curr_node.flags = d->flags;
+	    curr_node.matched_filters = 1;
+	    curr_node.resp = &d->resp[cpu];
+	    find_execute_plans(d->dbip, (d->collect) ? &scratch : NULL, &curr_node, d->plan);
+	    d->matched[i] = curr_node.matched_filters;
+
+	    /* Keep each node's output separate so the merge can
+	     * reproduce the serial ordering */
+	    if (BU_PTBL_LEN(&scratch)) {
+		BU_ALLOC(d->node_results[i], struct bu_ptbl);
+		bu_ptbl_init(d->node_results[i], BU_PTBL_LEN(&scratch), "search node results");
+		bu_ptbl_cat(d->node_results[i], &scratch);
+		bu_ptbl_reset(&scratch);
+	    }
+	}
+    }
+
+    bu_ptbl_free(&scratch);
+}
+
+
+/*
+ * Run the plan against each node (a db_full_path) in nodes, either
+ * serially or - when requested, worthwhile and safe for this plan -
+ * spread across threads.  Results are merged in node order, so both
+ * paths produce identical output.  Returns the number of nodes that
+ * matched.
+ */
+static int
+search_execute_nodes(struct db_i *dbip, struct bu_ptbl *search_results, struct bu_ptbl *nodes, struct bu_ptbl *full_paths, int search_flags, struct db_plan_t *dbplan)
+{
+    int result_cnt = 0;
+    size_t node_cnt = BU_PTBL_LEN(nodes);
+    size_t ncpu = bu_avail_cpus();
+
+    if (ncpu > MAX_PSW)
+	ncpu = MAX_PSW;
+
+    if (!(search_flags & DB_SEARCH_PARALLEL) || ncpu < 2 || node_cnt < SEARCH_PARALLEL_MIN_NODES || !plan_parallel_safe(dbplan)) {
+	for (size_t i = 0; i < node_cnt; i++) {
+	    struct db_node_t curr_node;
+	    curr_node.path = (struct db_full_path *)BU_PTBL_GET(nodes, i);
+	    curr_node.full_paths = full_paths;
+	    curr_node.flags = search_flags;
+	    curr_node.matched_filters = 1;
+	    curr_node.resp = &rt_uniresource;
+	    find_execute_plans(dbip, search_results, &curr_node, dbplan);
+	    result_cnt += curr_node.matched_filters;
+	}
+	return result_cnt;
+    }
+
+    struct search_parallel_data d;
+    d.dbip = dbip;
+    d.plan = dbplan;
+    d.nodes = nodes;
+    d.full_paths = full_paths;
+    d.flags = search_flags;
+    d.collect = (search_results) ? 1 : 0;
+    d.resp = (struct resource *)bu_calloc(ncpu, sizeof(struct resource), "search resources");
+    d.matched = (int *)bu_calloc(node_cnt, sizeof(int), "search node matches");
+    d.node_results = (struct bu_ptbl **)bu_calloc(node_cnt, sizeof(struct bu_ptbl *), "search node results");
+    d.next = 0;
+    for (size_t i = 0; i < ncpu; i++)
+	rt_init_resource(&d.resp[i], (int)i, NULL);
+
+    bu_parallel(search_parallel_worker, ncpu, (void *)&d);
+
+    /* Merge in node order.  Flat and unique-dp searches insert each
+     * directory pointer at most once. */
+    std::unordered_set<long *> seen;
+    int uniq = (search_flags & DB_SEARCH_FLAT || search_flags & DB_SEARCH_RETURN_UNIQ_DP);
+    if (search_results && uniq) {
+	for (size_t i = 0; i < BU_PTBL_LEN(search_results); i++)
+	    seen.insert(BU_PTBL_GET(search_results, i));
+    }
+    for (size_t i = 0; i < node_cnt; i++) {
+	result_cnt += d.matched[i];
+	if (!d.node_results[i])
+	    continue;
+	for (size_t j = 0; j < BU_PTBL_LEN(d.node_results[i]); j++) {
+	    long *r = BU_PTBL_GET(d.node_results[i], j);
+	    if (uniq && !seen.insert(r).second)
+		continue;
+	    bu_ptbl_ins(search_results, r);
+	}
+	bu_ptbl_free(d.node_results[i]);
+	bu_free(d.node_results[i], "search node results");
+    }
+
+    for (size_t i = 0; i < ncpu; i++)
+	rt_clean_resource_basic(NULL, &d.resp[i]);
+    bu_free(d.resp, "search resources");
+    bu_free(d.matched, "search node matches");
+    bu_free(d.node_results, "search node results");
+
+    return result_cnt;
+}
+
+
 static void
 free_exec_plan(struct db_plan_t *splan)
 {
@@ -2624,6 +2914,16 @@ db_search(struct bu_ptbl *search_results,
 	return -2;
     }
 
+    /* Bring the search index (if any) up to date before the filters
+     * that use it are evaluated */
+    for (size_t pi = 0; pi < BU_PTBL_LEN(&dbplans); pi++) {
+	struct db_plan_t *p = (struct db_plan_t *)BU_PTBL_GET(&dbplans, pi);
+	if (p->type == N_ATTR || p->type == N_STDATTR || p->type == N_TYPE) {
+	    db_search_index_sync(dbip);
+	    break;
+	}
+    }
+
     if (!paths) {
 	if (search_flags & DB_SEARCH_HIDDEN) {
 	    path_cnt = db_ls(dbip, DB_LS_TOPS | DB_LS_HIDDEN, NULL, &top_level_objects);
@@ -2636,6 +2936,7 @@ db_search(struct bu_ptbl *search_results,
     /* execute the plan */
     {
 	struct bu_ptbl *full_paths = NULL;
+	struct bu_ptbl flat_paths = BU_PTBL_INIT_ZERO;
 	struct list_client_data_t lcd;
 
 	/* First, check if search_results is initialized - don't trust the caller to do it,
@@ -2654,11 +2955,13 @@ db_search(struct bu_ptbl *search_results,
 	    lcd.dbip = dbip;
 	    lcd.full_paths = full_paths;
 	    lcd.flags = search_flags;
+	} else {
+	    BU_PTBL_INIT(&flat_paths);
 	}
 
-	/* If we're doing a flat search, we can handle everything in this loop.
-	 * Otherwise, we're building a list of full paths to be handled in a
-	 * second pass. */
+	/* For a flat search, the candidate nodes are just the starting
+	 * paths.  Otherwise, we're building a list of full paths to be
+	 * handled in a second pass. */
 	for (i = 0; i < path_cnt; i++) {
 	    struct directory *curr_dp = paths[i];
 	    struct db_full_path *start_path = NULL;
@@ -2674,20 +2977,12 @@ db_search(struct bu_ptbl *search_results,
 		db_add_node_to_full_path(start_path, curr_dp);
 		DB_FULL_PATH_SET_CUR_BOOL(start_path, 2);
 
-		/* For a flat search, we don't need to build a table of paths -
-		 * just run the filters on the path */
+		/* by convention, a top level node is "unioned" into the global database */
 		if (search_flags & DB_SEARCH_FLAT) {
-		    struct db_node_t curr_node;
-		    /* by convention, a top level node is "unioned" into the global database */
-		    curr_node.path = start_path;
-		    curr_node.flags = search_flags;
-		    curr_node.matched_filters = 1;
-		    curr_node.full_paths = NULL;
-		    find_execute_plans(dbip, search_results, &curr_node, dbplan);
-		    result_cnt += curr_node.matched_filters;
-		    DB_FULL_PATH_POP(start_path);
+		    /* For a flat search, we don't need to build a table of paths -
+		     * just run the filters on the path */
+		    bu_ptbl_ins(&flat_paths, (long *)start_path);
 		} else {
-		    /* by convention, a top level node is "unioned" into the global database */
 		    bu_ptbl_ins(full_paths, (long *)start_path);
 		    /* Use the initial path to tree-walk and build a set of all paths below
 		     * start_path */
@@ -2696,16 +2991,11 @@ db_search(struct bu_ptbl *search_results,
 	    }
 	}
 
-	if (!(search_flags & DB_SEARCH_FLAT)) {
-	    for (i = 0; i < (int)BU_PTBL_LEN(full_paths); i++) {
-		struct db_node_t curr_node;
-		curr_node.path = (struct db_full_path *)BU_PTBL_GET(full_paths, i);
-		curr_node.full_paths = full_paths;
-		curr_node.flags = search_flags;
-		curr_node.matched_filters = 1;
-		find_execute_plans(dbip, search_results, &curr_node, dbplan);
-		result_cnt += curr_node.matched_filters;
-	    }
+	if (search_flags & DB_SEARCH_FLAT) {
+	    result_cnt = search_execute_nodes(dbip, search_results, &flat_paths, NULL, search_flags, dbplan);
+	    db_search_free(&flat_paths);
+	} else {
+	    result_cnt = search_execute_nodes(dbip, search_results, full_paths, full_paths, search_flags, dbplan);
 
 	    /* Done with the paths now - we have our answer */
 	    db_search_free(full_paths);
@@ -75,6 +75,7 @@ struct db_node_t {
     struct bu_ptbl *full_paths;
     int flags;
     int matched_filters;
+    struct resource *resp;	/* per-thread resource for object imports */
 };
 
 /* search node type */
@@ -0,0 +1,425 @@
+/*                S E A R C H _ I N D E X . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file search_index.cpp
+ *
+ * Optional in-memory secondary index used by db_search.
+ *
+ * The -attr, -stdattr and -type filters otherwise have to read (and
+ * for -type, frequently unpack) every object they are evaluated
+ * against.  When an index is enabled on a db_i, the first search that
+ * uses one of those filters reads every object's attributes and type
+ * classification (in parallel) and records:
+ *
+ *   - attribute key -> objects with that key
+ *   - attribute key -> value -> objects with that key and value
+ *   - type label -> objects of that type
+ *
+ * along with each object's own attribute set, for the comparisons
+ * (patterns, < and >, numbers) a literal lookup can't answer.  The
+ * database change callback marks modified and added objects dirty and
+ * drops removed ones; dirty objects are re-read before the next
+ * search is run.
+ */
+
+#include "common.h"
+
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "bu/avs.h"
+#include "bu/parallel.h"
+#include "bu/path.h"
+#include "raytrace.h"
+#include "./librt_private.h"
+
+
+typedef std::unordered_set<struct directory *> search_index_objs;
+
+struct search_index_entry {
+    int attrs_state;	/* 1 = loaded, -1 = read failure */
+    struct bu_attribute_value_set avs;
+    int type_state;	/* 1 = loaded, -1 = read failure */
+    struct db_search_type_info type;
+};
+
+
+class DbSearchIndex {
+    public:
+	DbSearchIndex(struct db_i *d);
+	~DbSearchIndex();
+
+	void add(struct directory *dp, search_index_entry *e);
+	void remove(struct directory *dp);
+
+	struct db_i *dbip;
+	bool built = false;
+
+	/* Searches only read the index, and may do so from several
+	 * threads at once - the callback and sync take it exclusively. */
+	std::shared_mutex lock;
+
+	std::unordered_map<struct directory *, search_index_entry *> entries;
+	std::unordered_map<std::string, search_index_objs> key_objs;
+	std::unordered_map<std::string, std::unordered_map<std::string, search_index_objs>> val_objs;
+	std::unordered_map<std::string, search_index_objs> type_objs;
+	search_index_objs dirty;
+};
+
+
+static void
+search_index_changed_clbk(struct db_i *UNUSED(dbip), struct directory *dp, int mode, void *u_data)
+{
+    DbSearchIndex *idx = (DbSearchIndex *)u_data;
+    if (!idx || !dp)
+	return;
+
+    std::unique_lock<std::shared_mutex> guard(idx->lock);
+    if (!idx->built)
+	return;
+    if (mode == 2) {
+	idx->remove(dp);
+	idx->dirty.erase(dp);
+	return;
+    }
+    idx->dirty.insert(dp);
+}
+
+
+DbSearchIndex::DbSearchIndex(struct db_i *d)
+{
+    dbip = d;
+    db_add_changed_clbk(dbip, search_index_changed_clbk, (void *)this);
+}
+
+
+DbSearchIndex::~DbSearchIndex()
+{
+    db_rm_changed_clbk(dbip, search_index_changed_clbk, (void *)this);
+    for (auto &e : entries) {
+	if (e.second->attrs_state == 1)
+	    bu_avs_free(&e.second->avs);
+	BU_PUT(e.second, struct search_index_entry);
+    }
+}
+
+
+/* Caller must hold the lock exclusively.  Takes ownership of e. */
+void
+DbSearchIndex::add(struct directory *dp, search_index_entry *e)
+{
+    remove(dp);
+    entries[dp] = e;
+
+    if (e->attrs_state == 1) {
+	struct bu_attribute_value_pair *avpp;
+	for (BU_AVS_FOR(avpp, &e->avs)) {
+	    key_objs[std::string(avpp->name)].insert(dp);
+	    val_objs[std::string(avpp->name)][std::string(avpp->value)].insert(dp);
+	}
+    }
+    if (e->type_state == 1 && e->type.valid && e->type.label)
+	type_objs[std::string(e->type.label)].insert(dp);
+}
+
+
+/* Caller must hold the lock exclusively */
+void
+DbSearchIndex::remove(struct directory *dp)
+{
+    auto e_it = entries.find(dp);
+    if (e_it == entries.end())
+	return;
+
+    search_index_entry *e = e_it->second;
+    if (e->attrs_state == 1) {
+	struct bu_attribute_value_pair *avpp;
+	for (BU_AVS_FOR(avpp, &e->avs)) {
+	    std::string key(avpp->name);
+	    auto k_it = key_objs.find(key);
+	    if (k_it != key_objs.end()) {
+		k_it->second.erase(dp);
+		if (k_it->second.empty())
+		    key_objs.erase(k_it);
+	    }
+	    auto v_it = val_objs.find(key);
+	    if (v_it != val_objs.end()) {
+		auto vv_it = v_it->second.find(std::string(avpp->value));
+		if (vv_it != v_it->second.end()) {
+		    vv_it->second.erase(dp);
+		    if (vv_it->second.empty())
+			v_it->second.erase(vv_it);
+		}
+		if (v_it->second.empty())
+		    val_objs.erase(v_it);
+	    }
+	}
+	bu_avs_free(&e->avs);
+    }
+    if (e->type_state == 1 && e->type.valid && e->type.label) {
+	auto t_it = type_objs.find(std::string(e->type.label));
+	if (t_it != type_objs.end()) {
+	    t_it->second.erase(dp);
+	    if (t_it->second.empty())
+		type_objs.erase(t_it);
+	}
+    }
+    BU_PUT(e, struct search_index_entry);
+    entries.erase(e_it);
+}
+
+
+static search_index_entry *
+search_index_read(struct db_i *dbip, struct directory *dp, struct resource *resp)
+{
+    search_index_entry *e;
+    BU_GET(e, struct search_index_entry);
+    bu_avs_init_empty(&e->avs);
+    e->attrs_state = (db5_get_attributes(dbip, &e->avs, dp) < 0) ? -1 : 1;
+    if (e->attrs_state < 0)
+	bu_avs_free(&e->avs);
+    e->type_state = -1;
+    memset(&e->type, 0, sizeof(struct db_search_type_info));
+    if (!(dp->d_flags & RT_DIR_COMB) && dp->d_major_type != DB5_MAJORTYPE_ATTRIBUTE_ONLY)
+	e->type_state = (db_search_type_info_get(&e->type, dp, dbip, resp) < 0) ? -1 : 1;
+    return e;
+}
+
+
+struct search_index_build {
+    struct db_i *dbip;
+    std::vector<struct directory *> *dps;
+    std::vector<search_index_entry *> *ents;
+    struct resource *res;
+    size_t current;	/* semaphored */
+    size_t nworkers;	/* semaphored */
+};
+
+
+static void
+search_index_build_worker(int UNUSED(cpu), void *data)
+{
+    struct search_index_build *b = (struct search_index_build *)data;
+
+    bu_semaphore_acquire(BU_SEM_GENERAL);
+    struct resource *resp = &b->res[b->nworkers++];
+    bu_semaphore_release(BU_SEM_GENERAL);
+
+    while (1) {
+	bu_semaphore_acquire(BU_SEM_GENERAL);
+	size_t mine = b->current++;
+	bu_semaphore_release(BU_SEM_GENERAL);
+
+	if (mine >= b->dps->size())
+	    break;
+
+	(*b->ents)[mine] = search_index_read(b->dbip, (*b->dps)[mine], resp);
+    }
+}
+
+
+int
+db_search_index_enable(struct db_i *dbip)
+{
+    if (!dbip)
+	return -1;
+    RT_CK_DBI(dbip);
+
+    if (dbip->dbi_search_index)
+	return 0;
+
+    dbip->dbi_search_index = (void *)new DbSearchIndex(dbip);
+    return 0;
+}
+
+
+void
+db_search_index_disable(struct db_i *dbip)
+{
+    if (!dbip || !dbip->dbi_search_index)
+	return;
+
+    DbSearchIndex *idx = (DbSearchIndex *)dbip->dbi_search_index;
+    dbip->dbi_search_index = NULL;
+    delete idx;
+}
+
+
+int
+db_search_index_sync(struct db_i *dbip)
+{
+    if (!dbip || !dbip->dbi_search_index)
+	return -2;
+
+    DbSearchIndex *idx = (DbSearchIndex *)dbip->dbi_search_index;
+    std::unique_lock<std::shared_mutex> guard(idx->lock);
+
+    std::vector<struct directory *> dps;
+    if (!idx->built) {
+	for (int i = 0; i < RT_DBNHASH; i++) {
+	    for (struct directory *dp = dbip->dbi_Head[i]; dp != RT_DIR_NULL; dp = dp->d_forw)
+		dps.push_back(dp);
+	}
+    } else {
+	dps.insert(dps.end(), idx->dirty.begin(), idx->dirty.end());
+    }
+    idx->dirty.clear();
+    if (!dps.size()) {
+	idx->built = true;
+	return 0;
+    }
+
+    std::vector<search_index_entry *> ents(dps.size(), NULL);
+    size_t ncpu = (size_t)bu_avail_cpus();
+    ncpu = (ncpu < 1) ? 1 : ((ncpu > dps.size()) ? dps.size() : ncpu);
+    std::vector<struct resource> res(ncpu);
+    for (size_t i = 0; i < ncpu; i++)
+	rt_init_resource(&res[i], (int)i, NULL);
+
+    struct search_index_build b;
+    b.dbip = dbip;
+    b.dps = &dps;
+    b.ents = &ents;
+    b.res = res.data();
+    b.current = 0;
+    b.nworkers = 0;
+    bu_parallel(search_index_build_worker, ncpu, (void *)&b);
+
+    for (size_t i = 0; i < ncpu; i++)
+	rt_clean_resource_basic(NULL, &res[i]);
+
+    for (size_t i = 0; i < dps.size(); i++)
+	idx->add(dps[i], ents[i]);
+    idx->built = true;
+    return 0;
+}
+
+
+/* Shared lookup setup - returns the entry for dp if the index is
+ * current for it, NULL otherwise.  Caller holds the lock shared. */
+static search_index_entry *
+search_index_current(DbSearchIndex *idx, struct directory *dp)
+{
+    if (!idx->built || idx->dirty.find(dp) != idx->dirty.end())
+	return NULL;
+    auto e_it = idx->entries.find(dp);
+    if (e_it == idx->entries.end())
+	return NULL;
+    return e_it->second;
+}
+
+
+int
+db_search_index_attr(struct db_i *dbip, struct directory *dp, const char *key, const char *value)
+{
+    if (!dbip || !dbip->dbi_search_index || !dp || !key)
+	return -2;
+
+    DbSearchIndex *idx = (DbSearchIndex *)dbip->dbi_search_index;
+    std::shared_lock<std::shared_mutex> guard(idx->lock);
+    search_index_entry *e = search_index_current(idx, dp);
+    if (!e)
+	return -2;
+    if (e->attrs_state != 1)
+	return 0;
+
+    if (!value) {
+	auto k_it = idx->key_objs.find(std::string(key));
+	if (k_it == idx->key_objs.end())
+	    return 0;
+	return (k_it->second.find(dp) != k_it->second.end()) ? 1 : 0;
+    }
+
+    auto v_it = idx->val_objs.find(std::string(key));
+    if (v_it == idx->val_objs.end())
+	return 0;
+    auto vv_it = v_it->second.find(std::string(value));
+    if (vv_it == v_it->second.end())
+	return 0;
+    return (vv_it->second.find(dp) != vv_it->second.end()) ? 1 : 0;
+}
+
+
+int
+db_search_index_avs(struct db_i *dbip, struct directory *dp, int (*avs_chk)(struct bu_attribute_value_set *, void *), void *data)
+{
+    if (!dbip || !dbip->dbi_search_index || !dp || !avs_chk)
+	return -2;
+
+    /* The check runs with the lock held, so the attributes can't be
+     * freed out from under it by a concurrent edit */
+    DbSearchIndex *idx = (DbSearchIndex *)dbip->dbi_search_index;
+    std::shared_lock<std::shared_mutex> guard(idx->lock);
+    search_index_entry *e = search_index_current(idx, dp);
+    if (!e)
+	return -2;
+    if (e->attrs_state != 1)
+	return -1;
+    return (*avs_chk)(&e->avs, data);
+}
+
+
+int
+db_search_index_type(struct db_search_type_info *info, struct db_i *dbip, struct directory *dp)
+{
+    if (!dbip || !dbip->dbi_search_index || !info || !dp)
+	return -2;
+
+    DbSearchIndex *idx = (DbSearchIndex *)dbip->dbi_search_index;
+    std::shared_lock<std::shared_mutex> guard(idx->lock);
+    search_index_entry *e = search_index_current(idx, dp);
+    if (!e)
+	return -2;
+    if (e->type_state != 1)
+	return -1;
+    (*info) = e->type;
+    return 1;
+}
+
+
+int
+db_search_index_has_type(struct db_i *dbip, struct directory *dp, const char *label)
+{
+    if (!dbip || !dbip->dbi_search_index || !dp || !label)
+	return -2;
+
+    DbSearchIndex *idx = (DbSearchIndex *)dbip->dbi_search_index;
+    std::shared_lock<std::shared_mutex> guard(idx->lock);
+    search_index_entry *e = search_index_current(idx, dp);
+    if (!e || e->type_state != 1)
+	return -2;
+    auto t_it = idx->type_objs.find(std::string(label));
+    if (t_it == idx->type_objs.end())
+	return 0;
+    return (t_it->second.find(dp) != t_it->second.end()) ? 1 : 0;
+}
+
+
+// Local Variables:
+// tab-width: 8
+// mode: C++
+// c-basic-offset: 4
+// indent-tabs-mode: t
+// c-file-style: "stroustrup"
+// End:
+// ex: shiftwidth=4 tabstop=8
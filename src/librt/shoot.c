@@ -52,6 +52,121 @@ shoot_setup_status(struct rt_shootray_status *ss, struct application *ap)
 }
 
 
+/**
+ * State for the rt_shootray_occluded() and rt_shootray_first()
+ * queries, which share rt_shootray()'s traversal but never build the
+ * full partition list or make callbacks.
+ */
+struct shoot_query {
+    int first;		/**< @brief 1=nearest hit wanted, 0=any hit will do */
+    int plain_ok;	/**< @brief 1=plain solids may skip weaving */
+    fastf_t limit;	/**< @brief hits entering beyond this don't count */
+    int found;
+    fastf_t dist;	/**< @brief entry distance of the best hit so far */
+    struct region *regp;
+};
+
+
+/* Any segment of a solid used by a single non-air, non-FASTGEN region
+ * whose tree is a pure union is material of that region, no weaving
+ * needed.  A solid shared between regions always overlaps itself, so
+ * it is left to the boolean evaluation.
+ */
+static int
+shoot_solid_is_plain(struct soltab *stp)
+{
+    struct region *regp;
+
+    if (BU_PTBL_LEN(&stp->st_regions) != 1)
+	return 0;
+    regp = (struct region *)BU_PTBL_GET(&stp->st_regions, 0);
+    return (regp->reg_all_unions && regp->reg_aircode == 0 &&
+	    regp->reg_is_fastgen == REGION_NON_FASTGEN);
+}
+
+
+static void
+shoot_query_hit(struct shoot_query *q, fastf_t dist, struct region *regp)
+{
+    if (dist > q->limit)
+	return;
+    if (q->found && dist >= q->dist)
+	return;
+    q->found = 1;
+    q->dist = dist;
+    q->regp = regp;
+}
+
+
+/**
+ * Process the segments gathered so far for a query.  Segments of
+ * plain solids are decided on the spot and released; the rest are
+ * woven and boolean evaluated as far as enddist, which must not
+ * exceed the distance up to which every solid has been shot.
+ *
+ * Returns truthfully once the query is answered.
+ */
+static int
+shoot_query_eval(struct shoot_query *q, struct seg *waiting_segs, struct seg *finished_segs, struct partition *InitialPart, struct partition *FinalPart, fastf_t enddist, struct bu_ptbl *regionbits, struct application *ap, struct bu_bitv *solidbits)
+{
+    struct resource *resp = ap->a_resource;
+    struct partition *pp;
+    struct seg *segp, *nsegp;
+
+    for (segp = BU_LIST_FIRST(seg, &(waiting_segs->l)); BU_LIST_NOT_HEAD(segp, &(waiting_segs->l)); segp = nsegp) {
+	nsegp = BU_LIST_PNEXT(seg, segp);
+	if (segp->seg_out.hit_dist >= 0.0) {
+	    if (!q->plain_ok || !shoot_solid_is_plain(segp->seg_stp))
+		continue;
+	    shoot_query_hit(q, segp->seg_in.hit_dist, (struct region *)BU_PTBL_GET(&segp->seg_stp->st_regions, 0));
+	}
+	/* decided, or entirely behind the start point */
+	BU_LIST_DEQUEUE(&(segp->l));
+	RT_FREE_SEG(segp, resp);
+    }
+
+    if (q->found && !q->first)
+	return 1;
+
+    if (BU_LIST_NON_EMPTY(&(waiting_segs->l))) {
+	if (resp->re_prof) {
+	    rt_prof_weave(resp, waiting_segs);
+	    RT_PROF_STATE(resp, RT_PROF_ST_WEAVE, 0);
+	}
+	rt_boolweave(finished_segs, waiting_segs, InitialPart, ap);
+	RT_PROF_STATE(resp, RT_PROF_ST_TRAVERSE, 0);
+    }
+
+    if (InitialPart->pt_forw != InitialPart) {
+	int onehit = ap->a_onehit;
+	fastf_t evaldist = enddist;
+
+	/* nothing past an existing answer can improve on it */
+	if (q->found && q->dist < evaldist)
+	    evaldist = q->dist;
+
+	/* stop at the first non-air partition */
+	ap->a_onehit = -1;
+	RT_PROF_STATE(resp, RT_PROF_ST_EVAL, 0);
+	(void)rt_boolfinal(InitialPart, FinalPart, BACKING_DIST, evaldist, regionbits, ap, solidbits);
+	RT_PROF_STATE(resp, RT_PROF_ST_TRAVERSE, 0);
+	ap->a_onehit = onehit;
+
+	for (pp = FinalPart->pt_forw; pp != FinalPart; pp = pp->pt_forw) {
+	    if (pp->pt_outhit->hit_dist < 0.0 || pp->pt_regionp->reg_aircode != 0)
+		continue;
+	    shoot_query_hit(q, pp->pt_inhit->hit_dist, pp->pt_regionp);
+	    break;
+	}
+    }
+
+    if (!q->found)
+	return 0;
+
+    return (!q->first || q->dist <= enddist);
+}
+
+
 void
 rt_res_pieces_init(struct resource *resp, struct rt_i *rtip)
 {
@@ -143,6 +258,7 @@ rt_advance_to_next_cell(register struct rt_shootray_status *ssp)
     register const struct application *ap = ssp->ap;
     register fastf_t t0, px, py, pz;
     int push_flag = 0;
+    int depth;
     double fraction;
     int exponent;
 
@@ -246,7 +362,9 @@ rt_advance_to_next_cell(register struct rt_shootray_status *ssp)
 		t0 /*ssp->dist_corr*/, px, py, pz);
 	}
 
+	depth = 0;
 	while (cutp->cut_type == CUT_CUTNODE) {
+	    depth++;
 	    switch (cutp->cn.cn_axis) {
 		case X:
 		    if (!(px < cutp->cn.cn_point)) {
@@ -397,6 +515,9 @@ rt_advance_to_next_cell(register struct rt_shootray_status *ssp)
 		    goto push_to_next_box;
 		}
 
+		if (ap->a_resource->re_prof)
+		    ap->a_resource->re_prof->cut_depth[(depth < RT_PROF_DEPTH_BINS) ? depth : RT_PROF_DEPTH_BINS-1]++;
+
 		ssp->lastcut = cutp;
 		ssp->dist_corr = t0;
 		ssp->box_start = t0 + ssp->newray.r_min;
@@ -640,8 +761,14 @@ rt_plot_cell(const union cutter *cutp, const struct rt_shootray_status *ssp, str
 }
 
 
-_BU_ATTR_FLATTEN int
-rt_shootray(register struct application *ap)
+/**
+ * The ray traversal behind rt_shootray() and the query forms.  With q
+ * NULL this is rt_shootray().  Otherwise the answer is left in q, the
+ * application's callbacks are not invoked, and the return value is
+ * whether anything was found.
+ */
+_BU_ATTR_FLATTEN static int
+shootray(register struct application *ap, struct shoot_query *q)
 {
     struct rt_shootray_status ss;
     struct seg new_segs;	/* from solid intersections */
@@ -661,6 +788,8 @@ rt_shootray(register struct application *ap)
     struct rt_i *rtip;
     const int debug_shoot = RT_G_DEBUG & RT_DEBUG_SHOOT;
     fastf_t pending_hit = 0; /* dist of closest odd hit pending */
+    uint64_t prof_t0 = 0;
+    int prof_state = RT_PROF_ST_IDLE;
 
     RT_AP_CHECK(ap);
     if (ap->a_magic) {
@@ -732,6 +861,13 @@ rt_shootray(register struct application *ap)
     if (resp != &rt_uniresource)
 	BU_ASSERT(BU_PTBL_GET(&rtip->rti_resources, resp->re_cpu) != NULL);
 
+    /* Rays may be fired from within a_hit(), so the sampled state is
+     * put back rather than reset on the way out */
+    if (resp->re_prof) {
+	prof_state = resp->re_prof->state;
+	RT_PROF_STATE(resp, RT_PROF_ST_TRAVERSE, 0);
+    }
+
     solidbits = rt_get_solidbitv(rtip->nsolids, resp);
 
     if (BU_LIST_IS_EMPTY(&resp->re_region_ptbl)) {
@@ -834,6 +970,12 @@ rt_shootray(register struct application *ap)
 	    goto start_cell;
 	}
 	resp->re_nmiss_model++;
+	if (q) {
+	    ap->a_return = 0;
+	    status = "MISS model";
+	    goto out;
+	}
+	RT_PROF_STATE(resp, RT_PROF_ST_HIT, 0);
 	if (ap->a_miss)
 	    ap->a_return = ap->a_miss(ap);
 	else
@@ -1027,10 +1169,18 @@ rt_shootray(register struct application *ap)
 		resp->re_piece_shots++;
 		psp->cutp = cutp;
 
+		if (resp->re_prof) {
+		    RT_PROF_STATE(resp, RT_PROF_ST_SHOT, stp->st_id);
+		    prof_t0 = rt_prof_clock();
+		}
 		ret = -1;
 		if (stp->st_meth->ft_piece_shot) {
 		    ret = stp->st_meth->ft_piece_shot(psp, plp, ss.dist_corr, &ss.newray, ap, &waiting_segs);
 		}
+		if (resp->re_prof) {
+		    RT_PROF_SHOT(resp, stp->st_id, ret, prof_t0);
+		    RT_PROF_STATE(resp, RT_PROF_ST_TRAVERSE, 0);
+		}
 		if (ret <= 0) {
 		    /* No hits at all */
 		    resp->re_piece_shot_miss++;
@@ -1096,10 +1246,18 @@ rt_shootray(register struct application *ap)
 		resp->re_shots++;
 		BU_LIST_INIT(&(new_segs.l));
 
+		if (resp->re_prof) {
+		    RT_PROF_STATE(resp, RT_PROF_ST_SHOT, stp->st_id);
+		    prof_t0 = rt_prof_clock();
+		}
 		ret = -1;
 		if (stp->st_meth->ft_shot) {
 		    ret = stp->st_meth->ft_shot(stp, &ss.newray, ap, &new_segs);
 		}
+		if (resp->re_prof) {
+		    RT_PROF_SHOT(resp, stp->st_id, ret, prof_t0);
+		    RT_PROF_STATE(resp, RT_PROF_ST_TRAVERSE, 0);
+		}
 		if (ret <= 0) {
 		    resp->re_shot_miss++;
 		    continue;	/* MISS */
@@ -1123,6 +1281,25 @@ rt_shootray(register struct application *ap)
 	if (RT_G_DEBUG & RT_DEBUG_ADVANCE)
 	    rt_plot_cell(cutp, &ss, &(waiting_segs.l), rtip);
 
+	if (q) {
+	    /* Pending pieces may still hold hits back as far as their
+	     * mindist, so only trust evaluation up to there.
+	     */
+	    if (BU_PTBL_LEN(&resp->re_pieces_pending) > 0) {
+		struct rt_piecestate **psp;
+		for (BU_PTBL_FOR(psp, (struct rt_piecestate **), &resp->re_pieces_pending)) {
+		    if ((*psp)->mindist < pending_hit)
+			pending_hit = (*psp)->mindist;
+		}
+	    }
+	    if (shoot_query_eval(q, &waiting_segs, &finished_segs, &InitialPart, &FinalPart, pending_hit, regionbits, ap, solidbits))
+		goto query_done;
+	    if (ss.box_end >= q->limit)
+		goto weave;
+	    ss.box_start = ss.box_end;
+	    continue;
+	}
+
 	/*
 	 * If a_onehit == 0 and a_ray_length <= 0, then the ray is
 	 * traced to +infinity.
@@ -1151,6 +1328,10 @@ rt_shootray(register struct application *ap)
 		int done;
 
 		/* Weave these segments into partition list */
+		if (resp->re_prof) {
+		    rt_prof_weave(resp, &waiting_segs);
+		    RT_PROF_STATE(resp, RT_PROF_ST_WEAVE, 0);
+		}
 		rt_boolweave(&finished_segs, &waiting_segs, &InitialPart, ap);
 
 		if (BU_PTBL_LEN(&resp->re_pieces_pending) > 0) {
@@ -1173,8 +1354,10 @@ rt_shootray(register struct application *ap)
 
 		/* Evaluate regions up to end of good segs */
 		if (ss.box_end < pending_hit) pending_hit = ss.box_end;
+		RT_PROF_STATE(resp, RT_PROF_ST_EVAL, 0);
 		done = rt_boolfinal(&InitialPart, &FinalPart,
 				    last_bool_start, pending_hit, regionbits, ap, solidbits);
+		RT_PROF_STATE(resp, RT_PROF_ST_TRAVERSE, 0);
 		last_bool_start = pending_hit;
 
 		/* See if enough partitions have been acquired */
@@ -1214,12 +1397,22 @@ weave:
 	bu_ptbl_reset(&resp->re_pieces_pending);
     }
 
+    if (q) {
+	(void)shoot_query_eval(q, &waiting_segs, &finished_segs, &InitialPart, &FinalPart, INFINITY, regionbits, ap, solidbits);
+	goto query_done;
+    }
+
     if (BU_LIST_NON_EMPTY(&(waiting_segs.l))) {
+	if (resp->re_prof) {
+	    rt_prof_weave(resp, &waiting_segs);
+	    RT_PROF_STATE(resp, RT_PROF_ST_WEAVE, 0);
+	}
 	rt_boolweave(&finished_segs, &waiting_segs, &InitialPart, ap);
     }
 
     /* finished_segs chain now has all segments hit by this ray */
     if (BU_LIST_IS_EMPTY(&(finished_segs.l))) {
+	RT_PROF_STATE(resp, RT_PROF_ST_HIT, 0);
 	if (ap->a_miss)
 	    ap->a_return = ap->a_miss(ap);
 	else
@@ -1232,11 +1425,13 @@ weave:
      * All intersections of the ray with the model have been computed.
      * Evaluate the boolean trees over each partition.
      */
+    RT_PROF_STATE(resp, RT_PROF_ST_EVAL, 0);
     (void)rt_boolfinal(&InitialPart, &FinalPart, BACKING_DIST,
 		       INFINITY,
 		       regionbits, ap, solidbits);
 
     if (FinalPart.pt_forw == &FinalPart) {
+	RT_PROF_STATE(resp, RT_PROF_ST_HIT, 0);
 	if (ap->a_miss)
 	    ap->a_return = ap->a_miss(ap);
 	else
@@ -1251,6 +1446,8 @@ hitit:
     /* Ray/model intersections exist */
 
     if (debug_shoot) rt_pr_partitions(rtip, &FinalPart, "a_hit()");
+    if (resp->re_prof)
+	rt_prof_partitions(resp, &FinalPart);
 
     /* Before recursing, release storage for unused Initial
      * partitions.  finished_segs can not be released yet, because
@@ -1264,6 +1461,7 @@ hitit:
     if (RT_G_DEBUG&RT_DEBUG_ALLHITS) rt_pr_partitions(rtip, &FinalPart, "Partition list passed to a_hit() routine");
 
     /* Invoke caller's a_hit callback with the list of partitions */
+    RT_PROF_STATE(resp, RT_PROF_ST_HIT, 0);
     if (ap->a_hit) {
 	ap->a_return = ap->a_hit(ap, &FinalPart, &finished_segs);
 	status = "HIT";
@@ -1274,11 +1472,28 @@ hitit:
 
     RT_FREE_SEG_LIST(&finished_segs, resp);
     RT_FREE_PT_LIST(&FinalPart, resp);
+    goto out;
+
+query_done:
+    ap->a_return = q->found;
+    status = (q->found) ? "HIT query" : "MISS query";
+    /* the answer stands in for the partition list */
+    if (resp->re_prof && q->found) {
+	resp->re_prof->hit_rays++;
+	resp->re_prof->final_partitions++;
+    }
+    RT_FREE_PT_LIST(&InitialPart, resp);
+    RT_FREE_PT_LIST(&FinalPart, resp);
+    RT_FREE_SEG_LIST(&waiting_segs, resp);
+    RT_FREE_SEG_LIST(&finished_segs, resp);
 
     /*
      * Processing of this ray is complete.
      */
 out:
+    if (resp->re_prof)
+	resp->re_prof->state = prof_state;
+
     /* Return dynamic resources to their freelists.  */
     BU_CK_BITV(solidbits);
     BU_LIST_APPEND(&resp->re_solid_bitv, &solidbits->l);
@@ -1313,6 +1528,59 @@ out:
 }
 
 
+int
+rt_shootray(register struct application *ap)
+{
+    return shootray(ap, NULL);
+}
+
+
+static void
+shoot_query_init(struct shoot_query *q, struct application *ap, int first, int plain_ok, fastf_t dist)
+{
+    q->first = first;
+    q->plain_ok = plain_ok;
+    q->limit = (dist > 0.0) ? dist : INFINITY;
+    if (ap->a_ray_length > 0.0 && ap->a_ray_length < q->limit)
+	q->limit = ap->a_ray_length;
+    q->found = 0;
+    q->dist = INFINITY;
+    q->regp = REGION_NULL;
+}
+
+
+int
+rt_shootray_occluded(struct application *ap, fastf_t dist)
+{
+    struct shoot_query q;
+
+    shoot_query_init(&q, ap, 0, 1, dist);
+
+    return shootray(ap, &q);
+}
+
+
+int
+rt_shootray_first(struct application *ap, fastf_t *dist, struct region **regp)
+{
+    struct shoot_query q;
+
+    /* Which region a plain segment belongs to is only certain once
+     * overlaps with other regions have been resolved, so callers
+     * wanting the region get the full boolean evaluation */
+    shoot_query_init(&q, ap, 1, (regp == NULL), 0.0);
+
+    if (!shootray(ap, &q))
+	return 0;
+
+    if (dist)
+	*dist = q.dist;
+    if (regp)
+	*regp = q.regp;
+    return 1;
+}
+
+
 const union cutter *
 rt_cell_n_on_ray(register struct application *ap, int n)
 
@@ -0,0 +1,551 @@
+/*                       S I D E C A R . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file sidecar.c
+ *
+ * Shared, pre-converted copies of primitive data files.  See
+ * sidecar.h for an overview.
+ *
+ * A sidecar is a fixed size header, then the source file's path
+ * (NUL terminated and zero padded to keep the data aligned), then the
+ * converted data.  The header and path repeat everything the file
+ * name was hashed from, so a hash collision or a sidecar written by a
+ * host of different endianness is detected and regenerated rather
+ * than used.  Sidecars are written to a temporary file and renamed
+ * into place, so a sidecar that exists is always complete, and
+ * processes racing to create the same one are harmless.
+ *
+ * Because the source path is recorded, sidecars whose source has
+ * since been changed or removed can be found and pruned.
+ */
+
+#include "common.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef HAVE_SYS_STAT_H
+#  include <sys/stat.h>
+#endif
+
+#include "bio.h"
+
+#include "bu/app.h"
+#include "bu/file.h"
+#include "bu/hash.h"
+#include "bu/malloc.h"
+#include "bu/parallel.h"
+#include "bu/ptbl.h"
+#include "bu/process.h"
+#include "bu/str.h"
+#include "bu/time.h"
+#include "bu/vls.h"
+#include "raytrace.h"
+
+#include "./sidecar.h"
+
+
+#define SIDECAR_MAGIC "BRLSCAR"
+#define SIDECAR_VERSION 3
+#define SIDECAR_ENDIAN 0x01020304
+#define SIDECAR_KIND_LEN 80
+/* keeps the data 64 byte aligned within the mapping */
+#define SIDECAR_HDR_SIZE 128
+#define SIDECAR_PATH_SIZE(_plen) ((((size_t)(_plen) + 1 + 63) / 64) * 64)
+/* temporary files older than this (in seconds) were abandoned */
+#define SIDECAR_TMP_AGE 3600
+
+struct sidecar_hdr {
+    char magic[8];
+    uint32_t version;
+    uint32_t endian;
+    uint64_t src_size;
+    int64_t src_mtime;
+    uint64_t len;
+    uint32_t path_len;
+    uint32_t pad;
+    char kind[SIDECAR_KIND_LEN];
+};
+
+/* data attached to a mapped file's apbuf by sidecar_apbuf() */
+struct sidecar_owner {
+    const struct bu_mapped_file *mp;
+    struct bu_mapped_file *sc;	/* the sidecar holding the data, or */
+    void *buf;			/* the data, built in memory */
+};
+
+static int sidecar_pruned = 0;
+static struct bu_ptbl sidecar_owners = BU_PTBL_INIT_ZERO;	/* semaphored */
+
+
+/* returns truthfully if sidecars are enabled, with their directory in dir */
+static int
+sidecar_dir(char *dir, size_t len)
+{
+    const char *env = getenv("LIBRT_CACHE");
+
+    if (!BU_STR_EMPTY(env)) {
+	/* default unset is on, so do nothing if explicitly off */
+	if (bu_str_false(env))
+	    return 0;
+	bu_dir(dir, len, env, "sidecar", NULL);
+    } else {
+	bu_dir(dir, len, BU_DIR_CACHE, ".rt", "sidecar", NULL);
+    }
+
+    return !BU_STR_EMPTY(dir);
+}
+
+
+/* a file's modification time in nanoseconds, where the platform has
+ * them, so a rewrite within the same second is still noticed */
+static int64_t
+sidecar_stat_mtime(const struct stat *sb)
+{
+#if defined(__APPLE__)
+    return (int64_t)sb->st_mtimespec.tv_sec * 1000000000 + (int64_t)sb->st_mtimespec.tv_nsec;
+#elif defined(_WIN32)
+    return (int64_t)sb->st_mtime * 1000000000;
+#else
+    return (int64_t)sb->st_mtim.tv_sec * 1000000000 + (int64_t)sb->st_mtim.tv_nsec;
+#endif
+}
+
+
+static void
+sidecar_hdr_init(struct sidecar_hdr *hdr, const struct bu_mapped_file *src, const char *rpath, const char *kind, size_t len)
+{
+    struct stat sb;
+
+    memset(hdr, 0, sizeof(struct sidecar_hdr));
+    bu_strlcpy(hdr->magic, SIDECAR_MAGIC, sizeof(hdr->magic));
+    hdr->version = SIDECAR_VERSION;
+    hdr->endian = SIDECAR_ENDIAN;
+    hdr->src_size = (uint64_t)src->buflen;
+    if (stat(rpath, &sb) == 0)
+	hdr->src_mtime = sidecar_stat_mtime(&sb);
+    else
+	hdr->src_mtime = (int64_t)src->modtime * 1000000000;
+    hdr->len = (uint64_t)len;
+    hdr->path_len = (uint32_t)strlen(rpath);
+    bu_strlcpy(hdr->kind, kind, sizeof(hdr->kind));
+}
+
+
+/* map an existing sidecar, returning NULL if it is missing or stale */
+static struct bu_mapped_file *
+sidecar_map(const char *path, const struct bu_mapped_file *src, const char *rpath, const char *kind, size_t len)
+{
+    struct bu_mapped_file *mp;
+    struct sidecar_hdr want;
+    size_t off;
+
+    if (!bu_file_exists(path, NULL))
+	return NULL;
+
+    mp = bu_open_mapped_file(path, kind);
+    if (!mp)
+	return NULL;
+
+    sidecar_hdr_init(&want, src, rpath, kind, len);
+    off = SIDECAR_HDR_SIZE + SIDECAR_PATH_SIZE(want.path_len);
+    if (mp->buflen != off + len
+	|| memcmp(mp->buf, &want, sizeof(struct sidecar_hdr)) != 0
+	|| memcmp((char *)mp->buf + SIDECAR_HDR_SIZE, rpath, want.path_len + 1) != 0)
+    {
+	bu_close_mapped_file(mp);
+	bu_file_delete(path);
+	return NULL;
+    }
+
+    bu_semaphore_acquire(RT_SEM_MODEL);
+    if (!mp->apbuf) {
+	mp->apbuf = (void *)((char *)mp->buf + off);
+	mp->apbuflen = len;
+    }
+    bu_semaphore_release(RT_SEM_MODEL);
+
+    return mp;
+}
+
+
+/* returns truthfully if a complete sidecar was put in place at path */
+static int
+sidecar_write(const char *dir, const char *name, const char *path, const struct bu_mapped_file *src, const char *rpath, const char *kind, size_t len, sidecar_fill_t fill, void *data)
+{
+    char tmpname[MAXPATHLEN] = {0};
+    char tmppath[MAXPATHLEN] = {0};
+    char hdrbuf[SIDECAR_HDR_SIZE] = {0};
+    char *pathbuf;
+    size_t pathsize;
+    struct sidecar_hdr hdr;
+    void *buf;
+    FILE *fp;
+    int ret;
+
+    if (!bu_file_directory(dir))
+	bu_mkdir(dir);
+    if (!bu_file_directory(dir) || !bu_file_writable(dir))
+	return 0;
+
+    /* We're about to add a sidecar - once per process, clear out the
+     * ones nothing can use any more */
+    bu_semaphore_acquire(RT_SEM_MODEL);
+    if (!sidecar_pruned) {
+	sidecar_pruned = 1;
+	bu_semaphore_release(RT_SEM_MODEL);
+	(void)sidecar_prune(dir);
+    } else {
+	bu_semaphore_release(RT_SEM_MODEL);
+    }
+
+    buf = bu_malloc(len, "sidecar data");
+    if (!fill(buf, len, src, data)) {
+	bu_free(buf, "sidecar data");
+	return 0;
+    }
+
+    sidecar_hdr_init(&hdr, src, rpath, kind, len);
+    memcpy(hdrbuf, &hdr, sizeof(struct sidecar_hdr));
+    pathsize = SIDECAR_PATH_SIZE(hdr.path_len);
+    pathbuf = (char *)bu_calloc(pathsize, 1, "sidecar path");
+    memcpy(pathbuf, rpath, hdr.path_len);
+
+    snprintf(tmpname, MAXPATHLEN, "%s.%d.%d.%lld", name, bu_pid(), bu_parallel_id(), (long long int)bu_gettime());
+    bu_dir(tmppath, MAXPATHLEN, dir, tmpname, NULL);
+
+    fp = fopen(tmppath, "wb");
+    if (!fp) {
+	bu_free(pathbuf, "sidecar path");
+	bu_free(buf, "sidecar data");
+	return 0;
+    }
+    ret = (fwrite(hdrbuf, 1, SIDECAR_HDR_SIZE, fp) == SIDECAR_HDR_SIZE
+	   && fwrite(pathbuf, 1, pathsize, fp) == pathsize
+	   && fwrite(buf, 1, len, fp) == len);
+    if (fclose(fp))
+	ret = 0;
+    bu_free(pathbuf, "sidecar path");
+    bu_free(buf, "sidecar data");
+    if (!ret) {
+	bu_file_delete(tmppath);
+	return 0;
+    }
+
+    /* atomically flip it into place */
+#ifdef HAVE_WINDOWS_H
+    /* invert zero-is-failure return */
+    ret = !MoveFileEx(tmppath, path, MOVEFILE_WRITE_THROUGH | MOVEFILE_REPLACE_EXISTING);
+#else
+    ret = rename(tmppath, path);
+#endif
+    if (ret) {
+	bu_file_delete(tmppath);
+	/* someone probably beat us to it */
+	return bu_file_exists(path, NULL);
+    }
+
+    return 1;
+}
+
+
+struct bu_mapped_file *
+sidecar_open(const struct bu_mapped_file *src, const char *kind, size_t len, sidecar_fill_t fill, void *data)
+{
+    char dir[MAXPATHLEN] = {0};
+    char rpath[MAXPATHLEN] = {0};
+    char name[64] = {0};
+    char path[MAXPATHLEN] = {0};
+    struct bu_vls key = BU_VLS_INIT_ZERO;
+    struct sidecar_hdr hdr;
+    struct bu_mapped_file *mp;
+    unsigned long long hash;
+
+    if (!src || !src->name || !src->buf || !kind || !len || !fill)
+	return NULL;
+    if (strlen(kind) >= SIDECAR_KIND_LEN)
+	return NULL;
+    if (!sidecar_dir(dir, MAXPATHLEN))
+	return NULL;
+
+    if (!bu_file_realpath(src->name, rpath))
+	bu_strlcpy(rpath, src->name, MAXPATHLEN);
+    if (strlen(rpath) >= MAXPATHLEN - 1)
+	return NULL;
+
+    sidecar_hdr_init(&hdr, src, rpath, kind, len);
+    bu_vls_sprintf(&key, "%s|%s|%zu|%lld|%zu|%d|%x",
+		   rpath, kind, src->buflen, (long long)hdr.src_mtime, len,
+		   SIDECAR_VERSION, SIDECAR_ENDIAN);
+    hash = bu_data_hash(bu_vls_cstr(&key), bu_vls_strlen(&key));
+    bu_vls_free(&key);
+
+    snprintf(name, sizeof(name), "%016llx.sidecar", hash);
+    bu_dir(path, MAXPATHLEN, dir, name, NULL);
+
+    mp = sidecar_map(path, src, rpath, kind, len);
+    if (mp)
+	return mp;
+
+    if (!sidecar_write(dir, name, path, src, rpath, kind, len, fill, data))
+	return NULL;
+
+    return sidecar_map(path, src, rpath, kind, len);
+}
+
+
+static void
+sidecar_owner_free(struct sidecar_owner *o)
+{
+    if (o->sc)
+	bu_close_mapped_file(o->sc);
+    if (o->buf)
+	bu_free(o->buf, "sidecar apbuf");
+    bu_free(o, "sidecar owner");
+}
+
+
+/* Removes and returns the entry for mp, if any.  Caller must hold
+ * RT_SEM_MODEL. */
+static struct sidecar_owner *
+sidecar_owner_take(const struct bu_mapped_file *mp)
+{
+    size_t i;
+
+    if (!sidecar_owners.l.magic)
+	return NULL;
+
+    for (i = 0; i < BU_PTBL_LEN(&sidecar_owners); i++) {
+	struct sidecar_owner *o = (struct sidecar_owner *)BU_PTBL_GET(&sidecar_owners, i);
+	if (o->mp == mp) {
+	    bu_ptbl_rm(&sidecar_owners, (long *)o);
+	    return o;
+	}
+    }
+    return NULL;
+}
+
+
+void *
+sidecar_apbuf(struct bu_mapped_file *mp, const char *kind, size_t len, sidecar_fill_t fill, void *data)
+{
+    struct bu_mapped_file *sc;
+    struct sidecar_owner *o = NULL;
+    struct sidecar_owner *stale = NULL;
+    void *ret;
+
+    if (!mp || !len || !fill)
+	return NULL;
+    if (mp->apbuf)
+	return mp->apbuf;
+
+    sc = sidecar_open(mp, kind, len, fill, data);
+
+    /* Prevent a multi-processor race */
+    bu_semaphore_acquire(RT_SEM_MODEL);
+    if (!mp->apbuf) {
+	BU_ALLOC(o, struct sidecar_owner);
+	o->mp = mp;
+	if (sc) {
+	    o->sc = sc;
+	    sc = NULL;
+	} else {
+	    o->buf = bu_malloc(len, "sidecar apbuf");
+	    if (!fill(o->buf, len, mp, data)) {
+		bu_free(o->buf, "sidecar apbuf");
+		bu_free(o, "sidecar owner");
+		o = NULL;
+	    }
+	}
+	if (o) {
+	    /* anything still recorded for mp was left behind when an
+	     * earlier user released it without sidecar_close() */
+	    stale = sidecar_owner_take(mp);
+	    if (!sidecar_owners.l.magic)
+		bu_ptbl_init(&sidecar_owners, 8, "sidecar owners");
+	    bu_ptbl_ins(&sidecar_owners, (long *)o);
+	    mp->apbuflen = len;
+	    mp->apbuf = (o->sc) ? o->sc->apbuf : o->buf;
+	}
+    }
+    ret = mp->apbuf;
+    bu_semaphore_release(RT_SEM_MODEL);
+
+    /* Release outside of RT_SEM_MODEL, as sidecar_close() takes the
+     * mapped file semaphore first */
+    if (sc) {
+	/* someone else beat us */
+	bu_close_mapped_file(sc);
+    }
+    if (stale)
+	sidecar_owner_free(stale);
+
+    return ret;
+}
+
+
+void
+sidecar_close(struct bu_mapped_file *mp)
+{
+    struct sidecar_owner *o = NULL;
+
+    if (!mp)
+	return;
+
+    /* On the last use of mp, detach its data.  Nobody can pick up a
+     * new reference to mp, and with it the data, while the mapped
+     * file semaphore is held; anyone opening it afterwards finds no
+     * apbuf and attaches it again. */
+    bu_semaphore_acquire(BU_SEM_MAPPEDFILE);
+    if (mp->uses == 1) {
+	bu_semaphore_acquire(RT_SEM_MODEL);
+	o = sidecar_owner_take(mp);
+	if (o) {
+	    mp->apbuf = NULL;
+	    mp->apbuflen = 0;
+	}
+	bu_semaphore_release(RT_SEM_MODEL);
+    }
+    bu_semaphore_release(BU_SEM_MAPPEDFILE);
+
+    bu_close_mapped_file(mp);
+    if (o)
+	sidecar_owner_free(o);
+}
+
+
+/* returns truthfully if the sidecar at path was made from a source
+ * file that still exists, unchanged */
+static int
+sidecar_current(const char *path)
+{
+    struct sidecar_hdr hdr;
+    struct sidecar_hdr want;
+    char rpath[MAXPATHLEN] = {0};
+    struct stat sb;
+    FILE *fp;
+    int ret = 0;
+
+    fp = fopen(path, "rb");
+    if (!fp)
+	return 0;
+    if (fread(&hdr, sizeof(struct sidecar_hdr), 1, fp) != 1)
+	goto done;
+
+    /* anything we wouldn't have written ourselves is of no use */
+    memset(&want, 0, sizeof(struct sidecar_hdr));
+    bu_strlcpy(want.magic, SIDECAR_MAGIC, sizeof(want.magic));
+    if (memcmp(hdr.magic, want.magic, sizeof(hdr.magic)) != 0
+	|| hdr.version != SIDECAR_VERSION || hdr.endian != SIDECAR_ENDIAN
+	|| hdr.path_len == 0 || hdr.path_len >= MAXPATHLEN)
+	goto done;
+
+    if (fseek(fp, SIDECAR_HDR_SIZE, SEEK_SET)
+	|| fread(rpath, 1, hdr.path_len, fp) != hdr.path_len)
+	goto done;
+    rpath[hdr.path_len] = '\0';
+
+    if (stat(rpath, &sb) != 0)
+	goto done;
+    ret = ((uint64_t)sb.st_size == hdr.src_size && sidecar_stat_mtime(&sb) == hdr.src_mtime);
+
+done:
+    fclose(fp);
+    return ret;
+}
+
+
+size_t
+sidecar_prune(const char *dir)
+{
+    char path[MAXPATHLEN] = {0};
+    char **files = NULL;
+    size_t cnt, i;
+    size_t removed = 0;
+    time_t now = time(NULL);
+    struct stat sb;
+
+    if (!bu_file_directory(dir))
+	return 0;
+
+    cnt = bu_file_list(dir, "*.sidecar", &files);
+    for (i = 0; i < cnt; i++) {
+	bu_dir(path, MAXPATHLEN, dir, files[i], NULL);
+	if (!sidecar_current(path) && bu_file_delete(path))
+	    removed++;
+    }
+    bu_argv_free(cnt, files);
+
+    /* temporaries left behind by processes that died mid-write */
+    files = NULL;
+    cnt = bu_file_list(dir, "*.sidecar.*", &files);
+    for (i = 0; i < cnt; i++) {
+	bu_dir(path, MAXPATHLEN, dir, files[i], NULL);
+	if (stat(path, &sb) == 0 && now - sb.st_mtime > SIDECAR_TMP_AGE && bu_file_delete(path))
+	    removed++;
+    }
+    bu_argv_free(cnt, files);
+
+    return removed;
+}
+
+
+struct bu_mapped_file *
+rt_sidecar_open(const struct bu_mapped_file *src, const char *kind, size_t len, rt_sidecar_fill_t fill, void *data)
+{
+    return sidecar_open(src, kind, len, fill, data);
+}
+
+
+void *
+rt_sidecar_apbuf(struct bu_mapped_file *mp, const char *kind, size_t len, rt_sidecar_fill_t fill, void *data)
+{
+    return sidecar_apbuf(mp, kind, len, fill, data);
+}
+
+
+void
+rt_sidecar_close(struct bu_mapped_file *mp)
+{
+    sidecar_close(mp);
+}
+
+
+size_t
+rt_sidecar_prune(void)
+{
+    char dir[MAXPATHLEN] = {0};
+
+    if (!sidecar_dir(dir, MAXPATHLEN))
+	return 0;
+
+    return sidecar_prune(dir);
+}
+
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
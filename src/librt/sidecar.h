@@ -0,0 +1,104 @@
+/*                       S I D E C A R . H
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file sidecar.h
+ *
+ * Shared, pre-converted copies of primitive data files.
+ *
+ * Height field and bitmap primitives (DSP, EBM, HF) map their data
+ * files and then usually convert them - byte swapping, padding, or
+ * building acceleration structures - into a private buffer.  A
+ * sidecar holds the result of such a conversion in a file in the
+ * LIBRT cache directory.  Sidecars are mapped read-only, so every
+ * instance in a process and every process on a host shares a single
+ * copy of the converted data through the page cache.
+ *
+ * Sidecars are keyed on the source file's path, size and
+ * modification time (to the nanosecond, where the file system records
+ * it), so editing the source invalidates them.  The
+ * first time a process writes a sidecar, it also removes any whose
+ * source has changed or gone away.  They are disabled along with the rest of the cache by setting
+ * LIBRT_CACHE to a false value (e.g., LIBRT_CACHE="off").
+ */
+
+#ifndef LIBRT_SIDECAR_H
+#define LIBRT_SIDECAR_H
+
+#include "common.h"
+
+#include "bu/mapped_file.h"
+
+
+__BEGIN_DECLS
+
+/**
+ * Fills len bytes at dest with data derived from src.  Returns
+ * non-zero on success.
+ */
+typedef int (*sidecar_fill_t)(void *dest, size_t len, const struct bu_mapped_file *src, void *data);
+
+/**
+ * Returns a mapped sidecar holding len bytes derived from src, or
+ * NULL if sidecars are disabled or can't be read or written.  kind
+ * names the conversion and must include any parameters (dimensions,
+ * formats) that the result depends on besides the source file.
+ *
+ * If no valid sidecar exists, fill() is called to produce the data
+ * and the result is written to a new one.  The data is at
+ * mp->apbuf (mp->apbuflen bytes) and is read-only.  Release the
+ * sidecar with bu_close_mapped_file().
+ */
+extern struct bu_mapped_file *sidecar_open(const struct bu_mapped_file *src, const char *kind, size_t len, sidecar_fill_t fill, void *data);
+
+/**
+ * Attaches len bytes derived from mp by fill() to mp->apbuf, unless
+ * another user of mp already has, and returns mp->apbuf.  The data is
+ * taken from a sidecar (see sidecar_open()) where possible and built
+ * in memory otherwise.  Either way it belongs to mp: release mp with
+ * sidecar_close(), which releases the data along with mp's last use.
+ * Returns NULL if the data can't be built.
+ */
+extern void *sidecar_apbuf(struct bu_mapped_file *mp, const char *kind, size_t len, sidecar_fill_t fill, void *data);
+
+/**
+ * bu_close_mapped_file() for files whose apbuf was set by
+ * sidecar_apbuf().
+ */
+extern void sidecar_close(struct bu_mapped_file *mp);
+
+/**
+ * Removes the sidecars in dir whose source file has been modified or
+ * removed, and any abandoned partial writes.  Returns the number of
+ * files removed.
+ */
+extern size_t sidecar_prune(const char *dir);
+
+__END_DECLS
+
+#endif /* LIBRT_SIDECAR_H */
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
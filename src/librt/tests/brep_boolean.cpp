@@ -0,0 +1,227 @@
+/*                B R E P _ B O O L E A N . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file brep_boolean.cpp
+ *
+ * Evaluate the combinations in brep_boolean_tests.g as NURBS booleans
+ * and check the results against the CSG: the same grid of rays is
+ * shot through each combination and through the brep made from it,
+ * and the in-solid length along each ray must agree.
+ */
+
+#define NOMINMAX
+
+#include "common.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "vmath.h"
+#include "bu/app.h"
+#include "bu/log.h"
+#include "raytrace.h"
+#include "rt/comb.h"
+#include "wdb.h"
+#include "brep.h"
+
+#define GRID_SIZE 24
+/* fraction of rays allowed to disagree - rays grazing an edge can
+ * legitimately differ */
+#define GRID_MISMATCH_FRAC 0.02
+
+static int
+hit_len(struct application *ap, struct partition *PartHeadp, struct seg *UNUSED(segs))
+{
+    double *len = (double *)ap->a_uptr;
+    for (struct partition *pp = PartHeadp->pt_forw; pp != PartHeadp; pp = pp->pt_forw)
+	*len += pp->pt_outhit->hit_dist - pp->pt_inhit->hit_dist;
+    return 1;
+}
+
+
+static int
+miss_len(struct application *UNUSED(ap))
+{
+    return 0;
+}
+
+
+/* Shoot a grid of rays along each axis through the box, recording the
+ * in-solid length of each.  A NULL rtip records all zeros. */
+static void
+grid_lengths(std::vector<double> &lens, struct rt_i *rtip, const point_t min, const point_t max)
+{
+    struct application ap;
+
+    lens.clear();
+    for (int axis = 0; axis < 3; axis++) {
+	int u = (axis + 1) % 3;
+	int v = (axis + 2) % 3;
+	for (int i = 0; i < GRID_SIZE; i++) {
+	    for (int j = 0; j < GRID_SIZE; j++) {
+		double len = 0.0;
+		if (rtip) {
+		    RT_APPLICATION_INIT(&ap);
+		    ap.a_rt_i = rtip;
+		    ap.a_hit = hit_len;
+		    ap.a_miss = miss_len;
+		    ap.a_onehit = 0;
+		    ap.a_uptr = (void *)&len;
+		    ap.a_ray.r_pt[axis] = min[axis] - 1.0;
+		    ap.a_ray.r_pt[u] = min[u] + (max[u] - min[u]) * (i + 0.5) / GRID_SIZE;
+		    ap.a_ray.r_pt[v] = min[v] + (max[v] - min[v]) * (j + 0.5) / GRID_SIZE;
+		    VSETALL(ap.a_ray.r_dir, 0.0);
+		    ap.a_ray.r_dir[axis] = 1.0;
+		    (void)rt_shootray(&ap);
+		}
+		lens.push_back(len);
+	    }
+	}
+    }
+}
+
+
+static struct rt_i *
+prep_obj(struct db_i *dbip, const char *name)
+{
+    struct rt_i *rtip = rt_new_rti(dbip);
+    if (rt_gettree(rtip, name) < 0) {
+	rt_free_rti(rtip);
+	return NULL;
+    }
+    rt_prep(rtip);
+    return rtip;
+}
+
+
+static int
+check_comb(struct db_i *dbip, struct directory *dp)
+{
+    struct rt_db_internal intern;
+    struct bn_tol tol = BN_TOL_INIT_TOL;
+    std::vector<double> csg_lens, brep_lens;
+    point_t min, max;
+    int ret = 0;
+
+    if (rt_db_get_internal(&intern, dp, dbip, NULL, &rt_uniresource) < 0) {
+	bu_log("%s: unable to read\n", dp->d_namep);
+	return 1;
+    }
+
+    ON_Brep *brep = ON_Brep::New();
+    rt_comb_brep(&brep, &intern, &tol, dbip);
+    rt_db_free_internal(&intern);
+    if (!brep) {
+	bu_log("%s: boolean evaluation failed\n", dp->d_namep);
+	return 1;
+    }
+
+    struct rt_i *csg_rtip = prep_obj(dbip, dp->d_namep);
+    if (!csg_rtip) {
+	bu_log("%s: unable to prep the CSG\n", dp->d_namep);
+	delete brep;
+	return 1;
+    }
+    VMOVE(min, csg_rtip->mdl_min);
+    VMOVE(max, csg_rtip->mdl_max);
+    grid_lengths(csg_lens, csg_rtip, min, max);
+    rt_free_rti(csg_rtip);
+
+    /* An empty result (e.g. the intersection of disjoint objects)
+     * must match a CSG that nothing hits */
+    struct rt_wdb *mwdbp = NULL;
+    struct rt_i *brep_rtip = NULL;
+    if (brep->m_F.Count()) {
+	mwdbp = wdb_dbopen(db_create_inmem(), RT_WDB_TYPE_DB_INMEM);
+	if (mk_brep(mwdbp, "result.brep", (void *)brep) || !(brep_rtip = prep_obj(mwdbp->dbip, "result.brep"))) {
+	    bu_log("%s: unable to prep the boolean result\n", dp->d_namep);
+	    wdb_close(mwdbp);
+	    delete brep;
+	    return 1;
+	}
+    }
+    grid_lengths(brep_lens, brep_rtip, min, max);
+
+    double dtol = 1.0e-3 * DIST_PNT_PNT(min, max);
+    size_t mismatch = 0;
+    for (size_t i = 0; i < csg_lens.size(); i++) {
+	if (fabs(csg_lens[i] - brep_lens[i]) > dtol)
+	    mismatch++;
+    }
+    if (mismatch > GRID_MISMATCH_FRAC * csg_lens.size()) {
+	bu_log("%s: %zu of %zu rays differ between the CSG and the evaluated boolean\n", dp->d_namep, mismatch, csg_lens.size());
+	ret = 1;
+    }
+
+    if (brep_rtip)
+	rt_free_rti(brep_rtip);
+    if (mwdbp)
+	wdb_close(mwdbp);
+    delete brep;
+
+    return ret;
+}
+
+
+int
+main(int argc, const char **argv)
+{
+    struct db_i *dbip;
+    struct directory *dp;
+    int ret = 0;
+    int cnt = 0;
+
+    bu_setprogname(argv[0]);
+
+    if (argc != 2)
+	bu_exit(1, "Usage: %s brep_boolean_tests.g\n", argv[0]);
+
+    dbip = db_open(argv[1], DB_OPEN_READONLY);
+    if (dbip == DBI_NULL)
+	bu_exit(1, "ERROR: Unable to read from %s\n", argv[1]);
+    if (db_dirbuild(dbip) < 0)
+	bu_exit(1, "ERROR: Unable to read from %s\n", argv[1]);
+    db_update_nref(dbip, &rt_uniresource);
+
+    FOR_ALL_DIRECTORY_START(dp, dbip) {
+	if (!(dp->d_flags & RT_DIR_COMB) || dp->d_nref)
+	    continue;
+	cnt++;
+	ret += check_comb(dbip, dp);
+    } FOR_ALL_DIRECTORY_END;
+
+    db_close(dbip);
+
+    if (!cnt)
+	bu_exit(1, "ERROR: no test combinations found in %s\n", argv[1]);
+
+    bu_log("%d of %d boolean evaluations differ from the CSG\n", ret, cnt);
+    return (ret) ? 1 : 0;
+}
+
+
+// Local Variables:
+// tab-width: 8
+// mode: C++
+// c-basic-offset: 4
+// indent-tabs-mode: t
+// c-file-style: "stroustrup"
+// End:
+// ex: shiftwidth=4 tabstop=8
@@ -0,0 +1,341 @@
+/*                    C O M B _ C A C H E . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file comb_cache.c
+ *
+ * The comb cache must hand back the same imported comb until it is
+ * changed, keep references it has handed out valid across changes and
+ * removals, pick up modified, added and removed objects through the
+ * change callbacks, and give db_path_to_mat() and db_fp_op() the same
+ * answers they compute without it.
+ */
+
+#include "common.h"
+
+#include <string.h>
+
+#include "vmath.h"
+#include "bn/mat.h"
+#include "bu/app.h"
+#include "bu/log.h"
+#include "raytrace.h"
+#include "wdb.h"
+
+#define DIST_TOL 1.0e-6
+
+static struct bn_tol tol = BN_TOL_INIT_TOL;
+
+static const char *paths[] = {
+    "top.g",
+    "top.g/g1.g",
+    "top.g/g1.g/r1.r",
+    "top.g/g1.g/r1.r/s1.s",
+    "top.g/g1.g/r1.r/s2.s",
+    "top.g/g1.g/s3.s",
+    "top.g/g1.g/s2.s",
+    "top.g/r1.r/s1.s",
+    "top.g/r1.r/s2.s",
+    "top.g/s3.s",
+    "top.g/tmp.g/s1.s",
+    "top.g/missing.g/s1.s",
+    "top.g/missing.g/nothere.s",
+    NULL
+};
+#define NPATHS (sizeof(paths) / sizeof(paths[0]) - 1)
+
+struct path_result {
+    int found;
+    int mret;
+    mat_t mat;
+    int op;
+};
+
+static void
+eval_paths(struct path_result *r, struct db_i *dbip)
+{
+    for (size_t i = 0; i < NPATHS; i++) {
+	struct db_full_path fp;
+	db_full_path_init(&fp);
+	memset(&r[i], 0, sizeof(struct path_result));
+	r[i].found = (db_string_to_path(&fp, dbip, paths[i]) == 0);
+	if (r[i].found) {
+	    r[i].mret = db_path_to_mat(dbip, &fp, r[i].mat, 0, &rt_uniresource);
+	    r[i].op = db_fp_op(&fp, dbip, 0, &rt_uniresource);
+	}
+	db_free_full_path(&fp);
+    }
+}
+
+/* Evaluate every path with and without the cache and compare */
+static int
+check_paths(const char *stage, struct db_i *dbip)
+{
+    struct path_result cached[NPATHS], uncached[NPATHS];
+    int ret = 0;
+
+    eval_paths(cached, dbip);
+    db_comb_cache_disable(dbip);
+    eval_paths(uncached, dbip);
+    if (db_comb_cache_enable(dbip))
+	bu_exit(1, "ERROR: unable to re-enable the comb cache\n");
+
+    for (size_t i = 0; i < NPATHS; i++) {
+	struct path_result *c = &cached[i];
+	struct path_result *u = &uncached[i];
+	if (c->found != u->found || c->mret != u->mret || c->op != u->op) {
+	    bu_log("%s: %s: cached found %d, mat %d, op %d - uncached found %d, mat %d, op %d\n",
+		   stage, paths[i], c->found, c->mret, c->op, u->found, u->mret, u->op);
+	    ret++;
+	    continue;
+	}
+	if (c->found && c->mret && !bn_mat_is_equal(c->mat, u->mat, &tol)) {
+	    bu_log("%s: %s: cached and uncached path matrices differ\n", stage, paths[i]);
+	    bn_mat_print("cached", c->mat);
+	    bn_mat_print("uncached", u->mat);
+	    ret++;
+	}
+    }
+    return ret;
+}
+
+static void
+comb2(struct rt_wdb *wdbp, const char *name, const char *a, const mat_t amat, const char *b, const mat_t bmat, int bop, int region)
+{
+    struct wmember head;
+    BU_LIST_INIT(&head.l);
+    (void)mk_addmember(a, &head.l, (matp_t)amat, WMOP_UNION);
+    if (b)
+	(void)mk_addmember(b, &head.l, (matp_t)bmat, bop);
+    mk_comb(wdbp, name, &head.l, region, NULL, NULL, NULL, 0, 0, 0, 0, 0, 0, 0);
+}
+
+static void
+make_top(struct rt_wdb *wdbp, const mat_t g1mat)
+{
+    struct wmember head;
+    BU_LIST_INIT(&head.l);
+    (void)mk_addmember("g1.g", &head.l, (matp_t)g1mat, WMOP_UNION);
+    (void)mk_addmember("r1.r", &head.l, NULL, WMOP_UNION);
+    (void)mk_addmember("tmp.g", &head.l, NULL, WMOP_UNION);
+    (void)mk_addmember("missing.g", &head.l, NULL, WMOP_UNION);
+    (void)mk_addmember("s3.s", &head.l, NULL, WMOP_SUBTRACT);
+    mk_lcomb(wdbp, "top.g", &head, 0, NULL, NULL, NULL, 0);
+}
+
+static int
+check_member(const char *stage, struct db_i *dbip, const char *comb, const char *name, const mat_t emat, int eop)
+{
+    struct directory *cdp = db_lookup(dbip, comb, LOOKUP_QUIET);
+    mat_t m;
+    int op = -1;
+
+    if (!cdp || db_comb_cache_member(m, &op, dbip, cdp, name, 0, NULL) != 1) {
+	bu_log("%s: %s not found in %s\n", stage, name, comb);
+	return 1;
+    }
+    if (op != eop || !bn_mat_is_equal(m, emat, &tol)) {
+	bu_log("%s: %s in %s has op %d, expected %d, or the wrong matrix\n", stage, name, comb, op, eop);
+	return 1;
+    }
+    return 0;
+}
+
+static int
+check_bbox(const char *stage, struct db_i *dbip, const char *name, fastf_t x0, fastf_t y0, fastf_t z0, fastf_t x1, fastf_t y1, fastf_t z1)
+{
+    struct directory *dp = db_lookup(dbip, name, LOOKUP_QUIET);
+    point_t bmin, bmax, emin, emax;
+
+    VSET(emin, x0, y0, z0);
+    VSET(emax, x1, y1, z1);
+
+    if (!dp || db_comb_cache_bbox(bmin, bmax, dbip, dp, NULL) != 0) {
+	bu_log("%s: unable to bound %s\n", stage, name);
+	return 1;
+    }
+    if (!VNEAR_EQUAL(bmin, emin, DIST_TOL) || !VNEAR_EQUAL(bmax, emax, DIST_TOL)) {
+	bu_log("%s: %s bounded by (%g %g %g) (%g %g %g), expected (%g %g %g) (%g %g %g)\n",
+	       stage, name, V3ARGS(bmin), V3ARGS(bmax), V3ARGS(emin), V3ARGS(emax));
+	return 1;
+    }
+    return 0;
+}
+
+static int
+comb_has_leaf(const struct rt_db_internal *ip, const char *name)
+{
+    struct rt_comb_internal *comb = (struct rt_comb_internal *)ip->idb_ptr;
+    RT_CK_COMB(comb);
+    return (db_find_named_leaf(comb->tree, name) != TREE_NULL);
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct rt_wdb *wdbp;
+    struct db_i *dbip;
+    struct directory *dp;
+    const struct rt_db_internal *ip1, *ip2;
+    point_t min, max, center;
+    mat_t idn, m1, m2, m3;
+    int ret = 0;
+
+    bu_setprogname(argv[0]);
+
+    if (argc != 1)
+	bu_exit(1, "Usage: %s\n", argv[0]);
+
+    wdbp = wdb_dbopen(db_create_inmem(), RT_WDB_TYPE_DB_INMEM);
+    dbip = wdbp->dbip;
+    if (db_comb_cache_enable(dbip))
+	bu_exit(1, "ERROR: unable to enable the comb cache\n");
+
+    /* A hierarchy with matrices and every boolean operation */
+    VSET(center, 0, 0, 0);
+    mk_sph(wdbp, "s1.s", center, 5);
+    VSET(min, 0, 0, 0);
+    VSET(max, 4, 4, 4);
+    mk_rpp(wdbp, "s2.s", min, max);
+    VSET(center, 10, 0, 0);
+    mk_sph(wdbp, "s3.s", center, 3);
+
+    MAT_IDN(idn);
+    MAT_IDN(m1);
+    MAT_DELTAS(m1, 1, 2, 3);
+    bn_mat_angles(m2, 10, 20, 30);
+    MAT_DELTAS(m2, -4, 0, 2);
+    MAT_IDN(m3);
+    m3[15] = 0.5;
+
+    comb2(wdbp, "r1.r", "s1.s", NULL, "s2.s", m1, WMOP_SUBTRACT, 1);
+    {
+	struct wmember head;
+	BU_LIST_INIT(&head.l);
+	(void)mk_addmember("r1.r", &head.l, m2, WMOP_UNION);
+	(void)mk_addmember("s3.s", &head.l, NULL, WMOP_INTERSECT);
+	(void)mk_addmember("s2.s", &head.l, m1, WMOP_SUBTRACT);
+	mk_lcomb(wdbp, "g1.g", &head, 0, NULL, NULL, NULL, 0);
+    }
+    comb2(wdbp, "tmp.g", "s1.s", m1, NULL, NULL, 0, 0);
+    comb2(wdbp, "missing.g", "s1.s", NULL, "nothere.s", m1, WMOP_UNION, 0);
+    make_top(wdbp, m3);
+
+    ret += check_paths("initial", dbip);
+
+    /* Lookups: the same comb comes back until it is changed, and
+     * primitives aren't cached */
+    dp = db_lookup(dbip, "r1.r", LOOKUP_QUIET);
+    ip1 = db_comb_cache_get(dbip, dp, NULL);
+    ip2 = db_comb_cache_get(dbip, dp, NULL);
+    if (!ip1 || ip1 != ip2 || !comb_has_leaf(ip1, "s2.s")) {
+	bu_log("repeated lookups of r1.r returned %p and %p\n", (const void *)ip1, (const void *)ip2);
+	ret++;
+    }
+    db_comb_cache_release(dbip, ip1);
+    db_comb_cache_release(dbip, ip2);
+    if (db_comb_cache_get(dbip, db_lookup(dbip, "s1.s", LOOKUP_QUIET), NULL)) {
+	bu_log("a primitive was returned as a comb\n");
+	ret++;
+    }
+    ret += check_member("initial", dbip, "g1.g", "r1.r", m2, OP_UNION);
+    ret += check_member("initial", dbip, "g1.g", "s3.s", idn, OP_INTERSECT);
+    ret += check_member("initial", dbip, "g1.g", "s2.s", m1, OP_SUBTRACT);
+    {
+	struct directory *cdp = db_lookup(dbip, "g1.g", LOOKUP_QUIET);
+	if (db_comb_cache_member(NULL, NULL, dbip, cdp, "s1.s", 0, NULL) != 0) {
+	    bu_log("s1.s reported as a member of g1.g\n");
+	    ret++;
+	}
+    }
+
+    /* Mode 0 - a modified comb.  The reference held across the change
+     * still shows the old tree, new lookups the new one. */
+    dp = db_lookup(dbip, "r1.r", LOOKUP_QUIET);
+    ip1 = db_comb_cache_get(dbip, dp, NULL);
+    comb2(wdbp, "r1.r", "s1.s", m2, "s3.s", m1, WMOP_INTERSECT, 1);
+    ip2 = db_comb_cache_get(dbip, dp, NULL);
+    if (!ip1 || !comb_has_leaf(ip1, "s2.s")) {
+	bu_log("modified: held reference to r1.r no longer valid\n");
+	ret++;
+    }
+    if (!ip2 || ip2 == ip1 || comb_has_leaf(ip2, "s2.s") || !comb_has_leaf(ip2, "s3.s")) {
+	bu_log("modified: lookup of r1.r returned the old comb\n");
+	ret++;
+    }
+    db_comb_cache_release(dbip, ip1);
+    db_comb_cache_release(dbip, ip2);
+    ret += check_member("modified", dbip, "r1.r", "s1.s", m2, OP_UNION);
+    ret += check_member("modified", dbip, "r1.r", "s3.s", m1, OP_INTERSECT);
+    MAT_IDN(m3);
+    MAT_DELTAS(m3, 0, 0, -7);
+    make_top(wdbp, m3);
+    ret += check_paths("modified", dbip);
+
+    /* Mode 0 - a modified primitive changes the comb bounds */
+    ret += check_bbox("initial bounds", dbip, "tmp.g", -4, -3, -2, 6, 7, 8);
+    VSET(center, 0, 0, 0);
+    mk_sph(wdbp, "s1.s", center, 6);
+    ret += check_bbox("modified primitive bounds", dbip, "tmp.g", -5, -4, -3, 7, 8, 9);
+
+    /* Mode 1 - adding a missing member makes its paths valid and
+     * grows the bounds of the comb using it */
+    ret += check_bbox("missing member bounds", dbip, "missing.g", -6, -6, -6, 6, 6, 6);
+    VSET(min, 20, 20, 20);
+    VSET(max, 21, 21, 21);
+    mk_rpp(wdbp, "nothere.s", min, max);
+    ret += check_bbox("added member bounds", dbip, "missing.g", -6, -6, -6, 22, 23, 24);
+    ret += check_paths("added", dbip);
+
+    /* Mode 2 - a removed comb.  A held reference survives, and an
+     * object created under the same name isn't confused with it. */
+    dp = db_lookup(dbip, "tmp.g", LOOKUP_QUIET);
+    ip1 = db_comb_cache_get(dbip, dp, NULL);
+    if (db_delete(dbip, dp) != 0 || db_dirdelete(dbip, dp) != 0)
+	bu_exit(1, "ERROR: unable to remove tmp.g\n");
+    if (!ip1 || !comb_has_leaf(ip1, "s1.s")) {
+	bu_log("removed: held reference to tmp.g no longer valid\n");
+	ret++;
+    }
+    db_comb_cache_release(dbip, ip1);
+    ret += check_paths("removed", dbip);
+    comb2(wdbp, "tmp.g", "s3.s", NULL, NULL, NULL, 0, 0);
+    dp = db_lookup(dbip, "tmp.g", LOOKUP_QUIET);
+    ip1 = db_comb_cache_get(dbip, dp, NULL);
+    if (!ip1 || comb_has_leaf(ip1, "s1.s") || !comb_has_leaf(ip1, "s3.s")) {
+	bu_log("re-added: lookup of tmp.g returned the removed comb\n");
+	ret++;
+    }
+    db_comb_cache_release(dbip, ip1);
+    ret += check_bbox("re-added bounds", dbip, "tmp.g", 7, -3, -3, 13, 3, 3);
+    ret += check_paths("re-added", dbip);
+
+    wdb_close(wdbp);
+
+    return (ret) ? 1 : 0;
+}
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
@@ -23,8 +23,17 @@
 #include <string.h>
 
 #include "bu/app.h"
+#include "bu/file.h"
+#include "bu/str.h"
 #include "raytrace.h"
 #include "rt/db_diff.h"
+#include "wdb.h"
+
+/* Without arguments, three small databases are written and compared
+ * to check that the whole-database diffs, which skip the comparison
+ * for byte-identical objects, report the same as db_diff_dp() and
+ * db_diff3_dp() comparing each object in full. */
+static const char *self_files[3] = {"diff_left.g", "diff_ancestor.g", "diff_right.g"};
 
 void
 print_diff_summary(struct bu_ptbl *results)
@@ -67,6 +76,180 @@ print_diff_summary(struct bu_ptbl *results)
     }
 }
 
+/* which: 0 left, 1 ancestor, 2 right */
+static struct db_i *
+self_make_db(int which)
+{
+    static const char *note[3] = {"b", "a", "a"};
+    static const fastf_t edit_r[3] = {6, 5, 5};
+    static const fastf_t edit2_h[3] = {12, 10, 14};
+    fastf_t arb[24] = {
+	0, 0, 0,   10, 0, 0,   10, 10, 0,   0, 10, 0,
+	0, 0, 10,  10, 0, 10,  10, 10, 10,  0, 10, 10
+    };
+    unsigned char rgb[3] = {0, 128, 255};
+    struct rt_wdb *wdbp;
+    struct wmember head;
+    struct db_i *dbip;
+    point_t center;
+    vect_t h;
+
+    bu_file_delete(self_files[which]);
+    wdbp = wdb_fopen(self_files[which]);
+    if (!wdbp)
+	bu_exit(1, "ERROR: unable to create %s\n", self_files[which]);
+
+    /* The same everywhere */
+    VSET(center, 0, 0, 0);
+    mk_sph(wdbp, "same.s", center, 4);
+    mk_arb8(wdbp, "box.s", arb);
+    BU_LIST_INIT(&head.l);
+    (void)mk_addmember("same.s", &head.l, NULL, WMOP_UNION);
+    (void)mk_addmember("box.s", &head.l, NULL, WMOP_SUBTRACT);
+    mk_comb(wdbp, "same.r", &head.l, 1, "plastic", NULL, rgb, 1000, 0, 1, 100, 0, 0, 0);
+    db5_update_attribute("same.r", "note", "unchanged", wdbp->dbip);
+
+    /* Edited on the left */
+    mk_sph(wdbp, "edit.s", center, edit_r[which]);
+
+    /* Edited differently on each side */
+    VSET(h, 0, 0, edit2_h[which]);
+    mk_rcc(wdbp, "edit2.s", center, h, 2);
+
+    /* Only an attribute edited */
+    mk_sph(wdbp, "attr.s", center, 3);
+    db5_update_attribute("attr.s", "note", note[which], wdbp->dbip);
+
+    /* Only in the left database */
+    if (which == 0)
+	mk_sph(wdbp, "left_only.s", center, 1);
+
+    wdb_close(wdbp);
+
+    dbip = db_open(self_files[which], DB_OPEN_READONLY);
+    if (dbip == DBI_NULL || db_dirbuild(dbip) < 0)
+	bu_exit(1, "ERROR: unable to read %s\n", self_files[which]);
+    return dbip;
+}
+
+static int
+self_avps_same(const char *obj, const char *what, const struct bu_ptbl *a, const struct bu_ptbl *b)
+{
+    if (BU_PTBL_LEN(a) != BU_PTBL_LEN(b)) {
+	bu_log("%s: %zu %s entries, %zu comparing in full\n", obj, BU_PTBL_LEN(a), what, BU_PTBL_LEN(b));
+	return 0;
+    }
+    for (size_t i = 0; i < BU_PTBL_LEN(a); i++) {
+	const struct diff_avp *x = (const struct diff_avp *)BU_PTBL_GET(a, i);
+	const struct diff_avp *y = (const struct diff_avp *)BU_PTBL_GET(b, i);
+	if (!BU_STR_EQUAL(x->name, y->name) || x->state != y->state ||
+	    !BU_STR_EQUAL(x->left_value ? x->left_value : "", y->left_value ? y->left_value : "") ||
+	    !BU_STR_EQUAL(x->ancestor_value ? x->ancestor_value : "", y->ancestor_value ? y->ancestor_value : "") ||
+	    !BU_STR_EQUAL(x->right_value ? x->right_value : "", y->right_value ? y->right_value : "")) {
+	    bu_log("%s: %s entry %zu is %s (state %d), %s (state %d) comparing in full\n",
+		   obj, what, i, x->name, x->state, y->name, y->state);
+	    return 0;
+	}
+    }
+    return 1;
+}
+
+/* Compare each result with the full comparison of its objects, made
+ * the same way the whole-database diff makes it */
+static int
+self_check(const char *stage, struct bu_ptbl *results, struct db_i *dbips[3], int three_way, const struct bn_tol *tol, db_compare_criteria_t flags)
+{
+    int ret = 0;
+    int unchanged_params = 0;
+
+    for (size_t i = 0; i < BU_PTBL_LEN(results); i++) {
+	struct diff_result *dr = (struct diff_result *)BU_PTBL_GET(results, i);
+	struct diff_result ref;
+	db_compare_criteria_t passes[2] = {DB_COMPARE_PARAM, DB_COMPARE_ATTRS};
+
+	diff_init_result(&ref, tol, dr->obj_name);
+	for (int p = 0; p < 2; p++) {
+	    if (flags != DB_COMPARE_ALL && !(flags & passes[p]))
+		continue;
+	    if (three_way) {
+		db_diff3_dp(dbips[0], dbips[1], dbips[2], dr->dp_left, dr->dp_ancestor, dr->dp_right, tol, passes[p], &ref);
+	    } else {
+		db_diff_dp(dbips[0], dbips[2], dr->dp_left, dr->dp_right, tol, passes[p], &ref);
+	    }
+	}
+
+	if (dr->param_state != ref.param_state || dr->attr_state != ref.attr_state) {
+	    bu_log("%s: %s: states %d/%d, %d/%d comparing in full\n", stage, dr->obj_name,
+		   dr->param_state, dr->attr_state, ref.param_state, ref.attr_state);
+	    ret++;
+	}
+	if (!self_avps_same(dr->obj_name, "parameter", dr->param_diffs, ref.param_diffs))
+	    ret++;
+	if (!self_avps_same(dr->obj_name, "attribute", dr->attr_diffs, ref.attr_diffs))
+	    ret++;
+	if (BU_STR_EQUAL(dr->obj_name, "same.s") && BU_PTBL_LEN(dr->param_diffs))
+	    unchanged_params = 1;
+
+	diff_free_result(&ref);
+    }
+
+    /* gdiff lists the unchanged parameters of identical objects */
+    if ((flags == DB_COMPARE_ALL || flags & DB_COMPARE_PARAM) && !unchanged_params) {
+	bu_log("%s: no unchanged parameters listed for an identical object\n", stage);
+	ret++;
+    }
+    return ret;
+}
+
+static void
+self_free_results(struct bu_ptbl *results)
+{
+    for (size_t i = 0; i < BU_PTBL_LEN(results); i++) {
+	struct diff_result *result = (struct diff_result *)BU_PTBL_GET(results, i);
+	diff_free_result(result);
+	BU_PUT(result, struct diff_result);
+    }
+    bu_ptbl_reset(results);
+}
+
+static int
+self_test(void)
+{
+    struct db_i *dbips[3];
+    struct bu_ptbl results;
+    struct bn_tol tol = BN_TOL_INIT_TOL;
+    db_compare_criteria_t flags[3] = {DB_COMPARE_ALL, DB_COMPARE_PARAM, DB_COMPARE_ATTRS};
+    const char *fnames[3] = {"all", "parameters", "attributes"};
+    char stage[64];
+    int ret = 0;
+
+    for (int i = 0; i < 3; i++)
+	dbips[i] = self_make_db(i);
+
+    BU_PTBL_INIT(&results);
+    for (int f = 0; f < 3; f++) {
+	snprintf(stage, sizeof(stage), "db_diff %s", fnames[f]);
+	db_diff(dbips[0], dbips[2], &tol, flags[f], &results);
+	ret += self_check(stage, &results, dbips, 0, &tol, flags[f]);
+	self_free_results(&results);
+
+	snprintf(stage, sizeof(stage), "db_diff3 %s", fnames[f]);
+	db_diff3(dbips[0], dbips[1], dbips[2], &tol, flags[f], &results);
+	ret += self_check(stage, &results, dbips, 1, &tol, flags[f]);
+	self_free_results(&results);
+    }
+    bu_ptbl_free(&results);
+
+    for (int i = 0; i < 3; i++) {
+	db_close(dbips[i]);
+	bu_file_delete(self_files[i]);
+    }
+
+    if (ret)
+	bu_log("%d diff checks failed\n", ret);
+    return (ret) ? 1 : 0;
+}
+
 int
 main(int argc, char **argv)
 {
@@ -80,6 +263,9 @@ main(int argc, char **argv)
 
     bu_setprogname(argv[0]);
 
+    if (argc == 1)
+	return self_test();
+
     BU_GET(diff_tol, struct bn_tol);
     diff_tol->dist = BN_TOL_DIST;
 
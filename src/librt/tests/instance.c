@@ -0,0 +1,319 @@
+/*                      I N S T A N C E . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file instance.c
+ *
+ * A BoT placed under several rigid matrices shares one prototype prep
+ * among its later placements.  Shooting the model must give the same
+ * partitions, hit distances and normals as an rt_i with
+ * rti_dont_instance set, where every placement gets a full prep.
+ */
+
+#include "common.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "vmath.h"
+#include "bu/app.h"
+#include "bu/file.h"
+#include "bu/log.h"
+#include "bu/str.h"
+#include "bn/mat.h"
+#include "raytrace.h"
+#include "wdb.h"
+
+#define INSTANCE_TEST_FILE "instance_test.g"
+#define GRID_SIZE 24
+#define MAX_PARTS 16
+#define DIST_TOL 1.0e-6
+#define NORM_TOL 1.0e-6
+
+struct ray_parts {
+    int cnt;
+    fastf_t in[MAX_PARTS];
+    fastf_t out[MAX_PARTS];
+    vect_t in_norm[MAX_PARTS];
+    vect_t out_norm[MAX_PARTS];
+    const char *reg[MAX_PARTS];
+};
+
+static int
+parts_hit(struct application *ap, struct partition *PartHeadp, struct seg *UNUSED(segs))
+{
+    struct ray_parts *rp = (struct ray_parts *)ap->a_uptr;
+    struct partition *pp;
+
+    for (pp = PartHeadp->pt_forw; pp != PartHeadp && rp->cnt < MAX_PARTS; pp = pp->pt_forw) {
+	rp->in[rp->cnt] = pp->pt_inhit->hit_dist;
+	rp->out[rp->cnt] = pp->pt_outhit->hit_dist;
+	RT_HIT_NORMAL(rp->in_norm[rp->cnt], pp->pt_inhit, pp->pt_inseg->seg_stp, &ap->a_ray, pp->pt_inflip);
+	RT_HIT_NORMAL(rp->out_norm[rp->cnt], pp->pt_outhit, pp->pt_outseg->seg_stp, &ap->a_ray, pp->pt_outflip);
+	rp->reg[rp->cnt] = pp->pt_regionp->reg_name;
+	rp->cnt++;
+    }
+    return 1;
+}
+
+static int
+parts_miss(struct application *UNUSED(ap))
+{
+    return 0;
+}
+
+static void
+shoot(struct ray_parts *rp, struct rt_i *rtip, const point_t pt, const vect_t dir)
+{
+    struct application ap;
+
+    RT_APPLICATION_INIT(&ap);
+    ap.a_rt_i = rtip;
+    ap.a_resource = &rt_uniresource;
+    ap.a_hit = parts_hit;
+    ap.a_miss = parts_miss;
+    ap.a_onehit = 0;
+    ap.a_logoverlap = rt_silent_logoverlap;
+    ap.a_uptr = (void *)rp;
+    VMOVE(ap.a_ray.r_pt, pt);
+    VMOVE(ap.a_ray.r_dir, dir);
+    rp->cnt = 0;
+    (void)rt_shootray(&ap);
+}
+
+static int
+compare_ray(struct rt_i *inst, struct rt_i *full, const point_t pt, const vect_t dir, int *nhits)
+{
+    struct ray_parts a, b;
+
+    shoot(&a, inst, pt, dir);
+    shoot(&b, full, pt, dir);
+
+    if (a.cnt != b.cnt) {
+	bu_log("ray (%g %g %g) dir (%g %g %g): %d partitions instanced, %d without instancing\n",
+	       V3ARGS(pt), V3ARGS(dir), a.cnt, b.cnt);
+	return 1;
+    }
+    for (int i = 0; i < a.cnt; i++) {
+	if (!NEAR_EQUAL(a.in[i], b.in[i], DIST_TOL) || !NEAR_EQUAL(a.out[i], b.out[i], DIST_TOL) || !BU_STR_EQUAL(a.reg[i], b.reg[i])) {
+	    bu_log("ray (%g %g %g) dir (%g %g %g): partition %d is %s %g-%g instanced, %s %g-%g without instancing\n",
+		   V3ARGS(pt), V3ARGS(dir), i, a.reg[i], a.in[i], a.out[i], b.reg[i], b.in[i], b.out[i]);
+	    return 1;
+	}
+	if (!VNEAR_EQUAL(a.in_norm[i], b.in_norm[i], NORM_TOL) || !VNEAR_EQUAL(a.out_norm[i], b.out_norm[i], NORM_TOL)) {
+	    bu_log("ray (%g %g %g) dir (%g %g %g): partition %d normals differ: (%g %g %g) (%g %g %g) instanced, (%g %g %g) (%g %g %g) without instancing\n",
+		   V3ARGS(pt), V3ARGS(dir), i, V3ARGS(a.in_norm[i]), V3ARGS(a.out_norm[i]), V3ARGS(b.in_norm[i]), V3ARGS(b.out_norm[i]));
+	    return 1;
+	}
+    }
+    *nhits += a.cnt;
+    return 0;
+}
+
+static struct rt_i *
+prep_all(struct db_i *dbip, int dont_instance)
+{
+    struct rt_i *rtip = rt_new_rti(dbip);
+    rtip->rti_dont_instance = dont_instance;
+    if (rt_gettree(rtip, "all.g") < 0)
+	bu_exit(1, "ERROR: unable to load the test geometry\n");
+    rt_prep(rtip);
+    return rtip;
+}
+
+/* Soltabs set up as instances dispatch through something other than
+ * their type's own functab */
+static int
+count_instances(struct rt_i *rtip)
+{
+    struct soltab *stp;
+    int cnt = 0;
+    RT_VISIT_ALL_SOLTABS_START(stp, rtip) {
+	if (stp->st_meth != &OBJ[stp->st_id])
+	    cnt++;
+    } RT_VISIT_ALL_SOLTABS_END
+    return cnt;
+}
+
+static void
+placement(struct rt_wdb *wdbp, const char *name, mat_t m, const char *hole, int id)
+{
+    struct wmember head;
+    BU_LIST_INIT(&head.l);
+    (void)mk_addmember("bot.s", &head.l, m, WMOP_UNION);
+    if (hole)
+	(void)mk_addmember(hole, &head.l, NULL, WMOP_SUBTRACT);
+    mk_comb(wdbp, name, &head.l, 1, NULL, NULL, NULL, id, 0, 0, 100, 0, 0, 0);
+}
+
+static void
+make_geometry(struct rt_wdb *wdbp)
+{
+    /* A lopsided octahedron, so a wrongly oriented placement shows */
+    fastf_t verts[] = {
+	12, 0, 0,   -4, 0, 0,
+	0, 7, 0,    0, -3, 0,
+	0, 0, 9,    0, 0, -5
+    };
+    int faces[] = {
+	0, 2, 4,   2, 1, 4,   1, 3, 4,   3, 0, 4,
+	2, 0, 5,   1, 2, 5,   3, 1, 5,   0, 3, 5
+    };
+    struct wmember head;
+    point_t center;
+    mat_t m;
+    char name[32];
+    int id = 1;
+
+    mk_bot(wdbp, "bot.s", RT_BOT_SOLID, RT_BOT_CCW, 0, 6, 8, verts, faces, NULL, NULL);
+
+    /* The original placement */
+    MAT_IDN(m);
+    placement(wdbp, "p0.r", m, NULL, id++);
+
+    /* Moved */
+    MAT_DELTAS(m, 40, 0, 0);
+    placement(wdbp, "p1.r", m, NULL, id++);
+
+    /* Turned about Z and moved */
+    bn_mat_angles(m, 0, 0, 90);
+    MAT_DELTAS(m, 0, 40, 0);
+    placement(wdbp, "p2.r", m, NULL, id++);
+
+    /* Turned about all three axes and moved */
+    bn_mat_angles(m, 30, 45, 17);
+    MAT_DELTAS(m, 40, 40, 20);
+    placement(wdbp, "p3.r", m, NULL, id++);
+
+    /* Turned and moved, with a hole cut through it */
+    bn_mat_angles(m, -60, 10, 120);
+    MAT_DELTAS(m, -40, 10, -20);
+    VSET(center, -38, 10, -20);
+    mk_sph(wdbp, "hole.s", center, 3);
+    placement(wdbp, "p4.r", m, "hole.s", id++);
+
+    /* Scaled, which is not rigid and must be prepped in full */
+    MAT_IDN(m);
+    m[0] = m[5] = m[10] = 1.5;
+    MAT_DELTAS(m, 0, -40, 0);
+    placement(wdbp, "p5.r", m, NULL, id++);
+
+    /* Mirrored, likewise */
+    MAT_IDN(m);
+    m[0] = -1;
+    MAT_DELTAS(m, -40, -40, 0);
+    placement(wdbp, "p6.r", m, NULL, id++);
+
+    /* The same placement again under a second matrix, from a group */
+    BU_LIST_INIT(&head.l);
+    MAT_IDN(m);
+    MAT_DELTAS(m, 0, 0, 40);
+    (void)mk_addmember("p2.r", &head.l, m, WMOP_UNION);
+    mk_lcomb(wdbp, "up.g", &head, 0, NULL, NULL, NULL, 0);
+
+    BU_LIST_INIT(&head.l);
+    for (int i = 0; i < 7; i++) {
+	snprintf(name, sizeof(name), "p%d.r", i);
+	(void)mk_addmember(name, &head.l, NULL, WMOP_UNION);
+    }
+    (void)mk_addmember("up.g", &head.l, NULL, WMOP_UNION);
+    mk_lcomb(wdbp, "all.g", &head, 0, NULL, NULL, NULL, 0);
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct rt_wdb *wdbp;
+    struct rt_i *inst, *full;
+    point_t min, max, pt;
+    vect_t dir;
+    int nhits = 0;
+    int ret = 0;
+
+    bu_setprogname(argv[0]);
+
+    if (argc != 1)
+	bu_exit(1, "Usage: %s\n", argv[0]);
+
+    bu_file_delete(INSTANCE_TEST_FILE);
+    wdbp = wdb_fopen(INSTANCE_TEST_FILE);
+    if (!wdbp)
+	bu_exit(1, "ERROR: unable to create %s\n", INSTANCE_TEST_FILE);
+    make_geometry(wdbp);
+
+    inst = prep_all(wdbp->dbip, 0);
+    full = prep_all(wdbp->dbip, 1);
+
+    if (!count_instances(inst)) {
+	bu_log("no placement was set up as an instance\n");
+	ret++;
+    }
+    if (count_instances(full)) {
+	bu_log("placements were instanced with rti_dont_instance set\n");
+	ret++;
+    }
+
+    VMOVE(min, full->mdl_min);
+    VMOVE(max, full->mdl_max);
+    for (int axis = 0; axis < 3; axis++) {
+	int u = (axis + 1) % 3;
+	int v = (axis + 2) % 3;
+	for (int sgn = -1; sgn <= 1; sgn += 2) {
+	    for (int i = 0; i < GRID_SIZE; i++) {
+		for (int j = 0; j < GRID_SIZE; j++) {
+		    VSETALL(dir, 0.0);
+		    dir[axis] = sgn;
+		    pt[axis] = (sgn > 0) ? min[axis] - 1.0 : max[axis] + 1.0;
+		    pt[u] = min[u] + (max[u] - min[u]) * (i + 0.5) / GRID_SIZE;
+		    pt[v] = min[v] + (max[v] - min[v]) * (j + 0.5) / GRID_SIZE;
+		    ret += compare_ray(inst, full, pt, dir, &nhits);
+		}
+	    }
+	}
+    }
+    for (int i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+	VSET(pt, min[X] - 5.0, min[Y] + (max[Y] - min[Y]) * (i % GRID_SIZE + 0.5) / GRID_SIZE, min[Z] - 5.0);
+	VSET(dir, 1.0, 0.4 * (i / GRID_SIZE) / GRID_SIZE - 0.2, 0.3);
+	VUNITIZE(dir);
+	ret += compare_ray(inst, full, pt, dir, &nhits);
+    }
+
+    if (!nhits) {
+	bu_log("no rays hit the test geometry\n");
+	ret++;
+    }
+
+    rt_free_rti(inst);
+    rt_free_rti(full);
+    wdb_close(wdbp);
+    bu_file_delete(INSTANCE_TEST_FILE);
+
+    if (ret)
+	bu_log("%d instanced shot checks failed\n", ret);
+    return (ret) ? 1 : 0;
+}
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
@@ -0,0 +1,316 @@
+/*                        R E P R E P . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file reprep.c
+ *
+ * An rt_i watched with rt_reprep_watch() and brought up to date with
+ * rt_reprep_pending() after each edit must report the same partitions
+ * as an rt_i freshly prepped from the edited database, whether the
+ * edit was patched into the cut tree in place or forced a rebuild.
+ */
+
+#include "common.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "vmath.h"
+#include "bu/app.h"
+#include "bu/file.h"
+#include "bu/log.h"
+#include "bu/str.h"
+#include "raytrace.h"
+#include "wdb.h"
+
+#define REPREP_TEST_FILE "reprep_test.g"
+#define GRID_SIZE 20
+#define MAX_PARTS 16
+#define DIST_TOL 1.0e-6
+
+struct ray_parts {
+    int cnt;
+    fastf_t in[MAX_PARTS];
+    fastf_t out[MAX_PARTS];
+    const char *reg[MAX_PARTS];
+};
+
+static int
+parts_hit(struct application *ap, struct partition *PartHeadp, struct seg *UNUSED(segs))
+{
+    struct ray_parts *rp = (struct ray_parts *)ap->a_uptr;
+    struct partition *pp;
+
+    for (pp = PartHeadp->pt_forw; pp != PartHeadp && rp->cnt < MAX_PARTS; pp = pp->pt_forw) {
+	rp->in[rp->cnt] = pp->pt_inhit->hit_dist;
+	rp->out[rp->cnt] = pp->pt_outhit->hit_dist;
+	rp->reg[rp->cnt] = pp->pt_regionp->reg_name;
+	rp->cnt++;
+    }
+    return 1;
+}
+
+static int
+parts_miss(struct application *UNUSED(ap))
+{
+    return 0;
+}
+
+static void
+shoot(struct ray_parts *rp, struct rt_i *rtip, const point_t pt, const vect_t dir)
+{
+    struct application ap;
+
+    RT_APPLICATION_INIT(&ap);
+    ap.a_rt_i = rtip;
+    ap.a_resource = &rt_uniresource;
+    ap.a_hit = parts_hit;
+    ap.a_miss = parts_miss;
+    ap.a_onehit = 0;
+    ap.a_logoverlap = rt_silent_logoverlap;
+    ap.a_uptr = (void *)rp;
+    VMOVE(ap.a_ray.r_pt, pt);
+    VMOVE(ap.a_ray.r_dir, dir);
+    rp->cnt = 0;
+    (void)rt_shootray(&ap);
+}
+
+static int
+compare_ray(const char *stage, struct rt_i *watched, struct rt_i *fresh, const point_t pt, const vect_t dir)
+{
+    struct ray_parts a, b;
+
+    shoot(&a, watched, pt, dir);
+    shoot(&b, fresh, pt, dir);
+
+    if (a.cnt != b.cnt) {
+	bu_log("%s: ray (%g %g %g) dir (%g %g %g): %d partitions after reprep, %d after a full prep\n",
+	       stage, V3ARGS(pt), V3ARGS(dir), a.cnt, b.cnt);
+	return 1;
+    }
+    for (int i = 0; i < a.cnt; i++) {
+	if (!NEAR_EQUAL(a.in[i], b.in[i], DIST_TOL) || !NEAR_EQUAL(a.out[i], b.out[i], DIST_TOL) || !BU_STR_EQUAL(a.reg[i], b.reg[i])) {
+	    bu_log("%s: ray (%g %g %g) dir (%g %g %g): partition %d is %s %g-%g after reprep, %s %g-%g after a full prep\n",
+		   stage, V3ARGS(pt), V3ARGS(dir), i, a.reg[i], a.in[i], a.out[i], b.reg[i], b.in[i], b.out[i]);
+	    return 1;
+	}
+    }
+    return 0;
+}
+
+static struct rt_i *
+prep_all(struct db_i *dbip)
+{
+    struct rt_i *rtip = rt_new_rti(dbip);
+    if (rt_gettree(rtip, "all.g") < 0)
+	bu_exit(1, "ERROR: unable to load the test geometry\n");
+    rt_prep(rtip);
+    return rtip;
+}
+
+/* Bring the watched rt_i up to date and compare it, ray for ray, with
+ * a fresh prep of the same database */
+static int
+check_stage(const char *stage, struct rt_i *watched, int expected)
+{
+    struct rt_i *fresh;
+    point_t min, max, pt;
+    vect_t dir;
+    int ret = 0;
+    int pending = rt_reprep_pending(watched, NULL);
+
+    if (pending != expected) {
+	bu_log("%s: rt_reprep_pending() returned %d, expected %d\n", stage, pending, expected);
+	ret++;
+    }
+
+    fresh = prep_all(watched->rti_dbip);
+
+    /* The watched model RPP may be larger than the fresh one, never
+     * smaller, so shoot across the union of both */
+    VMOVE(min, fresh->mdl_min);
+    VMOVE(max, fresh->mdl_max);
+    VMIN(min, watched->mdl_min);
+    VMAX(max, watched->mdl_max);
+    for (int axis = 0; axis < 3; axis++) {
+	int u = (axis + 1) % 3;
+	int v = (axis + 2) % 3;
+	for (int sgn = -1; sgn <= 1; sgn += 2) {
+	    for (int i = 0; i < GRID_SIZE; i++) {
+		for (int j = 0; j < GRID_SIZE; j++) {
+		    VSETALL(dir, 0.0);
+		    dir[axis] = sgn;
+		    pt[axis] = (sgn > 0) ? min[axis] - 1.0 : max[axis] + 1.0;
+		    pt[u] = min[u] + (max[u] - min[u]) * (i + 0.5) / GRID_SIZE;
+		    pt[v] = min[v] + (max[v] - min[v]) * (j + 0.5) / GRID_SIZE;
+		    ret += compare_ray(stage, watched, fresh, pt, dir);
+		}
+	    }
+	}
+    }
+    for (int i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+	VSET(pt, min[X] - 5.0, min[Y] + (max[Y] - min[Y]) * (i % GRID_SIZE + 0.5) / GRID_SIZE, min[Z] - 5.0);
+	VSET(dir, 1.0, 0.2 * (i / GRID_SIZE) / GRID_SIZE, 0.3);
+	VUNITIZE(dir);
+	ret += compare_ray(stage, watched, fresh, pt, dir);
+    }
+
+    rt_free_rti(fresh);
+    return ret;
+}
+
+static void
+region(struct rt_wdb *wdbp, const char *name, const char *a, const char *b, int id)
+{
+    struct wmember head;
+    BU_LIST_INIT(&head.l);
+    (void)mk_addmember(a, &head.l, NULL, WMOP_UNION);
+    if (b)
+	(void)mk_addmember(b, &head.l, NULL, WMOP_SUBTRACT);
+    mk_comb(wdbp, name, &head.l, 1, NULL, NULL, NULL, id, 0, 0, 100, 0, 0, 0);
+}
+
+static void
+make_geometry(struct rt_wdb *wdbp)
+{
+    point_t min, max, center;
+    struct wmember head, chead;
+    struct wmember *wm;
+
+    VSET(center, 0, 0, 0);
+    mk_sph(wdbp, "a.s", center, 5);
+    region(wdbp, "a.r", "a.s", NULL, 1);
+
+    VSET(min, 10, 0, 0);
+    VSET(max, 20, 10, 10);
+    mk_rpp(wdbp, "b.s", min, max);
+    VSET(center, 15, 5, 5);
+    mk_sph(wdbp, "b_hole.s", center, 3);
+    region(wdbp, "b.r", "b.s", "b_hole.s", 2);
+
+    /* One primitive instanced twice, so it has two soltabs */
+    VSET(center, 0, 20, 0);
+    mk_sph(wdbp, "c.s", center, 3);
+    region(wdbp, "c.r", "c.s", NULL, 3);
+
+    BU_LIST_INIT(&chead.l);
+    wm = mk_addmember("c.r", &chead.l, NULL, WMOP_UNION);
+    MAT_DELTAS(wm->wm_mat, 0, 0, 10);
+    mk_lcomb(wdbp, "c2.g", &chead, 0, NULL, NULL, NULL, 0);
+
+    BU_LIST_INIT(&head.l);
+    (void)mk_addmember("a.r", &head.l, NULL, WMOP_UNION);
+    (void)mk_addmember("b.r", &head.l, NULL, WMOP_UNION);
+    (void)mk_addmember("c.r", &head.l, NULL, WMOP_UNION);
+    (void)mk_addmember("c2.g", &head.l, NULL, WMOP_UNION);
+    mk_lcomb(wdbp, "all.g", &head, 0, NULL, NULL, NULL, 0);
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct rt_wdb *wdbp;
+    struct rt_i *rtip;
+    const char *tops[] = {"all.g"};
+    point_t min, max, center;
+    int ret = 0;
+
+    bu_setprogname(argv[0]);
+
+    if (argc != 1)
+	bu_exit(1, "Usage: %s\n", argv[0]);
+
+    bu_file_delete(REPREP_TEST_FILE);
+    wdbp = wdb_fopen(REPREP_TEST_FILE);
+    if (!wdbp)
+	bu_exit(1, "ERROR: unable to create %s\n", REPREP_TEST_FILE);
+    make_geometry(wdbp);
+
+    rtip = prep_all(wdbp->dbip);
+    if (rt_reprep_watch(rtip, 1, tops, 1))
+	bu_exit(1, "ERROR: rt_reprep_watch() failed\n");
+
+    ret += check_stage("unedited", rtip, 0);
+
+    /* A primitive edit inside the model bounds */
+    VSET(center, 1, 1, 0);
+    mk_sph(wdbp, "a.s", center, 4);
+    ret += check_stage("sphere moved", rtip, 1);
+
+    /* Several primitives at once, one used by a subtraction */
+    VSET(min, 10, -2, 0);
+    VSET(max, 22, 10, 12);
+    mk_rpp(wdbp, "b.s", min, max);
+    VSET(center, 16, 4, 6);
+    mk_sph(wdbp, "b_hole.s", center, 2);
+    ret += check_stage("box and hole edited", rtip, 1);
+
+    /* Both instances of a primitive move */
+    VSET(center, 2, 18, 1);
+    mk_sph(wdbp, "c.s", center, 4);
+    ret += check_stage("instanced sphere edited", rtip, 1);
+
+    /* Growing the model RPP stretches the outer cells */
+    VSET(min, 10, -2, 0);
+    VSET(max, 60, 10, 40);
+    mk_rpp(wdbp, "b.s", min, max);
+    ret += check_stage("model bounds grown", rtip, 1);
+
+    /* Shrinking it back leaves the cut tree larger than needed */
+    VSET(min, 10, 0, 0);
+    VSET(max, 20, 10, 10);
+    mk_rpp(wdbp, "b.s", min, max);
+    ret += check_stage("model bounds shrunk", rtip, 1);
+
+    /* A combination edit can't be patched */
+    region(wdbp, "a.r", "a.s", "c.s", 1);
+    ret += check_stage("region edited", rtip, 2);
+
+    /* The rebuild must leave the watch working */
+    VSET(center, -1, 0, 1);
+    mk_sph(wdbp, "a.s", center, 6);
+    ret += check_stage("sphere edited after rebuild", rtip, 1);
+
+    /* A primitive changing type, which can't be patched either */
+    VSET(min, -3, -3, -3);
+    VSET(max, 3, 3, 3);
+    mk_rpp(wdbp, "a.s", min, max);
+    ret += check_stage("primitive type changed", rtip, 2);
+
+    /* Objects outside the watched tree are ignored */
+    VSET(center, 100, 100, 100);
+    mk_sph(wdbp, "unused.s", center, 1);
+    mk_sph(wdbp, "unused.s", center, 2);
+    ret += check_stage("unrelated edit", rtip, 0);
+
+    rt_free_rti(rtip);
+    wdb_close(wdbp);
+    bu_file_delete(REPREP_TEST_FILE);
+
+    return (ret) ? 1 : 0;
+}
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
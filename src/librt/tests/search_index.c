@@ -0,0 +1,201 @@
+/*                S E A R C H _ I N D E X . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+
+#include "common.h"
+
+#include "vmath.h"
+#include "bu/app.h"
+#include "bu/file.h"
+#include "raytrace.h"
+#include "wdb.h"
+
+#define SEARCH_INDEX_TEST_FILE "search_index_test.g"
+
+static int
+search_cnt(struct db_i *dbip, const char *plan)
+{
+    struct bu_ptbl results = BU_PTBL_INIT_ZERO;
+    int cnt = db_search(&results, DB_SEARCH_FLAT | DB_SEARCH_QUIET, plan, 0, NULL, dbip, NULL, NULL, NULL);
+    db_search_free(&results);
+    return cnt;
+}
+
+/* A parallel search must return exactly what a serial one does, in
+ * the same order */
+static int
+compare_parallel(struct db_i *dbip, const char **plans)
+{
+    int ret = 0;
+    for (int i = 0; plans[i]; i++) {
+	struct bu_ptbl sresults = BU_PTBL_INIT_ZERO;
+	struct bu_ptbl presults = BU_PTBL_INIT_ZERO;
+	int scnt = db_search(&sresults, DB_SEARCH_FLAT | DB_SEARCH_QUIET, plans[i], 0, NULL, dbip, NULL, NULL, NULL);
+	int pcnt = db_search(&presults, DB_SEARCH_FLAT | DB_SEARCH_QUIET | DB_SEARCH_PARALLEL, plans[i], 0, NULL, dbip, NULL, NULL, NULL);
+	if (scnt != pcnt || BU_PTBL_LEN(&sresults) != BU_PTBL_LEN(&presults)) {
+	    bu_log("%s: serial search found %d, parallel search found %d\n", plans[i], scnt, pcnt);
+	    ret = 1;
+	} else {
+	    for (size_t j = 0; j < BU_PTBL_LEN(&sresults); j++) {
+		if (BU_PTBL_GET(&sresults, j) != BU_PTBL_GET(&presults, j)) {
+		    bu_log("%s: parallel search result order differs at %zu\n", plans[i], j);
+		    ret = 1;
+		    break;
+		}
+	    }
+	}
+	db_search_free(&sresults);
+	db_search_free(&presults);
+    }
+    return ret;
+}
+
+static int
+compare_searches(struct db_i *dbip, const char **plans)
+{
+    int ret = 0;
+    for (int i = 0; plans[i]; i++) {
+	db_search_index_disable(dbip);
+	int expected = search_cnt(dbip, plans[i]);
+	db_search_index_enable(dbip);
+	/* Run twice - once to populate the index, once from it */
+	int first = search_cnt(dbip, plans[i]);
+	int second = search_cnt(dbip, plans[i]);
+	if (first != expected || second != expected) {
+	    bu_log("%s: expected %d, got %d (populating) and %d (indexed)\n", plans[i], expected, first, second);
+	    ret = 1;
+	}
+    }
+    return ret;
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct rt_wdb *wdbp;
+    struct db_i *dbip;
+    point_t center = VINIT_ZERO;
+    fastf_t pts[24] = {
+	0, 0, 0,  1, 0, 0,  1, 1, 0,  0, 1, 0,
+	0, 0, 1,  1, 0, 1,  1, 1, 1,  0, 1, 1
+    };
+    const char *plans[] = {
+	"-attr material_id",
+	"-attr material_id=5",
+	"-attr material_id>3",
+	"-attr mat*",
+	"-attr color=red",
+	"-stdattr",
+	"-type sph",
+	"-type arb8",
+	"-type shape",
+	"-type volume",
+	"-type plate",
+	"-type comb",
+	"-attr material_id -type sph",
+	NULL
+    };
+    int ret = 0;
+    int red_cnt;
+
+    bu_setprogname(argv[0]);
+
+    if (argc != 1)
+	bu_exit(1, "Usage: %s\n", argv[0]);
+
+    wdbp = wdb_fopen(SEARCH_INDEX_TEST_FILE);
+    if (!wdbp)
+	bu_exit(1, "ERROR: Unable to create %s\n", SEARCH_INDEX_TEST_FILE);
+    dbip = wdbp->dbip;
+
+    /* Enough objects that db_search will actually use threads when
+     * asked to */
+    for (int i = 0; i < 200; i++) {
+	char name[32];
+	snprintf(name, 32, "s%d.s", i);
+	center[X] = i;
+	mk_sph(wdbp, name, center, 1.0);
+	if (i % 2) {
+	    char val[32];
+	    snprintf(val, 32, "%d", i);
+	    db5_update_attribute(name, "material_id", val, dbip);
+	}
+	snprintf(name, 32, "a%d.s", i);
+	mk_arb8(wdbp, name, pts);
+	if (i % 3 == 0)
+	    db5_update_attribute(name, "color", "red", dbip);
+    }
+
+    ret += compare_searches(dbip, plans);
+    ret += compare_parallel(dbip, plans);
+    red_cnt = search_cnt(dbip, "-attr color=red");
+
+    /* Edits to objects must be reflected in the index */
+    db5_update_attribute("s1.s", "material_id", "7", dbip);
+    db5_update_attribute("s2.s", "material_id", "5", dbip);
+    db5_update_attribute("a3.s", "color", "blue", dbip);
+    if (search_cnt(dbip, "-attr material_id=5") != 2) {
+	bu_log("index not updated after attribute edit\n");
+	ret = 1;
+    }
+    if (search_cnt(dbip, "-attr color=red") != red_cnt - 1) {
+	bu_log("index not updated after attribute edit\n");
+	ret = 1;
+    }
+    ret += compare_searches(dbip, plans);
+    ret += compare_parallel(dbip, plans);
+
+    /* ... as must added and removed objects */
+    {
+	struct directory *dp = db_lookup(dbip, "s3.s", LOOKUP_QUIET);
+	int sph_cnt = search_cnt(dbip, "-type sph");
+	if (!dp || db_delete(dbip, dp) || db_dirdelete(dbip, dp)) {
+	    bu_log("unable to remove s3.s\n");
+	    ret = 1;
+	}
+	center[X] = -10;
+	mk_sph(wdbp, "added.s", center, 1.0);
+	db5_update_attribute("added.s", "material_id", "5", dbip);
+	if (search_cnt(dbip, "-type sph") != sph_cnt) {
+	    bu_log("index not updated after object add and removal\n");
+	    ret = 1;
+	}
+	if (search_cnt(dbip, "-attr material_id=5") != 3) {
+	    bu_log("index not updated after object add\n");
+	    ret = 1;
+	}
+	ret += compare_searches(dbip, plans);
+	ret += compare_parallel(dbip, plans);
+    }
+
+    wdb_close(wdbp);
+    bu_file_delete(SEARCH_INDEX_TEST_FILE);
+
+    return (ret) ? 1 : 0;
+}
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
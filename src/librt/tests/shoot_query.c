@@ -0,0 +1,278 @@
+/*                   S H O O T _ Q U E R Y . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file shoot_query.c
+ *
+ * rt_shootray_first() and rt_shootray_occluded() must agree with the
+ * partition list rt_shootray() produces for the same ray, including
+ * which of several overlapping regions is reported and where the ray
+ * length cuts the query off.
+ */
+
+#include "common.h"
+
+#include <math.h>
+
+#include "vmath.h"
+#include "bu/app.h"
+#include "bu/log.h"
+#include "raytrace.h"
+#include "wdb.h"
+
+#define GRID_SIZE 16
+#define DIST_TOL 1.0e-6
+
+struct first_part {
+    int found;
+    fastf_t dist;
+    struct region *regp;
+};
+
+/* Record the first non-air partition not entirely behind the start */
+static int
+ref_hit(struct application *ap, struct partition *PartHeadp, struct seg *UNUSED(segs))
+{
+    struct first_part *fp = (struct first_part *)ap->a_uptr;
+    struct partition *pp;
+
+    for (pp = PartHeadp->pt_forw; pp != PartHeadp; pp = pp->pt_forw) {
+	if (pp->pt_outhit->hit_dist < 0.0 || pp->pt_regionp->reg_aircode != 0)
+	    continue;
+	fp->found = 1;
+	fp->dist = pp->pt_inhit->hit_dist;
+	fp->regp = pp->pt_regionp;
+	break;
+    }
+    return 1;
+}
+
+static int
+ref_miss(struct application *UNUSED(ap))
+{
+    return 0;
+}
+
+static void
+region(struct rt_wdb *wdbp, const char *name, const char *a, const char *b, int op, int id, int air)
+{
+    struct wmember head;
+    BU_LIST_INIT(&head.l);
+    (void)mk_addmember(a, &head.l, NULL, WMOP_UNION);
+    if (b)
+	(void)mk_addmember(b, &head.l, NULL, op);
+    mk_comb(wdbp, name, &head.l, 1, NULL, NULL, NULL, id, air, 0, 100, 0, 0, 0);
+}
+
+static void
+make_geometry(struct rt_wdb *wdbp)
+{
+    point_t min, max, center;
+    struct wmember head;
+
+    /* Two plain regions overlapping over 5 <= x <= 10 */
+    VSET(min, 0, 0, 0);
+    VSET(max, 10, 10, 10);
+    mk_rpp(wdbp, "a.s", min, max);
+    VSET(min, 5, 0, 0);
+    VSET(max, 15, 10, 10);
+    mk_rpp(wdbp, "b.s", min, max);
+    region(wdbp, "a.r", "a.s", NULL, 0, 1, 0);
+    region(wdbp, "b.r", "b.s", NULL, 0, 2, 0);
+
+    /* Two regions sharing one solid - they overlap exactly, so which
+     * one is reported is down to the overlap handler */
+    VSET(min, 0, 20, 0);
+    VSET(max, 10, 30, 10);
+    mk_rpp(wdbp, "c.s", min, max);
+    region(wdbp, "c1.r", "c.s", NULL, 0, 3, 0);
+    region(wdbp, "c2.r", "c.s", NULL, 0, 4, 0);
+
+    /* A subtraction, which needs boolean evaluation */
+    VSET(min, 20, 0, 0);
+    VSET(max, 30, 10, 10);
+    mk_rpp(wdbp, "d.s", min, max);
+    VSET(center, 25, 5, 5);
+    mk_sph(wdbp, "d_hole.s", center, 4);
+    region(wdbp, "d.r", "d.s", "d_hole.s", WMOP_SUBTRACT, 5, 0);
+
+    /* Air in front of, and overlapping, a plain region */
+    VSET(min, 18, 18, 0);
+    VSET(max, 32, 32, 10);
+    mk_rpp(wdbp, "air.s", min, max);
+    region(wdbp, "air.r", "air.s", NULL, 0, 0, 1);
+    VSET(min, 22, 22, 2);
+    VSET(max, 28, 28, 8);
+    mk_rpp(wdbp, "e.s", min, max);
+    region(wdbp, "e.r", "e.s", NULL, 0, 6, 0);
+
+    BU_LIST_INIT(&head.l);
+    (void)mk_addmember("a.r", &head.l, NULL, WMOP_UNION);
+    (void)mk_addmember("b.r", &head.l, NULL, WMOP_UNION);
+    (void)mk_addmember("c1.r", &head.l, NULL, WMOP_UNION);
+    (void)mk_addmember("c2.r", &head.l, NULL, WMOP_UNION);
+    (void)mk_addmember("d.r", &head.l, NULL, WMOP_UNION);
+    (void)mk_addmember("air.r", &head.l, NULL, WMOP_UNION);
+    (void)mk_addmember("e.r", &head.l, NULL, WMOP_UNION);
+    mk_lcomb(wdbp, "all.g", &head, 0, NULL, NULL, NULL, 0);
+}
+
+static void
+setup_ap(struct application *ap, struct rt_i *rtip, const point_t pt, const vect_t dir)
+{
+    RT_APPLICATION_INIT(ap);
+    ap->a_rt_i = rtip;
+    ap->a_resource = &rt_uniresource;
+    ap->a_logoverlap = rt_silent_logoverlap;
+    VMOVE(ap->a_ray.r_pt, pt);
+    VMOVE(ap->a_ray.r_dir, dir);
+}
+
+static int
+check_ray(struct rt_i *rtip, const point_t pt, const vect_t dir, fastf_t limit)
+{
+    struct application ap;
+    struct first_part ref = {0, 0.0, REGION_NULL};
+    struct region *regp = REGION_NULL;
+    fastf_t dist = 0.0;
+    int found, ret = 0;
+
+    setup_ap(&ap, rtip, pt, dir);
+    ap.a_hit = ref_hit;
+    ap.a_miss = ref_miss;
+    ap.a_onehit = 0;
+    ap.a_uptr = (void *)&ref;
+    (void)rt_shootray(&ap);
+
+    /* The first region, with overlaps resolved */
+    setup_ap(&ap, rtip, pt, dir);
+    found = rt_shootray_first(&ap, &dist, &regp);
+    if (found != ref.found || (found && (regp != ref.regp || !NEAR_EQUAL(dist, ref.dist, DIST_TOL)))) {
+	bu_log("ray (%g %g %g) dir (%g %g %g): first found %d %s at %g, rt_shootray found %d %s at %g\n",
+	       V3ARGS(pt), V3ARGS(dir), found, (found) ? regp->reg_name : "-", dist,
+	       ref.found, (ref.found) ? ref.regp->reg_name : "-", ref.dist);
+	ret = 1;
+    }
+
+    /* The distance alone */
+    setup_ap(&ap, rtip, pt, dir);
+    found = rt_shootray_first(&ap, &dist, NULL);
+    if (found != ref.found || (found && !NEAR_EQUAL(dist, ref.dist, DIST_TOL))) {
+	bu_log("ray (%g %g %g) dir (%g %g %g): first (distance only) found %d at %g, rt_shootray found %d at %g\n",
+	       V3ARGS(pt), V3ARGS(dir), found, dist, ref.found, ref.dist);
+	ret = 1;
+    }
+
+    /* Occlusion, limited by the argument and by the ray length */
+    setup_ap(&ap, rtip, pt, dir);
+    found = rt_shootray_occluded(&ap, limit);
+    if (found != (ref.found && ref.dist <= limit)) {
+	bu_log("ray (%g %g %g) dir (%g %g %g): occluded within %g is %d, rt_shootray hit at %g\n",
+	       V3ARGS(pt), V3ARGS(dir), limit, found, ref.dist);
+	ret = 1;
+    }
+    setup_ap(&ap, rtip, pt, dir);
+    ap.a_ray_length = limit;
+    found = rt_shootray_occluded(&ap, 0.0);
+    if (found != (ref.found && ref.dist <= limit)) {
+	bu_log("ray (%g %g %g) dir (%g %g %g): occluded with a_ray_length %g is %d, rt_shootray hit at %g\n",
+	       V3ARGS(pt), V3ARGS(dir), limit, found, ref.dist);
+	ret = 1;
+    }
+    setup_ap(&ap, rtip, pt, dir);
+    ap.a_ray_length = limit;
+    found = rt_shootray_first(&ap, &dist, &regp);
+    if (found != (ref.found && ref.dist <= limit)) {
+	bu_log("ray (%g %g %g) dir (%g %g %g): first with a_ray_length %g is %d, rt_shootray hit at %g\n",
+	       V3ARGS(pt), V3ARGS(dir), limit, found, ref.dist);
+	ret = 1;
+    }
+
+    return ret;
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct rt_wdb *wdbp;
+    struct rt_i *rtip;
+    point_t min, max, pt;
+    vect_t dir;
+    int ret = 0;
+    int cnt = 0;
+
+    bu_setprogname(argv[0]);
+
+    if (argc != 1)
+	bu_exit(1, "Usage: %s\n", argv[0]);
+
+    wdbp = wdb_dbopen(db_create_inmem(), RT_WDB_TYPE_DB_INMEM);
+    make_geometry(wdbp);
+
+    rtip = rt_new_rti(wdbp->dbip);
+    if (rt_gettree(rtip, "all.g") < 0)
+	bu_exit(1, "ERROR: unable to load the test geometry\n");
+    rt_prep(rtip);
+    VMOVE(min, rtip->mdl_min);
+    VMOVE(max, rtip->mdl_max);
+
+    /* Grids of rays along each axis, in both directions, starting
+     * outside the model, plus a set of oblique rays */
+    for (int axis = 0; axis < 3; axis++) {
+	int u = (axis + 1) % 3;
+	int v = (axis + 2) % 3;
+	for (int sgn = -1; sgn <= 1; sgn += 2) {
+	    for (int i = 0; i < GRID_SIZE; i++) {
+		for (int j = 0; j < GRID_SIZE; j++) {
+		    VSETALL(dir, 0.0);
+		    dir[axis] = sgn;
+		    pt[axis] = (sgn > 0) ? min[axis] - 1.0 : max[axis] + 1.0;
+		    pt[u] = min[u] + (max[u] - min[u]) * (i + 0.5) / GRID_SIZE;
+		    pt[v] = min[v] + (max[v] - min[v]) * (j + 0.5) / GRID_SIZE;
+		    /* about halfway through the model */
+		    ret += check_ray(rtip, pt, dir, 0.5 * (max[axis] - min[axis]) + 1.0);
+		    cnt++;
+		}
+	    }
+	}
+    }
+    for (int i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+	VSET(pt, min[X] - 5.0, min[Y] + (max[Y] - min[Y]) * (i % GRID_SIZE + 0.5) / GRID_SIZE, min[Z] - 5.0);
+	VSET(dir, 1.0, 0.1 * (i / GRID_SIZE) / GRID_SIZE, 0.3);
+	VUNITIZE(dir);
+	ret += check_ray(rtip, pt, dir, 20.0);
+	cnt++;
+    }
+
+    rt_free_rti(rtip);
+    wdb_close(wdbp);
+
+    if (ret)
+	bu_log("%d of %d rays differ from rt_shootray\n", ret, cnt);
+    return (ret) ? 1 : 0;
+}
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
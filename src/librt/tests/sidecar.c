@@ -0,0 +1,330 @@
+/*                       S I D E C A R . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+
+#include "common.h"
+
+#include <stdio.h>
+#include <string.h>
+#ifdef HAVE_SYS_STAT_H
+#  include <sys/stat.h>
+#endif
+
+#include "bu/app.h"
+#include "bu/env.h"
+#include "bu/file.h"
+#include "bu/log.h"
+#include "bu/mapped_file.h"
+#include "bu/str.h"
+#include "raytrace.h"
+
+#define SIDECAR_TEST_CACHE "sidecar_test_cache"
+#define SIDECAR_TEST_SRC_A "sidecar_test_a.dat"
+#define SIDECAR_TEST_SRC_B "sidecar_test_b.dat"
+#define SIDECAR_TEST_LEN 1000
+
+struct fill_state {
+    int calls;
+    int fail;
+};
+
+/* the "conversion" is a bytewise inversion of the source */
+static int
+invert_fill(void *dest, size_t len, const struct bu_mapped_file *src, void *data)
+{
+    struct fill_state *fs = (struct fill_state *)data;
+    const unsigned char *sp = (const unsigned char *)src->buf;
+    unsigned char *dp = (unsigned char *)dest;
+    size_t i;
+
+    fs->calls++;
+    if (fs->fail)
+	return 0;
+    for (i = 0; i < len && i < src->buflen; i++)
+	dp[i] = (unsigned char)~sp[i];
+    return 1;
+}
+
+static void
+write_src(const char *path, size_t len, unsigned char seed)
+{
+    FILE *fp = fopen(path, "wb");
+    size_t i;
+    if (!fp)
+	bu_exit(1, "ERROR: unable to write %s\n", path);
+    for (i = 0; i < len; i++)
+	fputc((int)((i * 7 + seed) & 0xff), fp);
+    fclose(fp);
+}
+
+/* the modification time of path in nanoseconds, or -1 if the file
+ * system doesn't record them */
+static long long
+src_mtime_ns(const char *path)
+{
+#if defined(HAVE_SYS_STAT_H) && !defined(_WIN32)
+    struct stat sb;
+    if (stat(path, &sb) != 0)
+	return -1;
+#  if defined(__APPLE__)
+    return (long long)sb.st_mtimespec.tv_sec * 1000000000 + (long long)sb.st_mtimespec.tv_nsec;
+#  else
+    return (long long)sb.st_mtim.tv_sec * 1000000000 + (long long)sb.st_mtim.tv_nsec;
+#  endif
+#else
+    return -1;
+#endif
+}
+
+static int
+check_data(const char *name, const struct bu_mapped_file *sc, const struct bu_mapped_file *src)
+{
+    const unsigned char *sp = (const unsigned char *)src->buf;
+    const unsigned char *dp = (const unsigned char *)sc->apbuf;
+    size_t i;
+
+    if (!dp || sc->apbuflen != src->buflen) {
+	bu_log("%s: sidecar holds %zu bytes, expected %zu\n", name, sc->apbuflen, src->buflen);
+	return 1;
+    }
+    for (i = 0; i < src->buflen; i++) {
+	if ((dp[i] ^ sp[i]) != 0xff) {
+	    bu_log("%s: sidecar data differs from the source at %zu\n", name, i);
+	    return 1;
+	}
+    }
+    return 0;
+}
+
+static size_t
+sidecar_cnt(const char *dir)
+{
+    char **files = NULL;
+    size_t cnt = bu_file_list(dir, "*.sidecar", &files);
+    bu_argv_free(cnt, files);
+    return cnt;
+}
+
+/* find the sidecar in dir that isn't in the before list */
+static int
+new_sidecar(char *path, const char *dir, char **before, size_t nbefore)
+{
+    char **files = NULL;
+    size_t cnt = bu_file_list(dir, "*.sidecar", &files);
+    size_t i, j;
+    int found = 0;
+
+    for (i = 0; i < cnt && !found; i++) {
+	int seen = 0;
+	for (j = 0; j < nbefore; j++) {
+	    if (BU_STR_EQUAL(files[i], before[j]))
+		seen = 1;
+	}
+	if (!seen) {
+	    bu_dir(path, MAXPATHLEN, dir, files[i], NULL);
+	    found = 1;
+	}
+    }
+    bu_argv_free(cnt, files);
+    return found;
+}
+
+static void
+copy_file(const char *from, const char *to)
+{
+    struct bu_mapped_file *mp = bu_open_mapped_file(from, NULL);
+    FILE *fp = fopen(to, "wb");
+    if (!mp || !fp)
+	bu_exit(1, "ERROR: unable to copy %s to %s\n", from, to);
+    if (fwrite(mp->buf, 1, mp->buflen, fp) != mp->buflen)
+	bu_exit(1, "ERROR: unable to copy %s to %s\n", from, to);
+    fclose(fp);
+    bu_close_mapped_file(mp);
+}
+
+int
+main(int argc, char *argv[])
+{
+    char root[MAXPATHLEN] = {0};
+    char dir[MAXPATHLEN] = {0};
+    char path_a[MAXPATHLEN] = {0};
+    char path_b[MAXPATHLEN] = {0};
+    char **before = NULL;
+    size_t nbefore = 0;
+    struct fill_state fs = {0, 0};
+    struct bu_mapped_file *src_a, *src_b, *sc;
+    size_t cnt;
+    int ret = 0;
+
+    bu_setprogname(argv[0]);
+
+    if (argc != 1)
+	bu_exit(1, "Usage: %s\n", argv[0]);
+
+    bu_dir(root, MAXPATHLEN, BU_DIR_CURR, SIDECAR_TEST_CACHE, NULL);
+    bu_dir(dir, MAXPATHLEN, root, "sidecar", NULL);
+    if (bu_file_directory(root))
+	bu_dirclear(root);
+    bu_setenv("LIBRT_CACHE", root, 1);
+
+    write_src(SIDECAR_TEST_SRC_A, SIDECAR_TEST_LEN, 1);
+    write_src(SIDECAR_TEST_SRC_B, SIDECAR_TEST_LEN, 2);
+    src_a = bu_open_mapped_file(SIDECAR_TEST_SRC_A, NULL);
+    src_b = bu_open_mapped_file(SIDECAR_TEST_SRC_B, NULL);
+    if (!src_a || !src_b)
+	bu_exit(1, "ERROR: unable to map test sources\n");
+
+    /* Created on first use ... */
+    sc = rt_sidecar_open(src_a, "test.invert", SIDECAR_TEST_LEN, invert_fill, &fs);
+    if (!sc || fs.calls != 1 || !new_sidecar(path_a, dir, NULL, 0)) {
+	bu_log("sidecar not created (fill called %d times)\n", fs.calls);
+	bu_exit(1, "ERROR: sidecar creation failed\n");
+    }
+    ret += check_data("created", sc, src_a);
+    bu_close_mapped_file(sc);
+
+    /* ... and reused after that */
+    sc = rt_sidecar_open(src_a, "test.invert", SIDECAR_TEST_LEN, invert_fill, &fs);
+    if (!sc || fs.calls != 1) {
+	bu_log("existing sidecar not reused (fill called %d times)\n", fs.calls);
+	ret++;
+    }
+    if (sc) {
+	ret += check_data("reused", sc, src_a);
+	bu_close_mapped_file(sc);
+    }
+
+    /* Simulate a name collision: B's sidecar is replaced with A's,
+     * whose header matches in everything but the source path.  It
+     * must be detected and regenerated, not used. */
+    nbefore = bu_file_list(dir, "*.sidecar", &before);
+    sc = rt_sidecar_open(src_b, "test.invert", SIDECAR_TEST_LEN, invert_fill, &fs);
+    if (!sc || fs.calls != 2 || !new_sidecar(path_b, dir, before, nbefore)) {
+	bu_log("sidecar for B not created\n");
+	ret++;
+    } else {
+	int calls = fs.calls;
+	bu_close_mapped_file(sc);
+	bu_free_mapped_files(0);
+	copy_file(path_a, path_b);
+	bu_free_mapped_files(0);
+	sc = rt_sidecar_open(src_b, "test.invert", SIDECAR_TEST_LEN, invert_fill, &fs);
+	if (fs.calls != calls + 1) {
+	    bu_log("sidecar of another source was used\n");
+	    ret++;
+	}
+	if (sc) {
+	    ret += check_data("collision", sc, src_b);
+	    bu_close_mapped_file(sc);
+	}
+    }
+    bu_argv_free(nbefore, before);
+
+    /* A different conversion of the same file gets its own sidecar */
+    sc = rt_sidecar_open(src_a, "test.invert2", SIDECAR_TEST_LEN, invert_fill, &fs);
+    if (!sc || sidecar_cnt(dir) != 3) {
+	bu_log("second conversion not cached separately\n");
+	ret++;
+    }
+    if (sc)
+	bu_close_mapped_file(sc);
+
+    /* A failed conversion must not leave a sidecar behind */
+    fs.fail = 1;
+    sc = rt_sidecar_open(src_a, "test.fail", SIDECAR_TEST_LEN, invert_fill, &fs);
+    if (sc || sidecar_cnt(dir) != 3) {
+	bu_log("failed conversion was cached\n");
+	ret++;
+    }
+    fs.fail = 0;
+
+    /* Nothing is stale yet */
+    cnt = sidecar_cnt(dir);
+    if (rt_sidecar_prune() != 0 || sidecar_cnt(dir) != cnt) {
+	bu_log("prune removed current sidecars\n");
+	ret++;
+    }
+
+    /* Changing a source makes its sidecars stale, removing one makes
+     * them orphans - both get pruned */
+    bu_close_mapped_file(src_a);
+    bu_close_mapped_file(src_b);
+    bu_free_mapped_files(0);
+    write_src(SIDECAR_TEST_SRC_A, SIDECAR_TEST_LEN + 1, 3);
+    if (rt_sidecar_prune() != 2 || sidecar_cnt(dir) != cnt - 2) {
+	bu_log("sidecars of a modified source not pruned\n");
+	ret++;
+    }
+    bu_file_delete(SIDECAR_TEST_SRC_B);
+    if (rt_sidecar_prune() != 1 || sidecar_cnt(dir) != cnt - 3) {
+	bu_log("sidecar of a removed source not pruned\n");
+	ret++;
+    }
+
+    /* Rewriting a source without changing its size, within the same
+     * second, must still make its sidecars stale */
+    src_a = bu_open_mapped_file(SIDECAR_TEST_SRC_A, NULL);
+    sc = (src_a) ? rt_sidecar_open(src_a, "test.invert", SIDECAR_TEST_LEN + 1, invert_fill, &fs) : NULL;
+    if (!sc) {
+	bu_log("sidecar of the modified source not created\n");
+	ret++;
+    } else {
+	long long mtime = src_mtime_ns(SIDECAR_TEST_SRC_A);
+	int calls = fs.calls;
+	bu_close_mapped_file(sc);
+	bu_close_mapped_file(src_a);
+	bu_free_mapped_files(0);
+	write_src(SIDECAR_TEST_SRC_A, SIDECAR_TEST_LEN + 1, 4);
+	if (mtime < 0 || mtime == src_mtime_ns(SIDECAR_TEST_SRC_A)) {
+	    bu_log("note: modification times too coarse to check a same size rewrite\n");
+	} else {
+	    src_a = bu_open_mapped_file(SIDECAR_TEST_SRC_A, NULL);
+	    sc = (src_a) ? rt_sidecar_open(src_a, "test.invert", SIDECAR_TEST_LEN + 1, invert_fill, &fs) : NULL;
+	    if (!sc || fs.calls != calls + 1) {
+		bu_log("same size rewrite of a source not noticed\n");
+		ret++;
+	    }
+	    if (sc) {
+		ret += check_data("rewritten", sc, src_a);
+		bu_close_mapped_file(sc);
+	    }
+	    if (src_a)
+		bu_close_mapped_file(src_a);
+	    if (rt_sidecar_prune() != 1) {
+		bu_log("sidecar of a same size rewrite not pruned\n");
+		ret++;
+	    }
+	}
+    }
+
+    bu_file_delete(SIDECAR_TEST_SRC_A);
+    bu_dirclear(root);
+
+    return (ret) ? 1 : 0;
+}
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
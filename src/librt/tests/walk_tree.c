@@ -0,0 +1,394 @@
+/*                     W A L K _ T R E E . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file walk_tree.c
+ *
+ * db_walk_tree() must start the same regions in the same order, and
+ * hand the same region trees to the region end function, whether it
+ * walks with one cpu or several and whether or not the database has a
+ * comb cache to take combinations from - including subassemblies that
+ * are used more than once, and combinations below the regions.
+ */
+
+#include "common.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "vmath.h"
+#include "bn/mat.h"
+#include "bu/app.h"
+#include "bu/file.h"
+#include "bu/log.h"
+#include "bu/parallel.h"
+#include "bu/sort.h"
+#include "bu/str.h"
+#include "raytrace.h"
+#include "wdb.h"
+
+#define WALK_TEST_FILE "walk_tree_test.g"
+#define NMANY 24
+#define MAX_REGIONS 256
+
+struct walk {
+    int nstart;
+    char *start[MAX_REGIONS];
+    int nend;
+    char *end[MAX_REGIONS];	/* semaphored */
+};
+
+
+static void
+make_geometry(void)
+{
+    struct rt_wdb *wdbp;
+    struct wmember head, many;
+    point_t center, pmin, pmax;
+    vect_t h;
+    mat_t m;
+    char name[32];
+
+    bu_file_delete(WALK_TEST_FILE);
+    wdbp = wdb_fopen(WALK_TEST_FILE);
+    if (!wdbp)
+	bu_exit(1, "ERROR: unable to create %s\n", WALK_TEST_FILE);
+
+    VSET(center, 0, 0, 0);
+    mk_sph(wdbp, "s1.s", center, 10);
+    VSET(pmin, -5, -5, -5);
+    VSET(pmax, 5, 5, 5);
+    mk_rpp(wdbp, "s2.s", pmin, pmax);
+    VSET(h, 0, 0, 20);
+    mk_rcc(wdbp, "s3.s", center, h, 3);
+
+    /* A combination below a region */
+    BU_LIST_INIT(&head.l);
+    MAT_IDN(m);
+    MAT_DELTAS(m, 2, 0, 0);
+    (void)mk_addmember("s1.s", &head.l, m, WMOP_UNION);
+    (void)mk_addmember("s2.s", &head.l, NULL, WMOP_INTERSECT);
+    mk_lcomb(wdbp, "inner.c", &head, 0, NULL, NULL, NULL, 0);
+
+    BU_LIST_INIT(&head.l);
+    (void)mk_addmember("s1.s", &head.l, NULL, WMOP_UNION);
+    (void)mk_addmember("s2.s", &head.l, NULL, WMOP_SUBTRACT);
+    mk_lrcomb(wdbp, "r1.r", &head, 1, NULL, NULL, NULL, 1, 0, 0, 0, 0);
+
+    BU_LIST_INIT(&head.l);
+    (void)mk_addmember("s3.s", &head.l, NULL, WMOP_UNION);
+    (void)mk_addmember("inner.c", &head.l, NULL, WMOP_UNION);
+    mk_lrcomb(wdbp, "r2.r", &head, 1, NULL, NULL, NULL, 2, 0, 0, 0, 0);
+
+    BU_LIST_INIT(&head.l);
+    (void)mk_addmember("s2.s", &head.l, NULL, WMOP_UNION);
+    mk_lrcomb(wdbp, "r3.r", &head, 1, NULL, NULL, NULL, 3, 0, 0, 0, 0);
+
+    /* A subassembly used several times, twice in the same comb */
+    BU_LIST_INIT(&head.l);
+    (void)mk_addmember("r1.r", &head.l, NULL, WMOP_UNION);
+    MAT_DELTAS(m, 0, 30, 0);
+    (void)mk_addmember("r2.r", &head.l, m, WMOP_UNION);
+    mk_lcomb(wdbp, "sub.g", &head, 0, NULL, NULL, NULL, 0);
+
+    BU_LIST_INIT(&head.l);
+    MAT_DELTAS(m, 100, 0, 0);
+    (void)mk_addmember("sub.g", &head.l, m, WMOP_UNION);
+    MAT_DELTAS(m, 200, 0, 0);
+    (void)mk_addmember("sub.g", &head.l, m, WMOP_UNION);
+    (void)mk_addmember("r3.r", &head.l, NULL, WMOP_UNION);
+    mk_lcomb(wdbp, "asm.g", &head, 0, NULL, NULL, NULL, 0);
+
+    /* Enough regions to keep several cpus busy */
+    BU_LIST_INIT(&many.l);
+    for (int i = 0; i < NMANY; i++) {
+	snprintf(name, sizeof(name), "m%02d.r", i);
+	BU_LIST_INIT(&head.l);
+	MAT_IDN(m);
+	MAT_DELTAS(m, 0, 0, 50 * i);
+	(void)mk_addmember((i % 2) ? "s1.s" : "inner.c", &head.l, m, WMOP_UNION);
+	(void)mk_addmember("s3.s", &head.l, m, WMOP_SUBTRACT);
+	mk_lrcomb(wdbp, name, &head, 1, NULL, NULL, NULL, 100 + i, 0, 0, 0, 0);
+	(void)mk_addmember(name, &many.l, NULL, WMOP_UNION);
+    }
+    mk_lcomb(wdbp, "many.g", &many, 0, NULL, NULL, NULL, 0);
+
+    BU_LIST_INIT(&head.l);
+    (void)mk_addmember("asm.g", &head.l, NULL, WMOP_UNION);
+    bn_mat_angles(m, 0, 0, 90);
+    (void)mk_addmember("sub.g", &head.l, m, WMOP_UNION);
+    MAT_IDN(m);
+    MAT_DELTAS(m, 0, -300, 0);
+    (void)mk_addmember("asm.g", &head.l, m, WMOP_UNION);
+    (void)mk_addmember("many.g", &head.l, NULL, WMOP_UNION);
+    mk_lcomb(wdbp, "top.g", &head, 0, NULL, NULL, NULL, 0);
+
+    wdb_close(wdbp);
+}
+
+
+static void
+describe(struct bu_vls *v, const union tree *tp)
+{
+    if (!tp) {
+	bu_vls_printf(v, "null");
+	return;
+    }
+    switch (tp->tr_op) {
+	case OP_DB_LEAF:
+	    bu_vls_printf(v, "%s[", tp->tr_l.tl_name);
+	    for (int i = 0; i < 16; i++)
+		bu_vls_printf(v, " %.6g", tp->tr_l.tl_mat[i]);
+	    bu_vls_printf(v, " ]");
+	    return;
+	case OP_UNION:
+	case OP_INTERSECT:
+	case OP_SUBTRACT:
+	case OP_XOR:
+	    bu_vls_printf(v, "(");
+	    describe(v, tp->tr_b.tb_left);
+	    bu_vls_printf(v, " %d ", tp->tr_op);
+	    describe(v, tp->tr_b.tb_right);
+	    bu_vls_printf(v, ")");
+	    return;
+	case OP_NOT:
+	case OP_GUARD:
+	case OP_XNOP:
+	    bu_vls_printf(v, "%d(", tp->tr_op);
+	    describe(v, tp->tr_b.tb_left);
+	    bu_vls_printf(v, ")");
+	    return;
+	case OP_NOP:
+	    bu_vls_printf(v, "nop");
+	    return;
+	default:
+	    bu_vls_printf(v, "op%d", tp->tr_op);
+	    return;
+    }
+}
+
+
+static int
+walk_region_start(struct db_tree_state *tsp, const struct db_full_path *pathp, const struct rt_comb_internal *UNUSED(comb), void *client_data)
+{
+    struct walk *w = (struct walk *)client_data;
+    struct bu_vls v = BU_VLS_INIT_ZERO;
+    char *path = db_path_to_string(pathp);
+
+    /* Only ever called from the serial part of the walk */
+    bu_vls_sprintf(&v, "%s id=%ld", path, (long)tsp->ts_regionid);
+    bu_free(path, "path string");
+    if (w->nstart < MAX_REGIONS)
+	w->start[w->nstart] = bu_vls_strdup(&v);
+    w->nstart++;
+    bu_vls_free(&v);
+    return 0;
+}
+
+
+static union tree *
+walk_region_end(struct db_tree_state *tsp, const struct db_full_path *pathp, union tree *curtree, void *client_data)
+{
+    struct walk *w = (struct walk *)client_data;
+    struct bu_vls v = BU_VLS_INIT_ZERO;
+    char *path = db_path_to_string(pathp);
+
+    bu_vls_sprintf(&v, "%s id=%ld: ", path, (long)tsp->ts_regionid);
+    bu_free(path, "path string");
+    describe(&v, curtree);
+
+    bu_semaphore_acquire(BU_SEM_GENERAL);
+    if (w->nend < MAX_REGIONS)
+	w->end[w->nend] = bu_vls_strdup(&v);
+    w->nend++;
+    bu_semaphore_release(BU_SEM_GENERAL);
+    bu_vls_free(&v);
+
+    /* Nothing to keep - db_walk_tree() frees it */
+    return curtree;
+}
+
+
+static union tree *
+walk_leaf(struct db_tree_state *tsp, const struct db_full_path *pathp, struct rt_db_internal *UNUSED(ip), void *UNUSED(client_data))
+{
+    union tree *tp;
+
+    BU_GET(tp, union tree);
+    RT_TREE_INIT(tp);
+    tp->tr_l.tl_op = OP_DB_LEAF;
+    tp->tr_l.tl_name = db_path_to_string(pathp);
+    tp->tr_l.tl_mat = (matp_t)bu_malloc(sizeof(mat_t), "leaf matrix");
+    MAT_COPY(tp->tr_l.tl_mat, tsp->ts_mat);
+    return tp;
+}
+
+
+static int
+str_cmp(const void *a, const void *b, void *UNUSED(arg))
+{
+    return bu_strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+
+static int
+walk(struct walk *w, struct rt_i *rtip, int ncpu)
+{
+    struct db_tree_state state;
+    const char *argv[1] = {"top.g"};
+
+    memset(w, 0, sizeof(struct walk));
+    db_init_db_tree_state(&state, rtip->rti_dbip, &rt_uniresource);
+    state.ts_rtip = rtip;
+    int wret = db_walk_tree(rtip->rti_dbip, 1, argv, ncpu, &state, walk_region_start, walk_region_end, walk_leaf, (void *)w);
+    db_free_db_tree_state(&state);
+    if (wret < 0)
+	return -1;
+
+    /* The region end calls are made in whatever order the cpus get to
+     * the regions */
+    if (w->nend <= MAX_REGIONS)
+	bu_sort(w->end, w->nend, sizeof(char *), str_cmp, NULL);
+    return 0;
+}
+
+
+static void
+walk_free(struct walk *w)
+{
+    for (int i = 0; i < w->nstart && i < MAX_REGIONS; i++)
+	bu_free(w->start[i], "start");
+    for (int i = 0; i < w->nend && i < MAX_REGIONS; i++)
+	bu_free(w->end[i], "end");
+}
+
+
+static int
+compare(const char *stage, const struct walk *ref, const struct walk *w)
+{
+    int ret = 0;
+
+    if (w->nstart != ref->nstart || w->nend != ref->nend) {
+	bu_log("%s: %d regions started and %d ended, expected %d and %d\n", stage, w->nstart, w->nend, ref->nstart, ref->nend);
+	return 1;
+    }
+    for (int i = 0; i < w->nstart && i < MAX_REGIONS; i++) {
+	if (!BU_STR_EQUAL(w->start[i], ref->start[i])) {
+	    bu_log("%s: region %d started as %s, expected %s\n", stage, i, w->start[i], ref->start[i]);
+	    ret++;
+	}
+    }
+    for (int i = 0; i < w->nend && i < MAX_REGIONS; i++) {
+	if (!BU_STR_EQUAL(w->end[i], ref->end[i])) {
+	    bu_log("%s: region tree\n  %s\nexpected\n  %s\n", stage, w->end[i], ref->end[i]);
+	    ret++;
+	}
+    }
+    return ret;
+}
+
+
+int
+main(int ac, char *av[])
+{
+    struct db_i *dbip;
+    struct rt_i *rtip;
+    struct resource *resp;
+    struct walk ref, w;
+    /* Two subassemblies of sub.g's two regions and r3.r, sub.g, and
+     * the many.g regions */
+    int expected = 2 * (2 * 2 + 1) + 2 + NMANY;
+    int ncpu = (bu_avail_cpus() > 4) ? (int)bu_avail_cpus() : 4;
+    int ret = 0;
+
+    bu_setprogname(av[0]);
+
+    if (ac != 1)
+	bu_exit(1, "Usage: %s\n", av[0]);
+
+    if (ncpu > MAX_PSW)
+	ncpu = MAX_PSW;
+
+    make_geometry();
+
+    dbip = db_open(WALK_TEST_FILE, DB_OPEN_READONLY);
+    if (dbip == DBI_NULL || db_dirbuild(dbip) < 0)
+	bu_exit(1, "ERROR: unable to read %s\n", WALK_TEST_FILE);
+    rtip = rt_new_rti(dbip);
+    if (rtip == RTI_NULL)
+	bu_exit(1, "ERROR: rt_new_rti failed\n");
+
+    /* Each cpu past the first needs a resource of its own */
+    resp = (struct resource *)bu_calloc(ncpu, sizeof(struct resource), "resources");
+    for (int i = 1; i < ncpu; i++)
+	rt_init_resource(&resp[i], i, rtip);
+
+    /* The reference, walked the way it was before there was a cache */
+    db_comb_cache_disable(dbip);
+    if (walk(&ref, rtip, 1) < 0)
+	bu_exit(1, "ERROR: unable to walk top.g\n");
+    if (ref.nstart != expected || ref.nend != expected) {
+	bu_log("reference: %d regions started and %d ended, expected %d\n", ref.nstart, ref.nend, expected);
+	ret++;
+    }
+
+    if (walk(&w, rtip, ncpu) < 0)
+	bu_exit(1, "ERROR: unable to walk top.g\n");
+    ret += compare("no cache, several cpus", &ref, &w);
+    walk_free(&w);
+
+    db_comb_cache_enable(dbip);
+    if (walk(&w, rtip, 1) < 0)
+	bu_exit(1, "ERROR: unable to walk top.g\n");
+    ret += compare("cache, one cpu", &ref, &w);
+    walk_free(&w);
+
+    /* Filled by the walk above, then from empty again */
+    if (walk(&w, rtip, ncpu) < 0)
+	bu_exit(1, "ERROR: unable to walk top.g\n");
+    ret += compare("filled cache, several cpus", &ref, &w);
+    walk_free(&w);
+
+    db_comb_cache_disable(dbip);
+    db_comb_cache_enable(dbip);
+    if (walk(&w, rtip, ncpu) < 0)
+	bu_exit(1, "ERROR: unable to walk top.g\n");
+    ret += compare("empty cache, several cpus", &ref, &w);
+    walk_free(&w);
+
+    walk_free(&ref);
+    rt_free_rti(rtip);
+    bu_free(resp, "resources");
+    db_close(dbip);
+    bu_file_delete(WALK_TEST_FILE);
+
+    if (ret)
+	bu_log("%d tree walk checks failed\n", ret);
+    return (ret) ? 1 : 0;
+}
+
+
+/*
+ * Local Variables:
+ * mode: C
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
@@ -33,6 +33,7 @@
 #include "raytrace.h"
 
 #include "./cache.h"
+#include "./librt_private.h"
 
 
 #define ACQUIRE_SEMAPHORE_TREE(_hash) switch ((_hash)&03) {	\
@@ -556,7 +557,10 @@ _rt_gettree_leaf(struct db_tree_state *tsp, const struct db_full_path *pathp, st
      * long as idb_ptr is set to null.  Note that the prep routine may
      * have changed st_id.
      */
-    if (rtip->rti_dbip->dbi_version > 4) {
+    if (rt_instance_prep(stp, ip, data->cache) == 0) {
+	/* later placement sharing an earlier one's prep */
+	ret = 0;
+    } else if (rtip->rti_dbip->dbi_version > 4) {
 	ret = rt_cache_prep(data->cache, stp, ip);
     } else {
 	ret = rt_obj_prep(stp, ip, stp->st_rtip);
@@ -6538,6 +6538,9 @@ to_rt_gettrees_application(struct ged *gedp,
 	return RT_APPLICATION_NULL;
     }
 
+    /* Pick up edits made to these objects before later shots */
+    (void)rt_reprep_watch(rtip, argc, (const char **)&argv[0], 1);
+
     /* Establish defaults for this rt_i */
     rtip->rti_hasty_prep = 1;	/* Tcl isn't going to fire many rays */
 
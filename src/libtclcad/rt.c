@@ -598,6 +598,12 @@ tclcad_rt(ClientData clientData, Tcl_Interp *interp, int argc, const char **argv
 	return TCL_ERROR;
     }
 
+    /* Bring the model up to date with any database edits */
+    if (ap->a_rt_i && rt_reprep_pending(ap->a_rt_i, ap->a_resource) < 0) {
+	Tcl_AppendResult(interp, "unable to update geometry after database edits", (char *)NULL);
+	return TCL_ERROR;
+    }
+
     for (dbcmd = tclcad_rt_cmds; dbcmd->cmdname != NULL; dbcmd++) {
 	if (BU_STR_EQUAL(dbcmd->cmdname, argv[1])) {
 	    /* need proper cmd func pointer for actual call */
@@ -1761,6 +1761,9 @@ cmd_rt_gettrees(ClientData clientData, Tcl_Interp *UNUSED(interpreter), int argc
         return TCL_ERROR;
     }
 
+    /* Pick up edits made to these objects before later shots */
+    (void)rt_reprep_watch(rtip, argc-2, (const char **)&argv[2], 1);
+
     /* Establish defaults for this rt_i */
     rtip->rti_hasty_prep = 1;   /* Tcl isn't going to fire many rays */
 
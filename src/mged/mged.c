@@ -1475,6 +1475,27 @@ std_out_or_err(ClientData clientData, int UNUSED(mask))
 
 
 
+/* How often to redraw while adaptive wireframes are being regenerated */
+#define LOD_REDRAW_MSEC 50
+
+static Tcl_TimerToken lod_redraw_timer = NULL;
+
+/* Wireframes regenerated in the background show up on the next redraw
+ * of their view */
+static void
+lod_redraw(ClientData UNUSED(clientData))
+{
+    lod_redraw_timer = NULL;
+    for (size_t di = 0; di < BU_PTBL_LEN(&active_dm_set); di++) {
+	struct mged_dm *p = (struct mged_dm *)BU_PTBL_GET(&active_dm_set, di);
+	if (!p->dm_view_state || !ged_csg_lod_pending(p->dm_view_state->vs_gvp))
+	    continue;
+	p->dm_dirty = 1;
+	dm_set_dirty(p->dm_dmp, 1);
+    }
+}
+
+
 /**
  * NOTE that this routine is not to be casually used to refresh the
  * screen.  The normal procedure for screen refresh is to manipulate
@@ -1661,6 +1682,18 @@ refresh(struct mged_state *s)
 	}
     }
 
+    /* Keep redrawing views whose adaptive wireframes are still being
+     * regenerated */
+    if (!lod_redraw_timer) {
+	for (size_t di = 0; di < BU_PTBL_LEN(&active_dm_set); di++) {
+	    struct mged_dm *p = (struct mged_dm *)BU_PTBL_GET(&active_dm_set, di);
+	    if (p->dm_view_state && ged_csg_lod_pending(p->dm_view_state->vs_gvp)) {
+		lod_redraw_timer = Tcl_CreateTimerHandler(LOD_REDRAW_MSEC, lod_redraw, NULL);
+		break;
+	    }
+	}
+    }
+
     /* a frame was drawn */
     if (do_time) {
 	elapsed_time = bu_gettime() - start_time;
@@ -575,6 +575,9 @@ main(int argc, const char **argv)
     int minpieces = -1;
     int print_help = 0;
     int read_matrix = 0;
+    int ray_binary = 0;
+    int ray_ncpu = 0;
+    struct bu_vls ray_file = BU_VLS_INIT_ZERO;
     int silent_mode = SILENT_UNSET;
     int use_air = 0;
     int verbose_mode = 0;
@@ -599,7 +602,7 @@ main(int argc, const char **argv)
     mat_t q;
     /* These bu_opt_desc_opts settings approximate the old struct nirt_state help formatting */
     struct bu_opt_desc_opts dopts = { BU_OPT_ASCII, 1, 15, 65, NULL, NULL, NULL, 1, NULL, NULL };
-    struct bu_opt_desc d[18] = {BU_OPT_DESC_NULL};
+    struct bu_opt_desc d[21] = {BU_OPT_DESC_NULL};
 
     BU_OPT(d[0],  "?", "",     "",       NULL,             &print_help,     "print help and exit");
     BU_OPT(d[1],  "h", "help", "",       NULL,             &print_help,     "print help and exit");
@@ -618,7 +621,10 @@ main(int argc, const char **argv)
     BU_OPT(d[14], "O", "",     "action", &decode_overlap,  &overlap_claims, "handle overlap claims via action");
     BU_OPT(d[15], "x", "",     "v",      &bu_opt_int,      &rt_debug,      "set librt(3) diagnostic flag=v");
     BU_OPT(d[16], "X", "",     "v",      &bu_opt_vls,      &nirt_debug,     "set nirt diagnostic flag=v");
-    BU_OPT_NULL(d[17]);
+    BU_OPT(d[17], "R", "",     "file",   &bu_opt_vls,      &ray_file,       "shoot the rays (x y z dx dy dz) listed in file, or - for stdin, in parallel and exit");
+    BU_OPT(d[18], "",  "binary", "",     NULL,             &ray_binary,     "ray list given to -R is packed binary doubles");
+    BU_OPT(d[19], "P", "",     "n",      &bu_opt_int,      &ray_ncpu,       "use n processors for -R (default all)");
+    BU_OPT_NULL(d[20]);
 
     if (argc == 0 || !argv)
 	return -1;
@@ -895,6 +901,34 @@ main(int argc, const char **argv)
 	init_scripts.clear();
     }
 
+    /* Batch mode - shoot the whole ray list and exit */
+    if (bu_vls_strlen(&ray_file)) {
+	FILE *rfp = stdin;
+	long nrays;
+	if (!BU_STR_EQUAL(bu_vls_cstr(&ray_file), "-")) {
+	    rfp = fopen(bu_vls_cstr(&ray_file), (ray_binary) ? "rb" : "r");
+	    if (!rfp) {
+		bu_vls_sprintf(&msg, "Unable to open ray list %s\n", bu_vls_cstr(&ray_file));
+		nirt_err(&io_data, bu_vls_addr(&msg));
+		ret = EXIT_FAILURE;
+		goto done;
+	    }
+	}
+	nrays = nirt_batch(ns, rfp, ray_binary, io_data.out, ray_ncpu);
+	if (rfp != stdin)
+	    fclose(rfp);
+	if (nrays < 0) {
+	    ret = EXIT_FAILURE;
+	    goto done;
+	}
+	if (silent_mode != SILENT_YES) {
+	    bu_vls_sprintf(&msg, "%ld rays shot\n", nrays);
+	    nirt_msg(&io_data, bu_vls_addr(&msg));
+	}
+	ret = EXIT_SUCCESS;
+	goto done;
+    }
+
     /* If we're supposed to read matrix input from stdin instead of interacting, do that */
     if (read_matrix) {
 	while ((buf = rt_read_cmd(stdin)) != (char *) 0) {
@@ -1006,6 +1040,7 @@ done:
     bu_vls_free(&msg);
     bu_vls_free(&ncmd);
     bu_vls_free(&iline);
+    bu_vls_free(&ray_file);
 
     if (io_data.using_pipe) {
 	pclose(io_data.out);
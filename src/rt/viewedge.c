@@ -38,7 +38,9 @@
  * book-keeping with 2x as much work occurring as necessary on default
  * renders due to double-firing of the "below" row.  antialiasing
  * makes it even worse with entire subgrids being refired (although
- * they should all at least be unique).
+ * they should all at least be unique).  the gbuffer option avoids
+ * the neighbor rays entirely by comparing against a buffer of the
+ * whole frame.
  *
  * TODO: it would be nice to capture an edge "intensity" based on
  * normals, region ids, and the other detectable patterns, but then
@@ -141,6 +143,30 @@ static unsigned char *blendline[MAX_PSW];
 static struct cell *saved[MAX_PSW];
 static struct resource occlusion_resources[MAX_PSW];
 
+/*
+ * G-buffer entries, one per pixel.  Misses are stored the way
+ * raymiss2() fills in a cell so they compare the same way.
+ *
+ * The buffer covers the whole frame, about 45 bytes per pixel (45MB
+ * at 1024x1024).  Workers render pixels in whatever order the
+ * framework hands them out, so no part of the frame can be released
+ * until all of its neighbors are in, and tiling it would mean firing
+ * the tile borders twice - the extra rays this mode exists to avoid.
+ * Use the default mode for images too large to buffer.
+ */
+#define GB_UNSET 0
+#define GB_MISS 1
+#define GB_HIT 2
+
+static struct {
+    size_t width, height;
+    unsigned char *state;
+    int *id;
+    struct region **region;
+    fastf_t *dist;
+    fastf_t *normal;	/* 3 per pixel */
+} gbuf = {0, 0, NULL, NULL, NULL, NULL, NULL};
+
 int nEdges = 0;
 int nPixels = 0;
 
@@ -230,6 +256,20 @@ int occlusion_mode = OCCLUSION_MODE_NONE;
 static int antialias = 0;
 static int both_sides = 0;
 
+/*
+ * G-buffer Mode
+ *
+ * If set, each pixel only fires its main ray and records what it hit
+ * (region, distance, and normal) in a frame-sized buffer.  Edges are
+ * found in a separate pass over the buffer once the whole frame is
+ * rendered, comparing each pixel with its neighbors' entries instead
+ * of firing extra rays at them.  Neighbor rays are only fired for
+ * pixels whose neighbors weren't rendered (the image border, or
+ * outside a sub-grid).  Output is written by the edge pass, so
+ * nothing is displayed until the frame is complete.
+ */
+static int gbuffer = 0;
+
 
 /*
  * whether to draw aligned axes at the model's origin
@@ -274,6 +314,8 @@ struct bu_structparse view_parse[] = {
     {"%d", 1, "bs", 0, BU_STRUCTPARSE_FUNC_NULL, NULL, NULL},
     {"%d", 1, "draw_axes", 0, BU_STRUCTPARSE_FUNC_NULL, NULL, NULL},
     {"%d", 1, "da", 0, BU_STRUCTPARSE_FUNC_NULL, NULL, NULL},
+    {"%d", 1, "gbuffer", 0, BU_STRUCTPARSE_FUNC_NULL, NULL, NULL},
+    {"%d", 1, "gb", 0, BU_STRUCTPARSE_FUNC_NULL, NULL, NULL},
     {"",	0, (char *)0,	0,	BU_STRUCTPARSE_FUNC_NULL, NULL, NULL }
 };
 
@@ -283,27 +325,13 @@ const char title[] = "RT Hidden-Line Renderer";
 
 int handle_main_ray(struct application *ap, register struct partition *PartHeadp, struct seg *segp);
 int diffpixel(RGBpixel a, RGBpixel b);
-
-static int occlusion_hit(struct application *ap, struct partition *pt, struct seg *UNUSED(segp))
-{
-    struct hit *hitp = pt->pt_forw->pt_inhit;
-
-    ap->a_dist = hitp->hit_dist;
-    return 1;
-}
-
-
-static int occlusion_miss(struct application *ap)
-{
-    ap->a_dist = MAX_FASTF;
-    return 0;
-}
-
+static void gbuf_worker(int cpu, void *data);
 
 static int occludes(struct application *ap, struct cell *here)
 {
     int cpu;
     int oc_hit = 0;
+    fastf_t oc_dist = MAX_FASTF;
 
     if (ap->a_resource->re_cpu > 0)
 	cpu = ap->a_resource->re_cpu - 1;
@@ -317,7 +345,8 @@ static int occludes(struct application *ap, struct cell *here)
     VMOVE(occlusion_apps[cpu]->a_ray.r_pt, ap->a_ray.r_pt);
     VMOVE(occlusion_apps[cpu]->a_ray.r_dir, ap->a_ray.r_dir);
 
-    oc_hit = rt_shootray(occlusion_apps[cpu]);
+    /* only the nearest hit matters, so skip building partitions */
+    oc_hit = rt_shootray_first(occlusion_apps[cpu], &oc_dist, NULL);
 
     if (!oc_hit) {
 	/*
@@ -330,13 +359,13 @@ static int occludes(struct application *ap, struct cell *here)
 	return 2;
     }
 
-    if (NEAR_EQUAL(occlusion_apps[cpu]->a_dist, here->c_dist, BN_TOL_DIST)) {
+    if (NEAR_EQUAL(oc_dist, here->c_dist, BN_TOL_DIST)) {
 	/* same hit point.  object is probably in first and second
 	 * geometry sets.  it's not occluding itself, but we want an
 	 * edge because it's in the first display set.
 	 */
 	return 1;
-    } else if (	occlusion_apps[cpu]->a_dist < here->c_dist) {
+    } else if (oc_dist < here->c_dist) {
 	/* second geometry is closer than the first, therefore it is
 	 * 'foreground'. Do not draw the edge.
 	 *
@@ -498,9 +527,6 @@ view_init(struct application *ap, char *file, char *UNUSED(obj), int minus_o, in
 
 	    occlusion_apps[i]->a_rt_i = occlusion_rtip;
 	    occlusion_apps[i]->a_resource = (struct resource *)BU_PTBL_GET(&occlusion_rtip->rti_resources, i);
-	    occlusion_apps[i]->a_onehit = 1;
-	    occlusion_apps[i]->a_hit = occlusion_hit;
-	    occlusion_apps[i]->a_miss = occlusion_miss;
 	    if (rpt_overlap)
 		occlusion_apps[i]->a_logoverlap = (void (*)(struct application *, const struct partition *, const struct bu_ptbl *, const struct partition *))NULL;
 	    else
@@ -530,6 +556,13 @@ view_init(struct application *ap, char *file, char *UNUSED(obj), int minus_o, in
 	bu_exit(EXIT_FAILURE, "rtedge: occlusion mode set, but no objects were specified.\n");
     }
 
+    /* Passes after the first only render some pixels, and the edge
+     * pass needs the whole frame */
+    if (gbuffer && (incr_mode || full_incr_mode)) {
+	bu_log("rtedge: deactivating G-buffer mode due to incremental rendering.\n");
+	gbuffer = 0;
+    }
+
 
     // TODO - the setting of colors below broke the -W flag - lines and
     // background were both white.  Looks like rtedge was relying on bgcolor
@@ -611,8 +644,12 @@ view_2init(struct application *UNUSED(ap), char *UNUSED(framename))
      * Per_processor_chuck specifies the number of pixels rendered per
      * each pass of a worker. By making this value equal to the width
      * of the image, each worker will render one scanline at a time.
+     *
+     * The G-buffer doesn't care what order pixels are rendered in, so
+     * workers are left to render their default tiles.
      */
-    per_processor_chunk = width;
+    if (!gbuffer)
+	per_processor_chunk = width;
 
     /*
      * Use three bytes per pixel.
@@ -641,15 +678,36 @@ view_2init(struct application *UNUSED(ap), char *UNUSED(framename))
 	if (saved[i] == NULL)
 	    BU_ALLOC(saved[i], struct cell);
 	if (writeable[i] == NULL)
-	    writeable[i] = (unsigned char *) bu_calloc(1, per_processor_chunk, "writeable pixel flag buffer");
+	    writeable[i] = (unsigned char *) bu_calloc(1, width, "writeable pixel flag buffer");
 	if (scanline[i] == NULL)
-	    scanline[i] = (unsigned char *) bu_calloc(per_processor_chunk, pixsize, "scanline buffer");
+	    scanline[i] = (unsigned char *) bu_calloc(width, pixsize, "scanline buffer");
 	/*
 	 * If blending is desired, create scanline buffers to hold the
 	 * read-in lines from the framebuffer.
 	 */
 	if (blend && blendline[i] == NULL)
-	    blendline[i] = (unsigned char *) bu_calloc(per_processor_chunk, pixsize, "blend buffer");
+	    blendline[i] = (unsigned char *) bu_calloc(width, pixsize, "blend buffer");
+    }
+
+    if (gbuffer) {
+	size_t npix = width * height;
+	if (gbuf.width != width || gbuf.height != height) {
+	    if (gbuf.state) {
+		bu_free(gbuf.state, "gbuf state");
+		bu_free(gbuf.id, "gbuf id");
+		bu_free(gbuf.region, "gbuf region");
+		bu_free(gbuf.dist, "gbuf dist");
+		bu_free(gbuf.normal, "gbuf normal");
+	    }
+	    gbuf.width = width;
+	    gbuf.height = height;
+	    gbuf.state = (unsigned char *)bu_malloc(npix, "gbuf state");
+	    gbuf.id = (int *)bu_malloc(npix * sizeof(int), "gbuf id");
+	    gbuf.region = (struct region **)bu_malloc(npix * sizeof(struct region *), "gbuf region");
+	    gbuf.dist = (fastf_t *)bu_malloc(npix * sizeof(fastf_t), "gbuf dist");
+	    gbuf.normal = (fastf_t *)bu_malloc(npix * 3 * sizeof(fastf_t), "gbuf normal");
+	}
+	memset(gbuf.state, GB_UNSET, npix);
     }
 
     /*
@@ -678,31 +736,26 @@ void view_pixel(struct application *UNUSED(ap))
 
 
 /**
- * action performed at the end of each scanline
+ * write out scanline y from cpu's buffers
  */
-void
-view_eol(struct application *ap)
+static void
+write_scanline(int cpu, int y)
 {
-    int cpu;
     int i;
-
-    if (ap->a_resource->re_cpu > 0)
-	cpu = ap->a_resource->re_cpu - 1;
-    else
-	cpu = ap->a_resource->re_cpu;
+    int npix = (int)width;
 
     if (overlay) {
 	/*
 	 * Overlay mode. Check if the pixel is an edge.  If so, write
 	 * it to the framebuffer.
 	 */
-	for (i = 0; i < per_processor_chunk; ++i) {
+	for (i = 0; i < npix; ++i) {
 	    if (writeable[cpu][i]) {
 		/*
 		 * Write this pixel
 		 */
 		bu_semaphore_acquire(BU_SEM_SYSCALL);
-		fb_write(fbp, i, ap->a_y, &scanline[cpu][i*3], 1);
+		fb_write(fbp, i, y, &scanline[cpu][i*3], 1);
 		bu_semaphore_release(BU_SEM_SYSCALL);
 	    }
 	}
@@ -720,11 +773,11 @@ view_eol(struct application *ap)
 	fastf_t hsv[3];
 
 	bu_semaphore_acquire(BU_SEM_SYSCALL);
-	if (fb_read(fbp, 0, ap->a_y, blendline[cpu], per_processor_chunk) < 0)
+	if (fb_read(fbp, 0, y, blendline[cpu], npix) < 0)
 	    bu_exit(EXIT_FAILURE, "rtedge: error reading from framebuffer.\n");
 	bu_semaphore_release(BU_SEM_SYSCALL);
 
-	for (i = 0; i < per_processor_chunk; ++i) {
+	for (i = 0; i < npix; ++i) {
 	    /*
 	     * Is this pixel an edge?
 	     */
@@ -745,7 +798,7 @@ view_eol(struct application *ap)
 		 * course, we are on the bottom scanline or the
 		 * leftmost column (x=y=0)
 		 */
-		if (i != 0 && ap->a_y != 0 && !diffpixel(rgb, fb_bg_color)) {
+		if (i != 0 && y != 0 && !diffpixel(rgb, fb_bg_color)) {
 		    RGBpixel left;
 		    RGBpixel down;
 
@@ -754,7 +807,7 @@ view_eol(struct application *ap)
 		    left[BLU] = blendline[cpu][(i-1)*3+BLU];
 
 		    bu_semaphore_acquire(BU_SEM_SYSCALL);
-		    fb_read(fbp, i, ap->a_y - 1, down, 1);
+		    fb_read(fbp, i, y - 1, down, 1);
 		    bu_semaphore_release(BU_SEM_SYSCALL);
 
 		    if (diffpixel(left, fb_bg_color)) {
@@ -806,7 +859,7 @@ view_eol(struct application *ap)
 		     * wrong scanline.
 		     */
 		    bu_semaphore_acquire(BU_SEM_SYSCALL);
-		    fb_write(fbp, i, ap->a_y, rgb, 1);
+		    fb_write(fbp, i, y, rgb, 1);
 		    bu_semaphore_release(BU_SEM_SYSCALL);
 
 		    replace_down = 0;
@@ -827,7 +880,7 @@ view_eol(struct application *ap)
 	 * Write the blendline to the framebuffer.
 	 */
 	bu_semaphore_acquire(BU_SEM_SYSCALL);
-	fb_write(fbp, 0, ap->a_y, blendline[cpu], per_processor_chunk);
+	fb_write(fbp, 0, y, blendline[cpu], npix);
 	bu_semaphore_release(BU_SEM_SYSCALL);
     } /* end blend */
 
@@ -836,7 +889,7 @@ view_eol(struct application *ap)
 	 * Simple whole scanline write to a framebuffer.
 	 */
 	bu_semaphore_acquire(BU_SEM_SYSCALL);
-	fb_write(fbp, 0, ap->a_y, scanline[cpu], per_processor_chunk);
+	fb_write(fbp, 0, y, scanline[cpu], npix);
 	bu_semaphore_release(BU_SEM_SYSCALL);
     }
 
@@ -845,7 +898,7 @@ view_eol(struct application *ap)
 	 * Write to an icv_image_t.
 	 */
 	/* TODO : Add double type data to maintain resolution */
-	icv_writeline(bif, ap->a_y, scanline[cpu],  ICV_DATA_UCHAR);
+	icv_writeline(bif, y, scanline[cpu],  ICV_DATA_UCHAR);
     }
 
     else
@@ -856,6 +909,27 @@ view_eol(struct application *ap)
 }
 
 
+/**
+ * action performed at the end of each scanline
+ */
+void
+view_eol(struct application *ap)
+{
+    int cpu;
+
+    /* written by the edge pass instead */
+    if (gbuffer)
+	return;
+
+    if (ap->a_resource->re_cpu > 0)
+	cpu = ap->a_resource->re_cpu - 1;
+    else
+	cpu = ap->a_resource->re_cpu;
+
+    write_scanline(cpu, ap->a_y);
+}
+
+
 void view_setup(struct rt_i *UNUSED(rtip))
 {
 }
@@ -935,8 +1009,15 @@ void draw_z_label(const double x, const double y, const unsigned int lineLength,
  * end of each frame, draws axis aligned axes and origin if "draw_axes" is enabled
  */
 void
-view_end(struct application* UNUSED(ap))
+view_end(struct application* ap)
 {
+    if (gbuffer && gbuf.state) {
+	if (npsw > 1)
+	    bu_parallel(gbuf_worker, (size_t)npsw, (void *)ap);
+	else
+	    gbuf_worker(0, (void *)ap);
+    }
+
     if (!draw_axes || (fbp == NULL && bif == NULL)) {
         return;
     }
@@ -1047,13 +1128,20 @@ is_edge(double *intensity, struct application *ap, const struct cell *here,
  * absurdly inefficient way to perform sub-pixel anti-aliasing.  we
  * shoot additional rays to estimate the intensity contribution of
  * this edge cell.
+ *
+ * with TWOBYTWO, only the inner 2x2 sub-pixels are compared (against
+ * the neighboring pixels) so only those four rays are fired.
  */
+#define TWOBYTWO 1
 static void
 get_intensity(double *intensity, struct application *ap, const struct cell *UNUSED(here), const struct cell *left, const struct cell *below, const struct cell *right, const struct cell *above)
 {
-    vect_t dy, dx, dy3, dx3;
+    vect_t dy, dx;
     struct application aaap;
     struct cell grid[4][4];
+#ifndef TWOBYTWO
+    vect_t dy3, dx3;
+#endif
 
     /* Grid layout:
      *
@@ -1069,18 +1157,20 @@ get_intensity(double *intensity, struct application *ap, const struct cell *UNUS
      * |____|____|____|____|
      */
 
+    struct cell *UL = &grid[1][1];
+    struct cell *UR = &grid[1][2];
+    struct cell *LL = &grid[2][1];
+    struct cell *LR = &grid[2][2];
+#ifndef TWOBYTWO
     struct cell *AL = &grid[0][1];
     struct cell *AR = &grid[0][2];
     struct cell *TL = &grid[1][0];
-    struct cell *UL = &grid[1][1];
-    struct cell *UR = &grid[1][2];
     struct cell *TR = &grid[1][3];
     struct cell *BL = &grid[2][0];
-    struct cell *LL = &grid[2][1];
-    struct cell *LR = &grid[2][2];
     struct cell *BR = &grid[2][3];
     struct cell *DL = &grid[3][1];
     struct cell *DR = &grid[3][2];
+#endif
 
     RT_APPLICATION_INIT(&aaap);
     memset(&grid, 0, sizeof(struct cell) * 16);
@@ -1089,10 +1179,6 @@ get_intensity(double *intensity, struct application *ap, const struct cell *UNUS
     VSCALE(dy, dy_model, 0.125);
     VSCALE(dx, dx_model, 0.125);
 
-    /* 4x4 sub-pixel grid, dx*3 gets to outer cells */
-    VSCALE(dy3, dy_model, 0.375);
-    VSCALE(dx3, dx_model, 0.375);
-
     /* setup */
     aaap.a_hit = rayhit2;
     aaap.a_miss = raymiss2;
@@ -1101,103 +1187,108 @@ get_intensity(double *intensity, struct application *ap, const struct cell *UNUS
     aaap.a_resource = ap->a_resource;
     aaap.a_logoverlap = ap->a_logoverlap;
 
-    /* Above Left */
-    aaap.a_uptr = (void *)AL;
-    VADD2(aaap.a_ray.r_pt, ap->a_ray.r_pt, dy3);
+    /* Upper Left */
+    aaap.a_uptr = (void *)UL;
+    VADD2(aaap.a_ray.r_pt, ap->a_ray.r_pt, dy);
     VSUB2(aaap.a_ray.r_pt, aaap.a_ray.r_pt, dx);
     VMOVE(aaap.a_ray.r_dir, ap->a_ray.r_dir);
     rt_shootray(&aaap);
 
 #ifdef VEDEBUG
-    VPRINT("AL", aaap.a_ray.r_pt);
+    VPRINT("UL", aaap.a_ray.r_pt);
 #endif
 
-    /* Above Right */
-    aaap.a_uptr = (void *)AR;
-    VADD2(aaap.a_ray.r_pt, ap->a_ray.r_pt, dy3);
+    /* Upper Right */
+    aaap.a_uptr = (void *)UR;
+    VADD2(aaap.a_ray.r_pt, ap->a_ray.r_pt, dy);
     VADD2(aaap.a_ray.r_pt, aaap.a_ray.r_pt, dx);
     VMOVE(aaap.a_ray.r_dir, ap->a_ray.r_dir);
     rt_shootray(&aaap);
 
 #ifdef VEDEBUG
-    VPRINT("AR", aaap.a_ray.r_pt);
+    VPRINT("UR", aaap.a_ray.r_pt);
 #endif
 
-    /* Top Left */
-    aaap.a_uptr = (void *)TL;
-    VADD2(aaap.a_ray.r_pt, ap->a_ray.r_pt, dy);
-    VSUB2(aaap.a_ray.r_pt, aaap.a_ray.r_pt, dx3);
+    /* Lower Left */
+    aaap.a_uptr = (void *)LL;
+    VSUB2(aaap.a_ray.r_pt, ap->a_ray.r_pt, dy);
+    VSUB2(aaap.a_ray.r_pt, aaap.a_ray.r_pt, dx);
     VMOVE(aaap.a_ray.r_dir, ap->a_ray.r_dir);
     rt_shootray(&aaap);
 
 #ifdef VEDEBUG
-    VPRINT("TL", aaap.a_ray.r_pt);
+    VPRINT("LL", aaap.a_ray.r_pt);
 #endif
 
-    /* Upper Left */
-    aaap.a_uptr = (void *)UL;
-    VADD2(aaap.a_ray.r_pt, ap->a_ray.r_pt, dy);
-    VSUB2(aaap.a_ray.r_pt, aaap.a_ray.r_pt, dx);
+    /* Lower Right */
+    aaap.a_uptr = (void *)LR;
+    VSUB2(aaap.a_ray.r_pt, ap->a_ray.r_pt, dy);
+    VADD2(aaap.a_ray.r_pt, aaap.a_ray.r_pt, dx);
     VMOVE(aaap.a_ray.r_dir, ap->a_ray.r_dir);
     rt_shootray(&aaap);
 
 #ifdef VEDEBUG
-    VPRINT("UL", aaap.a_ray.r_pt);
+    VPRINT("LR", aaap.a_ray.r_pt);
 #endif
 
-    /* Upper Right */
-    aaap.a_uptr = (void *)UR;
-    VADD2(aaap.a_ray.r_pt, ap->a_ray.r_pt, dy);
-    VADD2(aaap.a_ray.r_pt, aaap.a_ray.r_pt, dx);
+#ifndef TWOBYTWO
+    /* 4x4 sub-pixel grid, dx*3 gets to outer cells */
+    VSCALE(dy3, dy_model, 0.375);
+    VSCALE(dx3, dx_model, 0.375);
+
+    /* Above Left */
+    aaap.a_uptr = (void *)AL;
+    VADD2(aaap.a_ray.r_pt, ap->a_ray.r_pt, dy3);
+    VSUB2(aaap.a_ray.r_pt, aaap.a_ray.r_pt, dx);
     VMOVE(aaap.a_ray.r_dir, ap->a_ray.r_dir);
     rt_shootray(&aaap);
 
 #ifdef VEDEBUG
-    VPRINT("UR", aaap.a_ray.r_pt);
+    VPRINT("AL", aaap.a_ray.r_pt);
 #endif
 
-    /* Top Right */
-    aaap.a_uptr = (void *)TR;
-    VADD2(aaap.a_ray.r_pt, ap->a_ray.r_pt, dy);
-    VADD2(aaap.a_ray.r_pt, aaap.a_ray.r_pt, dx3);
+    /* Above Right */
+    aaap.a_uptr = (void *)AR;
+    VADD2(aaap.a_ray.r_pt, ap->a_ray.r_pt, dy3);
+    VADD2(aaap.a_ray.r_pt, aaap.a_ray.r_pt, dx);
     VMOVE(aaap.a_ray.r_dir, ap->a_ray.r_dir);
     rt_shootray(&aaap);
 
 #ifdef VEDEBUG
-    VPRINT("TR", aaap.a_ray.r_pt);
+    VPRINT("AR", aaap.a_ray.r_pt);
 #endif
 
-    /* Bottom Left */
-    aaap.a_uptr = (void *)BL;
-    VSUB2(aaap.a_ray.r_pt, ap->a_ray.r_pt, dy);
+    /* Top Left */
+    aaap.a_uptr = (void *)TL;
+    VADD2(aaap.a_ray.r_pt, ap->a_ray.r_pt, dy);
     VSUB2(aaap.a_ray.r_pt, aaap.a_ray.r_pt, dx3);
     VMOVE(aaap.a_ray.r_dir, ap->a_ray.r_dir);
     rt_shootray(&aaap);
 
 #ifdef VEDEBUG
-    VPRINT("BL", aaap.a_ray.r_pt);
+    VPRINT("TL", aaap.a_ray.r_pt);
 #endif
 
-    /* Lower Left */
-    aaap.a_uptr = (void *)LL;
-    VSUB2(aaap.a_ray.r_pt, ap->a_ray.r_pt, dy);
-    VSUB2(aaap.a_ray.r_pt, aaap.a_ray.r_pt, dx);
+    /* Top Right */
+    aaap.a_uptr = (void *)TR;
+    VADD2(aaap.a_ray.r_pt, ap->a_ray.r_pt, dy);
+    VADD2(aaap.a_ray.r_pt, aaap.a_ray.r_pt, dx3);
     VMOVE(aaap.a_ray.r_dir, ap->a_ray.r_dir);
     rt_shootray(&aaap);
 
 #ifdef VEDEBUG
-    VPRINT("LL", aaap.a_ray.r_pt);
+    VPRINT("TR", aaap.a_ray.r_pt);
 #endif
 
-    /* Lower Right */
-    aaap.a_uptr = (void *)LR;
+    /* Bottom Left */
+    aaap.a_uptr = (void *)BL;
     VSUB2(aaap.a_ray.r_pt, ap->a_ray.r_pt, dy);
-    VADD2(aaap.a_ray.r_pt, aaap.a_ray.r_pt, dx);
+    VSUB2(aaap.a_ray.r_pt, aaap.a_ray.r_pt, dx3);
     VMOVE(aaap.a_ray.r_dir, ap->a_ray.r_dir);
     rt_shootray(&aaap);
 
 #ifdef VEDEBUG
-    VPRINT("LR", aaap.a_ray.r_pt);
+    VPRINT("BL", aaap.a_ray.r_pt);
 #endif
 
     /* Bottom Right */
@@ -1232,8 +1323,8 @@ get_intensity(double *intensity, struct application *ap, const struct cell *UNUS
 #ifdef VEDEBUG
     VPRINT("DR", aaap.a_ray.r_pt);
 #endif
+#endif
 
-#define TWOBYTWO 1
 #ifdef TWOBYTWO
     if (is_edge(NULL, NULL, UL, left, LL, UR, above)) {
 	*intensity += 0.25;
@@ -1348,6 +1439,95 @@ is_edge(double *intensity, struct application *ap, const struct cell *here,
 }
 
 
+/**
+ * decide what gets written for pixel ap->a_x of the scanline being
+ * assembled in cpu's buffers, given whether it is an edge.
+ */
+static void
+paint_pixel(struct application *ap, int cpu, int edge, double intensity, struct cell *me,
+	    struct cell *left, struct cell *below, struct cell *right, struct cell *above)
+{
+    int oc = 1;
+    RGBpixel col;
+
+    /*
+     * Does this pixel occlude the second geometry?  Note that we must
+     * check on edges as well since right side and top edges are
+     * actually misses.
+     */
+    if (occlusion_mode != OCCLUSION_MODE_NONE) {
+	if (me->c_ishit || edge) {
+	    oc = occludes(ap, me);
+	}
+    }
+
+    /*
+     * Perverse Pixel Painting Paradigm(tm) If a pixel should be
+     * written to the fb, writeable is set.
+     */
+    if (occlusion_mode == OCCLUSION_MODE_EDGES)
+	writeable[cpu][ap->a_x] = (edge && oc);
+    else if (occlusion_mode == OCCLUSION_MODE_HITS)
+	writeable[cpu][ap->a_x] = ((me->c_ishit || edge) && oc);
+    else if (occlusion_mode == OCCLUSION_MODE_DITHER) {
+	if (edge && oc)
+	    writeable[cpu][ap->a_x] = 1;
+	else if (me->c_ishit && oc) {
+	    /*
+	     * Dither mode.
+	     *
+	     * For occluding non-edges, only write every other pixel.
+	     */
+	    if (oc == 1 && ((ap->a_x + ap->a_y) % 2) == 0)
+		writeable[cpu][ap->a_x] = 1;
+	    else if (oc == 2)
+		writeable[cpu][ap->a_x] = 1;
+	    else
+		writeable[cpu][ap->a_x] = 0;
+	} else {
+	    writeable[cpu][ap->a_x] = 0;
+	}
+    } else {
+	if (edge)
+	    writeable[cpu][ap->a_x] = 1;
+	else
+	    writeable[cpu][ap->a_x] = 0;
+    }
+
+    if (edge) {
+	if (both_sides) {
+	    choose_color(col, intensity, me, left, below, right, above);
+	} else {
+	    choose_color(col, intensity, me, left, below, NULL, NULL);
+	}
+
+	scanline[cpu][ap->a_x*3+RED] = col[RED];
+	scanline[cpu][ap->a_x*3+GRN] = col[GRN];
+	scanline[cpu][ap->a_x*3+BLU] = col[BLU];
+    } else {
+	scanline[cpu][ap->a_x*3+RED] = bgcolor[RED];
+	scanline[cpu][ap->a_x*3+GRN] = bgcolor[GRN];
+	scanline[cpu][ap->a_x*3+BLU] = bgcolor[BLU];
+    }
+}
+
+
+/**
+ * record the main ray's cell in the G-buffer
+ */
+static void
+gbuf_store(const struct application *ap, const struct cell *me)
+{
+    size_t i = (size_t)ap->a_y * gbuf.width + (size_t)ap->a_x;
+
+    gbuf.state[i] = (me->c_ishit) ? GB_HIT : GB_MISS;
+    gbuf.id[i] = me->c_id;
+    gbuf.region[i] = me->c_region;
+    gbuf.dist[i] = me->c_dist;
+    VMOVE(&gbuf.normal[i*3], me->c_normal);
+}
+
+
 int
 handle_main_ray(struct application *ap, register struct partition *PartHeadp,
 		struct seg *segp)
@@ -1367,9 +1547,6 @@ handle_main_ray(struct application *ap, register struct partition *PartHeadp,
 
     int edge = 0;
     int cpu;
-    int oc = 1;
-
-    RGBpixel col;
 
     RT_APPLICATION_INIT(&a2);
     memset(&me, 0, sizeof(struct cell));
@@ -1407,6 +1584,12 @@ handle_main_ray(struct application *ap, register struct partition *PartHeadp,
 		      pp->pt_inseg->seg_stp, &(ap->a_ray), pp->pt_inflip);
     }
 
+    /* Edges are found later from the neighboring entries */
+    if (gbuffer) {
+	gbuf_store(ap, &me);
+	return 0;
+    }
+
     /*
      * Now, fire a ray for both the cell below and if necessary, the
      * cell to the left.
@@ -1466,78 +1649,230 @@ handle_main_ray(struct application *ap, register struct partition *PartHeadp,
 	edge = is_edge(&intensity, ap, &me, &left, &below, NULL, NULL);
     }
 
+    paint_pixel(ap, cpu, edge, intensity, &me, &left, &below, &right, &above);
+
     /*
-     * Does this pixel occlude the second geometry?  Note that we must
-     * check on edges as well since right side and top edges are
-     * actually misses.
+     * Save the cell info for the next pixel.
      */
-    if (occlusion_mode != OCCLUSION_MODE_NONE) {
-	if (me.c_ishit || edge) {
-	    oc = occludes(ap, &me);
-	}
+    saved[cpu]->c_ishit = me.c_ishit;
+    saved[cpu]->c_id = me.c_id;
+    saved[cpu]->c_dist = me.c_dist;
+    saved[cpu]->c_region = me.c_region;
+    VMOVE(saved[cpu]->c_rdir, me.c_rdir);
+    VMOVE(saved[cpu]->c_hit, me.c_hit);
+    VMOVE(saved[cpu]->c_normal, me.c_normal);
+
+    return edge;
+}
+
+
+/**
+ * set up ray r as the main ray for pixel x, y would have been (less
+ * any jitter).
+ */
+static void
+gbuf_ray(struct xray *r, const struct application *ap, int x, int y)
+{
+    point_t point;
+
+    VJOIN2(point, viewbase_model, x, dx_model, y, dy_model);
+    if (rt_perspective > 0.0) {
+	VSUB2(r->r_dir, point, eye_model);
+	VUNITIZE(r->r_dir);
+	VMOVE(r->r_pt, eye_model);
+    } else {
+	VMOVE(r->r_pt, point);
+	VMOVE(r->r_dir, ap->a_ray.r_dir);
     }
+}
 
-    /*
-     * Perverse Pixel Painting Paradigm(tm) If a pixel should be
-     * written to the fb, writeable is set.
-     */
-    if (occlusion_mode == OCCLUSION_MODE_EDGES)
-	writeable[cpu][ap->a_x] = (edge && oc);
-    else if (occlusion_mode == OCCLUSION_MODE_HITS)
-	writeable[cpu][ap->a_x] = ((me.c_ishit || edge) && oc);
-    else if (occlusion_mode == OCCLUSION_MODE_DITHER) {
-	if (edge && oc)
-	    writeable[cpu][ap->a_x] = 1;
-	else if (me.c_ishit && oc) {
-	    /*
-	     * Dither mode.
-	     *
-	     * For occluding non-edges, only write every other pixel.
-	     */
-	    if (oc == 1 && ((ap->a_x + ap->a_y) % 2) == 0)
-		writeable[cpu][ap->a_x] = 1;
-	    else if (oc == 2)
-		writeable[cpu][ap->a_x] = 1;
+
+/**
+ * fill in c for pixel x, y, from the G-buffer if the pixel was
+ * rendered and by firing its ray if not (off the image, or outside a
+ * sub-grid).  Either way the hit point and ray direction are those of
+ * pixel x, y's own ray, not of the pixel ap is working on.
+ */
+static void
+gbuf_cell(struct cell *c, struct application *ap, int x, int y)
+{
+    if (x >= 0 && y >= 0 && (size_t)x < gbuf.width && (size_t)y < gbuf.height) {
+	size_t i = (size_t)y * gbuf.width + (size_t)x;
+	if (gbuf.state[i] != GB_UNSET) {
+	    struct xray r;
+	    gbuf_ray(&r, ap, x, y);
+	    c->c_ishit = (gbuf.state[i] == GB_HIT);
+	    c->c_region = gbuf.region[i];
+	    c->c_dist = gbuf.dist[i];
+	    c->c_id = gbuf.id[i];
+	    VMOVE(c->c_normal, &gbuf.normal[i*3]);
+	    VMOVE(c->c_rdir, r.r_dir);
+	    if (c->c_ishit)
+		VJOIN1(c->c_hit, r.r_pt, c->c_dist, r.r_dir);
 	    else
-		writeable[cpu][ap->a_x] = 0;
-	} else {
-	    writeable[cpu][ap->a_x] = 0;
+		VSETALL(c->c_hit, MISS_DIST);
+	    return;
 	}
-    } else {
-	if (edge)
-	    writeable[cpu][ap->a_x] = 1;
-	else
-	    writeable[cpu][ap->a_x] = 0;
     }
 
-    if (edge) {
+    {
+	struct application a2;
+	RT_APPLICATION_INIT(&a2);
+	a2.a_hit = rayhit2;
+	a2.a_miss = raymiss2;
+	a2.a_onehit = 1;
+	a2.a_rt_i = ap->a_rt_i;
+	a2.a_resource = ap->a_resource;
+	a2.a_logoverlap = ap->a_logoverlap;
+	a2.a_uptr = (void *)c;
+	gbuf_ray(&a2.a_ray, ap, x, y);
+	rt_shootray(&a2);
+    }
+}
+
+
+/**
+ * compare one scanline of the G-buffer with its neighbors, the same
+ * tests is_edge() makes, for the pixels whose neighbors are all in
+ * the buffer.  edge[x] is set to 1 for edges, 0 for non-edges, and 2
+ * where a neighbor is missing and is_edge() has to decide.
+ */
+static void
+gbuf_edges(unsigned char *edge, int y)
+{
+    size_t w = gbuf.width;
+    size_t h = gbuf.height;
+    size_t row = (size_t)y * w;
+    size_t x;
+
+    for (x = 0; x < w; x++) {
+	size_t i = row + x;
+	size_t nbr[4];
+	int nnbr = 0;
+	int found = 0;
+	int n;
+
+	if (gbuf.state[i] == GB_UNSET) {
+	    edge[x] = 0;
+	    continue;
+	}
+
+	/* left and below, then right and above */
+	nbr[nnbr++] = (x > 0) ? i - 1 : i;
+	nbr[nnbr++] = (y > 0) ? i - w : i;
 	if (both_sides) {
-	    choose_color(col, intensity, &me, &left, &below, &right, &above);
-	} else {
-	    choose_color(col, intensity, &me, &left, &below, NULL, NULL);
+	    nbr[nnbr++] = (x + 1 < w) ? i + 1 : i;
+	    nbr[nnbr++] = ((size_t)y + 1 < h) ? i + w : i;
+	}
+	if (x == 0 || y == 0 || (both_sides && (x + 1 == w || (size_t)y + 1 == h))) {
+	    edge[x] = 2;
+	    continue;
+	}
+	for (n = 0; n < nnbr; n++) {
+	    if (gbuf.state[nbr[n]] == GB_UNSET)
+		break;
+	}
+	if (n < nnbr) {
+	    edge[x] = 2;
+	    continue;
 	}
 
-	scanline[cpu][ap->a_x*3+RED] = col[RED];
-	scanline[cpu][ap->a_x*3+GRN] = col[GRN];
-	scanline[cpu][ap->a_x*3+BLU] = col[BLU];
-    } else {
-	scanline[cpu][ap->a_x*3+RED] = bgcolor[RED];
-	scanline[cpu][ap->a_x*3+GRN] = bgcolor[GRN];
-	scanline[cpu][ap->a_x*3+BLU] = bgcolor[BLU];
+	if (gbuf.state[i] == GB_HIT) {
+	    const fastf_t *nrm = &gbuf.normal[i*3];
+	    for (n = 0; n < nnbr; n++) {
+		size_t j = nbr[n];
+		if (detect_ids && gbuf.id[i] != gbuf.id[j])
+		    found = 1;
+		if (detect_regions && gbuf.region[i] != gbuf.region[j])
+		    found = 1;
+		if (detect_distance && Abs(gbuf.dist[i] - gbuf.dist[j]) > max_dist)
+		    found = 1;
+		if (detect_normals && VDOT(nrm, &gbuf.normal[j*3]) < COSTOL)
+		    found = 1;
+	    }
+	} else {
+	    for (n = 0; n < nnbr; n++) {
+		if (gbuf.state[nbr[n]] == GB_HIT)
+		    found = 1;
+	    }
+	}
+	edge[x] = (unsigned char)found;
     }
+}
 
-    /*
-     * Save the cell info for the next pixel.
-     */
-    saved[cpu]->c_ishit = me.c_ishit;
-    saved[cpu]->c_id = me.c_id;
-    saved[cpu]->c_dist = me.c_dist;
-    saved[cpu]->c_region = me.c_region;
-    VMOVE(saved[cpu]->c_rdir, me.c_rdir);
-    VMOVE(saved[cpu]->c_hit, me.c_hit);
-    VMOVE(saved[cpu]->c_normal, me.c_normal);
 
-    return edge;
+/**
+ * the edge pass.  each cpu takes every npsw'th scanline, finds its
+ * edges, paints it and writes it out.
+ */
+static void
+gbuf_worker(int cpu, void *data)
+{
+    struct application *ap = (struct application *)data;
+    unsigned char *edge = (unsigned char *)bu_malloc(gbuf.width, "gbuf edge flags");
+    struct application a;
+    int y;
+
+    for (y = cpu; (size_t)y < gbuf.height; y += npsw) {
+	int x;
+
+	gbuf_edges(edge, y);
+
+	for (x = 0; (size_t)x < gbuf.width; x++) {
+	    struct cell me = CELL_INIT;
+	    struct cell left = CELL_INIT;
+	    struct cell below = CELL_INIT;
+	    struct cell right = CELL_INIT;
+	    struct cell above = CELL_INIT;
+	    double intensity = 1.0;
+	    int e = edge[x];
+
+	    a = *ap;			/* struct copy */
+	    a.a_resource = &resource[cpu];
+	    a.a_x = x;
+	    a.a_y = y;
+	    gbuf_ray(&a.a_ray, ap, x, y);
+
+	    if (gbuf.state[(size_t)y * gbuf.width + x] == GB_UNSET) {
+		/* outside the sub-grid */
+		writeable[cpu][x] = 0;
+		scanline[cpu][x*3+RED] = bgcolor[RED];
+		scanline[cpu][x*3+GRN] = bgcolor[GRN];
+		scanline[cpu][x*3+BLU] = bgcolor[BLU];
+		continue;
+	    }
+
+	    gbuf_cell(&me, &a, x, y);
+
+	    /* neighbors are only needed to decide, antialias, or color an edge */
+	    if (e == 2 || (e && (antialias || region_colors))) {
+		gbuf_cell(&left, &a, x - 1, y);
+		gbuf_cell(&below, &a, x, y - 1);
+		if (both_sides) {
+		    gbuf_cell(&right, &a, x + 1, y);
+		    gbuf_cell(&above, &a, x, y + 1);
+		}
+	    }
+
+	    if (e == 2) {
+		if (both_sides)
+		    e = is_edge(&intensity, &a, &me, &left, &below, &right, &above);
+		else
+		    e = is_edge(&intensity, &a, &me, &left, &below, NULL, NULL);
+	    } else if (e && antialias) {
+		if (both_sides)
+		    get_intensity(&intensity, &a, &me, &left, &below, &right, &above);
+		else
+		    get_intensity(&intensity, &a, &me, &left, &below, NULL, NULL);
+	    }
+
+	    paint_pixel(&a, cpu, e, intensity, &me, &left, &below, &right, &above);
+	}
+
+	write_scanline(cpu, y);
+    }
+
+    bu_free(edge, "gbuf edge flags");
 }
 
 
@@ -1575,6 +1910,8 @@ void application_init(void) {
     view_parse[27].sp_offset = bu_byteoffset(both_sides);
     view_parse[28].sp_offset = bu_byteoffset(draw_axes);
     view_parse[29].sp_offset = bu_byteoffset(draw_axes);
+    view_parse[30].sp_offset = bu_byteoffset(gbuffer);
+    view_parse[31].sp_offset = bu_byteoffset(gbuffer);
 
     option("", "-c \"command\"", "Customize behavior (see rtedge manual)", 1);
     option("Raytrace", "-i", "Enable incremental (progressive-style) rendering", 1);
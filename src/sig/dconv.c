@@ -45,25 +45,19 @@
 
 
 /*
- * Multiply two "real valued" spectra of length n
- * and put the result in the first.
- * The order is: [Re(0), Re(1)...Re(N/2), Im(N/2-1), ..., Im(1)]
- * so for: 0 < i < n/2, (x[i], x[n-i]) is a complex pair.
+ * Multiply two spectra of real valued length n sequences, as made
+ * by fft_plan_rexec(), and put the result in the first.
  */
 static void
-mult(double *o, double *b, int n)
+mult(COMPLEX *o, COMPLEX *b, int n)
 {
     int i;
     double r;
 
-    /* do DC and Nyquist components */
-    o[0] *= b[0];
-    o[n/2] *= b[n/2];
-
-    for (i = 1; i < n/2; i++) {
-	r = o[i] * b[i] - o[n-i] * b[n-i];
-	o[n-i] = o[i] * b[n-i] + o[n-i] * b[i];
-	o[i] = r;
+    for (i = 0; i <= n/2; i++) {
+	r = o[i].re * b[i].re - o[i].im * b[i].im;
+	o[i].im = o[i].re * b[i].im + o[i].im * b[i].re;
+	o[i].re = r;
     }
 }
 
@@ -72,8 +66,11 @@ int
 main(int argc, char *argv[])
 {
     double savebuffer[BU_PAGE_SIZE] = {0.0};
-    double xbuf[2 * (BU_PAGE_SIZE + 1)] = {0.0};
-    double ibuf[2 * (BU_PAGE_SIZE + 1)] = {0.0};		/* impulse response */
+    COMPLEX xbuf[BU_PAGE_SIZE + 2] = {{0.0, 0.0}};
+    COMPLEX ibuf[BU_PAGE_SIZE + 2] = {{0.0, 0.0}};		/* impulse response */
+    double *xdat = (double *)xbuf;	/* real data, transformed in place */
+    double *idat = (double *)ibuf;
+    struct fft_plan *plan;
 
     int i;
     int M = 128;	/* kernel size */
@@ -84,7 +81,7 @@ main(int argc, char *argv[])
     bu_setprogname(argv[0]);
 
     if (argc != 2 || isatty(fileno(stdin)) || isatty(fileno(stdout))) {
-	bu_exit(1, "Usage: dconv filterfile < doubles > doubles\n       WARNING: kernel size must be 2^i - 1\n");
+	bu_exit(1, "Usage: dconv filterfile < doubles > doubles\n");
     }
 
 #ifdef never
@@ -97,64 +94,56 @@ main(int argc, char *argv[])
      */
     for (i = 0; i < N; i++) {
 	if (i <= N/2)
-	    ibuf[i] = 1.0;	/* Real part */
+	    idat[i] = 1.0;	/* Real part */
 	else
-	    ibuf[i] = 0.0;	/* Imag part */
+	    idat[i] = 0.0;	/* Imag part */
     }
 #endif /* never */
 
     if ((fp = fopen(argv[1], "r")) == NULL) {
 	bu_exit(2, "dconv: can't open \"%s\"\n", argv[1]);
     }
-    if ((M = fread(ibuf, sizeof(*ibuf), 2*BU_PAGE_SIZE, fp)) == 0) {
+    if ((M = fread(idat, sizeof(*idat), 2*BU_PAGE_SIZE, fp)) == 0) {
 	bu_exit(3, "dconv: problem reading filter file\n");
     }
     fclose(fp);
     if (M > BU_PAGE_SIZE) {
 	bu_exit(4, "dconv: only compiled for up to %d sized filter kernels\n", BU_PAGE_SIZE);
     }
-/*XXX HACK HACK HACK HACK XXX*/
-/* Assume M = 2^i - 1 */
     M += 1;
     N = 2*M;	/* input sub-section length (fft size) */
     L = N - M + 1;	/* number of "good" points per section */
 
-    if (N == 256)
-	rfft256(ibuf);
-    else
-	rfft(ibuf, N);
+    /* Any kernel size will do, the plan handles any length */
+    plan = fft_plan_create(N, FFT_REAL);
+    if (!plan) {
+	bu_exit(4, "dconv: can't plan a %d point transform\n", N);
+    }
+    fft_plan_rexec(plan, idat, ibuf);
 
-    while ((i = fread(&xbuf[M-1], sizeof(*xbuf), L, stdin)) > 0) {
+    while ((i = fread(&xdat[M-1], sizeof(*xdat), L, stdin)) > 0) {
 	if (i < L) {
 	    /* pad the end with zero's */
-	    memset((char *)&xbuf[M-1+i], 0, (L-i)*sizeof(*savebuffer));
+	    memset((char *)&xdat[M-1+i], 0, (L-i)*sizeof(*savebuffer));
 	}
 
 	/* shift contents of savebuffer left */
 #define COPY_SIZE ((M - 1) * sizeof(*savebuffer))
-	memcpy(xbuf, savebuffer, COPY_SIZE);
-	memcpy(savebuffer, &xbuf[L], COPY_SIZE);
-
-	/*xform(xbuf, N);*/
-	if (N == 256)
-	    rfft256(xbuf);
-	else
-	    rfft(xbuf, N);
+	memcpy(xdat, savebuffer, COPY_SIZE);
+	memcpy(savebuffer, &xdat[L], COPY_SIZE);
 
-	/* Mult */
+	/* xform, mult and invxform */
+	fft_plan_rexec(plan, xdat, xbuf);
 	mult(xbuf, ibuf, N);
+	fft_plan_irexec(plan, xbuf, xdat);
 
-	/*invxform(xbuf, N);*/
-	if (N == 256)
-	    irfft256(xbuf);
-	else
-	    irfft(xbuf, N);
-
-	ret = fwrite(&xbuf[M-1], sizeof(*xbuf), L, stdout);
+	ret = fwrite(&xdat[M-1], sizeof(*xdat), L, stdout);
 	if (ret != (size_t)L)
 	    perror("fwrite");
     }
 
+    fft_plan_destroy(plan);
+
     return 0;
 }
 
@@ -37,14 +37,16 @@
 #include "bu/malloc.h"
 #include "bu/getopt.h"
 #include "bu/exit.h"
+#include "bu/parallel.h"
 #include "vmath.h"
+#include "fft.h"
 
 #define MAXFFT BU_PAGE_SIZE
+#define NRECORDS 256	/* records read and transformed at a time */
 
 
 /* functions specified elsewhere (these probably belong in a header) */
 void cbweights(double *filter, int window, int points); /* in butter.c */
-void rfft(double *dat, int N); /* in dfft.c */
 void LintoLog(double *in, double *out, int num); /* in interp.c */
 
 
@@ -59,22 +61,15 @@ static double cbfilter[27];
 
 
 static void
-fftmag2(double *mags, double *dat, int N)
+fftmag2(double *mags, COMPLEX *dat, int N)
 {
     int i;
     double value, dB;
 
-    /* DC */
-    mags[0] = dat[0]*dat[0];
-
-    /* Normal */
-    for (i = 1; i < N/2; i++) {
-	mags[i] = dat[i]*dat[i] + dat[N-i]*dat[N-i];
+    for (i = 0; i <= N/2; i++) {
+	mags[i] = dat[i].re*dat[i].re + dat[i].im*dat[i].im;
     }
 
-    /* Nyquist */
-    mags[N/2] = dat[N/2]*dat[N/2];
-
 
     if (!linear_output) {
 	/* Log output */
@@ -91,15 +86,17 @@ fftmag2(double *mags, double *dat, int N)
 
 
 static void
-fftdisp(double *dat, int N, double cbsum)
+fftdisp(COMPLEX *dat, int N, double cbsum)
 {
     int i, j;
     double mags[MAXFFT];
     size_t ret;
 
     /* Periodogram scaling */
-    for (i = 0; i < N; i++)
-	dat[i] /= (double)N;
+    for (i = 0; i <= N/2; i++) {
+	dat[i].re /= (double)N;
+	dat[i].im /= (double)N;
+    }
 
     fftmag2(mags, dat, N);
 
@@ -163,21 +160,18 @@ fftdisp(double *dat, int N, double cbsum)
 
 
 static void
-fftphase(double *dat, int N)
+fftphase(COMPLEX *dat, int N)
 {
     int i;
     double value, out[MAXFFT];
     size_t ret;
 
-    for (i = 0; i < N; i++)
-	dat[i] /= (double)N;
-
     for (i = 1; i < N/2; i++) {
-	value = atan2(dat[N-i], dat[i]);
+	value = atan2(dat[i].im, dat[i].re);
 	out[i] = value * M_1_PI;
     }
     /* DC */
-    out[i] = 0;
+    out[0] = 0;
 
     ret = fwrite(out, sizeof(*out), N/2, stdout);
     if (ret != (size_t)(N/2))
@@ -185,6 +179,33 @@ fftphase(double *dat, int N)
 }
 
 
+struct dfft_batch {
+    const struct fft_plan *plan;
+    double *data;
+    COMPLEX *spectra;
+    int count;
+    int current;	/* semaphored */
+};
+
+
+static void
+dfft_worker(int UNUSED(cpu), void *arg)
+{
+    struct dfft_batch *b = (struct dfft_batch *)arg;
+    int L = fft_plan_size(b->plan);
+
+    while (1) {
+	int mine;
+	bu_semaphore_acquire(BU_SEM_GENERAL);
+	mine = b->current++;
+	bu_semaphore_release(BU_SEM_GENERAL);
+	if (mine >= b->count)
+	    break;
+	fft_plan_rexec(b->plan, b->data + (size_t)mine * L, b->spectra + (size_t)mine * (L/2 + 1));
+    }
+}
+
+
 int
 main(int argc, char **argv)
 {
@@ -207,7 +228,11 @@ main(int argc, char **argv)
     int L = 1024;
     double cbsum = 0.0;
     int phase = 0;
-    double data[MAXFFT];		/* Data buffer: 2*Points in spectrum */
+    double *data;
+    COMPLEX *spectra;
+    struct fft_plan *plan;
+    struct dfft_batch batch;
+    size_t ncpu = bu_avail_cpus();
 
     bu_setprogname(argv[0]);
 
@@ -235,23 +260,44 @@ main(int argc, char **argv)
 	    cbsum += cbfilter[i];
     }
 
-    while ((n = fread(data, sizeof(*data), L, stdin)) > 0) {
-	if (n != L) {
-	    fprintf(stderr, "dfft: warning - partial record, adding %d zeros\n", L-n);
-	    memset((char *)&data[n], 0, L-n);
+    plan = fft_plan_create(L, FFT_REAL);
+    if (!plan)
+	bu_exit(1, "dfft: can't plan a %d point transform\n", L);
+    data = (double *)bu_malloc(sizeof(double) * L * NRECORDS, "data");
+    spectra = (COMPLEX *)bu_malloc(sizeof(COMPLEX) * (L/2 + 1) * NRECORDS, "spectra");
+    if (ncpu > MAX_PSW)
+	ncpu = MAX_PSW;
+
+    /* Read a batch of records, transform them in parallel and write
+     * out the results in order */
+    while ((n = fread(data, sizeof(*data), L * NRECORDS, stdin)) > 0) {
+	int count = (n + L - 1) / L;
+	if (n % L) {
+	    fprintf(stderr, "dfft: warning - partial record, adding %d zeros\n", L - n % L);
+	    memset(&data[n], 0, (L - n % L) * sizeof(*data));
 	}
 
-	/* Do a spectrum */
-	/* if (L == 256) rfft256(data); etc. XXX */
-	rfft(data, L);
-
-	/* Put it on screen */
-	if (phase)
-	    fftphase(data, L);
-	else
-	    fftdisp(data, L, cbsum);
+	/* Do the spectra */
+	batch.plan = plan;
+	batch.data = data;
+	batch.spectra = spectra;
+	batch.count = count;
+	batch.current = 0;
+	bu_parallel(dfft_worker, ((size_t)count < ncpu) ? (size_t)count : ncpu, &batch);
+
+	/* Put them on screen */
+	for (i = 0; i < count; i++) {
+	    if (phase)
+		fftphase(&spectra[i * (L/2 + 1)], L);
+	    else
+		fftdisp(&spectra[i * (L/2 + 1)], L, cbsum);
+	}
     }
 
+    fft_plan_destroy(plan);
+    bu_free(data, "data");
+    bu_free(spectra, "spectra");
+
     return 0;
 }
 
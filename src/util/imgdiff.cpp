@@ -91,7 +91,7 @@ main(int ac, const char **av)
     int matching = 0;
     int off_by_1 = 0;
     int off_by_many = 0;
-    icv_image_t *img1, *img2, *oimg;
+    icv_nimage_t *img1 = NULL, *img2 = NULL, *oimg;
     const char *img_path_1 = NULL;
     const char *img_path_2 = NULL;
     bu_setprogname(av[0]);
@@ -208,27 +208,36 @@ main(int ac, const char **av)
 	}
     }
 
-    img1 = icv_read(img_path_1, in_type_1, width1, height1);
-    img2 = icv_read(img_path_2, in_type_2, width2, height2);
+    /* Keep the images in their native types - for the usual 8 bit
+     * images this takes an eighth of the memory of icv_read. */
+    img1 = icv_nread(img_path_1, in_type_1, width1, height1, 0);
+    img2 = icv_nread(img_path_2, in_type_2, width2, height2, 0);
 
     if (approx_diff) {
-	pret = icv_pdiff(img1, img2);
+	pret = icv_npdiff(img1, img2);
 	bu_log("Hamming distance: %" PRIu32 "\n", pret);
 	ret = 0;
 	goto cleanup;
     } else {
-	ret = icv_diff(&matching, &off_by_1, &off_by_many, img1, img2);
+	ret = icv_ndiff(&matching, &off_by_1, &off_by_many, img1, img2);
 
 	bu_log("%d matching, %d off by 1, %d off by many\n", matching, off_by_1, off_by_many);
 
 	if (out_path && (off_by_1 || off_by_many)) {
-	    oimg = icv_diffimg(img1, img2);
-	    icv_write(oimg, out_path, out_type);
+	    oimg = icv_ndiffimg(img1, img2);
+	    if (oimg) {
+		icv_nwrite(oimg, out_path, out_type);
+		icv_ndestroy(oimg);
+	    }
 	}
     }
 
     /* Clean up */
 cleanup:
+    if (img1)
+	icv_ndestroy(img1);
+    if (img2)
+	icv_ndestroy(img2);
     if (bu_vls_strlen(&slog) > 0)
 	bu_log("%s", bu_vls_addr(&slog));
     bu_free((char *)in_fmt, "input format string");